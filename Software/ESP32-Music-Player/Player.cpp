@@ -429,6 +429,7 @@ void PlayerClass::Play(void) {
                                    Serial.printf("**********start a new radio: %s\n",web_station.url);
                                    _audio->connecttohost(web_station.url);
                                    Serial.println("**********start a new radio************");
+                                   PreconnectStations();
                                    Settings.AudioEnded = 0;
                                    Settings.Play = 1;
                                  }
@@ -455,6 +456,20 @@ void PlayerClass::Play(void) {
   }
 }
 
+void PlayerClass::PreconnectStations(void) {
+#if WEB_RADIO_PRECONNECT
+  // The neighbours of the current station are kept connected, next and previous switch at once
+  uint16_t total = Settings.NV.WebRadioTotalStations;
+  uint16_t cur   = Settings.NV.WebRadioCurrentStation;
+  if(total < 2) return;
+  web_station_t next, prev;
+  UrlSettings.GetStation(cur < total ? cur + 1 : 1, next);
+  UrlSettings.GetStation(cur > 1 ? cur - 1 : total, prev);
+  const char * urls[2] = { next.url, prev.url };
+  _audio->preconnect(urls, total > 2 ? 2 : 1);
+#endif
+}
+
 IRAM_ATTR void PlayerClass::loop(bool ten_ms_tick, bool seconds_tick) {
   if(_audio != NULL) _audio->loop();
   switch(Settings.NV.SourceAF) {
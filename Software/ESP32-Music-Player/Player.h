@@ -31,6 +31,7 @@ class PlayerClass {
     
   protected:
     bool PlayTrackFromSD(int n, uint32_t resume_pos = 0, uint32_t resume_time = 0, uint32_t track_time = 0, uint32_t total_time = 0);
+    void PreconnectStations(void);
  
     void (*_loop)(void);
     Audio * _audio;
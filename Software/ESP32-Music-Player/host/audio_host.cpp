@@ -0,0 +1,113 @@
+/*
+ * audio_host.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Plays local files and http(s) URLs through Audio on the host, one after the other. The I2S output goes into a WAV
+ * file, the decoder output optionally into the PCM sink.
+ *
+ *   audio_host [options] <file | http://host[:port]/path> ...
+ *     -o out.wav    I2S output (default: none)
+ *     -s sink.wav   PCM sink, the decoder output before volume and tone (Audio::openPcmSink())
+ *     -t seconds    stops each input after this time
+ *     -r            real time: I2S takes the samples at the sample rate
+ *     -v            audio_info() and the log level info
+ *     -n            no PSRAM
+ *     -b            decode statistics at the end (Audio::printDecodeStats())
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include "Audio.h"
+#include "host.h"
+
+static bool s_verbose = false;
+static bool s_eof = false;
+
+void audio_info(const char* info) {
+    if(s_verbose) printf("info        %s\n", info);
+}
+void audio_eof_mp3(const char* info) { s_eof = true; }
+void audio_eof_stream(const char* info) { s_eof = true; }
+void audio_showstreamtitle(const char* info) { printf("streamtitle %s\n", info); }
+
+//----------------------------------------------------------------------------------------------------------------------
+static void usage() {
+    fprintf(stderr, "usage: audio_host [-o out.wav] [-s sink.wav] [-t seconds] [-r] [-v] [-n] [-b] <file | url> ...\n");
+}
+//----------------------------------------------------------------------------------------------------------------------
+static std::string absolute(const char* path) { // SD is the host file system as it is, relative paths need the cwd
+    char cwd[PATH_MAX];
+    if(path[0] == '/' || !getcwd(cwd, sizeof(cwd))) return path;
+    return std::string(cwd) + "/" + path;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    const char* out = NULL;
+    const char* sink = NULL;
+    float       seconds = 0;
+    bool        stats = false;
+    int         opt;
+    while((opt = getopt(argc, argv, "o:s:t:rvnb")) != -1) {
+        switch(opt) {
+            case 'o': out = optarg; break;
+            case 's': sink = optarg; break;
+            case 't': seconds = atof(optarg); break;
+            case 'r': hostI2S_setRealtime(true); break;
+            case 'v': s_verbose = true; hostSetLogLevel(ARDUHAL_LOG_LEVEL_INFO); break;
+            case 'n': hostSetPsram(false); break;
+            case 'b': stats = true; break;
+            default: usage(); return 2;
+        }
+    }
+    if(optind >= argc) {
+        usage();
+        return 2;
+    }
+    if(out) hostI2S_setOutput(out);
+    hostSetFsRoot("");
+
+    Audio* audio = new Audio;
+    audio->setVolume(21);
+    if(sink && !audio->openPcmSink(SD, absolute(sink).c_str(), !out)) return 1;
+
+    int failed = 0;
+    for(int i = optind; i < argc; i++) {
+        const char* in = argv[i];
+        bool        web = strstr(in, "://") != NULL;
+        s_eof = false;
+        bool ok = web ? audio->connecttohost(in) : audio->connecttoFS(SD, absolute(in).c_str());
+        if(!ok) {
+            fprintf(stderr, "audio_host: can't play %s\n", in);
+            failed++;
+            continue;
+        }
+        uint32_t    start = millis();
+        uint64_t    frames = hostI2S_stats().frames;
+        const char* codec = "none";
+        uint32_t    rate = 0;
+        uint8_t     channels = 0;
+        while(audio->isRunning() && !s_eof) {
+            audio->loop();
+            if(audio->isRunning() && audio->getSampleRate()) { // the codec is gone after the end of the file
+                codec = audio->getCodecname();
+                rate = audio->getSampleRate();
+                channels = audio->getChannels();
+            }
+            if(seconds > 0 && millis() - start > seconds * 1000) break;
+            vTaskDelay(0);
+        }
+        audio->stopSong();
+        printf("%s: %s, %lu Hz, %u ch, played in %lu ms", in, codec, (long unsigned)rate, channels, (long unsigned)(millis() - start));
+        if(out && rate) printf(", %lu ms to I2S", (long unsigned)((hostI2S_stats().frames - frames) * 1000 / rate));
+        printf("\n");
+    }
+    if(stats) audio->printDecodeStats(Serial);
+    audio->closePcmSink();
+    delete audio;
+    hostI2S_close();
+    hostHeap_t h = hostHeap();
+    printf("peak heap: DRAM %lu bytes, PSRAM %lu bytes\n", (long unsigned)h.dramPeak, (long unsigned)h.psramPeak);
+    return failed ? 1 : 0;
+}
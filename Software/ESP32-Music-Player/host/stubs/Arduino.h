@@ -0,0 +1,137 @@
+/*
+ * Arduino.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Host stand-in for the Arduino ESP32 core 2.0.17 (ESP-IDF 4.4), as much of it as src/AudioI2S uses.
+ * FreeRTOS runs on std::thread, the heap is counted in DRAM and PSRAM, files are host files and the I2S driver writes
+ * a WAV file, see host.h.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+#include <errno.h>
+#include <alloca.h>
+#include <assert.h>
+
+#include "esp32-hal-log.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+
+#define ESP_IDF_VERSION_MAJOR         4
+#define ESP_IDF_VERSION_MINOR         4
+#define ESP_IDF_VERSION_PATCH         7
+#define ESP_IDF_VERSION_VAL(a, b, c)  (((a) << 16) | ((b) << 8) | (c))
+#define ESP_IDF_VERSION               ESP_IDF_VERSION_VAL(4, 4, 7)
+#define ESP_ARDUINO_VERSION_MAJOR     2
+#define ESP_ARDUINO_VERSION_MINOR     0
+#define ESP_ARDUINO_VERSION_PATCH     17
+#define ESP_ARDUINO_VERSION_VAL(a, b, c) (((a) << 16) | ((b) << 8) | (c))
+#define ESP_ARDUINO_VERSION           ESP_ARDUINO_VERSION_VAL(2, 0, 17)
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_ATTR
+#define PROGMEM
+#define pgm_read_byte(addr)   (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr)  (*(const uint32_t*)(addr))
+
+#define PI          3.1415926535897932384626433832795
+#define HIGH        0x1
+#define LOW         0x0
+#define INPUT       0x01
+#define OUTPUT      0x03
+
+#define _min(a, b)  ((a) < (b) ? (a) : (b))
+#define _max(a, b)  ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef bool    boolean;
+typedef uint8_t byte;
+typedef int     esp_err_t;
+
+#define ESP_OK          0
+#define ESP_FAIL        -1
+#define ESP_ERR_TIMEOUT 0x107
+
+#define ESP_INTR_FLAG_LEVEL1 (1 << 1)
+
+uint32_t millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+void     yield();
+long     random(long howbig);
+long     random(long howsmall, long howbig);
+uint32_t getCpuFrequencyMhz();
+bool     psramInit();
+bool     psramFound();
+void*    ps_malloc(size_t size);
+void*    ps_calloc(size_t n, size_t size);
+void*    ps_realloc(void* ptr, size_t size);
+
+char*    itoa(int value, char* str, int base);
+char*    ltoa(long value, char* str, int base);
+char*    lltoa(long long value, char* str, int base);
+char*    utoa(unsigned value, char* str, int base);
+char*    ultoa(unsigned long value, char* str, int base);
+static inline float pow10f(float x) { return powf(10.0f, x); }
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <cmath>
+
+using std::abs;
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+using ::round;
+
+// size_t has 64 bits on the host: min(uint32_t, size_t) compiles on the ESP32 only, these take mixed types as well
+template <typename A, typename B> static inline typename std::common_type<A, B>::type min(const A& a, const B& b) { return b < a ? b : a; }
+template <typename A, typename B> static inline typename std::common_type<A, B>::type max(const A& a, const B& b) { return a < b ? b : a; }
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+
+static inline char toLowerCase(char c) { return tolower(c); }
+static inline char toUpperCase(char c) { return toupper(c); }
+
+class HardwareSerial : public Stream {
+public:
+    void   begin(unsigned long) {}
+    int    available() override { return 0; }
+    int    read() override { return -1; }
+    int    peek() override { return -1; }
+    size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t* buf, size_t size) override { return fwrite(buf, 1, size, stdout); }
+    using  Print::write;
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getHeapSize();
+    uint32_t getFreePsram();
+    uint32_t getMinFreePsram();
+    uint32_t getMaxAllocPsram();
+    uint32_t getPsramSize();
+    uint32_t getCycleCount();   // host: ns, with getCpuFrequencyMhz() of 1000
+    uint8_t  getChipRevision() { return 3; }
+    const char* getSdkVersion() { return "v4.4.7-host"; }
+};
+extern EspClass ESP;
+#endif // __cplusplus
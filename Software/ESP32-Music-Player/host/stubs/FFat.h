@@ -0,0 +1,20 @@
+/*
+ * FFat.h
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#pragma once
+
+#include "FS.h"
+
+class F_Fat : public fs::FS {
+
+public:
+    F_Fat() : fs::FS(fs::hostFSImpl()) {}
+    bool     begin(...) { return true; }
+    void     end() {}
+    uint64_t totalBytes() { return 0; }
+    uint64_t usedBytes() { return 0; }
+};
+extern F_Fat FFat;
@@ -0,0 +1,109 @@
+/*
+ * FS.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * fs::FS and fs::File as in the core, with the implementation behind FSImpl and FileImpl. The file systems of the
+ * host (SD, SD_MMC, SPIFFS, FFat) open host paths with stdio; a test may give FS an FSImpl of its own, a slow or a
+ * failing card for instance.
+ */
+#pragma once
+
+#include <memory>
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class FileImpl {
+
+public:
+    virtual ~FileImpl() {}
+    virtual size_t      write(const uint8_t* buf, size_t size) = 0;
+    virtual size_t      read(uint8_t* buf, size_t size) = 0;
+    virtual void        flush() = 0;
+    virtual bool        seek(uint32_t pos, SeekMode mode) = 0;
+    virtual size_t      position() const = 0;
+    virtual size_t      size() const = 0;
+    virtual void        close() = 0;
+    virtual const char* path() const = 0;
+    virtual const char* name() const = 0;
+    virtual bool        isDirectory() = 0;
+    virtual operator bool() = 0;
+};
+typedef std::shared_ptr<FileImpl> FileImplPtr;
+
+class FSImpl {
+
+public:
+    virtual ~FSImpl() {}
+    virtual FileImplPtr open(const char* path, const char* mode, const bool create) = 0;
+    virtual bool        exists(const char* path) = 0;
+    virtual bool        rename(const char* pathFrom, const char* pathTo) = 0;
+    virtual bool        remove(const char* path) = 0;
+    virtual bool        mkdir(const char* path) = 0;
+    virtual bool        rmdir(const char* path) = 0;
+};
+typedef std::shared_ptr<FSImpl> FSImplPtr;
+
+class File : public Stream {
+
+public:
+    File(FileImplPtr p = FileImplPtr()) : _p(p) {}
+    size_t      write(uint8_t c) override { return _p ? _p->write(&c, 1) : 0; }
+    size_t      write(const uint8_t* buf, size_t size) override { return _p ? _p->write(buf, size) : 0; }
+    using       Print::write;
+    int         available() override { return _p ? (int)(_p->size() - _p->position()) : 0; }
+    int         read() override { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    size_t      read(uint8_t* buf, size_t size) { return _p ? _p->read(buf, size) : 0; }
+    size_t      readBytes(char* buffer, size_t length) override { return read((uint8_t*)buffer, length); }
+    int         peek() override;
+    void        flush() override { if(_p) _p->flush(); }
+    bool        seek(uint32_t pos, SeekMode mode) { return _p ? _p->seek(pos, mode) : false; }
+    bool        seek(uint32_t pos) { return seek(pos, SeekSet); }
+    size_t      position() const { return _p ? _p->position() : 0; }
+    size_t      size() const { return _p ? _p->size() : 0; }
+    void        close() { if(_p) { _p->close(); _p = nullptr; } }
+    operator bool() const { return _p && *_p; }
+    const char* path() const { return _p ? _p->path() : NULL; }
+    const char* name() const { return _p ? _p->name() : NULL; }
+    bool        isDirectory() { return _p && _p->isDirectory(); }
+    File        openNextFile(const char* mode = FILE_READ) { return File(); }
+
+protected:
+    FileImplPtr _p;
+};
+
+class FS {
+
+public:
+    FS(FSImplPtr impl) : _impl(impl) {}
+    File open(const char* path, const char* mode = FILE_READ, const bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, const bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path) { return _impl && _impl->exists(path); }
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path) { return _impl && _impl->remove(path); }
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* pathFrom, const char* pathTo) { return _impl && _impl->rename(pathFrom, pathTo); }
+    bool mkdir(const char* path) { return _impl && _impl->mkdir(path); }
+    bool rmdir(const char* path) { return _impl && _impl->rmdir(path); }
+
+protected:
+    FSImplPtr _impl;
+};
+
+FSImplPtr hostFSImpl(); // host paths through stdio
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
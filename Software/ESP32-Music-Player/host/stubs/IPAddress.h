@@ -0,0 +1,25 @@
+/*
+ * IPAddress.h
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress {
+
+public:
+    IPAddress() : m_addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : m_addr(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t addr) : m_addr(addr) {} // network order, as lwIP
+    operator uint32_t() const { return m_addr; }
+    uint8_t operator[](int index) const { return (m_addr >> (index * 8)) & 0xFF; }
+    bool    operator==(const IPAddress& addr) const { return m_addr == addr.m_addr; }
+    String  toString() const;
+
+private:
+    uint32_t m_addr;
+};
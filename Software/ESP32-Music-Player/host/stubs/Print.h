@@ -0,0 +1,36 @@
+/*
+ * Print.h
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "WString.h"
+
+class Print {
+
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    virtual void   flush() {}
+    size_t         write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t         write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t         printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t         print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t         print(const char* str) { return write(str); }
+    size_t         print(char c) { return write((uint8_t)c); }
+    size_t         print(int n) { return print(String(n)); }
+    size_t         print(unsigned n) { return print(String(n)); }
+    size_t         print(long n) { return print(String(n)); }
+    size_t         print(unsigned long n) { return print(String(n)); }
+    size_t         print(double n, int digits = 2) { return print(String(n, digits)); }
+    size_t         println() { return write("\r\n"); }
+    template <typename T>
+    size_t         println(const T& x) { size_t n = print(x); return n + println(); }
+};
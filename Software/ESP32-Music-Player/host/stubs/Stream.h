@@ -0,0 +1,27 @@
+/*
+ * Stream.h
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#pragma once
+
+#include "Print.h"
+
+class Stream : public Print {
+
+public:
+    virtual int    available() = 0;
+    virtual int    read() = 0;
+    virtual int    peek() = 0;
+    virtual size_t readBytes(char* buffer, size_t length); // waits up to the timeout for every byte
+    size_t         readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    size_t         readBytesUntil(char terminator, char* buffer, size_t length);
+    String         readStringUntil(char terminator);
+    void           setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long  getTimeout() { return _timeout; }
+
+protected:
+    int            timedRead();
+    unsigned long  _timeout = 1000;
+};
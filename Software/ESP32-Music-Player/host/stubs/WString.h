@@ -0,0 +1,79 @@
+/*
+ * WString.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Arduino String on std::string.
+ */
+#pragma once
+
+#include <string>
+#include <stddef.h>
+
+class String {
+
+public:
+    String(const char* cstr = "") : m_s(cstr ? cstr : "") {}
+    String(const std::string& s) : m_s(s) {}
+    explicit String(char c) : m_s(1, c) {}
+    explicit String(int value, unsigned char base = 10) : m_s(toString((long long)value, base)) {}
+    explicit String(unsigned int value, unsigned char base = 10) : m_s(toString((long long)value, base)) {}
+    explicit String(long value, unsigned char base = 10) : m_s(toString((long long)value, base)) {}
+    explicit String(unsigned long value, unsigned char base = 10) : m_s(toString((long long)value, base)) {}
+    explicit String(float value, unsigned int decimals = 2);
+    explicit String(double value, unsigned int decimals = 2);
+
+    const char* c_str() const { return m_s.c_str(); }
+    unsigned    length() const { return m_s.length(); }
+    bool        isEmpty() const { return m_s.empty(); }
+    char        charAt(unsigned index) const { return index < m_s.length() ? m_s[index] : 0; }
+    char        operator[](unsigned index) const { return charAt(index); }
+    char&       operator[](unsigned index) { return m_s[index]; }
+    bool        reserve(unsigned size) { m_s.reserve(size); return true; }
+
+    String&     operator=(const char* cstr) { m_s = cstr ? cstr : ""; return *this; }
+    String&     operator+=(const String& rhs) { m_s += rhs.m_s; return *this; }
+    String&     operator+=(const char* cstr) { if(cstr) m_s += cstr; return *this; }
+    String&     operator+=(char c) { m_s += c; return *this; }
+    String&     operator+=(int n) { m_s += std::to_string(n); return *this; }
+    String&     operator+=(unsigned n) { m_s += std::to_string(n); return *this; }
+    String&     operator+=(long n) { m_s += std::to_string(n); return *this; }
+    String&     operator+=(unsigned long n) { m_s += std::to_string(n); return *this; }
+    bool        concat(const char* cstr) { *this += cstr; return true; }
+
+    bool        equals(const String& s) const { return m_s == s.m_s; }
+    bool        equals(const char* cstr) const { return m_s == (cstr ? cstr : ""); }
+    bool        equalsIgnoreCase(const String& s) const;
+    bool        operator==(const String& rhs) const { return equals(rhs); }
+    bool        operator==(const char* cstr) const { return equals(cstr); }
+    bool        operator!=(const String& rhs) const { return !equals(rhs); }
+    bool        operator!=(const char* cstr) const { return !equals(cstr); }
+    bool        startsWith(const String& prefix) const { return m_s.compare(0, prefix.m_s.length(), prefix.m_s) == 0; }
+    bool        endsWith(const String& suffix) const;
+
+    int         indexOf(char c, unsigned from = 0) const { size_t p = m_s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+    int         indexOf(const String& s, unsigned from = 0) const { size_t p = m_s.find(s.m_s, from); return p == std::string::npos ? -1 : (int)p; }
+    int         lastIndexOf(char c) const { size_t p = m_s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+    String      substring(unsigned left) const { return left < m_s.length() ? String(m_s.substr(left)) : String(); }
+    String      substring(unsigned left, unsigned right) const;
+    void        replace(const String& find, const String& replace);
+    void        remove(unsigned index, unsigned count = (unsigned)-1) { if(index < m_s.length()) m_s.erase(index, count); }
+    void        toLowerCase();
+    void        toUpperCase();
+    void        trim();
+    long        toInt() const { return atol(m_s.c_str()); }
+    float       toFloat() const { return (float)atof(m_s.c_str()); }
+
+private:
+    static std::string toString(long long value, unsigned char base);
+    std::string m_s;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+String operator+(const String& lhs, int rhs);
+String operator+(const String& lhs, unsigned rhs);
+String operator+(const String& lhs, long rhs);
+String operator+(const String& lhs, unsigned long rhs);
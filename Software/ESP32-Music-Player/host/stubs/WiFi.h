@@ -0,0 +1,59 @@
+/*
+ * WiFi.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * WiFiClient on a host socket. Copies share the socket as in the core, stop() releases the reference of the client
+ * it is called on. The socket is non-blocking for reads: read() returns 0 when nothing has arrived, connected() turns
+ * false once the peer has closed and everything is read.
+ */
+#pragma once
+
+#include <memory>
+#include "Arduino.h"
+#include "Client.h"
+
+#define WL_CONNECTED 3
+
+class WiFiClient : public ESPLwIPClient {
+
+public:
+    WiFiClient() {}
+    virtual ~WiFiClient() {}
+    int             connect(IPAddress ip, uint16_t port) override { return connect(ip, port, _timeout); }
+    int             connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+    int             connect(const char* host, uint16_t port) override { return connect(host, port, _timeout); }
+    int             connect(const char* host, uint16_t port, int32_t timeout) override;
+    size_t          write(uint8_t c) override { return write(&c, 1); }
+    size_t          write(const uint8_t* buf, size_t size) override;
+    using           Print::write;
+    int             available() override;
+    int             read() override;
+    int             read(uint8_t* buf, size_t size) override;
+    int             peek() override;
+    void            flush() override;  // as the core: drops what has arrived
+    void            stop() override;
+    uint8_t         connected() override;
+    operator bool() override { return connected(); }
+    int             setTimeout(uint32_t seconds) override { _timeout = seconds * 1000; return 0; }
+    int             setNoDelay(bool nodelay);
+    int             fd() const;
+    IPAddress       remoteIP() const;
+    uint16_t        remotePort() const;
+
+protected:
+    std::shared_ptr<struct hostSocket_t> m_socket;
+    bool            _connected = false;
+    int             _timeout = 3000;
+};
+
+class WiFiClass {
+
+public:
+    int       hostByName(const char* host, IPAddress& ip);  // getaddrinfo(), IPv4
+    uint8_t   status() { return WL_CONNECTED; }
+    bool      isConnected() { return true; }
+    int8_t    RSSI() { return -50; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,124 @@
+/*
+ * WiFiClientSecure.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * WiFiClientSecure of the core 2.0.17 over a small part of the mbedtls 2 API, which is implemented with OpenSSL
+ * (TLS 1.2, no certificate verification): enough for the client, for start_ssl_client() and for TlsClient, which
+ * drives the handshake itself and compares the master secrets to see a resumed session.
+ */
+#pragma once
+
+#include "WiFi.h"
+
+#define MBEDTLS_SSL_IS_CLIENT             0
+#define MBEDTLS_SSL_TRANSPORT_STREAM      0
+#define MBEDTLS_SSL_PRESET_DEFAULT        0
+#define MBEDTLS_SSL_VERIFY_NONE           0
+#define MBEDTLS_SSL_VERIFY_REQUIRED       2
+#define MBEDTLS_ERR_SSL_WANT_READ         -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE        -0x6880
+#define MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY -0x7880
+#define MBEDTLS_ERR_SSL_CONN_EOF          -0x7280
+#define MBEDTLS_ERR_NET_CONN_RESET        -0x0050
+#define MBEDTLS_ERR_SSL_INTERNAL_ERROR    -0x6C00
+
+typedef struct mbedtls_ssl_session {
+    unsigned char           master[48];
+    struct ssl_session_st*  host;       // OpenSSL's SSL_SESSION
+} mbedtls_ssl_session;
+
+typedef struct mbedtls_ssl_config {
+    int                     endpoint;
+    int                     authmode;
+} mbedtls_ssl_config;
+
+typedef struct mbedtls_ssl_context {
+    const mbedtls_ssl_config* conf;
+    mbedtls_ssl_session*    session;            // the current one, after the handshake
+    mbedtls_ssl_session*    session_negotiate;  // during the handshake
+    mbedtls_ssl_session     hostSession;        // storage of both
+    struct ssl_session_st*  hostOffered;        // given to set_session()
+    struct ssl_st*          host;               // OpenSSL's SSL
+    int*                    hostFd;             // set_bio(): the socket
+    char*                   hostname;
+} mbedtls_ssl_context;
+
+typedef struct { int dummy; } mbedtls_ctr_drbg_context;
+typedef struct { int dummy; } mbedtls_entropy_context;
+typedef int (*mbedtls_ssl_send_t)(void* ctx, const unsigned char* buf, size_t len);
+typedef int (*mbedtls_ssl_recv_t)(void* ctx, unsigned char* buf, size_t len);
+typedef int (*mbedtls_ssl_recv_timeout_t)(void* ctx, unsigned char* buf, size_t len, uint32_t timeout);
+
+void   mbedtls_ssl_init(mbedtls_ssl_context* ssl);
+void   mbedtls_ssl_free(mbedtls_ssl_context* ssl);
+void   mbedtls_ssl_config_init(mbedtls_ssl_config* conf);
+void   mbedtls_ssl_config_free(mbedtls_ssl_config* conf);
+int    mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset);
+void   mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode);
+void   mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng);
+int    mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf);
+int    mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname);
+void   mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* p_bio, mbedtls_ssl_send_t f_send, mbedtls_ssl_recv_t f_recv,
+                           mbedtls_ssl_recv_timeout_t f_recv_timeout);
+int    mbedtls_ssl_handshake(mbedtls_ssl_context* ssl);
+int    mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len);
+int    mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len);
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl);
+void   mbedtls_ssl_session_init(mbedtls_ssl_session* session);
+void   mbedtls_ssl_session_free(mbedtls_ssl_session* session);
+int    mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session);
+int    mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session);
+void   mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context* ctx);
+void   mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context* ctx);
+int    mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context* ctx, int (*f_entropy)(void*, unsigned char*, size_t), void* p_entropy,
+                             const unsigned char* custom, size_t len);
+int    mbedtls_ctr_drbg_random(void* p_rng, unsigned char* output, size_t output_len);
+void   mbedtls_entropy_init(mbedtls_entropy_context* ctx);
+void   mbedtls_entropy_free(mbedtls_entropy_context* ctx);
+int    mbedtls_entropy_func(void* data, unsigned char* output, size_t len);
+int    mbedtls_net_send(void* ctx, const unsigned char* buf, size_t len);
+int    mbedtls_net_recv(void* ctx, unsigned char* buf, size_t len);
+
+typedef struct sslclient_context {
+    int                      socket;
+    mbedtls_ssl_context      ssl_ctx;
+    mbedtls_ssl_config       ssl_conf;
+    mbedtls_ctr_drbg_context drbg_ctx;
+    mbedtls_entropy_context  entropy_ctx;
+    unsigned long            handshake_timeout;
+} sslclient_context;
+
+class WiFiClientSecure : public WiFiClient {
+
+public:
+    WiFiClientSecure();
+    ~WiFiClientSecure();
+    int             connect(IPAddress ip, uint16_t port) override { return connect(ip, port, _timeout); }
+    int             connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+    int             connect(const char* host, uint16_t port) override { return connect(host, port, _timeout); }
+    int             connect(const char* host, uint16_t port, int32_t timeout) override;
+    size_t          write(uint8_t data) override { return write(&data, 1); }
+    size_t          write(const uint8_t* buf, size_t size) override;
+    using           Print::write;
+    int             available() override;
+    int             read() override;
+    int             read(uint8_t* buf, size_t size) override;
+    int             peek() override;
+    void            flush() override {}
+    void            stop() override;
+    uint8_t         connected() override;
+    int             lastError(char* buf, const size_t size);
+    void            setInsecure() { _use_insecure = true; }
+    void            setCACert(const char* rootCA) { _CA_cert = rootCA; _use_insecure = false; }
+    void            setHandshakeTimeout(unsigned long handshake_timeout) { sslclient->handshake_timeout = handshake_timeout * 1000; }
+    int             fd() const { return sslclient->socket; }
+    operator bool() override { return connected(); }
+
+protected:
+    sslclient_context* sslclient;
+    int             _lastError = 0;
+    int             _peek = -1;
+    bool            _use_insecure = false;
+    const char*     _CA_cert = NULL;
+};
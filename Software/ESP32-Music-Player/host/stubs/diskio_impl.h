@@ -0,0 +1,18 @@
+/*
+ * diskio_impl.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * The disk driver calls of FatFs, no drive is registered on the host.
+ */
+#pragma once
+
+#include "ff.h"
+
+typedef BYTE DSTATUS;
+typedef enum { RES_OK = 0, RES_ERROR, RES_WRPRT, RES_NOTRDY, RES_PARERR } DRESULT;
+
+#define STA_NOINIT 0x01
+
+static inline DSTATUS ff_disk_status(BYTE pdrv) { return STA_NOINIT; }
+static inline DRESULT ff_disk_read(BYTE pdrv, BYTE* buff, LBA_t sector, UINT count) { return RES_NOTRDY; }
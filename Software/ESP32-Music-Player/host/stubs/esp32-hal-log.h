@@ -0,0 +1,35 @@
+/*
+ * esp32-hal-log.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * log_e() .. log_v() as the core prints them, the level is read from AUDIO_HOST_LOG (0 none .. 5 verbose, default 2).
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define ARDUHAL_LOG_LEVEL_NONE    0
+#define ARDUHAL_LOG_LEVEL_ERROR   1
+#define ARDUHAL_LOG_LEVEL_WARN    2
+#define ARDUHAL_LOG_LEVEL_INFO    3
+#define ARDUHAL_LOG_LEVEL_DEBUG   4
+#define ARDUHAL_LOG_LEVEL_VERBOSE 5
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int  hostLogLevel();
+void hostLog(int level, const char* file, int line, const char* func, const char* format, ...) __attribute__((format(printf, 5, 6)));
+#ifdef __cplusplus
+}
+#endif
+
+#define HOST_LOG(level, format, ...) \
+    do { if(hostLogLevel() >= level) hostLog(level, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__); } while(0)
+
+#define log_e(format, ...) HOST_LOG(ARDUHAL_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#define log_w(format, ...) HOST_LOG(ARDUHAL_LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define log_i(format, ...) HOST_LOG(ARDUHAL_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define log_d(format, ...) HOST_LOG(ARDUHAL_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#define log_v(format, ...) HOST_LOG(ARDUHAL_LOG_LEVEL_VERBOSE, format, ##__VA_ARGS__)
@@ -0,0 +1,38 @@
+/*
+ * esp_heap_caps.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Two counted pools on the host heap: PSRAM for MALLOC_CAP_SPIRAM and ps_malloc(), DRAM for everything else that is
+ * allocated in the process. free() and realloc() know both. Without PSRAM (hostSetPsram(false)) SPIRAM requests fail
+ * as on a board without it.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_EXEC      (1 << 0)
+#define MALLOC_CAP_32BIT     (1 << 1)
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_DEFAULT   (1 << 12)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void*  heap_caps_malloc(size_t size, uint32_t caps);
+void*  heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void*  heap_caps_realloc(void* ptr, size_t size, uint32_t caps);
+void*  heap_caps_malloc_prefer(size_t size, size_t num, ...);
+void*  heap_caps_calloc_prefer(size_t n, size_t size, size_t num, ...);
+void   heap_caps_free(void* ptr);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_total_size(uint32_t caps);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,36 @@
+/*
+ * ff.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * The part of FatFs the file reader uses to find the drive of a file. The host files are no FatFs volume: f_stat()
+ * finds no mounted drive, a test gives FileReader a FAT image with setBlockDevice().
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef uint8_t  BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint32_t LBA_t;
+typedef unsigned UINT;
+typedef char     TCHAR;
+
+#define FF_VOLUMES 2
+#define FF_MAX_LFN 255
+#define AM_DIR     0x10
+
+typedef enum { FR_OK = 0, FR_DISK_ERR, FR_INT_ERR, FR_NOT_READY, FR_NO_FILE, FR_NO_PATH, FR_INVALID_NAME,
+               FR_DENIED, FR_EXIST, FR_INVALID_OBJECT, FR_WRITE_PROTECTED, FR_INVALID_DRIVE, FR_NOT_ENABLED } FRESULT;
+
+typedef struct {
+    DWORD fsize;
+    WORD  fdate;
+    WORD  ftime;
+    BYTE  fattrib;
+    TCHAR altname[13];
+    TCHAR fname[FF_MAX_LFN + 1];
+} FILINFO;
+
+static inline FRESULT f_stat(const TCHAR* path, FILINFO* fno) { return FR_NOT_ENABLED; }
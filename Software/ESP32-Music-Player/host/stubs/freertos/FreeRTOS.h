@@ -0,0 +1,49 @@
+/*
+ * FreeRTOS.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * The FreeRTOS calls of src/AudioI2S on std::thread: a task is a detached thread with its notification count,
+ * a semaphore is a recursive timed mutex, a tick is a millisecond. The core affinity and the priority are ignored,
+ * the stack depth as well; a host thread has the default stack of the platform.
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+typedef struct hostTask_t*      TaskHandle_t;
+typedef struct hostSemaphore_t* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS  1
+#define configTICK_RATE_HZ  1000
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define pdFAIL              0
+#define tskNO_AFFINITY      0x7FFFFFFF
+
+BaseType_t        xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                          UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+BaseType_t        xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param, UBaseType_t prio,
+                              TaskHandle_t* handle);
+void              vTaskDelete(TaskHandle_t task);          // NULL only: the calling task ends when its function returns
+void              vTaskDelay(TickType_t ticks);
+TickType_t        xTaskGetTickCount();
+TaskHandle_t      xTaskGetCurrentTaskHandle();
+uint32_t          ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+BaseType_t        xTaskNotifyGive(TaskHandle_t task);
+UBaseType_t       uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+void              vSemaphoreDelete(SemaphoreHandle_t s);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t s);
+BaseType_t        xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t ticks);
+BaseType_t        xSemaphoreGiveRecursive(SemaphoreHandle_t s);
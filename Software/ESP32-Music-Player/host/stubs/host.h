@@ -0,0 +1,41 @@
+/*
+ * host.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Controls of the host stand-ins, for the CLI and the tests.
+ *   AUDIO_HOST_LOG=n      log level, 0 none .. 5 verbose (default 2, warnings)
+ *   AUDIO_HOST_PSRAM=0    a board without PSRAM
+ *   AUDIO_HOST_I2S=path   the WAV file of the I2S output (default: none, the samples are dropped)
+ *   AUDIO_HOST_REALTIME=1 I2S takes the samples at the sample rate, as the DMA does
+ *   AUDIO_HOST_FS_ROOT=dir the directory that is the root of SD, SD_MMC, SPIFFS and FFat (default: the working directory)
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    size_t dramUsed;    // now
+    size_t dramPeak;    // since start or hostHeapResetPeak()
+    size_t psramUsed;
+    size_t psramPeak;
+} hostHeap_t;
+
+typedef struct {
+    uint64_t frames;    // written to I2S since the driver install
+    uint32_t sampleRate;
+    uint32_t files;     // WAV files written, a new one at each change of the sample rate
+    uint32_t fullWrites;// i2s_write() calls that found the DMA buffers full
+    uint32_t underruns; // real time mode: the DMA buffers ran empty between two writes while playing
+} hostI2S_t;
+
+void       hostSetLogLevel(int level);
+void       hostSetPsram(bool found);           // before Audio is constructed
+void       hostSetFsRoot(const char* dir);      // "" maps the file system paths to the host paths as they are
+hostHeap_t hostHeap();
+void       hostHeapResetPeak();
+void       hostI2S_setOutput(const char* path);  // NULL: drop the samples; a later rate gets path-2.wav, path-3.wav ..
+void       hostI2S_setRealtime(bool realtime);
+hostI2S_t  hostI2S_stats();
+void       hostI2S_close();                     // writes the WAV header of the open file
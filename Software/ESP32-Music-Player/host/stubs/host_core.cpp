@@ -0,0 +1,299 @@
+/*
+ * host_core.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Time, logging, String, Print and Stream, the ESP object and libb64.
+ */
+#include <chrono>
+#include <random>
+#include <thread>
+#include "Arduino.h"
+#include "libb64/cencode.h"
+#include "host.h"
+
+HardwareSerial Serial;
+EspClass       ESP;
+
+static const auto s_start = std::chrono::steady_clock::now();
+static int        s_logLevel = -1;
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void     delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void     yield() { std::this_thread::yield(); }
+uint32_t getCpuFrequencyMhz() { return 1000; } // getCycleCount() counts ns
+//----------------------------------------------------------------------------------------------------------------------
+long random(long howbig) {
+    static std::mt19937 gen(1);
+    return howbig > 0 ? (long)(gen() % howbig) : 0;
+}
+long random(long howsmall, long howbig) { return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall; }
+//----------------------------------------------------------------------------------------------------------------------
+static char* toBase(unsigned long long v, bool neg, char* str, int base) {
+    char  tmp[66];
+    char* p = tmp;
+    if(base < 2 || base > 36) base = 10;
+    do {
+        int d = v % base;
+        *p++ = d < 10 ? '0' + d : 'a' + d - 10;
+        v /= base;
+    } while(v);
+    char* s = str;
+    if(neg) *s++ = '-';
+    while(p > tmp) *s++ = *--p;
+    *s = 0;
+    return str;
+}
+char* itoa(int value, char* str, int base) { return lltoa(value, str, base); }
+char* ltoa(long value, char* str, int base) { return lltoa(value, str, base); }
+char* utoa(unsigned value, char* str, int base) { return toBase(value, false, str, base); }
+char* ultoa(unsigned long value, char* str, int base) { return toBase(value, false, str, base); }
+char* lltoa(long long value, char* str, int base) {
+    bool neg = value < 0 && base == 10;
+    return toBase(neg ? 0ULL - (unsigned long long)value : (unsigned long long)value, neg, str, base);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      L O G
+//----------------------------------------------------------------------------------------------------------------------
+void hostSetLogLevel(int level) { s_logLevel = level; }
+//----------------------------------------------------------------------------------------------------------------------
+extern "C" int hostLogLevel() {
+    if(s_logLevel < 0) {
+        const char* e = getenv("AUDIO_HOST_LOG");
+        s_logLevel = e ? atoi(e) : ARDUHAL_LOG_LEVEL_WARN;
+    }
+    return s_logLevel;
+}
+//----------------------------------------------------------------------------------------------------------------------
+extern "C" void hostLog(int level, const char* file, int line, const char* func, const char* format, ...) {
+    static const char tag[] = "NEWIDV";
+    const char*       name = strrchr(file, '/');
+    char              msg[512];
+    va_list           args;
+    va_start(args, format);
+    vsnprintf(msg, sizeof(msg), format, args);
+    va_end(args);
+    fprintf(stderr, "[%6lu][%c][%s:%i] %s(): %s\n", (long unsigned)millis(), tag[level], name ? name + 1 : file, line, func, msg);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      S T R I N G
+//----------------------------------------------------------------------------------------------------------------------
+String::String(float value, unsigned int decimals) : String((double)value, decimals) {}
+String::String(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    m_s = buf;
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::string String::toString(long long value, unsigned char base) {
+    char buf[72];
+    return lltoa(value, buf, base);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool String::equalsIgnoreCase(const String& s) const { return m_s.length() == s.m_s.length() && !strcasecmp(c_str(), s.c_str()); }
+//----------------------------------------------------------------------------------------------------------------------
+bool String::endsWith(const String& suffix) const {
+    return m_s.length() >= suffix.m_s.length() && m_s.compare(m_s.length() - suffix.m_s.length(), std::string::npos, suffix.m_s) == 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+String String::substring(unsigned left, unsigned right) const {
+    if(left > right) std::swap(left, right);
+    if(left >= m_s.length()) return String();
+    return String(m_s.substr(left, right - left));
+}
+//----------------------------------------------------------------------------------------------------------------------
+void String::replace(const String& find, const String& replace) {
+    if(find.m_s.empty()) return;
+    for(size_t pos = 0; (pos = m_s.find(find.m_s, pos)) != std::string::npos; pos += replace.m_s.length()) m_s.replace(pos, find.m_s.length(), replace.m_s);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void String::toLowerCase() { for(auto& c : m_s) c = tolower(c); }
+void String::toUpperCase() { for(auto& c : m_s) c = toupper(c); }
+//----------------------------------------------------------------------------------------------------------------------
+void String::trim() {
+    size_t b = m_s.find_first_not_of(" \t\r\n\f\v");
+    size_t e = m_s.find_last_not_of(" \t\r\n\f\v");
+    m_s = (b == std::string::npos) ? std::string() : m_s.substr(b, e - b + 1);
+}
+//----------------------------------------------------------------------------------------------------------------------
+String operator+(const String& lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, const char* rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const char* lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, char rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, int rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, unsigned rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, long rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, unsigned long rhs) { String s(lhs); s += rhs; return s; }
+//----------------------------------------------------------------------------------------------------------------------
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      P R I N T ,   S T R E A M
+//----------------------------------------------------------------------------------------------------------------------
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while(size-- && write(*buffer++)) n++;
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t Print::printf(const char* format, ...) {
+    char    buf[256];
+    char*   p = buf;
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if(len < 0) return 0;
+    if(len >= (int)sizeof(buf)) {
+        p = (char*)malloc(len + 1);
+        if(!p) return 0;
+        va_start(args, format);
+        vsnprintf(p, len + 1, format, args);
+        va_end(args);
+    }
+    size_t n = write((const uint8_t*)p, len);
+    if(p != buf) free(p);
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int Stream::timedRead() {
+    uint32_t start = millis();
+    do {
+        int c = read();
+        if(c >= 0) return c;
+        yield();
+    } while(millis() - start < _timeout);
+    return -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    while(n < length) {
+        int c = timedRead();
+        if(c < 0) break;
+        buffer[n++] = (char)c;
+    }
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t n = 0;
+    while(n < length) {
+        int c = timedRead();
+        if(c < 0 || c == terminator) break;
+        buffer[n++] = (char)c;
+    }
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+String Stream::readStringUntil(char terminator) {
+    String s;
+    int    c;
+    while((c = timedRead()) >= 0 && c != terminator) s += (char)c;
+    return s;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      E S P
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t EspClass::getHeapSize() { return heap_caps_get_total_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getFreeHeap() { return heap_caps_get_free_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getMinFreeHeap() { return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getMaxAllocHeap() { return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL); }
+uint32_t EspClass::getPsramSize() { return heap_caps_get_total_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getFreePsram() { return heap_caps_get_free_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getMinFreePsram() { return heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM); }
+uint32_t EspClass::getMaxAllocPsram() { return heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM); }
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      L I B B 6 4
+//----------------------------------------------------------------------------------------------------------------------
+void base64_init_encodestate(base64_encodestate* state_in) {
+    state_in->step = step_A;
+    state_in->result = 0;
+    state_in->stepcount = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+char base64_encode_value(char value_in) {
+    static const char* encoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    if(value_in > 63) return '=';
+    return encoding[(int)value_in];
+}
+//----------------------------------------------------------------------------------------------------------------------
+int base64_encode_block(const char* plaintext_in, int length_in, char* code_out, base64_encodestate* state_in) {
+    // without the line breaks of the original, as the core builds it
+    const char*       plainchar = plaintext_in;
+    const char* const plaintextend = plaintext_in + length_in;
+    char*             codechar = code_out;
+    char              result = state_in->result;
+    char              fragment;
+    switch(state_in->step) {
+        while(1) {
+        case step_A:
+            if(plainchar == plaintextend) { state_in->result = result; state_in->step = step_A; return codechar - code_out; }
+            fragment = *plainchar++;
+            result = (fragment & 0x0fc) >> 2;
+            *codechar++ = base64_encode_value(result);
+            result = (fragment & 0x003) << 4;
+            /* fall through */
+        case step_B:
+            if(plainchar == plaintextend) { state_in->result = result; state_in->step = step_B; return codechar - code_out; }
+            fragment = *plainchar++;
+            result |= (fragment & 0x0f0) >> 4;
+            *codechar++ = base64_encode_value(result);
+            result = (fragment & 0x00f) << 2;
+            /* fall through */
+        case step_C:
+            if(plainchar == plaintextend) { state_in->result = result; state_in->step = step_C; return codechar - code_out; }
+            fragment = *plainchar++;
+            result |= (fragment & 0x0c0) >> 6;
+            *codechar++ = base64_encode_value(result);
+            result = (fragment & 0x03f) >> 0;
+            *codechar++ = base64_encode_value(result);
+        }
+    }
+    return codechar - code_out;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int base64_encode_blockend(char* code_out, base64_encodestate* state_in) {
+    char* codechar = code_out;
+    switch(state_in->step) {
+        case step_B:
+            *codechar++ = base64_encode_value(state_in->result);
+            *codechar++ = '=';
+            *codechar++ = '=';
+            break;
+        case step_C:
+            *codechar++ = base64_encode_value(state_in->result);
+            *codechar++ = '=';
+            break;
+        case step_A: break;
+    }
+    *codechar = 0;
+    return codechar - code_out;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int base64_encode_chars(const char* plaintext_in, int length_in, char* code_out) {
+    base64_encodestate state;
+    base64_init_encodestate(&state);
+    int len = base64_encode_block(plaintext_in, length_in, code_out, &state);
+    return len + base64_encode_blockend(code_out + len, &state);
+}
@@ -0,0 +1,163 @@
+/*
+ * host_freertos.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Tasks are threads with a stack of HOST_TASK_STACK bytes. The part below the entry is painted, as FreeRTOS does it,
+ * uxTaskGetStackHighWaterMark() gives the stackDepth of xTaskCreate() minus the deepest use (x86-64 frames, the
+ * target's differ). Not with the address sanitizer, its frames are larger.
+ */
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+#include "Arduino.h"
+
+#define HOST_TASK_STACK (256 * 1024)
+#define HOST_STACK_FILL 0xA5
+
+struct hostTask_t {
+    std::mutex              mutex;
+    std::condition_variable cv;
+    uint32_t                notify = 0;
+    char                    name[16];
+    uint32_t                stackDepth = 0;    // of xTaskCreate(), bytes
+    uint8_t*                stackLow = NULL;   // painted from here up to stackTop
+    uint8_t*                stackTop = NULL;   // the frame of the thread entry
+};
+
+struct hostTaskStart_t {
+    hostTask_t*    task;
+    TaskFunction_t fn;
+    void*          param;
+};
+
+struct hostSemaphore_t {
+    std::recursive_timed_mutex mutex;
+};
+
+static thread_local hostTask_t* t_task = NULL; // the main thread gets its task on the first use
+
+//----------------------------------------------------------------------------------------------------------------------
+static hostTask_t* currentTask() {
+    if(!t_task) {
+        t_task = new hostTask_t; // never freed, a handle may be notified after the task has ended
+        strcpy(t_task->name, "main");
+    }
+    return t_task;
+}
+//----------------------------------------------------------------------------------------------------------------------
+#if !AUDIO_HOST_ASAN
+static void __attribute__((noinline)) paintStack(hostTask_t* task) {
+    // below this frame down to the end of the stack, a margin for the frame of the loop itself
+    volatile uint8_t here = 0;
+    uint8_t*         p = (uint8_t*)&here - 256;
+    for(volatile uint8_t* q = task->stackLow; q < p; q++) *q = HOST_STACK_FILL;
+}
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+static void* taskStart(void* arg) {
+    hostTaskStart_t s = *(hostTaskStart_t*)arg;
+    delete (hostTaskStart_t*)arg;
+    t_task = s.task;
+#if !AUDIO_HOST_ASAN
+    pthread_attr_t attr;
+    void*          addr;
+    size_t         size;
+    if(pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstack(&attr, &addr, &size);
+        pthread_attr_destroy(&attr);
+        s.task->stackLow = (uint8_t*)addr + 4096; // above the guard page
+        s.task->stackTop = (uint8_t*)&attr;       // glibc keeps the thread descriptor and TLS above the entry
+        paintStack(s.task);
+    }
+#endif
+    s.fn(s.param);
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param, UBaseType_t prio,
+                                   TaskHandle_t* handle, BaseType_t core) {
+    hostTask_t* task = new hostTask_t;
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->name[sizeof(task->name) - 1] = 0;
+    task->stackDepth = stackDepth;
+    if(handle) *handle = task;
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, HOST_TASK_STACK);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&thread, &attr, taskStart, new hostTaskStart_t{task, fn, param});
+    pthread_attr_destroy(&attr);
+    return err ? pdFAIL : pdPASS;
+}
+//----------------------------------------------------------------------------------------------------------------------
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param, UBaseType_t prio, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, param, prio, handle, tskNO_AFFINITY);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void vTaskDelete(TaskHandle_t task) {
+    if(task && task != currentTask()) log_e("host: vTaskDelete() of another task is not supported");
+}
+//----------------------------------------------------------------------------------------------------------------------
+void vTaskDelay(TickType_t ticks) {
+    if(ticks) std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+    else std::this_thread::yield();
+}
+//----------------------------------------------------------------------------------------------------------------------
+TickType_t   xTaskGetTickCount() { return millis(); }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return currentTask(); }
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    hostTask_t*                  task = currentTask();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    if(ticks == portMAX_DELAY) task->cv.wait(lock, [task] { return task->notify > 0; });
+    else task->cv.wait_for(lock, std::chrono::milliseconds(ticks), [task] { return task->notify > 0; });
+    uint32_t n = task->notify;
+    if(n) task->notify = clearOnExit ? 0 : n - 1;
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if(!task) return pdFAIL;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notify++;
+    }
+    task->cv.notify_one();
+    return pdPASS;
+}
+//----------------------------------------------------------------------------------------------------------------------
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // bytes of stackDepth never used so far, 0 for the main thread and with the address sanitizer (not measured)
+    hostTask_t* t = task ? task : currentTask();
+    if(!t->stackLow) return 0;
+    const uint8_t* p = t->stackLow;
+    while(p < t->stackTop && *p == HOST_STACK_FILL) p++;
+    uint32_t used = t->stackTop - p;
+    return used < t->stackDepth ? t->stackDepth - used : 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new hostSemaphore_t; }
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new hostSemaphore_t; }
+void              vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+//----------------------------------------------------------------------------------------------------------------------
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+    if(!s) return pdFAIL;
+    if(ticks == portMAX_DELAY) {
+        s->mutex.lock();
+        return pdTRUE;
+    }
+    return s->mutex.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    if(!s) return pdFAIL;
+    s->mutex.unlock();
+    return pdTRUE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t ticks) { return xSemaphoreTake(s, ticks); }
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s) { return xSemaphoreGive(s); }
@@ -0,0 +1,114 @@
+/*
+ * host_fs.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FS.h"
+#include "SD.h"
+#include "SD_MMC.h"
+#include "SPIFFS.h"
+#include "FFat.h"
+#include "host.h"
+
+SDFS     SD;
+SDMMCFS  SD_MMC;
+SPIFFSFS SPIFFS;
+F_Fat    FFat;
+
+namespace fs {
+
+class HostFileImpl : public FileImpl {
+
+public:
+    HostFileImpl(FILE* f, const char* path, bool dir) : m_f(f), m_path(path), m_dir(dir) {
+        const char* n = strrchr(path, '/');
+        m_name = n ? n + 1 : path;
+    }
+    ~HostFileImpl() { close(); }
+    size_t write(const uint8_t* buf, size_t size) override { return m_f ? fwrite(buf, 1, size, m_f) : 0; }
+    size_t read(uint8_t* buf, size_t size) override { return m_f ? fread(buf, 1, size, m_f) : 0; }
+    void   flush() override { if(m_f) fflush(m_f); }
+    bool   seek(uint32_t pos, SeekMode mode) override { return m_f && fseek(m_f, (long)(int32_t)pos, mode) == 0; }
+    size_t position() const override { return m_f ? ftell(m_f) : 0; }
+    size_t size() const override {
+        struct stat st;
+        if(!m_f) return 0;
+        fflush(m_f);
+        return fstat(fileno(m_f), &st) == 0 ? st.st_size : 0;
+    }
+    void   close() override {
+        if(m_f) fclose(m_f);
+        m_f = NULL;
+    }
+    const char* path() const override { return m_path.c_str(); }
+    const char* name() const override { return m_name.c_str(); }
+    bool        isDirectory() override { return m_dir; }
+    operator bool() override { return m_f || m_dir; }
+
+private:
+    FILE*       m_f;
+    std::string m_path;
+    std::string m_name;
+    bool        m_dir;
+};
+
+static std::string s_root = [] {
+    const char* e = getenv("AUDIO_HOST_FS_ROOT");
+    return std::string(e ? e : ".");
+}();
+
+// the file system path below the root, "/music/a.mp3" is "<root>/music/a.mp3" on the host
+static std::string hostPath(const char* path) {
+    if(s_root.empty()) return path;
+    return s_root + (path[0] == '/' ? "" : "/") + path;
+}
+
+class HostFSImpl : public FSImpl {
+
+public:
+    FileImplPtr open(const char* path, const char* mode, const bool create) override {
+        std::string h = hostPath(path);
+        struct stat st;
+        if(!stat(h.c_str(), &st) && S_ISDIR(st.st_mode)) return std::make_shared<HostFileImpl>((FILE*)NULL, path, true);
+        std::string m(mode);
+        if(m.find('b') == std::string::npos) m += 'b';
+        FILE* f = fopen(h.c_str(), m.c_str());
+        if(!f) return FileImplPtr();
+        return std::make_shared<HostFileImpl>(f, path, false);
+    }
+    bool exists(const char* path) override { return access(hostPath(path).c_str(), F_OK) == 0; }
+    bool rename(const char* pathFrom, const char* pathTo) override { return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0; }
+    bool remove(const char* path) override { return ::remove(hostPath(path).c_str()) == 0; }
+    bool mkdir(const char* path) override { return ::mkdir(hostPath(path).c_str(), 0777) == 0; }
+    bool rmdir(const char* path) override { return ::rmdir(hostPath(path).c_str()) == 0; }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+FSImplPtr hostFSImpl() {
+    static FSImplPtr impl = std::make_shared<HostFSImpl>();
+    return impl;
+}
+//----------------------------------------------------------------------------------------------------------------------
+File FS::open(const char* path, const char* mode, const bool create) {
+    if(!_impl || !path) return File();
+    return File(_impl->open(path, mode, create));
+}
+//----------------------------------------------------------------------------------------------------------------------
+int File::peek() {
+    if(!_p) return -1;
+    size_t  pos = _p->position();
+    uint8_t c;
+    if(_p->read(&c, 1) != 1) return -1;
+    _p->seek(pos, SeekSet);
+    return c;
+}
+
+} // namespace fs
+
+//----------------------------------------------------------------------------------------------------------------------
+void hostSetFsRoot(const char* dir) {
+    fs::s_root = dir;
+}
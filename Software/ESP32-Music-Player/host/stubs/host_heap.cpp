@@ -0,0 +1,230 @@
+/*
+ * host_heap.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * malloc() and friends are replaced for the whole process (glibc supports that), so every allocation is counted, the
+ * ones of the C++ runtime and OpenSSL included. A PSRAM block carries a 16 byte header with a tag derived from its
+ * address; free() and realloc() recognise it there, everything else is DRAM.
+ * With AUDIO_HOST_ASAN (cmake -DAUDIO_HOST_ASAN=ON) the address sanitizer owns malloc(), nothing is counted then and
+ * PSRAM is ordinary heap.
+ */
+#include <atomic>
+#include <errno.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "host.h"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void  __libc_free(void* ptr);
+}
+
+#define HOST_PSRAM_SIZE (4 * 1024 * 1024)   // WROVER
+#define HOST_DRAM_SIZE  (320 * 1024)        // what an ESP32 sketch starts with, about
+#define PSRAM_TAG       0x5053524d48454150ULL
+
+typedef struct {
+    uint64_t tag;   // PSRAM_TAG ^ address of the block
+    uint64_t size;
+} psramHeader_t;
+
+static std::atomic<size_t> s_dramUsed{0}, s_dramPeak{0}, s_psramUsed{0}, s_psramPeak{0}, s_psramMin{HOST_PSRAM_SIZE};
+static int                 s_psram = -1; // -1: AUDIO_HOST_PSRAM not read yet
+
+//----------------------------------------------------------------------------------------------------------------------
+static void count(std::atomic<size_t>& used, std::atomic<size_t>& peak, size_t add, size_t sub) {
+    size_t now = used.fetch_add(add) + add;
+    used.fetch_sub(sub);
+    now -= sub;
+    size_t p = peak.load();
+    while(now > p && !peak.compare_exchange_weak(p, now)) {}
+}
+//----------------------------------------------------------------------------------------------------------------------
+static psramHeader_t* psramHeader(void* ptr) {
+    psramHeader_t* h = (psramHeader_t*)ptr - 1;
+    return h->tag == (PSRAM_TAG ^ (uint64_t)(uintptr_t)ptr) ? h : NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool psramOn() {
+    if(s_psram < 0) {
+        const char* e = getenv("AUDIO_HOST_PSRAM");
+        s_psram = (e && *e == '0') ? 0 : 1;
+    }
+    return s_psram;
+}
+#if AUDIO_HOST_ASAN
+//----------------------------------------------------------------------------------------------------------------------
+static void* psramAlloc(size_t size) {
+    return psramOn() ? malloc(size) : NULL;
+}
+
+extern "C" {
+#else
+//----------------------------------------------------------------------------------------------------------------------
+static void* psramAlloc(size_t size) {
+    if(!psramOn() || s_psramUsed.load() + size > HOST_PSRAM_SIZE) return NULL;
+    psramHeader_t* h = (psramHeader_t*)__libc_memalign(16, sizeof(psramHeader_t) + size);
+    if(!h) return NULL;
+    h->tag = PSRAM_TAG ^ (uint64_t)(uintptr_t)(h + 1);
+    h->size = size;
+    count(s_psramUsed, s_psramPeak, size, 0);
+    size_t freeNow = HOST_PSRAM_SIZE - s_psramUsed.load(), m = s_psramMin.load();
+    while(freeNow < m && !s_psramMin.compare_exchange_weak(m, freeNow)) {}
+    return h + 1;
+}
+
+extern "C" {
+//----------------------------------------------------------------------------------------------------------------------
+void* malloc(size_t size) {
+    void* p = __libc_malloc(size);
+    if(p) count(s_dramUsed, s_dramPeak, malloc_usable_size(p), 0);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* calloc(size_t n, size_t size) {
+    void* p = __libc_calloc(n, size);
+    if(p) count(s_dramUsed, s_dramPeak, malloc_usable_size(p), 0);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void free(void* ptr) {
+    if(!ptr) return;
+    psramHeader_t* h = psramHeader(ptr);
+    if(h) {
+        s_psramUsed.fetch_sub(h->size);
+        h->tag = 0;
+        __libc_free(h);
+        return;
+    }
+    s_dramUsed.fetch_sub(malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* realloc(void* ptr, size_t size) {
+    if(!ptr) return malloc(size);
+    psramHeader_t* h = psramHeader(ptr);
+    if(h) { // stays in PSRAM
+        void* p = psramAlloc(size);
+        if(!p) return NULL;
+        memcpy(p, ptr, h->size < size ? h->size : size);
+        free(ptr);
+        return p;
+    }
+    size_t old = malloc_usable_size(ptr);
+    void*  p = __libc_realloc(ptr, size);
+    if(p) count(s_dramUsed, s_dramPeak, malloc_usable_size(p), old);
+    else if(!size) s_dramUsed.fetch_sub(old);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* memalign(size_t alignment, size_t size) {
+    void* p = __libc_memalign(alignment, size);
+    if(p) count(s_dramUsed, s_dramPeak, malloc_usable_size(p), 0);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+//----------------------------------------------------------------------------------------------------------------------
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+    void* p = memalign(alignment, size);
+    if(!p) return ENOMEM;
+    *memptr = p;
+    return 0;
+}
+#endif // AUDIO_HOST_ASAN
+//----------------------------------------------------------------------------------------------------------------------
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    if(caps & MALLOC_CAP_SPIRAM) return psramAlloc(size);
+    return malloc(size);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* p = heap_caps_malloc(n * size, caps);
+    if(p) memset(p, 0, n * size);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps) {
+#if AUDIO_HOST_ASAN
+    if(!(caps & MALLOC_CAP_SPIRAM) || psramOn()) return realloc(ptr, size);
+#endif
+    if(!ptr) return heap_caps_malloc(size, caps);
+    void* p = heap_caps_malloc(size, caps);
+    if(!p) return NULL;
+    psramHeader_t* h = psramHeader(ptr);
+    size_t old = h ? h->size : malloc_usable_size(ptr);
+    memcpy(p, ptr, old < size ? old : size);
+    free(ptr);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* heap_caps_malloc_prefer(size_t size, size_t num, ...) {
+    va_list args;
+    va_start(args, num);
+    void* p = NULL;
+    while(num-- && !p) p = heap_caps_malloc(size, va_arg(args, uint32_t));
+    va_end(args);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* heap_caps_calloc_prefer(size_t n, size_t size, size_t num, ...) {
+    va_list args;
+    va_start(args, num);
+    void* p = NULL;
+    while(num-- && !p) p = heap_caps_malloc(n * size, va_arg(args, uint32_t));
+    va_end(args);
+    if(p) memset(p, 0, n * size);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void heap_caps_free(void* ptr) { free(ptr); }
+//----------------------------------------------------------------------------------------------------------------------
+size_t heap_caps_get_total_size(uint32_t caps) {
+    if(caps & MALLOC_CAP_SPIRAM) return psramOn() ? HOST_PSRAM_SIZE : 0;
+    return HOST_DRAM_SIZE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t heap_caps_get_free_size(uint32_t caps) {
+    size_t total = heap_caps_get_total_size(caps);
+    size_t used = (caps & MALLOC_CAP_SPIRAM) ? s_psramUsed.load() : s_dramUsed.load();
+    return used < total ? total - used : 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return heap_caps_get_free_size(caps); }
+//----------------------------------------------------------------------------------------------------------------------
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    if(caps & MALLOC_CAP_SPIRAM) return psramOn() ? s_psramMin.load() : 0;
+    size_t peak = s_dramPeak.load();
+    return peak < HOST_DRAM_SIZE ? HOST_DRAM_SIZE - peak : 0;
+}
+} // extern "C"
+
+//----------------------------------------------------------------------------------------------------------------------
+bool  psramInit() { return psramOn(); }
+bool  psramFound() { return psramOn(); }
+void* ps_malloc(size_t size) { return heap_caps_malloc(size, MALLOC_CAP_SPIRAM); }
+void* ps_calloc(size_t n, size_t size) { return heap_caps_calloc(n, size, MALLOC_CAP_SPIRAM); }
+void* ps_realloc(void* ptr, size_t size) { return heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM); }
+//----------------------------------------------------------------------------------------------------------------------
+void hostSetPsram(bool found) { s_psram = found ? 1 : 0; }
+//----------------------------------------------------------------------------------------------------------------------
+hostHeap_t hostHeap() {
+    hostHeap_t h;
+    h.dramUsed = s_dramUsed.load();
+    h.dramPeak = s_dramPeak.load();
+    h.psramUsed = s_psramUsed.load();
+    h.psramPeak = s_psramPeak.load();
+    return h;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void hostHeapResetPeak() {
+    s_dramPeak = s_dramUsed.load();
+    s_psramPeak = s_psramUsed.load();
+}
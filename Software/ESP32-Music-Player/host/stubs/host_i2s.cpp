@@ -0,0 +1,192 @@
+/*
+ * host_i2s.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "driver/i2s.h"
+#include "host.h"
+
+static struct hostI2S {
+    std::mutex  mutex;
+    bool        installed = false;
+    bool        running = false;
+    bool        realtime = false;
+    uint32_t    sampleRate = 44100;
+    uint32_t    dmaFrames = 8192;     // dma_buf_count * dma_buf_len
+    double      level = 0;            // frames in the DMA buffers, real time mode
+    uint64_t    lastUs = 0;
+    std::string path;                 // "": drop
+    FILE*       file = NULL;
+    uint32_t    fileRate = 0;
+    uint64_t    fileBytes = 0;
+    hostI2S_t   stats = {0, 0, 0, 0, 0};
+    bool        envRead = false;
+    ~hostI2S() { closeFile(); }
+
+    //------------------------------------------------------------------------------------------------------------------
+    void readEnv() {
+        if(envRead) return;
+        envRead = true;
+        const char* e = getenv("AUDIO_HOST_I2S");
+        if(e && path.empty()) path = e;
+        e = getenv("AUDIO_HOST_REALTIME");
+        if(e && *e == '1') realtime = true;
+    }
+    //------------------------------------------------------------------------------------------------------------------
+    static void header(FILE* f, uint32_t rate, uint64_t bytes) {
+        uint32_t dataLen = bytes > 0xFFFFFFF0ULL ? 0xFFFFFFF0UL : (uint32_t)bytes;
+        uint8_t  h[44];
+        auto     le = [&](int pos, uint32_t v, int n) { for(int i = 0; i < n; i++) h[pos + i] = (v >> (8 * i)) & 0xFF; };
+        memcpy(h, "RIFF", 4);
+        le(4, dataLen + 36, 4);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        le(16, 16, 4);
+        le(20, 1, 2);               // PCM
+        le(22, 2, 2);               // stereo
+        le(24, rate, 4);
+        le(28, rate * 4, 4);
+        le(32, 4, 2);
+        le(34, 16, 2);
+        memcpy(h + 36, "data", 4);
+        le(40, dataLen, 4);
+        fseek(f, 0, SEEK_SET);
+        fwrite(h, 1, sizeof(h), f);
+        fseek(f, 0, SEEK_END);
+    }
+    //------------------------------------------------------------------------------------------------------------------
+    void closeFile() {
+        if(!file) return;
+        header(file, fileRate, fileBytes);
+        fclose(file);
+        file = NULL;
+    }
+    //------------------------------------------------------------------------------------------------------------------
+    void output(const void* src, size_t bytes) {
+        if(path.empty()) return;
+        if(file && fileRate != sampleRate) closeFile(); // WAV has one rate, the next file gets the new one
+        if(!file) {
+            std::string p = path;
+            if(stats.files) {
+                size_t dot = p.rfind('.');
+                size_t slash = p.rfind('/');
+                if(dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = p.length();
+                p.insert(dot, "-" + std::to_string(stats.files + 1));
+            }
+            file = fopen(p.c_str(), "w+b");
+            if(!file) { log_e("host i2s: can't create %s", p.c_str()); path.clear(); return; }
+            stats.files++;
+            fileRate = sampleRate;
+            fileBytes = 0;
+            header(file, fileRate, 0);
+        }
+        fwrite(src, 1, bytes, file);
+        fileBytes += bytes;
+    }
+    //------------------------------------------------------------------------------------------------------------------
+    uint64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+} s_i2s;
+
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_driver_install(i2s_port_t i2s_num, const i2s_config_t* i2s_config, int queue_size, void* i2s_queue) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.readEnv();
+    s_i2s.installed = true;
+    s_i2s.running = true;
+    s_i2s.sampleRate = i2s_config->sample_rate;
+    s_i2s.dmaFrames = i2s_config->dma_buf_count * i2s_config->dma_buf_len;
+    s_i2s.level = 0;
+    s_i2s.lastUs = s_i2s.nowUs();
+    return ESP_OK;
+}
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_driver_uninstall(i2s_port_t i2s_num) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.installed = false;
+    return ESP_OK;
+}
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_set_pin(i2s_port_t i2s_num, const i2s_pin_config_t* pin) { return ESP_OK; }
+esp_err_t i2s_set_dac_mode(i2s_dac_mode_t dac_mode) { return ESP_OK; }
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_set_sample_rates(i2s_port_t i2s_num, uint32_t rate) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.sampleRate = rate;
+    return ESP_OK;
+}
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_start(i2s_port_t i2s_num) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.running = true;
+    s_i2s.lastUs = s_i2s.nowUs();
+    return ESP_OK;
+}
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_stop(i2s_port_t i2s_num) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.running = false;
+    return ESP_OK;
+}
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_zero_dma_buffer(i2s_port_t i2s_num) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.level = 0;
+    return ESP_OK;
+}
+//----------------------------------------------------------------------------------------------------------------------
+esp_err_t i2s_write(i2s_port_t i2s_num, const void* src, size_t size, size_t* bytes_written, TickType_t ticks_to_wait) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    *bytes_written = 0;
+    if(!s_i2s.installed) return ESP_FAIL;
+    size_t frames = size / 4;
+    if(s_i2s.realtime) {
+        uint64_t now = s_i2s.nowUs();
+        if(s_i2s.running && s_i2s.level > 0) {
+            s_i2s.level -= (now - s_i2s.lastUs) * 1e-6 * s_i2s.sampleRate;
+            if(s_i2s.level < 0) s_i2s.stats.underruns++; // the DMA sent silence
+        }
+        if(s_i2s.level < 0) s_i2s.level = 0;
+        s_i2s.lastUs = now;
+        size_t space = s_i2s.dmaFrames - (size_t)s_i2s.level;
+        if(frames > space) {
+            frames = space;
+            s_i2s.stats.fullWrites++;
+        }
+        s_i2s.level += frames;
+    }
+    s_i2s.output(src, frames * 4);
+    s_i2s.stats.frames += frames;
+    s_i2s.stats.sampleRate = s_i2s.sampleRate;
+    *bytes_written = frames * 4;
+    return frames || !size ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void hostI2S_setOutput(const char* path) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.readEnv();
+    s_i2s.closeFile();
+    s_i2s.path = path ? path : "";
+    s_i2s.stats.files = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void hostI2S_setRealtime(bool realtime) {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.readEnv();
+    s_i2s.realtime = realtime;
+}
+//----------------------------------------------------------------------------------------------------------------------
+hostI2S_t hostI2S_stats() {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    return s_i2s.stats;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void hostI2S_close() {
+    std::lock_guard<std::mutex> lock(s_i2s.mutex);
+    s_i2s.closeFile();
+}
@@ -0,0 +1,331 @@
+/*
+ * host_tls.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * The mbedtls calls of the core's ssl_client.cpp and of TlsClient on OpenSSL, then WiFiClientSecure as the core 2.0.17
+ * has it. An OpenSSL session stands for the mbedtls session, its master key is copied into master[] so that
+ * TlsClient sees a resumed handshake the way it does on the target.
+ */
+#include <mutex>
+#include <poll.h>
+#include <signal.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include "lwip/sockets.h"
+#include "WiFiClientSecure.h"
+
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA -0x7100
+
+static SSL_CTX* s_ctx = NULL;
+
+//----------------------------------------------------------------------------------------------------------------------
+static SSL_CTX* sslCtx() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        signal(SIGPIPE, SIG_IGN); // OpenSSL writes to the socket with write(), lwip raises no signal on a closed peer
+        s_ctx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_max_proto_version(s_ctx, TLS1_2_VERSION); // mbedtls 2 of the core has no TLS 1.3
+        SSL_CTX_set_verify(s_ctx, SSL_VERIFY_NONE, NULL);
+    });
+    return s_ctx;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int sslError(SSL* ssl, int ret) {
+    switch(SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:   return MBEDTLS_ERR_SSL_WANT_READ;
+        case SSL_ERROR_WANT_WRITE:  return MBEDTLS_ERR_SSL_WANT_WRITE;
+        case SSL_ERROR_ZERO_RETURN: return MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY;
+        case SSL_ERROR_SYSCALL:     ERR_clear_error(); return MBEDTLS_ERR_NET_CONN_RESET;
+        default: {
+            char buf[160];
+            ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+            ERR_clear_error();
+            log_d("tls: %s", buf);
+            return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      M B E D T L S
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl) {
+    memset(ssl, 0, sizeof(*ssl));
+    ssl->session_negotiate = &ssl->hostSession;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl) {
+    // the core closes without close_notify, OpenSSL would then take the session as bad, mbedtls keeps it resumable
+    if(ssl->host) SSL_set_shutdown(ssl->host, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+    if(ssl->host) SSL_free(ssl->host);
+    if(ssl->hostOffered) SSL_SESSION_free(ssl->hostOffered);
+    mbedtls_ssl_session_free(&ssl->hostSession);
+    free(ssl->hostname);
+    mbedtls_ssl_init(ssl);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf) { memset(conf, 0, sizeof(*conf)); }
+void mbedtls_ssl_config_free(mbedtls_ssl_config* conf) { memset(conf, 0, sizeof(*conf)); }
+int  mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset) {
+    conf->endpoint = endpoint;
+    conf->authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
+    return 0;
+}
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode) { conf->authmode = authmode; }
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng) {}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf) {
+    ssl->conf = conf;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname) {
+    free(ssl->hostname);
+    ssl->hostname = hostname ? strdup(hostname) : NULL;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* p_bio, mbedtls_ssl_send_t f_send, mbedtls_ssl_recv_t f_recv,
+                         mbedtls_ssl_recv_timeout_t f_recv_timeout) {
+    ssl->hostFd = (int*)p_bio; // mbedtls_net_send/recv on the socket, OpenSSL uses it directly
+}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl) {
+    if(!ssl->host) {
+        if(!ssl->hostFd) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        ssl->host = SSL_new(sslCtx());
+        if(!ssl->host) return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        SSL_set_fd(ssl->host, *ssl->hostFd);
+        SSL_set_connect_state(ssl->host);
+        if(ssl->hostname && !isdigit((uint8_t)ssl->hostname[0])) SSL_set_tlsext_host_name(ssl->host, ssl->hostname);
+        if(ssl->hostOffered) SSL_set_session(ssl->host, ssl->hostOffered);
+    }
+    int ret = SSL_do_handshake(ssl->host);
+    if(ret != 1) return sslError(ssl->host, ret);
+    mbedtls_ssl_session_free(&ssl->hostSession);
+    SSL_SESSION_get_master_key(SSL_get_session(ssl->host), ssl->hostSession.master, sizeof(ssl->hostSession.master));
+    ssl->session = &ssl->hostSession;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len) {
+    if(!ssl->host) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    if(!len) { // reads a record, if there is one, for get_bytes_avail()
+        unsigned char c;
+        int           ret = SSL_peek(ssl->host, &c, 1);
+        return ret > 0 ? 0 : sslError(ssl->host, ret);
+    }
+    int ret = SSL_read(ssl->host, buf, len);
+    return ret > 0 ? ret : sslError(ssl->host, ret);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len) {
+    if(!ssl->host) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    int ret = SSL_write(ssl->host, buf, len);
+    return ret > 0 ? ret : sslError(ssl->host, ret);
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl) { return ssl->host ? SSL_pending(ssl->host) : 0; }
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session) { memset(session, 0, sizeof(*session)); }
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session) {
+    if(session->host) SSL_SESSION_free(session->host);
+    memset(session, 0, sizeof(*session));
+}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+    if(!ssl->host || !ssl->session) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    session->host = SSL_get1_session(ssl->host);
+    if(!session->host) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    memcpy(session->master, ssl->session->master, sizeof(session->master));
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+    if(!session->host || ssl->host) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    if(ssl->hostOffered) SSL_SESSION_free(ssl->hostOffered);
+    SSL_SESSION_up_ref(session->host);
+    ssl->hostOffered = session->host;
+    memcpy(ssl->hostSession.master, session->master, sizeof(session->master));
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context* ctx) {}
+void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context* ctx) {}
+int  mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context* ctx, int (*f_entropy)(void*, unsigned char*, size_t), void* p_entropy,
+                           const unsigned char* custom, size_t len) { return 0; }
+int  mbedtls_ctr_drbg_random(void* p_rng, unsigned char* output, size_t output_len) { return 0; }
+void mbedtls_entropy_init(mbedtls_entropy_context* ctx) {}
+void mbedtls_entropy_free(mbedtls_entropy_context* ctx) {}
+int  mbedtls_entropy_func(void* data, unsigned char* output, size_t len) { return 0; }
+int  mbedtls_net_send(void* ctx, const unsigned char* buf, size_t len) { return ::send(*(int*)ctx, buf, len, MSG_NOSIGNAL); }
+int  mbedtls_net_recv(void* ctx, unsigned char* buf, size_t len) { return ::recv(*(int*)ctx, buf, len, 0); }
+
+//----------------------------------------------------------------------------------------------------------------------
+//      S S L _ C L I E N T
+//----------------------------------------------------------------------------------------------------------------------
+static void stop_ssl_socket(sslclient_context* ssl_client) {
+    if(ssl_client->socket >= 0) {
+        ::close(ssl_client->socket);
+        ssl_client->socket = -1;
+    }
+    mbedtls_ssl_free(&ssl_client->ssl_ctx);
+    mbedtls_ssl_config_free(&ssl_client->ssl_conf);
+    mbedtls_ctr_drbg_free(&ssl_client->drbg_ctx);
+    mbedtls_entropy_free(&ssl_client->entropy_ctx);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int start_ssl_client(sslclient_context* ssl_client, IPAddress ip, uint16_t port, const char* host, int timeout) {
+    ssl_client->socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(ssl_client->socket < 0) return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+    fcntl(ssl_client->socket, F_SETFL, fcntl(ssl_client->socket, F_GETFL, 0) | O_NONBLOCK);
+    int res = ::connect(ssl_client->socket, (struct sockaddr*)&addr, sizeof(addr));
+    if(res < 0 && errno != EINPROGRESS) return -1;
+    struct pollfd pfd = {ssl_client->socket, POLLOUT, 0};
+    int           err = 0;
+    socklen_t     len = sizeof(err);
+    if(poll(&pfd, 1, timeout) <= 0) return -1;
+    getsockopt(ssl_client->socket, SOL_SOCKET, SO_ERROR, &err, &len);
+    if(err) return -1;
+
+    mbedtls_ssl_config_defaults(&ssl_client->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_authmode(&ssl_client->ssl_conf, MBEDTLS_SSL_VERIFY_NONE); // the host does not verify
+    mbedtls_ssl_setup(&ssl_client->ssl_ctx, &ssl_client->ssl_conf);
+    mbedtls_ssl_set_hostname(&ssl_client->ssl_ctx, host);
+    mbedtls_ssl_set_bio(&ssl_client->ssl_ctx, &ssl_client->socket, mbedtls_net_send, mbedtls_net_recv, NULL);
+    uint32_t start = millis();
+    int      ret;
+    while((ret = mbedtls_ssl_handshake(&ssl_client->ssl_ctx)) != 0) {
+        if(ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) return ret;
+        if(millis() - start > ssl_client->handshake_timeout) return -1;
+        vTaskDelay(2);
+    }
+    return ssl_client->socket;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      W I F I C L I E N T S E C U R E
+//----------------------------------------------------------------------------------------------------------------------
+WiFiClientSecure::WiFiClientSecure() {
+    sslclient = new sslclient_context;
+    mbedtls_ssl_init(&sslclient->ssl_ctx);
+    mbedtls_ssl_config_init(&sslclient->ssl_conf);
+    mbedtls_ctr_drbg_init(&sslclient->drbg_ctx);
+    mbedtls_entropy_init(&sslclient->entropy_ctx);
+    sslclient->socket = -1;
+    sslclient->handshake_timeout = 120000;
+    _timeout = 30000;
+}
+//----------------------------------------------------------------------------------------------------------------------
+WiFiClientSecure::~WiFiClientSecure() {
+    stop();
+    delete sslclient;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    return connect(ip.toString().c_str(), port, timeout);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::connect(const char* host, uint16_t port, int32_t timeout) {
+    stop();
+    IPAddress ip;
+    if(!WiFi.hostByName(host, ip)) return 0;
+    _timeout = timeout;
+    int ret = start_ssl_client(sslclient, ip, port, host, timeout);
+    _lastError = ret;
+    if(ret < 0) {
+        log_e("start_ssl_client: %d", ret);
+        stop();
+        return 0;
+    }
+    _connected = true;
+    return 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t WiFiClientSecure::write(const uint8_t* buf, size_t size) {
+    if(!_connected) return 0;
+    size_t   sent = 0;
+    uint32_t start = millis();
+    while(sent < size) {
+        int ret = mbedtls_ssl_write(&sslclient->ssl_ctx, buf + sent, size - sent);
+        if(ret > 0) { sent += ret; continue; }
+        if((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) || millis() - start > (uint32_t)_timeout) {
+            stop();
+            return 0;
+        }
+        vTaskDelay(2);
+    }
+    return sent;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::available() {
+    int peeked = (_peek >= 0);
+    if(!_connected) return peeked;
+    int ret = mbedtls_ssl_read(&sslclient->ssl_ctx, NULL, 0);
+    int res = mbedtls_ssl_get_bytes_avail(&sslclient->ssl_ctx);
+    if(ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE && res <= 0) {
+        stop(); // the peer has closed or the connection is broken
+        return peeked ? peeked : ret;
+    }
+    return res + peeked;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::read(uint8_t* buf, size_t size) {
+    int peeked = 0;
+    int avail = available();
+    if((!buf && size) || avail <= 0) return -1;
+    if(!size) return 0;
+    if(_peek >= 0) {
+        buf[0] = _peek;
+        _peek = -1;
+        size--;
+        avail--;
+        if(!size || !avail) return 1;
+        buf++;
+        peeked = 1;
+    }
+    int res = mbedtls_ssl_read(&sslclient->ssl_ctx, buf, size);
+    if(res < 0) {
+        stop();
+        return peeked ? peeked : res;
+    }
+    return res + peeked;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::read() {
+    uint8_t data = 0;
+    int     res = read(&data, 1);
+    if(res < 0) return res;
+    return data;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::peek() {
+    if(_peek >= 0) return _peek;
+    _peek = timedRead();
+    return _peek;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t WiFiClientSecure::connected() {
+    uint8_t dummy = 0;
+    read(&dummy, 0);
+    return _connected;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void WiFiClientSecure::stop() {
+    stop_ssl_socket(sslclient);
+    _connected = false;
+    _peek = -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClientSecure::lastError(char* buf, const size_t size) {
+    if(!_lastError) return 0;
+    snprintf(buf, size, "tls error %d", _lastError);
+    return _lastError;
+}
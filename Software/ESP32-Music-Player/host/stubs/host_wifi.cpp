@@ -0,0 +1,170 @@
+/*
+ * host_wifi.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include <netdb.h>
+#include <poll.h>
+#include "lwip/sockets.h"
+#include "WiFi.h"
+
+WiFiClass WiFi;
+
+struct hostSocket_t {
+    int fd;
+    hostSocket_t(int f) : fd(f) {}
+    ~hostSocket_t() { if(fd >= 0) ::close(fd); }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClass::hostByName(const char* host, IPAddress& ip) {
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if(getaddrinfo(host, NULL, &hints, &res) != 0 || !res) return 0;
+    ip = IPAddress((uint32_t)((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(res);
+    return 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    IPAddress ip;
+    if(!WiFi.hostByName(host, ip)) return 0;
+    return connect(ip, port, timeout);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    // as the core: a non-blocking connect that waits up to timeout ms
+    stop();
+    int fd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(fd < 0) return 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+    int window = 64 * 1024; // lwIP's receive window is a few KB, the host's grows to MBs and would take a whole file
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int res = ::connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if(res < 0 && errno != EINPROGRESS) {
+        log_e("connect on fd %d, errno: %d, \"%s\"", fd, errno, strerror(errno));
+        ::close(fd);
+        return 0;
+    }
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    if(poll(&pfd, 1, timeout < 0 ? 3000 : timeout) <= 0) {
+        log_e("select returned due to timeout %d ms for fd %d", timeout, fd);
+        ::close(fd);
+        return 0;
+    }
+    int       err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if(err) {
+        log_e("socket error on fd %d, errno: %d, \"%s\"", fd, err, strerror(err));
+        ::close(fd);
+        return 0;
+    }
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    m_socket = std::make_shared<hostSocket_t>(fd);
+    _connected = true;
+    return 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    if(!m_socket) return 0;
+    size_t   sent = 0;
+    uint32_t start = millis();
+    while(sent < size) {
+        ssize_t n = ::send(m_socket->fd, buf + sent, size - sent, MSG_NOSIGNAL);
+        if(n > 0) { sent += n; continue; }
+        if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            log_e("fail on fd %d, errno: %d, \"%s\"", m_socket->fd, errno, strerror(errno));
+            stop();
+            break;
+        }
+        if(millis() - start > (uint32_t)_timeout) break;
+        struct pollfd pfd = {m_socket->fd, POLLOUT, 0};
+        poll(&pfd, 1, 10);
+    }
+    return sent;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::available() {
+    if(!m_socket) return 0;
+    int count = 0;
+    if(ioctl(m_socket->fd, FIONREAD, &count) < 0) {
+        stop();
+        return 0;
+    }
+    return count;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    if(!m_socket) return -1;
+    ssize_t n = ::recv(m_socket->fd, buf, size, MSG_DONTWAIT);
+    if(n >= 0) return n; // 0: nothing there or the peer has closed, connected() tells which
+    if(errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    log_e("fail on fd %d, errno: %d, \"%s\"", m_socket->fd, errno, strerror(errno));
+    stop();
+    return -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::read() {
+    uint8_t c = 0;
+    int     n = read(&c, 1);
+    if(n < 0) return n;
+    return n ? c : -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::peek() {
+    if(!m_socket) return -1;
+    uint8_t c;
+    return ::recv(m_socket->fd, &c, 1, MSG_DONTWAIT | MSG_PEEK) == 1 ? c : -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void WiFiClient::flush() {
+    uint8_t buf[512];
+    for(int a = available(); a > 0; a = available()) {
+        if(read(buf, min((size_t)a, sizeof(buf))) <= 0) break;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void WiFiClient::stop() {
+    m_socket.reset();
+    _connected = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t WiFiClient::connected() {
+    if(!_connected || !m_socket) return 0;
+    uint8_t c;
+    ssize_t n = ::recv(m_socket->fd, &c, 1, MSG_DONTWAIT | MSG_PEEK);
+    if(n == 0) _connected = false; // FIN and nothing left to read
+    else if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) _connected = false;
+    return _connected;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::setNoDelay(bool nodelay) {
+    int flag = nodelay;
+    return m_socket ? setsockopt(m_socket->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) : -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WiFiClient::fd() const { return m_socket ? m_socket->fd : -1; }
+//----------------------------------------------------------------------------------------------------------------------
+IPAddress WiFiClient::remoteIP() const {
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof(addr);
+    if(!m_socket || getpeername(m_socket->fd, (struct sockaddr*)&addr, &len)) return IPAddress();
+    return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t WiFiClient::remotePort() const {
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof(addr);
+    if(!m_socket || getpeername(m_socket->fd, (struct sockaddr*)&addr, &len)) return 0;
+    return ntohs(addr.sin_port);
+}
@@ -0,0 +1,28 @@
+/*
+ * sockets.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * lwIP's BSD socket names on the sockets of the host.
+ */
+#pragma once
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define lwip_socket     ::socket
+#define lwip_connect    ::connect
+#define lwip_select     ::select
+#define lwip_getsockopt ::getsockopt
+#define lwip_setsockopt ::setsockopt
+#define lwip_close      ::close
+#define lwip_send       ::send
+#define lwip_recv       ::recv
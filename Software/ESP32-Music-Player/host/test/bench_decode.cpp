@@ -0,0 +1,232 @@
+/*
+ * bench_decode.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Runs files through the decoders' C functions (the codec table of audio_codecs.h), without Audio, and reports per file
+ * the decoded frames, cycles per frame (mean and worst), the real time factor, the peak heap and PSRAM use of the
+ * decoder (its codec arena share apart) and the FNV-1a hash of the PCM, the same hash printDecodeStats() shows on the
+ * ESP32 for the same file.
+ * On the host a cycle is a nanosecond (ESP.getCycleCount() at a nominal 1000 MHz).
+ *
+ *   bench_decode [file ...]   default: the generated corpus and the files in $AUDIO_CORPUS
+ *
+ * .mp3, .aac (ADTS), .flac, .opus and .ogg (Vorbis) are known. Without arguments the decoded WAV/FLAC tone must match
+ * its source, the MP3/AAC silence must be silent, the random CELT frames and MP3 frames must give the PCM of the
+ * decoders before their optimisations and the decoder context, the exit code tells. Files with frames of different length get a line per frame length.
+ */
+#include <dirent.h>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "audio_codecs.h"
+#include "codec_arena.h"
+#include "flac_decoder/flac_decoder.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+typedef struct {
+    uint32_t frames = 0;
+    uint64_t cycles = 0;
+    uint32_t maxCycles = 0;
+    uint64_t pcmFrames = 0;
+    uint32_t sampleRate = 0;
+    uint8_t  channels = 0;
+    uint32_t pcmHash = 2166136261UL; // FNV offset basis
+    bool     silent = true;          // all samples 0
+    uint32_t errors = 0;
+    size_t   dramPeak = 0;           // beyond the use before the decoder was set up
+    size_t   psramPeak = 0;
+    uint32_t arena = 0;              // taken from the codec arena
+    std::map<uint32_t, std::pair<uint32_t, uint64_t>> bySize; // samples per channel of a frame: frames, cycles
+} result_t;
+
+#define OPUS_PCM_HASH 0xCF2153D2UL // bench.opus, the CELT decoder before the PVQ row cache and the comb filter change
+#define MP3_PCM_HASH  0x850A3596UL // noise.mp3, the MP3 decoder on globals, before MP3Decoder_t
+
+//----------------------------------------------------------------------------------------------------------------------
+static int codecOf(const std::string& path) {
+    std::string ext = path.substr(path.rfind('.') + 1);
+    if(ext == "mp3") return CODEC_MP3;
+    if(ext == "aac") return CODEC_AAC;
+    if(ext == "flac") return CODEC_FLAC;
+    if(ext == "opus") return CODEC_OPUS;
+    if(ext == "ogg") return CODEC_VORBIS;
+    return CODEC_NONE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool readFile(const std::string& path, std::vector<uint8_t>* data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if(!f) return false;
+    fseek(f, 0, SEEK_END);
+    data->resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    bool ok = fread(data->data(), 1, data->size(), f) == data->size();
+    fclose(f);
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static size_t skipId3(const std::vector<uint8_t>& d) {
+    if(d.size() < 10 || memcmp(d.data(), "ID3", 3)) return 0;
+    return 10 + ((d[6] & 0x7F) << 21 | (d[7] & 0x7F) << 14 | (d[8] & 0x7F) << 7 | (d[9] & 0x7F));
+}
+//----------------------------------------------------------------------------------------------------------------------
+static size_t flacHeader(const std::vector<uint8_t>& d) {
+    // STREAMINFO to the decoder as Audio::read_FLAC_Header() does it, returns the first frame position
+    if(d.size() < 42 || memcmp(d.data(), "fLaC", 4)) return 0;
+    const uint8_t* si = d.data() + 8;
+    uint32_t sampleRate = (si[10] << 12) | (si[11] << 4) | (si[12] >> 4);
+    uint8_t  channels = ((si[12] >> 1) & 7) + 1;
+    uint8_t  bits = (((si[12] & 1) << 4) | (si[13] >> 4)) + 1;
+    uint32_t total = (si[14] << 24) | (si[15] << 16) | (si[16] << 8) | si[17];
+    size_t   pos = 4;
+    while(pos + 4 <= d.size()) {
+        bool last = d[pos] & 0x80;
+        pos += 4 + ((d[pos + 1] << 16) | (d[pos + 2] << 8) | d[pos + 3]);
+        if(last) break;
+    }
+    FLACSetRawBlockParams(FLACDecoder_Default(), channels, sampleRate, bits, total, d.size() - pos);
+    return pos;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool bench(const std::string& path, result_t* r) {
+    int                 c = codecOf(path);
+    const AudioCodec_t* codec = AudioCodec_Get(c);
+    std::vector<uint8_t> d;
+    if(!codec || !readFile(path, &d)) return false;
+
+    std::vector<int16_t> out(32768);
+    hostHeapResetPeak();
+    hostHeap_t base = hostHeap();
+    if(codec->arenaSize) CodecArena_Reserve(codec->arenaSize());
+    if(!codec->allocateBuffers()) return false;
+    r->arena = CodecArena_GetUsed();
+
+    size_t pos = c == CODEC_MP3 ? skipId3(d) : 0;
+    if(c == CODEC_FLAC) pos = flacHeader(d);
+    bool   f_sync = false;
+    while(pos < d.size()) {
+        int32_t left = d.size() - pos;
+        if(!f_sync) { // as Audio::findNextSync()
+            int32_t n = codec->findSyncWord(d.data() + pos, left);
+            if(n < 0) break;
+            pos += n;
+            f_sync = true;
+            continue;
+        }
+        uint32_t t0 = ESP.getCycleCount();
+        int32_t  err = codec->decode(d.data() + pos, &left, out.data());
+        uint32_t cycles = ESP.getCycleCount() - t0;
+        int32_t  used = (int32_t)(d.size() - pos) - left;
+        if(err < 0 || (used == 0 && err == 0)) { // skip the damaged frame as Audio::resyncOffset() does
+            r->errors++;
+            pos++;
+            f_sync = false;
+            continue;
+        }
+        pos += used;
+        if(codec->parseOggDone && err == codec->parseOggDone) continue;
+        uint32_t samps = codec->getOutputSamps();
+        if(!samps) continue;
+        uint8_t ch = codec->getChannels();
+        uint32_t n = codec->f_interleavedSamps ? samps : samps * ch; // int16 values
+        r->frames++;
+        r->cycles += cycles;
+        if(cycles > r->maxCycles) r->maxCycles = cycles;
+        r->bySize[n / ch].first++;
+        r->bySize[n / ch].second += cycles;
+        r->pcmFrames += n / ch;
+        r->sampleRate = codec->getSampRate();
+        r->channels = ch;
+        const uint8_t* p = (const uint8_t*)out.data();
+        for(uint32_t i = 0; i < n * 2; i++) { r->pcmHash ^= p[i]; r->pcmHash *= 16777619UL; }
+        for(uint32_t i = 0; i < n && r->silent; i++) if(out[i]) r->silent = false;
+    }
+    hostHeap_t h = hostHeap();
+    r->dramPeak = h.dramPeak - base.dramUsed;
+    r->psramPeak = h.psramPeak - base.psramUsed;
+    codec->freeBuffers();
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t hashOf(const pcm_t& pcm) {
+    uint32_t       h = 2166136261UL;
+    const uint8_t* p = (const uint8_t*)pcm.samples.data();
+    for(size_t i = 0; i < pcm.samples.size() * 2; i++) { h ^= p[i]; h *= 16777619UL; }
+    return h;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void print(const std::string& path, const result_t& r) {
+    double cpuSec = r.cycles / 1e9;
+    double audioSec = r.sampleRate ? (double)r.pcmFrames / r.sampleRate : 0;
+    printf("%-32s %6lu %10lu %9lu %8.1f %6lu/%u %9lu %9lu %7lu  %08lX %s\n", path.c_str(), (long unsigned)r.frames,
+           (long unsigned)(r.frames ? r.cycles / r.frames : 0), (long unsigned)r.maxCycles, cpuSec > 0 ? audioSec / cpuSec : 0,
+           (long unsigned)r.sampleRate, r.channels, (long unsigned)r.dramPeak, (long unsigned)r.psramPeak, (long unsigned)r.arena,
+           (long unsigned)r.pcmHash, r.errors ? "errors" : "");
+    int sizes = 0;
+    for(const auto& s : r.bySize) sizes += s.second.first > 1; // a short last frame does not count
+    if(sizes < 2) return;
+    for(const auto& s : r.bySize) { // frames of different length, the CELT frame sizes of Opus for instance
+        if(s.second.first < 2) continue;
+        printf("  %5lu samples %6lu %10lu\n", (long unsigned)s.first, (long unsigned)s.second.first,
+               (long unsigned)(s.second.second / s.second.first));
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    CodecArena_Init(AudioCodec_MaxArenaSize());
+    CodecArena_Reserve(AudioCodec_MaxArenaSize()); // taken once, as Audio does on the first codec
+    printf("%-32s %6s %10s %9s %8s %8s %9s %9s %7s  %8s\n", "file", "frames", "cyc/frame", "max cyc", "RTF", "rate/ch", "heap pk",
+           "psram pk", "arena", "PCM hash");
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; i++) files.push_back(argv[i]);
+    bool corpus = files.empty();
+    if(corpus) {
+        std::string dir = corpusDir();
+        pcm_t       tone = corpusTone(44100, 2, 10.0f);
+        CHECK(corpusWriteFlac(dir + "bench.flac", tone));
+        CHECK(corpusWriteMp3Silence(dir + "bench.mp3", 400));
+        CHECK(corpusWriteAacSilence(dir + "bench.aac", 400));
+        CHECK(corpusWriteOpus(dir + "bench.opus", 2000));
+        CHECK(corpusWriteMp3Noise(dir + "noise.mp3", 400));
+        result_t r;
+        CHECK(bench(dir + "bench.flac", &r));
+        print(dir + "bench.flac", r);
+        CHECK(r.pcmHash == hashOf(tone) && r.pcmFrames == tone.samples.size() / 2 && !r.errors);
+        for(const char* name : {"bench.mp3", "bench.aac"}) {
+            result_t s;
+            CHECK(bench(dir + name, &s));
+            print(dir + name, s);
+            CHECK(s.silent && s.frames >= 399 && !s.errors);
+        }
+        result_t m;
+        CHECK(bench(dir + "noise.mp3", &m));
+        print(dir + "noise.mp3", m);
+        CHECK(m.pcmHash == MP3_PCM_HASH && m.frames == 400 && !m.silent && !m.errors);
+        result_t o;
+        CHECK(bench(dir + "bench.opus", &o));
+        print(dir + "bench.opus", o);
+        CHECK(o.pcmHash == OPUS_PCM_HASH && o.frames == 1999 && !o.errors); // the first audio packet is skipped after OpusTags
+        const char* extra = getenv("AUDIO_CORPUS");
+        DIR*        dp = extra ? opendir(extra) : NULL;
+        for(struct dirent* e; dp && (e = readdir(dp));) {
+            std::string p = std::string(extra) + "/" + e->d_name;
+            if(codecOf(p) != CODEC_NONE) files.push_back(p);
+        }
+        if(dp) closedir(dp);
+    }
+    for(const std::string& f : files) {
+        result_t r;
+        if(!bench(f, &r)) {
+            printf("%-32s can't decode\n", f.c_str());
+            if(!corpus) s_failures++;
+            continue;
+        }
+        print(f, r);
+    }
+    return TEST_RESULT();
+}
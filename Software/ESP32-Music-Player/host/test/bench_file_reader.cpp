@@ -0,0 +1,63 @@
+/*
+ * bench_file_reader.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * FileReader::benchmark() on a FAT32 image (fat_image.h): sustained MB/s and the worst read, through the file system
+ * (FatFs' way: a FAT lookup per cluster, a command per cluster) and through the cluster runs of the file (a command per
+ * chunk, split where a run ends). Two files of 8 MB on 4 KB clusters, one contiguous and one fragmented into runs of
+ * 1..8 clusters spread over the volume. The card model: 250 µs per command and 25 µs per sector (20 MB/s), the order of
+ * an SDMMC card in 4 bit mode; the runs must be faster on both, on the fragmented file by a quarter at least.
+ *
+ *   bench_file_reader [image file]   the image of a FAT16/FAT32 card and the path of a file on it, no latency model
+ */
+#include <vector>
+#include "Arduino.h"
+#include "file_reader.h"
+#include "fat_image.h"
+#include "corpus.h"
+#include "test_util.h"
+
+#define CMD_US    250
+#define SECTOR_US 25
+
+//----------------------------------------------------------------------------------------------------------------------
+static void bench(FatImageCard& card, const char* path, readBench_t* r) {
+    std::shared_ptr<FatImageFS> image = std::make_shared<FatImageFS>(&card);
+    fs::FS                      fs(image);
+    CHECK(image->mounted());
+    printf("%s\n", path);
+    FileReader::setBlockDevice(FatImageCard::readSectors, &card);
+    uint32_t commands = card.commands;
+    CHECK(FileReader::benchmark(fs, path, Serial, r));
+    printf("%lu card commands\n", (long unsigned)(card.commands - commands));
+    FileReader::setBlockDevice(NULL, NULL);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    readBench_t r[2];
+    if(argc > 2) {
+        FatImageCard card(argv[1]);
+        bench(card, argv[2], r);
+        return TEST_RESULT();
+    }
+    std::string                 image = corpusDir() + "card.img";
+    std::vector<fatImageFile_t> files(2);
+    files[0].path = "/music/Contiguous File.flac";
+    files[1].path = "/music/Fragmented File.flac";
+    files[1].maxRun = 8;
+    for(fatImageFile_t& f : files) {
+        f.data.resize(8 * 1024 * 1024);
+        for(size_t i = 0; i < f.data.size(); i++) f.data[i] = i * 2654435761UL >> 24;
+    }
+    CHECK(fatImageWrite(image, files));
+    FatImageCard card(image, CMD_US, SECTOR_US);
+    printf("card: %u us per command, %u us per sector\n", CMD_US, SECTOR_US);
+    for(const fatImageFile_t& f : files) {
+        bench(card, f.path.c_str(), r);
+        CHECK(r[0].reads == f.data.size() / AUDIO_FILE_READER_CHUNK);
+        CHECK(r[1].kBps > r[0].kBps);
+        if(f.maxRun) CHECK(r[1].kBps > r[0].kBps * 5 / 4);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,698 @@
+/*
+ * corpus.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "corpus.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+class BitWriter {
+
+public:
+    void put(uint32_t value, int bits) {
+        for(int i = bits - 1; i >= 0; i--) {
+            m_acc = (m_acc << 1) | ((value >> i) & 1);
+            if(++m_n == 8) { m_buf.push_back(m_acc); m_acc = 0; m_n = 0; }
+        }
+    }
+    void    align() { while(m_n) put(0, 1); }
+    size_t  size() const { return m_buf.size(); }
+    uint8_t* data() { return m_buf.data(); }
+    std::vector<uint8_t>& bytes() { return m_buf; }
+
+private:
+    std::vector<uint8_t> m_buf;
+    uint8_t              m_acc = 0;
+    int                  m_n = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if(!f) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return fclose(f) == 0 && ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteFile(const std::string& path, const std::vector<uint8_t>& data) {
+    return writeFile(path, data);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusReadFile(const std::string& path, std::vector<uint8_t>* data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if(!f) return false;
+    fseek(f, 0, SEEK_END);
+    data->resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    bool ok = fread(data->data(), 1, data->size(), f) == data->size();
+    fclose(f);
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::string corpusDir() {
+    mkdir("corpus", 0777);
+    return "corpus/";
+}
+//----------------------------------------------------------------------------------------------------------------------
+pcm_t corpusTone(uint32_t sampleRate, uint16_t channels, float seconds) {
+    pcm_t    pcm;
+    uint32_t frames = sampleRate * seconds;
+    pcm.sampleRate = sampleRate;
+    pcm.channels = channels;
+    pcm.bitsPerSample = 16;
+    pcm.samples.resize(frames * channels);
+    for(uint32_t i = 0; i < frames; i++) {
+        for(uint16_t c = 0; c < channels; c++) {
+            double f = c ? 660.0 : 440.0;
+            pcm.samples[i * channels + c] = (int16_t)lrint(9000.0 * sin(2 * M_PI * f * i / sampleRate) + 300.0 * sin(2 * M_PI * 97.0 * i / sampleRate));
+        }
+    }
+    return pcm;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteWav(const std::string& path, const pcm_t& pcm) {
+    std::vector<uint8_t> d(44);
+    uint32_t             bytes = pcm.samples.size() * 2;
+    auto                 le = [&](int pos, uint32_t v, int n) { for(int i = 0; i < n; i++) d[pos + i] = (v >> (8 * i)) & 0xFF; };
+    memcpy(&d[0], "RIFF", 4);
+    le(4, bytes + 36, 4);
+    memcpy(&d[8], "WAVEfmt ", 8);
+    le(16, 16, 4);
+    le(20, 1, 2);
+    le(22, pcm.channels, 2);
+    le(24, pcm.sampleRate, 4);
+    le(28, pcm.sampleRate * pcm.channels * 2, 4);
+    le(32, pcm.channels * 2, 2);
+    le(34, 16, 2);
+    memcpy(&d[36], "data", 4);
+    le(40, bytes, 4);
+    for(int16_t s : pcm.samples) { d.push_back(s & 0xFF); d.push_back((s >> 8) & 0xFF); }
+    return writeFile(path, d);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteWavFormat(const std::string& path, const pcm_t& pcm, uint16_t format, uint16_t bitsPerSample, bool extensible) {
+    // the 16 bit samples as 24/32 bit PCM (low bytes 0x5A, below the 16 bits Audio keeps) or 32/64 bit float
+    uint16_t             bytesPerSample = bitsPerSample / 8;
+    uint32_t             bytes = pcm.samples.size() * bytesPerSample;
+    uint32_t             fmtSize = extensible ? 40 : 16;
+    std::vector<uint8_t> d(28 + fmtSize);
+    auto                 le = [&](int pos, uint32_t v, int n) { for(int i = 0; i < n; i++) d[pos + i] = (v >> (8 * i)) & 0xFF; };
+    memcpy(&d[0], "RIFF", 4);
+    le(4, bytes + 20 + fmtSize, 4);
+    memcpy(&d[8], "WAVEfmt ", 8);
+    le(16, fmtSize, 4);
+    le(20, extensible ? 0xFFFE : format, 2);
+    le(22, pcm.channels, 2);
+    le(24, pcm.sampleRate, 4);
+    le(28, pcm.sampleRate * pcm.channels * bytesPerSample, 4);
+    le(32, pcm.channels * bytesPerSample, 2);
+    le(34, bitsPerSample, 2);
+    if(extensible) { // cbSize, valid bits, channel mask, subformat GUID xxxx0000-0000-0010-8000-00AA00389B71
+        static const uint8_t guid[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+        le(36, 22, 2);
+        le(38, bitsPerSample, 2);
+        le(40, pcm.channels == 2 ? 3 : 4, 4);
+        le(44, format, 2);
+        memcpy(&d[46], guid, 14);
+    }
+    memcpy(&d[d.size() - 8], "data", 4);
+    le(d.size() - 4, bytes, 4);
+    for(int16_t s : pcm.samples) {
+        uint8_t b[8];
+        if(format == 3 && bitsPerSample == 32) { float f = s / 32768.0f; memcpy(b, &f, 4); }
+        else if(format == 3)                   { double f = s / 32768.0; memcpy(b, &f, 8); }
+        else {
+            memset(b, 0x5A, bytesPerSample - 2);
+            b[bytesPerSample - 2] = s & 0xFF;
+            b[bytesPerSample - 1] = (s >> 8) & 0xFF;
+        }
+        d.insert(d.end(), b, b + bytesPerSample);
+    }
+    return writeFile(path, d);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusReadWav(const std::string& path, pcm_t* pcm) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if(!f) return false;
+    uint8_t h[44];
+    bool    ok = fread(h, 1, 44, f) == 44 && !memcmp(h, "RIFF", 4) && !memcmp(h + 36, "data", 4);
+    if(ok) {
+        pcm->channels = h[22] | (h[23] << 8);
+        pcm->sampleRate = h[24] | (h[25] << 8) | (h[26] << 16) | ((uint32_t)h[27] << 24);
+        pcm->bitsPerSample = h[34] | (h[35] << 8);
+        uint32_t bytes = h[40] | (h[41] << 8) | (h[42] << 16) | ((uint32_t)h[43] << 24);
+        pcm->samples.resize(bytes / 2);
+        ok = pcm->bitsPerSample == 16 && fread(pcm->samples.data(), 2, bytes / 2, f) == bytes / 2;
+    }
+    fclose(f);
+    return ok;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      F L A C
+//----------------------------------------------------------------------------------------------------------------------
+static uint8_t crc8(const uint8_t* p, size_t n) {
+    uint8_t crc = 0;
+    while(n--) {
+        crc ^= *p++;
+        for(int i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint16_t crc16(const uint8_t* p, size_t n) {
+    uint16_t crc = 0;
+    while(n--) {
+        crc ^= (uint16_t)*p++ << 8;
+        for(int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+    }
+    return crc;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void flacSubframe(BitWriter& bw, const std::vector<int32_t>& x) {
+    // fixed predictor of order 2, one Rice partition with the parameter of the smallest size
+    size_t n = x.size();
+    if(n < 3) { // verbatim
+        bw.put(0, 1); bw.put(1, 6); bw.put(0, 1);
+        for(int32_t s : x) bw.put((uint32_t)s & 0xFFFF, 16);
+        return;
+    }
+    std::vector<uint32_t> u(n - 2);
+    for(size_t i = 2; i < n; i++) {
+        int32_t r = x[i] - 2 * x[i - 1] + x[i - 2];
+        u[i - 2] = ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+    }
+    int      bestK = 0;
+    uint64_t bestBits = UINT64_MAX;
+    for(int k = 0; k < 15; k++) {
+        uint64_t bits = 0;
+        for(uint32_t v : u) bits += (v >> k) + 1 + k;
+        if(bits < bestBits) { bestBits = bits; bestK = k; }
+    }
+    bw.put(0, 1); bw.put(0x0A, 6); bw.put(0, 1);    // FIXED, order 2, no wasted bits
+    bw.put((uint32_t)x[0] & 0xFFFF, 16);
+    bw.put((uint32_t)x[1] & 0xFFFF, 16);
+    bw.put(0, 2); bw.put(0, 4); bw.put(bestK, 4);   // RICE, partition order 0
+    for(uint32_t v : u) {
+        for(uint32_t q = v >> bestK; q; q--) bw.put(0, 1);
+        bw.put(1, 1);
+        if(bestK) bw.put(v & ((1u << bestK) - 1), bestK);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteFlac(const std::string& path, const pcm_t& pcm, uint32_t blockSize) {
+    uint32_t frames = pcm.samples.size() / pcm.channels;
+    BitWriter hdr;
+    for(char c : std::string("fLaC")) hdr.put(c, 8);
+    hdr.put(1, 1); hdr.put(0, 7); hdr.put(34, 24);  // last metadata block, STREAMINFO
+    hdr.put(blockSize, 16); hdr.put(blockSize, 16);
+    hdr.put(0, 24); hdr.put(0, 24);                 // frame sizes unknown
+    hdr.put(pcm.sampleRate, 20);
+    hdr.put(pcm.channels - 1, 3);
+    hdr.put(15, 5);                                 // 16 bit
+    hdr.put(0, 4); hdr.put(frames, 32);             // total samples, 36 bit
+    for(int i = 0; i < 16; i++) hdr.put(0, 8);      // no MD5
+    std::vector<uint8_t> out = hdr.bytes();
+
+    uint8_t rateCode = pcm.sampleRate == 44100 ? 9 : pcm.sampleRate == 48000 ? 10 : pcm.sampleRate == 32000 ? 8 : 0;
+    for(uint32_t pos = 0, num = 0; pos < frames; pos += blockSize, num++) {
+        uint32_t  n = std::min(blockSize, frames - pos);
+        BitWriter bw;
+        bw.put(0x3FFE, 14); bw.put(0, 1); bw.put(0, 1); // fixed block size
+        bw.put(7, 4);                                   // block size - 1 in 16 bit at the end of the header
+        bw.put(rateCode, 4);
+        bw.put(pcm.channels - 1, 4);                    // independent channels
+        bw.put(4, 3); bw.put(0, 1);                     // 16 bit
+        if(num < 0x80) bw.put(num, 8);                  // UTF-8 coded frame number
+        else { bw.put(0xC0 | (num >> 6), 8); bw.put(0x80 | (num & 0x3F), 8); }
+        bw.put(n - 1, 16);
+        bw.put(crc8(bw.data(), bw.size()), 8);
+        for(uint16_t c = 0; c < pcm.channels; c++) {
+            std::vector<int32_t> x(n);
+            for(uint32_t i = 0; i < n; i++) x[i] = pcm.samples[(pos + i) * pcm.channels + c];
+            flacSubframe(bw, x);
+        }
+        bw.align();
+        bw.put(crc16(bw.data(), bw.size()), 16);
+        out.insert(out.end(), bw.bytes().begin(), bw.bytes().end());
+    }
+    return writeFile(path, out);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      M P 3 ,   A A C
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteMp3Silence(const std::string& path, uint32_t frames) {
+    // 144 * 128000 / 44100 = 417 bytes without padding; side info all zero: no main data, every granule is silent
+    std::vector<uint8_t> out;
+    for(uint32_t i = 0; i < frames; i++) {
+        uint8_t f[417] = {0xFF, 0xFB, 0x90, 0x00};
+        out.insert(out.end(), f, f + sizeof(f));
+    }
+    return writeFile(path, out);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteMp3Noise(const std::string& path, uint32_t frames, uint32_t seed) {
+    // frames as corpusWriteMp3Silence(), the side info random within its limits, the main data random bits: 762 bits
+    // per granule and channel, enough for the scale factors and 30 big value pairs of the tables without linbits (at
+    // most 19 bits a pair), the count1 region takes the rest
+    std::mt19937         rng(seed);
+    std::vector<uint8_t> out;
+    for(uint32_t i = 0; i < frames; i++) {
+        BitWriter f;
+        f.put(0xFFFB9000, 32);                          // MPEG-1 layer 3, 128 kbit/s, 44.1 kHz, stereo
+        f.put(0, 9); f.put(0, 3); f.put(0, 8);          // main_data_begin 0, private bits, scfsi
+        for(int gr = 0; gr < 2; gr++) {
+            for(int ch = 0; ch < 2; ch++) {
+                f.put(762, 12);                         // part2_3_length, the main data split in four
+                f.put(rng() % 31, 9);                   // big_values
+                f.put(120 + rng() % 40, 8);             // global_gain
+                f.put(rng() % 16, 4);                   // scalefac_compress
+                f.put(0, 1);                            // long blocks
+                for(int r = 0; r < 3; r++) {
+                    uint32_t t;
+                    do { t = rng() % 16; } while(t == 4 || t == 14); // tables 4 and 14 do not exist
+                    f.put(t, 5);
+                }
+                f.put(rng() % 13, 4); f.put(rng() % 8, 3); // region0_count, region1_count, within the 22 bands
+                f.put(rng() % 2, 1); f.put(rng() % 2, 1); f.put(rng() % 2, 1); // preflag, scalefac_scale, count1table
+            }
+        }
+        while(f.size() < 417) f.put(rng() & 0xFF, 8);
+        out.insert(out.end(), f.bytes().begin(), f.bytes().end());
+    }
+    return writeFile(path, out);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteAacSilence(const std::string& path, uint32_t frames) {
+    // a raw data block of one CPE with a common window and max_sfb 0: no spectral data, 1024 silent samples
+    BitWriter raw;
+    raw.put(1, 3); raw.put(0, 4);                   // ID_CPE, tag 0
+    raw.put(1, 1);                                  // common_window
+    raw.put(0, 1); raw.put(0, 2); raw.put(0, 1);    // ics_info: reserved, ONLY_LONG_SEQUENCE, window shape
+    raw.put(0, 6); raw.put(0, 1);                   // max_sfb 0, no predictor
+    raw.put(0, 2);                                  // ms_mask_present 0
+    for(int ch = 0; ch < 2; ch++) {
+        raw.put(100, 8);                            // global_gain
+        raw.put(0, 1); raw.put(0, 1); raw.put(0, 1);// no pulse, tns, gain control data
+    }
+    raw.put(7, 3);                                  // ID_END
+    raw.align();
+
+    std::vector<uint8_t> out;
+    for(uint32_t i = 0; i < frames; i++) {
+        BitWriter adts;
+        uint32_t  len = 7 + raw.size();
+        adts.put(0xFFF, 12); adts.put(0, 1); adts.put(0, 2); adts.put(1, 1);  // MPEG-4, layer 0, no CRC
+        adts.put(1, 2);                             // AAC LC (profile 2 - 1)
+        adts.put(4, 4);                             // 44100 Hz
+        adts.put(0, 1); adts.put(2, 3);             // private, 2 channels
+        adts.put(0, 1); adts.put(0, 1); adts.put(0, 1); adts.put(0, 1);
+        adts.put(len, 13);
+        adts.put(0x7FF, 11);                        // VBR
+        adts.put(0, 2);                             // one raw data block
+        out.insert(out.end(), adts.bytes().begin(), adts.bytes().end());
+        out.insert(out.end(), raw.bytes().begin(), raw.bytes().end());
+    }
+    return writeFile(path, out);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      O G G
+//----------------------------------------------------------------------------------------------------------------------
+class BitWriterLsb { // Vorbis packs LSB first
+
+public:
+    void put(uint32_t value, int bits) {
+        for(int i = 0; i < bits; i++) {
+            m_acc |= ((value >> i) & 1) << m_n;
+            if(++m_n == 8) { m_buf.push_back(m_acc); m_acc = 0; m_n = 0; }
+        }
+    }
+    void codeword(uint32_t code, int len) { for(int i = len - 1; i >= 0; i--) put(code >> i, 1); } // root bit first
+    void align() { if(m_n) put(0, 8 - m_n); }
+    std::vector<uint8_t>& bytes() { return m_buf; }
+
+private:
+    std::vector<uint8_t> m_buf;
+    uint8_t              m_acc = 0;
+    int                  m_n = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t corpusOggCrc(const uint8_t* p, size_t n) {
+    uint32_t crc = 0;
+    while(n--) {
+        crc ^= (uint32_t)*p++ << 24;
+        for(int i = 0; i < 8; i++) crc = (crc & 0x80000000UL) ? (crc << 1) ^ 0x04C11DB7UL : crc << 1;
+    }
+    return crc;
+}
+//----------------------------------------------------------------------------------------------------------------------
+class OggWriter { // a page holds whole packets, up to 255 lacing values and 4096 bytes unless one packet is longer
+
+public:
+    explicit OggWriter(uint32_t serial) : m_serial(serial) {}
+    void packet(const std::vector<uint8_t>& p, int64_t granule, bool flush = false, bool eos = false) {
+        if(!m_lacing.empty() && (m_lacing.size() + p.size() / 255 + 1 > 255 || m_body.size() + p.size() > 4096)) page(false);
+        for(size_t n = p.size(); n >= 255; n -= 255) m_lacing.push_back(255);
+        m_lacing.push_back(p.size() % 255);
+        m_body.insert(m_body.end(), p.begin(), p.end());
+        m_granule = granule;
+        if(flush || eos) page(eos);
+    }
+    std::vector<uint8_t>& bytes() { return m_out; }
+
+private:
+    void page(bool eos) {
+        std::vector<uint8_t> h(27);
+        memcpy(&h[0], "OggS", 4);
+        h[5] = (m_seq == 0 ? 2 : 0) | (eos ? 4 : 0);
+        for(int i = 0; i < 8; i++) h[6 + i] = (uint64_t)m_granule >> (8 * i);
+        for(int i = 0; i < 4; i++) { h[14 + i] = m_serial >> (8 * i); h[18 + i] = m_seq >> (8 * i); }
+        h[26] = m_lacing.size();
+        h.insert(h.end(), m_lacing.begin(), m_lacing.end());
+        h.insert(h.end(), m_body.begin(), m_body.end());
+        uint32_t crc = corpusOggCrc(h.data(), h.size());
+        for(int i = 0; i < 4; i++) h[22 + i] = crc >> (8 * i);
+        m_out.insert(m_out.end(), h.begin(), h.end());
+        m_lacing.clear();
+        m_body.clear();
+        m_seq++;
+    }
+
+    std::vector<uint8_t> m_out, m_lacing, m_body;
+    uint32_t             m_serial;
+    uint32_t             m_seq = 0;
+    int64_t              m_granule = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+//      V O R B I S
+//----------------------------------------------------------------------------------------------------------------------
+// No encoder: the setup header describes two floors 1, residues of type 0, 1 and 2 and codebooks that cover every
+// decode table layout of the decoder (8/8, 8/16, 16/16 and 16/32 bit nodes/leaves, sparse and length ordered books,
+// codewords up to 20 bits); the audio packets are random symbols coded with these books, so each packet is exactly as
+// long as the decoder reads. The result is noise with a random spectral envelope, short and long blocks mixed.
+typedef struct {
+    uint32_t              dim, entries;
+    std::vector<uint8_t>  len;          // 0: unused entry
+    std::vector<uint32_t> code;
+    bool                  ordered, sparse;
+    uint32_t              maptype, quantvals, qBits, seq;
+    int32_t               qMin;         // multiplicand m stands for qMin + m
+} vbook_t;
+
+typedef struct {
+    uint32_t dim, subs, book;
+    int32_t  subbook[4];                // -1: no book, the value is 0
+} vclass_t;
+
+typedef struct {
+    std::vector<uint32_t> partitions;   // class of each partition
+    uint32_t              rangebits;
+    std::vector<uint32_t> posts;
+} vfloor_t;
+
+typedef struct {
+    uint32_t type, end, grouping;
+    uint8_t  cascade[4];                // stages per class
+    int32_t  books[4][8];
+} vresidue_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> vorbisLengths(uint32_t used, uint32_t maxLen, std::mt19937& rng) {
+    // a complete prefix code: leaves are split until there are enough, every other split deepens the longest one
+    std::vector<uint8_t> len = {1, 1};
+    while(len.size() < used) {
+        size_t i = rng() % len.size();
+        if(rng() & 1) i = std::max_element(len.begin(), len.end()) - len.begin();
+        while(len[i] >= maxLen) i = (i + 1) % len.size();
+        len[i]++;
+        len.push_back(len[i]);
+    }
+    for(size_t i = len.size() - 1; i > 0; i--) std::swap(len[i], len[rng() % (i + 1)]);
+    return len;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void vorbisCodewords(vbook_t* b) {
+    // the codeword assignment of the Vorbis I specification (libvorbis _make_words()), entries in order
+    uint32_t marker[33] = {0};
+    b->code.assign(b->entries, 0);
+    for(uint32_t i = 0; i < b->entries; i++) {
+        int l = b->len[i];
+        if(!l) continue;
+        uint32_t entry = marker[l];
+        b->code[i] = entry;
+        for(int j = l; j > 0; j--) {
+            if(marker[j] & 1) {
+                if(j == 1) marker[1]++;
+                else marker[j] = marker[j - 1] << 1;
+                break;
+            }
+            marker[j]++;
+        }
+        for(int j = l + 1; j < 33; j++) {
+            if((marker[j] >> 1) != entry) break;
+            entry = marker[j];
+            marker[j] = marker[j - 1] << 1;
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+static vbook_t vorbisBook(uint32_t dim, uint32_t entries, uint32_t used, uint32_t maxLen, std::mt19937& rng) {
+    vbook_t b = {dim, entries, {}, {}, false, used < entries, 0, 0, 0, 0, 0};
+    std::vector<uint8_t> l = vorbisLengths(used, maxLen, rng);
+    b.len.assign(entries, 0);
+    for(uint32_t i = 0, k = 0; i < entries; i++) {
+        if(k == used || (rng() % entries >= used && entries - i > used - k)) continue; // unused
+        b.len[i] = l[k++];
+    }
+    return b;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void vorbisPutBook(BitWriterLsb& bw, vbook_t& b) {
+    vorbisCodewords(&b);
+    bw.put(0x564342, 24);
+    bw.put(b.dim, 16);
+    bw.put(b.entries, 24);
+    bw.put(b.ordered, 1);
+    if(b.ordered) {
+        bw.put(b.len[0] - 1, 5);
+        for(uint32_t i = 0, l = b.len[0]; i < b.entries; l++) {
+            uint32_t n = 0, bits = 0;
+            while(i + n < b.entries && b.len[i + n] == l) n++;
+            for(uint32_t v = b.entries - i; v; v >>= 1) bits++;
+            bw.put(n, bits);
+            i += n;
+        }
+    }
+    else {
+        bw.put(b.sparse, 1);
+        for(uint32_t i = 0; i < b.entries; i++) {
+            if(b.sparse) bw.put(b.len[i] != 0, 1);
+            if(b.len[i]) bw.put(b.len[i] - 1, 5);
+        }
+    }
+    bw.put(b.maptype, 4);
+    if(b.maptype) {
+        // float32 of the spec: 21 bit mantissa, exponent biased by 788, sign; integers with exponent 788
+        bw.put((b.qMin < 0 ? 0x80000000UL : 0) | (788UL << 21) | (uint32_t)abs(b.qMin), 32);
+        bw.put((788UL << 21) | 1, 32); // delta 1
+        bw.put(b.qBits - 1, 4);
+        bw.put(b.seq, 1);
+        for(uint32_t m = 0; m < b.quantvals; m++) bw.put(m, b.qBits);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t vorbisSymbol(BitWriterLsb& bw, const vbook_t& b, uint32_t entry) {
+    bw.codeword(b.code[entry], b.len[entry]);
+    return entry;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t vorbisRandomSymbol(BitWriterLsb& bw, const vbook_t& b, std::mt19937& rng, uint32_t below = UINT32_MAX) {
+    uint32_t e;
+    do e = rng() % std::min(b.entries, below); while(!b.len[e]);
+    return vorbisSymbol(bw, b, e);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool corpusWriteVorbis(const std::string& path, uint32_t packets, uint32_t seed) {
+    const uint32_t blocksizes[2] = {256, 2048};
+    std::mt19937   rng(seed);
+
+    std::vector<vbook_t> books;
+    books.push_back(vorbisBook(1, 16, 16, 15, rng));    // 0: floor classes, 8/8, skewed: up to 15 bits
+    books[0].len = {3, 1, 7, 2, 15, 5, 9, 4, 11, 6, 13, 8, 10, 12, 14, 15};
+    books.push_back(vorbisBook(1, 16, 13, 10, rng));    // 1: floor values, 8/8, sparse
+    books.push_back(vorbisBook(1, 200, 200, 20, rng));  // 2: floor values, 16/16, length ordered, up to 20 bits
+    std::sort(books[2].len.begin(), books[2].len.end());
+    books[2].ordered = true;
+    books.push_back(vorbisBook(2, 16, 16, 12, rng));    // 3: residue classes, two partitions per word
+    books.push_back(vorbisBook(2, 81, 81, 16, rng));    // 4: 2 x -4..4, 16/16
+    books[4].maptype = 1; books[4].quantvals = 9; books[4].qBits = 4; books[4].qMin = -4;
+    books.push_back(vorbisBook(4, 81, 81, 14, rng));    // 5: 4 x -1..1, 16/32
+    books[5].maptype = 1; books[5].quantvals = 3; books[5].qBits = 4; books[5].qMin = -1;
+    books.push_back(vorbisBook(2, 36, 30, 12, rng));    // 6: 2 x -3..2, 8/16, sparse, sequence_p
+    books[6].maptype = 1; books[6].quantvals = 6; books[6].qBits = 4; books[6].qMin = -3; books[6].seq = 1;
+    books.push_back(vorbisBook(1, 1024, 1024, 20, rng)); // 7: floor values, 16/16, brings the setup header to 1 KB
+
+    vclass_t classes[2] = {{2, 2, 0, {-1, 1, 1, 2}}, {4, 1, 0, {2, 7, -1, -1}}};
+    vfloor_t floors[2] = {{{0, 0}, 7, {32, 8, 96, 60}},                                                 // short blocks
+                          {{1, 0, 1, 0}, 10, {512, 64, 768, 128, 300, 900, 16, 200, 40, 600, 1000, 400}}}; // long
+    vresidue_t residues[3] = {
+        {2, 2048, 32, {0, 1, 3, 9}, {{-1}, {4}, {5, 6}, {6, -1, -1, 4}}},
+        {1, 128, 16, {0, 1, 3, 9}, {{-1}, {4}, {5, 6}, {6, -1, -1, 4}}},
+        {0, 128, 16, {0, 1, 3, 9}, {{-1}, {5}, {4, 6}, {6, -1, -1, 5}}},
+    };
+
+    std::vector<uint8_t> id = {1, 'v', 'o', 'r', 'b', 'i', 's', 0, 0, 0, 0, 2, 0x44, 0xAC, 0, 0, // 2 ch, 44100 Hz
+                               0, 0, 0, 0, 0, 0xF4, 1, 0, 0, 0, 0, 0, 0xB8, 1};                   // 128 kbit/s
+    std::vector<uint8_t> comment = {3, 'v', 'o', 'r', 'b', 'i', 's', 6, 0, 0, 0, 'c', 'o', 'r', 'p', 'u', 's', 1, 0, 0, 0,
+                                    11, 0, 0, 0, 'T', 'I', 'T', 'L', 'E', '=', 'n', 'o', 'i', 's', 'e', 1};
+
+    BitWriterLsb setup;
+    for(char c : std::string("\x05vorbis")) setup.put((uint8_t)c, 8);
+    setup.put(books.size() - 1, 8);
+    for(vbook_t& b : books) vorbisPutBook(setup, b);
+    setup.put(0, 6); setup.put(0, 16);                  // time domain transforms, placeholders
+    setup.put(1, 6);
+    for(const vfloor_t& f : floors) {
+        setup.put(1, 16);                               // floor 1
+        setup.put(f.partitions.size(), 5);
+        uint32_t maxClass = 0;
+        for(uint32_t c : f.partitions) { setup.put(c, 4); maxClass = std::max(maxClass, c); }
+        for(uint32_t c = 0; c <= maxClass; c++) {
+            setup.put(classes[c].dim - 1, 3);
+            setup.put(classes[c].subs, 2);
+            if(classes[c].subs) setup.put(classes[c].book, 8);
+            for(uint32_t k = 0; k < (1u << classes[c].subs); k++) setup.put(classes[c].subbook[k] + 1, 8);
+        }
+        setup.put(1, 2);                                // multiplier 2
+        setup.put(f.rangebits, 4);
+        for(uint32_t x : f.posts) setup.put(x, f.rangebits);
+    }
+    setup.put(2, 6);
+    for(const vresidue_t& r : residues) {
+        setup.put(r.type, 16);
+        setup.put(0, 24); setup.put(r.end, 24); setup.put(r.grouping - 1, 24);
+        setup.put(3, 6);                                // 4 classifications
+        setup.put(3, 8);                                // class book
+        for(uint8_t c : r.cascade) {
+            setup.put(c & 7, 3);
+            setup.put(c > 7, 1);
+            if(c > 7) setup.put(c >> 3, 5);
+        }
+        for(int c = 0; c < 4; c++)
+            for(int s = 0; s < 8; s++)
+                if(r.cascade[c] & (1 << s)) setup.put(r.books[c][s], 8);
+    }
+    setup.put(1, 6);
+    setup.put(0, 16);                                   // mapping 0, short blocks: one submap per channel
+    setup.put(1, 1); setup.put(1, 4); setup.put(0, 1); setup.put(0, 2);
+    setup.put(0, 4); setup.put(1, 4);                   // channel 0 -> submap 0, channel 1 -> submap 1
+    setup.put(0, 8); setup.put(0, 8); setup.put(1, 8);  // floor 0, residue 1 (type 1)
+    setup.put(0, 8); setup.put(0, 8); setup.put(2, 8);  // floor 0, residue 2 (type 0)
+    setup.put(0, 16);                                   // mapping 1, long blocks: square polar coupling
+    setup.put(0, 1); setup.put(1, 1); setup.put(0, 8); setup.put(0, 1); setup.put(1, 1); setup.put(0, 2);
+    setup.put(0, 8); setup.put(1, 8); setup.put(0, 8);  // floor 1, residue 0 (type 2)
+    setup.put(1, 6);
+    for(uint32_t m = 0; m < 2; m++) { setup.put(m, 1); setup.put(0, 16); setup.put(0, 16); setup.put(m, 8); }
+    setup.put(1, 1);                                    // framing
+    setup.align();
+
+    OggWriter ogg(seed);
+    ogg.packet(id, 0, true);
+    ogg.packet(comment, 0);
+    ogg.packet(setup.bytes(), 0, true);
+
+    std::vector<uint8_t> flags(packets + 1);
+    for(uint32_t i = 0; i <= packets; i++) flags[i] = rng() % 5 != 0; // 4 of 5 blocks long
+    int64_t granule = 0;
+    for(uint32_t p = 0; p < packets; p++) {
+        uint32_t     W = flags[p], n = blocksizes[W] / 2;
+        BitWriterLsb bw;
+        bw.put(0, 1);                                   // audio packet
+        bw.put(W, 1);                                   // mode
+        if(W) { bw.put(p ? flags[p - 1] : 0, 1); bw.put(flags[p + 1], 1); }
+        bool nonzero[2];
+        for(int ch = 0; ch < 2; ch++) {
+            const vfloor_t& f = floors[W];
+            nonzero[ch] = rng() % 16 != 0;
+            bw.put(nonzero[ch], 1);
+            if(!nonzero[ch]) continue;
+            bw.put(40 + rng() % 40, 7); bw.put(40 + rng() % 40, 7);
+            for(uint32_t c : f.partitions) {
+                const vclass_t& cl = classes[c];
+                uint32_t        cval = cl.subs ? vorbisRandomSymbol(bw, books[cl.book], rng) : 0;
+                for(uint32_t k = 0; k < cl.dim; k++) {
+                    int32_t book = cl.subbook[cval & ((1 << cl.subs) - 1)];
+                    cval >>= cl.subs;
+                    if(book >= 0) vorbisRandomSymbol(bw, books[book], rng, 128); // below quant_q, the post stays in range
+                }
+            }
+        }
+        // residues: long blocks one vector of both channels (type 2), short blocks one per channel (types 1 and 0)
+        std::vector<const vresidue_t*> res;
+        std::vector<bool>              coded;
+        if(W) { res.push_back(&residues[0]); coded.push_back(nonzero[0] || nonzero[1]); }
+        else  { res.push_back(&residues[1]); res.push_back(&residues[2]); coded.push_back(nonzero[0]); coded.push_back(nonzero[1]); }
+        for(size_t r = 0; r < res.size(); r++) {
+            if(!coded[r]) continue;
+            const vresidue_t* rs = res[r];
+            uint32_t          partvals = std::min(rs->end, rs->type == 2 ? 2 * n : n) / rs->grouping;
+            std::vector<uint32_t> cls(partvals);
+            for(uint32_t& c : cls) { uint32_t x = rng() % 20; c = x < 12 ? 0 : x < 17 ? 1 : x < 19 ? 2 : 3; }
+            for(int s = 0; s < 4; s++) {
+                for(uint32_t i = 0; i < partvals; i += 2) {
+                    if(s == 0) vorbisSymbol(bw, books[3], cls[i] * 4 + cls[i + 1]);
+                    for(uint32_t k = i; k < i + 2; k++) {
+                        if(!(rs->cascade[cls[k]] & (1 << s))) continue;
+                        const vbook_t& b = books[rs->books[cls[k]][s]];
+                        for(uint32_t v = 0; v < rs->grouping; v += b.dim) vorbisRandomSymbol(bw, b, rng);
+                    }
+                }
+            }
+        }
+        bw.align();
+        if(p) granule += blocksizes[flags[p - 1]] / 4 + blocksizes[W] / 4;
+        ogg.packet(bw.bytes(), granule, false, p == packets - 1);
+    }
+    return writeFile(path, ogg.bytes());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//      O P U S
+//----------------------------------------------------------------------------------------------------------------------
+// No encoder either: CELT frames (full band, 2.5 to 20 ms, stereo) of random bytes. The range decoder turns any payload
+// into a valid frame, so the frames use band energies, PVQ codewords, transients, the comb filter and so on at random.
+bool corpusWriteOpus(const std::string& path, uint32_t packets, uint16_t preSkip, uint32_t seed) {
+    std::mt19937 rng(seed);
+
+    std::vector<uint8_t> head = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 2, (uint8_t)preSkip, (uint8_t)(preSkip >> 8),
+                                 0x80, 0xBB, 0, 0, 0, 0, 0};                                   // 2 ch, 48 kHz, no gain
+    std::vector<uint8_t> tags = {'O', 'p', 'u', 's', 'T', 'a', 'g', 's', 6, 0, 0, 0, 'c', 'o', 'r', 'p', 'u', 's',
+                                 1, 0, 0, 0, 11, 0, 0, 0, 'T', 'I', 'T', 'L', 'E', '=', 'n', 'o', 'i', 's', 'e'};
+
+    OggWriter ogg(seed);
+    ogg.packet(head, 0, true);
+    ogg.packet(tags, 0, true);
+    int64_t granule = 0;
+    for(uint32_t p = 0; p < packets; p++) {
+        uint32_t             config = 28 + rng() % 4;   // CELT FB, 2.5, 5, 10 or 20 ms
+        uint32_t             samples = 120 << (config - 28);
+        std::vector<uint8_t> packet(1 + 8 + rng() % (samples / 4)); // up to about 300 kbit/s
+        packet[0] = config << 3 | 4;                    // stereo, one frame
+        for(size_t i = 1; i < packet.size(); i++) packet[i] = rng();
+        granule += samples;
+        ogg.packet(packet, granule, false, p == packets - 1);
+    }
+    return writeFile(path, ogg.bytes());
+}
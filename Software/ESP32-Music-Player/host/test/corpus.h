@@ -0,0 +1,38 @@
+/*
+ * corpus.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Test signals, written by the tests themselves: WAV (16/24/32 bit PCM, 32/64 bit float, WAVE_FORMAT_EXTENSIBLE) and
+ * FLAC (a small encoder, fixed predictor and Rice coding) of a two tone signal, MP3 and AAC (ADTS) frames of digital
+ * silence, which need no encoder, MP3 frames of random side info and main data, Ogg Vorbis of random symbols under a
+ * complete setup header and Ogg Opus of random CELT frames. More files can be given in the directory $AUDIO_CORPUS.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef struct {
+    uint32_t             sampleRate = 0;
+    uint16_t             channels = 0;
+    uint16_t             bitsPerSample = 0;
+    std::vector<int16_t> samples;       // interleaved
+} pcm_t;
+
+pcm_t       corpusTone(uint32_t sampleRate, uint16_t channels, float seconds);  // 440 Hz left, 660 Hz right
+bool        corpusWriteWav(const std::string& path, const pcm_t& pcm);
+bool        corpusWriteWavFormat(const std::string& path, const pcm_t& pcm, uint16_t format, uint16_t bitsPerSample,
+                                 bool extensible = false);               // format 1: PCM 24/32 bit, 3: float 32/64 bit
+bool        corpusWriteFlac(const std::string& path, const pcm_t& pcm, uint32_t blockSize = 4096);
+bool        corpusWriteMp3Silence(const std::string& path, uint32_t frames);   // MPEG-1 layer 3, 128 kbit/s, 44.1 kHz
+bool        corpusWriteMp3Noise(const std::string& path, uint32_t frames, uint32_t seed = 1); // random side info and main data
+bool        corpusWriteAacSilence(const std::string& path, uint32_t frames);   // ADTS, AAC LC, 44.1 kHz stereo
+bool        corpusWriteVorbis(const std::string& path, uint32_t packets, uint32_t seed = 1); // 44.1 kHz stereo
+bool        corpusWriteOpus(const std::string& path, uint32_t packets, uint16_t preSkip = 312, uint32_t seed = 1);
+uint32_t    corpusOggCrc(const uint8_t* p, size_t n);                         // page checksum, CRC field zeroed
+bool        corpusReadWav(const std::string& path, pcm_t* pcm);               // 16 bit PCM
+bool        corpusReadFile(const std::string& path, std::vector<uint8_t>* data);
+bool        corpusWriteFile(const std::string& path, const std::vector<uint8_t>& data);
+std::string corpusDir();                                                      // created below the working directory
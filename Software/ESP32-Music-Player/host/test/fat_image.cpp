@@ -0,0 +1,320 @@
+/*
+ * fat_image.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <ctype.h>
+#include <fcntl.h>
+#include <map>
+#include <random>
+#include <string.h>
+#include <unistd.h>
+#include "fat_image.h"
+
+#define FAT_SECTOR   512
+#define FAT_SPC      8        // sectors per cluster
+#define FAT_CLUSTERS 65600    // just above the 65525 a FAT32 volume needs at least
+#define FAT_PART_LBA 2048     // first sector of the partition
+#define FAT_RSVD     32       // reserved sectors
+#define FAT_EOC      0x0FFFFFFF
+
+static void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+typedef struct {
+    uint32_t             cluster;
+    uint32_t             parent;
+    std::vector<uint8_t> entries;
+    int                  aliases = 0;
+} fatDir_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool shortName(const std::string& name, int alias, uint8_t* sfn) {
+    // the 8.3 name, returns true if the name needs a long name entry
+    size_t      dot = name.rfind('.');
+    std::string base = name.substr(0, dot), ext = dot == std::string::npos ? "" : name.substr(dot + 1);
+    bool        fits = base.size() >= 1 && base.size() <= 8 && ext.size() <= 3;
+    for(char c : name) fits = fits && ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_');
+    memset(sfn, ' ', 11);
+    if(fits) {
+        memcpy(sfn, base.data(), base.size());
+        memcpy(sfn + 8, ext.data(), ext.size());
+        return false;
+    }
+    std::string b, e;
+    for(char c : base) if(isalnum((uint8_t)c) && b.size() < 6) b += toupper(c);
+    for(char c : ext) if(isalnum((uint8_t)c) && e.size() < 3) e += toupper(c);
+    b += "~" + std::to_string(alias);
+    memcpy(sfn, b.data(), b.size());
+    memcpy(sfn + 8, e.data(), e.size());
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void addEntry(fatDir_t& dir, const std::string& name, uint8_t attr, uint32_t cluster, uint32_t size) {
+    uint8_t sfn[11], e[32];
+    if(name == "." || name == "..") {
+        memset(sfn, ' ', 11);
+        memcpy(sfn, name.data(), name.size());
+    }
+    else if(shortName(name, ++dir.aliases, sfn)) { // long name entries, the last part first
+        std::vector<uint16_t> u;
+        for(size_t i = 0; i < name.size(); i++) u.push_back((uint8_t)name[i]); // ASCII
+        uint8_t sum = 0;
+        for(int i = 0; i < 11; i++) sum = ((sum & 1) << 7) + (sum >> 1) + sfn[i];
+        static const uint8_t offs[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+        int n = (u.size() + 12) / 13;
+        for(int ord = n; ord >= 1; ord--) {
+            memset(e, 0, 32);
+            e[0] = ord | (ord == n ? 0x40 : 0);
+            e[11] = 0x0F;
+            e[13] = sum;
+            for(int k = 0; k < 13; k++) {
+                size_t i = (ord - 1) * 13 + k;
+                put16(e + offs[k], i < u.size() ? u[i] : i == u.size() ? 0 : 0xFFFF);
+            }
+            dir.entries.insert(dir.entries.end(), e, e + 32);
+        }
+    }
+    memset(e, 0, 32);
+    memcpy(e, sfn, 11);
+    e[11] = attr;
+    put16(e + 20, cluster >> 16);
+    put16(e + 26, cluster);
+    put32(e + 28, size);
+    dir.entries.insert(dir.entries.end(), e, e + 32);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool fatImageWrite(const std::string& path, const std::vector<fatImageFile_t>& files, uint32_t seed) {
+    const uint32_t clusterBytes = FAT_SPC * FAT_SECTOR;
+    const uint32_t fatSize = ((FAT_CLUSTERS + 2) * 4 + FAT_SECTOR - 1) / FAT_SECTOR;
+    const uint32_t total = FAT_RSVD + 2 * fatSize + FAT_CLUSTERS * FAT_SPC;
+    const uint32_t dataLba = FAT_PART_LBA + FAT_RSVD + 2 * fatSize;
+    std::vector<uint32_t> fat(FAT_CLUSTERS + 2, 0);
+    std::mt19937          rng(seed);
+    uint32_t              cursor = 2;
+    fat[0] = 0x0FFFFFF8;
+    fat[1] = FAT_EOC;
+
+    auto isFree = [&](uint32_t c, uint32_t n) {
+        for(uint32_t i = 0; i < n; i++) if(c + i >= FAT_CLUSTERS + 2 || fat[c + i]) return false;
+        return true;
+    };
+    auto allocate = [&](uint32_t n, uint32_t maxRun) { // the clusters of a chain, linked in the FAT
+        std::vector<uint32_t> c;
+        while(c.size() < n) {
+            uint32_t len = maxRun ? std::min<uint32_t>(1 + rng() % maxRun, n - c.size()) : n;
+            uint32_t start;
+            if(maxRun) { do start = 2 + rng() % (FAT_CLUSTERS - len); while(!isFree(start, len)); }
+            else { for(start = cursor; !isFree(start, len); start++) if(start >= FAT_CLUSTERS + 2) return std::vector<uint32_t>(); }
+            for(uint32_t i = 0; i < len; i++) { c.push_back(start + i); fat[start + i] = FAT_EOC; }
+            if(!maxRun) cursor = start + len;
+        }
+        for(size_t i = 0; i + 1 < c.size(); i++) fat[c[i]] = c[i + 1];
+        return c;
+    };
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    bool ok = ftruncate(fd, (off_t)(FAT_PART_LBA + total) * FAT_SECTOR) == 0;
+    auto writeAt = [&](uint32_t lba, const uint8_t* p, size_t n) {
+        ok = ok && pwrite(fd, p, n, (off_t)lba * FAT_SECTOR) == (ssize_t)n;
+    };
+
+    std::map<std::string, fatDir_t> dirs; // by path, "" is the root
+    dirs[""].cluster = allocate(1, 0)[0];
+    dirs[""].parent = 0;
+    for(const fatImageFile_t& f : files) {
+        std::string dir;
+        size_t      p = 1;
+        for(size_t q; (q = f.path.find('/', p)) != std::string::npos; p = q + 1) { // the directories on the way
+            std::string sub = f.path.substr(0, q);
+            if(!dirs.count(sub)) {
+                fatDir_t& d = dirs[sub];
+                d.cluster = allocate(1, 0)[0];
+                d.parent = dirs[dir].cluster;
+                addEntry(d, ".", 0x10, d.cluster, 0);
+                addEntry(d, "..", 0x10, dir.empty() ? 0 : d.parent, 0);
+                addEntry(dirs[dir], sub.substr(dir.size() + 1), 0x10, d.cluster, 0);
+            }
+            dir = sub;
+        }
+        uint32_t              n = (f.data.size() + clusterBytes - 1) / clusterBytes;
+        std::vector<uint32_t> c = allocate(n, f.maxRun);
+        if(c.size() != n) { close(fd); return false; }
+        addEntry(dirs[dir], f.path.substr(p), 0x20, n ? c[0] : 0, f.data.size());
+        for(uint32_t i = 0; i < n; i++) {
+            size_t len = std::min<size_t>(clusterBytes, f.data.size() - (size_t)i * clusterBytes);
+            writeAt(dataLba + (c[i] - 2) * FAT_SPC, f.data.data() + (size_t)i * clusterBytes, len);
+        }
+    }
+    for(auto& d : dirs) {
+        if(d.second.entries.size() > clusterBytes) { close(fd); return false; } // one cluster per directory
+        writeAt(dataLba + (d.second.cluster - 2) * FAT_SPC, d.second.entries.data(), d.second.entries.size());
+    }
+
+    uint8_t s[FAT_SECTOR] = {};
+    s[446 + 4] = 0x0C; // FAT32 LBA
+    put32(s + 446 + 8, FAT_PART_LBA);
+    put32(s + 446 + 12, total);
+    put16(s + 510, 0xAA55);
+    writeAt(0, s, FAT_SECTOR);
+    memset(s, 0, FAT_SECTOR);
+    memcpy(s, "\xEB\x58\x90" "MSWIN4.1", 11);
+    put16(s + 11, FAT_SECTOR);
+    s[13] = FAT_SPC;
+    put16(s + 14, FAT_RSVD);
+    s[16] = 2;             // FATs
+    s[21] = 0xF8;          // media
+    put16(s + 24, 63);     // sectors per track
+    put16(s + 26, 255);    // heads
+    put32(s + 28, FAT_PART_LBA);
+    put32(s + 32, total);
+    put32(s + 36, fatSize);
+    put32(s + 44, dirs[""].cluster);
+    put16(s + 48, 1);      // FSInfo
+    put16(s + 50, 6);      // backup boot sector
+    s[64] = 0x80;
+    s[66] = 0x29;
+    put32(s + 67, seed);
+    memcpy(s + 71, "NO NAME    FAT32   ", 19);
+    put16(s + 510, 0xAA55);
+    writeAt(FAT_PART_LBA, s, FAT_SECTOR);
+    writeAt(FAT_PART_LBA + 6, s, FAT_SECTOR);
+    memset(s, 0, FAT_SECTOR);
+    put32(s, 0x41615252);
+    put32(s + 484, 0x61417272);
+    put32(s + 488, 0xFFFFFFFF); // free clusters unknown
+    put32(s + 492, 0xFFFFFFFF);
+    put32(s + 508, 0xAA550000);
+    writeAt(FAT_PART_LBA + 1, s, FAT_SECTOR);
+    std::vector<uint8_t> f((size_t)fatSize * FAT_SECTOR, 0);
+    for(size_t i = 0; i < fat.size(); i++) put32(f.data() + i * 4, fat[i]);
+    writeAt(FAT_PART_LBA + FAT_RSVD, f.data(), f.size());
+    writeAt(FAT_PART_LBA + FAT_RSVD + fatSize, f.data(), f.size());
+    close(fd);
+    return ok;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+FatImageCard::FatImageCard(const std::string& path, uint32_t cmdUs, uint32_t sectorUs) : m_cmdUs(cmdUs), m_sectorUs(sectorUs) {
+    m_fd = ::open(path.c_str(), O_RDONLY);
+}
+//----------------------------------------------------------------------------------------------------------------------
+FatImageCard::~FatImageCard() {
+    if(m_fd >= 0) close(m_fd);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatImageCard::read(uint32_t lba, uint32_t count, uint8_t* buf) {
+    // the bus is busy for the whole command, the time is spun away, a sleep would add the scheduler's latency
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto   end = std::chrono::steady_clock::now() + std::chrono::microseconds(m_cmdUs + count * m_sectorUs);
+    size_t n = (size_t)count * FAT_SECTOR;
+    bool   ok = m_fd >= 0 && pread(m_fd, buf, n, (off_t)lba * FAT_SECTOR) == (ssize_t)n;
+    commands++;
+    sectors += count;
+    while(std::chrono::steady_clock::now() < end) {}
+    return ok;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+class FatImageFile : public fs::FileImpl {
+
+public:
+    FatImageFile(FatImageFS* fs, const char* path, uint32_t cluster, uint32_t size)
+        : m_fs(fs), m_path(path), m_first(cluster), m_size(size) {
+        const char* n = strrchr(path, '/');
+        m_name = n ? n + 1 : path;
+    }
+    size_t write(const uint8_t* buf, size_t size) override { return 0; }
+    size_t read(uint8_t* buf, size_t size) override;
+    void   flush() override {}
+    bool   seek(uint32_t pos, fs::SeekMode mode) override {
+        int64_t p = mode == fs::SeekSet ? pos : mode == fs::SeekCur ? m_pos + (int32_t)pos : m_size + (int32_t)pos;
+        if(p < 0 || p > m_size) return false;
+        m_pos = p;
+        return true;
+    }
+    size_t      position() const override { return m_pos; }
+    size_t      size() const override { return m_size; }
+    void        close() override { m_open = false; }
+    const char* path() const override { return m_path.c_str(); }
+    const char* name() const override { return m_name.c_str(); }
+    bool        isDirectory() override { return false; }
+    operator bool() override { return m_open; }
+
+private:
+    uint32_t clusterAt(uint32_t index);
+
+    FatImageFS* m_fs;
+    std::string m_path;
+    std::string m_name;
+    uint32_t    m_first;
+    uint32_t    m_size;
+    uint32_t    m_pos = 0;
+    uint32_t    m_cluster = 0;     // the cluster of index m_index, 0: none yet
+    uint32_t    m_index = 0;
+    uint32_t    m_bufLba = UINT32_MAX;
+    uint8_t     m_buf[FAT_SECTOR]; // the sector buffer of FIL
+    bool        m_open = true;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FatImageFile::clusterAt(uint32_t index) {
+    // forward from the current cluster, backward from the first, a link per cluster as f_read() and f_lseek() follow it
+    if(!m_cluster || index < m_index) { m_cluster = m_first; m_index = 0; }
+    while(m_cluster && m_index < index) { m_cluster = m_fs->m_vol.next(m_cluster); m_index++; }
+    return m_cluster;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t FatImageFile::read(uint8_t* buf, size_t size) {
+    std::lock_guard<std::mutex> lock(m_fs->m_mutex);
+    const uint32_t clusterBytes = m_fs->m_vol.clusterSectors() * FAT_SECTOR;
+    size_t         done = 0;
+    if(!m_open || m_pos >= m_size) return 0;
+    size = std::min<size_t>(size, m_size - m_pos);
+    while(done < size) {
+        uint32_t cluster = clusterAt(m_pos / clusterBytes);
+        if(!cluster) break;
+        uint32_t inCluster = m_pos % clusterBytes;
+        uint32_t lba = m_fs->m_vol.lba(cluster) + inCluster / FAT_SECTOR;
+        uint32_t off = m_pos % FAT_SECTOR;
+        uint32_t n;
+        if(!off && size - done >= FAT_SECTOR) { // whole sectors straight into buf, up to the end of the cluster
+            uint32_t count = std::min<uint32_t>((size - done) / FAT_SECTOR, (clusterBytes - inCluster) / FAT_SECTOR);
+            if(!m_fs->m_card->read(lba, count, buf + done)) break;
+            n = count * FAT_SECTOR;
+        }
+        else {
+            if(m_bufLba != lba) {
+                if(!m_fs->m_card->read(lba, 1, m_buf)) break;
+                m_bufLba = lba;
+            }
+            n = std::min<uint32_t>(FAT_SECTOR - off, size - done);
+            memcpy(buf + done, m_buf + off, n);
+        }
+        done += n;
+        m_pos += n;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+FatImageFS::FatImageFS(FatImageCard* card) : m_card(card) {
+    m_mounted = m_vol.mount(FatImageCard::readSectors, card);
+}
+//----------------------------------------------------------------------------------------------------------------------
+fs::FileImplPtr FatImageFS::open(const char* path, const char* mode, const bool create) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t cluster, size;
+    if(strcmp(mode, FILE_READ) || !m_mounted || !m_vol.find(path, &cluster, &size)) return fs::FileImplPtr();
+    return std::make_shared<FatImageFile>(this, path, cluster, size);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatImageFS::exists(const char* path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t cluster, size;
+    return m_mounted && m_vol.find(path, &cluster, &size);
+}
@@ -0,0 +1,66 @@
+/*
+ * fat_image.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * A FAT32 card for the file reader tests. fatImageWrite() formats an image (MBR, one partition, 65600 clusters of 4 KB,
+ * a sparse file of 257 MB) with files that are either contiguous or spread over the volume in runs of a few clusters.
+ * FatImageCard reads the image as a card does: one command at a time, each costs cmdUs plus sectorUs per sector.
+ * FatImageFS is a read-only fs::FSImpl on the card that reads as FatFs does: whole sectors of a cluster in one command,
+ * the FAT chain link by link through a window of one sector, a partial sector through the sector buffer of the file.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "FS.h"
+#include "fat_runs.h"
+
+typedef struct {
+    std::string          path;        // "/music/a.wav", the directories are created
+    std::vector<uint8_t> data;
+    uint32_t             maxRun = 0;  // 0: contiguous, else runs of 1..maxRun clusters at random places
+} fatImageFile_t;
+
+bool fatImageWrite(const std::string& path, const std::vector<fatImageFile_t>& files, uint32_t seed = 1);
+
+class FatImageCard {
+
+public:
+    FatImageCard(const std::string& path, uint32_t cmdUs = 0, uint32_t sectorUs = 0);
+    ~FatImageCard();
+    bool                  read(uint32_t lba, uint32_t count, uint8_t* buf);
+    static bool           readSectors(void* ctx, uint32_t lba, uint32_t count, uint8_t* buf) { // a fatRead_t
+        return ((FatImageCard*)ctx)->read(lba, count, buf);
+    }
+    std::atomic<uint32_t> commands{0};
+    std::atomic<uint32_t> sectors{0};
+
+private:
+    int        m_fd;
+    uint32_t   m_cmdUs;
+    uint32_t   m_sectorUs;
+    std::mutex m_mutex;
+};
+
+class FatImageFS : public fs::FSImpl {
+
+public:
+    explicit FatImageFS(FatImageCard* card);
+    bool            mounted() const { return m_mounted; }
+    fs::FileImplPtr open(const char* path, const char* mode, const bool create) override;
+    bool            exists(const char* path) override;
+    bool            rename(const char* pathFrom, const char* pathTo) override { return false; }
+    bool            remove(const char* path) override { return false; }
+    bool            mkdir(const char* path) override { return false; }
+    bool            rmdir(const char* path) override { return false; }
+
+private:
+    friend class FatImageFile;
+    FatImageCard* m_card;
+    FatVolume     m_vol;     // the FAT window of FatFs
+    std::mutex    m_mutex;   // the volume lock of FatFs
+    bool          m_mounted;
+};
@@ -0,0 +1,192 @@
+/*
+ * test_decoders.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Decoder contexts: two streams of the same codec decoded interleaved, a frame of the one, then a frame of the other,
+ * each on its own context of XDecoder_Create(), must give the PCM of the two decoded one after the other. FLAC, MP3,
+ * AAC, Opus and Vorbis; the two streams differ (seed, sample rate, channels) wherever the corpus allows it, the AAC
+ * frames are silence for both. The codec arena is not initialized, every context takes its buffers from the heap.
+ */
+#include "Arduino.h"
+#include "audio_codecs.h"
+#include "flac_decoder/flac_decoder.h"
+#include "mp3_decoder/mp3_decoder.h"
+#include "aac_decoder/aac_decoder.h"
+#include "opus_decoder/opus_decoder.h"
+#include "vorbis_decoder/vorbis_decoder.h"
+#include "corpus.h"
+#include "test_util.h"
+
+typedef struct { // the C functions of one codec on an explicit context
+    const char* name;
+    int         codec;
+    void*       (*create)();
+    void        (*destroy)(void* dec);
+    bool        (*allocate)(void* dec);
+    int32_t     (*findSync)(void* dec, uint8_t* buf, int32_t n);
+    int32_t     (*decode)(void* dec, uint8_t* buf, int32_t* left, int16_t* out);
+    uint32_t    (*outputSamps)(void* dec);
+    uint8_t     (*channels)(void* dec);
+} ops_t;
+
+typedef struct { // one stream on its own context
+    std::vector<uint8_t> data;
+    size_t               pos = 0;
+    bool                 f_sync = false;
+    bool                 f_done = false;
+    void*                dec = NULL;
+    std::vector<int16_t> pcm;
+    uint32_t             frames = 0;
+    uint32_t             errors = 0;
+} stream_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static size_t flacHeader(FLACDecoder_t* dec, const std::vector<uint8_t>& d) {
+    // STREAMINFO to the decoder as Audio::read_FLAC_Header() does it, returns the first frame position
+    const uint8_t* si = d.data() + 8;
+    uint32_t sampleRate = (si[10] << 12) | (si[11] << 4) | (si[12] >> 4);
+    uint8_t  channels = ((si[12] >> 1) & 7) + 1;
+    uint8_t  bits = (((si[12] & 1) << 4) | (si[13] >> 4)) + 1;
+    uint32_t total = (si[14] << 24) | (si[15] << 16) | (si[16] << 8) | si[17];
+    size_t   pos = 4;
+    while(pos + 4 <= d.size()) {
+        bool last = d[pos] & 0x80;
+        pos += 4 + ((d[pos + 1] << 16) | (d[pos + 2] << 8) | d[pos + 3]);
+        if(last) break;
+    }
+    FLACSetRawBlockParams(dec, channels, sampleRate, bits, total, d.size() - pos);
+    return pos;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static const ops_t s_ops[] = {
+    {"FLAC", CODEC_FLAC, []() -> void* { return FLACDecoder_Create(); },
+     [](void* d) { FLACDecoder_Destroy((FLACDecoder_t*)d); },
+     [](void* d) -> bool { return FLACDecoder_AllocateBuffers((FLACDecoder_t*)d); },
+     [](void* d, uint8_t* b, int32_t n) -> int32_t { return FLACFindSyncWord((FLACDecoder_t*)d, b, n); },
+     [](void* d, uint8_t* b, int32_t* l, int16_t* o) -> int32_t { return FLACDecode((FLACDecoder_t*)d, b, l, o); },
+     [](void* d) -> uint32_t { return FLACGetOutputSamps((FLACDecoder_t*)d); },
+     [](void* d) -> uint8_t { return FLACGetChannels((FLACDecoder_t*)d); }},
+    {"MP3", CODEC_MP3, []() -> void* { return MP3Decoder_Create(); },
+     [](void* d) { MP3Decoder_Destroy((MP3Decoder_t*)d); },
+     [](void* d) -> bool { return MP3Decoder_AllocateBuffers((MP3Decoder_t*)d); },
+     [](void* d, uint8_t* b, int32_t n) -> int32_t { return MP3FindSyncWord(b, n); },
+     [](void* d, uint8_t* b, int32_t* l, int16_t* o) -> int32_t { return MP3Decode((MP3Decoder_t*)d, b, l, o, 0); },
+     [](void* d) -> uint32_t { return MP3GetOutputSamps((MP3Decoder_t*)d); },
+     [](void* d) -> uint8_t { return MP3GetChannels((MP3Decoder_t*)d); }},
+    {"AAC", CODEC_AAC, []() -> void* { return AACDecoder_Create(); },
+     [](void* d) { AACDecoder_Destroy((AACDecoder_t*)d); },
+     [](void* d) -> bool { return AACDecoder_AllocateBuffers((AACDecoder_t*)d); },
+     [](void* d, uint8_t* b, int32_t n) -> int32_t { return AACFindSyncWord(b, n); },
+     [](void* d, uint8_t* b, int32_t* l, int16_t* o) -> int32_t { return AACDecode((AACDecoder_t*)d, b, l, o); },
+     [](void* d) -> uint32_t { return AACGetOutputSamps((AACDecoder_t*)d); },
+     [](void* d) -> uint8_t { return AACGetChannels((AACDecoder_t*)d); }},
+    {"Opus", CODEC_OPUS, []() -> void* { return OPUSDecoder_Create(); },
+     [](void* d) { OPUSDecoder_Destroy((OPUSDecoder_t*)d); },
+     [](void* d) -> bool { return OPUSDecoder_AllocateBuffers((OPUSDecoder_t*)d); },
+     [](void* d, uint8_t* b, int32_t n) -> int32_t { return OPUSFindSyncWord((OPUSDecoder_t*)d, b, n); },
+     [](void* d, uint8_t* b, int32_t* l, int16_t* o) -> int32_t { return OPUSDecode((OPUSDecoder_t*)d, b, l, o); },
+     [](void* d) -> uint32_t { return OPUSGetOutputSamps((OPUSDecoder_t*)d); },
+     [](void* d) -> uint8_t { return OPUSGetChannels((OPUSDecoder_t*)d); }},
+    {"Vorbis", CODEC_VORBIS, []() -> void* { return VORBISDecoder_Create(); },
+     [](void* d) { VORBISDecoder_Destroy((VORBISDecoder_t*)d); },
+     [](void* d) -> bool { return VORBISDecoder_AllocateBuffers((VORBISDecoder_t*)d); },
+     [](void* d, uint8_t* b, int32_t n) -> int32_t { return VORBISFindSyncWord(b, n); },
+     [](void* d, uint8_t* b, int32_t* l, int16_t* o) -> int32_t { return VORBISDecode((VORBISDecoder_t*)d, b, l, o); },
+     [](void* d) -> uint32_t { return VORBISGetOutputSamps((VORBISDecoder_t*)d); },
+     [](void* d) -> uint8_t { return VORBISGetChannels((VORBISDecoder_t*)d); }},
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+static void openStream(const ops_t& ops, stream_t* s) {
+    s->dec = ops.create();
+    CHECK(s->dec && ops.allocate(s->dec));
+    if(ops.codec == CODEC_FLAC) s->pos = flacHeader((FLACDecoder_t*)s->dec, s->data);
+    s->data.resize(s->data.size() + 8); // the bit readers look some bytes ahead
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void step(const ops_t& ops, stream_t* s) {
+    // one decode call, after a sync search if needed, as bench_decode
+    const AudioCodec_t*  codec = AudioCodec_Get(ops.codec);
+    size_t               end = s->data.size() - 8;
+    std::vector<int16_t> out(32768);
+    while(!s->f_done) {
+        if(s->pos >= end) { s->f_done = true; break; }
+        int32_t left = end - s->pos;
+        if(!s->f_sync) {
+            int32_t n = ops.findSync(s->dec, s->data.data() + s->pos, left);
+            if(n < 0) { s->f_done = true; break; }
+            s->pos += n;
+            s->f_sync = true;
+            continue;
+        }
+        int32_t err = ops.decode(s->dec, s->data.data() + s->pos, &left, out.data());
+        int32_t used = (int32_t)(end - s->pos) - left;
+        if(err < 0 || (used == 0 && err == 0)) { s->errors++; s->pos++; s->f_sync = false; return; }
+        s->pos += used;
+        if(codec->parseOggDone && err == codec->parseOggDone) return;
+        uint32_t samps = ops.outputSamps(s->dec);
+        uint32_t n = codec->f_interleavedSamps ? samps : samps * ops.channels(s->dec);
+        s->pcm.insert(s->pcm.end(), out.begin(), out.begin() + n);
+        s->frames++;
+        return;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void compare(const ops_t& ops, const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    stream_t serial[2], inter[2];
+    serial[0].data = inter[0].data = a;
+    serial[1].data = inter[1].data = b;
+    for(stream_t& s : serial) { // one after the other
+        openStream(ops, &s);
+        while(!s.f_done) step(ops, &s);
+        ops.destroy(s.dec);
+    }
+    for(stream_t& s : inter) openStream(ops, &s);
+    while(!inter[0].f_done || !inter[1].f_done) { // a frame of each in turn
+        step(ops, &inter[0]);
+        step(ops, &inter[1]);
+    }
+    for(stream_t& s : inter) ops.destroy(s.dec);
+    printf("%-6s %5u + %5u frames, %u + %u errors, interleaved %s\n", ops.name, serial[0].frames, serial[1].frames,
+           serial[0].errors, serial[1].errors, inter[0].pcm == serial[0].pcm && inter[1].pcm == serial[1].pcm ? "bit-exact" : "DIFFERS");
+    for(int i = 0; i < 2; i++) {
+        CHECK(serial[i].frames > 10);
+        CHECK(inter[i].frames == serial[i].frames);
+        CHECK(inter[i].pcm == serial[i].pcm);
+    }
+    CHECK(serial[0].pcm != serial[1].pcm || ops.codec == CODEC_AAC); // otherwise a shared state could go unseen
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string          dir = corpusDir();
+    std::vector<uint8_t> a, b;
+    for(const ops_t& ops : s_ops) {
+        std::string p = dir + "ctx_" + ops.name, q = p + "2";
+        switch(ops.codec) {
+            case CODEC_FLAC:
+                CHECK(corpusWriteFlac(p, corpusTone(44100, 2, 3.0f)));
+                CHECK(corpusWriteFlac(q, corpusTone(22050, 1, 4.0f), 1152));
+                break;
+            case CODEC_MP3:
+                CHECK(corpusWriteMp3Noise(p, 200, 1));
+                CHECK(corpusWriteMp3Noise(q, 150, 2));
+                break;
+            case CODEC_AAC:
+                CHECK(corpusWriteAacSilence(p, 200));
+                CHECK(corpusWriteAacSilence(q, 150));
+                break;
+            case CODEC_OPUS:
+                CHECK(corpusWriteOpus(p, 400, 312, 1));
+                CHECK(corpusWriteOpus(q, 300, 120, 2));
+                break;
+            case CODEC_VORBIS:
+                CHECK(corpusWriteVorbis(p, 300, 1));
+                CHECK(corpusWriteVorbis(q, 250, 2));
+                break;
+        }
+        CHECK(corpusReadFile(p, &a) && corpusReadFile(q, &b));
+        compare(ops, a, b);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,183 @@
+/*
+ * test_file_reader.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * A slow card (an FSImpl around the host files) reads at 2 MB/s and stalls for 300 ms every 24th read, longer than the
+ * 186 ms the I2S DMA buffers hold. With I2S in real time the stalls must not reach the output: the reader task waits
+ * for the card while Audio::loop() plays from the input buffer. A seek in the middle of a stall must not deliver the
+ * data of the read in flight. The reader task must leave a margin of its stack unused.
+ * On a FAT32 image with the WAV file in runs of a few clusters the reader task reads the sectors of the runs itself; the
+ * sink must hold the file, before and after a seek to a position within a sector.
+ */
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "fat_image.h"
+#include "test_util.h"
+
+static bool s_eof = false;
+void audio_eof_mp3(const char* info) { s_eof = true; }
+
+class SlowCard : public fs::FSImpl {
+
+public:
+    std::atomic<uint32_t> reads{0};
+    std::atomic<bool>     stalling{false};
+    static const uint32_t stallEvery = 24;
+    static const uint32_t stallMs = 300;
+    static const uint32_t bytesPerMs = 2000;
+
+    void read(size_t size) {
+        if(size >= 512 && ++reads % stallEvery == 0) { // card internal garbage collection
+            stalling = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+            stalling = false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(size * 1000 / bytesPerMs));
+    }
+    fs::FileImplPtr open(const char* path, const char* mode, const bool create) override;
+    bool            exists(const char* path) override { return m_host->exists(path); }
+    bool            rename(const char* pathFrom, const char* pathTo) override { return m_host->rename(pathFrom, pathTo); }
+    bool            remove(const char* path) override { return m_host->remove(path); }
+    bool            mkdir(const char* path) override { return m_host->mkdir(path); }
+    bool            rmdir(const char* path) override { return m_host->rmdir(path); }
+
+private:
+    fs::FSImplPtr m_host = fs::hostFSImpl();
+};
+
+class SlowFile : public fs::FileImpl {
+
+public:
+    SlowFile(fs::FileImplPtr f, SlowCard* card) : m_f(f), m_card(card) {}
+    size_t      write(const uint8_t* buf, size_t size) override { return m_f->write(buf, size); }
+    size_t      read(uint8_t* buf, size_t size) override { m_card->read(size); return m_f->read(buf, size); }
+    void        flush() override { m_f->flush(); }
+    bool        seek(uint32_t pos, fs::SeekMode mode) override { return m_f->seek(pos, mode); }
+    size_t      position() const override { return m_f->position(); }
+    size_t      size() const override { return m_f->size(); }
+    void        close() override { m_f->close(); }
+    const char* path() const override { return m_f->path(); }
+    const char* name() const override { return m_f->name(); }
+    bool        isDirectory() override { return m_f->isDirectory(); }
+    operator bool() override { return (bool)*m_f; }
+
+private:
+    fs::FileImplPtr m_f;
+    SlowCard*       m_card;
+};
+
+fs::FileImplPtr SlowCard::open(const char* path, const char* mode, const bool create) {
+    fs::FileImplPtr f = m_host->open(path, mode, create);
+    return f ? std::make_shared<SlowFile>(f, this) : f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    pcm_t       tone = corpusTone(44100, 2, 6.0f); // 1 MB, 5 stalls
+    CHECK(corpusWriteWav(dir + "reader.wav", tone));
+    std::shared_ptr<SlowCard> slow = std::make_shared<SlowCard>();
+    fs::FS                    card(slow);
+
+    Audio* audio = new Audio;
+    audio->setBufsize(-1, 96 * 1024); // 0.5 s of the tone, the whole file would hide the card
+
+    // real time: the DMA runs dry if loop() waits for the card
+    hostI2S_setRealtime(true);
+    hostI2S_t i2s0 = hostI2S_stats();
+    s_eof = false;
+    CHECK(audio->connecttoFS(card, (dir + "reader.wav").c_str()));
+    uint32_t start = millis();
+    while(audio->isRunning() && !s_eof && millis() - start < 20000) audio->loop();
+    audioStats_t* st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    audio->getStats(st);
+    audio->stopSong();
+    printf("reader task: %lu of %u bytes of the stack unused\n", (long unsigned)st->file.readerStackUnused, AUDIO_FILE_READER_STACK);
+    hostI2S_t i2s = hostI2S_stats();
+    printf("%u reads, %u stalls of %u ms; read p50 %lu us, p99 %lu us, max %lu us; %u I2S underruns\n", (unsigned)slow->reads,
+           (unsigned)(slow->reads / SlowCard::stallEvery), (unsigned)SlowCard::stallMs, (long unsigned)st->file.readP50Us,
+           (long unsigned)st->file.readP99Us, (long unsigned)st->file.readMaxUs, (unsigned)(i2s.underruns - i2s0.underruns));
+    CHECK(s_eof);
+    CHECK(slow->reads >= 2 * SlowCard::stallEvery);
+    CHECK(st->file.readMaxUs >= SlowCard::stallMs * 1000); // the stalls happened, in the reader task
+    CHECK(i2s.frames - i2s0.frames == tone.samples.size() / 2);
+    CHECK(i2s.underruns == i2s0.underruns);
+#if !AUDIO_HOST_ASAN
+    CHECK(st->file.readerStackUnused >= 512); // the high-water mark of the reader task, the margin of its stack size
+#endif
+    free(st);
+    hostI2S_setRealtime(false);
+
+    // a seek while the card stalls: after the seek position the sink holds the file from there on
+    uint32_t seekFrame = tone.samples.size() / 2 / 3;
+    pcm_t    out;
+    bool     f_seek = false;
+    CHECK(audio->openPcmSink(SD, (dir + "sink_reader.wav").c_str()));
+    s_eof = false;
+    slow->reads = 0;
+    CHECK(audio->connecttoFS(card, (dir + "reader.wav").c_str()));
+    start = millis();
+    while(audio->isRunning() && !s_eof && millis() - start < 20000) {
+        audio->loop();
+        if(!f_seek && slow->stalling) f_seek = audio->setFilePos(44 + seekFrame * 4);
+    }
+    audio->stopSong();
+    audio->closePcmSink();
+    CHECK(f_seek && s_eof);
+    CHECK(corpusReadWav(dir + "sink_reader.wav", &out));
+    size_t tail = tone.samples.size() - seekFrame * 2; // samples behind the seek position
+    CHECK(out.samples.size() >= tail);
+    if(out.samples.size() >= tail) {
+        size_t head = out.samples.size() - tail;    // played before the seek
+        CHECK(head < seekFrame * 2);                // a jump forward
+        CHECK(std::equal(out.samples.begin(), out.samples.begin() + head, tone.samples.begin()));
+        CHECK(std::equal(out.samples.begin() + head, out.samples.end(), tone.samples.begin() + seekFrame * 2));
+    }
+
+    // the cluster runs of a fragmented file
+    std::vector<fatImageFile_t> files(1);
+    files[0].path = "/music/Fragmented Tone.wav";
+    files[0].maxRun = 4;
+    CHECK(corpusReadFile(dir + "reader.wav", &files[0].data));
+    CHECK(fatImageWrite(dir + "reader.img", files));
+    FatImageCard                fatCard(dir + "reader.img");
+    std::shared_ptr<FatImageFS> image = std::make_shared<FatImageFS>(&fatCard);
+    fs::FS                      fat(image);
+    FileReader::setBlockDevice(FatImageCard::readSectors, &fatCard);
+    seekFrame = tone.samples.size() / 2 * 2 / 3 + 5; // not on a sector
+    f_seek = false;
+    CHECK(audio->openPcmSink(SD, (dir + "sink_runs.wav").c_str()));
+    s_eof = false;
+    CHECK(audio->connecttoFS(fat, files[0].path.c_str()));
+    start = millis();
+    while(audio->isRunning() && !s_eof && millis() - start < 20000) {
+        audio->loop();
+        if(!f_seek && audio->getFilePos() > files[0].data.size() / 3) f_seek = audio->setFilePos(44 + seekFrame * 4);
+    }
+    st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    audio->getStats(st);
+    audio->stopSong();
+    audio->closePcmSink();
+    FileReader::setBlockDevice(NULL, NULL);
+    printf("fragmented file: %lu cluster runs, %u card commands\n", (long unsigned)st->file.readerRuns, (unsigned)fatCard.commands);
+    CHECK(st->file.readerRuns > 50);
+    CHECK(f_seek && s_eof);
+    free(st);
+    CHECK(corpusReadWav(dir + "sink_runs.wav", &out));
+    tail = tone.samples.size() - seekFrame * 2;
+    CHECK(out.samples.size() >= tail);
+    if(out.samples.size() >= tail) {
+        size_t head = out.samples.size() - tail;
+        CHECK(head < seekFrame * 2);
+        CHECK(std::equal(out.samples.begin(), out.samples.begin() + head, tone.samples.begin()));
+        CHECK(std::equal(out.samples.begin() + head, out.samples.end(), tone.samples.begin() + seekFrame * 2));
+    }
+
+    delete audio;
+    return TEST_RESULT();
+}
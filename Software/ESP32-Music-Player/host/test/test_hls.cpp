@@ -0,0 +1,120 @@
+/*
+ * test_hls.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * A live HLS stream from the local server: the master playlist has an AAC LC variant at 32 and at 200 kbit/s and an
+ * HE-AAC v2 one at 48 kbit/s. Audio starts with 32 kbit/s and switches up when the segments come in fast enough. The
+ * HE-AAC v2 variant must never be requested, its CODECS differ. The media playlists slide by one segment every 500 ms
+ * and their segment names carry no number, so only #EXT-X-MEDIA-SEQUENCE tells that the first segments of the new
+ * variant have been queued from the old one: every sequence number must be loaded once, in order. The first segment
+ * too: Audio hands it to the prefetch task and does not ask for it itself.
+ */
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static std::mutex               s_lock;
+static std::vector<std::string> s_requests; // segments and playlists, in the order asked for
+static uint32_t                 s_start = 0;
+static std::vector<uint8_t>     s_segment;
+
+//----------------------------------------------------------------------------------------------------------------------
+static std::string segmentName(uint32_t seq) {
+    // letters only, the media sequence number must not be found in the URL
+    std::string n;
+    do { n += (char)('a' + seq % 26); seq /= 26; } while(seq);
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void respond(int fd, const char* type, const std::string& body) {
+    char head[160];
+    snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", type,
+             body.size());
+    TestHttpServer::sendAll(fd, head, strlen(head));
+    TestHttpServer::sendAll(fd, body.data(), body.size());
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void serve(const std::string& request, int fd) {
+    std::string path = request.substr(5, request.find(' ', 5) - 5);
+    {
+        std::lock_guard<std::mutex> l(s_lock);
+        s_requests.push_back(path);
+    }
+    if(path == "master.m3u8") {
+        respond(fd, "application/vnd.apple.mpegurl",
+                "#EXTM3U\n"
+                "#EXT-X-STREAM-INF:BANDWIDTH=48000,CODECS=\"mp4a.40.29\"\nhe.m3u8\n"
+                "#EXT-X-STREAM-INF:BANDWIDTH=32000,CODECS=\"mp4a.40.2\"\nlo.m3u8\n"
+                "#EXT-X-STREAM-INF:BANDWIDTH=200000,CODECS=\"mp4a.40.2\"\nhi.m3u8\n");
+        return;
+    }
+    if(path.size() > 5 && path.compare(path.size() - 5, 5, ".m3u8") == 0) { // a window of 5 segments
+        uint32_t    base = (millis() - s_start) / 500;
+        std::string variant = path.substr(0, path.size() - 5);
+        std::string pl = "#EXTM3U\n#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:" + std::to_string(base) + "\n";
+        for(uint32_t k = 0; k < 5; k++) pl += "#EXTINF:1.0,\n" + variant + "/" + segmentName(base + k) + ".aac\n";
+        respond(fd, "application/vnd.apple.mpegurl", pl);
+        return;
+    }
+    char head[160]; // a segment in two halves, the download takes long enough to be measured
+    snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: audio/aac\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+             s_segment.size());
+    TestHttpServer::sendAll(fd, head, strlen(head));
+    TestHttpServer::sendAll(fd, s_segment.data(), s_segment.size() / 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    TestHttpServer::sendAll(fd, s_segment.data() + s_segment.size() / 2, s_segment.size() - s_segment.size() / 2);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t sequenceOf(const std::string& segment) {
+    // "lo/cb.aac" -> 'b' * 26 + 'c'
+    size_t   slash = segment.find('/'), dot = segment.rfind('.');
+    uint32_t seq = 0;
+    for(size_t i = dot; i > slash + 1; i--) seq = seq * 26 + (segment[i - 1] - 'a');
+    return seq;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    CHECK(corpusWriteAacSilence(dir + "hls.aac", 400)); // 5200 bytes, enough for a throughput measurement
+    FILE* f = fopen((dir + "hls.aac").c_str(), "rb");
+    s_segment.resize(5200);
+    CHECK(f && fread(s_segment.data(), 1, s_segment.size(), f) == s_segment.size());
+    if(f) fclose(f);
+
+    TestHttpServer server(serve);
+    Audio*         audio = new Audio;
+    s_start = millis();
+    CHECK(audio->connecttohost(server.url("master.m3u8").c_str()));
+    uint32_t hi = 0;
+    while(millis() - s_start < 15000 && hi < 4) {
+        audio->loop();
+        std::lock_guard<std::mutex> l(s_lock);
+        hi = 0;
+        for(const std::string& r : s_requests) hi += r.compare(0, 3, "hi/") == 0;
+    }
+    audioStats_t* st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    audio->getStats(st);
+    audio->stopSong();
+
+    std::vector<std::string> segments;
+    for(const std::string& r : s_requests) {
+        CHECK(r.compare(0, 2, "he") != 0); // the HE-AAC v2 variant
+        if(r.size() > 4 && r.compare(r.size() - 4, 4, ".aac") == 0) segments.push_back(r);
+    }
+    for(const std::string& s : segments) printf("%s(%u) ", s.c_str(), sequenceOf(s));
+    printf("\n%u variant switches\n", st->hls.switches);
+    CHECK(st->hls.switches >= 1);
+    CHECK(hi >= 4);
+    CHECK(segments.size() > 4 && segments[0].compare(0, 3, "lo/") == 0);
+    if(segments.size()) CHECK(std::count(segments.begin(), segments.end(), segments[0]) == 1);
+    for(size_t i = 1; i < segments.size(); i++) CHECK(sequenceOf(segments[i]) == sequenceOf(segments[i - 1]) + 1);
+    free(st);
+    delete audio;
+    return TEST_RESULT();
+}
@@ -0,0 +1,220 @@
+/*
+ * test_http_parser.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * HttpParser gets a response in blocks of random size, as the socket delivers it: the header lines, the bytes behind
+ * the header (rxRead()) and the unframed chunked ICY body must not depend on where the blocks end. Random bytes must
+ * not take the parser out of its buffers (build with -DAUDIO_HOST_ASAN=ON), a chunk size of more than 8 hex digits is
+ * an error. Through Audio a chunked playlist whose chunk size line comes late must not hold up loop().
+ */
+#include <chrono>
+#include <random>
+#include <thread>
+#include "Audio.h"
+#include "http_parser.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static bool s_eof = false;
+void audio_eof_mp3(const char* info) { s_eof = true; }
+void audio_eof_stream(const char* info) { s_eof = true; }
+
+typedef struct {
+    std::vector<std::string> lines;  // the header
+    std::vector<uint8_t>     audio;  // the body without framing
+    std::vector<std::string> titles; // the ICY metadata
+} response_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static std::string chunked(const std::string& body, std::mt19937& rng) {
+    std::string out;
+    for(size_t pos = 0; pos < body.size();) {
+        size_t n = std::min(body.size() - pos, (size_t)(1 + rng() % 3000));
+        char   len[16];
+        snprintf(len, sizeof(len), rng() % 2 ? "%zx\r\n" : "%zX;ext=1\r\n", n);
+        out += len + body.substr(pos, n) + "\r\n";
+        pos += n;
+    }
+    return out + "0\r\n\r\n";
+}
+//----------------------------------------------------------------------------------------------------------------------
+static std::string icy(const std::vector<uint8_t>& audio, uint32_t metaint, std::vector<std::string>* titles) {
+    std::string out;
+    for(size_t pos = 0; pos < audio.size(); pos += metaint) {
+        out.append((const char*)audio.data() + pos, std::min((size_t)metaint, audio.size() - pos));
+        if(pos + metaint > audio.size()) break;
+        std::string meta;
+        if(titles->size() % 2 == 0) meta = "StreamTitle='title " + std::to_string(titles->size()) + "';";
+        if(!meta.empty()) titles->push_back(meta);
+        size_t blocks = (meta.size() + 15) / 16;
+        meta.resize(blocks * 16, '\0');
+        out += (char)blocks + meta;
+    }
+    return out;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static response_t parse(const std::string& response, std::mt19937& rng, bool f_chunked, uint32_t metaint) {
+    // block reads of 1..700 bytes, the header line by line, then the body as Audio::processWebStream() takes it
+    response_t  r;
+    HttpParser* parser = new HttpParser;
+    size_t      pos = 0;
+    parser->reset();
+    while(true) {
+        if(parser->nextLine()) {
+            if(!parser->line()[0]) break;
+            r.lines.push_back(parser->line());
+            continue;
+        }
+        if(pos == response.size()) break;
+        size_t   space;
+        uint8_t* rx = parser->rxSpace(&space);
+        size_t   n = std::min(std::min(space, (size_t)(1 + rng() % 700)), response.size() - pos);
+        memcpy(rx, response.data() + pos, n);
+        parser->rxWritten(n);
+        pos += n;
+    }
+    CHECK(parser->setBody(f_chunked, metaint));
+    std::vector<uint8_t> block(700);
+    while(true) {
+        size_t n = 1 + rng() % block.size();
+        if(parser->rxAvailable()) n = parser->rxRead(block.data(), n);
+        else {
+            n = std::min(n, response.size() - pos);
+            memcpy(block.data(), response.data() + pos, n);
+            pos += n;
+        }
+        if(!n) break;
+        for(size_t used, at = 0; at < n; at += used) {
+            uint8_t out[700];
+            size_t  a = parser->unframe(block.data() + at, n - at, out, &used);
+            r.audio.insert(r.audio.end(), out, out + a);
+            if(parser->metadataReady()) r.titles.push_back(parser->metadata());
+            if(!used) break;
+        }
+    }
+    CHECK(!parser->error());
+    CHECK(!f_chunked || parser->endOfBody());
+    delete parser;
+    return r;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void fuzz(std::mt19937& rng) {
+    // bytes from an alphabet rich in framing characters, random splits; the line is cut, nothing is written outside
+    static const char alphabet[] = "0123456789abcdefABCDEF;\r\n\r\n: \t\x01\xff";
+    HttpParser*       parser = new HttpParser;
+    for(int run = 0; run < 2000; run++) {
+        std::vector<uint8_t> d(rng() % 4000);
+        for(uint8_t& b : d) b = rng() % 4 ? alphabet[rng() % (sizeof(alphabet) - 1)] : rng();
+        parser->reset();
+        size_t pos = 0;
+        while(pos < d.size()) {
+            size_t   space;
+            uint8_t* rx = parser->rxSpace(&space);
+            size_t   n = std::min(std::min(space, (size_t)(1 + rng() % 600)), d.size() - pos);
+            memcpy(rx, d.data() + pos, n);
+            parser->rxWritten(n);
+            pos += n;
+            while(parser->nextLine()) {
+                CHECK(strlen(parser->line()) < HTTP_LINE_SIZE);
+                CHECK(parser->lineBytes() >= 1);
+                uint32_t size;
+                if(HttpParser::chunkSize(parser->line(), &size)) CHECK(strspn(parser->line(), "0123456789abcdefABCDEF") <= 8);
+            }
+            CHECK(parser->rxAvailable() == 0);
+        }
+        parser->setBody(true, 1 + rng() % 64);
+        std::vector<uint8_t> out(d.size());
+        for(size_t used, at = 0; at < d.size(); at += used) {
+            size_t n = std::min(d.size() - at, (size_t)(1 + rng() % 600));
+            CHECK(parser->unframe(d.data() + at, n, out.data(), &used) <= used);
+            if(parser->metadataReady()) CHECK(strlen(parser->metadata()) < HTTP_META_SIZE);
+            if(!used) break;
+        }
+    }
+    delete parser;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void chunkSizes() {
+    uint32_t size = 0;
+    CHECK(HttpParser::chunkSize("1f40", &size) && size == 0x1f40);
+    CHECK(HttpParser::chunkSize("1F40 ; name=value", &size) && size == 0x1f40);
+    CHECK(HttpParser::chunkSize("ffffffff", &size) && size == 0xffffffff);
+    CHECK(HttpParser::chunkSize("0", &size) && size == 0);
+    CHECK(!HttpParser::chunkSize("", &size));
+    CHECK(!HttpParser::chunkSize("123456789", &size)); // more than 32 bit
+    CHECK(!HttpParser::chunkSize("12x", &size));
+    HttpParser* parser = new HttpParser;
+    const char* over = "00000001234\r\nabcd\r\n0\r\n\r\n"; // leading zeros are digits too
+    uint8_t     out[64];
+    size_t      used;
+    parser->setBody(true, 0);
+    parser->unframe((const uint8_t*)over, strlen(over), out, &used);
+    CHECK(parser->error());
+    delete parser;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void playlist(Audio& audio, const std::string& dir) {
+    // the chunk size line of the playlist is split and its second half comes 300 ms later, loop() goes on meanwhile
+    chdir(dir.c_str());
+    TestHttpServer* server = NULL;
+    server = new TestHttpServer([&server](const std::string& request, int fd) {
+        if(request.find("GET /list.m3u ") != 0) return TestHttpServer::serveFile(request, fd);
+        std::string body = "#EXTM3U\r\n" + server->url("silence.mp3") + "\r\n";
+        char        head[160], len[16];
+        snprintf(len, sizeof(len), "%zx", body.size());
+        snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: audio/x-mpegurl\r\nTransfer-Encoding: chunked\r\n\r\n%c", len[0]);
+        TestHttpServer::sendAll(fd, head, strlen(head));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        std::string rest = std::string(len + 1) + "\r\n" + body + "\r\n0\r\n\r\n";
+        TestHttpServer::sendAll(fd, rest.data(), rest.size());
+    });
+    CHECK(audio.openPcmSink(SD, "sink_list.wav"));
+    s_eof = false;
+    CHECK(audio.connecttohost(server->url("list.m3u").c_str()));
+    uint32_t start = millis(), longest = 0;
+    while(audio.isRunning() || millis() - start < 1000) {
+        uint32_t t = millis();
+        audio.loop();
+        longest = std::max(longest, (uint32_t)(millis() - t));
+        if(s_eof || millis() - start > 20000) break;
+    }
+    audio.stopSong();
+    audio.closePcmSink();
+    pcm_t out;
+    printf("chunked playlist: longest loop() %lu ms\n", (long unsigned)longest);
+    CHECK(s_eof);
+    CHECK(longest < 150);
+    CHECK(corpusReadWav("sink_list.wav", &out) && out.samples.size() >= 90 * 1152 * 2);
+    delete server;
+    chdir("..");
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::mt19937 rng(1);
+    chunkSizes();
+
+    std::vector<uint8_t> audioData(100000);
+    for(uint8_t& b : audioData) b = rng();
+    for(uint32_t seed = 1; seed <= 20; seed++) {
+        std::mt19937             split(seed);
+        std::vector<std::string> titles;
+        std::string              body = icy(audioData, 8192, &titles);
+        std::string head = "HTTP/1.1 200 OK\r\nContent-Type: audio/mpeg\r\nicy-metaint:8192\r\nX-Long: " + std::string(1000, 'x') + "\r\n";
+        head += seed % 2 ? "Transfer-Encoding: chunked\r\n\r\n" : "\r\n";
+        response_t r = parse(head + (seed % 2 ? chunked(body, split) : body), split, seed % 2, 8192);
+        CHECK(r.lines.size() == 4 + seed % 2);
+        CHECK(r.lines.size() > 3 && r.lines[2] == "icy-metaint:8192" && r.lines[3].size() == HTTP_LINE_SIZE - 1);
+        CHECK(r.audio == audioData);
+        CHECK(r.titles == titles);
+    }
+    fuzz(rng);
+
+    std::string dir = corpusDir();
+    CHECK(corpusWriteMp3Silence(dir + "silence.mp3", 100));
+    Audio* audio = new Audio;
+    playlist(*audio, dir);
+    delete audio;
+    return TEST_RESULT();
+}
@@ -0,0 +1,111 @@
+/*
+ * test_net_reader.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * The net reader task and its jitter buffer on a local web radio stream of 128 kbit/s MP3, sent at its bit rate by
+ * TestHttpServer::throttledStream() with a burst of 2 s at the start, as Icecast does; I2S takes the samples in real
+ * time.
+ * Four stalls of 350 ms, one every 1.5 s, the data comes late but complete: the buffer covers them, its depth while playing
+ * never falls below a frame, no underrun of the stream nor of I2S, the target depth adapts to the stall and the
+ * measured rate approaches the pace of the server.
+ * A stall of 3 s, longer than the buffer: one underrun is counted, the stream waits for the target depth and plays on
+ * over the same connection.
+ */
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+#define RATE  16000    // bytes/s of 128 kbit/s
+#define BURST (2 * RATE)
+
+typedef struct {
+    uint32_t minDepth = UINT32_MAX; // while playing
+    uint32_t maxTarget = 0;
+    uint64_t frames = 0;            // I2S, behind the stall
+} watch_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static void run(Audio* audio, uint32_t ms, uint32_t afterMs, audioStats_t* st, watch_t* w) {
+    // loop() for ms, the net stats every 50 ms; I2S frames from afterMs on
+    uint32_t start = millis(), next = start;
+    uint64_t frames0 = 0, playing = hostI2S_stats().frames;
+    bool     after = false;
+    while(millis() - start < ms && audio->isRunning()) {
+        audio->loop();
+        if(millis() < next) continue;
+        next += 50;
+        audio->getStats(st);
+        if(hostI2S_stats().frames > playing + 44100) w->minDepth = std::min(w->minDepth, st->net.depth); // after 1 s
+        w->maxTarget = std::max(w->maxTarget, st->net.target);
+        if(!after && millis() - start >= afterMs) { after = true; frames0 = hostI2S_stats().frames; }
+    }
+    w->frames = hostI2S_stats().frames - frames0;
+    audio->getStats(st);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    CHECK(corpusWriteMp3Silence(dir + "radio.mp3", 400));
+    chdir(dir.c_str());
+
+    Audio*        audio = new Audio;
+    audioStats_t* st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    hostI2S_setRealtime(true);
+
+    // short stalls: covered
+    {
+        TestHttpServer::throttle_t t;
+        t.bytesPerSec = RATE;
+        t.burst = BURST;
+        t.seconds = 12;
+        for(uint32_t ms = 2000; ms < 7000; ms += 1500) t.stalls.push_back({ms, 350});
+        TestHttpServer server(TestHttpServer::throttledStream("radio.mp3", t));
+        watch_t        w;
+        hostI2S_t      i2s0 = hostI2S_stats();
+        CHECK(audio->connecttohost(server.url("radio.mp3").c_str()));
+        run(audio, 9500, 1000, st, &w);
+        hostI2S_t i2s = hostI2S_stats();
+        printf("stalls of 350 ms: depth min %lu, target max %lu, now %lu; rate %lu B/s; underruns %lu, I2S %u; reconnects %lu\n",
+               (long unsigned)w.minDepth, (long unsigned)w.maxTarget, (long unsigned)st->net.target, (long unsigned)st->net.rate,
+               (long unsigned)st->net.underruns, (unsigned)(i2s.underruns - i2s0.underruns), (long unsigned)st->net.reconnects);
+        CHECK(audio->isRunning());
+        CHECK(st->net.readerActive);
+        CHECK(w.minDepth > 418 && w.minDepth < UINT32_MAX);        // a frame
+        CHECK(st->net.underruns == 0);
+        CHECK(i2s.underruns == i2s0.underruns);
+        CHECK(st->net.reconnects == 0);
+        CHECK(w.maxTarget >= RATE * 350 / 1000);                     // the stall is covered by the target
+        CHECK(st->net.rate > RATE * 3 / 4 && st->net.rate < RATE * 3 / 2); // the burst fades from the running mean
+        CHECK(w.frames > 44100 * 7);                                 // 8.5 s of real time
+        audio->stopSong();
+    }
+
+    // a long stall: one underrun, then the stream plays on
+    {
+        TestHttpServer::throttle_t t;
+        t.bytesPerSec = RATE;
+        t.burst = BURST;
+        t.seconds = 12;
+        t.stalls.push_back({2000, 3000});
+        TestHttpServer server(TestHttpServer::throttledStream("radio.mp3", t));
+        watch_t        w;
+        CHECK(audio->connecttohost(server.url("radio.mp3").c_str()));
+        run(audio, 9000, 6000, st, &w);
+        printf("stall of 3000 ms: underruns %lu, reconnects %lu, %llu frames in the last 3 s\n", (long unsigned)st->net.underruns,
+               (long unsigned)st->net.reconnects, (long long unsigned)w.frames);
+        CHECK(audio->isRunning());
+        CHECK(st->net.underruns == 1);
+        CHECK(st->net.reconnects == 0);
+        CHECK(server.connections() == 1);
+        CHECK(w.frames > 44100 * 2);                                 // plays on after the stall
+        audio->stopSong();
+    }
+
+    hostI2S_setRealtime(false);
+    free(st);
+    delete audio;
+    chdir("..");
+    return TEST_RESULT();
+}
@@ -0,0 +1,291 @@
+/*
+ * test_play.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Audio plays local files and a local HTTP URL; the PCM sink holds exactly the samples of the lossless sources, the
+ * silent MP3 and AAC frames come out as silence, and a change of the format continues the sink in a second file.
+ * WAV of 24/32 bit PCM and float, also as WAVE_FORMAT_EXTENSIBLE, gives the 16 bit source; at full volume I2S gets it
+ * unchanged.
+ * Cover art of 1.5 MB in an ID3v2.3 tag and in a FLAC PICTURE block is seeked over: the time from connect to the first
+ * samples in the PCM sink stays that of the file without it, getCoverArt() points to the picture.
+ * The duration of Ogg Opus comes from the last granule position without the pre-skip, pages of another stream or with
+ * a wrong CRC behind it do not count.
+ */
+#include <algorithm>
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static bool s_eof = false;
+void audio_eof_mp3(const char* info) { s_eof = true; }
+void audio_eof_stream(const char* info) { s_eof = true; }
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool play(Audio& audio, const std::string& in, uint32_t timeoutMs = 20000) {
+    s_eof = false;
+    bool ok = in.find("://") != std::string::npos ? audio.connecttohost(in.c_str()) : audio.connecttoFS(SD, in.c_str());
+    if(!ok) return false;
+    uint32_t start = millis();
+    while(audio.isRunning() && !s_eof && millis() - start < timeoutMs) audio.loop();
+    audio.stopSong();
+    return s_eof;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool samePcm(const pcm_t& a, const pcm_t& b) {
+    return a.sampleRate == b.sampleRate && a.channels == b.channels && a.samples == b.samples;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool silent(const pcm_t& p, size_t minSamples) {
+    if(p.samples.size() < minSamples) return false;
+    for(int16_t s : p.samples) if(s) return false;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint64_t lastGranule(const std::vector<uint8_t>& d) { // of the last page, the test file has no "OggS" in packets
+    for(size_t i = d.size() - 27; i > 0; i--) {
+        if(memcmp(&d[i], "OggS", 4)) continue;
+        uint64_t g = 0;
+        for(int j = 7; j >= 0; j--) g = (g << 8) | d[i + 6 + j];
+        return g;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void appendPage(std::vector<uint8_t>* d, uint32_t serial, uint64_t granule, bool badCrc) {
+    std::vector<uint8_t> p = {'O', 'g', 'g', 'S', 0, 4};
+    for(int i = 0; i < 8; i++) p.push_back(granule >> (8 * i));
+    for(int i = 0; i < 4; i++) p.push_back(serial >> (8 * i));
+    for(int i = 0; i < 8; i++) p.push_back(0);  // sequence, CRC
+    p.push_back(1);
+    p.push_back(16);
+    for(int i = 0; i < 16; i++) p.push_back(i * 7);
+    uint32_t crc = corpusOggCrc(p.data(), p.size()) ^ (badCrc ? 1 : 0);
+    for(int i = 0; i < 4; i++) p[22 + i] = crc >> (8 * i);
+    d->insert(d->end(), p.begin(), p.end());
+}
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> picture(size_t size) {
+    std::vector<uint8_t> pic(size);
+    for(size_t i = 0; i < size; i++) pic[i] = i * 2654435761UL >> 24;
+    return pic;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> id3Tag(const std::vector<uint8_t>& pic) { // ID3v2.3: TIT2, APIC, padding
+    std::vector<uint8_t> f;
+    auto frame = [&](const char* id, const std::vector<uint8_t>& body) {
+        f.insert(f.end(), id, id + 4);
+        for(int i = 3; i >= 0; i--) f.push_back(body.size() >> (8 * i));
+        f.push_back(0);
+        f.push_back(0);
+        f.insert(f.end(), body.begin(), body.end());
+    };
+    std::string title = std::string(1, '\0') + "Heavy Artwork";
+    frame("TIT2", std::vector<uint8_t>(title.begin(), title.end()));
+    std::string mime = std::string(1, '\0') + "image/jpeg" + std::string(1, '\0') + "\x03" + std::string(1, '\0');
+    std::vector<uint8_t> apic(mime.begin(), mime.end());
+    apic.insert(apic.end(), pic.begin(), pic.end());
+    frame("APIC", apic);
+    f.resize(f.size() + 4096); // padding
+    std::vector<uint8_t> t = {'I', 'D', '3', 3, 0, 0};
+    for(int i = 3; i >= 0; i--) t.push_back((f.size() >> (7 * i)) & 0x7F); // syncsafe
+    t.insert(t.end(), f.begin(), f.end());
+    return t;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> flacPicture(const std::vector<uint8_t>& flac, const std::vector<uint8_t>& pic) {
+    // a PICTURE block behind STREAMINFO, which takes over its last block flag
+    std::vector<uint8_t> b;
+    auto be32 = [&](uint32_t v) { for(int i = 3; i >= 0; i--) b.push_back(v >> (8 * i)); };
+    be32(3);                                   // front cover
+    be32(10);
+    b.insert(b.end(), {'i', 'm', 'a', 'g', 'e', '/', 'j', 'p', 'e', 'g'});
+    be32(0);                                   // description
+    be32(600); be32(600); be32(24); be32(0);   // width, height, depth, colors
+    be32(pic.size());
+    b.insert(b.end(), pic.begin(), pic.end());
+    std::vector<uint8_t> hdr = {(uint8_t)(6 | (flac[4] & 0x80)), (uint8_t)(b.size() >> 16), (uint8_t)(b.size() >> 8), (uint8_t)b.size()};
+    std::vector<uint8_t> out(flac.begin(), flac.begin() + 42); // "fLaC", STREAMINFO
+    out[4] &= 0x7F;
+    out.insert(out.end(), hdr.begin(), hdr.end());
+    out.insert(out.end(), b.begin(), b.end());
+    out.insert(out.end(), flac.begin() + 42, flac.end());
+    return out;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t firstAudio(Audio& audio, const std::string& path, const std::string& sink, pcm_t* out) {
+    // connect to the first samples in the PCM sink, in ms
+    audioStats_t* st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    CHECK(audio.openPcmSink(SD, sink.c_str()));
+    CHECK(play(audio, path));
+    audio.closePcmSink();
+    CHECK(corpusReadWav(sink, out));
+    audio.getStats(st);
+    uint32_t ms = st->file.firstAudioMs;
+    free(st);
+    return ms;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool coverArtIn(Audio& audio, const std::vector<uint8_t>& file, const std::vector<uint8_t>& pic) {
+    // getCoverArt() of the last file covers the picture data and little more (frame or block fields)
+    uint32_t pos = 0, len = 0;
+    if(!audio.getCoverArt(&pos, &len)) return false;
+    if(pos + len > file.size() || len < pic.size() || len > pic.size() + 64) return false;
+    return std::search(file.begin() + pos, file.begin() + pos + len, pic.begin(), pic.end()) != file.begin() + pos + len;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t opusDuration(Audio& audio, const std::string& path) {
+    if(!audio.connecttoFS(SD, path.c_str())) return 0;
+    uint32_t start = millis();
+    while(audio.isRunning() && !audio.getAudioFileDuration() && millis() - start < 5000) audio.loop();
+    uint32_t sec = audio.getAudioFileDuration();
+    audio.stopSong();
+    return sec;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    pcm_t       tone44 = corpusTone(44100, 2, 2.0f);
+    pcm_t       tone48 = corpusTone(48000, 1, 1.0f);
+    CHECK(corpusWriteWav(dir + "tone44.wav", tone44));
+    CHECK(corpusWriteWav(dir + "tone48m.wav", tone48));
+    CHECK(corpusWriteFlac(dir + "tone44.flac", tone44));
+    CHECK(corpusWriteMp3Silence(dir + "silence.mp3", 100));
+    CHECK(corpusWriteAacSilence(dir + "silence.aac", 100));
+
+    Audio* audio = new Audio;
+    pcm_t  out;
+
+    // lossless: the sink holds the source
+    for(const char* name : {"tone44.wav", "tone44.flac"}) {
+        std::string sink = dir + "sink_" + name + ".wav";
+        CHECK(audio->openPcmSink(SD, sink.c_str()));
+        CHECK(play(*audio, dir + name));
+        audio->closePcmSink();
+        CHECK(corpusReadWav(sink, &out));
+        CHECK(samePcm(out, tone44));
+    }
+
+    // 24/32 bit PCM and 32/64 bit float, plain and as WAVE_FORMAT_EXTENSIBLE: wavToPCM16() keeps the upper 16 bits
+    struct { uint16_t format, bits; bool extensible; } wavFormats[] = {
+        {1, 24, false}, {1, 32, false}, {3, 32, false}, {3, 64, false}, {1, 24, true}, {1, 32, true}, {3, 32, true}, {3, 64, true}};
+    for(const auto& f : wavFormats) {
+        std::string name = dir + "tone44_" + (f.format == 3 ? "f" : "i") + std::to_string(f.bits) + (f.extensible ? "x" : "") + ".wav";
+        CHECK(corpusWriteWavFormat(name, tone44, f.format, f.bits, f.extensible));
+        CHECK(audio->openPcmSink(SD, (dir + "sink_format.wav").c_str()));
+        CHECK(play(*audio, name));
+        audio->closePcmSink();
+        CHECK(corpusReadWav(dir + "sink_format.wav", &out));
+        CHECK(samePcm(out, tone44));
+    }
+
+    // silence, 1152 and 1024 samples per frame, the first frames may go to the decoder delay
+    CHECK(audio->openPcmSink(SD, (dir + "sink_silence.mp3.wav").c_str()));
+    CHECK(play(*audio, dir + "silence.mp3"));
+    audio->closePcmSink();
+    CHECK(corpusReadWav(dir + "sink_silence.mp3.wav", &out));
+    CHECK(silent(out, 90 * 1152 * 2));
+    CHECK(audio->openPcmSink(SD, (dir + "sink_silence.aac.wav").c_str()));
+    CHECK(play(*audio, dir + "silence.aac"));
+    audio->closePcmSink();
+    CHECK(corpusReadWav(dir + "sink_silence.aac.wav", &out));
+    CHECK(silent(out, 90 * 1024 * 2));
+
+    // HTTP with Content-Length
+    {
+        chdir(dir.c_str());
+        TestHttpServer server;
+        CHECK(audio->openPcmSink(SD, "sink_http.wav"));
+        CHECK(play(*audio, server.url("tone44.flac")));
+        audio->closePcmSink();
+        CHECK(corpusReadWav("sink_http.wav", &out));
+        CHECK(samePcm(out, tone44));
+        chdir("..");
+    }
+
+    // a new format continues in the next part of the sink, I2S gets all samples
+    hostI2S_setOutput((dir + "i2s.wav").c_str());
+    remove((dir + "sink_parts-2.wav").c_str());
+    CHECK(audio->openPcmSink(SD, (dir + "sink_parts.wav").c_str(), false));
+    CHECK(play(*audio, dir + "tone44.wav"));
+    CHECK(play(*audio, dir + "tone48m.wav"));
+    audio->closePcmSink();
+    CHECK(corpusReadWav(dir + "sink_parts.wav", &out));
+    CHECK(samePcm(out, tone44));
+    CHECK(corpusReadWav(dir + "sink_parts-2.wav", &out));
+    CHECK(samePcm(out, tone48));
+    hostI2S_t i2s = hostI2S_stats();
+    CHECK(i2s.files == 2);
+    CHECK(i2s.frames == tone44.samples.size() / 2 + tone48.samples.size());
+
+    // I2S: the block write of passthroughPossible() at the highest volume step of both curves gives the source, a
+    // lower step goes through Gain(); 10 steps on the logarithmic curve end at 1 only within rounding
+    const uint8_t steps[3] = {21, 10, 21}, vol[3] = {21, 10, 20}, curve[3] = {0, 1, 0};
+    for(int i = 0; i < 3; i++) {
+        pcm_t i2s;
+        audio->setVolumeSteps(steps[i]);
+        audio->setVolume(vol[i], curve[i]);
+        hostI2S_setOutput((dir + "i2s_volume.wav").c_str());
+        CHECK(play(*audio, dir + "tone44.wav"));
+        hostI2S_close();
+        CHECK(corpusReadWav(dir + "i2s_volume.wav", &i2s));
+        CHECK(i2s.samples.size() == tone44.samples.size());
+        CHECK(samePcm(i2s, tone44) == (i < 2));
+    }
+    hostI2S_setOutput(NULL);
+    audio->setVolumeSteps(21);
+    audio->setVolume(21);
+
+    // time to first audio with 1.5 MB cover art: the picture is one seek, not 1.5 MB through the input buffer
+    {
+        std::vector<uint8_t> pic = picture(1536 * 1024), mp3, flac, art;
+        pcm_t                plainOut, artOut;
+        CHECK(corpusReadFile(dir + "silence.mp3", &mp3));
+        art = id3Tag(pic);
+        art.insert(art.end(), mp3.begin(), mp3.end());
+        CHECK(corpusWriteFile(dir + "artwork.mp3", art));
+        uint32_t plainMs = firstAudio(*audio, dir + "silence.mp3", dir + "sink_plain.wav", &plainOut);
+        uint32_t artMs = firstAudio(*audio, dir + "artwork.mp3", dir + "sink_artwork.wav", &artOut);
+        printf("MP3: first audio after %lu ms, with %lu KB ID3 artwork after %lu ms\n", (long unsigned)plainMs,
+               (long unsigned)pic.size() / 1024, (long unsigned)artMs);
+        CHECK(coverArtIn(*audio, art, pic));
+        CHECK(artMs <= plainMs + 20);
+        CHECK(artOut.samples == plainOut.samples);
+
+        CHECK(corpusReadFile(dir + "tone44.flac", &flac));
+        art = flacPicture(flac, pic);
+        CHECK(corpusWriteFile(dir + "artwork.flac", art));
+        plainMs = firstAudio(*audio, dir + "tone44.flac", dir + "sink_plain.wav", &plainOut);
+        artMs = firstAudio(*audio, dir + "artwork.flac", dir + "sink_artwork.wav", &artOut);
+        printf("FLAC: first audio after %lu ms, with %lu KB PICTURE after %lu ms\n", (long unsigned)plainMs,
+               (long unsigned)pic.size() / 1024, (long unsigned)artMs);
+        CHECK(coverArtIn(*audio, art, pic));
+        CHECK(artMs <= plainMs + 20);
+        CHECK(samePcm(artOut, tone44));
+    }
+
+    // Opus duration: a pre-skip that moves it below the next full second, rounded it must not count
+    {
+        std::vector<uint8_t> d;
+        CHECK(corpusWriteOpus(dir + "duration.opus", 600, 0));
+        CHECK(corpusReadFile(dir + "duration.opus", &d));
+        uint64_t g = lastGranule(d);
+        uint32_t f = g % 48000, sec = g / 48000;
+        uint16_t preSkip = f >= 24000 ? f - 23000 : f + 25000; // g - preSkip ends 23000 samples into a second
+        uint32_t expected = f >= 24000 ? sec : sec - 1;        // g alone rounds to one second more
+        CHECK(corpusWriteOpus(dir + "duration.opus", 600, preSkip));
+        CHECK(corpusReadFile(dir + "duration.opus", &d));
+        CHECK(lastGranule(d) == g);
+        appendPage(&d, 2, g * 2, false);                       // a chained stream
+        appendPage(&d, 1, g * 3, true);                        // "OggS" in the data
+        CHECK(corpusWriteFile(dir + "duration.opus", d));
+        uint32_t seconds = opusDuration(*audio, dir + "duration.opus");
+        printf("Opus: %llu samples, pre-skip %u, duration %lu s\n", (long long unsigned)g, preSkip, (long unsigned)seconds);
+        CHECK(seconds == expected);
+    }
+
+    delete audio;
+    hostI2S_close();
+    return TEST_RESULT();
+}
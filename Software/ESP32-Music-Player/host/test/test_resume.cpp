@@ -0,0 +1,139 @@
+/*
+ * test_resume.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Resume cost: FLAC, MP3 and AAC files are played and moved to six positions with setFilePos(), none on a frame.
+ * Each resume (Audio::codec_correctResumeFilePos(), scanForFrame()) must find the next frame in blocks of
+ * AUDIO_RESUME_SCAN_BLOCK: at most three blocks and one read call of the file per block. The card charges each read
+ * call 200 µs (VFS, FatFs and the SDMMC command) plus 50 µs per KB, the scan must take less than 20 ms; read byte by
+ * byte, 8 KB would take 1.6 s. Each resume waits for "stream ready", the buffer is filled again after a resume. The file
+ * must then play to its end without a decode error.
+ */
+#include <atomic>
+#include <chrono>
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static bool s_eof = false;
+static bool s_ready = false;
+void audio_eof_mp3(const char* info) { s_eof = true; }
+void audio_info(const char* info) { if(!strcmp(info, "stream ready")) s_ready = true; }
+
+class CountingCard : public fs::FSImpl {
+
+public:
+    static const uint32_t callUs = 200;
+    static const uint32_t kbUs = 50;
+
+    std::atomic<uint32_t> calls{0};      // of the first handle, audiofile; the file reader task opens the second
+    std::atomic<uint32_t> bytes{0};
+    std::atomic<int>      handles{0};
+
+    void read(int handle, size_t size) {
+        auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(callUs + size * kbUs / 1024);
+        if(handle == 0) { calls++; bytes += size; }
+        while(std::chrono::steady_clock::now() < end) {}
+    }
+    fs::FileImplPtr open(const char* path, const char* mode, const bool create) override;
+    bool            exists(const char* path) override { return m_host->exists(path); }
+    bool            rename(const char* pathFrom, const char* pathTo) override { return m_host->rename(pathFrom, pathTo); }
+    bool            remove(const char* path) override { return m_host->remove(path); }
+    bool            mkdir(const char* path) override { return m_host->mkdir(path); }
+    bool            rmdir(const char* path) override { return m_host->rmdir(path); }
+
+private:
+    fs::FSImplPtr m_host = fs::hostFSImpl();
+};
+
+class CountingFile : public fs::FileImpl {
+
+public:
+    CountingFile(fs::FileImplPtr f, CountingCard* card, int handle) : m_f(f), m_card(card), m_handle(handle) {}
+    size_t      write(const uint8_t* buf, size_t size) override { return m_f->write(buf, size); }
+    size_t      read(uint8_t* buf, size_t size) override { m_card->read(m_handle, size); return m_f->read(buf, size); }
+    void        flush() override { m_f->flush(); }
+    bool        seek(uint32_t pos, fs::SeekMode mode) override { return m_f->seek(pos, mode); }
+    size_t      position() const override { return m_f->position(); }
+    size_t      size() const override { return m_f->size(); }
+    void        close() override { m_f->close(); }
+    const char* path() const override { return m_f->path(); }
+    const char* name() const override { return m_f->name(); }
+    bool        isDirectory() override { return m_f->isDirectory(); }
+    operator bool() override { return (bool)*m_f; }
+
+private:
+    fs::FileImplPtr m_f;
+    CountingCard*   m_card;
+    int             m_handle;
+};
+
+fs::FileImplPtr CountingCard::open(const char* path, const char* mode, const bool create) {
+    fs::FileImplPtr f = m_host->open(path, mode, create);
+    return f ? std::make_shared<CountingFile>(f, this, handles++) : f;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+static void resumes(Audio* audio, const char* name, const std::string& path) {
+    std::shared_ptr<CountingCard> counting = std::make_shared<CountingCard>();
+    fs::FS                        card(counting);
+    audioStats_t*                 st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    size_t                        fileSize = 0;
+    {
+        std::vector<uint8_t> d;
+        CHECK(corpusReadFile(path, &d));
+        fileSize = d.size();
+    }
+    s_eof = false;
+    hostI2S_setRealtime(true); // the file must not be played through between the resumes
+    CHECK(audio->connecttoFS(card, path.c_str()));
+    uint32_t start = millis();
+    for(int k = 1; k <= 6; k++) {
+        s_ready = false; // the buffer is filled again after each resume, the next one is done then
+        while(audio->isRunning() && !s_ready && millis() - start < 5000) audio->loop();
+        CHECK(s_ready);
+        uint32_t pos = fileSize * k / 8 + 333; // not on a frame
+        uint32_t calls = counting->calls, bytes = counting->bytes;
+        auto     t0 = std::chrono::steady_clock::now();
+        CHECK(audio->setFilePos(pos));
+        audio->loop(); // the resume is done in the next processLocalFile()
+        uint32_t wallUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+        audio->getStats(st);
+        calls = counting->calls - calls;
+        bytes = counting->bytes - bytes;
+        printf("%-5s resume at %7lu: scan %6lu bytes in %5lu us, %lu read calls of %lu bytes, loop() %lu us\n", name,
+               (long unsigned)pos, (long unsigned)st->file.resumeScanBytes, (long unsigned)st->file.resumeScanUs,
+               (long unsigned)calls, (long unsigned)bytes, (long unsigned)wallUs);
+        CHECK(st->file.resumeScanBytes > 0 && st->file.resumeScanBytes <= 3 * AUDIO_RESUME_SCAN_BLOCK);
+        CHECK(st->file.resumeScanUs < 20000);
+        CHECK(calls <= st->file.resumeScanBytes / AUDIO_RESUME_SCAN_BLOCK + 2); // one call per block, not per byte
+        CHECK(wallUs < 20000);
+        CHECK(audio->getFilePos() >= pos);
+        start = millis();
+    }
+    hostI2S_setRealtime(false);
+    start = millis();
+    while(audio->isRunning() && !s_eof && millis() - start < 20000) audio->loop();
+    audio->getStats(st);
+    audio->stopSong();
+    CHECK(s_eof);
+    CHECK(st->input.decodeErrors == 0);
+    free(st);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    CHECK(corpusWriteFlac(dir + "resume.flac", corpusTone(44100, 2, 20.0f)));
+    CHECK(corpusWriteMp3Noise(dir + "resume.mp3", 800));
+    CHECK(corpusWriteAacSilence(dir + "resume.aac", 8000));
+
+    Audio* audio = new Audio;
+    audio->setBufsize(-1, 64 * 1024);
+    resumes(audio, "FLAC", dir + "resume.flac");
+    resumes(audio, "MP3", dir + "resume.mp3");
+    resumes(audio, "AAC", dir + "resume.aac");
+    delete audio;
+    return TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+/*
+ * test_resync.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Corruption injection: random bytes of MP3 and ADTS AAC streams are damaged, a third of them in the frame header.
+ * After a decode error the next frame must be found within one frame length (MP3FindSyncWord(), AACFindSyncWord(),
+ * Audio::resyncOffset()) and at most two frames may be lost per damaged one: the MP3 bit reservoir reaches into the
+ * next frame, the ADTS sync check looks at the header of the next frame. Build with -DAUDIO_HOST_ASAN=ON to catch the
+ * decoder reading or writing out of bounds on the damaged data.
+ */
+#include <random>
+#include "Audio.h"
+#include "audio_codecs.h"
+#include "codec_arena.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static bool s_eof = false;
+void audio_eof_mp3(const char* info) { s_eof = true; }
+
+typedef struct {
+    int         codec;
+    const char* name;
+    uint32_t    frames;
+    uint32_t    frameLen;       // constant in the corpus
+    uint32_t    samplesPerFrame;
+} stream_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> readAll(const std::string& path) {
+    std::vector<uint8_t> d;
+    FILE*                f = fopen(path.c_str(), "rb");
+    if(!f) return d;
+    fseek(f, 0, SEEK_END);
+    d.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    if(fread(d.data(), 1, d.size(), f) != d.size()) d.clear();
+    fclose(f);
+    return d;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t corrupt(std::vector<uint8_t>& d, const stream_t& s, std::mt19937& rng) {
+    // one damaged byte in every 8th frame, the first two frames stay intact for the decoder to start
+    uint32_t n = 0;
+    for(uint32_t f = 2; f < s.frames - 1; f += 8) {
+        uint32_t off = (rng() % 3 == 0) ? rng() % 4 : rng() % s.frameLen;
+        d[f * s.frameLen + off] ^= 1 + rng() % 255;
+        n++;
+    }
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void decoderRun(const stream_t& s, const std::vector<uint8_t>& d, uint32_t damaged) {
+    // the decoder's C functions with the resync of Audio::resyncOffset()
+    const AudioCodec_t* codec = AudioCodec_Get(s.codec);
+    CodecArena_Reserve(codec->arenaSize());
+    CHECK(codec->allocateBuffers());
+    std::vector<int16_t> out(8192);
+    uint32_t             pos = codec->findSyncWord((uint8_t*)d.data(), d.size());
+    uint32_t             frames = 0, resyncs = 0;
+    while(pos < d.size()) {
+        int32_t left = d.size() - pos;
+        int32_t err = codec->decode((uint8_t*)d.data() + pos, &left, out.data());
+        int32_t used = (int32_t)(d.size() - pos) - left;
+        if(err >= 0 && used > 0) {
+            frames++;
+            pos += used;
+            continue;
+        }
+        int32_t next = codec->findSyncWord((uint8_t*)d.data() + pos + 1, d.size() - pos - 1);
+        if(next < 0) break;
+        resyncs++;
+        CHECK(next + 1 <= (int32_t)s.frameLen); // within one frame
+        pos += next + 1;
+    }
+    codec->freeBuffers();
+    printf("%s: %u damaged frames, %u resyncs, %u of %u frames decoded\n", s.name, damaged, resyncs, frames, s.frames);
+    CHECK(frames + 2 * damaged >= s.frames);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void audioRun(Audio& audio, const stream_t& s, const std::string& path, uint32_t damaged) {
+    CHECK(audio.openPcmSink(SD, (path + ".wav").c_str()));
+    s_eof = false;
+    CHECK(audio.connecttoFS(SD, path.c_str()));
+    uint32_t start = millis();
+    while(audio.isRunning() && !s_eof && millis() - start < 20000) audio.loop();
+    uint32_t resyncs = audio.getResyncs(), skipped = audio.getResyncSkippedBytes();
+    audio.stopSong();
+    audio.closePcmSink();
+    pcm_t out;
+    CHECK(corpusReadWav(path + ".wav", &out));
+    printf("%s through Audio: %u resyncs, %u bytes skipped, %u samples\n", s.name, resyncs, skipped, (unsigned)out.samples.size() / 2);
+    CHECK(s_eof);
+    CHECK(skipped <= resyncs * s.frameLen);
+    CHECK(out.samples.size() / 2 + 2 * damaged * s.samplesPerFrame >= s.frames * s.samplesPerFrame);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    CodecArena_Init(AudioCodec_MaxArenaSize());
+    CHECK(corpusWriteMp3Silence(dir + "resync.mp3", 400));
+    CHECK(corpusWriteAacSilence(dir + "resync.aac", 400));
+    std::vector<uint8_t> aac = readAll(dir + "resync.aac");
+    stream_t streams[] = {{CODEC_MP3, "mp3", 400, 417, 1152}, {CODEC_AAC, "aac", 400, (uint32_t)aac.size() / 400, 1024}};
+
+    Audio* audio = new Audio;
+    for(uint32_t seed = 1; seed <= 8; seed++) {
+        std::mt19937 rng(seed);
+        for(const stream_t& s : streams) {
+            std::vector<uint8_t> d = readAll(dir + "resync." + s.name);
+            uint32_t             damaged = corrupt(d, s, rng);
+            decoderRun(s, d, damaged);
+            std::string path = dir + "damaged." + s.name;
+            FILE*       f = fopen(path.c_str(), "wb");
+            fwrite(d.data(), 1, d.size(), f);
+            fclose(f);
+            audioRun(*audio, s, path, damaged);
+        }
+    }
+    delete audio;
+    return TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+/*
+ * test_station_warmer.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Station changes with preconnect() between two local stations, one over http and one over https. Both take 300 ms
+ * to answer (DNS, TLS and a busy server), then send a WAV stream of a 16 kHz mono tone with a burst of 1 s and then
+ * at its pace. A cold switch waits for the answer; a warm one takes the connection of StationWarmer over with its
+ * buffered bytes (StationWarmer::take(), ReplayClient; for https TlsClient::swap()) and must play in less than half of
+ * that. The replayed response header must be parsed once (one icy-name) and the replayed body must reach the decoder
+ * once, in order, followed by the bytes of the socket. A WAV stream without Content-Length is played as it comes, its
+ * header too, so the PCM sink of each station must hold the body from its first byte.
+ */
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+#define DELAY_MS 300
+#define RATE     32000 // bytes/s, 16 kHz mono
+
+static std::string              s_wav;
+static std::vector<std::string> s_stations; // audio_showstation()
+void audio_showstation(const char* info) { s_stations.push_back(info); }
+
+//----------------------------------------------------------------------------------------------------------------------
+static void stream(const char* name, std::function<bool(const void*, size_t)> send) {
+    // the answer after DELAY_MS, a burst of 1 s, then in real time until the client goes
+    std::this_thread::sleep_for(std::chrono::milliseconds(DELAY_MS));
+    std::string head = std::string("HTTP/1.1 200 OK\r\nContent-Type: audio/wav\r\nicy-name: ") + name + "\r\nConnection: close\r\n\r\n";
+    if(!send(head.data(), head.size())) return;
+    auto   t0 = std::chrono::steady_clock::now();
+    size_t pos = 0;
+    while(pos < s_wav.size()) {
+        uint32_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+        size_t   due = std::min(s_wav.size(), (size_t)RATE + (size_t)RATE * ms / 1000);
+        if(due > pos && !send(s_wav.data() + pos, due - pos)) return;
+        pos = due;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t zap(Audio* audio, const std::string& url, audioStats_t* st) {
+    // connecttohost(), 2 s of playing; the switch time from the stats
+    s_stations.clear();
+    CHECK(audio->openPcmSink(SD, "sink_station.wav", false));
+    CHECK(audio->connecttohost(url.c_str()));
+    uint32_t start = millis();
+    while(audio->isRunning() && millis() - start < 2000) audio->loop();
+    audio->getStats(st);
+    audio->closePcmSink();
+    pcm_t out;
+    CHECK(corpusReadWav("sink_station.wav", &out));
+    size_t bytes = out.samples.size() * 2;
+    CHECK(bytes > RATE);                                                  // 1 s at least
+    CHECK(bytes <= s_wav.size() && !memcmp(out.samples.data(), s_wav.data(), bytes)); // nothing twice, nothing lost
+    CHECK(s_stations.size() == 1);                                        // the header is parsed once
+    return st->station.lastMs;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void warmUp(Audio* audio, const std::string& url) {
+    // the neighbour of the playing station; the warmer has connected and buffered its burst after 1 s
+    const char* urls[1] = {url.c_str()};
+    CHECK(audio->preconnect(urls, 1));
+    uint32_t start = millis();
+    while(millis() - start < 1000) audio->loop();
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    pcm_t       tone = corpusTone(16000, 1, 20.0f);
+    CHECK(corpusWriteWav(dir + "station.wav", tone));
+    {
+        std::vector<uint8_t> d;
+        CHECK(corpusReadFile(dir + "station.wav", &d));
+        s_wav.assign(d.begin(), d.end());
+    }
+    chdir(dir.c_str());
+
+    TestHttpServer http([](const std::string& request, int fd) {
+        stream("Plain", [fd](const void* p, size_t n) { return TestHttpServer::sendAll(fd, p, n); });
+    });
+    TestTlsServer https([](const std::string& path, SSL* ssl) {
+        stream("Secure", [ssl](const void* p, size_t n) { return TestTlsServer::sendAll(ssl, p, n); });
+        return false;
+    });
+    std::string   a = http.url("a.wav"), b = https.url("b.wav");
+    Audio*        audio = new Audio;
+    audioStats_t* st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    hostI2S_setRealtime(true);
+
+    uint32_t coldA = zap(audio, a, st);
+    CHECK(s_stations.size() && s_stations[0] == "Plain");
+    warmUp(audio, b);
+    uint32_t warmB = zap(audio, b, st);                             // TLS, the session moves over by swap()
+    CHECK(s_stations.size() && s_stations[0] == "Secure");
+    warmUp(audio, a);
+    uint32_t warmA = zap(audio, a, st);                             // plain, the socket is shared
+    audio->preconnect(NULL, 0);
+    uint32_t coldB = zap(audio, b, st);
+    audio->getStats(st);
+    audio->stopSong();
+
+    printf("station switch: http cold %lu ms, warm %lu ms; https cold %lu ms, warm %lu ms\n", (long unsigned)coldA,
+           (long unsigned)warmA, (long unsigned)coldB, (long unsigned)warmB);
+    printf("%lu cold switches in %lu ms, %lu warm in %lu ms; %i http connections, %zu https requests\n",
+           (long unsigned)st->station.cold, (long unsigned)st->station.coldSumMs, (long unsigned)st->station.warm,
+           (long unsigned)st->station.warmSumMs, http.connections(), https.requests().size());
+    CHECK(st->station.cold == 2 && st->station.warm == 2);
+    CHECK(coldA >= DELAY_MS && coldB >= DELAY_MS);
+    CHECK(warmA < DELAY_MS / 2 && warmB < DELAY_MS / 2);
+    CHECK(http.connections() == 2);                                       // the warm one was taken, not opened again
+    CHECK(https.requests().size() == 2);
+
+    hostI2S_setRealtime(false);
+    free(st);
+    delete audio;
+    chdir("..");
+    return TEST_RESULT();
+}
@@ -0,0 +1,109 @@
+/*
+ * test_tls.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * A local TLS 1.2 server (OpenSSL, a self-signed EC certificate made at the start) with HTTP keep-alive.
+ * TlsClient: the second connect to the server resumes the session of the first one.
+ * Audio over https: an HLS stream behind a redirect whose body comes late. The unread body must not be taken as the
+ * next response, httpPrint() opens a new connection for the master playlist (a resumed handshake) and reuses it for
+ * the media playlist, whose body is read to its Content-Length. The segments come over the prefetch task's connection.
+ */
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "Audio.h"
+#include "tls_client.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static std::vector<uint8_t> s_segment;
+static TestTlsServer*       s_server = NULL;
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool serve(const std::string& path, SSL* ssl) {
+    const char* m3u8 = "application/vnd.apple.mpegurl";
+    if(path == "hello") return TestTlsServer::respond(ssl, "200 OK", "text/plain", "hello");
+    if(path == "late.m3u8") { // a redirect, its body of 7 bytes follows 300 ms after the header
+        char head[256];
+        snprintf(head, sizeof(head), "HTTP/1.1 302 Found\r\nContent-Type: text/plain\r\nContent-Length: 7\r\nLocation: %s\r\n\r\n",
+                 s_server->url("master.m3u8").c_str());
+        TestTlsServer::sendAll(ssl, head, strlen(head));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        TestTlsServer::sendAll(ssl, "moved\r\n", 7);
+        return true; // keep-alive, the client must not send its next request here
+    }
+    if(path == "master.m3u8") return TestTlsServer::respond(ssl, "200 OK", m3u8, "#EXTM3U\n#EXT-X-STREAM-INF:BANDWIDTH=32000,CODECS=\"mp4a.40.2\"\nlo.m3u8\n");
+    if(path == "lo.m3u8") {
+        std::string pl = "#EXTM3U\n#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:0\n";
+        for(const char* s : {"a", "b", "c", "d"}) pl += std::string("#EXTINF:1.0,\nlo/") + s + ".aac\n";
+        return TestTlsServer::respond(ssl, "200 OK", m3u8, pl);
+    }
+    if(path.compare(0, 3, "lo/") == 0) return TestTlsServer::respond(ssl, "200 OK", "audio/aac", std::string(s_segment.begin(), s_segment.end()));
+    return TestTlsServer::respond(ssl, "404 Not Found", "text/plain", "");
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    CHECK(corpusWriteAacSilence(dir + "tls.aac", 100));
+    FILE* f = fopen((dir + "tls.aac").c_str(), "rb");
+    s_segment.resize(1300);
+    CHECK(f && fread(s_segment.data(), 1, s_segment.size(), f) == s_segment.size());
+    if(f) fclose(f);
+    s_server = new TestTlsServer(serve);
+
+    // TlsClient: a full handshake, then the session of it
+    TlsClient* tls = new TlsClient;
+    tls->setInsecure();
+    for(int i = 0; i < 2; i++) {
+        CHECK(tls->connect("127.0.0.1", s_server->port()));
+        printf("connect %i: %s handshake, %lu ms\n", i + 1, tls->timing().resumed ? "resumed" : "full", (long unsigned)tls->timing().tlsMs);
+        CHECK(tls->timing().resumed == (i == 1));
+        tls->print("GET /hello HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+        std::string r;
+        uint32_t    t = millis();
+        while(r.find("hello", r.find("\r\n\r\n") + 1) == std::string::npos && millis() - t < 2000) {
+            int c = tls->read();
+            if(c >= 0) r += (char)c;
+        }
+        CHECK(r.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+        tls->stop();
+    }
+    tlsStats_t st = TlsClient::stats();
+    CHECK(st.handshakes >= 1 && st.resumed >= 1);
+    delete tls;
+
+    // Audio: the redirect keeps its connection open and sends its body late
+    Audio* audio = new Audio;
+    CHECK(audio->connecttohost(s_server->url("late.m3u8").c_str()));
+    uint32_t start = millis();
+    size_t   segments = 0;
+    while(millis() - start < 10000 && segments < 3) {
+        audio->loop();
+        segments = 0;
+        for(const TestTlsServer::request_t& r : s_server->requests()) segments += r.path.compare(0, 3, "lo/") == 0;
+    }
+    audio->stopSong();
+    delete audio;
+
+    std::vector<TestTlsServer::request_t> req = s_server->requests();
+    int                    late = 0, master = 0, media = 0, segment = 0;
+    bool                   oneSegmentConn = true;
+    for(const TestTlsServer::request_t& r : req) {
+        printf("connection %i%s: %s\n", r.conn, r.resumed ? " (resumed)" : "", r.path.c_str());
+        if(r.path == "late.m3u8") late = r.conn;
+        if(r.path == "master.m3u8") master = r.conn;
+        if(r.path == "lo.m3u8") media = r.conn;
+        if(r.path.compare(0, 3, "lo/") == 0) {
+            oneSegmentConn &= !segment || segment == r.conn;
+            segment = r.conn;
+        }
+    }
+    CHECK(segments >= 3);
+    CHECK(late && master && master != late);            // the redirect's body was not read, a new connection
+    CHECK(media == master);                             // the body was read to its Content-Length, the connection is kept
+    CHECK(oneSegmentConn);                              // the same for the prefetch task
+    for(const TestTlsServer::request_t& r : req) if(r.conn > 1) CHECK(r.resumed);
+    return TEST_RESULT();
+}
@@ -0,0 +1,244 @@
+/*
+ * test_ts_demux.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * TsDemux on HLS segments written as TS files: PAT, PMT with a video and an AAC stream, PES of 64 ADTS frames each
+ * (five packets), video and null packets in between. They are demuxed as Audio::processWebStreamTS() does, in batches of
+ * AUDIO_TS_BATCH packets out of reads of 1..4096 bytes. The clean segment must give the ADTS stream byte for byte. Each
+ * damaged one has one fault in the third packet of a PES: a continuity gap, the transport error indicator, 57 bytes of
+ * garbage in front of it (lost sync) and an adaptation field length of 255. The PES must be cut there, the bytes of its
+ * first two packets are kept and all other PES must come out complete; a duplicated packet is dropped. The throughput is
+ * measured on the clean segment.
+ *
+ *   test_ts_demux [segment.ts]   demuxes a recorded segment, prints the counters and the throughput
+ */
+#include <algorithm>
+#include <chrono>
+#include "ts_demux.h"
+#include "corpus.h"
+#include "test_util.h"
+
+#define VIDEO_PID 0x100
+#define AUDIO_PID 0x101
+#define PMT_PID   0x1000
+#define FRAMES    64 // ADTS frames per PES
+
+enum { CLEAN, CC_GAP, TEI, LOST_SYNC, OVERSIZED_AF, DUPLICATE };
+
+typedef struct {
+    std::vector<uint8_t> ts;
+    std::vector<uint8_t> es;   // what must come out
+    uint32_t             pes = 0;
+    uint32_t             damagedPackets = 0;
+} segment_t;
+
+typedef struct {
+    uint32_t packets;
+    uint32_t ccErrors;
+    uint32_t syncLosses;
+    uint32_t dropped;
+} counters_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t crc32Mpeg(const uint8_t* p, size_t n) {
+    uint32_t crc = 0xFFFFFFFF;
+    while(n--) {
+        crc ^= (uint32_t)*p++ << 24;
+        for(int k = 0; k < 8; k++) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void packet(std::vector<uint8_t>* ts, uint16_t pid, bool pusi, uint8_t* cc, const uint8_t* payload, size_t n) {
+    // a payload of less than 184 bytes is padded with adaptation field stuffing
+    uint8_t p[TS_PACKET_SIZE];
+    size_t  af = TS_MAX_PAYLOAD - n;
+    p[0] = 0x47;
+    p[1] = (pusi ? 0x40 : 0x00) | (pid >> 8);
+    p[2] = pid & 0xFF;
+    p[3] = (af ? 0x30 : 0x10) | (*cc & 0x0F);
+    *cc = (*cc + 1) & 0x0F;
+    if(af) {
+        p[4] = af - 1;
+        if(af > 1) p[5] = 0x00; // no flags
+        memset(p + 6, 0xFF, af > 2 ? af - 2 : 0);
+    }
+    memcpy(p + 4 + af, payload, n);
+    ts->insert(ts->end(), p, p + TS_PACKET_SIZE);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void section(std::vector<uint8_t>* ts, uint16_t pid, uint8_t* cc, std::vector<uint8_t> s) {
+    // pointer field, the section with its CRC, 0xFF up to the end of the packet
+    uint32_t crc = crc32Mpeg(s.data(), s.size());
+    for(int k = 24; k >= 0; k -= 8) s.push_back(crc >> k);
+    s.insert(s.begin(), 0x00);
+    s.resize(TS_MAX_PAYLOAD, 0xFF);
+    packet(ts, pid, true, cc, s.data(), s.size());
+}
+//----------------------------------------------------------------------------------------------------------------------
+static segment_t segment(const std::vector<uint8_t>& adts, int fault) {
+    segment_t seg;
+    uint8_t   ccPat = 0, ccPmt = 0, ccVideo = 0, ccAudio = 0, ccNull = 0;
+    section(&seg.ts, 0, &ccPat, {0x00, 0xB0, 13, 0x00, 0x01, 0xC1, 0x00, 0x00, 0x00, 0x01, 0xE0 | (PMT_PID >> 8), PMT_PID & 0xFF});
+    section(&seg.ts, PMT_PID, &ccPmt,
+            {0x02, 0xB0, 23, 0x00, 0x01, 0xC1, 0x00, 0x00, 0xE0 | (AUDIO_PID >> 8), AUDIO_PID & 0xFF, 0xF0, 0x00,   // PCR PID, no program info
+             0x1B, 0xE0 | (VIDEO_PID >> 8), VIDEO_PID & 0xFF, 0xF0, 0x00,                                          // H.264
+             0x0F, 0xE0 | (AUDIO_PID >> 8), AUDIO_PID & 0xFF, 0xF0, 0x00});                                        // AAC ADTS
+
+    // the ADTS frames, their length is in the header
+    std::vector<std::pair<size_t, size_t>> frames;
+    for(size_t i = 0; i + 7 <= adts.size();) {
+        size_t len = ((adts[i + 3] & 0x03) << 11) | (adts[i + 4] << 3) | (adts[i + 5] >> 5);
+        if(adts[i] != 0xFF || (adts[i + 1] & 0xF0) != 0xF0 || !len || i + len > adts.size()) break;
+        frames.push_back({i, len});
+        i += len;
+    }
+    for(size_t f = 0; f + FRAMES <= frames.size(); f += FRAMES, seg.pes++) {
+        size_t  start = frames[f].first, len = frames[f + FRAMES - 1].first + frames[f + FRAMES - 1].second - start;
+        uint8_t pts[5] = {0x21, 0x00, 0x01, 0x00, 0x01};
+        std::vector<uint8_t> pes = {0x00, 0x00, 0x01, 0xC0, (uint8_t)((len + 8) >> 8), (uint8_t)(len + 8), 0x80, 0x80, 0x05};
+        pes.insert(pes.end(), pts, pts + 5);
+        size_t hdr = pes.size();
+        pes.insert(pes.end(), adts.begin() + start, adts.begin() + start + len);
+
+        bool damaged = fault != CLEAN && seg.pes == 3;
+        for(size_t k = 0, n = 0; k < pes.size(); k += n) {
+            n = std::min(pes.size() - k, (size_t)TS_MAX_PAYLOAD);
+            bool third = k / TS_MAX_PAYLOAD == 2;
+            if(damaged && third) {
+                if(fault == CC_GAP) { ccAudio = (ccAudio + 1) & 0x0F; continue; }   // lost on the way
+                if(fault == LOST_SYNC) for(int g = 0; g < 57; g++) seg.ts.push_back(g); // no sync byte
+            }
+            packet(&seg.ts, AUDIO_PID, k == 0, &ccAudio, pes.data() + k, n);
+            uint8_t* p = &seg.ts[seg.ts.size() - TS_PACKET_SIZE];
+            if(damaged && third && fault == TEI) p[1] |= 0x80;
+            if(damaged && third && fault == OVERSIZED_AF) { p[3] |= 0x20; p[4] = 255; }
+            if(damaged && third && fault == DUPLICATE) seg.ts.insert(seg.ts.end(), p, p + TS_PACKET_SIZE);
+            if(damaged && fault != DUPLICATE && k / TS_MAX_PAYLOAD >= 2) seg.damagedPackets++;
+            else if(k + n > hdr) seg.es.insert(seg.es.end(), pes.begin() + std::max(k, hdr), pes.begin() + k + n);
+            if(k == 0) packet(&seg.ts, VIDEO_PID, true, &ccVideo, pes.data(), TS_MAX_PAYLOAD); // another PID, dropped
+        }
+        uint8_t nul[TS_MAX_PAYLOAD] = {0};
+        packet(&seg.ts, 0x1FFF, false, &ccNull, nul, sizeof(nul));
+    }
+    return seg;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> demux(TsDemux& d, const std::vector<uint8_t>& ts, counters_t* c) {
+    // as Audio::processWebStreamTS(): reads into a batch buffer, demux straight into the input buffer
+    static const size_t  reads[] = {1, 187, 188, 1000, 4096, 376, 95};
+    uint8_t              batch[AUDIO_TS_BATCH * TS_PACKET_SIZE];
+    size_t               fill = 0, pos = 0;
+    std::vector<uint8_t> es(ts.size() + TS_MAX_PAYLOAD);
+    size_t               o = 0;
+    d.newSegment();
+    for(int r = 0; pos < ts.size() || fill >= TS_PACKET_SIZE; r++) {
+        size_t n = std::min({reads[r % 7], sizeof(batch) - fill, ts.size() - pos});
+        memcpy(batch + fill, ts.data() + pos, n);
+        fill += n;
+        pos += n;
+        if(fill < TS_PACKET_SIZE) continue;
+        size_t used = 0;
+        o += d.demux(batch, fill, es.data() + o, es.size() - o, &used);
+        fill -= used;
+        memmove(batch, batch + used, fill);
+    }
+    es.resize(o);
+    *c = {d.packets(), d.ccErrors(), d.syncLosses(), d.dropped()};
+    return es;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static double throughput(const std::vector<uint8_t>& ts) {
+    // MB/s of TS, demuxed in whole batches; the segment is run through until 64 MB are done
+    TsDemux              d;
+    std::vector<uint8_t> out(AUDIO_TS_BATCH * TS_MAX_PAYLOAD);
+    size_t               total = 0, batch = AUDIO_TS_BATCH * TS_PACKET_SIZE;
+    uint64_t             es = 0;
+    auto                 t0 = std::chrono::steady_clock::now();
+    while(total < 64 * 1024 * 1024) {
+        d.newSegment();
+        for(size_t i = 0; i < ts.size(); i += batch) {
+            size_t used = 0;
+            es += d.demux(ts.data() + i, std::min(batch, ts.size() - i), out.data(), out.size(), &used);
+        }
+        total += ts.size();
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%.1f MB/s of TS, %.1f ns per packet, %llu ES bytes\n", total / s / 1e6, s * 1e9 / d.packets(), (long long unsigned)es);
+    return total / s / 1e6;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    counters_t c;
+    if(argc > 1) {
+        std::vector<uint8_t> ts;
+        CHECK(corpusReadFile(argv[1], &ts));
+        TsDemux d;
+        d.reset();
+        size_t es = demux(d, ts, &c).size();
+        printf("%s: audio PID 0x%04X, %lu packets, %lu ES bytes; %lu CC errors, %lu sync losses, %lu dropped\n", argv[1],
+               d.audioPid(), (long unsigned)c.packets, (long unsigned)es, (long unsigned)c.ccErrors, (long unsigned)c.syncLosses,
+               (long unsigned)c.dropped);
+        throughput(ts);
+        return TEST_RESULT();
+    }
+
+    std::string          dir = corpusDir();
+    std::vector<uint8_t> adts;
+    CHECK(corpusWriteAacSilence(dir + "ts.aac", 64 * 40));
+    CHECK(corpusReadFile(dir + "ts.aac", &adts));
+    const char* names[] = {"clean", "cc_gap", "tei", "lost_sync", "oversized_af", "duplicate"};
+    segment_t   clean;
+
+    for(int fault = CLEAN; fault <= DUPLICATE; fault++) {
+        segment_t seg = segment(adts, fault);
+        CHECK(corpusWriteFile(dir + "seg_" + names[fault] + ".ts", seg.ts));
+        TsDemux d;
+        d.reset();
+        std::vector<uint8_t> es = demux(d, seg.ts, &c);
+        printf("%-12s %4zu packets, %2u PES: %6zu ES bytes of %6zu; %lu CC errors, %lu sync losses, %lu dropped\n", names[fault],
+               seg.ts.size() / TS_PACKET_SIZE, seg.pes, es.size(), seg.es.size(), (long unsigned)c.ccErrors,
+               (long unsigned)c.syncLosses, (long unsigned)c.dropped);
+        CHECK(d.audioPid() == AUDIO_PID);
+        CHECK(!d.noAudio());
+        CHECK(seg.pes == 40);
+        CHECK(es == seg.es);
+        CHECK(c.ccErrors == (fault == CC_GAP));
+        CHECK(c.syncLosses == (fault == LOST_SYNC));
+        CHECK(c.dropped == seg.damagedPackets);
+        if(fault == CLEAN) {
+            clean = seg;
+            CHECK(es.size() == adts.size());
+            CHECK(seg.damagedPackets == 0);
+        }
+        else if(fault != DUPLICATE) CHECK(seg.damagedPackets >= 2 && es.size() < clean.es.size());
+    }
+
+    // the next segment starts with its own counter, a continuity gap at the boundary is not an error
+    {
+        TsDemux d;
+        d.reset();
+        std::vector<uint8_t> es = demux(d, clean.ts, &c);
+        std::vector<uint8_t> next = clean.ts;
+        for(size_t i = 0; i < next.size(); i += TS_PACKET_SIZE) next[i + 3] = (next[i + 3] & 0xF0) | ((next[i + 3] + 5) & 0x0F);
+        std::vector<uint8_t> es2 = demux(d, next, &c);
+        CHECK(es2 == clean.es);
+        CHECK(c.ccErrors == 0);
+    }
+
+    // a bare pointer field of 255 and an adaptation field of 255 in the PAT: no read beyond the packet
+    {
+        std::vector<uint8_t> ts(TS_PACKET_SIZE, 0xFF);
+        ts[0] = 0x47, ts[1] = 0x40, ts[2] = 0x00, ts[3] = 0x30, ts[4] = 255;
+        ts.insert(ts.end(), ts.begin(), ts.end());
+        ts[TS_PACKET_SIZE + 3] = 0x11, ts[TS_PACKET_SIZE + 4] = 255; // payload only, pointer field 255
+        ts.insert(ts.end(), clean.ts.begin(), clean.ts.end());
+        TsDemux d;
+        d.reset();
+        CHECK(demux(d, ts, &c) == clean.es);
+    }
+
+    CHECK(throughput(clean.ts) > 50); // 40 kB/s for a 320 kbit/s stream
+    return TEST_RESULT();
+}
@@ -0,0 +1,327 @@
+/*
+ * test_util.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * CHECK() for the test programs and a local HTTP server that serves files from the working directory, with byte ranges,
+ * also as a web radio stream at a given pace with stalls; a local HTTPS server.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                                             \
+    do {                                                                                        \
+        if(!(cond)) {                                                                           \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);            \
+            s_failures++;                                                                       \
+        }                                                                                       \
+    } while(0)
+
+#define TEST_RESULT() (s_failures ? (fprintf(stderr, "%d check(s) failed\n", s_failures), 1) : 0)
+
+//----------------------------------------------------------------------------------------------------------------------
+// One connection at a time, each in its own thread. The handler gets the request head and the socket and writes the
+// response; serveFile() answers a GET with a file of the working directory and Content-Length, a "Range: bytes=a-" or
+// "a-b" with 206 and Content-Range; files() does the same and counts the bytes sent, throttledStream() answers with
+// a stream of a file over and over, without Content-Length, paced as a radio server and a WiFi link with hiccups do.
+class TestHttpServer {
+
+public:
+    typedef std::function<void(const std::string& request, int fd)> handler_t;
+
+    typedef struct {
+        uint32_t bytesPerSec = 16000; // the pace, 128 kbit/s
+        uint32_t burst = 0;           // sent at once at the start
+        uint32_t seconds = 10;        // then the connection is closed
+        std::vector<std::pair<uint32_t, uint32_t>> stalls; // {start ms, length ms}: nothing is sent, the data is sent
+                                                           // late, not lost
+    } throttle_t;
+
+    explicit TestHttpServer(handler_t handler = serveFile) : m_handler(handler) {
+        m_listen = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_listen, (struct sockaddr*)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(m_listen, (struct sockaddr*)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+        listen(m_listen, 8);
+        m_thread = std::thread([this] { run(); });
+    }
+    ~TestHttpServer() {
+        m_stop = true;
+        shutdown(m_listen, SHUT_RDWR);
+        close(m_listen);
+        m_thread.join();
+    }
+    uint16_t    port() const { return m_port; }
+    std::string url(const std::string& path) const { return "http://127.0.0.1:" + std::to_string(m_port) + "/" + path; }
+    int         connections() const { return m_connections; }
+
+    static std::string readHead(int fd) {
+        std::string head;
+        char        c;
+        while(head.size() < 8192 && recv(fd, &c, 1, 0) == 1) {
+            head += c;
+            if(head.size() >= 4 && !head.compare(head.size() - 4, 4, "\r\n\r\n")) break;
+        }
+        return head;
+    }
+    static bool sendAll(int fd, const void* data, size_t len) {
+        const char* p = (const char*)data;
+        while(len) {
+            ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+            if(n <= 0) return false;
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+    static const char* contentType(const std::string& path) {
+        if(path.size() > 4 && path.compare(path.size() - 4, 4, ".wav") == 0) return "audio/wav";
+        if(path.size() > 5 && path.compare(path.size() - 5, 5, ".flac") == 0) return "audio/flac";
+        if(path.size() > 4 && path.compare(path.size() - 4, 4, ".aac") == 0) return "audio/aac";
+        return "audio/mpeg";
+    }
+    static void serveFile(const std::string& request, int fd) { serve(request, fd, true, NULL); }
+    static handler_t files(std::atomic<uint32_t>* sent, bool ranges = true) { // false: Range ignored, as some servers do
+        return [sent, ranges](const std::string& request, int fd) { serve(request, fd, ranges, sent); };
+    }
+    static void serve(const std::string& request, int fd, bool ranges, std::atomic<uint32_t>* sent) {
+        size_t      sp = request.find(' ');
+        std::string path = request.substr(sp + 2, request.find(' ', sp + 1) - sp - 2);
+        FILE*       f = fopen(path.c_str(), "rb");
+        if(!f) {
+            const char* r = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+            sendAll(fd, r, strlen(r));
+            return;
+        }
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        long first = 0, last = size - 1;
+        std::string lower = request;
+        for(char& c : lower) c = tolower(c);
+        size_t r = lower.find("\r\nrange: bytes=");
+        if(ranges && r != std::string::npos) {
+            r += strlen("\r\nrange: bytes=");
+            first = atol(lower.c_str() + r);
+            size_t dash = lower.find('-', r);
+            if(dash != std::string::npos && isdigit(lower[dash + 1])) last = std::min(last, atol(lower.c_str() + dash + 1));
+        }
+        char head[384];
+        if(ranges && r != std::string::npos && (first >= size || first > last)) {
+            snprintf(head, sizeof(head), "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%ld\r\nContent-Length: 0\r\n\r\n", size);
+            sendAll(fd, head, strlen(head));
+            fclose(f);
+            return;
+        }
+        int sndbuf = 64 * 1024; // the socket buffers hold little, "sent" is close to what the client has read
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        if(ranges && r != std::string::npos) {
+            snprintf(head, sizeof(head), "HTTP/1.1 206 Partial Content\r\nContent-Type: %s\r\nContent-Length: %ld\r\n"
+                     "Content-Range: bytes %ld-%ld/%ld\r\nAccept-Ranges: bytes\r\nConnection: close\r\n\r\n",
+                     contentType(path), last - first + 1, first, last, size);
+        }
+        else {
+            snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %ld\r\nAccept-Ranges: bytes\r\n"
+                     "Connection: close\r\n\r\n", contentType(path), size);
+        }
+        sendAll(fd, head, strlen(head));
+        fseek(f, first, SEEK_SET);
+        char buf[4096];
+        long left = last - first + 1;
+        size_t n;
+        while(left > 0 && (n = fread(buf, 1, std::min((long)sizeof(buf), left), f)) > 0 && sendAll(fd, buf, n)) {
+            left -= n;
+            if(sent) *sent += n;
+        }
+        fclose(f);
+    }
+
+    static handler_t throttledStream(const std::string& path, const throttle_t& t, std::atomic<uint32_t>* sent = NULL) {
+        return [path, t, sent](const std::string& request, int fd) {
+            std::string data;
+            FILE*       f = fopen(path.c_str(), "rb");
+            char        buf[4096];
+            size_t      n;
+            while(f && (n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+            if(f) fclose(f);
+            if(data.empty()) return;
+            char head[256];
+            snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nicy-name: throttled\r\nConnection: close\r\n\r\n",
+                     contentType(path));
+            if(!sendAll(fd, head, strlen(head))) return;
+            auto     t0 = std::chrono::steady_clock::now();
+            uint64_t pos = 0;
+            while(true) {
+                uint32_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+                if(ms >= t.seconds * 1000) break;
+                bool stalled = false;
+                for(const auto& s : t.stalls) stalled |= ms >= s.first && ms < s.first + s.second;
+                uint64_t due = stalled ? pos : t.burst + (uint64_t)t.bytesPerSec * ms / 1000;
+                if(due <= pos) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    continue;
+                }
+                size_t off = pos % data.size(), len = std::min((size_t)(due - pos), std::min(data.size() - off, sizeof(buf)));
+                if(!sendAll(fd, data.data() + off, len)) break;
+                pos += len;
+                if(sent) *sent += len;
+            }
+        };
+    }
+
+private:
+    void run() {
+        while(!m_stop) {
+            int fd = accept(m_listen, NULL, NULL);
+            if(fd < 0) break;
+            m_connections++;
+            std::thread([this, fd] {
+                std::string head = readHead(fd);
+                if(!head.empty()) m_handler(head, fd);
+                shutdown(fd, SHUT_WR);
+                char c;
+                while(recv(fd, &c, 1, 0) > 0) {} // until the client closes
+                close(fd);
+            }).detach();
+        }
+    }
+
+    handler_t         m_handler;
+    int               m_listen = -1;
+    uint16_t          m_port = 0;
+    std::atomic<bool> m_stop{false};
+    std::atomic<int>  m_connections{0};
+    std::thread       m_thread;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// A TLS 1.2 server with a self-signed EC certificate made at the start, HTTP keep-alive: the handler is called for
+// each request of a connection until it returns false. requests() tells which connection each request came over and
+// whether its handshake resumed a session.
+class TestTlsServer {
+
+public:
+    typedef struct {
+        int         conn;    // connections in the order of accept(), from 1
+        bool        resumed; // the handshake of the connection
+        std::string path;
+    } request_t;
+
+    typedef std::function<bool(const std::string& path, SSL* ssl)> handler_t; // false: close the connection
+
+    explicit TestTlsServer(handler_t handler) : m_handler(handler) {
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509*     x = X509_new();
+        X509_set_version(x, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(x), 1);
+        X509_gmtime_adj(X509_getm_notBefore(x), 0);
+        X509_gmtime_adj(X509_getm_notAfter(x), 3600);
+        X509_set_pubkey(x, key);
+        X509_NAME* name = X509_get_subject_name(x);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"127.0.0.1", -1, -1, 0);
+        X509_set_issuer_name(x, name);
+        X509_sign(x, key, EVP_sha256());
+        m_ctx = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_use_certificate(m_ctx, x);
+        SSL_CTX_use_PrivateKey(m_ctx, key);
+        SSL_CTX_set_session_id_context(m_ctx, (const unsigned char*)"test_tls", 8);
+        X509_free(x);
+        EVP_PKEY_free(key);
+
+        m_listen = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_listen, (struct sockaddr*)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(m_listen, (struct sockaddr*)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+        listen(m_listen, 8);
+        m_thread = std::thread([this] { run(); });
+    }
+    ~TestTlsServer() { // the SSL_CTX stays, a connection thread may still use it
+        shutdown(m_listen, SHUT_RDWR);
+        close(m_listen);
+        m_thread.join();
+    }
+    uint16_t    port() const { return m_port; }
+    std::string url(const std::string& path) const { return "https://127.0.0.1:" + std::to_string(m_port) + "/" + path; }
+    std::vector<request_t> requests() {
+        std::lock_guard<std::mutex> l(m_lock);
+        return m_requests;
+    }
+    static bool sendAll(SSL* ssl, const void* data, size_t len) { return len == 0 || SSL_write(ssl, data, len) == (int)len; }
+    static bool respond(SSL* ssl, const char* status, const char* type, const std::string& body, const char* extra = "") {
+        char head[256];
+        snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n", status, type, body.size(), extra);
+        return sendAll(ssl, head, strlen(head)) && sendAll(ssl, body.data(), body.size());
+    }
+
+private:
+    void run() {
+        for(int conn = 1;; conn++) {
+            int fd = accept(m_listen, NULL, NULL);
+            if(fd < 0) break;
+            std::thread([this, fd, conn] {
+                SSL* ssl = SSL_new(m_ctx);
+                SSL_set_fd(ssl, fd);
+                if(SSL_accept(ssl) == 1) {
+                    while(true) { // requests on this connection until the client closes it
+                        std::string head;
+                        char        c;
+                        while(head.size() < 8192 && SSL_read(ssl, &c, 1) == 1) {
+                            head += c;
+                            if(head.size() >= 4 && !head.compare(head.size() - 4, 4, "\r\n\r\n")) break;
+                        }
+                        if(head.compare(0, 5, "GET /")) break;
+                        std::string path = head.substr(5, head.find(' ', 5) - 5);
+                        {
+                            std::lock_guard<std::mutex> l(m_lock);
+                            m_requests.push_back({conn, SSL_session_reused(ssl) == 1, path});
+                        }
+                        if(!m_handler(path, ssl)) break;
+                    }
+                    SSL_shutdown(ssl);
+                }
+                SSL_free(ssl);
+                close(fd);
+            }).detach();
+        }
+    }
+
+    handler_t              m_handler;
+    SSL_CTX*               m_ctx = NULL;
+    int                    m_listen = -1;
+    uint16_t               m_port = 0;
+    std::thread            m_thread;
+    std::mutex             m_lock;
+    std::vector<request_t> m_requests;
+};
@@ -0,0 +1,136 @@
+/*
+ * test_vorbis.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Codebook entry decoding of the Vorbis decoder: the direct lookup tables (VORBIS_LOOKUP_BITS) must give the PCM of
+ * the tree walk bit for bit, and both the PCM of the decoder before the lookup tables (PCM hash below). The generated
+ * stream uses all decode table layouts and codewords longer than the table width; files in $AUDIO_CORPUS (*.ogg) are
+ * compared as well. The CPU time per second of audio is printed for each table width.
+ * The fused imdct/overlap-add must match the transform in place of the work buffers (PSNR, CPU time printed).
+ */
+#include <math.h>
+#include <dirent.h>
+#include "Arduino.h"
+#include "audio_codecs.h"
+#include "codec_arena.h"
+#include "vorbis_decoder/vorbis_decoder.h"
+#include "corpus.h"
+#include "test_util.h"
+
+#define NOISE_PACKETS   600
+#define NOISE_PCM_HASH  0x2A8A4016UL // the tree walk decoder of the baseline, the same file
+
+typedef struct {
+    std::vector<int16_t> pcm;
+    uint64_t             cycles = 0;
+    uint32_t             sampleRate = 0;
+    uint32_t             errors = 0;
+} decoded_t;
+
+//----------------------------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> readAll(const std::string& path) {
+    std::vector<uint8_t> d;
+    FILE*                f = fopen(path.c_str(), "rb");
+    if(!f) return d;
+    fseek(f, 0, SEEK_END);
+    d.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    if(fread(d.data(), 1, d.size(), f) != d.size()) d.clear();
+    fclose(f);
+    return d;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t hashOf(const std::vector<int16_t>& pcm) {
+    uint32_t       h = 2166136261UL;
+    const uint8_t* p = (const uint8_t*)pcm.data();
+    for(size_t i = 0; i < pcm.size() * 2; i++) { h ^= p[i]; h *= 16777619UL; }
+    return h;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static decoded_t decode(const std::vector<uint8_t>& file, uint8_t lookupBits, bool fused = true) {
+    // as bench_decode, the file in one buffer with some slack: the bit reader looks up to 5 bytes ahead
+    const AudioCodec_t*  codec = AudioCodec_Get(CODEC_VORBIS);
+    std::vector<uint8_t> d(file);
+    std::vector<int16_t> out(8192);
+    decoded_t            r;
+    d.resize(file.size() + 8);
+    VORBISsetLookupBits(VORBISDecoder_Default(), lookupBits);
+    VORBISsetFusedImdct(VORBISDecoder_Default(), fused);
+    CodecArena_Reserve(codec->arenaSize ? codec->arenaSize() : 0);
+    CHECK(codec->allocateBuffers());
+    size_t pos = 0, end = file.size();
+    bool   f_sync = false;
+    while(pos < end) {
+        int32_t left = end - pos;
+        if(!f_sync) {
+            int32_t n = codec->findSyncWord(d.data() + pos, left);
+            if(n < 0) break;
+            pos += n;
+            f_sync = true;
+            continue;
+        }
+        uint32_t t0 = ESP.getCycleCount();
+        int32_t  err = codec->decode(d.data() + pos, &left, out.data());
+        r.cycles += ESP.getCycleCount() - t0;
+        int32_t used = (int32_t)(end - pos) - left;
+        if(err < 0 || (used == 0 && err == 0)) { r.errors++; pos++; f_sync = false; continue; }
+        pos += used;
+        if(err == codec->parseOggDone) continue;
+        uint32_t samps = codec->getOutputSamps();
+        r.pcm.insert(r.pcm.end(), out.begin(), out.begin() + samps * codec->getChannels());
+        if(samps) r.sampleRate = codec->getSampRate(); // 0 again after the last page
+    }
+    codec->freeBuffers();
+    VORBISsetLookupBits(VORBISDecoder_Default(), VORBIS_LOOKUP_BITS);
+    VORBISsetFusedImdct(VORBISDecoder_Default(), true);
+    return r;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static double psnr(const std::vector<int16_t>& a, const std::vector<int16_t>& b) { // dB, 1000 if identical
+    double e = 0;
+    for(size_t i = 0; i < a.size(); i++) e += (double)(a[i] - b[i]) * (a[i] - b[i]);
+    if(e == 0) return 1000;
+    return 10 * log10(32767.0 * 32767.0 * a.size() / e);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void compare(const std::string& path, uint32_t expectedHash) {
+    std::vector<uint8_t> file = readAll(path);
+    CHECK(!file.empty());
+    decoded_t tree = decode(file, 0);
+    double    seconds = tree.sampleRate ? tree.pcm.size() / 2.0 / tree.sampleRate : 0;
+    printf("%s: %.2f s, PCM hash %08lX, %u errors\n", path.c_str(), seconds, (unsigned long)hashOf(tree.pcm), tree.errors);
+    printf("  lookup bits  CPU ms per s of audio\n");
+    printf("  %11u  %21.2f\n", 0, seconds > 0 ? tree.cycles / 1e6 / seconds : 0);
+    CHECK(seconds > 0 && !tree.errors);
+    if(expectedHash) CHECK(hashOf(tree.pcm) == expectedHash);
+    for(uint8_t bits : {4, 8, 12}) {
+        decoded_t t = decode(file, bits);
+        printf("  %11u  %21.2f\n", bits, seconds > 0 ? t.cycles / 1e6 / seconds : 0);
+        CHECK(t.pcm == tree.pcm); // bit-exact
+    }
+    decoded_t inPlace = decode(file, VORBIS_LOOKUP_BITS, false);
+    decoded_t fused = decode(file, VORBIS_LOOKUP_BITS, true);
+    CHECK(inPlace.pcm.size() == fused.pcm.size());
+    double db = inPlace.pcm.size() == fused.pcm.size() ? psnr(inPlace.pcm, fused.pcm) : 0;
+    printf("  imdct in place %.2f, fused %.2f CPU ms per s of audio, PSNR %s%.1f dB\n",
+           seconds > 0 ? inPlace.cycles / 1e6 / seconds : 0, seconds > 0 ? fused.cycles / 1e6 / seconds : 0,
+           db >= 1000 ? "(bit-exact) " : "", db);
+    CHECK(db >= 90);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    CodecArena_Init(AudioCodec_MaxArenaSize());
+    std::string dir = corpusDir();
+    CHECK(corpusWriteVorbis(dir + "noise.ogg", NOISE_PACKETS));
+    compare(dir + "noise.ogg", NOISE_PCM_HASH);
+
+    const char* extra = getenv("AUDIO_CORPUS");
+    DIR*        dp = extra ? opendir(extra) : NULL;
+    for(struct dirent* e; dp && (e = readdir(dp));) {
+        std::string p = e->d_name;
+        if(p.size() > 4 && p.compare(p.size() - 4, 4, ".ogg") == 0) compare(std::string(extra) + "/" + p, 0);
+    }
+    if(dp) closedir(dp);
+    return TEST_RESULT();
+}
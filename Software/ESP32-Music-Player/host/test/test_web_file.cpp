@@ -0,0 +1,74 @@
+/*
+ * test_web_file.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ * Seek in a web file with HTTP range requests: a WAV of 60 s (10.6 MB) from the local server, setFilePos() to 3/4 as
+ * soon as the header is read. The duration comes from Content-Length, the seek is one range request that is answered
+ * with 206, the server sends far less than the file, and the PCM sink ends with the samples behind the new position.
+ * A server that sends Accept-Ranges but answers the range with the whole file (200): the seek still lands on the
+ * position, the data in front of it is read over.
+ */
+#include "Audio.h"
+#include "host.h"
+#include "corpus.h"
+#include "test_util.h"
+
+static bool s_eof = false, s_ready = false;
+void audio_eof_mp3(const char* info) { s_eof = true; }
+void audio_eof_stream(const char* info) { s_eof = true; }
+void audio_info(const char* info) { if(!strncmp(info, "stream ready", 12)) s_ready = true; }
+
+//----------------------------------------------------------------------------------------------------------------------
+static void seek(Audio* audio, const pcm_t& tone, bool ranges) {
+    std::atomic<uint32_t> sent{0};
+    TestHttpServer        server(TestHttpServer::files(&sent, ranges));
+    audioStats_t*         st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    uint32_t              size = 44 + tone.samples.size() * 2;
+    uint32_t              pos = 44 + tone.samples.size() / 2 * 3 / 4 * 2 * 2; // 3/4, on a frame
+    pcm_t                 out;
+
+    s_eof = s_ready = false;
+    CHECK(audio->openPcmSink(SD, "sink_web.wav"));
+    CHECK(audio->connecttohost(server.url("web.wav").c_str()));
+    uint32_t start = millis();
+    while(audio->isRunning() && (!s_ready || !audio->getAudioFileDuration()) && millis() - start < 5000) audio->loop(); // header
+    CHECK(s_ready);
+    uint32_t duration = audio->getAudioFileDuration();
+    uint32_t t0 = millis();
+    CHECK(audio->setFilePos(pos));
+    while(audio->isRunning() && !s_eof && millis() - start < 20000) audio->loop();
+    uint32_t ms = millis() - t0;
+    audio->getStats(st);
+    audio->closePcmSink();
+    CHECK(corpusReadWav("sink_web.wav", &out));
+    size_t tail = (size - pos) / 2;
+    printf("%s: duration %lu s; seek to %lu: %lu range requests, first data after %lu ms, then %lu ms to the end; "
+           "%lu of %lu bytes sent, %lu connections\n", ranges ? "206" : "200", (long unsigned)duration, (long unsigned)pos,
+           (long unsigned)st->net.rangeRequests, (long unsigned)st->net.rangeSeekMs, (long unsigned)ms, (long unsigned)sent.load(),
+           (long unsigned)size, (long unsigned)server.connections());
+    CHECK(s_eof);
+    CHECK(duration == 60);
+    CHECK(st->net.rangeRequests == 1);
+    CHECK(server.connections() == 2);
+    CHECK(st->net.rangeSeekMs < 500);
+    if(ranges) CHECK(sent < size / 2);                              // the part in front of the position is not sent
+    else CHECK(sent > size);
+    CHECK(out.samples.size() >= tail && out.samples.size() < tail + size / 8); // a little of the start, before the seek
+    CHECK(std::equal(out.samples.end() - tail, out.samples.end(), tone.samples.end() - tail));
+    free(st);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int main() {
+    std::string dir = corpusDir();
+    pcm_t       tone = corpusTone(44100, 2, 60.0f);
+    CHECK(corpusWriteWav(dir + "web.wav", tone));
+    chdir(dir.c_str());
+
+    Audio* audio = new Audio;
+    seek(audio, tone, true);
+    seek(audio, tone, false);
+    delete audio;
+    chdir("..");
+    return TEST_RESULT();
+}
@@ -14,6 +14,8 @@
 #include "mp3_decoder/mp3_decoder.h"
 #include "opus_decoder/opus_decoder.h"
 #include "vorbis_decoder/vorbis_decoder.h"
+#include "audio_codecs.h"
+#include "codec_mem.h"
 
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 AudioBuffer::AudioBuffer(size_t maxBlockSize) {
@@ -44,12 +46,14 @@ size_t AudioBuffer::init() {
         m_buffSize = m_buffSizePSRAM;
         m_buffer = (uint8_t*)ps_calloc(m_buffSize, sizeof(uint8_t));
         m_buffSize = m_buffSizePSRAM - m_resBuffSizePSRAM;
+        m_resBuffSize = m_resBuffSizePSRAM;
     }
     if(m_buffer == NULL) {
         // PSRAM not found, not configured or not enough available
         m_f_psram = false;
         m_buffer = (uint8_t*)heap_caps_calloc(m_buffSizeRAM, sizeof(uint8_t), MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL);
         m_buffSize = m_buffSizeRAM - m_resBuffSizeRAM;
+        m_resBuffSize = m_resBuffSizeRAM;
     }
     if(!m_buffer) return 0;
     m_f_init = true;
@@ -58,78 +62,78 @@ size_t AudioBuffer::init() {
 }
 
 void AudioBuffer::changeMaxBlockSize(uint16_t mbs) {
+    if(mbs > m_resBuffSize && m_f_init) log_w("maxBlockSize %u exceeds the mirrored area %u", mbs, (unsigned)m_resBuffSize);
     m_maxBlockSize = mbs;
     return;
 }
 
 uint16_t AudioBuffer::getMaxBlockSize() { return m_maxBlockSize; }
 
-size_t AudioBuffer::freeSpace() {
-    if(m_readPtr >= m_writePtr) { m_freeSpace = (m_readPtr - m_writePtr); }
-    else { m_freeSpace = (m_endPtr - m_writePtr) + (m_readPtr - m_buffer); }
-    if(m_f_start) m_freeSpace = m_buffSize;
-    return m_freeSpace - 1;
+size_t AudioBuffer::freeSpace() { // producer side
+    if(m_f_start) return m_buffSize - 1;
+    size_t rd = m_readIdx.load(std::memory_order_acquire);
+    size_t wr = m_writeIdx.load(std::memory_order_relaxed);
+    if(rd > wr) return rd - wr - 1;
+    return m_buffSize - wr + rd - 1; // rd == wr: empty
 }
 
-size_t AudioBuffer::writeSpace() {
-    if(m_readPtr >= m_writePtr) {
-        m_writeSpace = (m_readPtr - m_writePtr - 1); // readPtr must not be overtaken
-    }
-    else {
-        if(getReadPos() == 0) m_writeSpace = (m_endPtr - m_writePtr - 1);
-        else m_writeSpace = (m_endPtr - m_writePtr);
-    }
-    if(m_f_start) m_writeSpace = m_buffSize - 1;
-    return m_writeSpace;
+size_t AudioBuffer::writeSpace() { // producer side
+    if(m_f_start) return m_buffSize - 1;
+    size_t rd = m_readIdx.load(std::memory_order_acquire);
+    size_t wr = m_writeIdx.load(std::memory_order_relaxed);
+    if(rd > wr) return rd - wr - 1; // readIdx must not be overtaken
+    if(rd == 0) return m_buffSize - wr - 1;
+    return m_buffSize - wr;
 }
 
-size_t AudioBuffer::bufferFilled() {
-    if(m_writePtr >= m_readPtr) { m_dataLength = (m_writePtr - m_readPtr); }
-    else { m_dataLength = (m_endPtr - m_readPtr) + (m_writePtr - m_buffer); }
-    return m_dataLength;
+size_t AudioBuffer::bufferFilled() { // consumer side
+    size_t wr = m_writeIdx.load(std::memory_order_acquire);
+    size_t rd = m_readIdx.load(std::memory_order_relaxed);
+    if(wr >= rd) return wr - rd;
+    return m_buffSize - rd + wr;
 }
 
-size_t AudioBuffer::getMaxAvailableBytes() {
-    if(m_writePtr >= m_readPtr) { m_dataLength = (m_writePtr - m_readPtr - 1); }
-    else { m_dataLength = (m_endPtr - m_readPtr); }
-    return m_dataLength;
+size_t AudioBuffer::getMaxAvailableBytes() { // consumer side
+    size_t wr = m_writeIdx.load(std::memory_order_acquire);
+    size_t rd = m_readIdx.load(std::memory_order_relaxed);
+    if(wr > rd) return wr - rd - 1;
+    if(wr == rd) return 0;
+    return m_buffSize - rd;
 }
 
 void AudioBuffer::bytesWritten(size_t bw) {
-    m_writePtr += bw;
-    if(m_writePtr == m_endPtr) { m_writePtr = m_buffer; }
+    size_t wr = m_writeIdx.load(std::memory_order_relaxed);
+    if(wr < m_resBuffSize) { // mirror the beginning of the ring behind its end, before the data is published
+        memcpy(m_buffer + m_buffSize + wr, m_buffer + wr, min(bw, m_resBuffSize - wr));
+    }
+    wr += bw;
+    if(wr >= m_buffSize) wr -= m_buffSize;
     if(bw && m_f_start) m_f_start = false;
+    m_writeIdx.store(wr, std::memory_order_release);
 }
 
 void AudioBuffer::bytesWasRead(size_t br) {
-    m_readPtr += br;
-    if(m_readPtr >= m_endPtr) {
-        size_t tmp = m_readPtr - m_endPtr;
-        m_readPtr = m_buffer + tmp;
-    }
+    size_t rd = m_readIdx.load(std::memory_order_relaxed) + br;
+    if(rd >= m_buffSize) rd -= m_buffSize;
+    m_readIdx.store(rd, std::memory_order_release);
 }
 
-uint8_t* AudioBuffer::getWritePtr() { return m_writePtr; }
+uint8_t* AudioBuffer::getWritePtr() { return m_buffer + m_writeIdx.load(std::memory_order_relaxed); }
 
-uint8_t* AudioBuffer::getReadPtr() {
-    size_t len = m_endPtr - m_readPtr;
-    if(len < m_maxBlockSize) {                            // be sure the last frame is completed
-        memcpy(m_endPtr, m_buffer, m_maxBlockSize - len); // cpy from m_buffer to m_endPtr with len
-    }
-    return m_readPtr;
+uint8_t* AudioBuffer::getReadPtr() { // a wrapped frame is completed by the mirror, up to m_resBuffSize bytes
+    return m_buffer + m_readIdx.load(std::memory_order_relaxed);
 }
 
 void AudioBuffer::resetBuffer() {
-    m_writePtr = m_buffer;
-    m_readPtr = m_buffer;
-    m_endPtr = m_buffer + m_buffSize;
+    m_writeIdx = 0;
+    m_readIdx = 0;
     m_f_start = true;
     // memset(m_buffer, 0, m_buffSize); //Clear Inputbuffer
 }
 
-uint32_t AudioBuffer::getWritePos() { return m_writePtr - m_buffer; }
+uint32_t AudioBuffer::getWritePos() { return m_writeIdx.load(std::memory_order_relaxed); }
 
-uint32_t AudioBuffer::getReadPos() { return m_readPtr - m_buffer; }
+uint32_t AudioBuffer::getReadPos() { return m_readIdx.load(std::memory_order_relaxed); }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 // clang-format off
 Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLOT_MODE_STEREO */, uint8_t i2sPort) {
@@ -153,6 +157,9 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_SLO
 
     if(!m_chbuf || !m_lastHost || !m_outBuff || !m_ibuff) log_e("oom");
 
+    // one block for the decoder buffers, taken on the first codec open, see initializeDecoder()
+    CodecArena_Init(AudioCodec_MaxArenaSize());
+
 #define AUDIO_INFO(...)                     \
     {                                       \
         sprintf(m_ibuff, __VA_ARGS__);      \
@@ -236,6 +243,7 @@ Audio::~Audio() {
     // I2Sstop(m_i2s_num);
     // InBuff.~AudioBuffer(); #215 the AudioBuffer is automatically destroyed by the destructor
     setDefaults();
+    closePcmSink();
     if(m_playlistBuff) {
         free(m_playlistBuff);
         m_playlistBuff = NULL;
@@ -250,6 +258,7 @@ Audio::~Audio() {
     if(m_outBuff)     {free(m_outBuff);      m_outBuff      = NULL; }
     if(m_ibuff)       {free(m_ibuff);        m_ibuff        = NULL;}
     if(m_lastM3U8host){free(m_lastM3U8host); m_lastM3U8host = NULL;}
+    if(m_connHost)    {free(m_connHost);     m_connHost     = NULL;}
 
     vSemaphoreDelete(mutex_audio);
 }
@@ -294,29 +303,54 @@ void Audio::setDefaults() {
     stopSong();
     initInBuff(); // initialize InputBuffer if not already done
     InBuff.resetBuffer();
-    MP3Decoder_FreeBuffers();
-    FLACDecoder_FreeBuffers();
-    AACDecoder_FreeBuffers();
-    OPUSDecoder_FreeBuffers();
-    VORBISDecoder_FreeBuffers();
+    AudioCodec_FreeAll();
     if(m_playlistBuff) {
         free(m_playlistBuff);
         m_playlistBuff = NULL;
     } // free if stream is not m3u8
     vector_clear_and_shrink(m_playlistURL);
     vector_clear_and_shrink(m_playlistContent);
+    m_playlistDur.clear();
+    m_playlistDur.shrink_to_fit(); // uint32_t vector
+    hlsVariantsClear();
     m_hashQueue.clear();
     m_hashQueue.shrink_to_fit(); // uint32_t vector
     client.stop();
     clientsecure.stop();
     _client = static_cast<WiFiClient*>(&client); /* default to *something* so that no NULL deref can happen */
-    ts_parsePacket(0, 0, 0);                     // reset ts routine
+    m_switchTime = 0;
+    m_fileStartTime = 0;
+    m_tsDemux.reset();                           // reset ts routine
     if(m_lastM3U8host) {
         free(m_lastM3U8host);
         m_lastM3U8host = NULL;
     }
     AUDIO_INFO("buffers freed, free Heap: %lu bytes", (long unsigned int)ESP.getFreeHeap());
-
+    if(CodecArena_GetSize()) AUDIO_INFO("codec arena: %lu bytes, high-water mark %lu bytes", (long unsigned int)CodecArena_GetSize(),
+                                        (long unsigned int)CodecArena_GetHighWaterMark());
+
+    m_decodeErrorCount = 0;
+    m_resyncCount = 0;
+    m_resyncSkipped = 0;
+    m_headerSkip = 0;
+    m_headerSeekPos = -1;
+    m_webFilePos = 0;
+    m_rangeSkipTo = 0;
+    m_rangeStart = -1;
+    m_rangeTime = 0;
+    m_rangeSeekMs = 0;
+    m_rangeRequests = 0;
+    m_webFileBytes = 0;
+    m_hlsSegments = 0;
+    m_hlsFailed = 0;
+    m_hlsLate = 0;
+    m_hlsWorstLoad = 0;
+    m_hlsHistoryLen = 0;
+    m_hlsSwitches = 0;
+    m_f_acceptRanges = false;
+    m_f_rangeRequest = false;
+    m_coverArtPos = 0;
+    m_coverArtLen = 0;
     m_f_timeout = false;
     m_f_chunked = false; // Assume not chunked
     m_f_firstmetabyte = false;
@@ -358,6 +392,7 @@ void Audio::setDefaults() {
     m_channels = 2;       // assume stereo #209
     m_streamTitleHash = 0;
     m_fileSize = 0;
+    m_oggLastGranule = 0;
     m_ID3Size = 0;
     m_haveNewFilePos = 0;
 }
@@ -441,6 +476,7 @@ bool Audio::openai_speech(const String& api_key, const String& model, const Stri
         uint32_t dt = millis() - t;
         strcpy(m_lastHost, host);
         AUDIO_INFO("%s has been established in %lu ms, free Heap: %lu bytes", "SSL", (long unsigned int) dt, (long unsigned int) ESP.getFreeHeap());
+        connOrigin(host, port);
         m_f_running = true;
     }
 
@@ -469,6 +505,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     // user and pwd for authentification only, can be empty
 
     xSemaphoreTakeRecursive(mutex_audio, portMAX_DELAY);
+    uint32_t switchStart = millis();
 
     if(host == NULL) {
         AUDIO_INFO("Hostaddress is empty");
@@ -519,7 +556,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
         hostwoext[pos_slash] = '\0';
         uint16_t extLen = urlencode_expected_len(h_host + pos_slash);
         extension = (char*)malloc(extLen + 20);
-        memcpy(extension, h_host + pos_slash, extLen);
+        strcpy(extension, h_host + pos_slash); // extLen is the encoded length, the source may be shorter
         urlencode(extension, extLen, true);
     }
     else { // url has no extension
@@ -534,6 +571,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
 
     AUDIO_INFO("Connect to new host: \"%s\"", l_host);
     setDefaults(); // no need to stop clients if connection is established (default is true)
+    m_switchTime = switchStart;
 
     if(startsWith(l_host, "https")) m_f_ssl = true;
     else m_f_ssl = false;
@@ -589,12 +627,24 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     else { _client = static_cast<WiFiClient*>(&client); }
 
     uint32_t t = millis();
+    size_t   buffered = 0;
     if(m_f_Log) AUDIO_INFO("connect to %s on port %d path %s", hostwoext, port, extension);
-    res = _client->connect(hostwoext, port, m_f_ssl ? m_timeout_ms_ssl : m_timeout_ms);
+    m_f_switchWarm = (auth == 0) && m_warmer.take(l_host, &client, &clientsecure, &buffered); // request already sent
+    if(m_f_switchWarm) {
+        AUDIO_INFO("warm connection taken over, %lu bytes received so far", (long unsigned int)buffered);
+        res = true;
+    }
+    else res = _client->connect(hostwoext, port, m_f_ssl ? m_timeout_ms_ssl : m_timeout_ms);
     if(res) {
         uint32_t dt = millis() - t;
         strcpy(m_lastHost, l_host);
         AUDIO_INFO("%s has been established in %lu ms, free Heap: %lu bytes", m_f_ssl ? "SSL" : "Connection", (long unsigned int)dt, (long unsigned int)ESP.getFreeHeap());
+        if(m_f_ssl && !m_f_switchWarm) {
+            const tlsTiming_t& tm = clientsecure.timing();
+            AUDIO_INFO("dns %lu ms, tcp %lu ms, %s handshake %lu ms", (long unsigned int)tm.dnsMs, (long unsigned int)tm.tcpMs,
+                       tm.resumed ? "resumed" : "full", (long unsigned int)tm.tlsMs);
+        }
+        connOrigin(hostwoext, port);
         m_f_running = true;
     }
 
@@ -603,7 +653,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
 
     if(res) {
     //    log_i("connecttohost(): %s", rqh);
-        _client->print(rqh);
+        if(!m_f_switchWarm) _client->print(rqh);
         if(endsWith(extension, ".mp3" )) m_expectedCodec  = CODEC_MP3;
         if(endsWith(extension, ".aac" )) m_expectedCodec  = CODEC_AAC;
         if(endsWith(extension, ".wav" )) m_expectedCodec  = CODEC_WAV;
@@ -651,8 +701,33 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     return res;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-bool Audio::httpPrint(const char* host) {
-    // user and pwd for authentification only, can be empty
+bool Audio::preconnect(const char* const* hosts, uint8_t n) {
+    // e.g. the previous and the next station of a list: m_warmer keeps them connected with the first bytes of their
+    // response, connecttohost() of one of them plays at once. Called again after each station change
+    if(AUDIO_WARM_STATIONS == 0 || !n || !m_f_psramFound) {
+        m_warmer.end();
+        return false;
+    }
+    if(!m_warmer.isActive() && !m_warmer.begin()) return false;
+    n = min(n, (uint8_t)AUDIO_WARM_STATIONS);
+    char* urls[AUDIO_WARM_STATIONS];
+    for(int i = 0; i < n; i++) { // the same form as l_host in connecttohost()
+        int idx = indexOf(hosts[i], "http");
+        urls[i] = (char*)malloc(strlen(hosts[i]) + 10);
+        if(!urls[i]) { n = i; break; }
+        if(idx < 0) {
+            strcpy(urls[i], "http://");
+            strcat(urls[i], hosts[i]);
+        }
+        else { strcpy(urls[i], hosts[i] + idx); }
+    }
+    m_warmer.warm(urls, n);
+    for(int i = 0; i < n; i++) free(urls[i]);
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::httpPrint(const char* host, int32_t rangeStart) {
+    // rangeStart >= 0: the current web file is requested again from this byte on
 
     if(host == NULL) {
         AUDIO_INFO("Hostaddress is empty");
@@ -688,7 +763,7 @@ bool Audio::httpPrint(const char* host) {
         hostwoext[pos_slash] = '\0';
         uint16_t extLen = urlencode_expected_len(h_host + pos_slash);
         extension = (char*)malloc(extLen + 20);
-        memcpy(extension, h_host + pos_slash, extLen);
+        strcpy(extension, h_host + pos_slash); // extLen is the encoded length, the source may be shorter
         urlencode(extension, extLen, true);
     }
     else { // url has no extension
@@ -713,6 +788,7 @@ bool Audio::httpPrint(const char* host) {
     strcat(rqh, hostwoext);
     strcat(rqh, "\r\n");
     strcat(rqh, "Accept-Encoding: identity;q=1,*;q=0\r\n");
+    if(rangeStart >= 0) sprintf(rqh + strlen(rqh), "Range: bytes=%li-\r\n", (long)rangeStart);
     //    strcat(rqh, "User-Agent: Mozilla/5.0\r\n"); #363
     strcat(rqh, "Connection: keep-alive\r\n\r\n");
 
@@ -721,14 +797,33 @@ bool Audio::httpPrint(const char* host) {
         if(port == 80) port = 443;
     }
     else { _client = static_cast<WiFiClient*>(&client); }
-    if(!_client->connected()) {
-        AUDIO_INFO("The host has disconnected, reconnecting");
-        if(!_client->connect(hostwoext, port)) {
+    // the open connection is reused for the same origin (HTTP/1.1 keep-alive), a playlist and its segments or the
+    // master and the media playlist of HLS usually come from one host. Only if the last body has been read to its
+    // Content-Length and nothing follows it: the rest of a stream, a chunked body or an unread error page would be
+    // taken as the next response
+    bool sameOrigin = m_connHost && !strcmp(m_connHost, hostwoext) && m_connPort == port && m_f_connSsl == m_f_ssl;
+    bool bodyRead = m_f_bodyRead && !m_httpParser.rxAvailable() && !_client->available();
+    if(!sameOrigin || m_f_connClose || !bodyRead || !_client->connected()) {
+        if(sameOrigin && !bodyRead) { AUDIO_INFO("the last response is not read completely, reconnecting"); }
+        else if(sameOrigin) { AUDIO_INFO("The host has disconnected, reconnecting"); }
+        else if(m_connHost) { AUDIO_INFO("new origin %s:%u, reconnecting", hostwoext, port); }
+        client.stop();
+        clientsecure.stop();
+        uint32_t t = millis();
+        if(!_client->connect(hostwoext, port, m_f_ssl ? m_timeout_ms_ssl : m_timeout_ms)) {
             log_e("connection lost");
+            connOrigin(NULL, 0);
             stopSong();
             return false;
         }
+        if(m_f_ssl) {
+            const tlsTiming_t& tm = clientsecure.timing();
+            AUDIO_INFO("SSL has been established in %lu ms (dns %lu, tcp %lu, %s handshake %lu)", (long unsigned int)(millis() - t),
+                       (long unsigned int)tm.dnsMs, (long unsigned int)tm.tcpMs, tm.resumed ? "resumed" : "full", (long unsigned int)tm.tlsMs);
+        }
+        connOrigin(hostwoext, port);
     }
+    m_f_connClose = false;
     _client->print(rqh);
     if(endsWith(extension, ".mp3"))       m_expectedCodec  = CODEC_MP3;
     if(endsWith(extension, ".aac"))       m_expectedCodec  = CODEC_AAC;
@@ -741,8 +836,12 @@ bool Audio::httpPrint(const char* host) {
     if(endsWith(extension, ".pls"))       m_expectedPlsFmt = FORMAT_PLS;
 
     setDatamode(HTTP_RESPONSE_HEADER); // Handle header
-    m_streamType = ST_WEBSTREAM;
-    m_contentlength = 0;
+    if(rangeStart < 0) { // a new resource, a range request continues the current web file
+        m_streamType = ST_WEBSTREAM;
+        m_contentlength = 0;
+        m_webFilePos = 0;
+        m_f_rangeRequest = false;
+    }
     m_f_chunked = false;
 
     if(hostwoext) {
@@ -760,6 +859,18 @@ bool Audio::httpPrint(const char* host) {
     return true;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::connOrigin(const char* host, uint16_t port) {
+    // where the open connection goes, host NULL: nowhere httpPrint() could send the next request to
+    if(m_connHost) {
+        free(m_connHost);
+        m_connHost = NULL;
+    }
+    if(host) m_connHost = strdup(host);
+    m_connPort = port;
+    m_f_connSsl = m_f_ssl;
+    m_f_connClose = false;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::setFileLoop(bool input) {
     if(m_codec == CODEC_M4A) return 0;
     m_f_loop = input;
@@ -813,6 +924,8 @@ bool Audio::connecttoFS(fs::FS& fs, const char* path, int32_t fileStartPos) {
 
     m_fileStartPos = fileStartPos;
     setDefaults(); // free buffers an set defaults
+    m_fileStartTime = millis();
+    m_firstAudioMs = 0;
 
     char *audioPath = (char *) __malloc_heap_psram(strlen(path) + 2);
     if(!audioPath){
@@ -867,11 +980,16 @@ bool Audio::connecttoFS(fs::FS& fs, const char* path, int32_t fileStartPos) {
         free(afn);
         afn = NULL;
     }
-    free(audioPath);
+
+    if(m_codec == CODEC_OPUS || m_codec == CODEC_OGG) m_oggLastGranule = ogg_readLastGranule(); // exact duration
 
     bool ret = initializeDecoder();
     if(ret) m_f_running = true;
     else audiofile.close();
+#if AUDIO_FILE_READER
+    if(ret && !m_fileReader.begin(fs, audioPath, audiofile.position())) AUDIO_INFO("file reader task not available, read in loop()");
+#endif
+    free(audioPath);
     xSemaphoreGiveRecursive(mutex_audio);
     return ret;
 }
@@ -917,6 +1035,7 @@ bool Audio::connecttospeech(const char* speech, const char* lang) {
         speechBuff = NULL;
     }
     _client = static_cast<WiFiClient*>(&client);
+    connOrigin(NULL, 0); // "Connection: close"
     if(!_client->connect(host, 80)) {
         log_e("Connection failed");
         xSemaphoreGiveRecursive(mutex_audio);
@@ -1288,27 +1407,23 @@ size_t Audio::readAudioHeader(uint32_t bytes) {
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int Audio::read_WAV_Header(uint8_t* data, size_t len) {
-    static size_t   headerSize;
-    static uint32_t cs = 0;
-    static uint8_t  bts = 0;
-
     if(m_controlCounter == 0) {
         m_controlCounter++;
         if((*data != 'R') || (*(data + 1) != 'I') || (*(data + 2) != 'F') || (*(data + 3) != 'F')) {
             AUDIO_INFO("file has no RIFF tag");
-            headerSize = 0;
+            m_wavHdr.headerSize = 0;
             return -1; // false;
         }
         else {
-            headerSize = 4;
+            m_wavHdr.headerSize = 4;
             return 4; // ok
         }
     }
 
     if(m_controlCounter == 1) {
         m_controlCounter++;
-        cs = (uint32_t)(*data + (*(data + 1) << 8) + (*(data + 2) << 16) + (*(data + 3) << 24) - 8);
-        headerSize += 4;
+        m_wavHdr.cs = (uint32_t)(*data + (*(data + 1) << 8) + (*(data + 2) << 16) + (*(data + 3) << 24) - 8);
+        m_wavHdr.headerSize += 4;
         return 4; // ok
     }
 
@@ -1319,7 +1434,7 @@ int Audio::read_WAV_Header(uint8_t* data, size_t len) {
             return -1; // false;
         }
         else {
-            headerSize += 4;
+            m_wavHdr.headerSize += 4;
             return 4;
         }
     }
@@ -1327,24 +1442,32 @@ int Audio::read_WAV_Header(uint8_t* data, size_t len) {
     if(m_controlCounter == 3) {
         if((*data == 'f') && (*(data + 1) == 'm') && (*(data + 2) == 't')) {
             m_controlCounter++;
-            headerSize += 4;
+            m_wavHdr.headerSize += 4;
             return 4;
         }
         else {
-            headerSize += 4;
+            m_wavHdr.headerSize += 4;
             return 4;
         }
     }
 
     if(m_controlCounter == 4) {
         m_controlCounter++;
-        cs = (uint32_t)(*data + (*(data + 1) << 8));
-        if(cs > 40) return -1; // false, something going wrong
-        bts = cs - 16;         // bytes to skip if fmt chunk is >16
-        headerSize += 4;
+        m_wavHdr.cs = (uint32_t)(*data + (*(data + 1) << 8));
+        if(m_wavHdr.cs > 40) return -1; // false, something going wrong
+        m_wavHdr.bts = m_wavHdr.cs - 16;         // bytes to skip if fmt chunk is >16
+        m_wavHdr.headerSize += 4;
         return 4;
     }
 
+    auto formatOk = [&](uint16_t fc, uint16_t bps) { // lambda, PCM 8/16/24/32 bit, float 32/64 bit
+        if(fc == WAVE_FORMAT_PCM && (bps == 8 || bps == 16 || bps == 24 || bps == 32)) return true;
+        if(fc == WAVE_FORMAT_IEEE_FLOAT && (bps == 32 || bps == 64)) return true;
+        AUDIO_INFO("format code %u with %u bits per sample is not supported", fc, bps);
+        stopSong();
+        return false;
+    };
+
     if(m_controlCounter == 5) {
         m_controlCounter++;
         uint16_t fc = (uint16_t)(*(data + 0) + (*(data + 1) << 8));                                               // Format code
@@ -1361,45 +1484,47 @@ int Audio::read_WAV_Header(uint8_t* data, size_t len) {
         AUDIO_INFO("DataBlockSize: %u", dbs);
         AUDIO_INFO("BitsPerSample: %u", bps);
 
-        if((bps != 8) && (bps != 16)) {
-            AUDIO_INFO("BitsPerSample is %u,  must be 8 or 16", bps);
-            stopSong();
-            return -1;
-        }
         if((nic != 1) && (nic != 2)) {
             AUDIO_INFO("num channels is %u,  must be 1 or 2", nic);
             stopSong();
             return -1;
         }
-        if(fc != 1) {
-            AUDIO_INFO("format code is not 1 (PCM)");
-            stopSong();
-            return -1; // false;
+        m_wavFormat = fc;
+        m_wavBytesPerSample = bps / 8;
+        if(fc == WAVE_FORMAT_EXTENSIBLE) {
+            if(m_wavHdr.bts < 24) { AUDIO_INFO("WAVE_FORMAT_EXTENSIBLE without subformat"); stopSong(); return -1; }
         }
-        setBitsPerSample(bps);
+        else if(!formatOk(fc, bps)) return -1;
+        setBitsPerSample(bps == 8 ? 8 : 16); // 24/32 bit and float are converted to 16 bit in wavToPCM16()
         setChannels(nic);
         setSampleRate(sr);
         setBitrate(nic * sr * bps);
         //    AUDIO_INFO("BitRate: %u", m_bitRate);
-        headerSize += 16;
+        m_wavHdr.headerSize += 16;
         return 16; // ok
     }
 
     if(m_controlCounter == 6) {
         m_controlCounter++;
-        headerSize += bts;
-        return bts; // skip to data
+        if(m_wavFormat == WAVE_FORMAT_EXTENSIBLE) { // cbSize, validBitsPerSample, channelMask, subformat GUID
+            uint16_t sfc = (uint16_t)(*(data + 8) + (*(data + 9) << 8)); // first two bytes of the GUID are the format code
+            AUDIO_INFO("WAVE_FORMAT_EXTENSIBLE, subformat %u", sfc);
+            if(!formatOk(sfc, m_wavBytesPerSample * 8)) return -1;
+            m_wavFormat = sfc;
+        }
+        m_wavHdr.headerSize += m_wavHdr.bts;
+        return m_wavHdr.bts; // skip to data
     }
 
     if(m_controlCounter == 7) {
         if((*(data + 0) == 'd') && (*(data + 1) == 'a') && (*(data + 2) == 't') && (*(data + 3) == 'a')) {
             m_controlCounter++;
             //    vTaskDelay(30);
-            headerSize += 4;
+            m_wavHdr.headerSize += 4;
             return 4;
         }
         else {
-            headerSize++;
+            m_wavHdr.headerSize++;
             return 1;
         }
     }
@@ -1407,49 +1532,48 @@ int Audio::read_WAV_Header(uint8_t* data, size_t len) {
     if(m_controlCounter == 8) {
         m_controlCounter++;
         size_t cs = *(data + 0) + (*(data + 1) << 8) + (*(data + 2) << 16) + (*(data + 3) << 24); // read chunkSize
-        headerSize += 4;
+        m_wavHdr.headerSize += 4;
         if(getDatamode() == AUDIO_LOCALFILE) m_contentlength = getFileSize();
-        if(cs) { m_audioDataSize = cs - 44; }
+        if(cs) { m_audioDataSize = cs; }
         else { // sometimes there is nothing here
-            if(getDatamode() == AUDIO_LOCALFILE) m_audioDataSize = getFileSize() - headerSize;
-            if(m_streamType == ST_WEBFILE) m_audioDataSize = m_contentlength - headerSize;
+            if(getDatamode() == AUDIO_LOCALFILE) m_audioDataSize = getFileSize() - m_wavHdr.headerSize;
+            if(m_streamType == ST_WEBFILE) m_audioDataSize = m_contentlength - m_wavHdr.headerSize;
         }
         AUDIO_INFO("Audio-Length: %u", m_audioDataSize);
         return 4;
     }
     m_controlCounter = 100; // header succesfully read
-    m_audioDataStart = headerSize;
+    m_audioDataStart = m_wavHdr.headerSize;
     return 0;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
-    static size_t   headerSize;
-    static size_t   retvalue = 0;
-    static bool     f_lastMetaBlock = false;
-    static uint32_t picPos = 0;
-    static uint32_t picLen = 0;
-
-    if(retvalue) {
-        if(retvalue > len) { // if returnvalue > bufferfillsize
+    if(m_flacHdr.retvalue) {
+        if(m_flacHdr.retvalue > len && headerCanSkip(m_flacHdr.retvalue)) { // picture, padding: one seek instead of reading it
+            m_headerSkip = m_flacHdr.retvalue;
+            m_flacHdr.retvalue = 0;
+            return 0;
+        }
+        if(m_flacHdr.retvalue > len) { // if returnvalue > bufferfillsize
             if(len > InBuff.getMaxBlockSize()) len = InBuff.getMaxBlockSize();
-            retvalue -= len; // and wait for more bufferdata
+            m_flacHdr.retvalue -= len; // and wait for more bufferdata
             return len;
         }
         else {
-            size_t tmp = retvalue;
-            retvalue = 0;
+            size_t tmp = m_flacHdr.retvalue;
+            m_flacHdr.retvalue = 0;
             return tmp;
         }
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_BEGIN) { // init
-        headerSize = 0;
-        retvalue = 0;
+        m_flacHdr.headerSize = 0;
+        m_flacHdr.retvalue = 0;
         m_audioDataStart = 0;
-        picPos = 0;
-        picLen = 0;
-        f_lastMetaBlock = false;
+        m_flacHdr.picPos = 0;
+        m_flacHdr.picLen = 0;
+        m_flacHdr.f_lastMetaBlock = false;
         m_controlCounter = FLAC_MAGIC;
         if(getDatamode() == AUDIO_LOCALFILE) {
             m_contentlength = getFileSize();
@@ -1460,8 +1584,8 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_MAGIC) {            /* check MAGIC STRING */
         if(specialIndexOf(data, "OggS", 10) == 0) { // is ogg
-            headerSize = 0;
-            retvalue = 0;
+            m_flacHdr.headerSize = 0;
+            m_flacHdr.retvalue = 0;
             m_controlCounter = FLAC_OKAY;
             return 0;
         }
@@ -1471,15 +1595,15 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
             return -1;
         }
         m_controlCounter = FLAC_MBH; // METADATA_BLOCK_HEADER
-        headerSize = 4;
-        retvalue = 4;
+        m_flacHdr.headerSize = 4;
+        m_flacHdr.retvalue = 4;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_MBH) { /* METADATA_BLOCK_HEADER */
         uint8_t blockType = *data;
-        if(!f_lastMetaBlock) {
-            if(blockType & 128) { f_lastMetaBlock = true; }
+        if(!m_flacHdr.f_lastMetaBlock) {
+            if(blockType & 128) { m_flacHdr.f_lastMetaBlock = true; }
             blockType &= 127;
             if(blockType == 0) m_controlCounter = FLAC_SINFO;
             if(blockType == 1) m_controlCounter = FLAC_PADDING;
@@ -1488,21 +1612,27 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
             if(blockType == 4) m_controlCounter = FLAC_VORBIS;
             if(blockType == 5) m_controlCounter = FLAC_CUESHEET;
             if(blockType == 6) m_controlCounter = FLAC_PICTURE;
-            headerSize += 1;
-            retvalue = 1;
+            m_flacHdr.headerSize += 1;
+            m_flacHdr.retvalue = 1;
             return 0;
         }
         m_controlCounter = FLAC_OKAY;
-        m_audioDataStart = headerSize;
+        m_audioDataStart = m_flacHdr.headerSize;
         m_audioDataSize = m_contentlength - m_audioDataStart;
-        FLACSetRawBlockParams(m_flacNumChannels, m_flacSampleRate, m_flacBitsPerSample, m_flacTotalSamplesInStream, m_audioDataSize);
-        if(picLen) {
+#if AUDIO_CODEC_FLAC
+        FLACSetRawBlockParams(FLACDecoder_Default(), m_flacNumChannels, m_flacSampleRate, m_flacBitsPerSample, m_flacTotalSamplesInStream, m_audioDataSize);
+#endif
+        if(m_flacHdr.picLen && getDatamode() == AUDIO_LOCALFILE) {
+            m_coverArtPos = m_flacHdr.picPos;
+            m_coverArtLen = m_flacHdr.picLen;
+        }
+        if(m_flacHdr.picLen) {
             size_t pos = audiofile.position();
-            if(audio_id3image) audio_id3image(audiofile, picPos, picLen);
+            if(audio_id3image) audio_id3image(audiofile, m_flacHdr.picPos, m_flacHdr.picLen);
             audiofile.seek(pos); // the filepointer could have been changed by the user, set it back
         }
         AUDIO_INFO("Audio-Length: %u", m_audioDataSize);
-        retvalue = 0;
+        m_flacHdr.retvalue = 0;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1543,32 +1673,32 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
         else { AUDIO_INFO("total samples in stream: N/A"); }
         if(bps != 0 && m_flacTotalSamplesInStream) { AUDIO_INFO("audio file duration: %lu seconds", (long unsigned int)m_flacTotalSamplesInStream / (long unsigned int)m_flacSampleRate); }
         m_controlCounter = FLAC_MBH; // METADATA_BLOCK_HEADER
-        retvalue = l + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = l + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_PADDING) { /* PADDING */
         size_t l = bigEndian(data, 3);
         m_controlCounter = FLAC_MBH;
-        retvalue = l + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = l + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_APP) { /* APPLICATION */
         size_t l = bigEndian(data, 3);
         m_controlCounter = FLAC_MBH;
-        retvalue = l + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = l + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_SEEK) { /* SEEKTABLE */
         size_t l = bigEndian(data, 3);
         m_controlCounter = FLAC_MBH;
-        retvalue = l + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = l + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1600,67 +1730,51 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
             if(idx > vendorLength + 3) {log_e("VORBIS COMMENT section is too long");}
         }
         m_controlCounter = FLAC_MBH;
-        retvalue = vendorLength + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = vendorLength + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_CUESHEET) { /* CUESHEET */
         size_t l = bigEndian(data, 3);
         m_controlCounter = FLAC_MBH;
-        retvalue = l + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = l + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_PICTURE) { /* PICTURE */
-        picLen = bigEndian(data, 3);
-        picPos = headerSize;
+        m_flacHdr.picLen = bigEndian(data, 3);
+        m_flacHdr.picPos = m_flacHdr.headerSize + 3; // behind the block length
         // log_w("FLAC PICTURE, size %i, pos %i", picLen, picPos);
         m_controlCounter = FLAC_MBH;
-        retvalue = picLen + 3;
-        headerSize += retvalue;
+        m_flacHdr.retvalue = m_flacHdr.picLen + 3;
+        m_flacHdr.headerSize += m_flacHdr.retvalue;
         return 0;
     }
     return 0;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int Audio::read_ID3_Header(uint8_t* data, size_t len) {
-    static size_t   id3Size;
-    static size_t   totalId3Size; // if we have more header, id3_1_size + id3_2_size + ....
-    static size_t   remainingHeaderBytes;
-    static size_t   universal_tmp = 0;
-    static uint8_t  ID3version;
-    static int      ehsz = 0;
-    static char     tag[5];
-    static char     frameid[5];
-    static size_t   framesize = 0;
-    static bool     compressed = false;
-    static size_t   APIC_size[3] = {0};
-    static uint32_t APIC_pos[3] = {0};
-    static bool     SYLT_seen = false;
-    static size_t   SYLT_size = 0;
-    static uint32_t SYLT_pos = 0;
-    static uint8_t  numID3Header = 0;
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 0) { /* read ID3 tag and ID3 header size */
         if(getDatamode() == AUDIO_LOCALFILE) {
-            ID3version = 0;
+            m_id3Hdr.ID3version = 0;
             m_contentlength = getFileSize();
             AUDIO_INFO("Content-Length: %lu", (long unsigned int)m_contentlength);
         }
         m_controlCounter++;
-        SYLT_seen = false;
-        remainingHeaderBytes = 0;
-        ehsz = 0;
+        m_id3Hdr.SYLT_seen = false;
+        m_id3Hdr.remainingHeaderBytes = 0;
+        m_id3Hdr.ehsz = 0;
         if(specialIndexOf(data, "ID3", 4) != 0) { // ID3 not found
             if(!m_f_m3u8data) AUDIO_INFO("file has no mp3 tag, skip metadata");
             m_audioDataSize = m_contentlength;
             if(!m_f_m3u8data) AUDIO_INFO("Audio-Length: %u", m_audioDataSize);
             return -1; // error, no ID3 signature found
         }
-        ID3version = *(data + 3);
-        switch(ID3version) {
+        m_id3Hdr.ID3version = *(data + 3);
+        switch(m_id3Hdr.ID3version) {
             case 2:
                 m_f_unsync = (*(data + 5) & 0x80);
                 m_f_exthdr = false;
@@ -1671,17 +1785,17 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
                 m_f_exthdr = (*(data + 5) & 0x40); // bit6 extended header
                 break;
         };
-        id3Size = bigEndian(data + 6, 4, 7); //  ID3v2 size  4 * %0xxxxxxx (shift left seven times!!)
-        id3Size += 10;
+        m_id3Hdr.id3Size = bigEndian(data + 6, 4, 7); //  ID3v2 size  4 * %0xxxxxxx (shift left seven times!!)
+        m_id3Hdr.id3Size += 10;
 
         // Every read from now may be unsync'd
-        if(!m_f_m3u8data) AUDIO_INFO("ID3 framesSize: %i", id3Size);
-        if(!m_f_m3u8data) AUDIO_INFO("ID3 version: 2.%i", ID3version);
+        if(!m_f_m3u8data) AUDIO_INFO("ID3 framesSize: %i", m_id3Hdr.id3Size);
+        if(!m_f_m3u8data) AUDIO_INFO("ID3 version: 2.%i", m_id3Hdr.ID3version);
 
-        if(ID3version == 2) { m_controlCounter = 10; }
-        remainingHeaderBytes = id3Size;
-        m_ID3Size = id3Size;
-        remainingHeaderBytes -= 10;
+        if(m_id3Hdr.ID3version == 2) { m_controlCounter = 10; }
+        m_id3Hdr.remainingHeaderBytes = m_id3Hdr.id3Size;
+        m_ID3Size = m_id3Hdr.id3Size;
+        m_id3Hdr.remainingHeaderBytes -= 10;
 
         return 10;
     }
@@ -1690,9 +1804,9 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
         m_controlCounter++;
         if(m_f_exthdr) {
             AUDIO_INFO("ID3 extended header");
-            ehsz = bigEndian(data, 4);
-            remainingHeaderBytes -= 4;
-            ehsz -= 4;
+            m_id3Hdr.ehsz = bigEndian(data, 4);
+            m_id3Hdr.remainingHeaderBytes -= 4;
+            m_id3Hdr.ehsz -= 4;
             return 4;
         }
         else {
@@ -1702,33 +1816,33 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 2) { // skip extended header if exists
-        if(ehsz > len) {
-            ehsz -= len;
-            remainingHeaderBytes -= len;
+        if(m_id3Hdr.ehsz > len) {
+            m_id3Hdr.ehsz -= len;
+            m_id3Hdr.remainingHeaderBytes -= len;
             return len;
         } // Throw it away
         else {
             m_controlCounter++;
-            remainingHeaderBytes -= ehsz;
-            return ehsz;
+            m_id3Hdr.remainingHeaderBytes -= m_id3Hdr.ehsz;
+            return m_id3Hdr.ehsz;
         } // Throw it away
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 3) { // read a ID3 frame, get the tag
-        if(remainingHeaderBytes == 0) {
+        if(m_id3Hdr.remainingHeaderBytes == 0) {
             m_controlCounter = 99;
             return 0;
         }
         m_controlCounter++;
-        frameid[0] = *(data + 0);
-        frameid[1] = *(data + 1);
-        frameid[2] = *(data + 2);
-        frameid[3] = *(data + 3);
-        frameid[4] = 0;
-        for(uint8_t i = 0; i < 4; i++) tag[i] = frameid[i]; // tag = frameid
-
-        remainingHeaderBytes -= 4;
-        if(frameid[0] == 0 && frameid[1] == 0 && frameid[2] == 0 && frameid[3] == 0) {
+        m_id3Hdr.frameid[0] = *(data + 0);
+        m_id3Hdr.frameid[1] = *(data + 1);
+        m_id3Hdr.frameid[2] = *(data + 2);
+        m_id3Hdr.frameid[3] = *(data + 3);
+        m_id3Hdr.frameid[4] = 0;
+        for(uint8_t i = 0; i < 4; i++) m_id3Hdr.tag[i] = m_id3Hdr.frameid[i]; // tag = frameid
+
+        m_id3Hdr.remainingHeaderBytes -= 4;
+        if(m_id3Hdr.frameid[0] == 0 && m_id3Hdr.frameid[1] == 0 && m_id3Hdr.frameid[2] == 0 && m_id3Hdr.frameid[3] == 0) {
             // We're in padding
             m_controlCounter = 98; // all ID3 metadata processed
         }
@@ -1738,24 +1852,24 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
     if(m_controlCounter == 4) { // get the frame size
         m_controlCounter = 6;
 
-        if(ID3version == 4) {
-            framesize = bigEndian(data, 4, 7); // << 7
+        if(m_id3Hdr.ID3version == 4) {
+            m_id3Hdr.framesize = bigEndian(data, 4, 7); // << 7
         }
         else {
-            framesize = bigEndian(data, 4); // << 8
+            m_id3Hdr.framesize = bigEndian(data, 4); // << 8
         }
-        remainingHeaderBytes -= 4;
+        m_id3Hdr.remainingHeaderBytes -= 4;
         uint8_t flag = *(data + 4); // skip 1st flag
         (void)flag;
-        remainingHeaderBytes--;
-        compressed = (*(data + 5)) & 0x80; // Frame is compressed using [#ZLIB zlib] with 4 bytes for 'decompressed
+        m_id3Hdr.remainingHeaderBytes--;
+        m_id3Hdr.compressed = (*(data + 5)) & 0x80; // Frame is compressed using [#ZLIB zlib] with 4 bytes for 'decompressed
                                            // size' appended to the frame header.
-        remainingHeaderBytes--;
+        m_id3Hdr.remainingHeaderBytes--;
         uint32_t decompsize = 0;
-        if(compressed) {
+        if(m_id3Hdr.compressed) {
             if(m_f_Log) log_i("iscompressed");
             decompsize = bigEndian(data + 6, 4);
-            remainingHeaderBytes -= 4;
+            m_id3Hdr.remainingHeaderBytes -= 4;
             (void)decompsize;
             if(m_f_Log) log_i("decompsize=%u", decompsize);
             return 6 + 4;
@@ -1764,15 +1878,21 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 5) { // If the frame is larger than 512 bytes, skip the rest
-        if(framesize > len) {
-            framesize -= len;
-            remainingHeaderBytes -= len;
+        if(m_id3Hdr.framesize > len && headerCanSkip(m_id3Hdr.framesize)) { // APIC, SYLT...: one seek instead of reading it
+            m_headerSkip = m_id3Hdr.framesize;
+            m_id3Hdr.remainingHeaderBytes -= m_id3Hdr.framesize;
+            m_controlCounter = 3; // check next frame
+            return 0;
+        }
+        if(m_id3Hdr.framesize > len) {
+            m_id3Hdr.framesize -= len;
+            m_id3Hdr.remainingHeaderBytes -= len;
             return len;
         }
         else {
             m_controlCounter = 3; // check next frame
-            remainingHeaderBytes -= framesize;
-            return framesize;
+            m_id3Hdr.remainingHeaderBytes -= m_id3Hdr.framesize;
+            return m_id3Hdr.framesize;
         }
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1785,31 +1905,31 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
         // $03 – UTF-8 encoded Unicode, in ID3v2.4.
         bool isUnicode = (ch == 1) ? true : false;
 
-        if(startsWith(tag, "APIC")) { // a image embedded in file, passing it to external function
+        if(startsWith(m_id3Hdr.tag, "APIC")) { // a image embedded in file, passing it to external function
             isUnicode = false;
             if(getDatamode() == AUDIO_LOCALFILE) {
-                APIC_pos[numID3Header] = totalId3Size + id3Size - remainingHeaderBytes;
-                APIC_size[numID3Header] = framesize;
+                m_id3Hdr.APIC_pos[m_id3Hdr.numID3Header] = m_id3Hdr.totalId3Size + m_id3Hdr.id3Size - m_id3Hdr.remainingHeaderBytes;
+                m_id3Hdr.APIC_size[m_id3Hdr.numID3Header] = m_id3Hdr.framesize;
                 //    log_e("APIC_pos %i APIC_size %i", APIC_pos[numID3Header], APIC_size[numID3Header]);
             }
             return 0;
         }
 
         if( // any lyrics embedded in file, passing it to external function
-            startsWith(tag, "SYLT") || startsWith(tag, "TXXX") || startsWith(tag, "USLT")) {
+            startsWith(m_id3Hdr.tag, "SYLT") || startsWith(m_id3Hdr.tag, "TXXX") || startsWith(m_id3Hdr.tag, "USLT")) {
             if(getDatamode() == AUDIO_LOCALFILE) {
-                SYLT_seen = true;
-                SYLT_pos = id3Size - remainingHeaderBytes;
-                SYLT_size = framesize;
+                m_id3Hdr.SYLT_seen = true;
+                m_id3Hdr.SYLT_pos = m_id3Hdr.id3Size - m_id3Hdr.remainingHeaderBytes;
+                m_id3Hdr.SYLT_size = m_id3Hdr.framesize;
             }
             return 0;
         }
 
-        size_t fs = framesize;
+        size_t fs = m_id3Hdr.framesize;
         if(fs > 1024) fs = 1024;
         for(int i = 0; i < fs; i++) { m_ibuff[i] = *(data + i); }
-        framesize -= fs;
-        remainingHeaderBytes -= fs;
+        m_id3Hdr.framesize -= fs;
+        m_id3Hdr.remainingHeaderBytes -= fs;
         m_ibuff[fs] = 0;
 
         if(isUnicode && fs > 1) {
@@ -1828,7 +1948,7 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
             m_ibuff[k] = '\0'; // new termination
             latinToUTF8(m_ibuff, m_ibuffSize, false);
         }
-        showID3Tag(tag, m_ibuff);
+        showID3Tag(m_id3Hdr.tag, m_ibuff);
         return fs;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1837,53 +1957,58 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
     // see https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.2.html
     if(m_controlCounter == 10) { // frames in V2.2, 3bytes identifier, 3bytes size descriptor
 
-        if(universal_tmp > 0) {
-            if(universal_tmp > 256) {
-                universal_tmp -= 256;
+        if(m_id3Hdr.universal_tmp > 0) {
+            if(m_id3Hdr.universal_tmp > 256 && headerCanSkip(m_id3Hdr.universal_tmp)) { // PIC: one seek instead of reading it
+                m_headerSkip = m_id3Hdr.universal_tmp;
+                m_id3Hdr.universal_tmp = 0;
+                return 0;
+            }
+            if(m_id3Hdr.universal_tmp > 256) {
+                m_id3Hdr.universal_tmp -= 256;
                 return 256;
             }
             else {
-                uint8_t t = universal_tmp;
-                universal_tmp = 0;
+                uint8_t t = m_id3Hdr.universal_tmp;
+                m_id3Hdr.universal_tmp = 0;
                 return t;
             }
         }
 
-        frameid[0] = *(data + 0);
-        frameid[1] = *(data + 1);
-        frameid[2] = *(data + 2);
-        frameid[3] = 0;
-        for(uint8_t i = 0; i < 4; i++) tag[i] = frameid[i]; // tag = frameid
-        remainingHeaderBytes -= 3;
+        m_id3Hdr.frameid[0] = *(data + 0);
+        m_id3Hdr.frameid[1] = *(data + 1);
+        m_id3Hdr.frameid[2] = *(data + 2);
+        m_id3Hdr.frameid[3] = 0;
+        for(uint8_t i = 0; i < 4; i++) m_id3Hdr.tag[i] = m_id3Hdr.frameid[i]; // tag = frameid
+        m_id3Hdr.remainingHeaderBytes -= 3;
         size_t dataLen = bigEndian(data + 3, 3);
-        universal_tmp = dataLen;
-        remainingHeaderBytes -= 3;
+        m_id3Hdr.universal_tmp = dataLen;
+        m_id3Hdr.remainingHeaderBytes -= 3;
         char value[256];
         if(dataLen > 249) { dataLen = 249; }
         memcpy(value, (data + 7), dataLen);
         value[dataLen + 1] = 0;
         m_chbuf[0] = 0;
-        if(startsWith(tag, "PIC")) { // image embedded in header
+        if(startsWith(m_id3Hdr.tag, "PIC")) { // image embedded in header
             if(getDatamode() == AUDIO_LOCALFILE) {
-                APIC_pos[numID3Header] = id3Size - remainingHeaderBytes;
-                APIC_size[numID3Header] = universal_tmp;
-                if(m_f_Log) log_i("Attached picture seen at pos %d length %d", APIC_pos[0], APIC_size[0]);
+                m_id3Hdr.APIC_pos[m_id3Hdr.numID3Header] = m_id3Hdr.id3Size - m_id3Hdr.remainingHeaderBytes;
+                m_id3Hdr.APIC_size[m_id3Hdr.numID3Header] = m_id3Hdr.universal_tmp;
+                if(m_f_Log) log_i("Attached picture seen at pos %d length %d", m_id3Hdr.APIC_pos[0], m_id3Hdr.APIC_size[0]);
             }
         }
-        else if(startsWith(tag, "SLT")) { // lyrics embedded in header
+        else if(startsWith(m_id3Hdr.tag, "SLT")) { // lyrics embedded in header
             if(getDatamode() == AUDIO_LOCALFILE) {
-                SYLT_seen = true; // #460
-                SYLT_pos = id3Size - remainingHeaderBytes;
-                SYLT_size = universal_tmp;
-                if(m_f_Log) log_i("Attached lyrics seen at pos %d length %d", SYLT_pos, SYLT_size);
+                m_id3Hdr.SYLT_seen = true; // #460
+                m_id3Hdr.SYLT_pos = m_id3Hdr.id3Size - m_id3Hdr.remainingHeaderBytes;
+                m_id3Hdr.SYLT_size = m_id3Hdr.universal_tmp;
+                if(m_f_Log) log_i("Attached lyrics seen at pos %d length %d", m_id3Hdr.SYLT_pos, m_id3Hdr.SYLT_size);
             }
         }
-        else { showID3Tag(tag, value); }
-        remainingHeaderBytes -= universal_tmp;
-        universal_tmp -= dataLen;
+        else { showID3Tag(m_id3Hdr.tag, value); }
+        m_id3Hdr.remainingHeaderBytes -= m_id3Hdr.universal_tmp;
+        m_id3Hdr.universal_tmp -= dataLen;
 
         if(dataLen == 0) m_controlCounter = 98;
-        if(remainingHeaderBytes == 0) m_controlCounter = 98;
+        if(m_id3Hdr.remainingHeaderBytes == 0) m_controlCounter = 98;
 
         return 3 + 3 + dataLen;
     }
@@ -1891,43 +2016,52 @@ int Audio::read_ID3_Header(uint8_t* data, size_t len) {
 
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 98) { // skip all ID3 metadata (mostly spaces)
-        if(remainingHeaderBytes > len) {
-            remainingHeaderBytes -= len;
+        if(m_id3Hdr.remainingHeaderBytes > len && headerCanSkip(m_id3Hdr.remainingHeaderBytes)) {
+            m_headerSkip = m_id3Hdr.remainingHeaderBytes;
+            m_controlCounter = 99;
+            return 0;
+        }
+        if(m_id3Hdr.remainingHeaderBytes > len) {
+            m_id3Hdr.remainingHeaderBytes -= len;
             return len;
         } // Throw it away
         else {
             m_controlCounter = 99;
-            return remainingHeaderBytes;
+            return m_id3Hdr.remainingHeaderBytes;
         } // Throw it away
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 99) { //  exist another ID3tag?
-        m_audioDataStart += id3Size;
+        m_audioDataStart += m_id3Hdr.id3Size;
         //    vTaskDelay(30);
         if((*(data + 0) == 'I') && (*(data + 1) == 'D') && (*(data + 2) == '3')) {
             m_controlCounter = 0;
-            numID3Header++;
-            totalId3Size += id3Size;
+            m_id3Hdr.numID3Header++;
+            m_id3Hdr.totalId3Size += m_id3Hdr.id3Size;
             return 0;
         }
         else {
             m_controlCounter = 100; // ok
             m_audioDataSize = m_contentlength - m_audioDataStart;
             if(!m_f_m3u8data) AUDIO_INFO("Audio-Length: %u", m_audioDataSize);
-            if(APIC_pos[0] && audio_id3image) { // if we have more than one APIC, output the first only
+            if(m_id3Hdr.APIC_pos[0]) {
+                m_coverArtPos = m_id3Hdr.APIC_pos[0];
+                m_coverArtLen = m_id3Hdr.APIC_size[0];
+            }
+            if(m_id3Hdr.APIC_pos[0] && audio_id3image) { // if we have more than one APIC, output the first only
                 size_t pos = audiofile.position();
-                audio_id3image(audiofile, APIC_pos[0], APIC_size[0]);
+                audio_id3image(audiofile, m_id3Hdr.APIC_pos[0], m_id3Hdr.APIC_size[0]);
                 audiofile.seek(pos); // the filepointer could have been changed by the user, set it back
             }
-            if(SYLT_seen && audio_id3lyrics) {
+            if(m_id3Hdr.SYLT_seen && audio_id3lyrics) {
                 size_t pos = audiofile.position();
-                audio_id3lyrics(audiofile, SYLT_pos, SYLT_size);
+                audio_id3lyrics(audiofile, m_id3Hdr.SYLT_pos, m_id3Hdr.SYLT_size);
                 audiofile.seek(pos); // the filepointer could have been changed by the user, set it back
             }
-            numID3Header = 0;
-            totalId3Size = 0;
-            for(int i = 0; i < 3; i++) APIC_pos[i] = 0;  // delete all
-            for(int i = 0; i < 3; i++) APIC_size[i] = 0; // delete all
+            m_id3Hdr.numID3Header = 0;
+            m_id3Hdr.totalId3Size = 0;
+            for(int i = 0; i < 3; i++) m_id3Hdr.APIC_pos[i] = 0;  // delete all
+            for(int i = 0; i < 3; i++) m_id3Hdr.APIC_size[i] = 0; // delete all
             return 0;
         }
     }
@@ -1943,45 +2077,38 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
            |
          mdat contains the audio data                                                      */
 
-    static size_t headerSize = 0;
-    static size_t retvalue = 0;
-    static size_t atomsize = 0;
-    static size_t audioDataPos = 0;
-    static uint32_t picPos = 0;
-    static uint32_t picLen = 0;
 
-    if(m_controlCounter == M4A_BEGIN) retvalue = 0;
-    static size_t cnt = 0;
-    if(retvalue) {
+    if(m_controlCounter == M4A_BEGIN) m_m4aHdr.retvalue = 0;
+    if(m_m4aHdr.retvalue) {
         if(len > InBuff.getMaxBlockSize()) len = InBuff.getMaxBlockSize();
-        if(retvalue > len) { // if returnvalue > bufferfillsize
-            retvalue -= len; // and wait for more bufferdata
-            cnt += len;
+        if(m_m4aHdr.retvalue > len) { // if returnvalue > bufferfillsize
+            m_m4aHdr.retvalue -= len; // and wait for more bufferdata
+            m_m4aHdr.cnt += len;
             return len;
         }
         else {
-            size_t tmp = retvalue;
-            retvalue = 0;
-            cnt += tmp;
-            cnt = 0;
+            size_t tmp = m_m4aHdr.retvalue;
+            m_m4aHdr.retvalue = 0;
+            m_m4aHdr.cnt += tmp;
+            m_m4aHdr.cnt = 0;
             return tmp;
         }
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == M4A_BEGIN) { // init
-        headerSize = 0;
-        retvalue = 0;
-        atomsize = 0;
-        audioDataPos = 0;
-        picPos = 0;
-        picLen = 0;
+        m_m4aHdr.headerSize = 0;
+        m_m4aHdr.retvalue = 0;
+        m_m4aHdr.atomsize = 0;
+        m_m4aHdr.audioDataPos = 0;
+        m_m4aHdr.picPos = 0;
+        m_m4aHdr.picLen = 0;
         m_controlCounter = M4A_FTYP;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == M4A_FTYP) { /* check_m4a_file */
-        atomsize = bigEndian(data, 4); // length of first atom
+        m_m4aHdr.atomsize = bigEndian(data, 4); // length of first atom
         if(specialIndexOf(data, "ftyp", 10) != 4) {
             log_e("atom 'ftyp' not found in header");
             stopSong();
@@ -1998,23 +2125,30 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
         }
 
         m_controlCounter = M4A_CHK;
-        retvalue = atomsize;
-        headerSize = atomsize;
+        m_m4aHdr.retvalue = m_m4aHdr.atomsize;
+        m_m4aHdr.headerSize = m_m4aHdr.atomsize;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == M4A_CHK) {  /* check  Tag */
-        atomsize = bigEndian(data, 4); // length of this atom
+        m_m4aHdr.atomsize = bigEndian(data, 4); // length of this atom
         if(specialIndexOf(data, "moov", 10) == 4) {
             m_controlCounter = M4A_MOOV;
             return 0;
         }
         else if(specialIndexOf(data, "free", 10) == 4) {
-            retvalue = atomsize;
-            headerSize += atomsize;
+            m_m4aHdr.retvalue = m_m4aHdr.atomsize;
+            m_m4aHdr.headerSize += m_m4aHdr.atomsize;
             return 0;
         }
         else if(specialIndexOf(data, "mdat", 10) == 4) {
+            if(!m_m4aHdr.audioDataPos && m_streamType == ST_WEBFILE && headerCanSkip(m_m4aHdr.atomsize)) {
+                // moov follows the audio data: jump over mdat, read moov and come back (range requests)
+                m_m4aHdr.audioDataPos = m_m4aHdr.headerSize;
+                m_m4aHdr.headerSize += m_m4aHdr.atomsize;
+                m_headerSkip = m_m4aHdr.atomsize;
+                return 0;
+            }
             m_controlCounter = M4A_MDAT;
             return 0;
         }
@@ -2029,8 +2163,8 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
 
             if(m_f_Log) log_i("atom %s found", atomName);
 
-            retvalue = atomsize;
-            headerSize += atomsize;
+            m_m4aHdr.retvalue = m_m4aHdr.atomsize;
+            m_m4aHdr.headerSize += m_m4aHdr.atomsize;
             return 0;
         }
     }
@@ -2039,23 +2173,23 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
         // we are looking for track and ilst
         if(specialIndexOf(data, "trak", len) > 0) {
             int offset = specialIndexOf(data, "trak", len);
-            retvalue = offset;
-            atomsize -= offset;
-            headerSize += offset;
+            m_m4aHdr.retvalue = offset;
+            m_m4aHdr.atomsize -= offset;
+            m_m4aHdr.headerSize += offset;
             m_controlCounter = M4A_TRAK;
             return 0;
         }
         if(specialIndexOf(data, "ilst", len) > 0) {
             int offset = specialIndexOf(data, "ilst", len);
-            retvalue = offset;
-            atomsize -= offset;
-            headerSize += offset;
+            m_m4aHdr.retvalue = offset;
+            m_m4aHdr.atomsize -= offset;
+            m_m4aHdr.headerSize += offset;
             m_controlCounter = M4A_ILST;
             return 0;
         }
         m_controlCounter = M4A_CHK;
-        headerSize += atomsize;
-        retvalue = atomsize;
+        m_m4aHdr.headerSize += m_m4aHdr.atomsize;
+        m_m4aHdr.retvalue = m_m4aHdr.atomsize;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -2126,9 +2260,15 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
             setSampleRate(srate);
             setBitrate(bps * channel * srate);
             AUDIO_INFO("ch; %i, bps: %i, sr: %i", channel, bps, srate);
-            if(audioDataPos && getDatamode() == AUDIO_LOCALFILE) {
+            if(m_m4aHdr.audioDataPos && getDatamode() == AUDIO_LOCALFILE) {
                 m_controlCounter = M4A_AMRDY;
-                setFilePos(audioDataPos);
+                setFilePos(m_m4aHdr.audioDataPos);
+                return 0;
+            }
+            if(m_m4aHdr.audioDataPos && m_streamType == ST_WEBFILE) { // back to the mdat atom
+                m_controlCounter = M4A_MDAT;
+                m_m4aHdr.headerSize = m_m4aHdr.audioDataPos;
+                m_headerSeekPos = m_m4aHdr.audioDataPos;
                 return 0;
             }
         }
@@ -2173,8 +2313,8 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
         }
         offset = specialIndexOf(data, "covr", len);
         if(offset > 0){
-            picLen = bigEndian(data + offset + 4, 4) - 4;
-            picPos = headerSize + offset + 12;
+            m_m4aHdr.picLen = bigEndian(data + offset + 4, 4) - 4;
+            m_m4aHdr.picPos = m_m4aHdr.headerSize + offset + 12;
         }
         m_controlCounter = M4A_MOOV;
         return 0;
@@ -2183,20 +2323,24 @@ int Audio::read_M4A_Header(uint8_t* data, size_t len) {
     if(m_controlCounter == M4A_MDAT) {            // mdat
         m_audioDataSize = bigEndian(data, 4) - 8; // length of this atom - strlen(M4A_MDAT)
         AUDIO_INFO("Audio-Length: %u", m_audioDataSize);
-        retvalue = 8;
-        headerSize += 8;
+        m_m4aHdr.retvalue = 8;
+        m_m4aHdr.headerSize += 8;
         m_controlCounter = M4A_AMRDY; // last step before starting the audio
         return 0;
     }
 
     if(m_controlCounter == M4A_AMRDY) { // almost ready
-        m_audioDataStart = headerSize;
+        m_audioDataStart = m_m4aHdr.headerSize;
         //        m_contentlength = headerSize + m_audioDataSize; // after this mdat atom there may be other atoms
         if(getDatamode() == AUDIO_LOCALFILE) { AUDIO_INFO("Content-Length: %lu", (long unsigned int)m_contentlength); }
 
-        if(picLen) {
+        if(m_m4aHdr.picLen && getDatamode() == AUDIO_LOCALFILE) {
+            m_coverArtPos = m_m4aHdr.picPos;
+            m_coverArtLen = m_m4aHdr.picLen;
+        }
+        if(m_m4aHdr.picLen) {
             size_t pos = audiofile.position();
-            audio_id3image(audiofile, picPos, picLen);
+            audio_id3image(audiofile, m_m4aHdr.picPos, m_m4aHdr.picLen);
             audiofile.seek(pos); // the filepointer could have been changed by the user, set it back
         }
 
@@ -2258,6 +2402,10 @@ size_t Audio::process_m3u8_ID3_Header(uint8_t* packet) {
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint32_t Audio::stopSong() {
     uint32_t pos = 0;
+#if AUDIO_NET_READER
+    m_netReader.end(); // before the socket is closed
+#endif
+    m_hlsPrefetch.end();
     if(m_f_running) {
         m_f_running = false;
         if(getDatamode() == AUDIO_LOCALFILE) {
@@ -2271,6 +2419,9 @@ uint32_t Audio::stopSong() {
         AUDIO_INFO("Closing audio file \"%s\"", audiofile.name());
         audiofile.close();
     }
+#if AUDIO_FILE_READER
+    m_fileReader.end();
+#endif
     memset(m_outBuff, 0, m_outbuffSize); // Clear OutputBuffer
     memset(m_filterBuff, 0, sizeof(m_filterBuff)); // Clear FilterBuffer
     m_validSamples = 0;
@@ -2295,10 +2446,78 @@ bool Audio::pauseResume() {
     return retVal;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::wavToPCM16(uint8_t* data, size_t len) {
+    // block conversion of 24/32 bit PCM and 32/64 bit float into m_outBuff, the upper 16 bits are kept
+    uint32_t n = len / m_wavBytesPerSample; // samples of all channels, len holds whole frames only
+    if(n > m_outbuffSize / sizeof(int16_t)) n = m_outbuffSize / sizeof(int16_t);
+    int16_t* out = m_outBuff;
+    if(m_wavFormat == WAVE_FORMAT_IEEE_FLOAT) {
+        for(uint32_t i = 0; i < n; i++) {
+            float f;
+            if(m_wavBytesPerSample == 8) { double d; memcpy(&d, data, 8); f = (float)d; }
+            else                         { memcpy(&f, data, 4); }
+            data += m_wavBytesPerSample;
+            int32_t v = lrintf(f * 32768.0f);
+            if(v >  32767) v =  32767;
+            if(v < -32768) v = -32768;
+            out[i] = v;
+        }
+    }
+    else {
+        data += m_wavBytesPerSample - 2; // little endian, most significant 16 bits of the 24 or 32 bit sample
+        for(uint32_t i = 0; i < n; i++) {
+            out[i] = (int16_t)(data[0] | (data[1] << 8));
+            data += m_wavBytesPerSample;
+        }
+    }
+    m_validSamples = n / getChannels();
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::passthroughPossible() {
+    // 16 bit stereo at full volume with flat tone and balance: the sample chain in playSample() does not change
+    // the samples, m_outBuff already has the I2S frame layout and can be written to the DMA buffer in one block.
+    // Gain() is the identity only for limits of exactly 1, below it truncates, 0.99 turns 32767 into 32439;
+    // computeLimit() gives 1 for the highest volume step of both curves with the balance in the middle
+    if(getBitsPerSample() != 16 || getChannels() != 2) return false;
+    if(m_f_forceMono || m_f_internalDAC || audio_process_i2s) return false;
+    if(m_gain0 || m_gain1 || m_gain2) return false;
+    if(m_limit_left != 1.0 || m_limit_right != 1.0) return false;
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::playChunk() {
 
     int16_t sample[2];
 
+    if(m_switchTime) { // first samples of a new station
+        uint32_t ms = millis() - m_switchTime;
+        m_switchTime = 0;
+        m_switchMs = ms;
+        m_switches[m_f_switchWarm]++;
+        m_switchSumMs[m_f_switchWarm] += ms;
+        AUDIO_INFO("station switch took %lu ms (%s)", (long unsigned int)ms, m_f_switchWarm ? "warm" : "cold");
+    }
+
+    if(passthroughPossible()) {
+        size_t bw = 0;
+        int16_t* p = m_outBuff + m_curSample * 2;
+#if(ESP_IDF_VERSION_MAJOR == 5)
+        esp_err_t err = i2s_channel_write(m_i2s_tx_handle, (const char*)p, m_validSamples * 4, &bw, 0);
+#else
+        esp_err_t err = i2s_write((i2s_port_t)m_i2s_num, (const char*)p, m_validSamples * 4, &bw, 0); // no wait
+#endif
+        if(err != ESP_OK && err != 263) { log_e("ESP32 Errorcode: %i", err); }
+        uint16_t frames = bw / 4;
+        for(uint16_t i = 0; i < frames; i++) { // VU meter as in playSample()
+            sample[LEFTCHANNEL] = p[i * 2 + 1];
+            sample[RIGHTCHANNEL] = p[i * 2];
+            computeVUlevel(sample);
+        }
+        m_curSample += frames;
+        m_validSamples -= frames;
+        return;
+    }
+
     auto pc = [&](int16_t* s16) { // lambda, inner function
         if(playSample(s16)) {
             m_validSamples--;
@@ -2391,6 +2610,7 @@ void Audio::loop() {
             case AUDIO_PLAYLISTINIT: readPlayListData(); break;
             case AUDIO_PLAYLISTDATA:
                 host = parsePlaylist_M3U8();
+                if(host && host == m_playlistBuff && hlsPrefetchStart()) break; // the segments come from the prefetch task
                 if(host) { // host contains the next playlist URL
                     httpPrint(host);
                     setDatamode(HTTP_RESPONSE_HEADER);
@@ -2406,6 +2626,10 @@ void Audio::loop() {
                 if(m_f_ts) { processWebStreamTS(); } // aac or aacp with ts packets
                 else { processWebStreamHLS(); }      // aac or aacp normal stream
 
+                if(hlsPrefetching()) {
+                    hlsPrefetchFeed();
+                    break;
+                }
                 if(m_f_continue) { // at this point m_f_continue is true, means processWebStream() needs more data
                     setDatamode(AUDIO_PLAYLISTDATA);
                     m_f_continue = false;
@@ -2418,11 +2642,15 @@ void Audio::loop() {
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::readPlayListData() {
     if(getDatamode() != AUDIO_PLAYLISTINIT) return false;
-    if(_client->available() == 0) return false;
+    if(netAvailable() == 0) return false;
 
     uint32_t chunksize = 0;
     uint8_t  readedBytes = 0;
-    if(m_f_chunked) chunksize = chunkedDataTransfer(&readedBytes);
+    if(m_f_chunked) {
+        int32_t n = chunkedDataTransfer(&readedBytes);
+        if(n < 0) return false; // the chunk size line is not complete yet
+        chunksize = n;
+    }
 
     // reads the content of the playlist and stores it in the vector m_contentlength
     // m_contentlength is a table of pointers to the lines
@@ -2439,8 +2667,8 @@ bool Audio::readPlayListData() {
 
         while(true) { // inner while
             uint16_t pos = 0;
-            while(_client->available()) { // super inner while :-))
-                pl[pos] = _client->read();
+            while(netAvailable()) { // super inner while :-))
+                pl[pos] = netRead();
                 ctl++;
                 if(pl[pos] == '\n') {
                     pl[pos] = '\0';
@@ -2502,14 +2730,14 @@ bool Audio::readPlayListData() {
         // 2. no contentLength, but Transfer-Encoding:chunked -> compute chunksize and read until chunksize is reached
         // 3. no chunksize and no contentlengt, but Connection: close -> read all available chars
         if(ctl == m_contentlength) {
-            while(_client->available()) _client->read();
+            m_f_bodyRead = !m_f_chunked;
             break;
-        } // read '\n\n' if exists
+        }
         if(ctl == chunksize) {
-            while(_client->available()) _client->read();
+            while(netAvailable()) netRead();
             break;
         }
-        if(!_client->connected() && _client->available() == 0) break;
+        if(!_client->connected() && netAvailable() == 0) break;
 
     } // outer while
     lines = m_playlistContent.size();
@@ -2659,19 +2887,21 @@ const char* Audio::parsePlaylist_M3U8() {
     // #EXTINF:10,title="text=\"Spot Block End\" amgTrackId=\"9876543\"",artist=" ",url="length=\"00:00:00\""
     // http://n3fa-e2.revma.ihrhls.com/zc7729/63_sdtszizjcjbz02/main/163374039.aac
 
-    static uint64_t xMedSeq = 0;
-    static boolean  f_mediaSeq_found = false;
     boolean         f_EXTINF_found = false;
     char            llasc[21]; // uint64_t max = 18,446,744,073,709,551,615  thats 20 chars + \0
     if(m_f_firstM3U8call) {
         m_f_firstM3U8call = false;
-        xMedSeq = 0;
-        f_mediaSeq_found = false;
+        m_m3u8.xMedSeq = 0;
+        m_m3u8.f_mediaSeq_found = false;
+        m_hlsLastSeq = UINT64_MAX;
+        m_f_hlsAlign = false;
     }
 
     uint8_t     lines = m_playlistContent.size();
     bool        f_begin = false;
     const char* ret;
+    uint64_t    seqTag = UINT64_MAX; // #EXT-X-MEDIA-SEQUENCE, the number of the first segment
+    uint32_t    seqIdx = 0;
     if(lines) {
         for(uint16_t i = 0; i < lines; i++) {
             if(strlen(m_playlistContent[i]) == 0) continue; // empty line
@@ -2692,28 +2922,39 @@ const char* Audio::parsePlaylist_M3U8() {
             if(m_codec == CODEC_NONE) m_codec = CODEC_AAC; // if we have no redirection
 
             // "#EXT-X-DISCONTINUITY-SEQUENCE: // not used, 0: seek for continuity numbers, is sometimes not set
-            // "#EXT-X-MEDIA-SEQUENCE:"        // not used, is unreliable
+            // "#EXT-X-MEDIA-SEQUENCE:"        // is unreliable, only used to align a new variant
+            if(startsWith(m_playlistContent[i], "#EXT-X-MEDIA-SEQUENCE:")) {
+                seqTag = strtoull(m_playlistContent[i] + 22, NULL, 10);
+                continue;
+            }
             if(startsWith(m_playlistContent[i], "#EXT-X-VERSION:")) continue;
             if(startsWith(m_playlistContent[i], "#EXT-X-ALLOW-CACHE:")) continue;
             if(startsWith(m_playlistContent[i], "##")) continue;
             if(startsWith(m_playlistContent[i], "#EXT-X-INDEPENDENT-SEGMENTS")) continue;
             if(startsWith(m_playlistContent[i], "#EXT-X-PROGRAM-DATE-TIME:")) continue;
+            if(startsWith(m_playlistContent[i], "#EXT-X-TARGETDURATION:")) {
+                m_m3u8_targetDuration = max(atoi(m_playlistContent[i] + 22), 1);
+                continue;
+            }
 
-            if(!f_mediaSeq_found) {
-                xMedSeq = m3u8_findMediaSeqInURL();
-                if(xMedSeq == UINT64_MAX) {
+            if(!m_m3u8.f_mediaSeq_found) {
+                m_m3u8.xMedSeq = m3u8_findMediaSeqInURL();
+                if(m_m3u8.xMedSeq == UINT64_MAX) {
                     log_e("X MEDIA SEQUENCE NUMBER not found");
                     stopSong();
                     return NULL;
                 }
-                if(xMedSeq > 0) f_mediaSeq_found = true;
-                if(xMedSeq == 0) { // mo mediaSeqNr but min 3 times #EXTINF found
+                if(m_m3u8.xMedSeq > 0) m_m3u8.f_mediaSeq_found = true;
+                if(m_m3u8.xMedSeq == 0) { // mo mediaSeqNr but min 3 times #EXTINF found
                     ;
                 }
             }
 
             if(startsWith(m_playlistContent[i], "#EXTINF")) {
                 f_EXTINF_found = true;
+                uint32_t extinfMs = atof(m_playlistContent[i] + 8) * 1000; // #EXTINF:9.976,
+                uint64_t seq = (seqTag != UINT64_MAX) ? seqTag + seqIdx++ : UINT64_MAX;
+                size_t   queued = m_playlistURL.size();
                 if(STfromEXTINF(m_playlistContent[i])) { showstreamtitle(m_chbuf); }
                 i++;
                 if(startsWith(m_playlistContent[i], "#")) i++;   // #MY-USER-CHUNK-DATA-1:ON-TEXT-DATA="20....
@@ -2759,18 +3000,28 @@ const char* Audio::parsePlaylist_M3U8() {
                 }
                 else { tmp = strdup(m_playlistContent[i]); }
 
-                if(f_mediaSeq_found) {
-                    lltoa(xMedSeq, llasc, 10);
+                if(m_f_hlsAlign && seq != UINT64_MAX && m_hlsLastSeq != UINT64_MAX && seq <= m_hlsLastSeq) {
+                    // the new variant: this segment has been queued from the old one, its URL is known from now on
+                    m_hashQueue.insert(m_hashQueue.begin(), simpleHash(tmp));
+                    if(m_hashQueue.size() > 20) m_hashQueue.pop_back();
+                    free(tmp);
+                    continue;
+                }
+
+                if(m_m3u8.f_mediaSeq_found) {
+                    lltoa(m_m3u8.xMedSeq, llasc, 10);
                     if(indexOf(tmp, llasc) > 0) {
                         m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
-                        xMedSeq++;
+                        m_playlistDur.insert(m_playlistDur.begin(), extinfMs);
+                        m_m3u8.xMedSeq++;
                     }
                     else{
-                        lltoa(xMedSeq + 1, llasc, 10);
+                        lltoa(m_m3u8.xMedSeq + 1, llasc, 10);
                         if(indexOf(tmp, llasc) > 0) {
                             m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
-                            log_w("mediaseq %llu skipped", xMedSeq);
-                            xMedSeq+= 2;
+                            m_playlistDur.insert(m_playlistDur.begin(), extinfMs);
+                            log_w("mediaseq %llu skipped", m_m3u8.xMedSeq);
+                            m_m3u8.xMedSeq+= 2;
                         }
                     }
                 }
@@ -2779,6 +3030,7 @@ const char* Audio::parsePlaylist_M3U8() {
                     if(m_hashQueue.size() == 0) {
                         m_hashQueue.insert(m_hashQueue.begin(), hash);
                         m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
+                        m_playlistDur.insert(m_playlistDur.begin(), extinfMs);
                     }
                     else {
                         bool known = false;
@@ -2791,16 +3043,22 @@ const char* Audio::parsePlaylist_M3U8() {
                         if(!known) {
                             m_hashQueue.insert(m_hashQueue.begin(), hash);
                             m_playlistURL.insert(m_playlistURL.begin(), strdup(tmp));
+                            m_playlistDur.insert(m_playlistDur.begin(), extinfMs);
                         }
                     }
                     if(m_hashQueue.size() > 20) m_hashQueue.pop_back();
                 }
+                if(m_playlistURL.size() > queued && seq != UINT64_MAX) m_hlsLastSeq = seq;
 
                 if(tmp) {free(tmp); tmp = NULL;}
 
                 continue;
             }
         }
+        if(m_f_hlsAlign && f_EXTINF_found) { // the first media playlist of the new variant has been read
+            if(seqTag == UINT64_MAX) log_w("hls variant without #EXT-X-MEDIA-SEQUENCE, segments may repeat");
+            m_f_hlsAlign = false;
+        }
         vector_clear_and_shrink(m_playlistContent); // clear after reading everything, m_playlistContent.size is now 0
     }
 
@@ -2814,6 +3072,11 @@ const char* Audio::parsePlaylist_M3U8() {
             m_playlistURL.pop_back();
             m_playlistURL.shrink_to_fit();
         }
+        m_hlsSegmentMs = 0;
+        if(m_playlistDur.size()) {
+            m_hlsSegmentMs = m_playlistDur.back();
+            m_playlistDur.pop_back();
+        }
         if(m_f_Log) log_i("now playing %s", m_playlistBuff);
         if(endsWith(m_playlistBuff, "ts")) m_f_ts = true;
         if(indexOf(m_playlistBuff, ".ts?") > 0) m_f_ts = true;
@@ -2821,15 +3084,15 @@ const char* Audio::parsePlaylist_M3U8() {
     }
     else {
         if(f_EXTINF_found) {
-            if(f_mediaSeq_found) {
+            if(m_m3u8.f_mediaSeq_found) {
                 if(m_playlistContent.size() == 0) return NULL;
                 uint64_t mediaSeq = m3u8_findMediaSeqInURL();
-                if(xMedSeq == 0 || xMedSeq == UINT64_MAX) {
+                if(m_m3u8.xMedSeq == 0 || m_m3u8.xMedSeq == UINT64_MAX) {
                     log_e("xMediaSequence not found");
                     connecttohost(m_lastHost);
                 }
-                if(mediaSeq < xMedSeq) {
-                    uint64_t diff = xMedSeq - mediaSeq;
+                if(mediaSeq < m_m3u8.xMedSeq) {
+                    uint64_t diff = m_m3u8.xMedSeq - mediaSeq;
                     if(diff < 10) { ; }
                     else {
                         if(m_playlistContent.size() > 0) {
@@ -2852,8 +3115,8 @@ const char* Audio::parsePlaylist_M3U8() {
                     }
                 }
                 else {
-                    if(mediaSeq != UINT64_MAX) { log_e("err, %u packets lost from %u, to %u", mediaSeq - xMedSeq, xMedSeq, mediaSeq); }
-                    xMedSeq = mediaSeq;
+                    if(mediaSeq != UINT64_MAX) { log_e("err, %u packets lost from %u, to %u", mediaSeq - m_m3u8.xMedSeq, m_m3u8.xMedSeq, mediaSeq); }
+                    m_m3u8.xMedSeq = mediaSeq;
                 }
             } // f_medSeq_found
         }
@@ -2884,87 +3147,111 @@ const char* Audio::m3u8redirection(uint8_t* codec) {
         "mp4a.67",    // MPEG-2 AAC LC
     };
 
-    uint16_t choosenLine = 0;
+    // every variant with a playable codec, a missing CODECS attribute is taken as aac; the codec that comes first in
+    // codecString[] is played, among the variants with the same CODECS string the throughput decides, see
+    // hlsChooseVariant(). mp4a.40.2, .5 and .29 are not interchangeable, SBR and PS change the sample rate and channels
     uint16_t plcSize = m_playlistContent.size();
     int8_t   cS = 100;
-
-    for(uint16_t i = 0; i < plcSize; i++) { // looking for lowest codeString
-        int16_t posCodec = indexOf(m_playlistContent[i], "CODECS=\"mp4a");
-        if(posCodec > 0){
-            bool found = false;
-            for(uint8_t j = 0; j < sizeof(codecString); j++){
-                if(indexOf(m_playlistContent[i], codecString[j]) > 0){
-                    if(j < cS){cS = j; choosenLine = i;}
-                    found = true;
+    char     codecs[48] = ""; // of the variants that are played
+
+    hlsVariantsClear();
+    for(uint16_t i = 0; i < plcSize; i++) {
+        if(!startsWith(m_playlistContent[i], "#EXT-X-STREAM-INF:")) continue;
+        hlsVariant_t v;
+        int8_t       rank = 99;
+        int16_t      posCodec = indexOf(m_playlistContent[i], "CODECS=\"");
+        v.codecs[0] = '\0';
+        if(posCodec > 0) {
+            const char* c = m_playlistContent[i] + posCodec + 8;
+            size_t      n = min(strcspn(c, "\""), sizeof(v.codecs) - 1);
+            memcpy(v.codecs, c, n);
+            v.codecs[n] = '\0';
+            rank = -1;
+            for(uint8_t j = 0; j < sizeof(codecString) / sizeof(codecString[0]) && rank < 0; j++) {
+                size_t len = strlen(codecString[j]); // a whole entry of the list, "mp4a.40.2" is not "mp4a.40.29"
+                for(const char* f = strstr(v.codecs, codecString[j]); f; f = strstr(f + 1, codecString[j])) {
+                    if((f == v.codecs || f[-1] == ',' || f[-1] == ' ') && (!f[len] || f[len] == ',')) { rank = j; break; }
                 }
             }
-            if(!found) log_w("codeString %s not in list", m_playlistContent[i] + posCodec);
+            if(rank < 0) { log_w("codeString %s not in list", m_playlistContent[i] + posCodec); continue; }
         }
-        if(cS == 0)            *codec = CODEC_MP3;
-        if(cS > 0 && cS < 100) *codec = CODEC_AAC;
-    }
-
-    char* tmp = nullptr;
-
-    // if((!endsWith(m_playlistContent[choosenLine], "m3u8") && indexOf(m_playlistContent[choosenLine], "m3u8?") == -1)) {
-    //     // we have a new m3u8 playlist, skip to next line
-    //     int pos = indexOf(m_playlistContent[choosenLine - 1], "CODECS=\"mp4a", 18);
-    //     if(pos < 0) { // not found
-    //         int pos1 = indexOf(m_playlistContent[choosenLine - 1], "CODECS=", 18);
-    //         if(pos1 < 0) pos1 = 0;
-    //         log_e("codec %s in m3u8 playlist not supported", m_playlistContent[choosenLine - 1] + pos1);
-    //         goto exit;
-    //     }
-    // }
-    choosenLine++; // next line is the redirection url
-
-    if(!startsWith(m_playlistContent[choosenLine], "http")) {
-
-        // http://livees.com/prog_index.m3u8 and prog_index48347.aac -->
-        // http://livees.com/prog_index48347.aac http://livees.com/prog_index.m3u8 and chunklist022.m3u8 -->
-        // http://livees.com/chunklist022.m3u8
+        uint16_t u = i + 1; // the URL follows, maybe behind other tags
+        while(u < plcSize && startsWith(m_playlistContent[u], "#")) u++;
+        if(u == plcSize) break;
 
-        tmp = (char*)malloc(strlen(m_lastHost) + strlen(m_playlistContent[choosenLine]));
-        strcpy(tmp, m_lastHost);
-        int idx1 = lastIndexOf(tmp, "/");
-        strcpy(tmp + idx1 + 1, m_playlistContent[choosenLine]);
-    }
-    else { tmp = strdup(m_playlistContent[choosenLine]); }
-
-    if(startsWith(m_playlistContent[choosenLine], "../")){
-        // ../../2093120-b/RISMI/stream01/streamPlaylist.m3u8
-        if(tmp) { free(tmp); tmp = NULL;}
-        tmp = (char*)malloc(strlen(m_lastHost) + strlen(m_playlistContent[choosenLine]));
-        strcpy(tmp, m_lastHost);
-        int idx1 = lastIndexOf(tmp, "/");
-        tmp[idx1] = '\0';
-
-        while(startsWith(m_playlistContent[choosenLine], "../")){
-            memcpy(m_playlistContent[choosenLine], m_playlistContent[choosenLine] + 3, strlen(m_playlistContent[choosenLine] +3) + 1); // shift << 3
-            idx1 = lastIndexOf(tmp, "/");
-            tmp[idx1] = '\0';
-        }
-        strcat(tmp, "/");
-        strcat(tmp, m_playlistContent[choosenLine]);
+        int16_t posBw = indexOf(m_playlistContent[i], "AVERAGE-BANDWIDTH=");
+        if(posBw > 0) v.bandwidth = atol(m_playlistContent[i] + posBw + 18);
+        else {
+            posBw = indexOf(m_playlistContent[i], "BANDWIDTH=");
+            v.bandwidth = (posBw > 0) ? atol(m_playlistContent[i] + posBw + 10) : 0;
+        }
+        v.url = m3u8ResolveURL(m_playlistContent[u]);
+        if(!v.url) continue;
+        uint8_t pos = 0; // sorted by bandwidth
+        while(pos < m_hlsVariants.size() && m_hlsVariants[pos].bandwidth <= v.bandwidth) pos++;
+        m_hlsVariants.insert(m_hlsVariants.begin() + pos, v);
+        if(rank < cS) {
+            cS = rank;
+            strcpy(codecs, v.codecs);
+        }
+        i = u;
+    }
+    *codec = (cS == 0) ? CODEC_MP3 : CODEC_AAC;
+    for(int i = m_hlsVariants.size() - 1; i >= 0; i--) { // other CODECS, switching would need a new decoder setup
+        if(!strcmp(m_hlsVariants[i].codecs, codecs)) continue;
+        free(m_hlsVariants[i].url);
+        m_hlsVariants.erase(m_hlsVariants.begin() + i);
+    }
+    if(!m_hlsVariants.size()) {
+        log_e("no playable variant in the m3u8 playlist");
+        stopSong();
+        return NULL;
     }
 
-    if(m_playlistContent[choosenLine]) {
-        free(m_playlistContent[choosenLine]);
-        m_playlistContent[choosenLine] = NULL;
-    }
-    m_playlistContent[choosenLine] = strdup(tmp);
+    m_hlsVariant = hlsChooseVariant(hlsThroughput());
+    m_hlsHold = 0;
+    m_hlsHistory[0] = m_hlsVariants[m_hlsVariant].bandwidth;
+    m_hlsHistoryLen = 1;
+    m_hlsSwitches = 0;
     if(m_lastM3U8host) {
         free(m_lastM3U8host);
         m_lastM3U8host = NULL;
     }
-    m_lastM3U8host = strdup(tmp);
-    if(tmp) {
-        free(tmp);
-        tmp = NULL;
-    }
-    log_d("redirect to %s", m_playlistContent[choosenLine]);
-    _client->stop();
-    return m_playlistContent[choosenLine]; // it's a redirection, a new m3u8 playlist
+    m_lastM3U8host = strdup(m_hlsVariants[m_hlsVariant].url);
+    AUDIO_INFO("hls variant %i of %i, %lu bit/s, codecs \"%s\"", m_hlsVariant + 1, m_hlsVariants.size(),
+               (long unsigned)m_hlsVariants[m_hlsVariant].bandwidth, codecs);
+    log_d("redirect to %s", m_lastM3U8host);
+    return m_lastM3U8host; // it's a redirection, a new m3u8 playlist, httpPrint() keeps the connection on the same origin
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+char* Audio::m3u8ResolveURL(const char* url) {
+    // URL from the master playlist, relative to m_lastHost:
+    // http://livees.com/prog_index.m3u8 and chunklist022.m3u8 --> http://livees.com/chunklist022.m3u8
+    // http://livees.com/a/b/prog_index.m3u8 and /c/chunklist.m3u8 --> http://livees.com/c/chunklist.m3u8
+    // http://livees.com/a/b/prog_index.m3u8 and ../c/chunklist.m3u8 --> http://livees.com/a/c/chunklist.m3u8
+
+    if(startsWith(url, "http")) return strdup(url);
+    char* tmp = (char*)malloc(strlen(m_lastHost) + strlen(url) + 2);
+    if(!tmp) return NULL;
+    strcpy(tmp, m_lastHost);
+    int hostEnd = indexOf(tmp, "/", 8); // behind "https://host"
+    if(hostEnd < 0) hostEnd = strlen(tmp);
+    if(url[0] == '/') {
+        tmp[hostEnd] = '\0';
+        strcat(tmp, url);
+        return tmp;
+    }
+    int idx = lastIndexOf(tmp, "/");
+    if(idx >= hostEnd) tmp[idx] = '\0';
+    else tmp[hostEnd] = '\0';
+    while(startsWith(url, "../")) {
+        url += 3;
+        idx = lastIndexOf(tmp, "/");
+        if(idx >= hostEnd) tmp[idx] = '\0';
+    }
+    strcat(tmp, "/");
+    strcat(tmp, url);
+    return tmp;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint64_t Audio::m3u8_findMediaSeqInURL() { // We have no clue what the media sequence is
@@ -3033,6 +3320,7 @@ bool Audio::STfromEXTINF(char* str) {
 
     int t1, t2, t3, n0 = 0, n1 = 0, n2 = 0;
 
+    m_chbuf[0] = '\0';
     t1 = indexOf(str, "title", 0);
     if(t1 > 0) {
         strcpy(m_chbuf, "StreamTitle=");
@@ -3057,27 +3345,23 @@ bool Audio::STfromEXTINF(char* str) {
         strncpy(m_chbuf + n0 + n1, str + t2, n2);
         m_chbuf[n0 + n1 + n2] = '\0';
     }
-    return true;
+    return m_chbuf[0] != '\0'; // "#EXTINF:10," has no title
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::processLocalFile() {
     if(!(audiofile && m_f_running && getDatamode() == AUDIO_LOCALFILE)) return; // guard
 
-    static uint32_t ctime = 0;
     const uint32_t  timeout = m_headerTimeout; // OMT: expansion, was 2500; // ms
     const uint32_t  maxFrameSize = InBuff.getMaxBlockSize(); // every mp3/aac frame is not bigger
-    static bool     f_stream;
-    static bool     f_fileDataComplete;
-    static uint32_t byteCounter; // count received data
     uint32_t        availableBytes = 0;
 
     if(m_f_firstCall) { // runs only one time per connection, prepare for start
         m_f_firstCall = false;
-        f_stream = false;
-        f_fileDataComplete = false;
-        byteCounter = 0;
-        ctime = millis();
+        m_localFile.f_stream = false;
+        m_localFile.f_fileDataComplete = false;
+        m_localFile.byteCounter = 0;
+        m_localFile.ctime = millis();
         if(m_codec == CODEC_M4A) seek_m4a_stsz(); // determine the pos of atom stsz
         if(m_codec == CODEC_M4A) seek_m4a_ilst(); // looking for metadata
         if(m_resumeFilePos == 0) m_resumeFilePos = -1; // parkposition
@@ -3087,19 +3371,20 @@ void Audio::processLocalFile() {
     availableBytes = 256 * 1024; // set some large value
 
     availableBytes = min(availableBytes, (uint32_t)InBuff.writeSpace());
-    availableBytes = min(availableBytes, audiofile.size() - byteCounter);
+    availableBytes = min(availableBytes, audiofile.size() - m_localFile.byteCounter);
     if(m_contentlength) {
         if(m_contentlength > getFilePos()) availableBytes = min(availableBytes, m_contentlength - getFilePos());
     }
-    if(m_audioDataSize) { availableBytes = min(availableBytes, m_audioDataSize + m_audioDataStart - byteCounter); }
+    if(m_audioDataSize) { availableBytes = min(availableBytes, m_audioDataSize + m_audioDataStart - m_localFile.byteCounter); }
 
-    int32_t bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), availableBytes);
+    int32_t bytesAddedToBuffer = readLocalFile(InBuff.getWritePtr(), availableBytes);
     if(bytesAddedToBuffer > 0) {
-        byteCounter += bytesAddedToBuffer; // Pull request #42
+        m_localFile.byteCounter += bytesAddedToBuffer; // Pull request #42
         InBuff.bytesWritten(bytesAddedToBuffer);
     }
-    if(!f_stream) {
+    if(!m_localFile.f_stream) {
         if(m_codec == CODEC_OGG) { // log_i("determine correct codec here");
+            if(InBuff.bufferFilled() < maxFrameSize && m_localFile.byteCounter < audiofile.size()) return; // file reader not ready yet
             uint8_t codec = determineOggCodec(InBuff.getReadPtr(), maxFrameSize);
             if(codec == CODEC_FLAC) {
                 m_codec = CODEC_FLAC;
@@ -3120,23 +3405,30 @@ void Audio::processLocalFile() {
             return;
         }
         if(m_controlCounter != 100) {
-            if((millis() - ctime) > timeout) {
+            if((millis() - m_localFile.ctime) > timeout) {
                 log_e("audioHeader reading timeout");
                 m_f_running = false;
                 return;
             }
-            if(InBuff.bufferFilled() > maxFrameSize) { // read the file header first
+            if(InBuff.bufferFilled() > maxFrameSize || (m_localFile.byteCounter == audiofile.size() && InBuff.bufferFilled())) { // read the file header first, a short file has less
                 InBuff.bytesWasRead(readAudioHeader(InBuff.getMaxAvailableBytes()));
             }
+            if(m_headerSkip) { // the parser wants to jump over a picture or padding
+                m_localFile.byteCounter = m_localFile.byteCounter - InBuff.bufferFilled() + m_headerSkip;
+                m_headerSkip = 0;
+                InBuff.resetBuffer();
+                seekLocalFile(m_localFile.byteCounter);
+            }
             return;
         }
         else {
-            if((InBuff.freeSpace() > maxFrameSize) && (m_fileSize - byteCounter) > maxFrameSize && availableBytes) {
+            if((InBuff.freeSpace() > maxFrameSize) && (m_fileSize - m_localFile.byteCounter) > maxFrameSize && availableBytes) {
                 // fill the buffer before playing
                 return;
             }
 
-            f_stream = true;
+            m_localFile.f_stream = true;
+            m_headerTimeMs = millis() - m_localFile.ctime;
             AUDIO_INFO("stream ready");
             if(m_f_Log) log_i("m_audioDataStart %d", m_audioDataStart);
         }
@@ -3152,61 +3444,59 @@ void Audio::processLocalFile() {
         if(m_resumeFilePos >= (int32_t)m_audioDataStart + m_audioDataSize) {goto exit;}
         m_haveNewFilePos = m_resumeFilePos;
 
-        if(m_codec == CODEC_M4A) {
+        const AudioCodec_t* codec = AudioCodec_Get(m_codec);
+        if(m_codec == CODEC_M4A) { // the container knows the frames
             m_resumeFilePos = m4a_correctResumeFilePos(m_resumeFilePos);
         }
+        else if(codec && codec->seekFrame) {
+            m_resumeFilePos = codec_correctResumeFilePos(codec, m_resumeFilePos);
+            if(m_resumeFilePos == -1) goto exit;
+        }
         if(m_codec == CODEC_WAV) {
-            while((m_resumeFilePos % 4) != 0){ // must be divisible by four
+            while(((m_resumeFilePos - m_audioDataStart) % (getChannels() * m_wavBytesPerSample)) != 0){ // whole frames
                 m_resumeFilePos++;
                 if(m_resumeFilePos >= m_fileSize) goto exit;
             }
         }
-        if(m_codec == CODEC_FLAC) {
-            m_resumeFilePos = flac_correctResumeFilePos(m_resumeFilePos);
-            if(m_resumeFilePos == -1) goto exit;
-            FLACDecoderReset();
-        }
-        if(m_codec == CODEC_MP3) {
-            m_resumeFilePos = mp3_correctResumeFilePos(m_resumeFilePos);
-            if(m_resumeFilePos == -1) goto exit;
-        }
+        if(codec && codec->flush) codec->flush();
 
-        audiofile.seek(m_resumeFilePos);
+        seekLocalFile(m_resumeFilePos);
         InBuff.resetBuffer();
-        byteCounter = m_resumeFilePos;
-        f_fileDataComplete = false; // #570
+        m_localFile.byteCounter = m_resumeFilePos;
+        m_localFile.f_fileDataComplete = false; // #570
 
         m_resumeFilePos = -1;
-        f_stream = false;
+        m_localFile.f_stream = false;
     }
     // end of file reached? - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_fileDataComplete && InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {
+    if(m_localFile.f_fileDataComplete && InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {
+        if(m_validSamples) { // play samples first, also those of the last frame that I2S has not taken yet
+            playChunk();
+            return;
+        }
         if(InBuff.bufferFilled()) {
             if(!readID3V1Tag()) {
-                if(m_validSamples) {
-                    playChunk();
-                    return;
-                } // play samples first
+                bool f_sync = !m_f_playing; // this call only looks for the syncword
                 int bytesDecoded = sendBytes(InBuff.getReadPtr(), InBuff.bufferFilled());
                 if(bytesDecoded <= InBuff.bufferFilled()) { // avoid InBuff overrun (can be if file is corrupt)
-                    if(m_f_playing) {
-                        if(bytesDecoded > 2) {
-                            InBuff.bytesWasRead(bytesDecoded);
-                            return;
-                        }
+                    // a damaged frame in the last block is skipped by the resync as before, it does not end the file;
+                    // a FLAC frame ends with a call that reads only the 2 byte CRC
+                    if(bytesDecoded > 0 || (f_sync && m_f_playing)) {
+                        InBuff.bytesWasRead(bytesDecoded);
+                        return;
                     }
                 }
                 if(m_codec == CODEC_MP3) AUDIO_INFO("audio file is corrupt --> send EOF"); // no return, fall through
             }
         }
 
-        if(m_f_loop && f_stream) {                                                                                      // eof
+        if(m_f_loop && m_localFile.f_stream) {                                                                                      // eof
             AUDIO_INFO("loop from: %lu to: %lu", (long unsigned int)getFilePos(), (long unsigned int)m_audioDataStart); // loop
             setFilePos(m_audioDataStart);
-            if(m_codec == CODEC_FLAC) FLACDecoderReset();
+            if(AudioCodec_Get(m_codec) && AudioCodec_Get(m_codec)->flush) AudioCodec_Get(m_codec)->flush();
             m_audioCurrentTime = 0;
-            byteCounter = m_audioDataStart;
-            f_fileDataComplete = false;
+            m_localFile.byteCounter = m_audioDataStart;
+            m_localFile.f_fileDataComplete = false;
             return;
         } // loop
 exit:
@@ -3215,14 +3505,12 @@ exit:
         m_f_running = false;
         m_streamType = ST_NONE;
         audiofile.close();
+#if AUDIO_FILE_READER
+        m_fileReader.end();
+#endif
         AUDIO_INFO("Closing audio file \"%s\"", afn);
 
-        if(m_codec == CODEC_MP3) MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
-        if(m_codec == CODEC_OPUS) OPUSDecoder_FreeBuffers();
-        if(m_codec == CODEC_VORBIS) VORBISDecoder_FreeBuffers();
+        if(AudioCodec_Get(m_codec)) AudioCodec_Get(m_codec)->freeBuffers();
 
         if(afn) {
             if(audio_eof_mp3) audio_eof_mp3(afn);
@@ -3237,64 +3525,46 @@ exit:
         m_codec = CODEC_NONE;
         return;
     }
-    if(byteCounter == audiofile.size()) { f_fileDataComplete = true; }
-    if(byteCounter == m_audioDataSize + m_audioDataStart) { f_fileDataComplete = true; }
+    if(m_localFile.byteCounter == audiofile.size()) { m_localFile.f_fileDataComplete = true; }
+    if(m_localFile.byteCounter == m_audioDataSize + m_audioDataStart) { m_localFile.f_fileDataComplete = true; }
     // play audio data - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) { playAudioData(); }
+    if(m_localFile.f_stream) { playAudioData(); }
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::processWebStream() {
     const uint16_t  maxFrameSize = InBuff.getMaxBlockSize(); // every mp3/aac frame is not bigger
-    static bool     f_stream;                                // first audio data received
-    static uint32_t chunkSize;                               // chunkcount read from stream
 
     // first call, set some values to default  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { // runs only ont time per connection, prepare for start
         m_f_firstCall = false;
-        f_stream = false;
-        chunkSize = 0;
-        m_metacount = m_metaint;
-        readMetadata(0, true); // reset all static vars
+        m_webStream.f_stream = false;
+        m_webStream.f_rebuffer = false;
+        if(!m_httpParser.setBody(m_f_chunked, m_f_metadata ? m_metaint : 0)) log_e("no memory for metadata, stream title lost");
+#if AUDIO_NET_READER
+        if(!m_netReader.begin(_client)) AUDIO_INFO("net reader task not available, read in loop()");
+#endif
     }
 
     if(getDatamode() != AUDIO_DATA) return;         // guard
-    uint32_t availableBytes = _client->available(); // available from stream
-    // chunked data tramsfer - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_chunked && availableBytes) {
-        uint8_t readedBytes = 0;
-        if(!chunkSize) chunkSize = chunkedDataTransfer(&readedBytes);
-        availableBytes = min(availableBytes, chunkSize);
-    }
-    // we have metadata  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_metadata && availableBytes) {
-        if(m_metacount == 0) {
-            chunkSize -= readMetadata(availableBytes);
-            return;
-        }
-        availableBytes = min(availableBytes, m_metacount);
-    }
+    uint32_t availableBytes = netAvailable();       // available from stream
 
     // if the buffer is often almost empty issue a warning - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) {
+    if(m_webStream.f_stream) {
         if(streamDetection(availableBytes)) return;
     }
 
-    // buffer fill routine - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    // buffer fill routine, chunk and metadata framing is stripped in place - - - - - - - - - - - - - - - - - - - - - -
     if(availableBytes) {
         availableBytes = min(availableBytes, (uint32_t)InBuff.writeSpace());
-        int16_t bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), availableBytes);
+        int32_t bytesRead = netRead(InBuff.getWritePtr(), availableBytes);
 
-        if(bytesAddedToBuffer > 0) {
-            if(m_f_metadata) m_metacount -= bytesAddedToBuffer;
-            if(m_f_chunked) chunkSize -= bytesAddedToBuffer;
-            InBuff.bytesWritten(bytesAddedToBuffer);
-        }
+        if(bytesRead > 0) InBuff.bytesWritten(unframeStream(InBuff.getWritePtr(), bytesRead));
 
-        if(InBuff.bufferFilled() > maxFrameSize && !f_stream) { // waiting for buffer filled
-            f_stream = true;                                    // ready to play the audio data
+        if(InBuff.bufferFilled() > maxFrameSize && !m_webStream.f_stream && netBufferReady()) { // waiting for buffer filled
+            m_webStream.f_stream = true;                                    // ready to play the audio data
             AUDIO_INFO("stream ready");
         }
-        if(!f_stream) return;
+        if(!m_webStream.f_stream) return;
         if(m_codec == CODEC_OGG) { // log_i("determine correct codec here");
             uint8_t codec = determineOggCodec(InBuff.getReadPtr(), maxFrameSize);
             if(codec == CODEC_FLAC) {
@@ -3317,27 +3587,31 @@ void Audio::processWebStream() {
         }
     }
 
+    // jitter buffer ran dry: count it and wait until the target depth is reached again - - - - - - - - - - - - - - - -
+    if(m_webStream.f_stream && !m_webStream.f_rebuffer && InBuff.bufferFilled() < maxFrameSize && !netAvailable()) {
+        m_webStream.f_rebuffer = true;
+        m_netUnderruns++;
+    }
+    if(m_webStream.f_rebuffer) {
+        if(!netBufferReady()) return;
+        m_webStream.f_rebuffer = false;
+    }
+
     // play audio data - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) { playAudioData(); }
+    if(m_webStream.f_stream) { playAudioData(); }
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::processWebFile() {
     const uint32_t  maxFrameSize = InBuff.getMaxBlockSize(); // every mp3/aac frame is not bigger
-    static bool     f_stream;                                // first audio data received
-    static bool     f_webFileDataComplete;                   // all file data received
-    static uint32_t byteCounter;
-    static uint32_t chunkSize;                               // chunkcount read from stream
-    static size_t   audioDataCount;                          // counts the decoded audiodata only
 
     // first call, set some values to default - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_f_firstCall) { // runs only ont time per connection, prepare for start
+    if(m_f_firstCall) { // runs only ont time per connection and after each range request, prepare for start
         m_f_firstCall = false;
         m_t0 = millis();
-        f_webFileDataComplete = false;
-        f_stream = false;
-        byteCounter = 0;
-        chunkSize = 0;
-        audioDataCount = 0;
+        m_webFile.f_webFileDataComplete = false;
+        m_webFile.f_stream = false;
+        m_webFile.chunkSize = 0;
+        m_webFile.audioDataCount = 0;
     }
 
     if(!m_contentlength && !m_f_tts) {
@@ -3346,48 +3620,78 @@ void Audio::processWebFile() {
         return;
     } // guard
 
-    uint32_t availableBytes = _client->available(); // available from stream
+    uint32_t availableBytes = netAvailable(); // available from stream
 
     // chunked data tramsfer - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_chunked) {
         uint8_t readedBytes = 0;
-        if(!chunkSize) chunkSize = chunkedDataTransfer(&readedBytes);
-        availableBytes = min(availableBytes, chunkSize);
-        if(m_f_tts) m_contentlength = chunkSize;
+        if(!m_webFile.chunkSize) m_webFile.chunkSize = max(chunkedDataTransfer(&readedBytes), (int32_t)0);
+        availableBytes = min((uint32_t)netAvailable(), m_webFile.chunkSize);
+        if(m_f_tts) m_contentlength = m_webFile.chunkSize;
+    }
+
+    // the server ignored the range, read over the data in front of the wanted position - - - - - - - - - - - - - - -
+    while(m_webFilePos < m_rangeSkipTo && availableBytes) {
+        uint8_t tmp[512];
+        int32_t n = netRead(tmp, min((uint32_t)sizeof(tmp), min(availableBytes, m_rangeSkipTo - m_webFilePos)));
+        if(n <= 0) break;
+        m_webFilePos += n;
+        m_webFileBytes += n;
+        availableBytes -= n;
     }
+    if(m_webFilePos < m_rangeSkipTo) return;
 
     // if the buffer is often almost empty issue a warning - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(!f_webFileDataComplete && f_stream) {
+    if(!m_webFile.f_webFileDataComplete && m_webFile.f_stream) {
+        if(!availableBytes && m_f_acceptRanges && m_webFilePos < m_contentlength && !_client->connected()) { // continue where the connection broke off
+            AUDIO_INFO("connection closed at byte %lu, continue with a range request", (long unsigned int)m_webFilePos);
+            m_netReconnects++;
+            webFileRange(m_webFilePos);
+            return;
+        }
         if(streamDetection(availableBytes)) return;
     }
 
     availableBytes = min((uint32_t)InBuff.writeSpace(), availableBytes);
-    availableBytes = min(m_contentlength - byteCounter, availableBytes);
-    if(m_audioDataSize) availableBytes = min(m_audioDataSize - (byteCounter - m_audioDataStart), availableBytes);
+    availableBytes = min(m_contentlength - m_webFilePos, availableBytes);
+    if(m_audioDataSize) availableBytes = min(m_audioDataSize - (m_webFilePos - m_audioDataStart), availableBytes);
 
-    int16_t bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), availableBytes);
+    int32_t bytesAddedToBuffer = netRead(InBuff.getWritePtr(), availableBytes);
 
     if(bytesAddedToBuffer > 0) {
-        byteCounter += bytesAddedToBuffer; // Pull request #42
+        m_webFilePos += bytesAddedToBuffer; // Pull request #42
+        m_webFileBytes += bytesAddedToBuffer;
         if(m_f_chunked) m_chunkcount -= bytesAddedToBuffer;
-        if(m_controlCounter == 100) audioDataCount += bytesAddedToBuffer;
+        if(m_controlCounter == 100) m_webFile.audioDataCount += bytesAddedToBuffer;
         InBuff.bytesWritten(bytesAddedToBuffer);
     }
 
-    if(!f_stream) {
-        if((InBuff.freeSpace() > maxFrameSize) && (byteCounter < m_contentlength)) return;
-        f_stream = true; // ready to play the audio data
+    if(!m_webFile.f_stream) {
+        if((InBuff.freeSpace() > maxFrameSize) && (m_webFilePos < m_contentlength)) return;
+        m_webFile.f_stream = true; // ready to play the audio data
         uint16_t filltime = millis() - m_t0;
         AUDIO_INFO("stream ready, buffer filled in %d ms", filltime);
+        if(m_rangeTime) { // request, response header and refill
+            m_rangeSeekMs = millis() - m_rangeTime;
+            m_rangeTime = 0;
+            if(m_f_Log) log_i("range request served in %lu ms", (long unsigned int)m_rangeSeekMs);
+        }
         return;
     }
 
     // we have a webfile, read the file header first - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter != 100) {
-        if(InBuff.bufferFilled() > maxFrameSize) { // read the file header first
+        if(InBuff.bufferFilled() > maxFrameSize || (m_webFilePos == m_contentlength && InBuff.bufferFilled())) {
             int32_t bytesRead = readAudioHeader(InBuff.getMaxAvailableBytes());
             if(bytesRead > 0) InBuff.bytesWasRead(bytesRead);
         }
+        if(m_headerSkip || m_headerSeekPos >= 0) { // over a picture or to an atom behind the audio data
+            uint32_t pos = (m_headerSeekPos >= 0) ? m_headerSeekPos : m_webFilePos - InBuff.bufferFilled() + m_headerSkip;
+            m_headerSkip = 0;
+            m_headerSeekPos = -1;
+            InBuff.resetBuffer();
+            webFileRange(pos);
+        }
         return;
     }
 
@@ -3412,16 +3716,33 @@ void Audio::processWebFile() {
         return;
     }
 
+    // setFilePos(): request the new position, the decoder seeks the next frame header in the new data - - - - - - - - -
+    if(m_resumeFilePos >= 0) {
+        uint32_t pos = max((uint32_t)m_resumeFilePos, m_audioDataStart);
+        uint32_t end = m_audioDataSize ? m_audioDataStart + m_audioDataSize : m_contentlength;
+        m_resumeFilePos = -1;
+        if(pos < end) {
+            if(m_codec == CODEC_WAV) pos -= (pos - m_audioDataStart) % (getChannels() * m_wavBytesPerSample); // whole frames
+            m_haveNewFilePos = pos;
+            if(AudioCodec_Get(m_codec) && AudioCodec_Get(m_codec)->flush) AudioCodec_Get(m_codec)->flush();
+            m_f_playing = false;
+            InBuff.resetBuffer();
+            webFileRange(pos);
+            return;
+        }
+    }
+
     // end of webfile reached? - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_webFileDataComplete && InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {
+    if(m_webFile.f_webFileDataComplete && InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {
+        if(m_validSamples) { // play samples first, also those of the last frame that I2S has not taken yet
+            playChunk();
+            return;
+        }
         if(InBuff.bufferFilled()) {
             if(!readID3V1Tag()) {
-                if(m_validSamples) {
-                    playChunk();
-                    return;
-                } // play samples first
+                bool f_sync = !m_f_playing; // this call only looks for the syncword
                 int bytesDecoded = sendBytes(InBuff.getReadPtr(), InBuff.bufferFilled());
-                if(bytesDecoded > 2) {
+                if(bytesDecoded > 0 || (f_sync && m_f_playing)) { // a FLAC frame ends with a call that reads only the 2 byte CRC
                     InBuff.bytesWasRead(bytesDecoded);
                     return;
                 }
@@ -3430,12 +3751,7 @@ void Audio::processWebFile() {
 
         m_f_running = false;
         m_streamType = ST_NONE;
-        if(m_codec == CODEC_MP3) MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
-        if(m_codec == CODEC_OPUS) OPUSDecoder_FreeBuffers();
-        if(m_codec == CODEC_VORBIS) VORBISDecoder_FreeBuffers();
+        if(AudioCodec_Get(m_codec)) AudioCodec_Get(m_codec)->freeBuffers();
         m_codec = CODEC_NONE;
         if(m_f_tts) {
             AUDIO_INFO("End of speech: \"%s\"", m_lastHost);
@@ -3448,125 +3764,136 @@ void Audio::processWebFile() {
         return;
     }
 
-    if(byteCounter == m_contentlength) { f_webFileDataComplete = true; }
-    if(byteCounter - m_audioDataStart == m_audioDataSize) { f_webFileDataComplete = true; }
+    if(m_webFilePos == m_contentlength) {
+        m_webFile.f_webFileDataComplete = true;
+        m_f_bodyRead = !m_f_chunked;
+    }
+    if(m_webFilePos - m_audioDataStart == m_audioDataSize) { m_webFile.f_webFileDataComplete = true; }
 
     // play audio data - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) { playAudioData(); }
+    if(m_webFile.f_stream) { playAudioData(); }
     return;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::processWebStreamTS() {
     const uint16_t  maxFrameSize = InBuff.getMaxBlockSize(); // every mp3/aac frame is not bigger
     uint32_t        availableBytes;                          // available bytes in stream
-    static bool     f_stream;                                // first audio data received
-    static bool     f_firstPacket;
-    static bool     f_chunkFinished;
-    static uint32_t byteCounter;    // count received data
-    static uint8_t  ts_packet[188]; // m3u8 transport stream is 188 bytes long
-    uint8_t         ts_packetStart = 0;
-    uint8_t         ts_packetLength = 0;
-    static uint8_t  ts_packetPtr = 0;
-    const uint8_t   ts_packetsize = 188;
-    static size_t   chunkSize = 0;
 
     // first call, set some values to default - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { // runs only ont time per connection, prepare for start
-        f_stream = false;
-        f_firstPacket = true;
-        f_chunkFinished = false;
-        byteCounter = 0;
-        chunkSize = 0;
+        m_webTS.f_stream = false;
+        m_webTS.f_firstPacket = true;
+        m_webTS.f_chunkFinished = false;
+        m_webTS.byteCounter = 0;
+        m_webTS.chunkSize = 0;
         m_t0 = millis();
-        ts_packetPtr = 0;
+        m_webTS.ts_fill = 0;
+        m_tsDemux.newSegment();
         m_controlCounter = 0;
         m_f_firstCall = false;
     }
 
     if(getDatamode() != AUDIO_DATA) return; // guard
 
-    if(InBuff.freeSpace() < maxFrameSize && f_stream) {
+    if(InBuff.freeSpace() < maxFrameSize && m_webTS.f_stream) {
         playAudioData();
         return;
     }
 
-    availableBytes = _client->available();
-    if(availableBytes) {
+    bool prefetch = hlsPrefetching();
+    if(prefetch && m_webTS.ts_fill < TS_PACKET_SIZE && hlsNextSegment()) { // the next segment follows, the decoder goes on
+        m_webTS.f_firstPacket = true;
+        m_webTS.byteCounter = 0;
+        m_webTS.ts_fill = 0;
+        m_tsDemux.newSegment();
+    }
+
+    availableBytes = prefetch ? m_hlsPrefetch.available() : netAvailable();
+    if(availableBytes && m_webTS.ts_fill < sizeof(m_webTS.ts_batch)) {
         uint8_t readedBytes = 0;
-        if(m_f_chunked) chunkSize = chunkedDataTransfer(&readedBytes);
-        int res = _client->read(ts_packet + ts_packetPtr, ts_packetsize - ts_packetPtr);
+        if(m_f_chunked && !m_webTS.chunkSize && !prefetch) m_webTS.chunkSize = max(chunkedDataTransfer(&readedBytes), (int32_t)0);
+        size_t   want = sizeof(m_webTS.ts_batch) - m_webTS.ts_fill;
+        uint32_t segmentLen = m_f_chunked ? m_webTS.chunkSize : m_contentlength;
+        if(!prefetch && segmentLen > m_webTS.byteCounter) want = min(want, (size_t)(segmentLen - m_webTS.byteCounter)); // not beyond the segment
+        int res = prefetch ? m_hlsPrefetch.read(m_webTS.ts_batch + m_webTS.ts_fill, want) : netRead(m_webTS.ts_batch + m_webTS.ts_fill, want);
         if(res > 0) {
-            ts_packetPtr += res;
-            byteCounter += res;
-            if(ts_packetPtr < ts_packetsize) return;
-            ts_packetPtr = 0;
-            if(f_firstPacket) { // search for ID3 Header in the first packet
-                f_firstPacket = false;
-                uint8_t ID3_HeaderSize = process_m3u8_ID3_Header(ts_packet);
-                if(ID3_HeaderSize > ts_packetsize) {
-                    log_e("ID3 Header is too big");
-                    stopSong();
-                    return;
-                }
-                if(ID3_HeaderSize) {
-                    memcpy(ts_packet, &ts_packet[ID3_HeaderSize], ts_packetsize - ID3_HeaderSize);
-                    ts_packetPtr = ts_packetsize - ID3_HeaderSize;
-                    return;
-                }
+            m_webTS.ts_fill += res;
+            m_webTS.byteCounter += res;
+            if(!prefetch && m_webTS.byteCounter == segmentLen) { // else hlsNextSegment()
+                m_webTS.f_chunkFinished = true;
+                m_f_bodyRead = !m_f_chunked;
+                m_webTS.byteCounter = 0;
+                m_webTS.chunkSize = 0;
             }
-            ts_parsePacket(&ts_packet[0], &ts_packetStart, &ts_packetLength);
+        }
+    }
 
-            if(ts_packetLength) {
-                size_t ws = InBuff.writeSpace();
-                if(ws >= ts_packetLength) {
-                    memcpy(InBuff.getWritePtr(), ts_packet + ts_packetStart, ts_packetLength);
-                    InBuff.bytesWritten(ts_packetLength);
-                }
-                else {
-                    memcpy(InBuff.getWritePtr(), ts_packet + ts_packetStart, ws);
-                    InBuff.bytesWritten(ws);
-                    memcpy(InBuff.getWritePtr(), &ts_packet[ws + ts_packetStart], ts_packetLength - ws);
-                    InBuff.bytesWritten(ts_packetLength - ws);
-                }
-            }
-            if (byteCounter == m_contentlength || byteCounter == chunkSize) {
-                f_chunkFinished = true;
-                byteCounter = 0;
-            }
-            if(byteCounter > m_contentlength) log_e("byteCounter overflow");
+    if(m_webTS.f_firstPacket && m_webTS.ts_fill >= TS_PACKET_SIZE) { // search for ID3 Header in front of the first packet
+        size_t ID3_HeaderSize = process_m3u8_ID3_Header(m_webTS.ts_batch);
+        if(ID3_HeaderSize > m_webTS.ts_fill) {
+            if(m_webTS.ts_fill < sizeof(m_webTS.ts_batch) && !m_webTS.f_chunkFinished) return; // not complete yet
+            log_e("ID3 Header is too big");
+            stopSong();
+            return;
+        }
+        m_webTS.f_firstPacket = false;
+        m_webTS.ts_fill -= ID3_HeaderSize;
+        memmove(m_webTS.ts_batch, m_webTS.ts_batch + ID3_HeaderSize, m_webTS.ts_fill);
+    }
+
+    // demux a batch of packets straight into the input buffer - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    if(!m_webTS.f_firstPacket && m_webTS.ts_fill >= TS_PACKET_SIZE && InBuff.freeSpace() >= TS_MAX_PAYLOAD) {
+        size_t used = 0;
+        size_t ws = InBuff.writeSpace();
+        if(ws >= TS_MAX_PAYLOAD) { InBuff.bytesWritten(m_tsDemux.demux(m_webTS.ts_batch, m_webTS.ts_fill, InBuff.getWritePtr(), ws, &used)); }
+        else { // end of the ring, one packet through a bounce buffer
+            uint8_t bounce[TS_MAX_PAYLOAD];
+            size_t  es = m_tsDemux.demux(m_webTS.ts_batch, TS_PACKET_SIZE, bounce, sizeof(bounce), &used);
+            size_t  n = min(es, ws);
+            memcpy(InBuff.getWritePtr(), bounce, n);
+            InBuff.bytesWritten(n);
+            memcpy(InBuff.getWritePtr(), bounce + n, es - n);
+            InBuff.bytesWritten(es - n);
+        }
+        m_webTS.ts_fill -= used;
+        if(m_webTS.ts_fill) memmove(m_webTS.ts_batch, m_webTS.ts_batch + used, m_webTS.ts_fill); // less than a packet, or the rest of a full buffer
+        if(m_tsDemux.noAudio()) {
+            log_e("no AAC stream in the transport stream");
+            stopSong();
+            return;
         }
     }
-    if(f_chunkFinished) {
+    if(m_webTS.f_chunkFinished && m_webTS.ts_fill < TS_PACKET_SIZE) { // all packets of the segment demuxed
         if(m_f_psramFound) {
             if(InBuff.bufferFilled() < 50000) {
-                f_chunkFinished = false;
+                m_webTS.f_chunkFinished = false;
                 m_f_continue = true;
             }
         }
         else {
-            f_chunkFinished = false;
+            m_webTS.f_chunkFinished = false;
             m_f_continue = true;
         }
     }
 
     // if the buffer is often almost empty issue a warning - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) {
+    if(m_webTS.f_stream) {
         if(streamDetection(availableBytes)) return;
     }
 
     // buffer fill routine  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(true) {                                                  // statement has no effect
-        if(InBuff.bufferFilled() > 50000 && !f_stream) {        // waiting for buffer filled
-            f_stream = true;                                    // ready to play the audio data
+        if(InBuff.bufferFilled() > 50000 && !m_webTS.f_stream) {        // waiting for buffer filled
+            m_webTS.f_stream = true;                                    // ready to play the audio data
             uint16_t filltime = millis() - m_t0;
             if(m_f_Log) AUDIO_INFO("stream ready");
             if(m_f_Log) AUDIO_INFO("buffer filled in %d ms", filltime);
         }
-        if(!f_stream) return;
+        if(!m_webTS.f_stream) return;
     }
 
     // play audio data - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) { playAudioData(); }
+    if(m_webTS.f_stream) { playAudioData(); }
     return;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -3575,50 +3902,56 @@ void Audio::processWebStreamHLS() {
     uint16_t       ID3BuffSize = 1024;
     if(m_f_psramFound) ID3BuffSize = 4096;
     uint32_t        availableBytes; // available bytes in stream
-    static bool     f_stream;       // first audio data received
-    static bool     firstBytes;
-    static bool     f_chunkFinished;
-    static uint32_t byteCounter; // count received data
-    static size_t   chunkSize = 0;
-    static uint16_t ID3WritePtr;
-    static uint16_t ID3ReadPtr;
-    static uint8_t* ID3Buff;
 
     // first call, set some values to default - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_firstCall) { // runs only ont time per connection, prepare for start
-        f_stream = false;
-        f_chunkFinished = false;
-        byteCounter = 0;
-        chunkSize = 0;
-        ID3WritePtr = 0;
-        ID3ReadPtr = 0;
+        m_webHLS.f_stream = false;
+        m_webHLS.f_chunkFinished = false;
+        m_webHLS.byteCounter = 0;
+        m_webHLS.chunkSize = 0;
+        m_webHLS.ID3WritePtr = 0;
+        m_webHLS.ID3ReadPtr = 0;
         m_t0 = millis();
         m_f_firstCall = false;
-        firstBytes = true;
-        ID3Buff = (uint8_t*)malloc(ID3BuffSize);
+        m_webHLS.firstBytes = true;
+        m_webHLS.ID3Buff = (uint8_t*)malloc(ID3BuffSize);
         m_controlCounter = 0;
     }
 
     if(getDatamode() != AUDIO_DATA) return; // guard
 
-    availableBytes = _client->available();
+    bool prefetch = hlsPrefetching();
+    if(prefetch && hlsNextSegment()) { // the next segment starts with its own ID3 header, the decoder goes on
+        m_webHLS.firstBytes = true;
+        m_webHLS.byteCounter = 0;
+        m_webHLS.ID3WritePtr = 0;
+        m_webHLS.ID3ReadPtr = 0;
+        m_controlCounter = 0;
+        if(!m_webHLS.ID3Buff) m_webHLS.ID3Buff = (uint8_t*)malloc(ID3BuffSize);
+    }
+
+    availableBytes = prefetch ? m_hlsPrefetch.available() : netAvailable();
     if(availableBytes) { // an ID3 header could come here
         uint8_t readedBytes = 0;
 
-        if(m_f_chunked && !chunkSize) {
-            chunkSize = chunkedDataTransfer(&readedBytes);
-            byteCounter += readedBytes;
+        if(m_f_chunked && !m_webHLS.chunkSize && !prefetch) {
+            int32_t n = chunkedDataTransfer(&readedBytes);
+            if(n < 0) return; // the chunk size line is not complete yet
+            m_webHLS.chunkSize = n;
+            m_webHLS.byteCounter += readedBytes;
+            availableBytes = netAvailable();
         }
 
-        if(firstBytes) {
-            if(ID3WritePtr < ID3BuffSize) {
-                ID3WritePtr += _client->readBytes(&ID3Buff[ID3WritePtr], ID3BuffSize - ID3WritePtr);
+        if(m_webHLS.firstBytes) {
+            if(m_webHLS.ID3WritePtr < ID3BuffSize) {
+                if(prefetch) m_webHLS.ID3WritePtr += m_hlsPrefetch.read(&m_webHLS.ID3Buff[m_webHLS.ID3WritePtr], ID3BuffSize - m_webHLS.ID3WritePtr);
+                else m_webHLS.ID3WritePtr += max(netRead(&m_webHLS.ID3Buff[m_webHLS.ID3WritePtr], ID3BuffSize - m_webHLS.ID3WritePtr), (int32_t)0);
                 return;
             }
             if(m_controlCounter < 100) {
-                int res = read_ID3_Header(&ID3Buff[ID3ReadPtr], ID3BuffSize - ID3ReadPtr);
-                if(res >= 0) ID3ReadPtr += res;
-                if(ID3ReadPtr > ID3BuffSize) {
+                int res = read_ID3_Header(&m_webHLS.ID3Buff[m_webHLS.ID3ReadPtr], ID3BuffSize - m_webHLS.ID3ReadPtr);
+                if(res >= 0) m_webHLS.ID3ReadPtr += res;
+                if(m_webHLS.ID3ReadPtr > ID3BuffSize) {
                     log_e("buffer overflow");
                     stopSong();
                     return;
@@ -3628,68 +3961,205 @@ void Audio::processWebStreamHLS() {
             if(m_controlCounter != 100) return;
 
             size_t ws = InBuff.writeSpace();
-            if(ws >= ID3BuffSize - ID3ReadPtr) {
-                memcpy(InBuff.getWritePtr(), &ID3Buff[ID3ReadPtr], ID3BuffSize - ID3ReadPtr);
-                InBuff.bytesWritten(ID3BuffSize - ID3ReadPtr);
+            if(ws >= ID3BuffSize - m_webHLS.ID3ReadPtr) {
+                memcpy(InBuff.getWritePtr(), &m_webHLS.ID3Buff[m_webHLS.ID3ReadPtr], ID3BuffSize - m_webHLS.ID3ReadPtr);
+                InBuff.bytesWritten(ID3BuffSize - m_webHLS.ID3ReadPtr);
             }
             else {
-                memcpy(InBuff.getWritePtr(), &ID3Buff[ID3ReadPtr], ws);
+                memcpy(InBuff.getWritePtr(), &m_webHLS.ID3Buff[m_webHLS.ID3ReadPtr], ws);
                 InBuff.bytesWritten(ws);
-                memcpy(InBuff.getWritePtr(), &ID3Buff[ws + ID3ReadPtr], ID3BuffSize - (ID3ReadPtr + ws));
-                InBuff.bytesWritten(ID3BuffSize - (ID3ReadPtr + ws));
+                memcpy(InBuff.getWritePtr(), &m_webHLS.ID3Buff[ws + m_webHLS.ID3ReadPtr], ID3BuffSize - (m_webHLS.ID3ReadPtr + ws));
+                InBuff.bytesWritten(ID3BuffSize - (m_webHLS.ID3ReadPtr + ws));
             }
-            if(ID3Buff) free(ID3Buff);
-            byteCounter += ID3BuffSize;
-            ID3Buff = NULL;
-            firstBytes = false;
+            if(m_webHLS.ID3Buff) free(m_webHLS.ID3Buff);
+            m_webHLS.byteCounter += ID3BuffSize;
+            m_webHLS.ID3Buff = NULL;
+            m_webHLS.firstBytes = false;
         }
 
         size_t bytesWasWritten = 0;
-        if(InBuff.writeSpace() >= availableBytes) {
+        if(prefetch) { bytesWasWritten = m_hlsPrefetch.read(InBuff.getWritePtr(), InBuff.writeSpace()); } // memcpy, no throttle
+        else if(InBuff.writeSpace() >= availableBytes) {
             if(availableBytes > 1024) availableBytes = 1024; // 1K throttle
-            bytesWasWritten = _client->read(InBuff.getWritePtr(), availableBytes);
+            bytesWasWritten = max(netRead(InBuff.getWritePtr(), availableBytes), (int32_t)0);
         }
-        else { bytesWasWritten = _client->read(InBuff.getWritePtr(), InBuff.writeSpace()); }
+        else { bytesWasWritten = max(netRead(InBuff.getWritePtr(), InBuff.writeSpace()), (int32_t)0); }
         InBuff.bytesWritten(bytesWasWritten);
 
-        byteCounter += bytesWasWritten;
+        m_webHLS.byteCounter += bytesWasWritten;
 
-        if(byteCounter == m_contentlength || byteCounter == chunkSize) {
-            f_chunkFinished = true;
-            byteCounter = 0;
+        if(!prefetch && (m_webHLS.byteCounter == m_contentlength || m_webHLS.byteCounter == m_webHLS.chunkSize)) { // else hlsNextSegment()
+            m_webHLS.f_chunkFinished = true;
+            m_f_bodyRead = !m_f_chunked;
+            m_webHLS.byteCounter = 0;
         }
     }
 
-    if(f_chunkFinished) {
+    if(m_webHLS.f_chunkFinished) {
         if(m_f_psramFound) {
             if(InBuff.bufferFilled() < 50000) {
-                f_chunkFinished = false;
+                m_webHLS.f_chunkFinished = false;
                 m_f_continue = true;
             }
         }
         else {
-            f_chunkFinished = false;
+            m_webHLS.f_chunkFinished = false;
             m_f_continue = true;
         }
     }
 
     // if the buffer is often almost empty issue a warning or try a new connection - - - - - - - - - - - - - - - - - - -
-    if(f_stream) {
+    if(m_webHLS.f_stream) {
         if(streamDetection(availableBytes)) return;
     }
 
-    if(InBuff.bufferFilled() > maxFrameSize && !f_stream) { // waiting for buffer filled
-        f_stream = true;                                    // ready to play the audio data
+    if(InBuff.bufferFilled() > maxFrameSize && !m_webHLS.f_stream) { // waiting for buffer filled
+        m_webHLS.f_stream = true;                                    // ready to play the audio data
         uint16_t filltime = millis() - m_t0;
         if(m_f_Log) AUDIO_INFO("stream ready");
         if(m_f_Log) AUDIO_INFO("buffer filled in %u ms", filltime);
     }
 
     // play audio data - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(f_stream) { playAudioData(); }
+    if(m_webHLS.f_stream) { playAudioData(); }
     return;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::hlsPrefetching() {
+    return AUDIO_HLS_PREFETCH > 0 && m_hlsPrefetch.isActive();
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::hlsPrefetchStart() {
+    // first segment of a m3u8 stream: from now on the segments are loaded by the prefetch task, Audio's own
+    // connection is not needed any longer. Returns false if the stream goes on without it.
+    if(AUDIO_HLS_PREFETCH == 0 || !m_f_psramFound) return false;
+    if(!m_hlsPrefetch.begin(AUDIO_HLS_PREFETCH)) return false;
+    if(endsWith(m_playlistBuff, ".mp3")) m_codec = CODEC_MP3; // no response header tells the content type
+    if(!initializeDecoder()) return true; // the song has been stopped
+    m_hlsPrefetch.push(m_playlistBuff, m_hlsSegmentMs);
+    _client->stop();
+    m_hlsPlaylistTime = millis();
+    m_hlsRefreshMs = m_m3u8_targetDuration * 1000;
+    m_controlCounter = 0;
+    m_f_firstCall = true;
+    setDatamode(AUDIO_DATA);
+    if(m_f_Log) AUDIO_INFO("hls prefetch, %u segments ahead", AUDIO_HLS_PREFETCH);
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::hlsPrefetchFeed() {
+    // hands the known segments to the prefetch task and refreshes the playlist in the background,
+    // after the target duration if it has changed, after half of it if not (RFC 8216, 6.3.4)
+    size_t len = 0;
+    char*  pl = m_hlsPrefetch.playlist(&len);
+    if(pl) {
+        vector_clear_and_shrink(m_playlistContent);
+        char* next = NULL;
+        for(char* line = strtok_r(pl, "\r\n", &next); line; line = strtok_r(NULL, "\r\n", &next)) {
+            m_playlistContent.push_back(x_strdup(line));
+        }
+        if(!m_playlistContent.size()) {
+            log_w("playlist refresh failed");
+            m_hlsRefreshMs = m_m3u8_targetDuration * 500;
+        }
+    }
+    bool    parse = m_playlistContent.size() > 0;
+    size_t  queued = m_playlistURL.size();
+    uint8_t pushed = 0;
+    while(m_hlsPrefetch.hasRoom() && (m_playlistContent.size() || m_playlistURL.size())) {
+        const char* host = parsePlaylist_M3U8();
+        if(!hlsPrefetching() || getDatamode() != AUDIO_DATA) return; // the playlist parser has started anew
+        if(!host || host != m_playlistBuff) break;
+        m_hlsPrefetch.push(m_playlistBuff, m_hlsSegmentMs);
+        pushed++;
+    }
+    if(parse && !m_playlistContent.size()) { // the refresh has been read
+        bool changed = m_playlistURL.size() + pushed > queued;
+        m_hlsRefreshMs = m_m3u8_targetDuration * (changed ? 1000 : 500);
+    }
+    if(!m_playlistContent.size() && millis() - m_hlsPlaylistTime > m_hlsRefreshMs) {
+        if(m_hlsPrefetch.fetchPlaylist(m_lastM3U8host ? m_lastM3U8host : m_lastHost)) m_hlsPlaylistTime = millis();
+    }
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::hlsNextSegment() {
+    // the current segment is read completely, its download time is held against its duration
+    hlsSegmentStat_t st;
+    if(!m_hlsPrefetch.segmentEnd() || !m_hlsPrefetch.nextSegment(&st)) return false;
+    m_hlsSegments++;
+    if(st.failed) m_hlsFailed++;
+    if(st.durationMs) {
+        uint32_t load = st.loadMs * 100 / st.durationMs;
+        if(load > m_hlsWorstLoad) m_hlsWorstLoad = load;
+        if(load > 100) m_hlsLate++;
+    }
+    if(st.failed) { AUDIO_INFO("hls segment lost after %lu bytes", (long unsigned)st.bytes); }
+    else if(m_f_Log) {
+        AUDIO_INFO("hls segment: %lu bytes, first byte after %lu ms, loaded in %lu ms of %lu ms", (long unsigned)st.bytes,
+                   (long unsigned)st.ttfbMs, (long unsigned)st.loadMs, (long unsigned)st.durationMs);
+    }
+    hlsSelectVariant(&st);
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t Audio::hlsThroughput() {
+    // bit/s, the lower average: a drop counts at once, a single fast segment does not
+    return min(m_hlsBwFast, m_hlsBwSlow);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int8_t Audio::hlsChooseVariant(uint32_t bps) {
+    // the highest variant that the throughput carries with the margin AUDIO_HLS_SWITCH_UP, else the lowest one
+    if(!bps) bps = (uint64_t)AUDIO_HLS_START_BANDWIDTH * AUDIO_HLS_SWITCH_UP / 100; // nothing measured yet
+    int8_t v = 0;
+    for(int i = 0; i < m_hlsVariants.size(); i++) {
+        if((uint64_t)m_hlsVariants[i].bandwidth * AUDIO_HLS_SWITCH_UP <= (uint64_t)bps * 100) v = i;
+    }
+    return v;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::hlsSelectVariant(const hlsSegmentStat_t* st) {
+    // called at every segment boundary. Up: after AUDIO_HLS_SWITCH_HOLD segments, if the throughput carries the higher
+    // variant with margin. Down: as soon as the throughput falls below AUDIO_HLS_SWITCH_DOWN percent of the current
+    // bandwidth. The new media playlist is fetched at once, its segments follow the ones already queued (aligned by
+    // the media sequence number, see parsePlaylist_M3U8()), all variants have the same CODECS, so the decoder goes on.
+    if(st->loadMs && st->bytes >= 4096) { // a few bytes say nothing about the link
+        uint32_t bps = (uint64_t)st->bytes * 8000 / st->loadMs;
+        m_hlsBwFast = m_hlsBwFast ? (m_hlsBwFast + bps) / 2 : bps;
+        m_hlsBwSlow = m_hlsBwSlow ? (m_hlsBwSlow * 7 + bps) / 8 : bps;
+    }
+    if(m_hlsHold < 255) m_hlsHold++;
+    if(m_hlsVariants.size() < 2 || m_hlsVariant < 0) return;
+
+    uint32_t bps = hlsThroughput();
+    int8_t   v = hlsChooseVariant(bps);
+    uint32_t cur = m_hlsVariants[m_hlsVariant].bandwidth;
+    if(v == m_hlsVariant) return;
+    if(v > m_hlsVariant && m_hlsHold < AUDIO_HLS_SWITCH_HOLD) return;
+    if(v < m_hlsVariant && (uint64_t)bps * 100 >= (uint64_t)cur * AUDIO_HLS_SWITCH_DOWN) return; // hysteresis
+
+    AUDIO_INFO("hls variant %i -> %i, %lu -> %lu bit/s, throughput %lu bit/s", m_hlsVariant + 1, v + 1, (long unsigned)cur,
+               (long unsigned)m_hlsVariants[v].bandwidth, (long unsigned)bps);
+    m_hlsVariant = v;
+    m_hlsHold = 0;
+    m_hlsSwitches++;
+    if(m_hlsHistoryLen == sizeof(m_hlsHistory) / sizeof(m_hlsHistory[0])) {
+        memmove(m_hlsHistory, m_hlsHistory + 1, sizeof(m_hlsHistory) - sizeof(m_hlsHistory[0]));
+        m_hlsHistoryLen--;
+    }
+    m_hlsHistory[m_hlsHistoryLen++] = m_hlsVariants[v].bandwidth;
+    if(m_lastM3U8host) free(m_lastM3U8host);
+    m_lastM3U8host = strdup(m_hlsVariants[v].url);
+    m_hlsRefreshMs = 0;
+    m_f_hlsAlign = true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::hlsVariantsClear() {
+    for(int i = 0; i < m_hlsVariants.size(); i++) free(m_hlsVariants[i].url);
+    m_hlsVariants.clear();
+    m_hlsVariants.shrink_to_fit();
+    m_hlsVariant = -1;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::playAudioData() {
     if(m_validSamples) {
         playChunk();
@@ -3721,60 +4191,25 @@ bool Audio::parseHttpResponseHeader() { // this is the response to a GET / reque
 
     if(getDatamode() != HTTP_RESPONSE_HEADER) return false;
 
-    uint32_t ctime = millis();
     uint32_t timeout = 2500; // ms
 
-    static uint32_t stime;
-    static bool     f_time = false;
-    if(_client->available() == 0) {
-        if(!f_time) {
-            stime = millis();
-            f_time = true;
-        }
-        if((millis() - stime) > timeout) {
-            log_e("timeout");
-            f_time = false;
-            return false;
-        }
-    }
-    f_time = false;
-
-    char rhl[512] = {0}; // responseHeaderline
-    bool ct_seen = false;
-
-    while(true) { // outer while
-        uint16_t pos = 0;
-        if((millis() - ctime) > timeout) {
+    while(true) { // one header line per pass, returns if the socket has no more bytes
+        if(!netAvailable()) {
+            if((millis() - m_httpTime) < timeout) return false; // not complete yet, continue in the next loop()
             log_e("timeout");
+            m_httpTime = millis();
+            if(!m_f_httpData) return false; // no response yet, keep waiting
             m_f_timeout = true;
             goto exit;
         }
-        while(_client->available()) {
-            uint8_t b = _client->read();
-            if(b == '\n') {
-                if(!pos) { // empty line received, is the last line of this responseHeader
-                    if(ct_seen) goto lastToDo;
-                    else goto exit;
-                }
-                break;
-            }
-            if(b == '\r') rhl[pos] = 0;
-            if(b < 0x20) continue;
-            rhl[pos] = b;
-            pos++;
-            if(pos == 511) {
-                pos = 510;
-                continue;
-            }
-            if(pos == 510) {
-                rhl[pos] = '\0';
-                if(m_f_Log) log_i("responseHeaderline overflow");
-            }
-        } // inner while
+        m_f_httpData = true;
+        m_httpTime = millis();
+        if(!readHttpLine()) continue;
 
-        if(!pos) {
-            vTaskDelay(5);
-            continue;
+        char* rhl = m_httpParser.line(); // responseHeaderline
+        if(!rhl[0]) { // empty line received, is the last line of this responseHeader
+            if(m_f_ctSeen || m_f_rangeRequest) goto lastToDo;
+            else goto exit;
         }
 
         //log_i("httpResponseHeader: %s", rhl);
@@ -3801,7 +4236,8 @@ bool Audio::parseHttpResponseHeader() { // this is the response to a GET / reque
             // log_i("cT: %s", rhl);
             int idx = indexOf(rhl + 13, ";");
             if(idx > 0) rhl[13 + idx] = '\0';
-            if(parseContentType(rhl + 13)) ct_seen = true;
+            if(m_f_rangeRequest) { ; } // the same file again, keep the codec
+            else if(parseContentType(rhl + 13)) m_f_ctSeen = true;
             else goto exit;
         }
 
@@ -3818,8 +4254,7 @@ bool Audio::parseHttpResponseHeader() { // this is the response to a GET / reque
                                 strcpy(m_lastHost, c_host);
                                 m_f_m3u8data = true;
                             }
-                            httpPrint(c_host);
-                            while(_client->available()) _client->read(); // empty client buffer
+                            httpPrint(c_host); // closes the connection, the body of the redirect is not read
                             return true;
                         }
                     }
@@ -3852,7 +4287,7 @@ bool Audio::parseHttpResponseHeader() { // this is the response to a GET / reque
         }
 
         else if(startsWith(rhl, "connection:")) {
-            if(indexOf(rhl, "close", 0) >= 0) { ; /* do nothing */ }
+            if(indexOf(rhl, "close", 0) >= 0) m_f_connClose = true; // httpPrint() must not reuse the connection
         }
 
         else if(startsWith(rhl, "icy-genre:")) {
@@ -3896,15 +4331,27 @@ bool Audio::parseHttpResponseHeader() { // this is the response to a GET / reque
         else if(startsWith(rhl, "content-length:")) {
             const char* c_cl = (rhl + 15);
             int32_t     i_cl = atoi(c_cl);
-            m_contentlength = i_cl;
+            if(!m_f_rangeRequest) m_contentlength = i_cl; // a range response has the length of the rest only
             m_streamType = ST_WEBFILE; // Stream comes from a fileserver
-            if(m_f_Log) AUDIO_INFO("content-length: %lu", (long unsigned int)m_contentlength);
+            if(m_f_Log) AUDIO_INFO("content-length: %lu", (long unsigned int)i_cl);
+        }
+
+        else if(startsWith(rhl, "accept-ranges:")) {
+            if(indexOf(rhl, "bytes", 0) > 0) m_f_acceptRanges = true; // "none" otherwise
+            if(m_f_Log) AUDIO_INFO("%s", rhl);
+        }
+
+        else if(startsWith(rhl, "content-range:")) { // e.g. content-range: bytes 21010-47021/47022
+            int pos1 = indexOf(rhl, "bytes", 0);
+            int pos2 = indexOf(rhl, "/", 0);
+            if(pos1 > 0) m_rangeStart = strtoul(rhl + pos1 + 5, NULL, 10);
+            if(pos2 > 0 && isdigit(rhl[pos2 + 1])) m_contentlength = strtoul(rhl + pos2 + 1, NULL, 10); // whole file
         }
 
         else if(startsWith(rhl, "icy-description:")) {
             const char* c_idesc = (rhl + 16);
             while(c_idesc[0] == ' ') c_idesc++;
-            latinToUTF8(rhl, sizeof(rhl)); // if already UTF-8 do nothing, otherwise convert to UTF-8
+            latinToUTF8(rhl, HTTP_LINE_SIZE); // if already UTF-8 do nothing, otherwise convert to UTF-8
             if(strlen(c_idesc) > 0 && specialIndexOf((uint8_t*)c_idesc, "24bit", 0) > 0) {
                 AUDIO_INFO("icy-description: %s has to be 8 or 16", c_idesc);
                 stopSong();
@@ -3931,7 +4378,7 @@ bool Audio::parseHttpResponseHeader() { // this is the response to a GET / reque
             goto exit;
         }
         else { ; }
-    } // outer while
+    }
 
 exit: // termination condition
     if(audio_showstation) audio_showstation("");
@@ -3944,6 +4391,20 @@ exit: // termination condition
     return false;
 
 lastToDo:
+    if(m_f_rangeRequest) { // answer to webFileRange(), the decoder continues
+        m_f_rangeRequest = false;
+        m_rangeSkipTo = m_webFilePos;
+        if(m_rangeStart < 0) { // 200 instead of 206: the whole file comes again
+            AUDIO_INFO("the server ignores ranges, reading over %lu bytes", (long unsigned int)m_webFilePos);
+            m_f_acceptRanges = false;
+            m_rangeStart = 0;
+        }
+        m_webFilePos = m_rangeStart;
+        m_streamType = ST_WEBFILE;
+        setDatamode(AUDIO_DATA);
+        m_f_firstCall = true;
+        return true;
+    }
     if(m_codec != CODEC_NONE) {
         setDatamode(AUDIO_DATA); // Expecting data now
         if(!initializeDecoder()) return false;
@@ -3966,86 +4427,30 @@ lastToDo:
 bool Audio::initializeDecoder() {
     uint32_t gfH = 0;
     uint32_t hWM = 0;
-    switch(m_codec) {
-        case CODEC_MP3:
-            if(!MP3Decoder_IsInit()){
-                if(!MP3Decoder_AllocateBuffers()) {
-                    AUDIO_INFO("The MP3Decoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("MP3Decoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeMP3);
-            }
-            break;
-        case CODEC_AAC:
-            if(!AACDecoder_IsInit()) {
-                if(!AACDecoder_AllocateBuffers()) {
-                    AUDIO_INFO("The AACDecoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("AACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-            break;
-        case CODEC_M4A:
-            if(!AACDecoder_IsInit()) {
-                if(!AACDecoder_AllocateBuffers()) {
-                    AUDIO_INFO("The AACDecoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("AACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-            break;
-        case CODEC_FLAC:
-            if(!psramFound()) {
-                AUDIO_INFO("FLAC works only with PSRAM!");
-                goto exit;
-            }
-            if(!FLACDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The FLACDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            InBuff.changeMaxBlockSize(m_frameSizeFLAC);
-            AUDIO_INFO("FLACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            break;
-        case CODEC_OPUS:
-            if(!OPUSDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The OPUSDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            AUDIO_INFO("OPUSDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            InBuff.changeMaxBlockSize(m_frameSizeOPUS);
-            break;
-        case CODEC_VORBIS:
-            if(!psramFound()) {
-                AUDIO_INFO("VORBIS works only with PSRAM!");
-                goto exit;
-            }
-            if(!VORBISDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The VORBISDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            AUDIO_INFO("VORBISDecoder has been initialized, free Heap: %lu bytes,  free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            InBuff.changeMaxBlockSize(m_frameSizeVORBIS);
-            break;
-        case CODEC_WAV: InBuff.changeMaxBlockSize(m_frameSizeWav); break;
-        case CODEC_OGG: // the decoder will be determined later (vorbis, flac, opus?)
-            break;
-        default: goto exit; break;
+    const AudioCodec_t* codec = NULL;
+
+    if(m_codec == CODEC_WAV) { InBuff.changeMaxBlockSize(m_frameSizeWav); return true; }
+    if(m_codec == CODEC_OGG) { return true; } // the decoder will be determined later (vorbis, flac, opus?)
+
+    codec = AudioCodec_Get(m_codec);
+    if(!codec) {
+        AUDIO_INFO("The %s format is not supported in this build", m_codec < 10 ? codecname[m_codec] : "unknown");
+        goto exit;
+    }
+    if(codec->isInit && codec->isInit()) return true;
+    if(codec->f_needsPSRAM && !psramFound()) {
+        AUDIO_INFO("%s works only with PSRAM!", codec->name);
+        goto exit;
+    }
+    if(codec->arenaSize) CodecArena_Reserve(codec->arenaSize());
+    if(!codec->allocateBuffers()) {
+        AUDIO_INFO("The %sDecoder could not be initialized", codec->name);
+        goto exit;
     }
+    gfH = ESP.getFreeHeap();
+    hWM = uxTaskGetStackHighWaterMark(NULL);
+    AUDIO_INFO("%sDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", codec->name, (long unsigned int)gfH, (long unsigned int)hWM);
+    InBuff.changeMaxBlockSize(codec->frameSize);
     return true;
 
 exit:
@@ -4327,15 +4732,16 @@ void Audio::showCodecParams() {
     if(getBitRate()) { AUDIO_INFO("BitRate: %lu", (long unsigned int)getBitRate()); }
     else { AUDIO_INFO("BitRate: N/A"); }
 
+#if AUDIO_CODEC_AAC
     if(m_codec == CODEC_AAC) {
-        uint8_t answ = AACGetFormat();
+        uint8_t answ = AACGetFormat(AACDecoder_Default());
         if(answ < 4) {
             const char hf[4][8] = {"unknown", "ADTS", "ADIF", "RAW"};
             AUDIO_INFO("AAC HeaderFormat: %s", hf[answ])
         }
         if(answ == 1) { // ADTS Header
-            uint8_t aacId = AACGetID();
-            uint8_t aacPr = AACGetProfile();
+            uint8_t aacId = AACGetID(AACDecoder_Default());
+            uint8_t aacPr = AACGetProfile(AACDecoder_Default());
             if(aacId < 2 && aacPr < 4) {
                 const char co[2][7] = {"MPEG-4", "MPEG-2"};
                 const char pr[4][23] = {"Main", "LowComplexity", "Scalable Sampling Rate", "reserved"};
@@ -4343,6 +4749,7 @@ void Audio::showCodecParams() {
             }
         }
     }
+#endif
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int Audio::findNextSync(uint8_t* data, size_t len) {
@@ -4354,44 +4761,33 @@ int Audio::findNextSync(uint8_t* data, size_t len) {
     //         -1 the sync word was not found within the block with the length len
 
     int             nextSync;
-    static uint32_t swnf = 0;
     if(m_codec == CODEC_WAV) {
         m_f_playing = true;
         nextSync = 0;
     }
-    if(m_codec == CODEC_MP3) {
-        nextSync = MP3FindSyncWord(data, len);
-        if(nextSync == -1) return len; // syncword not found, search next block
-    }
-    if(m_codec == CODEC_AAC) { nextSync = AACFindSyncWord(data, len); }
-    if(m_codec == CODEC_M4A) {
-        AACSetRawBlockParams(0, 2, 44100, 1);
+#if AUDIO_CODEC_AAC
+    else if(m_codec == CODEC_M4A) {
+        AACSetRawBlockParams(AACDecoder_Default(), 0, 2, 44100, 1);
         m_f_playing = true;
         nextSync = 0;
     }
-    if(m_codec == CODEC_FLAC) {
-        nextSync = FLACFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(m_codec == CODEC_OPUS) {
-        nextSync = OPUSFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(m_codec == CODEC_VORBIS) {
-        nextSync = VORBISFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
+#endif
+    else if(AudioCodec_Get(m_codec)) {
+        nextSync = AudioCodec_Get(m_codec)->findSyncWord(data, len);
+        if(nextSync == -1 && m_codec != CODEC_AAC) return len; // syncword or OggS not found, search next block
     }
+    else return len;
     if(nextSync == -1) {
-        if(audio_info && swnf == 0) audio_info("syncword not found");
+        if(audio_info && m_syncwordNotFound == 0) audio_info("syncword not found");
         else {
-            swnf++; // syncword not found counter, can be multimediadata
+            m_syncwordNotFound++; // syncword not found counter, can be multimediadata
         }
     }
     if(nextSync == 0) {
-        if(audio_info && swnf > 0) {
-            sprintf(m_chbuf, "syncword not found %lu times", (long unsigned int)swnf);
+        if(audio_info && m_syncwordNotFound > 0) {
+            sprintf(m_chbuf, "syncword not found %lu times", (long unsigned int)m_syncwordNotFound);
             audio_info(m_chbuf);
-            swnf = 0;
+            m_syncwordNotFound = 0;
         }
         else {
             if(audio_info) audio_info("syncword found at pos 0");
@@ -4401,46 +4797,28 @@ int Audio::findNextSync(uint8_t* data, size_t len) {
     return nextSync;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int Audio::resyncOffset(uint8_t* data, size_t len) {
+    // MP3 and ADTS AAC: the next valid frame header behind the damaged frame is searched in the whole buffered window,
+    // instead of skipping one byte per loop() call. The other codecs seek their sync word in findNextSync() as before
+    const AudioCodec_t* codec = AudioCodec_Get(m_codec);
+    if(!codec || len < 2) return 1;
+    if(m_codec != CODEC_MP3 && m_codec != CODEC_AAC && m_codec != CODEC_AACP) return 1;
+    int nextSync = codec->findSyncWord(data + 1, len - 1);
+    int skip = (nextSync < 0) ? len : nextSync + 1;
+    m_resyncCount++;
+    m_resyncSkipped += skip;
+    return skip;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::setDecoderItems() {
-    if(m_codec == CODEC_MP3) {
-        setChannels(MP3GetChannels());
-        setSampleRate(MP3GetSampRate());
-        setBitsPerSample(MP3GetBitsPerSample());
-        setBitrate(MP3GetBitrate());
-    }
-    if(m_codec == CODEC_AAC || m_codec == CODEC_M4A) {
-        setChannels(AACGetChannels());
-        setSampleRate(AACGetSampRate());
-        setBitsPerSample(AACGetBitsPerSample());
-        setBitrate(AACGetBitrate());
-    }
-    if(m_codec == CODEC_FLAC) {
-        setChannels(FLACGetChannels());
-        setSampleRate(FLACGetSampRate());
-        setBitsPerSample(FLACGetBitsPerSample());
-        setBitrate(FLACGetBitRate());
-        if(FLACGetAudioDataStart() > 0){ // only flac-ogg, native flac sets audioDataStart in readFlacHeader()
-            m_audioDataStart = FLACGetAudioDataStart();
-            if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
-        }
-    }
-    if(m_codec == CODEC_OPUS) {
-        setChannels(OPUSGetChannels());
-        setSampleRate(OPUSGetSampRate());
-        setBitsPerSample(OPUSGetBitsPerSample());
-        setBitrate(OPUSGetBitRate());
-        if(OPUSGetAudioDataStart() > 0){
-            m_audioDataStart = OPUSGetAudioDataStart();
-            if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
-        }
-    }
-    if(m_codec == CODEC_VORBIS) {
-        setChannels(VORBISGetChannels());
-        setSampleRate(VORBISGetSampRate());
-        setBitsPerSample(VORBISGetBitsPerSample());
-        setBitrate(VORBISGetBitRate());
-        if(VORBISGetAudioDataStart() > 0){
-            m_audioDataStart = VORBISGetAudioDataStart();
+    const AudioCodec_t* codec = AudioCodec_Get(m_codec);
+    if(codec) {
+        setChannels(codec->getChannels());
+        setSampleRate(codec->getSampRate());
+        setBitsPerSample(codec->getBitsPerSample());
+        setBitrate(codec->getBitRate());
+        if(codec->getAudioDataStart && codec->getAudioDataStart() > 0){ // only ogg, native flac sets audioDataStart in readFlacHeader()
+            m_audioDataStart = codec->getAudioDataStart();
             if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
         }
     }
@@ -4458,10 +4836,9 @@ void Audio::setDecoderItems() {
 int Audio::sendBytes(uint8_t* data, size_t len) {
 
     int32_t     bytesLeft;
-    static bool f_setDecodeParamsOnce = true;
     int         nextSync = 0;
     if(!m_f_playing) {
-        f_setDecodeParamsOnce = true;
+        m_f_setDecodeParamsOnce = true;
         nextSync = findNextSync(data, len);
         if(nextSync == -1) return len;
         if(nextSync == 0) { m_f_playing = true; }
@@ -4472,18 +4849,23 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     m_decodeError = 0;
     int bytesDecoded = 0;
 
-    switch(m_codec) {
-        case CODEC_WAV:  m_decodeError = 0; bytesLeft = 0; break;
-        case CODEC_MP3:  m_decodeError = MP3Decode(data, &bytesLeft, m_outBuff, 0); break;
-        case CODEC_AAC:  m_decodeError = AACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_M4A:  m_decodeError = AACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_FLAC: m_decodeError = FLACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_OPUS: m_decodeError = OPUSDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_VORBIS: m_decodeError = VORBISDecode(data, &bytesLeft, m_outBuff); break;
-        default: {
-            log_e("no valid codec found codec = %d", m_codec);
-            stopSong();
-        }
+    const AudioCodec_t* codec = AudioCodec_Get(m_codec);
+#if AUDIO_BENCHMARK
+    uint32_t cycles = 0;
+#endif
+    if(m_codec == CODEC_WAV) { m_decodeError = 0; bytesLeft = len % (getChannels() * m_wavBytesPerSample); } // whole frames only
+    else if(codec) {
+#if AUDIO_BENCHMARK
+        uint32_t t0 = ESP.getCycleCount();
+        m_decodeError = codec->decode(data, &bytesLeft, m_outBuff);
+        cycles = ESP.getCycleCount() - t0;
+#else
+        m_decodeError = codec->decode(data, &bytesLeft, m_outBuff);
+#endif
+    }
+    else {
+        log_e("no valid codec found codec = %d", m_codec);
+        stopSong();
     }
 
     // m_decodeError - possible values are:
@@ -4495,6 +4877,7 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
 
         printDecodeError(m_decodeError);
         m_f_playing = false; // seek for new syncword
+        m_decodeErrorCount++;
         if(m_codec == CODEC_FLAC) {
         //    if(m_decodeError == ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG) stopSong();
         //    if(m_decodeError == ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT) stopSong();
@@ -4507,165 +4890,453 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
             if(m_decodeError == ERR_OPUS_SUPER_WIDE_BAND_UNSUPPORTED) stopSong();
         }
 
-        return 1; // skip one byte and seek for the next sync word
+        return resyncOffset(data, len); // skip the damaged frame and seek for the next sync word
     }
     bytesDecoded = len - bytesLeft;
 
     if(bytesDecoded == 0 && m_decodeError == 0) { // unlikely framesize
         if(audio_info) audio_info("framesize is 0, start decoding again");
         m_f_playing = false; // seek for new syncword
-        // we're here because there was a wrong sync word so skip one byte and seek for the next
-        return 1;
+        // we're here because there was a wrong sync word so skip it and seek for the next
+        return resyncOffset(data, len);
     }
     // status: bytesDecoded > 0 and m_decodeError >= 0
     char* st = NULL;
     std::vector<uint32_t> vec;
-    switch(m_codec) {
-        case CODEC_WAV:     memmove(m_outBuff, data, len); // copy len data in outbuff and set validsamples and bytesdecoded=len
-                            if(getBitsPerSample() == 16) m_validSamples = len / (2 * getChannels());
-                            if(getBitsPerSample() == 8) m_validSamples = len / 2;
-                            break;
-        case CODEC_MP3:     m_validSamples = MP3GetOutputSamps() / getChannels();
-                            break;
-        case CODEC_AAC:     m_validSamples = AACGetOutputSamps() / getChannels();
-                            break;
-        case CODEC_M4A:     m_validSamples = AACGetOutputSamps() / getChannels();
-                            break;
-        case CODEC_FLAC:    if(m_decodeError == FLAC_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = FLACGetOutputSamps() / getChannels();
-                            st = FLACgetStreamTitle();
-                            if(st) {
-                                AUDIO_INFO(st);
-                                if(audio_showstreamtitle) audio_showstreamtitle(st);
-                            }
-                            vec = FLACgetMetadataBlockPicture();
-                            if(vec.size() > 0){ // get blockpic data
-                                // log_i("---------------------------------------------------------------------------");
-                                // log_i("ogg metadata blockpicture found:");
-                                // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
-                                // log_i("---------------------------------------------------------------------------");
-                                if(audio_oggimage) audio_oggimage(audiofile, vec);
-                            }
-                            break;
-        case CODEC_OPUS:    if(m_decodeError == OPUS_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = OPUSGetOutputSamps();
-                            st = OPUSgetStreamTitle();
-                            if(st){
-                                AUDIO_INFO(st);
-                                if(audio_showstreamtitle) audio_showstreamtitle(st);
-                            }
-                            vec = OPUSgetMetadataBlockPicture();
-                            if(vec.size() > 0){ // get blockpic data
-                                // log_i("---------------------------------------------------------------------------");
-                                // log_i("ogg metadata blockpicture found:");
-                                // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
-                                // log_i("---------------------------------------------------------------------------");
-                                if(audio_oggimage) audio_oggimage(audiofile, vec);
-                            }
-                            break;
-        case CODEC_VORBIS:  if(m_decodeError == VORBIS_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = VORBISGetOutputSamps();
-                            st = VORBISgetStreamTitle();
-                            if(st) {
-                                AUDIO_INFO(st);
-                                if(audio_showstreamtitle) audio_showstreamtitle(st);
-                            }
-                            vec = VORBISgetMetadataBlockPicture();
-                            if(vec.size() > 0){ // get blockpic data
-                                // log_i("---------------------------------------------------------------------------");
-                                // log_i("ogg metadata blockpicture found:");
-                                // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
-                                // log_i("---------------------------------------------------------------------------");
-                                if(audio_oggimage) audio_oggimage(audiofile, vec);
-                            }
-                            break;
-    }
-    if(f_setDecodeParamsOnce && m_validSamples) {
-        f_setDecodeParamsOnce = false;
+    if(m_codec == CODEC_WAV) { // copy len data in outbuff and set validsamples and bytesdecoded=len
+        if(m_wavBytesPerSample > 2) { wavToPCM16(data, bytesDecoded); }
+        else {
+            memmove(m_outBuff, data, len);
+            if(getBitsPerSample() == 16) m_validSamples = len / (2 * getChannels());
+            if(getBitsPerSample() == 8) m_validSamples = len / 2;
+        }
+    }
+    else if(codec) {
+        if(codec->parseOggDone && m_decodeError == codec->parseOggDone) return bytesDecoded; // nothing to play
+        if(m_hlsVariants.size() > 1 && !m_f_setDecodeParamsOnce &&
+           (codec->getSampRate() != getSampleRate() || codec->getChannels() != getChannels())) {
+            setDecoderItems(); // the HLS variant has changed, e.g. from HE-AAC to AAC LC
+        }
+        if(codec->f_interleavedSamps) m_validSamples = codec->getOutputSamps() / getChannels();
+        else                          m_validSamples = codec->getOutputSamps();
+        if(codec->getStreamTitle) st = codec->getStreamTitle();
+        if(st) {
+            AUDIO_INFO(st);
+            if(audio_showstreamtitle) audio_showstreamtitle(st);
+        }
+        if(codec->getMetadataBlockPicture) vec = codec->getMetadataBlockPicture();
+        if(vec.size() > 0){ // get blockpic data
+            // log_i("---------------------------------------------------------------------------");
+            // log_i("ogg metadata blockpicture found:");
+            // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
+            // log_i("---------------------------------------------------------------------------");
+            if(audio_oggimage) audio_oggimage(audiofile, vec);
+        }
+    }
+    if(m_f_setDecodeParamsOnce && m_validSamples) {
+        m_f_setDecodeParamsOnce = false;
         setDecoderItems();
         m_PlayingStartTime = millis();
     }
 
+#if AUDIO_BENCHMARK
+    if(codec || m_codec == CODEC_WAV) updateDecodeStats(cycles); // WAV: hash and heap only, no decode cycles
+#endif
+
     uint16_t bytesDecoderOut = m_validSamples;
     if(m_channels == 2) bytesDecoderOut /= 2;
     if(m_bitsPerSample == 16) bytesDecoderOut *= 2;
     computeAudioTime(bytesDecoded, bytesDecoderOut);
 
+    if(m_fileStartTime && m_validSamples) { // first samples of a local file, header, pictures and prefill are behind
+        m_firstAudioMs = millis() - m_fileStartTime;
+        m_fileStartTime = 0;
+        AUDIO_INFO("first audio after %lu ms", (long unsigned int)m_firstAudioMs);
+    }
+
     if(audio_process_extern) {
         bool continueI2S = false;
         audio_process_extern(m_outBuff, m_validSamples, &continueI2S);
         if(!continueI2S) { return bytesDecoded; }
     }
+    if(m_pcmSink) {
+        writePcmSink();
+        if(m_f_pcmSinkMute) { m_validSamples = 0; return bytesDecoded; } // decode as fast as the input allows
+    }
     m_curSample = 0;
     playChunk();
     return bytesDecoded;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::openPcmSink(fs::FS& fs, const char* path, bool muteI2S) {
+    // The decoder output (before volume, balance and tone) is written into a WAV file, e.g. to compare the decoded PCM
+    // with a reference decoder on the PC. With muteI2S the samples are not sent to I2S and the decoding is no longer
+    // paced by the DMA, the sink stays open over several songs until closePcmSink() is called. A WAV file has one
+    // format, a song with another sample rate, channel count or sample size continues in path-2.wav, path-3.wav ..
+    xSemaphoreTake(mutex_audio, portMAX_DELAY);
+    if(m_pcmSink) { writePcmSinkHeader(); m_pcmSink.close(); }
+    if(m_pcmSinkPath) { free(m_pcmSinkPath); m_pcmSinkPath = NULL; }
+    m_f_pcmSinkMute = muteI2S;
+    m_pcmSinkFS = &fs;
+    m_pcmSinkPath = strdup(path);
+    bool res = m_pcmSinkPath && openPcmSinkPart(1);
+    xSemaphoreGive(mutex_audio);
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::openPcmSinkPart(uint16_t part) {
+    // part 1 is the path as given, the next ones get "-<part>" before the extension
+    char*       name = (char*)malloc(strlen(m_pcmSinkPath) + 8);
+    if(!name) return false;
+    const char* dot = strrchr(m_pcmSinkPath, '.');
+    if(!dot || strchr(dot, '/')) dot = m_pcmSinkPath + strlen(m_pcmSinkPath);
+    if(part == 1) strcpy(name, m_pcmSinkPath);
+    else sprintf(name, "%.*s-%u%s", (int)(dot - m_pcmSinkPath), m_pcmSinkPath, part, dot);
+    m_pcmSinkPart = part;
+    m_pcmSinkBytes = 0;
+    m_pcmSinkSampleRate = 0;
+    m_pcmSinkChannels = 0;
+    m_pcmSinkBitsPerSample = 0;
+    m_pcmSink = m_pcmSinkFS->open(name, "w");
+    bool res = m_pcmSink;
+    if(res) writePcmSinkHeader(); // placeholder, completed when the part is closed
+    else log_e("can't open PCM sink %s", name);
+    free(name);
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::closePcmSink() {
+    xSemaphoreTake(mutex_audio, portMAX_DELAY);
+    if(m_pcmSink) {
+        writePcmSinkHeader();
+        AUDIO_INFO("PCM sink closed, %lu bytes, %lu Hz, %u ch, %u bit", (long unsigned int)m_pcmSinkBytes,
+                   (long unsigned int)m_pcmSinkSampleRate, m_pcmSinkChannels, m_pcmSinkBitsPerSample);
+        m_pcmSink.close();
+    }
+    if(m_pcmSinkPath) { free(m_pcmSinkPath); m_pcmSinkPath = NULL; }
+    m_f_pcmSinkMute = false;
+    xSemaphoreGive(mutex_audio);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+size_t Audio::outBuffBytes() {
+    // m_outBuff holds m_validSamples frames, 8 bit samples are packed two per word (mono) or one frame per word (stereo)
+    size_t bytes = m_validSamples * sizeof(int16_t);
+    if(getBitsPerSample() == 16) bytes *= getChannels();
+    return bytes;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::writePcmSink() {
+    if(!m_validSamples) return;
+    if(m_pcmSinkSampleRate && (m_pcmSinkSampleRate != getSampleRate() || m_pcmSinkChannels != getChannels() ||
+                               m_pcmSinkBitsPerSample != getBitsPerSample())) { // the format has changed: next part
+        writePcmSinkHeader();
+        AUDIO_INFO("PCM sink part %u closed, %lu bytes, %lu Hz, %u ch, %u bit", m_pcmSinkPart, (long unsigned int)m_pcmSinkBytes,
+                   (long unsigned int)m_pcmSinkSampleRate, m_pcmSinkChannels, m_pcmSinkBitsPerSample);
+        m_pcmSink.close();
+        if(!openPcmSinkPart(m_pcmSinkPart + 1)) { m_f_pcmSinkMute = false; return; }
+    }
+    if(!m_pcmSinkSampleRate) {
+        m_pcmSinkSampleRate = getSampleRate();
+        m_pcmSinkChannels = getChannels();
+        m_pcmSinkBitsPerSample = getBitsPerSample();
+    }
+    size_t bytes = outBuffBytes();
+    size_t bw = m_pcmSink.write((const uint8_t*)m_outBuff, bytes);
+    m_pcmSinkBytes += bw;
+    if(bw < bytes) {
+        log_e("PCM sink write error, sink closed");
+        writePcmSinkHeader();
+        m_pcmSink.close();
+        m_f_pcmSinkMute = false;
+    }
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::writePcmSinkHeader() {
+    // canonical 44 byte RIFF/WAVE header, PCM, little endian
+    uint8_t  hdr[44];
+    uint16_t ch = m_pcmSinkChannels ? m_pcmSinkChannels : 2;
+    uint16_t bps = m_pcmSinkBitsPerSample ? m_pcmSinkBitsPerSample : 16;
+    uint32_t sr = m_pcmSinkSampleRate ? m_pcmSinkSampleRate : 44100;
+    uint32_t byteRate = sr * ch * (bps / 8);
+    uint16_t blockAlign = ch * (bps / 8);
+
+    auto le = [&](uint8_t* p, uint32_t val, uint8_t n) { // lambda, little endian
+        for(uint8_t i = 0; i < n; i++) p[i] = (val >> (8 * i)) & 0xFF;
+    };
+    memcpy(hdr +  0, "RIFF", 4); le(hdr +  4, m_pcmSinkBytes + 36, 4);
+    memcpy(hdr +  8, "WAVE", 4);
+    memcpy(hdr + 12, "fmt ", 4); le(hdr + 16, 16, 4);
+    le(hdr + 20, 1, 2);           // PCM
+    le(hdr + 22, ch, 2);
+    le(hdr + 24, sr, 4);
+    le(hdr + 28, byteRate, 4);
+    le(hdr + 32, blockAlign, 2);
+    le(hdr + 34, bps, 2);
+    memcpy(hdr + 36, "data", 4); le(hdr + 40, m_pcmSinkBytes, 4);
+
+    uint32_t pos = m_pcmSink.position();
+    m_pcmSink.seek(0);
+    m_pcmSink.write(hdr, sizeof(hdr));
+    if(pos > sizeof(hdr)) m_pcmSink.seek(pos);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::updateDecodeStats(uint32_t cycles) {
+#if AUDIO_BENCHMARK
+    decodeStats_t* ds = &m_decodeStats[m_codec];
+    if(ds->frames == 0) {
+        ds->pcmHash = 2166136261UL; // FNV offset basis
+        ds->minFreeHeap = UINT32_MAX;
+        ds->minFreePsram = UINT32_MAX;
+    }
+    ds->frames++;
+    ds->cycles += cycles;
+    if(cycles > ds->maxCycles) ds->maxCycles = cycles;
+    ds->sampleRate = getSampleRate();
+    ds->channels = getChannels();
+    ds->bitsPerSample = getBitsPerSample();
+    if(getBitsPerSample() == 8 && getChannels() == 1) ds->pcmFrames += m_validSamples * 2;
+    else                                              ds->pcmFrames += m_validSamples;
+
+    const uint8_t* p = (const uint8_t*)m_outBuff;
+    size_t n = outBuffBytes();
+    uint32_t h = ds->pcmHash;
+    for(size_t i = 0; i < n; i++) { h ^= p[i]; h *= 16777619UL; } // FNV prime
+    ds->pcmHash = h;
+
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t freePsram = ESP.getFreePsram();
+    if(freeHeap < ds->minFreeHeap) ds->minFreeHeap = freeHeap;
+    if(freePsram < ds->minFreePsram) ds->minFreePsram = freePsram;
+#else
+    (void)cycles;
+#endif
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::resetDecodeStats() {
+    xSemaphoreTake(mutex_audio, portMAX_DELAY);
+    m_netUnderruns = 0;
+    m_netReconnects = 0;
+    memset(m_switches, 0, sizeof(m_switches));
+    memset(m_switchSumMs, 0, sizeof(m_switchSumMs));
+#if AUDIO_BENCHMARK
+    memset(m_decodeStats, 0, sizeof(m_decodeStats));
+#endif
+    xSemaphoreGive(mutex_audio);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::getStats(audioStats_t* st) {
+    // the counters of the audio task change under mutex_audio, copied under it they belong to the same moment
+    memset(st, 0, sizeof(audioStats_t));
+    xSemaphoreTake(mutex_audio, portMAX_DELAY);
+#if AUDIO_BENCHMARK
+    memcpy(st->decode, m_decodeStats, sizeof(st->decode));
+#endif
+    st->input.decodeErrors = m_decodeErrorCount;
+    st->input.resyncs = m_resyncCount;
+    st->input.resyncSkipped = m_resyncSkipped;
+
+    st->file.headerMs = m_headerTimeMs;
+    st->file.firstAudioMs = m_firstAudioMs;
+    getFileReadLatency(&st->file.readP50Us, &st->file.readP99Us, &st->file.readMaxUs); // under the reader's mutex
+#if AUDIO_FILE_READER
+    st->file.readerStackUnused = m_fileReader.getStackUnused();
+    st->file.readerRuns = m_fileReader.getRuns();
+#endif
+    st->file.resumeScanBytes = m_resumeScanBytes;
+    st->file.resumeScanUs = m_resumeScanUs;
+
+#if AUDIO_NET_READER
+    st->net.readerActive = m_netReader.isActive();
+    if(st->net.readerActive) st->net.rate = m_netReader.getRate(); // atomics of the reader task
+#endif
+    st->net.depth = getNetBufferDepth();
+    st->net.target = getNetBufferTarget();
+    st->net.underruns = m_netUnderruns;
+    st->net.reconnects = m_netReconnects;
+    st->net.webFileBytes = m_webFileBytes;
+    st->net.rangeRequests = m_rangeRequests;
+    st->net.rangeSeekMs = m_rangeSeekMs;
+
+    st->hls.segments = m_hlsSegments;
+    st->hls.failed = m_hlsFailed;
+    st->hls.late = m_hlsLate;
+    st->hls.worstLoad = m_hlsWorstLoad;
+    st->hls.switches = m_hlsSwitches;
+    if(m_hlsHistoryLen) st->hls.throughput = hlsThroughput();
+    memcpy(st->hls.history, m_hlsHistory, sizeof(st->hls.history));
+    st->hls.historyLen = m_hlsHistoryLen;
+    st->hls.tsPackets = m_tsDemux.packets();
+    st->hls.tsCcErrors = m_tsDemux.ccErrors();
+    st->hls.tsSyncLosses = m_tsDemux.syncLosses();
+    st->hls.tsDropped = m_tsDemux.dropped();
+
+    st->station.lastMs = m_switchMs;
+    st->station.cold = m_switches[0];
+    st->station.coldSumMs = m_switchSumMs[0];
+    st->station.warm = m_switches[1];
+    st->station.warmSumMs = m_switchSumMs[1];
+
+    st->arenaSize = CodecArena_GetSize();
+    st->arenaHighWater = CodecArena_GetHighWaterMark();
+    xSemaphoreGive(mutex_audio);
+    st->tls = TlsClient::stats(); // under its own mutex
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::printDecodeStats(Print& out) {
+    // RTF is the real time factor: seconds of audio decoded per second of CPU time in decode(), I2S is not included
+    // Decode a corpus with openPcmSink(..., true) to measure the decoders only
+    // Printed from a copy, a slow Print does not hold the audio task up
+    audioStats_t* st = (audioStats_t*)malloc(sizeof(audioStats_t));
+    if(!st) return;
+    getStats(st);
+#if AUDIO_BENCHMARK
+    uint32_t cpuHz = getCpuFrequencyMhz() * 1000000UL;
+    out.printf("codec   frames  cyc/frame   max cyc      RTF  rate/ch/bit      heap lw     psram lw  PCM hash\n");
+    for(int i = 0; i < 10; i++) {
+        const decodeStats_t* ds = &st->decode[i];
+        if(!ds->frames || !ds->sampleRate) continue;
+        double cpuSec = (double)ds->cycles / cpuHz;
+        double audioSec = (double)ds->pcmFrames / ds->sampleRate;
+        double rtf = cpuSec > 0 ? audioSec / cpuSec : 0;
+        out.printf("%-6s %7lu %10lu %9lu %8.1f %6lu/%u/%-2u %12lu %12lu  %08lX\n", codecname[i], (long unsigned)ds->frames,
+                   (long unsigned)(ds->cycles / ds->frames), (long unsigned)ds->maxCycles, rtf, (long unsigned)ds->sampleRate,
+                   ds->channels, ds->bitsPerSample, (long unsigned)ds->minFreeHeap, (long unsigned)ds->minFreePsram,
+                   (long unsigned)ds->pcmHash);
+    }
+    out.printf("codec arena: size %lu, high water %lu\n", (long unsigned)st->arenaSize, (long unsigned)st->arenaHighWater);
+#else
+    out.printf("decode statistics are disabled, build with -DAUDIO_BENCHMARK=1\n");
+#endif
+    out.printf("input: decode errors %lu, resyncs %lu, bytes skipped %lu\n", (long unsigned)st->input.decodeErrors,
+               (long unsigned)st->input.resyncs, (long unsigned)st->input.resyncSkipped);
+    if(st->file.headerMs) out.printf("file: header and prefill of the last file took %lu ms\n", (long unsigned)st->file.headerMs);
+    if(st->file.firstAudioMs) out.printf("file: first audio of the last file after %lu ms\n", (long unsigned)st->file.firstAudioMs);
+    if(st->file.readMaxUs) {
+        out.printf("file: read latency p50 < %lu us, p99 < %lu us, max %lu us\n", (long unsigned)st->file.readP50Us,
+                   (long unsigned)st->file.readP99Us, (long unsigned)st->file.readMaxUs);
+    }
+    if(st->file.readerStackUnused) out.printf("file: reader task, %lu bytes of the stack unused\n", (long unsigned)st->file.readerStackUnused);
+    if(st->file.readerRuns) out.printf("file: reader task, sectors of %lu cluster runs\n", (long unsigned)st->file.readerRuns);
+    if(st->file.resumeScanBytes) {
+        out.printf("file: last resume read %lu bytes in %lu us\n", (long unsigned)st->file.resumeScanBytes,
+                   (long unsigned)st->file.resumeScanUs);
+    }
+    if(st->net.readerActive) {
+        out.printf("net: buffer depth %lu, target %lu, rate %lu B/s\n", (long unsigned)st->net.depth, (long unsigned)st->net.target,
+                   (long unsigned)st->net.rate);
+    }
+    out.printf("net: underruns %lu, reconnects %lu\n", (long unsigned)st->net.underruns, (long unsigned)st->net.reconnects);
+    if(st->net.webFileBytes) {
+        out.printf("net: web file %lu bytes received, %lu range requests, last one served in %lu ms\n",
+                   (long unsigned)st->net.webFileBytes, (long unsigned)st->net.rangeRequests, (long unsigned)st->net.rangeSeekMs);
+    }
+    if(st->hls.segments) {
+        out.printf("hls: %lu segments, %lu lost, %lu loaded slower than real time, worst %lu%% of the duration\n",
+                   (long unsigned)st->hls.segments, (long unsigned)st->hls.failed, (long unsigned)st->hls.late,
+                   (long unsigned)st->hls.worstLoad);
+    }
+    if(st->hls.tsPackets) {
+        out.printf("hls: ts %lu packets, %lu continuity errors, %lu sync losses, %lu packets of damaged PES dropped\n",
+                   (long unsigned)st->hls.tsPackets, (long unsigned)st->hls.tsCcErrors, (long unsigned)st->hls.tsSyncLosses,
+                   (long unsigned)st->hls.tsDropped);
+    }
+    if(st->hls.historyLen) {
+        out.printf("hls: variants %lu switches, throughput %lu bit/s, selected", (long unsigned)st->hls.switches,
+                   (long unsigned)st->hls.throughput);
+        for(int i = 0; i < st->hls.historyLen; i++) out.printf(" %lu", (long unsigned)st->hls.history[i]);
+        out.printf(" bit/s\n");
+    }
+    if(st->station.cold + st->station.warm) {
+        out.printf("station switch: last %lu ms, %lu cold avg %lu ms, %lu warm avg %lu ms\n", (long unsigned)st->station.lastMs,
+                   (long unsigned)st->station.cold, (long unsigned)(st->station.cold ? st->station.coldSumMs / st->station.cold : 0),
+                   (long unsigned)st->station.warm, (long unsigned)(st->station.warm ? st->station.warmSumMs / st->station.warm : 0));
+    }
+    const tlsStats_t* tls = &st->tls;
+    if(tls->handshakes + tls->resumed) {
+        out.printf("tls: %lu full handshakes, avg %lu ms, %lu resumed, avg %lu ms, %lu failed\n", (long unsigned)tls->handshakes,
+                   (long unsigned)(tls->handshakes ? tls->fullMs / tls->handshakes : 0), (long unsigned)tls->resumed,
+                   (long unsigned)(tls->resumed ? tls->resumedMs / tls->resumed : 0), (long unsigned)tls->failed);
+    }
+    free(st);
+#if CODEC_MEM_PROFILE
+    CodecMem_PrintProfile(out); // where the decoder buffers landed
+#endif
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::computeAudioTime(uint16_t bytesDecoderIn, uint16_t bytesDecoderOut) {
 
     if(getDatamode() != AUDIO_LOCALFILE && m_streamType != ST_WEBFILE) return; //guard
 
-    static uint64_t sumBytesIn         = 0;
-    static uint64_t sumBytesOut        = 0;
-    static uint32_t sumBitRate         = 0;
-    static uint32_t counter            = 0;
-    static uint32_t timeStamp          = 0;
-    static uint32_t deltaBytesIn       = 0;
-    static uint32_t nominalBitRate     = 0;
 
     if(m_f_firstCurTimeCall) { // first call
         m_f_firstCurTimeCall = false;
-        sumBytesIn = 0;
-        sumBytesOut = 0;
-        sumBitRate  = 0;
-        counter = 0;
-        timeStamp = millis();
-        deltaBytesIn = 0;
-        nominalBitRate = 0;
-
-        if(m_codec == CODEC_FLAC && FLACGetAudioFileDuration()){
-            m_audioFileDuration = FLACGetAudioFileDuration();
-            nominalBitRate = (m_audioDataSize / FLACGetAudioFileDuration()) * 8;
-            m_avr_bitrate = nominalBitRate;
+        m_sumBytesIn = 0;
+        m_sumBytesOut = 0;
+        m_sumBitRate  = 0;
+        m_bitRateCounter = 0;
+        m_timeStamp = millis();
+        m_deltaBytesIn = 0;
+        m_nominalBitRate = 0;
+
+#if AUDIO_CODEC_FLAC
+        if(m_codec == CODEC_FLAC && FLACGetAudioFileDuration(FLACDecoder_Default())){
+            m_audioFileDuration = FLACGetAudioFileDuration(FLACDecoder_Default());
+            m_nominalBitRate = (m_audioDataSize / FLACGetAudioFileDuration(FLACDecoder_Default())) * 8;
+            m_avr_bitrate = m_nominalBitRate;
         }
+#endif
         if(m_codec == CODEC_WAV){
-            nominalBitRate = getBitRate();
-            m_avr_bitrate = nominalBitRate;
-            m_audioFileDuration = m_audioDataSize  / (getSampleRate() * getChannels());
-            if(getBitsPerSample() == 16) m_audioFileDuration /= 2;
+            m_nominalBitRate = getBitRate();
+            m_avr_bitrate = m_nominalBitRate;
+            m_audioFileDuration = m_audioDataSize  / (getSampleRate() * getChannels() * m_wavBytesPerSample);
+        }
+        if((m_codec == CODEC_OPUS || m_codec == CODEC_VORBIS) && m_oggLastGranule && m_audioDataSize){
+            uint64_t samples = m_oggLastGranule;
+            uint32_t sr = getSampleRate();
+#if AUDIO_CODEC_OPUS
+            if(m_codec == CODEC_OPUS){ // opus granule always counts 48kHz samples, including pre-skip
+                sr = 48000;
+                samples = (samples > OPUSGetPreSkip(OPUSDecoder_Default())) ? samples - OPUSGetPreSkip(OPUSDecoder_Default()) : 0;
+            }
+#endif
+            if(sr && samples >= sr){
+                m_audioFileDuration = round((float)samples / sr);
+                m_nominalBitRate = ((float)m_audioDataSize * 8 * sr) / samples;
+                m_avr_bitrate = m_nominalBitRate;
+            }
         }
     }
 
-    sumBytesIn   += bytesDecoderIn;
-    deltaBytesIn += bytesDecoderIn;
-    sumBytesOut  += bytesDecoderOut;
+    m_sumBytesIn   += bytesDecoderIn;
+    m_deltaBytesIn += bytesDecoderIn;
+    m_sumBytesOut  += bytesDecoderOut;
 
 
-    if(timeStamp + 500 < millis()){
+    if(m_timeStamp + 500 < millis()){
         uint32_t t       = millis();      // time tracking
-        uint32_t delta_t = t - timeStamp; //    ---"---
-        timeStamp = t;                    //    ---"---
+        uint32_t delta_t = t - m_timeStamp; //    ---"---
+        m_timeStamp = t;                    //    ---"---
 
-        uint32_t bitRate = ((deltaBytesIn * 8000) / delta_t);  // we know the time and bytesIn to compute the bitrate
+        uint32_t bitRate = ((m_deltaBytesIn * 8000) / delta_t);  // we know the time and bytesIn to compute the bitrate
 
-        sumBitRate += bitRate;
-        counter ++;
-        if(nominalBitRate){
-            m_audioCurrentTime = round(((float)sumBytesIn * 8) / m_avr_bitrate);
+        m_sumBitRate += bitRate;
+        m_bitRateCounter ++;
+        if(m_nominalBitRate){
+            m_audioCurrentTime = round(((float)m_sumBytesIn * 8) / m_avr_bitrate);
         }
         else{
-            m_avr_bitrate = sumBitRate / counter;
-            m_audioCurrentTime = (sumBytesIn * 8) / m_avr_bitrate;
+            m_avr_bitrate = m_sumBitRate / m_bitRateCounter;
+            m_audioCurrentTime = (m_sumBytesIn * 8) / m_avr_bitrate;
             m_audioFileDuration = round(((float)m_audioDataSize * 8 / m_avr_bitrate));
         }
-        deltaBytesIn = 0;
+        m_deltaBytesIn = 0;
     }
 
     if(m_haveNewFilePos && m_avr_bitrate){
         uint32_t posWhithinAudioBlock =  m_haveNewFilePos - m_audioDataStart;
         uint32_t newTime = posWhithinAudioBlock / (m_avr_bitrate / 8);
         m_audioCurrentTime = newTime;
-        sumBytesIn = posWhithinAudioBlock;
+        m_sumBytesIn = posWhithinAudioBlock;
         m_haveNewFilePos = 0;
     }
 }
@@ -4845,10 +5516,132 @@ uint32_t Audio::getFileSize() { // returns the size of webfile or local file
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint32_t Audio::getFilePos() {
-    if(!audiofile) return 0;
+    if(!audiofile) return (m_streamType == ST_WEBFILE) ? m_webFilePos : 0; // next byte from the socket
+#if AUDIO_FILE_READER
+    if(m_fileReader.isActive()) return m_fileReader.position();
+#endif
     return audiofile.position();
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int32_t Audio::readLocalFile(uint8_t* buf, size_t len) {
+    // with the reader task only prefetched data is taken, 0 means the task has not caught up yet (not end of file)
+#if AUDIO_FILE_READER
+    if(m_fileReader.isActive()) return m_fileReader.read(buf, len);
+#endif
+    return audiofile.read(buf, len);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::seekLocalFile(uint32_t pos) {
+    audiofile.seek(pos);
+#if AUDIO_FILE_READER
+    m_fileReader.seek(pos);
+#endif
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::webFileRange(uint32_t pos) {
+    // the web file continues at pos with "Range: bytes=pos-" on a new connection, the rest of the current response
+    // would otherwise have to be read first. Seek, resume after a broken connection and header jumps come here
+    _client->stop();
+    m_f_rangeRequest = true;
+    m_rangeStart = -1;
+    m_webFilePos = pos;
+    m_rangeTime = millis();
+    m_rangeRequests++;
+    if(m_f_Log) log_i("range request from byte %lu", (long unsigned int)pos);
+    return httpPrint(m_lastHost, pos);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::headerCanSkip(uint32_t bytes) {
+    // the header parser may seek over pictures and padding: local files always, web files if the server accepts
+    // ranges and the jump saves more than a new request costs
+    if(getDatamode() == AUDIO_LOCALFILE) return true;
+    return m_streamType == ST_WEBFILE && m_f_acceptRanges && bytes >= AUDIO_RANGE_MIN_SKIP;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::getFileReadLatency(uint32_t* p50, uint32_t* p99, uint32_t* maxUs) {
+#if AUDIO_FILE_READER
+    m_fileReader.getLatency(p50, p99, maxUs);
+    return true;
+#else
+    *p50 = 0; *p99 = 0; *maxUs = 0;
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int32_t Audio::netAvailable() {
+    // the web stream helpers read through these, first the bytes read behind the header or chunk size line, with the
+    // net reader task only buffered data is seen
+    int32_t ahead = m_httpParser.rxAvailable();
+#if AUDIO_NET_READER
+    if(m_netReader.isActive()) return ahead + m_netReader.available();
+#endif
+    return ahead + _client->available();
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int32_t Audio::netRead(uint8_t* buf, size_t len) {
+    if(m_httpParser.rxAvailable()) return m_httpParser.rxRead(buf, len);
+#if AUDIO_NET_READER
+    if(m_netReader.isActive()) return m_netReader.read(buf, len);
+#endif
+    return _client->read(buf, len);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int Audio::netRead() {
+    uint8_t b;
+    if(m_httpParser.rxRead(&b, 1)) return b;
+#if AUDIO_NET_READER
+    if(m_netReader.isActive()) return m_netReader.read();
+#endif
+    return _client->read();
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::readHttpLine() {
+    // a header or chunk size line to m_httpParser.line(), the socket is read in blocks, what is read behind the line
+    // stays in the parser and netRead() returns it first; false: the line is not complete yet
+    while(!m_httpParser.nextLine()) {
+        size_t   space;
+        uint8_t* p = m_httpParser.rxSpace(&space);
+        int32_t  n = netAvailable();
+        if(n <= 0) return false;
+        n = netRead(p, min((size_t)n, space));
+        if(n <= 0) return false;
+        m_httpParser.rxWritten(n);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::netBufferReady() {
+    // the target depth is reached or no more data fits
+    if(InBuff.freeSpace() < InBuff.getMaxBlockSize()) return true;
+    return getNetBufferDepth() >= getNetBufferTarget();
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::setDatamode(uint8_t dm) {
+    if(dm == HTTP_RESPONSE_HEADER) { // a new response follows
+        m_httpParser.reset();
+        m_f_bodyRead = false;
+        m_f_ctSeen = false;
+        m_f_httpData = false;
+        m_httpTime = millis();
+    }
+    m_datamode = dm;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t Audio::getNetBufferDepth() {
+#if AUDIO_NET_READER
+    return InBuff.bufferFilled() + m_netReader.available();
+#else
+    return InBuff.bufferFilled();
+#endif
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t Audio::getNetBufferTarget() {
+#if AUDIO_NET_READER
+    if(m_netReader.isActive()) return m_netReader.getTargetDepth();
+#endif
+    return InBuff.getMaxBlockSize(); // one frame, as without the jitter buffer
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint32_t Audio::getAudioDataStartPos() {
     if(!audiofile) return 0;
     return m_audioDataStart;
@@ -4871,8 +5664,7 @@ uint32_t Audio::getAudioCurrentTime() { // return current time in seconds
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::setAudioPlayPosition(uint16_t sec) {
-    if(m_codec == CODEC_OPUS) return false;   // not impl. yet
-    if(m_codec == CODEC_VORBIS) return false; // not impl. yet
+    if(AudioCodec_Get(m_codec) && !AudioCodec_Get(m_codec)->seekFrame) return false; // opus, vorbis: not impl. yet
     // Jump to an absolute position in time within an audio file
     // e.g. setAudioPlayPosition(300) sets the pointer at pos 5 min
     if(sec > getAudioFileDuration()) sec = getAudioFileDuration();
@@ -4895,9 +5687,8 @@ uint32_t Audio::getTotalPlayingTime() {
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::setTimeOffset(int sec) { // fast forward or rewind the current position in seconds
 
-    if(!audiofile || !m_avr_bitrate) return false;
-    if(m_codec == CODEC_OPUS) return false;   // not impl. yet
-    if(m_codec == CODEC_VORBIS) return false; // not impl. yet
+    if((!audiofile && m_streamType != ST_WEBFILE) || !m_avr_bitrate) return false;
+    if(AudioCodec_Get(m_codec) && !AudioCodec_Get(m_codec)->seekFrame) return false; // opus, vorbis: not impl. yet
 
     uint32_t oneSec = m_avr_bitrate / 8;                 // bytes decoded in one sec
     int32_t  offset = oneSec * sec;                      // bytes to be wind/rewind
@@ -4908,9 +5699,7 @@ bool Audio::setTimeOffset(int sec) { // fast forward or rewind the current posit
     pos += offset;
     if(pos < (int32_t)startAB) {pos = startAB;}
     if(pos >= (int32_t)endAB)  {pos = endAB;}
-    setFilePos(pos);
-
-    return true;
+    return setFilePos(pos);
 }
 
 //-OMT expansion----------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -4920,12 +5709,13 @@ bool Audio::setHeaderTimeout(int ms) {
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::setFilePos(uint32_t pos) {
-    if(!audiofile) return false;
-    if(m_codec == CODEC_OPUS) return false;   // not impl. yet
-    if(m_codec == CODEC_VORBIS) return false; // not impl. yet
+    // web files need a server with range support, m4a only local (the stsz table is read from the file)
+    bool f_web = m_streamType == ST_WEBFILE && m_f_acceptRanges && m_codec != CODEC_M4A;
+    if(!audiofile && !f_web) return false;
+    if(AudioCodec_Get(m_codec) && !AudioCodec_Get(m_codec)->seekFrame) return false; // opus, vorbis: not impl. yet
     memset(m_outBuff, 0, m_outbuffSize);
     m_validSamples = 0;
-    m_resumeFilePos = pos;  // used in processLocalFile()
+    m_resumeFilePos = pos;  // used in processLocalFile() and processWebFile()
     m_haveNewFilePos = pos; // used in computeAudioCurrentTime()
 
     return true;
@@ -5029,10 +5819,6 @@ void Audio::setI2SCommFMT_LSB(bool commFMT) {
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::computeVUlevel(int16_t sample[2]) {
-    static uint8_t sampleArray[2][4][8] = {0};
-    static uint8_t cnt0 = 0, cnt1 = 0, cnt2 = 0, cnt3 = 0, cnt4 = 0;
-    static bool    f_vu = false;
-
     auto avg = [&](uint8_t* sampArr) { // lambda, inner function, compute the average of 8 samples
         uint16_t av = 0;
         for(int i = 0; i < 8; i++) { av += sampArr[i]; }
@@ -5047,47 +5833,47 @@ void Audio::computeVUlevel(int16_t sample[2]) {
         return maxValue;
     };
 
-    if(cnt0 == 64) {
-        cnt0 = 0;
-        cnt1++;
+    if(m_vuLevel.cnt0 == 64) {
+        m_vuLevel.cnt0 = 0;
+        m_vuLevel.cnt1++;
     }
-    if(cnt1 == 8) {
-        cnt1 = 0;
-        cnt2++;
+    if(m_vuLevel.cnt1 == 8) {
+        m_vuLevel.cnt1 = 0;
+        m_vuLevel.cnt2++;
     }
-    if(cnt2 == 8) {
-        cnt2 = 0;
-        cnt3++;
+    if(m_vuLevel.cnt2 == 8) {
+        m_vuLevel.cnt2 = 0;
+        m_vuLevel.cnt3++;
     }
-    if(cnt3 == 8) {
-        cnt3 = 0;
-        cnt4++;
-        f_vu = true;
+    if(m_vuLevel.cnt3 == 8) {
+        m_vuLevel.cnt3 = 0;
+        m_vuLevel.cnt4++;
+        m_vuLevel.f_vu = true;
     }
-    if(cnt4 == 8) { cnt4 = 0; }
+    if(m_vuLevel.cnt4 == 8) { m_vuLevel.cnt4 = 0; }
 
-    if(!cnt0) { // store every 64th sample in the array[0]
-        sampleArray[LEFTCHANNEL][0][cnt1] = abs(sample[LEFTCHANNEL] >> 7);
-        sampleArray[RIGHTCHANNEL][0][cnt1] = abs(sample[RIGHTCHANNEL] >> 7);
+    if(!m_vuLevel.cnt0) { // store every 64th sample in the array[0]
+        m_vuLevel.sampleArray[LEFTCHANNEL][0][m_vuLevel.cnt1] = abs(sample[LEFTCHANNEL] >> 7);
+        m_vuLevel.sampleArray[RIGHTCHANNEL][0][m_vuLevel.cnt1] = abs(sample[RIGHTCHANNEL] >> 7);
     }
-    if(!cnt1) { // store argest from 64 * 8 samples in the array[1]
-        sampleArray[LEFTCHANNEL][1][cnt2] = largest(sampleArray[LEFTCHANNEL][0]);
-        sampleArray[RIGHTCHANNEL][1][cnt2] = largest(sampleArray[RIGHTCHANNEL][0]);
+    if(!m_vuLevel.cnt1) { // store argest from 64 * 8 samples in the array[1]
+        m_vuLevel.sampleArray[LEFTCHANNEL][1][m_vuLevel.cnt2] = largest(m_vuLevel.sampleArray[LEFTCHANNEL][0]);
+        m_vuLevel.sampleArray[RIGHTCHANNEL][1][m_vuLevel.cnt2] = largest(m_vuLevel.sampleArray[RIGHTCHANNEL][0]);
     }
-    if(!cnt2) { // store avg from 64 * 8 * 8 samples in the array[2]
-        sampleArray[LEFTCHANNEL][2][cnt3] = largest(sampleArray[LEFTCHANNEL][1]);
-        sampleArray[RIGHTCHANNEL][2][cnt3] = largest(sampleArray[RIGHTCHANNEL][1]);
+    if(!m_vuLevel.cnt2) { // store avg from 64 * 8 * 8 samples in the array[2]
+        m_vuLevel.sampleArray[LEFTCHANNEL][2][m_vuLevel.cnt3] = largest(m_vuLevel.sampleArray[LEFTCHANNEL][1]);
+        m_vuLevel.sampleArray[RIGHTCHANNEL][2][m_vuLevel.cnt3] = largest(m_vuLevel.sampleArray[RIGHTCHANNEL][1]);
     }
-    if(!cnt3) { // store avg from 64 * 8 * 8 * 8 samples in the array[3]
-        sampleArray[LEFTCHANNEL][3][cnt4] = avg(sampleArray[LEFTCHANNEL][2]);
-        sampleArray[RIGHTCHANNEL][3][cnt4] = avg(sampleArray[RIGHTCHANNEL][2]);
+    if(!m_vuLevel.cnt3) { // store avg from 64 * 8 * 8 * 8 samples in the array[3]
+        m_vuLevel.sampleArray[LEFTCHANNEL][3][m_vuLevel.cnt4] = avg(m_vuLevel.sampleArray[LEFTCHANNEL][2]);
+        m_vuLevel.sampleArray[RIGHTCHANNEL][3][m_vuLevel.cnt4] = avg(m_vuLevel.sampleArray[RIGHTCHANNEL][2]);
     }
-    if(f_vu) {
-        f_vu = false;
-        m_vuLeft = avg(sampleArray[LEFTCHANNEL][3]);
-        m_vuRight = avg(sampleArray[RIGHTCHANNEL][3]);
+    if(m_vuLevel.f_vu) {
+        m_vuLevel.f_vu = false;
+        m_vuLeft = avg(m_vuLevel.sampleArray[LEFTCHANNEL][3]);
+        m_vuRight = avg(m_vuLevel.sampleArray[RIGHTCHANNEL][3]);
     }
-    cnt1++;
+    m_vuLevel.cnt1++;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint16_t Audio::getVUlevel() {
@@ -5219,6 +6005,7 @@ void Audio::computeLimit() {    // is calculated when the volume or balance chan
             break;
     }
 
+    if(v > 0.9999) v = 1; // full volume: the logarithmic curve gives 1 only within rounding, Gain() must not change a sample
     m_limit_left = l * v;
     m_limit_right = r * v;
 
@@ -5363,12 +6150,11 @@ int16_t* Audio::IIR_filterChain0(int16_t iir_in[2], bool clear) { // Infinite Im
     enum : uint8_t { in = 0, out = 1 };
     float          inSample[2];
     float          outSample[2];
-    static int16_t iir_out[2];
 
     if(clear) {
         memset(m_filterBuff, 0, sizeof(m_filterBuff)); // zero IIR filterbuffer
-        iir_out[0] = 0;
-        iir_out[1] = 0;
+        m_iirChain0.iir_out[0] = 0;
+        m_iirChain0.iir_out[1] = 0;
         iir_in[0] = 0;
         iir_in[1] = 0;
     }
@@ -5385,7 +6171,7 @@ int16_t* Audio::IIR_filterChain0(int16_t iir_in[2], bool clear) { // Infinite Im
     m_filterBuff[0][z1][in][LEFTCHANNEL] = inSample[LEFTCHANNEL];
     m_filterBuff[0][z2][out][LEFTCHANNEL] = m_filterBuff[0][z1][out][LEFTCHANNEL];
     m_filterBuff[0][z1][out][LEFTCHANNEL] = outSample[LEFTCHANNEL];
-    iir_out[LEFTCHANNEL] = (int16_t)outSample[LEFTCHANNEL];
+    m_iirChain0.iir_out[LEFTCHANNEL] = (int16_t)outSample[LEFTCHANNEL];
 
     outSample[RIGHTCHANNEL] = m_filter[0].a0 * inSample[RIGHTCHANNEL] +
                               m_filter[0].a1 * m_filterBuff[0][z1][in][RIGHTCHANNEL] +
@@ -5397,9 +6183,9 @@ int16_t* Audio::IIR_filterChain0(int16_t iir_in[2], bool clear) { // Infinite Im
     m_filterBuff[0][z1][in][RIGHTCHANNEL] = inSample[RIGHTCHANNEL];
     m_filterBuff[0][z2][out][RIGHTCHANNEL] = m_filterBuff[0][z1][out][RIGHTCHANNEL];
     m_filterBuff[0][z1][out][RIGHTCHANNEL] = outSample[RIGHTCHANNEL];
-    iir_out[RIGHTCHANNEL] = (int16_t)outSample[RIGHTCHANNEL];
+    m_iirChain0.iir_out[RIGHTCHANNEL] = (int16_t)outSample[RIGHTCHANNEL];
 
-    return iir_out;
+    return m_iirChain0.iir_out;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int16_t* Audio::IIR_filterChain1(int16_t iir_in[2], bool clear) { // Infinite Impulse Response (IIR) filters
@@ -5408,12 +6194,11 @@ int16_t* Audio::IIR_filterChain1(int16_t iir_in[2], bool clear) { // Infinite Im
     enum : uint8_t { in = 0, out = 1 };
     float          inSample[2];
     float          outSample[2];
-    static int16_t iir_out[2];
 
     if(clear) {
         memset(m_filterBuff, 0, sizeof(m_filterBuff)); // zero IIR filterbuffer
-        iir_out[0] = 0;
-        iir_out[1] = 0;
+        m_iirChain1.iir_out[0] = 0;
+        m_iirChain1.iir_out[1] = 0;
         iir_in[0] = 0;
         iir_in[1] = 0;
     }
@@ -5430,7 +6215,7 @@ int16_t* Audio::IIR_filterChain1(int16_t iir_in[2], bool clear) { // Infinite Im
     m_filterBuff[1][z1][in][LEFTCHANNEL] = inSample[LEFTCHANNEL];
     m_filterBuff[1][z2][out][LEFTCHANNEL] = m_filterBuff[1][z1][out][LEFTCHANNEL];
     m_filterBuff[1][z1][out][LEFTCHANNEL] = outSample[LEFTCHANNEL];
-    iir_out[LEFTCHANNEL] = (int16_t)outSample[LEFTCHANNEL];
+    m_iirChain1.iir_out[LEFTCHANNEL] = (int16_t)outSample[LEFTCHANNEL];
 
     outSample[RIGHTCHANNEL] = m_filter[1].a0 * inSample[RIGHTCHANNEL] +
                               m_filter[1].a1 * m_filterBuff[1][z1][in][RIGHTCHANNEL] +
@@ -5442,9 +6227,9 @@ int16_t* Audio::IIR_filterChain1(int16_t iir_in[2], bool clear) { // Infinite Im
     m_filterBuff[1][z1][in][RIGHTCHANNEL] = inSample[RIGHTCHANNEL];
     m_filterBuff[1][z2][out][RIGHTCHANNEL] = m_filterBuff[1][z1][out][RIGHTCHANNEL];
     m_filterBuff[1][z1][out][RIGHTCHANNEL] = outSample[RIGHTCHANNEL];
-    iir_out[RIGHTCHANNEL] = (int16_t)outSample[RIGHTCHANNEL];
+    m_iirChain1.iir_out[RIGHTCHANNEL] = (int16_t)outSample[RIGHTCHANNEL];
 
-    return iir_out;
+    return m_iirChain1.iir_out;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int16_t* Audio::IIR_filterChain2(int16_t iir_in[2], bool clear) { // Infinite Impulse Response (IIR) filters
@@ -5453,12 +6238,11 @@ int16_t* Audio::IIR_filterChain2(int16_t iir_in[2], bool clear) { // Infinite Im
     enum : uint8_t { in = 0, out = 1 };
     float          inSample[2];
     float          outSample[2];
-    static int16_t iir_out[2];
 
     if(clear) {
         memset(m_filterBuff, 0, sizeof(m_filterBuff)); // zero IIR filterbuffer
-        iir_out[0] = 0;
-        iir_out[1] = 0;
+        m_iirChain2.iir_out[0] = 0;
+        m_iirChain2.iir_out[1] = 0;
         iir_in[0] = 0;
         iir_in[1] = 0;
     }
@@ -5475,7 +6259,7 @@ int16_t* Audio::IIR_filterChain2(int16_t iir_in[2], bool clear) { // Infinite Im
     m_filterBuff[2][z1][in][LEFTCHANNEL] = inSample[LEFTCHANNEL];
     m_filterBuff[2][z2][out][LEFTCHANNEL] = m_filterBuff[2][z1][out][LEFTCHANNEL];
     m_filterBuff[2][z1][out][LEFTCHANNEL] = outSample[LEFTCHANNEL];
-    iir_out[LEFTCHANNEL] = (int16_t)outSample[LEFTCHANNEL];
+    m_iirChain2.iir_out[LEFTCHANNEL] = (int16_t)outSample[LEFTCHANNEL];
 
     outSample[RIGHTCHANNEL] = m_filter[2].a0 * inSample[RIGHTCHANNEL] +
                               m_filter[2].a1 * m_filterBuff[2][z1][in][RIGHTCHANNEL] +
@@ -5487,296 +6271,60 @@ int16_t* Audio::IIR_filterChain2(int16_t iir_in[2], bool clear) { // Infinite Im
     m_filterBuff[2][z1][in][RIGHTCHANNEL] = inSample[RIGHTCHANNEL];
     m_filterBuff[2][z2][out][RIGHTCHANNEL] = m_filterBuff[2][z1][out][RIGHTCHANNEL];
     m_filterBuff[2][z1][out][RIGHTCHANNEL] = outSample[RIGHTCHANNEL];
-    iir_out[RIGHTCHANNEL] = (int16_t)outSample[RIGHTCHANNEL];
+    m_iirChain2.iir_out[RIGHTCHANNEL] = (int16_t)outSample[RIGHTCHANNEL];
 
-    return iir_out;
+    return m_iirChain2.iir_out;
 }
 // clang-format on
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-//    AAC - T R A N S P O R T S T R E A M
+//    W E B S T R E A M  -  H E L P   F U N C T I O N S
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-bool Audio::ts_parsePacket(uint8_t* packet, uint8_t* packetStart, uint8_t* packetLength) {
-    const uint8_t TS_PACKET_SIZE = 188;
-    const uint8_t PAYLOAD_SIZE = 184;
-    const uint8_t PID_ARRAY_LEN = 4;
-
-    (void)PAYLOAD_SIZE; // suppress [-Wunused-variable]
-
-    typedef struct {
-        int number = 0;
-        int pids[PID_ARRAY_LEN];
-    } pid_array;
-
-    static pid_array pidsOfPMT;
-    static int       PES_DataLength = 0;
-    static int       pidOfAAC = 0;
-
-    if(packet == NULL) {
-        if(m_f_Log) log_i("parseTS reset");
-        for(int i = 0; i < PID_ARRAY_LEN; i++) pidsOfPMT.pids[i] = 0;
-        PES_DataLength = 0;
-        pidOfAAC = 0;
-        return true;
-    }
-
-    // --------------------------------------------------------------------------------------------------------
-    // 0. Byte SyncByte  | 0 | 1 | 0 | 0 | 0 | 1 | 1 | 1 | always bit pattern of 0x47
-    //---------------------------------------------------------------------------------------------------------
-    // 1. Byte           |PUSI|TP|   |PID|PID|PID|PID|PID|
-    //---------------------------------------------------------------------------------------------------------
-    // 2. Byte           |PID|PID|PID|PID|PID|PID|PID|PID|
-    //---------------------------------------------------------------------------------------------------------
-    // 3. Byte           |TSC|TSC|AFC|AFC|CC |CC |CC |CC |
-    //---------------------------------------------------------------------------------------------------------
-    // 4.-187. Byte      |Payload data if AFC==01 or 11  |
-    //---------------------------------------------------------------------------------------------------------
-
-    // PUSI Payload unit start indicator, set when this packet contains the first byte of a new payload unit.
-    //      The first byte of the payload will indicate where this new payload unit starts.
-    // TP   Transport priority, set when the current packet has a higher priority than other packets with the same PID.
-    // PID  Packet Identifier, describing the payload data.
-    // TSC  Transport scrambling control, '00' = Not scrambled.
-    // AFC  Adaptation field control, 01 – no adaptation field, payload only, 10 – adaptation field only, no payload,
-    //                                11 – adaptation field followed by payload, 00 – RESERVED for future use
-    // CC   Continuity counter, Sequence number of payload packets (0x00 to 0x0F) within each stream (except PID 8191)
-
-    if(packet[0] != 0x47) {
-        log_e("ts SyncByte not found, first bytes are %X %X %X %X", packet[0], packet[1], packet[2], packet[3]);
-        stopSong();
-        return false;
-    }
-    int PID = (packet[1] & 0x1F) << 8 | (packet[2] & 0xFF);
-    if(m_f_Log) log_i("PID: 0x%04X(%d)", PID, PID);
-    int PUSI = (packet[1] & 0x40) >> 6;
-    if(m_f_Log) log_i("Payload Unit Start Indicator: %d", PUSI);
-    int AFC = (packet[3] & 0x30) >> 4;
-    if(m_f_Log) log_i("Adaption Field Control: %d", AFC);
-
-    int AFL = -1;
-    if((AFC & 0b10) == 0b10) {  // AFC '11' Adaptation Field followed
-        AFL = packet[4] & 0xFF; // Adaptation Field Length
-        if(m_f_Log) log_i("Adaptation Field Length: %d", AFL);
-    }
-    int PLS = PUSI ? 5 : 4;     // PayLoadStart, Payload Unit Start Indicator
-    if(AFL > 0) PLS += AFL + 1; // skip adaption field
-
-    if(PID == 0) {
-        // Program Association Table (PAT) - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        if(m_f_Log) log_i("PAT");
-        pidsOfPMT.number = 0;
-        pidOfAAC = 0;
-
-        int startOfProgramNums = 8;
-        int lengthOfPATValue = 4;
-        int sectionLength = ((packet[PLS + 1] & 0x0F) << 8) | (packet[PLS + 2] & 0xFF);
-        if(m_f_Log) log_i("Section Length: %d", sectionLength);
-        int program_number, program_map_PID;
-        int indexOfPids = 0;
-        (void)program_number; // [-Wunused-but-set-variable]
-        for(int i = startOfProgramNums; i <= sectionLength; i += lengthOfPATValue) {
-            program_number = ((packet[PLS + i] & 0xFF) << 8) | (packet[PLS + i + 1] & 0xFF);
-            program_map_PID = ((packet[PLS + i + 2] & 0x1F) << 8) | (packet[PLS + i + 3] & 0xFF);
-            if(m_f_Log) log_i("Program Num: 0x%04X(%d) PMT PID: 0x%04X(%d)", program_number, program_number, program_map_PID, program_map_PID);
-            pidsOfPMT.pids[indexOfPids++] = program_map_PID;
-        }
-        pidsOfPMT.number = indexOfPids;
-        *packetStart = 0;
-        *packetLength = 0;
-        return true;
-    }
-    else if(PID == pidOfAAC) {
-        static uint8_t fillData = 0;
-        if(m_f_Log) log_i("AAC");
-        uint8_t posOfPacketStart = 4;
-        if(AFL >= 0) {
-            posOfPacketStart = 5 + AFL;
-            if(m_f_Log) log_i("posOfPacketStart: %d", posOfPacketStart);
-        }
-        // Packetized Elementary Stream (PES) - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        if(m_f_Log) log_i("PES_DataLength %i", PES_DataLength);
-        if(PES_DataLength > 0) {
-            *packetStart = posOfPacketStart + fillData;
-            *packetLength = TS_PACKET_SIZE - posOfPacketStart - fillData;
-            fillData = 0;
-            PES_DataLength -= (*packetLength);
-            return true;
-        }
-        else {
-            int firstByte = packet[posOfPacketStart] & 0xFF;
-            int secondByte = packet[posOfPacketStart + 1] & 0xFF;
-            int thirdByte = packet[posOfPacketStart + 2] & 0xFF;
-            if(m_f_Log) log_i("First 3 bytes: %02X %02X %02X", firstByte, secondByte, thirdByte);
-            if(firstByte == 0x00 && secondByte == 0x00 && thirdByte == 0x01) { // Packet start code prefix
-                // PES
-                uint8_t StreamID = packet[posOfPacketStart + 3] & 0xFF;
-                if(StreamID >= 0xC0 && StreamID <= 0xDF) { ; } // okay ist audio stream
-                if(StreamID >= 0xE0 && StreamID <= 0xEF) {
-                    log_e("video stream!");
-                    return false;
-                }
-                uint8_t PES_HeaderDataLength = packet[posOfPacketStart + 8] & 0xFF;
-                if(m_f_Log) log_i("PES_headerDataLength %d", PES_HeaderDataLength);
-                int PES_PacketLength = ((packet[posOfPacketStart + 4] & 0xFF) << 8) + (packet[posOfPacketStart + 5] & 0xFF);
-                if(m_f_Log) log_i("PES Packet length: %d", PES_PacketLength);
-                PES_DataLength = PES_PacketLength;
-                int startOfData = PES_HeaderDataLength + 9;
-                if(posOfPacketStart + startOfData >= 188) { // only fillers in packet
-                    if(m_f_Log) log_e("posOfPacketStart + startOfData %i", posOfPacketStart + startOfData);
-                    *packetStart = 0;
-                    *packetLength = 0;
-                    PES_DataLength -= (PES_HeaderDataLength + 3);
-                    fillData = (posOfPacketStart + startOfData) - 188;
-                    if(m_f_Log) log_i("fillData %i", fillData);
-                    return true;
-                }
-                if(m_f_Log) log_i("First AAC data byte: %02X", packet[posOfPacketStart + startOfData]);
-                if(m_f_Log) log_i("Second AAC data byte: %02X", packet[posOfPacketStart + startOfData + 1]);
-                *packetStart = posOfPacketStart + startOfData;
-                *packetLength = TS_PACKET_SIZE - posOfPacketStart - startOfData;
-                PES_DataLength -= (*packetLength);
-                PES_DataLength -= (PES_HeaderDataLength + 3);
-                return true;
-            }
-            if(firstByte == 0 && secondByte == 0 && thirdByte == 0){
-                // PES packet startcode prefix is 0x000000
-                // skip such packets
-                return true;
-            }
-        }
-        *packetStart = 0;
-        *packetLength = 0;
-        log_e("PES not found");
-        return false;
-    }
-    else if(pidsOfPMT.number) {
-        //  Program Map Table (PMT) - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-        for(int i = 0; i < pidsOfPMT.number; i++) {
-            if(PID == pidsOfPMT.pids[i]) {
-                if(m_f_Log) log_i("PMT");
-                int staticLengthOfPMT = 12;
-                int sectionLength = ((packet[PLS + 1] & 0x0F) << 8) | (packet[PLS + 2] & 0xFF);
-                if(m_f_Log) log_i("Section Length: %d", sectionLength);
-                int programInfoLength = ((packet[PLS + 10] & 0x0F) << 8) | (packet[PLS + 11] & 0xFF);
-                if(m_f_Log) log_i("Program Info Length: %d", programInfoLength);
-                int cursor = staticLengthOfPMT + programInfoLength;
-                while(cursor < sectionLength - 1) {
-                    int streamType = packet[PLS + cursor] & 0xFF;
-                    int elementaryPID = ((packet[PLS + cursor + 1] & 0x1F) << 8) | (packet[PLS + cursor + 2] & 0xFF);
-                    if(m_f_Log) log_i("Stream Type: 0x%02X Elementary PID: 0x%04X", streamType, elementaryPID);
-
-                    if(streamType == 0x0F || streamType == 0x11) {
-                        if(m_f_Log) log_i("AAC PID discover");
-                        pidOfAAC = elementaryPID;
-                    }
-                    int esInfoLength = ((packet[PLS + cursor + 3] & 0x0F) << 8) | (packet[PLS + cursor + 4] & 0xFF);
-                    if(m_f_Log) log_i("ES Info Length: 0x%04X", esInfoLength);
-                    cursor += 5 + esInfoLength;
-                }
-            }
-        }
-        *packetStart = 0;
-        *packetLength = 0;
-        return true;
-    }
-    // PES received before PAT and PMT seen
-    *packetStart = 0;
-    *packetLength = 0;
-    return false;
+size_t Audio::unframeStream(uint8_t* data, size_t len) {
+    // strips chunk and ICY framing in place, returns the remaining audio bytes, metadata is shown on the way
+    uint8_t* out = data;
+    size_t   audioBytes = 0;
+    while(len) {
+        size_t used = 0;
+        audioBytes += m_httpParser.unframe(data, len, out + audioBytes, &used);
+        data += used;
+        len -= used;
+        if(m_httpParser.metadataReady()) showIcyMetadata(m_httpParser.metadata());
+        if(!used) break;
+    }
+    if(m_httpParser.error()) log_w("invalid chunk size line");
+    return audioBytes;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-//    W E B S T R E A M  -  H E L P   F U N C T I O N S
-//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-uint16_t Audio::readMetadata(uint16_t maxBytes, bool first) {
-    static uint16_t pos_ml = 0; // determines the current position in metaline
-    static uint16_t metalen = 0;
-    uint16_t        res = 0;
-    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(first) {
-        pos_ml = 0;
-        metalen = 0;
-        return 0;
-    }
-    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(!maxBytes) return 0; // guard
-
-    if(!metalen) {
-        int b = _client->read(); // First byte of metadata?
-        metalen = b * 16;        // New count for metadata including length byte, max 4096
-        pos_ml = 0;
-        m_chbuf[pos_ml] = 0; // Prepare for new line
-        res = 1;
-    }
-    if(!metalen) {
-        m_metacount = m_metaint;
-        return res;
-    } // metalen is 0
-    if(metalen < m_chbufSize) {
-        uint16_t a = _client->readBytes(&m_chbuf[pos_ml], min((uint16_t)(metalen - pos_ml), (uint16_t)(maxBytes - 1)));
-        res += a;
-        pos_ml += a;
-    }
-    else { // metadata doesn't fit in m_chbuf
-        uint8_t c = 0;
-        int8_t  i = 0;
-        while(pos_ml != metalen) {
-            i = _client->read(&c, 1); // fake read
-            if(i != -1) {
-                pos_ml++;
-                res++;
-            }
-            else { return res; }
-        }
-        m_metacount = m_metaint;
-        metalen = 0;
-        pos_ml = 0;
-        return res;
-    }
-    if(pos_ml == metalen) {
-        m_chbuf[pos_ml] = '\0';
-        if(strlen(m_chbuf)) { // Any info present?
-            // metaline contains artist and song name.  For example:
-            // "StreamTitle='Don McLean - American Pie';StreamUrl='';"
-            // Sometimes it is just other info like:
-            // "StreamTitle='60s 03 05 Magic60s';StreamUrl='';"
-            // Isolate the StreamTitle, remove leading and trailing quotes if present.
-            latinToUTF8(m_chbuf, m_chbufSize);          // convert to UTF-8 if necessary
-            int pos = indexOf(m_chbuf, "song_spot", 0); // remove some irrelevant infos
-            if(pos > 3) {                               // e.g. song_spot="T" MediaBaseId="0" itunesTrackId="0"
-                m_chbuf[pos] = 0;
-            }
-            showstreamtitle(m_chbuf); // Show artist and title if present in metadata
-        }
-        m_metacount = m_metaint;
-        metalen = 0;
-        pos_ml = 0;
-    }
-    return res;
+void Audio::showIcyMetadata(char* meta) {
+    if(!strlen(meta)) return; // Any info present?
+    // metaline contains artist and song name.  For example:
+    // "StreamTitle='Don McLean - American Pie';StreamUrl='';"
+    // Sometimes it is just other info like:
+    // "StreamTitle='60s 03 05 Magic60s';StreamUrl='';"
+    // Isolate the StreamTitle, remove leading and trailing quotes if present.
+    latinToUTF8(meta, HTTP_META_SIZE);        // convert to UTF-8 if necessary
+    int pos = indexOf(meta, "song_spot", 0); // remove some irrelevant infos
+    if(pos > 3) {                             // e.g. song_spot="T" MediaBaseId="0" itunesTrackId="0"
+        meta[pos] = 0;
+    }
+    showstreamtitle(meta); // Show artist and title if present in metadata
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-size_t Audio::chunkedDataTransfer(uint8_t* bytes) {
-    uint8_t  byteCounter = 0;
-    size_t   chunksize = 0;
-    int      b = 0;
-    uint32_t ctime = millis();
-    uint32_t timeout = 2000; // ms
-    while(true) {
-        if(ctime + timeout < millis()) {
-            log_e("timeout");
-            stopSong();
-            return 0;
-        }
-        b = _client->read();
-        byteCounter++;
-        if(b < 0) continue; // -1 no data available
-        if(b == '\n') break;
-        if(b < '0') continue;
-        // We have received a hexadecimal character.  Decode it and add to the result.
-        b = toupper(b) - '0'; // Be sure we have uppercase
-        if(b > 9) b = b - 7;  // Translate A..F to 10..15
-        chunksize = (chunksize << 4) + b;
-    }
-    if(m_f_Log) log_i("chunksize %d", chunksize);
-    *bytes = byteCounter;
+int32_t Audio::chunkedDataTransfer(uint8_t* bytes) {
+    // the next chunk size line, it never waits: -1 if the line is not complete yet, the next call goes on with it;
+    // the CR LF behind the data of the last chunk is skipped
+    *bytes = 0;
+    uint32_t chunksize = 0;
+    do {
+        if(!readHttpLine()) return -1;
+    } while(!m_httpParser.line()[0]);
+    *bytes = min(m_httpParser.lineBytes(), (size_t)UINT8_MAX);
+    if(!HttpParser::chunkSize(m_httpParser.line(), &chunksize) || chunksize > INT32_MAX) {
+        log_e("invalid chunk size line \"%s\"", m_httpParser.line());
+        stopSong();
+        return -1;
+    }
+    if(m_f_Log) log_i("chunksize %lu", (long unsigned)chunksize);
     return chunksize;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -5885,37 +6433,38 @@ bool Audio::readID3V1Tag() {
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 boolean Audio::streamDetection(uint32_t bytesAvail) {
-    static uint32_t tmr_slow = millis();
-    static uint32_t tmr_lost = millis();
-    static uint8_t  cnt_slow = 0;
-    static uint8_t  cnt_lost = 0;
 
     // if within one second the content of the audio buffer falls below the size of an audio frame 100 times,
     // issue a message
-    if(tmr_slow + 1000 < millis()) {
-        tmr_slow = millis();
-        if(cnt_slow > 100) AUDIO_INFO("slow stream, dropouts are possible");
-        cnt_slow = 0;
+    if(m_streamDetect.tmr_slow + 1000 < millis()) {
+        m_streamDetect.tmr_slow = millis();
+        if(m_streamDetect.cnt_slow > 100) AUDIO_INFO("slow stream, dropouts are possible");
+        m_streamDetect.cnt_slow = 0;
     }
-    if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) cnt_slow++;
+    if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) m_streamDetect.cnt_slow++;
     if(bytesAvail) {
-        tmr_lost = millis() + 1000;
-        cnt_lost = 0;
+        m_streamDetect.tmr_lost = millis() + 1000;
+        m_streamDetect.cnt_lost = 0;
     }
     if(InBuff.bufferFilled() > InBuff.getMaxBlockSize() * 2) return false; // enough data available to play
 
     // if no audio data is received within three seconds, a new connection attempt is started.
-    if(tmr_lost < millis()) {
-        cnt_lost++;
-        tmr_lost = millis() + 1000;
-        if(cnt_lost == 5) { // 5s no data?
-            cnt_lost = 0;
+    if(m_streamDetect.tmr_lost < millis()) {
+        m_streamDetect.cnt_lost++;
+        m_streamDetect.tmr_lost = millis() + 1000;
+        if(m_streamDetect.cnt_lost == 5) { // 5s no data?
+            m_streamDetect.cnt_lost = 0;
             if (String(m_lastHost) == "api.openai.com") {
                 AUDIO_INFO("End of Stream.");
                 m_f_running = false;
                 setDatamode(AUDIO_NONE);
+            } else if(m_streamType == ST_WEBFILE && m_f_acceptRanges) {
+                AUDIO_INFO("Stream lost -> continue at byte %lu", (long unsigned int)m_webFilePos);
+                m_netReconnects++;
+                webFileRange(m_webFilePos);
             } else {
                 AUDIO_INFO("Stream lost -> try new connection");
+                m_netReconnects++;
                 connecttohost(m_lastHost);
             }
             return true;
@@ -6196,89 +6745,115 @@ uint32_t Audio::ogg_correctResumeFilePos(uint32_t resumeFilePos) {
     return 0;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t Audio::flac_correctResumeFilePos(uint32_t resumeFilePos) {
-    // The starting point is the next FLAC syncword
-    uint8_t  p1, p2;
-    boolean  found = false;
-    uint32_t pos = resumeFilePos;
+int32_t Audio::scanForFrame(uint32_t pos, uint32_t maxPos, int32_t (*findFrame)(uint8_t*, int32_t), uint32_t lookahead) {
+    // reads the file in blocks of AUDIO_RESUME_SCAN_BLOCK and lets findFrame() validate the frame headers in memory,
+    // a candidate is only taken if lookahead bytes behind it are in the block too (findFrame checks the next header)
+    uint32_t t0 = micros();
+    uint32_t startPos = pos;
+    int32_t  ret = -1;
+    m_resumeScanBytes = 0;
+    uint8_t* buf = (uint8_t*)CodecMem_Alloc(AUDIO_RESUME_SCAN_BLOCK, CODEC_MEM_AUTO, "resume scan");
+    if(!buf) return -1;
+    while(pos < maxPos && pos - startPos < AUDIO_RESUME_SCAN_MAX) {
+        uint32_t len = min((uint32_t)AUDIO_RESUME_SCAN_BLOCK, maxPos - pos);
+        audiofile.seek(pos);
+        int32_t n = audiofile.read(buf, len);
+        if(n <= 0) break;
+        m_resumeScanBytes += n;
+        bool f_last = (pos + n >= maxPos);
+        int32_t idx = findFrame(buf, n);
+        if(idx >= 0 && (idx + lookahead <= (uint32_t)n || f_last)) { ret = pos + idx; break; }
+        if(idx > 0) { pos += idx; continue; }          // candidate at the end of the block, check it with the next one
+        if(f_last) break;
+        pos += (n > (int32_t)lookahead) ? n - lookahead : n; // the tail is searched again
+    }
+    free(buf);
+    m_resumeScanUs = micros() - t0;
+    if(m_f_Log) log_i("resume scan %lu -> %li, %lu bytes in %lu us", (long unsigned)startPos, (long)ret,
+                      (long unsigned)m_resumeScanBytes, (long unsigned)m_resumeScanUs);
+    return ret;
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+int32_t Audio::codec_correctResumeFilePos(const AudioCodec_t* codec, uint32_t resumeFilePos) {
+    // the first frame header at or behind resumeFilePos that the codec's seekFrame() accepts, seekLookahead bytes behind
+    // it let seekFrame() check the following header too (MP3: the longest layer 3 frame)
     uint32_t maxPos = m_audioDataStart + m_audioDataSize;
-
-    if(pos + 2 >= maxPos) goto exit;
-
-    audiofile.seek(pos);
-    p1 = audiofile.read();
-    p2 = audiofile.read();
-    pos += 2;
-    while(!found && pos < maxPos) {
-        if(p1 == 0xFF && p2 == 0xF8) {
-            found = true;
-            break;
+    if(resumeFilePos < m_audioDataStart) resumeFilePos = m_audioDataStart;
+    if(resumeFilePos + 3 >= maxPos) return -1;
+    return scanForFrame(resumeFilePos, maxPos, codec->seekFrame, codec->seekLookahead);
+}
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint64_t Audio::ogg_readLastGranule() {
+    // one seek near EOF, search backwards for the last "OggS" page that carries a granule position
+    // the granule of the last page is the total number of samples (opus: incl. pre-skip, always 48kHz)
+    // the page must be of the stream that begins the file (serial number) and pass its CRC, "OggS" can occur in the
+    // audio data of an earlier page or in a chained stream
+    if(!audiofile) return 0;
+    const uint16_t blkSize = 4096;
+    uint32_t fileSize = audiofile.size();
+    uint32_t oldPos = audiofile.position();
+    uint32_t pos = fileSize;
+    uint64_t granule = 0;
+    uint32_t serial = 0;
+    uint8_t  first[27];
+    if(fileSize < 27) return 0;
+    audiofile.seek(0);
+    if(audiofile.read(first, 27) != 27 || memcmp(first, "OggS", 4)) { audiofile.seek(oldPos); return 0; }
+    for(int j = 3; j >= 0; j--) serial = (serial << 8) | first[14 + j];
+    uint8_t* buf = (uint8_t*)__malloc_heap_psram(blkSize + 27); // + 27: a page header may straddle two blocks
+    if(!buf) { audiofile.seek(oldPos); return 0; }
+
+    while(pos > 0 && fileSize - pos < UINT16_MAX + 27) { // a page is never larger than 65307 bytes
+        uint32_t start = (pos > blkSize) ? pos - blkSize : 0;
+        uint32_t len = min(fileSize - start, (uint32_t)blkSize + 27);
+        audiofile.seek(start);
+        len = audiofile.read(buf, len);
+        for(int32_t i = (int32_t)len - 27; i >= 0; i--) {
+            if(buf[i] != 'O' || buf[i + 1] != 'g' || buf[i + 2] != 'g' || buf[i + 3] != 'S' || buf[i + 4] != 0) continue;
+            uint64_t g = 0;
+            for(int j = 7; j >= 0; j--) g = (g << 8) | buf[i + 6 + j]; // little endian
+            if(g == UINT64_MAX) continue; // no packet ends on this page
+            if(!ogg_pageValid(start + i, serial)) continue;
+            granule = g;
+            goto exit;
         }
-        p1 = p2;
-        p2 = audiofile.read();
-        pos++;
+        pos = start;
     }
-    if(found) return (pos - 2);
-
 exit:
-    return -1;
+    audiofile.seek(oldPos);
+    free(buf);
+    if(granule) AUDIO_INFO("last granule position %llu", (long long unsigned int)granule);
+    return granule;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t Audio::mp3_correctResumeFilePos(uint32_t resumeFilePos) {
-/* this checks that the first 22 bits of the next frame header are the same as the current frame header, but it's still not foolproof
- * (could accidentally find a sequence in the bitstream which appears to match but is not actually the next frame header)
- * this could be made more error-resilient by checking several frames in a row and verifying that nSlots is the same in each case
-*/
-    boolean  found = false;
-    uint32_t pos = resumeFilePos;
-    uint32_t pos1 = 0, pos2 = 0;
-    uint32_t maxPos = m_audioDataStart + m_audioDataSize;
-    uint8_t byte1a, byte2a, byte3a;
-    uint8_t byte1b, byte2b, byte3b;
-
-    if(pos + 3 >= maxPos) goto exit;
-    if(pos < m_audioDataStart) pos = m_audioDataStart;
-    audiofile.seek(pos);
-
-    while(!found){
-        if(pos + 3 >= maxPos) goto exit;
-        byte1a = audiofile.read(); pos++;
-        byte2a = audiofile.read(); pos++;
-        while(true){
-            if(byte1a == 0xFF && (byte2a & 0x0E0) == 0xE0) {
-                byte3a = audiofile.read(); pos++;
-                pos1 = pos - 3; break;
-            }
-            byte1a = byte2a;
-            byte2a = audiofile.read(); pos++;
-            if(pos >= maxPos) goto exit;
-        }
-        // log_i("pos1 %i, byte1a %X, byte2a %X, byte3a %X", pos1, byte1a, byte2a, byte3a);
-
-        if(pos + 3 >= maxPos) goto exit;
-        byte1b = audiofile.read(); pos++;
-        byte2b = audiofile.read(); pos++;
-        while(true){
-            if(byte1b == 0xFF && (byte2b & 0x0E0) == 0xE0) {
-                byte3b = audiofile.read(); pos++;
-                pos2 = pos - 3; break;
-            }
-            byte1b = byte2b;
-            byte2b = audiofile.read(); pos++;
-            if(pos >= maxPos) goto exit;
+bool Audio::ogg_pageValid(uint32_t pos, uint32_t serial) {
+    // the page at pos belongs to the stream 'serial' and its CRC (polynomial 0x04C11DB7, CRC field as 0) is right
+    uint8_t  hdr[27 + 255];
+    uint8_t  blk[256];
+    uint32_t crc = 0, s = 0, bodyLen = 0;
+    auto update = [&](const uint8_t* p, uint32_t n) { // lambda, CRC over n bytes
+        while(n--) {
+            crc ^= (uint32_t)*p++ << 24;
+            for(int j = 0; j < 8; j++) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
         }
-
-        if((byte1a == byte1b) && (byte2a ==  byte2b) && ((byte3a & 0xFC) == (byte3b & 0xFC))){
-            if(byte1a == 0xFF && byte2a == 0xFF && byte3a == 0xFF) found = false; // 0xFFFFFF can't be
-            else found = true;
-        }
-    }
-    (void) pos2;
-    // log_i("found pos1=%i, pos2=%i", pos1, pos2);
-    if(found) return (pos1);
-
-exit:
-    return -1;
+    };
+    audiofile.seek(pos);
+    if(audiofile.read(hdr, 27) != 27) return false;
+    for(int j = 3; j >= 0; j--) s = (s << 8) | hdr[14 + j];
+    if(s != serial) return false;
+    uint8_t nSegs = hdr[26];
+    if(audiofile.read(hdr + 27, nSegs) != nSegs) return false;
+    for(int j = 0; j < nSegs; j++) bodyLen += hdr[27 + j];
+    uint32_t pageCrc = hdr[22] | (hdr[23] << 8) | (hdr[24] << 16) | ((uint32_t)hdr[25] << 24);
+    memset(hdr + 22, 0, 4);
+    update(hdr, 27 + nSegs);
+    while(bodyLen) {
+        uint32_t n = min(bodyLen, (uint32_t)sizeof(blk));
+        if(audiofile.read(blk, n) != n) return false; // truncated file, the page is incomplete
+        update(blk, n);
+        bodyLen -= n;
+    }
+    return crc == pageCrc;
 }
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint8_t Audio::determineOggCodec(uint8_t* data, uint16_t len) {
@@ -22,6 +22,14 @@
 #include <FS.h>
 #include <FFat.h>
 #include <atomic>
+#include "audio_codecs.h"
+#include "file_reader.h"
+#include "net_reader.h"
+#include "http_parser.h"
+#include "hls_prefetch.h"
+#include "ts_demux.h"
+#include "tls_client.h"
+#include "station_warmer.h"
 
 #if ESP_IDF_VERSION_MAJOR == 5
 #include <driver/i2s_std.h>
@@ -32,6 +40,30 @@
 #ifndef I2S_GPIO_UNUSED
   #define I2S_GPIO_UNUSED -1 // = I2S_PIN_NO_CHANGE in IDF < 5
 #endif
+#ifndef AUDIO_BENCHMARK
+  #define AUDIO_BENCHMARK 0  // 1: per codec decode cycles, real time factor, heap low water and PCM hash, see printDecodeStats()
+#endif
+#ifndef AUDIO_RESUME_SCAN_BLOCK
+  #define AUDIO_RESUME_SCAN_BLOCK 8192         // bytes per read while the first frame after a resume is searched
+#endif
+#ifndef AUDIO_RESUME_SCAN_MAX
+  #define AUDIO_RESUME_SCAN_MAX   (256 * 1024) // give up the search after that many bytes
+#endif
+#ifndef AUDIO_RANGE_MIN_SKIP
+  #define AUDIO_RANGE_MIN_SKIP    (64 * 1024)  // web file: the header parser jumps with a range request if it saves more
+#endif
+#ifndef AUDIO_HLS_START_BANDWIDTH
+  #define AUDIO_HLS_START_BANDWIDTH 128000     // HLS: bit/s assumed for the first variant, before anything is measured
+#endif
+#ifndef AUDIO_HLS_SWITCH_UP
+  #define AUDIO_HLS_SWITCH_UP     140          // HLS: a variant is taken if the throughput is that many percent of its bandwidth
+#endif
+#ifndef AUDIO_HLS_SWITCH_DOWN
+  #define AUDIO_HLS_SWITCH_DOWN   110          // HLS: below that many percent of the current bandwidth a lower variant follows
+#endif
+#ifndef AUDIO_HLS_SWITCH_HOLD
+  #define AUDIO_HLS_SWITCH_HOLD   3            // HLS: segments after a switch before the next switch up
+#endif
 using namespace std;
 
 extern __attribute__((weak)) void audio_info(const char*);
@@ -60,7 +92,7 @@ class AudioBuffer {
 // AudioBuffer will be allocated in PSRAM, If PSRAM not available or has not enough space AudioBuffer will be
 // allocated in FlashRAM with reduced size
 //
-//  m_buffer            m_readPtr                 m_writePtr                 m_endPtr
+//  m_buffer            m_readIdx                 m_writeIdx                 m_buffSize
 //   |                       |<------dataLength------->|<------ writeSpace ----->|
 //   ▼                       ▼                         ▼                         ▼
 //   ---------------------------------------------------------------------------------------------------------------
@@ -70,17 +102,19 @@ class AudioBuffer {
 //
 //
 //
-//   if the space between m_readPtr and buffend < m_resBuffSize copy data from the beginning to resBuff
-//   so that the mp3/aac/flac frame is always completed
+//   the first m_resBuffSize bytes of the ring are mirrored behind its end when they are written, so a mp3/aac/flac
+//   frame that wraps around is readable in one piece at getReadPtr(), the reader never copies
 //
-//  m_buffer                      m_writePtr                 m_readPtr        m_endPtr
+//  m_buffer                      m_writeIdx                 m_readIdx        m_buffSize
 //   |                                 |<-------writeSpace------>|<--dataLength-->|
 //   ▼                                 ▼                         ▼                ▼
 //   ---------------------------------------------------------------------------------------------------------------
-//   |                        <--m_buffSize-->                                    |      <--m_resBuffSize -->     |
+//   |  A  |                  <--m_buffSize-->                                    |  A  |  <--m_resBuffSize -->    |
 //   ---------------------------------------------------------------------------------------------------------------
 //   |<---  ------dataLength--  ------>|<-------freeSpace------->|
 //
+//   one producer (getWritePtr, bytesWritten) and one consumer (getReadPtr, bytesWasRead) may run in different tasks,
+//   each index is written by its own side only, resetBuffer() needs both sides to be idle
 //
 
 public:
@@ -109,21 +143,98 @@ protected:
     size_t   m_buffSizePSRAM    = UINT16_MAX * 10;   // most webstreams limit the advance to 100...300Kbytes
     size_t   m_buffSizeRAM      = 1600 * 10;
     size_t   m_buffSize         = 0;
-    size_t   m_freeSpace        = 0;
-    size_t   m_writeSpace       = 0;
-    size_t   m_dataLength       = 0;
     size_t   m_resBuffSizeRAM   = 2048;     // reserved buffspace, >= one wav  frame
     size_t   m_resBuffSizePSRAM = 4096 * 4; // reserved buffspace, >= one flac frame
+    size_t   m_resBuffSize      = 0;        // mirrored bytes behind the end of the ring
     size_t   m_maxBlockSize     = 1600;
     uint8_t* m_buffer           = NULL;
-    uint8_t* m_writePtr         = NULL;
-    uint8_t* m_readPtr          = NULL;
-    uint8_t* m_endPtr           = NULL;
-    bool     m_f_start          = true;
+    std::atomic<size_t> m_writeIdx{0};      // written by the producer only
+    std::atomic<size_t> m_readIdx{0};       // written by the consumer only
+    std::atomic<bool>   m_f_start{true};
     bool     m_f_init           = false;
     bool     m_f_psram          = false;    // PSRAM is available (and used...)
 };
 //----------------------------------------------------------------------------------------------------------------------
+// Statistics, one struct per subsystem; Audio::getStats() copies them all in one piece under the audio mutex, the
+// reader tasks hand their measurements over under their own locks or as atomics
+typedef struct _decodeStats{
+    uint32_t frames;         // decoded frames
+    uint64_t cycles;         // CPU cycles spent in decode()
+    uint32_t maxCycles;      // slowest frame
+    uint64_t pcmFrames;      // PCM frames (one sample per channel) produced
+    uint32_t sampleRate;     // of the last file
+    uint8_t  channels;
+    uint8_t  bitsPerSample;
+    uint32_t pcmHash;        // FNV-1a over the decoder output, for regression checks
+    uint32_t minFreeHeap;    // low water of the internal heap while decoding
+    uint32_t minFreePsram;
+} decodeStats_t;
+
+typedef struct _inputStats{
+    uint32_t decodeErrors;   // frames the decoder rejected, since the last connect
+    uint32_t resyncs;        // searches for the next frame after an error
+    uint32_t resyncSkipped;  // bytes dropped by these searches
+} inputStats_t;
+
+typedef struct _fileStats{
+    uint32_t headerMs;       // connect to "stream ready" of the last local file
+    uint32_t firstAudioMs;   // connect to the first decoded samples of the last local file, to I2S or the PCM sink
+    uint32_t readP50Us;      // read latency of the file reader task, upper bounds of the histogram buckets
+    uint32_t readP99Us;
+    uint32_t readMaxUs;
+    uint32_t readerStackUnused; // bytes of AUDIO_FILE_READER_STACK the reader task of the last file never used
+    uint32_t readerRuns;     // cluster runs the reader task reads the last file in, 0: through the file system
+    uint32_t resumeScanBytes;// bytes read by the last resume position correction
+    uint32_t resumeScanUs;
+} fileStats_t;
+
+typedef struct _netStats{
+    bool     readerActive;   // the net reader task receives the stream
+    uint32_t depth;          // bytes buffered, jitter buffer and input buffer
+    uint32_t target;         // depth that covers the measured jitter
+    uint32_t rate;           // measured throughput in bytes/s
+    uint32_t underruns;      // the stream ran dry while playing
+    uint32_t reconnects;
+    uint32_t webFileBytes;   // received for the last web file
+    uint32_t rangeRequests;  // of the last web file
+    uint32_t rangeSeekMs;    // the last range request took
+} netStats_t;
+
+typedef struct _hlsStats{
+    uint32_t segments;       // prefetched segments of the last stream
+    uint32_t failed;
+    uint32_t late;           // loaded slower than real time
+    uint32_t worstLoad;      // % of the segment duration
+    uint32_t switches;       // variant switches
+    uint32_t throughput;     // bit/s
+    uint32_t history[8];     // bandwidths of the last variant selections
+    uint8_t  historyLen;
+    uint32_t tsPackets;      // transport stream demultiplexer
+    uint32_t tsCcErrors;
+    uint32_t tsSyncLosses;
+    uint32_t tsDropped;
+} hlsStats_t;
+
+typedef struct _stationStats{
+    uint32_t lastMs;         // connecttohost() to the first samples of the last station
+    uint32_t cold;           // switches to a station that was not preconnected
+    uint32_t coldSumMs;
+    uint32_t warm;           // switches to a station of the station warmer
+    uint32_t warmSumMs;
+} stationStats_t;
+
+typedef struct _audioStats{
+    decodeStats_t  decode[10]; // per codec, indexed like getCodec(), AUDIO_BENCHMARK 1
+    inputStats_t   input;
+    fileStats_t    file;
+    netStats_t     net;
+    hlsStats_t     hls;
+    stationStats_t station;
+    tlsStats_t     tls;
+    uint32_t       arenaSize;  // codec arena
+    uint32_t       arenaHighWater;
+} audioStats_t;
+//----------------------------------------------------------------------------------------------------------------------
 
 class Audio : private AudioBuffer{
 
@@ -135,6 +246,7 @@ public:
     void setBufsize(int rambuf_sz, int psrambuf_sz);
     bool openai_speech(const String& api_key, const String& model, const String& input, const String& voice, const String& response_format, const String& speed);
     bool connecttohost(const char* host, const char* user = "", const char* pwd = "");
+    bool preconnect(const char* const* hosts, uint8_t n); // stations connecttohost() may get next, n = 0: none; needs PSRAM
     bool connecttospeech(const char* speech, const char* lang);
     bool connecttoFS(fs::FS &fs, const char* path, int32_t m_fileStartPos = -1);
     bool setFileLoop(bool input);//TEST loop
@@ -177,6 +289,21 @@ public:
     int getCodec() {return m_codec;}
     const char *getCodecname() {return codecname[m_codec];}
     void unicode2utf8(char* buff, uint32_t len);
+    bool openPcmSink(fs::FS &fs, const char* path, bool muteI2S = true); // dump decoded PCM into a WAV file
+    void closePcmSink();
+    bool     getFileReadLatency(uint32_t* p50, uint32_t* p99, uint32_t* maxUs); // µs, needs AUDIO_FILE_READER 1
+    uint32_t getNetBufferDepth();  // web stream bytes buffered, jitter buffer and input buffer
+    uint32_t getNetBufferTarget(); // depth that covers the measured jitter, playback (re)starts there
+    uint32_t getNetUnderruns() {return m_netUnderruns;}
+    uint32_t getNetReconnects() {return m_netReconnects;}
+    uint32_t getSwitchTime() {return m_switchMs;} // connecttohost() to the first samples of the last station
+    uint32_t getDecodeErrors() {return m_decodeErrorCount;} // since the last connect
+    uint32_t getResyncs() {return m_resyncCount;}
+    uint32_t getResyncSkippedBytes() {return m_resyncSkipped;}
+    bool     getCoverArt(uint32_t* pos, uint32_t* len) {*pos = m_coverArtPos; *len = m_coverArtLen; return m_coverArtLen > 0;} // local files
+    void getStats(audioStats_t* stats);         // a consistent copy of all statistics
+    void printDecodeStats(Print& out = Serial); // decode statistics (AUDIO_BENCHMARK 1), memory profile (CODEC_MEM_PROFILE 1)
+    void resetDecodeStats();
 
 private:
 
@@ -192,12 +319,23 @@ private:
   bool            latinToUTF8(char* buff, size_t bufflen, bool UTF8check = true);
   void            setDefaults(); // free buffers and set defaults
   void            initInBuff();
-  bool            httpPrint(const char* host);
+  bool            httpPrint(const char* host, int32_t rangeStart = -1);
+  bool            webFileRange(uint32_t pos);
+  void            connOrigin(const char* host, uint16_t port);
+  bool            headerCanSkip(uint32_t bytes);
   void            processLocalFile();
   void            processWebStream();
   void            processWebFile();
   void            processWebStreamTS();
   void            processWebStreamHLS();
+  bool            hlsPrefetching();
+  bool            hlsPrefetchStart();
+  void            hlsPrefetchFeed();
+  bool            hlsNextSegment();
+  uint32_t        hlsThroughput();
+  int8_t          hlsChooseVariant(uint32_t bps);
+  void            hlsSelectVariant(const hlsSegmentStat_t* st);
+  void            hlsVariantsClear();
   void            playAudioData();
   bool            readPlayListData();
   const char*     parsePlaylist_M3U();
@@ -205,12 +343,28 @@ private:
   const char*     parsePlaylist_ASX();
   const char*     parsePlaylist_M3U8();
   const char*     m3u8redirection(uint8_t* codec);
+  char*           m3u8ResolveURL(const char* url);
   uint64_t        m3u8_findMediaSeqInURL();
   bool            STfromEXTINF(char* str);
   void            showCodecParams();
   int             findNextSync(uint8_t* data, size_t len);
+  int             resyncOffset(uint8_t* data, size_t len);
+  int32_t         readLocalFile(uint8_t* buf, size_t len);
+  void            seekLocalFile(uint32_t pos);
+  int32_t         netAvailable();
+  int32_t         netRead(uint8_t* buf, size_t len);
+  int             netRead();
+  bool            readHttpLine();
+  bool            netBufferReady();
   int             sendBytes(uint8_t* data, size_t len);
   void            setDecoderItems();
+  size_t          outBuffBytes();
+  void            wavToPCM16(uint8_t* data, size_t len);
+  bool            passthroughPossible();
+  bool            openPcmSinkPart(uint16_t part);
+  void            writePcmSink();
+  void            writePcmSinkHeader();
+  void            updateDecodeStats(uint32_t cycles);
   void            computeAudioTime(uint16_t bytesDecoderIn, uint16_t bytesDecoderOut);
   void            printProcessLog(int r, const char* s = "");
   void            printDecodeError(int r);
@@ -240,24 +394,26 @@ private:
   int16_t*        IIR_filterChain0(int16_t iir_in[2], bool clear = false);
   int16_t*        IIR_filterChain1(int16_t iir_in[2], bool clear = false);
   int16_t*        IIR_filterChain2(int16_t iir_in[2], bool clear = false);
-  inline void     setDatamode(uint8_t dm) { m_datamode = dm; }
+  void            setDatamode(uint8_t dm);
   inline uint8_t  getDatamode() { return m_datamode; }
-  inline uint32_t streamavail() { return _client ? _client->available() : 0; }
+  inline uint32_t streamavail() { return _client ? netAvailable() : 0; }
   void            IIR_calculateCoefficients(int8_t G1, int8_t G2, int8_t G3);
-  bool            ts_parsePacket(uint8_t* packet, uint8_t* packetStart, uint8_t* packetLength);
 
   //+++ W E B S T R E A M  -  H E L P   F U N C T I O N S +++
-  uint16_t readMetadata(uint16_t b, bool first = false);
-  size_t   chunkedDataTransfer(uint8_t* bytes);
+  size_t   unframeStream(uint8_t* data, size_t len);
+  void     showIcyMetadata(char* meta);
+  int32_t  chunkedDataTransfer(uint8_t* bytes);
   bool     readID3V1Tag();
   boolean  streamDetection(uint32_t bytesAvail);
   void     seek_m4a_stsz();
   void     seek_m4a_ilst();
   uint32_t m4a_correctResumeFilePos(uint32_t resumeFilePos);
   uint32_t ogg_correctResumeFilePos(uint32_t resumeFilePos);
-  int32_t  flac_correctResumeFilePos(uint32_t resumeFilePos);
-  int32_t  mp3_correctResumeFilePos(uint32_t resumeFilePos);
+  int32_t  codec_correctResumeFilePos(const AudioCodec_t* codec, uint32_t resumeFilePos);
+  int32_t  scanForFrame(uint32_t pos, uint32_t maxPos, int32_t (*findFrame)(uint8_t*, int32_t), uint32_t lookahead);
   uint8_t  determineOggCodec(uint8_t* data, uint16_t len);
+  uint64_t ogg_readLastGranule();
+  bool     ogg_pageValid(uint32_t pos, uint32_t serial);
 
   //++++ implement several function with respect to the index of string ++++
   void strlower(char* str) {
@@ -310,7 +466,7 @@ private:
         const char *p = base;
         for (; startIndex > 0; startIndex--)
             if (*p++ == '\0') return -1;
-        char* pos = strstr(p, str);
+        const char* pos = strstr(p, str);
         if (pos == nullptr) return -1;
         return pos - base;
     }
@@ -320,7 +476,7 @@ private:
         const char *p = base;
         for (; startIndex > 0; startIndex--)
             if (*p++ == '\0') return -1;
-        char *pos = strchr(p, ch);
+        const char *pos = strchr(p, ch);
         if (pos == nullptr) return -1;
         return pos - base;
     }
@@ -437,9 +593,8 @@ private:
                  FLAC_SEEK = 6, FLAC_VORBIS = 7, FLAC_CUESHEET = 8, FLAC_PICTURE = 9, FLAC_OKAY = 100};
     enum : int { M4A_BEGIN = 0, M4A_FTYP = 1, M4A_CHK = 2, M4A_MOOV = 3, M4A_FREE = 4, M4A_TRAK = 5, M4A_MDAT = 6,
                  M4A_ILST = 7, M4A_MP4A = 8, M4A_AMRDY = 99, M4A_OKAY = 100};
-    enum : int { CODEC_NONE = 0, CODEC_WAV = 1, CODEC_MP3 = 2, CODEC_AAC = 3, CODEC_M4A = 4, CODEC_FLAC = 5,
-                 CODEC_AACP = 6, CODEC_OPUS = 7, CODEC_OGG = 8, CODEC_VORBIS = 9};
     enum : int { ST_NONE = 0, ST_WEBFILE = 1, ST_WEBSTREAM = 2};
+    enum : int { WAVE_FORMAT_PCM = 1, WAVE_FORMAT_IEEE_FLOAT = 3, WAVE_FORMAT_EXTENSIBLE = 0xFFFE };
     typedef enum { LEFTCHANNEL=0, RIGHTCHANNEL=1 } SampleIndex;
     typedef enum { LOWSHELF = 0, PEAKEQ = 1, HIFGSHELF =2 } FilterType;
 
@@ -456,9 +611,135 @@ private:
         int pids[4];
     } pid_array;
 
+    typedef struct _hlsVariant{
+        char*    url;            // media playlist
+        uint32_t bandwidth;      // bit/s, AVERAGE-BANDWIDTH if given, else BANDWIDTH
+        char     codecs[48];     // the CODECS attribute, "" if there is none
+    } hlsVariant_t;
+
+    typedef struct _wavHeader{ // read_WAV_Header() between its calls
+        size_t   headerSize = 0;
+        uint32_t cs = 0;
+        uint8_t  bts = 0;
+    } wavHeader_t;
+
+    typedef struct _flacHeader{ // read_FLAC_Header() between its calls
+        size_t   headerSize = 0;
+        size_t   retvalue = 0;
+        bool     f_lastMetaBlock = false;
+        uint32_t picPos = 0;
+        uint32_t picLen = 0;
+    } flacHeader_t;
+
+    typedef struct _id3Header{ // read_ID3_Header() between its calls
+        size_t   id3Size = 0;
+        size_t   totalId3Size = 0;               // if we have more header, id3_1_size + id3_2_size + ....
+        size_t   remainingHeaderBytes = 0;
+        size_t   universal_tmp = 0;
+        uint8_t  ID3version = 0;
+        int      ehsz = 0;
+        char     tag[5] = {};
+        char     frameid[5] = {};
+        size_t   framesize = 0;
+        bool     compressed = false;
+        size_t   APIC_size[3] = {0};
+        uint32_t APIC_pos[3] = {0};
+        bool     SYLT_seen = false;
+        size_t   SYLT_size = 0;
+        uint32_t SYLT_pos = 0;
+        uint8_t  numID3Header = 0;
+    } id3Header_t;
+
+    typedef struct _m4aHeader{ // read_M4A_Header() between its calls
+        size_t   headerSize = 0;
+        size_t   retvalue = 0;
+        size_t   atomsize = 0;
+        size_t   audioDataPos = 0;
+        uint32_t picPos = 0;
+        uint32_t picLen = 0;
+        size_t   cnt = 0;
+    } m4aHeader_t;
+
+    typedef struct _m3u8State{ // parsePlaylist_M3U8() between its calls
+        uint64_t xMedSeq = 0;
+        boolean  f_mediaSeq_found = false;
+    } m3u8State_t;
+
+    typedef struct _localFile{ // processLocalFile() between its calls
+        uint32_t ctime = 0;
+        bool     f_stream = false;
+        bool     f_fileDataComplete = false;
+        uint32_t byteCounter = 0;                // count received data
+    } localFile_t;
+
+    typedef struct _webStream{ // processWebStream() between its calls
+        bool f_stream = false;                   // first audio data received
+        bool f_rebuffer = false;                 // ran dry, wait for the target depth again
+    } webStream_t;
+
+    typedef struct _webFile{ // processWebFile() between its calls
+        bool     f_stream = false;               // first audio data received
+        bool     f_webFileDataComplete = false;  // all file data received
+        uint32_t chunkSize = 0;                  // chunkcount read from stream
+        size_t   audioDataCount = 0;             // counts the decoded audiodata only
+    } webFile_t;
+
+    typedef struct _webStreamTS{ // processWebStreamTS() between its calls
+        bool     f_stream = false;               // first audio data received
+        bool     f_firstPacket = false;
+        bool     f_chunkFinished = false;
+        uint32_t byteCounter = 0;                // count received data
+        uint8_t  ts_batch[AUDIO_TS_BATCH * TS_PACKET_SIZE] = {}; // received packets, a partial one stays at the front
+        size_t   ts_fill = 0;
+        size_t   chunkSize = 0;
+    } webStreamTS_t;
+
+    typedef struct _webStreamHLS{ // processWebStreamHLS() between its calls
+        bool     f_stream = false;               // first audio data received
+        bool     firstBytes = false;
+        bool     f_chunkFinished = false;
+        uint32_t byteCounter = 0;                // count received data
+        size_t   chunkSize = 0;
+        uint16_t ID3WritePtr = 0;
+        uint16_t ID3ReadPtr = 0;
+        uint8_t* ID3Buff = nullptr;
+    } webStreamHLS_t;
+
+    typedef struct _vuLevel{ // computeVUlevel() between its calls
+        uint8_t sampleArray[2][4][8] = {0};
+        uint8_t cnt0 = 0;
+        uint8_t cnt1 = 0;
+        uint8_t cnt2 = 0;
+        uint8_t cnt3 = 0;
+        uint8_t cnt4 = 0;
+        bool    f_vu = false;
+    } vuLevel_t;
+
+    typedef struct _iirChain{ // IIR_filterChain0..2() between their calls, one per chain
+        int16_t iir_out[2] = {};
+    } iirChain_t;
+
+    typedef struct _streamDetect{ // streamDetection() between its calls
+        uint32_t tmr_slow = 0;                   // millis()
+        uint32_t tmr_lost = 0;                   // millis(), deadline for the next data
+        uint8_t  cnt_slow = 0;
+        uint8_t  cnt_lost = 0;
+    } streamDetect_t;
+
     File                  audiofile;    // @suppress("Abstract class cannot be instantiated")
-    WiFiClient            client;       // @suppress("Abstract class cannot be instantiated")
-    WiFiClientSecure      clientsecure; // @suppress("Abstract class cannot be instantiated")
+    File                  m_pcmSink;    // @suppress("Abstract class cannot be instantiated")
+#if AUDIO_FILE_READER
+    FileReader            m_fileReader; // prefetches audiofile in its own task
+#endif
+#if AUDIO_NET_READER
+    NetReader             m_netReader;  // receives a web stream in its own task
+#endif
+    HlsPrefetch           m_hlsPrefetch; // downloads the next HLS segments while the current one plays, AUDIO_HLS_PREFETCH > 0
+    HttpParser            m_httpParser; // response header, chunks and ICY metadata
+    TsDemux               m_tsDemux;    // AAC out of the HLS transport stream segments
+    StationWarmer         m_warmer;     // keeps the stations of preconnect() connected, AUDIO_WARM_STATIONS > 0
+    ReplayClient<WiFiClient> client;    // @suppress("Abstract class cannot be instantiated")
+    ReplayClient<TlsClient>  clientsecure; // @suppress("Abstract class cannot be instantiated") resumes TLS sessions
     WiFiClient*           _client = nullptr;
     SemaphoreHandle_t     mutex_audio;
 
@@ -476,14 +757,11 @@ private:
 
     std::vector<char*>    m_playlistContent;  // m3u8 playlist buffer
     std::vector<char*>    m_playlistURL;      // m3u8 streamURLs buffer
+    std::vector<uint32_t> m_playlistDur;      // their #EXTINF durations in ms
+    std::vector<hlsVariant_t> m_hlsVariants;  // master playlist, playable variants by bandwidth
     std::vector<uint32_t> m_hashQueue;
 
     const size_t    m_frameSizeWav    = 2048;
-    const size_t    m_frameSizeMP3    = 1600;
-    const size_t    m_frameSizeAAC    = 1600;
-    const size_t    m_frameSizeFLAC   = 4096 * 4;
-    const size_t    m_frameSizeOPUS   = 1024;
-    const size_t    m_frameSizeVORBIS = 4096 * 2;
     const size_t    m_outbuffSize     = 4096 * 2;
 
     static const uint8_t m_tsPacketSize  = 188;
@@ -495,6 +773,8 @@ private:
     uint16_t        m_ibuffSize = 0;                // will set in constructor (depending on PSRAM)
     char*           m_lastHost = NULL;              // Store the last URL to a webstream
     char*           m_lastM3U8host = NULL;
+    char*           m_connHost = NULL;              // origin of the open connection, a request to it reuses the connection
+    uint16_t        m_connPort = 0;
     char*           m_playlistBuff = NULL;          // stores playlistdata
     const uint16_t  m_plsBuffEntryLen = 256;        // length of each entry in playlistBuff
     filter_t        m_filter[3];                    // digital filters
@@ -503,7 +783,21 @@ private:
     uint32_t        m_bitRate=0;                    // current bitrate given fom decoder
     uint32_t        m_avr_bitrate = 0;              // average bitrate, median computed by VBR
     int             m_readbytes = 0;                // bytes read
-    uint32_t        m_metacount = 0;                // counts down bytes between metadata
+    wavHeader_t     m_wavHdr;                       // state of read_WAV_Header()
+    flacHeader_t    m_flacHdr;                      // state of read_FLAC_Header()
+    id3Header_t     m_id3Hdr;                       // state of read_ID3_Header()
+    m4aHeader_t     m_m4aHdr;                       // state of read_M4A_Header()
+    m3u8State_t     m_m3u8;                         // state of parsePlaylist_M3U8()
+    localFile_t     m_localFile;                    // state of processLocalFile()
+    webStream_t     m_webStream;                    // state of processWebStream()
+    webFile_t       m_webFile;                      // state of processWebFile()
+    webStreamTS_t   m_webTS;                        // state of processWebStreamTS()
+    webStreamHLS_t  m_webHLS;                       // state of processWebStreamHLS()
+    vuLevel_t       m_vuLevel;                      // state of computeVUlevel()
+    iirChain_t      m_iirChain0;                    // state of IIR_filterChain0()
+    iirChain_t      m_iirChain1;                    // state of IIR_filterChain1()
+    iirChain_t      m_iirChain2;                    // state of IIR_filterChain2()
+    streamDetect_t  m_streamDetect;                 // state of streamDetection()
     int             m_controlCounter = 0;           // Status within readID3data() and readWaveHeader()
     int8_t          m_balance = 0;                  // -16 (mute left) ... +16 (mute right)
     uint16_t        m_vol = 21;                     // volume
@@ -540,6 +834,7 @@ private:
     uint32_t        m_metaint = 0;                  // Number of databytes between metadata
     uint32_t        m_chunkcount = 0 ;              // Counter for chunked transfer
     uint32_t        m_t0 = 0;                       // store millis(), is needed for a small delay
+    uint32_t        m_httpTime = 0;                 // millis() of the last response header byte
 	//uint32_t        m_byteCounter = 0;              // count received data
     uint32_t        m_contentlength = 0;            // Stores the length if the stream comes from fileserver
     uint32_t        m_bytesNotDecoded = 0;          // pictures or something else that comes with the stream
@@ -559,6 +854,9 @@ private:
     bool            m_f_firstCurTimeCall = false;   // InitSequence for computeAudioTime
     bool            m_f_firstM3U8call = false;      // InitSequence for m3u8 parsing
     bool            m_f_chunked = false ;           // Station provides chunked transfer
+    bool            m_f_connSsl = false;            // the open connection is clientsecure
+    bool            m_f_connClose = false;          // the last response ends with the connection ("Connection: close")
+    bool            m_f_bodyRead = false;           // the body of the last response has been read to its Content-Length
     bool            m_f_firstmetabyte = false;      // True if first metabyte (counter)
     bool            m_f_playing = false;            // valid mp3 stream recognized
     bool            m_f_tts = false;                // text to speech
@@ -573,6 +871,8 @@ private:
     bool            m_f_m4aID3dataAreRead = false;  // has the m4a-ID3data already been read?
     bool            m_f_psramFound = false;         // set in constructor, result of psramInit()
     bool            m_f_timeout = false;            //
+    bool            m_f_ctSeen = false;             // response header has a usable content-type
+    bool            m_f_httpData = false;           // first byte of the response received
     uint8_t         m_f_channelEnabled = 3;         // internal DAC, both channels
     uint32_t        m_audioFileDuration = 0;
     float           m_audioCurrentTime = 0;
@@ -581,7 +881,74 @@ private:
     float           m_filterBuff[3][2][2][2];       // IIR filters memory for Audio DSP
     float           m_corr = 1.0;					// correction factor for level adjustment
     size_t          m_i2s_bytesWritten = 0;         // set in i2s_write() but not used
+    fs::FS*         m_pcmSinkFS = NULL;             // of m_pcmSink, the next part is opened there
+    char*           m_pcmSinkPath = NULL;           // as given to openPcmSink(), part 1
+    uint16_t        m_pcmSinkPart = 0;              // 1: path, 2: path-2.wav ..
+    uint32_t        m_pcmSinkBytes = 0;             // PCM bytes written to m_pcmSink (WAV data chunk size)
+    uint32_t        m_pcmSinkSampleRate = 0;        // format of the PCM in m_pcmSink, taken from its first chunk
+    uint8_t         m_pcmSinkChannels = 0;
+    uint8_t         m_pcmSinkBitsPerSample = 0;
+    bool            m_f_pcmSinkMute = false;        // PCM goes to m_pcmSink only, I2S is skipped
+    uint32_t        m_decodeErrorCount = 0;         // frames the decoder rejected
+    uint32_t        m_resyncCount = 0;              // searches for the next frame after an error
+    uint32_t        m_resyncSkipped = 0;            // bytes dropped by these searches
+    uint32_t        m_resumeScanBytes = 0;          // bytes read by the last resume position correction
+    uint32_t        m_resumeScanUs = 0;             // and the time it took
+    uint32_t        m_netUnderruns = 0;             // web stream ran dry while playing, counted until resetDecodeStats()
+    uint32_t        m_netReconnects = 0;            // "stream lost" reconnects, counted until resetDecodeStats()
+    uint32_t        m_headerSkip = 0;               // bytes the header parser wants to seek over, see headerCanSkip()
+    int32_t         m_headerSeekPos = -1;           // web file: the header parser continues there (m4a moov behind mdat)
+    uint32_t        m_webFilePos = 0;               // web file: file position of the next byte from the socket
+    uint32_t        m_rangeSkipTo = 0;              // the server ignored the range, read over the data up to here
+    int32_t         m_rangeStart = -1;              // first byte of the range response, from content-range
+    uint32_t        m_rangeTime = 0;                // millis() of the pending range request
+    uint32_t        m_rangeSeekMs = 0;              // last range request to "stream ready"
+    uint32_t        m_rangeRequests = 0;            // seeks, resumes and header jumps of the last web file
+    uint32_t        m_webFileBytes = 0;             // bytes received for the last web file
+    bool            m_f_acceptRanges = false;       // the server sent "Accept-Ranges: bytes"
+    bool            m_f_rangeRequest = false;       // the pending response answers a range request
+    uint32_t        m_hlsSegmentMs = 0;             // #EXTINF duration of m_playlistBuff
+    uint32_t        m_hlsPlaylistTime = 0;          // millis() of the last playlist refresh request
+    uint32_t        m_hlsRefreshMs = 0;             // and the time until the next one
+    uint32_t        m_hlsSegments = 0;              // prefetched segments of the last stream
+    uint32_t        m_hlsFailed = 0;                // of them not downloaded completely
+    uint32_t        m_hlsLate = 0;                  // downloaded slower than real time
+    uint32_t        m_hlsWorstLoad = 0;             // longest download in percent of the segment duration
+    int8_t          m_hlsVariant = -1;              // index in m_hlsVariants of the media playlist in m_lastM3U8host
+    uint8_t         m_hlsHold = 0;                  // segments since the last variant switch
+    uint32_t        m_hlsBwFast = 0;                // bit/s, segment throughput averaged over ~2 segments
+    uint32_t        m_hlsBwSlow = 0;                // and over ~8, kept from station to station
+    uint32_t        m_hlsHistory[8] = {0};          // bandwidths of the last variant selections
+    uint8_t         m_hlsHistoryLen = 0;
+    uint32_t        m_hlsSwitches = 0;              // variant switches of the last stream
+    uint64_t        m_hlsLastSeq = UINT64_MAX;      // #EXT-X-MEDIA-SEQUENCE number of the last queued segment
+    bool            m_f_hlsAlign = false;           // the next media playlist is a new variant, see parsePlaylist_M3U8()
+    uint32_t        m_headerTimeMs = 0;             // connect to "stream ready" of the last local file
+    uint32_t        m_fileStartTime = 0;            // millis() of connecttoFS() until the first samples are decoded
+    uint32_t        m_firstAudioMs = 0;             // and the time it took for the last local file
+    uint32_t        m_switchTime = 0;               // millis() of connecttohost() until the first samples are played
+    uint32_t        m_switchMs = 0;                 // and the time it took for the last station
+    uint32_t        m_switches[2] = {0};            // station switches [cold, warm], counted until resetDecodeStats()
+    uint32_t        m_switchSumMs[2] = {0};
+    bool            m_f_switchWarm = false;         // the last station was taken from m_warmer
+    uint32_t        m_coverArtPos = 0;              // first embedded picture (ID3 APIC/PIC, FLAC PICTURE, M4A covr)
+    uint32_t        m_coverArtLen = 0;
+    uint16_t        m_wavFormat = WAVE_FORMAT_PCM;  // format code of the wav file, EXTENSIBLE resolved to its subformat
+    uint8_t         m_wavBytesPerSample = 2;        // container size of one wav sample, 1...8
+#if AUDIO_BENCHMARK
+    decodeStats_t   m_decodeStats[10] = {};         // indexed by m_codec
+#endif
     size_t          m_fileSize = 0;                // size of the file
+    uint64_t        m_oggLastGranule = 0;           // granule position of the last ogg page, 0 if unknown
+    uint64_t        m_sumBytesIn = 0;               // computeAudioTime()
+    uint64_t        m_sumBytesOut = 0;              //          "
+    uint32_t        m_sumBitRate = 0;               //          "
+    uint32_t        m_bitRateCounter = 0;           //          "
+    uint32_t        m_timeStamp = 0;                //          "
+    uint32_t        m_deltaBytesIn = 0;             //          "
+    uint32_t        m_nominalBitRate = 0;           //          "
+    uint32_t        m_syncwordNotFound = 0;         // findNextSync()
+    bool            m_f_setDecodeParamsOnce = true; // sendBytes()
     uint16_t        m_filterFrequency[2];
     int8_t          m_gain0 = 0;                    // cut or boost filters (EQ)
     int8_t          m_gain1 = 0;
@@ -6,7 +6,11 @@
  *  Updated on: 22.05.2024
  ************************************************************************************/
 
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_AAC
+
 #include "aac_decoder.h"
+#include <new>
 
 const uint32_t SQRTHALF             = 0x5a82799a;    /* sqrt(0.5), format = Q31 */
 const uint32_t Q28_2                = 0x20000000;    /* Q28: 2.0 */
@@ -76,15 +80,21 @@ const uint16_t nfftTab[2]           = {64, 512};
 const uint8_t  nfftlog2Tab[2]       = {6, 9};
 const uint8_t  cos4sin4tabOffset[2] = {0, 128};
 
-PSInfoBase_t        *m_PSInfoBase;
-AACDecInfo_t        *m_AACDecInfo;
-AACFrameInfo_t       m_AACFrameInfo;
-ADTSHeader_t         m_fhADTS;
-ADIFHeader_t         m_fhADIF;
-ProgConfigElement_t *m_pce[16];
-PulseInfo_t          m_pulseInfo[2]; // [MAX_NCHANS_ELEM]
-aac_BitStreamInfo_t  m_aac_BitStreamInfo;
-PSInfoSBR_t         *m_PSInfoSBR;
+AACDecoder_t s_aacDefault; // the context of the codec registry
+
+AACDecoder_t* AACDecoder_Create(){ // a further, independent decoder, e.g. to probe or preroll a second stream
+    AACDecoder_t* dec = new (std::nothrow) AACDecoder_t;
+    if(!dec) log_e("not enough memory to allocate an aacdecoder context");
+    return dec;
+}
+void AACDecoder_Destroy(AACDecoder_t* dec){
+    if(!dec || dec == &s_aacDefault) return;
+    AACDecoder_FreeBuffers(dec);
+    delete dec;
+}
+AACDecoder_t* AACDecoder_Default(){
+    return &s_aacDefault;
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 inline int32_t MULSHIFT32(int32_t x, int32_t y){
@@ -374,7 +384,7 @@ const int32_t cos1sin1tab[514] PROGMEM = {
 
 const uint8_t sinWindowOffset[NUM_IMDCT_SIZES] PROGMEM = {0, 128};
 
-const int32_t sinWindow[128 + 1024] PROGMEM = {
+const int32_t sinWindow[128 + 1024] CODEC_HOT_TABLE = {
 /* 128 - format = Q31 * 2^0 */
 0x00c90f88, 0x7fff6216, 0x025b26d7, 0x7ffa72d1, 0x03ed26e6, 0x7ff09478, 0x057f0035, 0x7fe1c76b,
 0x0710a345, 0x7fce0c3e, 0x08a2009a, 0x7fb563b3, 0x0a3308bd, 0x7f97cebd, 0x0bc3ac35, 0x7f754e80,
@@ -525,7 +535,7 @@ const int32_t sinWindow[128 + 1024] PROGMEM = {
 
 const int32_t kbdWindowOffset[NUM_IMDCT_SIZES] PROGMEM = {0, 128};
 
-const int32_t kbdWindow[128 + 1024] PROGMEM = {
+const int32_t kbdWindow[128 + 1024] CODEC_HOT_TABLE = {
 /* 128 - format = Q31 * 2^0 */
 0x00016f63, 0x7ffffffe, 0x0003e382, 0x7ffffff1, 0x00078f64, 0x7fffffc7, 0x000cc323, 0x7fffff5d,
 0x0013d9ed, 0x7ffffe76, 0x001d3a9d, 0x7ffffcaa, 0x0029581f, 0x7ffff953, 0x0038b1bd, 0x7ffff372,
@@ -1655,23 +1665,21 @@ static const int8_t negMask[3] = {~0x03, ~0x07, ~0x0f};
  *
  **********************************************************************************************************************/
 
-#ifdef CONFIG_IDF_TARGET_ESP32S3
-    // ESP32-S3: If there is PSRAM, prefer it
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
-#else
-    // ESP32, PSRAM is too slow, prefer SRAM
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM)
+uint32_t AACDecoder_ArenaSize(void){ // bytes AACDecoder_AllocateBuffers() takes from the codec arena
+    uint32_t size = ((sizeof(AACDecInfo_t) + 7) & ~7) + ((sizeof(PSInfoBase_t) + 7) & ~7) + ((sizeof(ProgConfigElement_t) * 16 + 7) & ~7);
+#ifdef AAC_ENABLE_SBR
+    size += (sizeof(PSInfoSBR_t) + 7) & ~7;
 #endif
+    return size;
+}
 
-bool AACDecoder_AllocateBuffers(void){
+bool AACDecoder_AllocateBuffers(AACDecoder_t* dec){
 
     /* here, sizes are: AACDecInfo_t:96 PSInfoBase_t:27364 ProgConfigElement_t*16:1312 PSInfoSBR_t:50788 */
 #ifdef AAC_ENABLE_SBR
-    if(!m_PSInfoSBR) {m_PSInfoSBR   = (PSInfoSBR_t*)__malloc_heap_psram(sizeof(PSInfoSBR_t));}
+    if(!dec->psInfoSBR) {dec->psInfoSBR   = (PSInfoSBR_t*)CodecArena_Alloc(sizeof(PSInfoSBR_t));}
 
-    if(!m_PSInfoSBR) {
+    if(!dec->psInfoSBR) {
         log_e("OOM in SBR, can't allocate %d bytes\n", sizeof(PSInfoSBR_t));
         return false; // ERR_AAC_SBR_INIT;
     }
@@ -1681,38 +1689,38 @@ bool AACDecoder_AllocateBuffers(void){
 #endif
 
     /* these could fall back to PSRAM if not enough heap available */
-    if(!m_AACDecInfo) {m_AACDecInfo = (AACDecInfo_t*)        __malloc_heap_psram(sizeof(AACDecInfo_t));}
-    if(!m_PSInfoBase) {m_PSInfoBase = (PSInfoBase_t*)        __malloc_heap_psram(sizeof(PSInfoBase_t));}
-    if(!m_pce[0])     {m_pce[0]     = (ProgConfigElement_t*) __malloc_heap_psram(sizeof(ProgConfigElement_t)*16);}
+    if(!dec->aacDecInfo) {dec->aacDecInfo = (AACDecInfo_t*)        CodecArena_Alloc(sizeof(AACDecInfo_t));}
+    if(!dec->psInfoBase) {dec->psInfoBase = (PSInfoBase_t*)        CodecArena_Alloc(sizeof(PSInfoBase_t));}
+    if(!dec->pce[0])     {dec->pce[0]     = (ProgConfigElement_t*) CodecArena_Alloc(sizeof(ProgConfigElement_t)*16);}
 
-    if(!m_AACDecInfo || !m_PSInfoBase || !m_pce[0]) {
+    if(!dec->aacDecInfo || !dec->psInfoBase || !dec->pce[0]) {
             log_e("not enough memory to allocate aacdecoder buffers");
-            AACDecoder_FreeBuffers();
+            AACDecoder_FreeBuffers(dec);
             return false;
     }
 
     // Clear Buffer
-    memset( m_AACDecInfo,        0, sizeof(AACDecInfo_t));              //Clear AACDecInfo
-    memset( m_PSInfoBase,        0, sizeof(PSInfoBase_t));              //Clear PSInfoBase
-    memset(&m_AACFrameInfo,      0, sizeof(AACFrameInfo_t));            //Clear AACFrameInfo
-    memset(&m_fhADTS,            0, sizeof(ADTSHeader_t));              //Clear fhADTS
-    memset(&m_fhADIF,            0, sizeof(ADIFHeader_t));              //Clear fhADIS
-    memset( m_pce[0],            0, sizeof(ProgConfigElement_t) * 16);  //Clear ProgConfigElement
-    memset(&m_pulseInfo[0],      0, sizeof(PulseInfo_t) *2);            //Clear PulseInfo
-    memset(&m_aac_BitStreamInfo, 0, sizeof(aac_BitStreamInfo_t));       //Clear aac_BitStreamInfo
+    memset( dec->aacDecInfo,        0, sizeof(AACDecInfo_t));              //Clear AACDecInfo
+    memset( dec->psInfoBase,        0, sizeof(PSInfoBase_t));              //Clear PSInfoBase
+    memset(&dec->aacFrameInfo,      0, sizeof(AACFrameInfo_t));            //Clear AACFrameInfo
+    memset(&dec->fhADTS,            0, sizeof(ADTSHeader_t));              //Clear fhADTS
+    memset(&dec->fhADIF,            0, sizeof(ADIFHeader_t));              //Clear fhADIS
+    memset( dec->pce[0],            0, sizeof(ProgConfigElement_t) * 16);  //Clear ProgConfigElement
+    memset(&dec->pulseInfo[0],      0, sizeof(PulseInfo_t) *2);            //Clear PulseInfo
+    memset(&dec->bsi, 0, sizeof(aac_BitStreamInfo_t));       //Clear aac_BitStreamInfo
 #ifdef AAC_ENABLE_SBR
-    memset( m_PSInfoSBR,         0, sizeof(PSInfoSBR_t));               //Clear PSInfoSBR
-    InitSBRState();
+    memset( dec->psInfoSBR,         0, sizeof(PSInfoSBR_t));               //Clear PSInfoSBR
+    InitSBRState(dec);
 #endif
 
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    dec->aacDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currInstTag = -1;
     for(int32_t ch = 0; ch < MAX_NCHANS_ELEM; ch++)
-        m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
-    m_AACDecInfo->adtsBlocksLeft = 0;
-    m_AACDecInfo->tnsUsed = 0;
-    m_AACDecInfo->pnsUsed = 0;
+        dec->aacDecInfo->sbDeinterleaveReqd[ch] = 0;
+    dec->aacDecInfo->adtsBlocksLeft = 0;
+    dec->aacDecInfo->tnsUsed = 0;
+    dec->aacDecInfo->pnsUsed = 0;
 
     return true;
 }
@@ -1728,29 +1736,29 @@ bool AACDecoder_AllocateBuffers(void){
  *
  * Return:      0 if successful, error code (< 0) if error
  **************************************************************************************/
-int32_t AACFlushCodec()
+int32_t AACFlushCodec(AACDecoder_t* dec)
 {
     int32_t ch;
 
-    if (!m_AACDecInfo)
+    if (!dec->aacDecInfo)
         return ERR_AAC_NULL_POINTER;
 
     /* reset common state variables which change per-frame
      * don't touch state variables which are (usually) constant for entire clip
      *   (nChans, sampRate, profile, format, sbrEnabled)
      */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    dec->aacDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currInstTag = -1;
     for (ch = 0; ch < MAX_NCHANS_ELEM; ch++)
-        m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
-    m_AACDecInfo->adtsBlocksLeft = 0;
-    m_AACDecInfo->tnsUsed = 0;
-    m_AACDecInfo->pnsUsed = 0;
+        dec->aacDecInfo->sbDeinterleaveReqd[ch] = 0;
+    dec->aacDecInfo->adtsBlocksLeft = 0;
+    dec->aacDecInfo->tnsUsed = 0;
+    dec->aacDecInfo->pnsUsed = 0;
 
     /* reset internal codec state (flush overlap buffers, etc.) */
-    memset(m_PSInfoBase->overlap, 0,  AAC_MAX_NCHANS * AAC_MAX_NSAMPS * sizeof(int32_t));
-    memset(m_PSInfoBase->prevWinShape, 0, AAC_MAX_NCHANS * sizeof(int32_t));
+    memset(dec->psInfoBase->overlap, 0,  AAC_MAX_NCHANS * AAC_MAX_NSAMPS * sizeof(int32_t));
+    memset(dec->psInfoBase->prevWinShape, 0, AAC_MAX_NCHANS * sizeof(int32_t));
 
     return ERR_AAC_NONE;
 }
@@ -1766,16 +1774,16 @@ int32_t AACFlushCodec()
  * Return:      none
 
  **********************************************************************************************************************/
-void AACDecoder_FreeBuffers(void) {
+void AACDecoder_FreeBuffers(AACDecoder_t* dec) {
 
 //    uint32_t i = ESP.getFreeHeap();
 
-    if(m_AACDecInfo)                         {free(m_AACDecInfo);    m_AACDecInfo=NULL;}
-    if(m_PSInfoBase)                         {free(m_PSInfoBase);    m_PSInfoBase=NULL;}
-    if(m_pce[0])                             {free(m_pce[0]);        m_pce[0]=NULL;}
+    if(dec->aacDecInfo)                         {CodecArena_Free(dec->aacDecInfo);    dec->aacDecInfo=NULL;}
+    if(dec->psInfoBase)                         {CodecArena_Free(dec->psInfoBase);    dec->psInfoBase=NULL;}
+    if(dec->pce[0])                             {CodecArena_Free(dec->pce[0]);        dec->pce[0]=NULL;}
 
 #ifdef AAC_ENABLE_SBR
-    if(m_PSInfoSBR)                           {free(m_PSInfoSBR);    m_PSInfoSBR=NULL;}               //Clear AACDecInfo
+    if(dec->psInfoSBR)                           {CodecArena_Free(dec->psInfoSBR);    dec->psInfoSBR=NULL;}               //Clear AACDecInfo
 #endif
 
 //    log_i("AACDecoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
@@ -1793,8 +1801,8 @@ void AACDecoder_FreeBuffers(void) {
  * Return:      true if buffers allocated, otherwise false
 
  **********************************************************************************************************************/
-bool AACDecoder_IsInit(void) {
-    if(m_AACDecInfo && m_PSInfoBase && m_pce[0]){
+bool AACDecoder_IsInit(AACDecoder_t* dec) {
+    if(dec->aacDecInfo && dec->psInfoBase && dec->pce[0]){
         return true;
     }
     return false;
@@ -1825,30 +1833,50 @@ bool AACDecoder_IsInit(void) {
  *
  * Return:      offset to first sync word (bytes from start of buf)
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       memchr() scans a word at a time for the first byte of the sync word. A candidate needs a
+ *              valid ADTS header (layer 0, sampling rate index, frame length), if the next frame header
+ *              lies inside buf it must be an ADTS header with the same sampling rate index
  **********************************************************************************************************************/
 int32_t AACFindSyncWord(uint8_t *buf, int32_t nBytes)
 {
-    int32_t i;
+    const uint8_t adtsHsize = 6; // bytes needed for the frame length
+    uint8_t* end = buf + nBytes;
+    uint8_t* p = buf;
+
+    auto headerOk = [&](uint8_t* h) { // lambda, inner function
+        if ((h[0] & SYNCWORDH) != SYNCWORDH || (h[1] & SYNCWORDL) != SYNCWORDL) return false;
+        if ((h[1] & 0x06) != 0) return false;             // layer must be 0
+        if (((h[2] >> 2) & 0x0f) >= NUM_SAMPLE_RATES) return false;
+        return true;
+    };
 
     /* find byte-aligned syncword (12 bits = 0xFFF) */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ( (buf[i+0] & SYNCWORDH) == SYNCWORDH && (buf[i+1] & SYNCWORDL) == SYNCWORDL )
-            return i;
+    while (end - p >= adtsHsize) {
+        p = (uint8_t*)memchr(p, SYNCWORDH, end - p - (adtsHsize - 1));
+        if (!p) return -1;
+        if (!headerOk(p)) {p++; continue;}
+        int32_t frameLen = ((p[3] & 0x03) << 11) | (p[4] << 3) | (p[5] >> 5);
+        if (frameLen < 7) {p++; continue;}
+        uint8_t* n = p + frameLen;
+        if (n + adtsHsize <= end) {
+            if (!headerOk(n) || ((n[2] >> 2) & 0x0f) != ((p[2] >> 2) & 0x0f)) {p++; continue;}
+        }
+        return p - buf;
     }
-
     return -1;
 }
 //**************************************************************************************
-int32_t AACGetSampRate(){return m_AACDecInfo->sampRate * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
-int32_t AACGetChannels(){return m_AACDecInfo->nChans;}
+int32_t AACGetSampRate(AACDecoder_t* dec){return dec->aacDecInfo->sampRate * (dec->aacDecInfo->sbrEnabled ? 2 : 1);}
+int32_t AACGetChannels(AACDecoder_t* dec){return dec->aacDecInfo->nChans;}
 int32_t AACGetBitsPerSample(){return 16;}
-int32_t AACGetID() {return m_AACDecInfo->id;} // 0-MPEG4, 1-MPEG2
-uint8_t AACGetProfile() {return (uint8_t)m_AACDecInfo->profile;} // 0-Main, 1-LC, 2-SSR, 3-reserved
-uint8_t AACGetFormat() {return (uint8_t)m_AACDecInfo->format;}   // 0-unknown 1-ADTS 2-ADIF, 3-RAW
-int32_t AACGetOutputSamps(){return m_AACDecInfo->nChans * AAC_MAX_NSAMPS  * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
-int32_t AACGetBitrate() {
-    uint32_t br = AACGetBitsPerSample() * AACGetChannels() *  AACGetSampRate();
-    return (br / m_AACDecInfo->compressionRatio);
+int32_t AACGetID(AACDecoder_t* dec) {return dec->aacDecInfo->id;} // 0-MPEG4, 1-MPEG2
+uint8_t AACGetProfile(AACDecoder_t* dec) {return (uint8_t)dec->aacDecInfo->profile;} // 0-Main, 1-LC, 2-SSR, 3-reserved
+uint8_t AACGetFormat(AACDecoder_t* dec) {return (uint8_t)dec->aacDecInfo->format;}   // 0-unknown 1-ADTS 2-ADIF, 3-RAW
+int32_t AACGetOutputSamps(AACDecoder_t* dec){return dec->aacDecInfo->nChans * AAC_MAX_NSAMPS  * (dec->aacDecInfo->sbrEnabled ? 2 : 1);}
+int32_t AACGetBitrate(AACDecoder_t* dec) {
+    uint32_t br = AACGetBitsPerSample() * AACGetChannels(dec) *  AACGetSampRate(dec);
+    return (br / dec->aacDecInfo->compressionRatio);
 }
 /**************************************************************************************
  * Function:    AACSetRawBlockParams
@@ -1870,16 +1898,16 @@ int32_t AACGetBitrate() {
  *                aacFrameInfo to configure its internal state (useful when the
  *                source is MP4 format, for example)
  **************************************************************************************/
-int32_t AACSetRawBlockParams(int32_t copyLast, int32_t nChans, int32_t sampRateCore, int32_t profile)
+int32_t AACSetRawBlockParams(AACDecoder_t* dec, int32_t copyLast, int32_t nChans, int32_t sampRateCore, int32_t profile)
 {
-    if (!m_AACDecInfo)
+    if (!dec->aacDecInfo)
         return ERR_AAC_NULL_POINTER;
 
-    m_AACDecInfo->format = AAC_FF_RAW;
+    dec->aacDecInfo->format = AAC_FF_RAW;
     if (copyLast)
-        return SetRawBlockParams(1, 0, 0, 0);
+        return SetRawBlockParams(dec, 1, 0, 0, 0);
     else
-        return SetRawBlockParams(0, nChans, sampRateCore, profile);
+        return SetRawBlockParams(dec, 0, nChans, sampRateCore, profile);
 }
 
 /***********************************************************************************************************************
@@ -1902,10 +1930,11 @@ int32_t AACSetRawBlockParams(int32_t copyLast, int32_t nChans, int32_t sampRateC
  *                successfully decoded, so if ERR_AAC_INDATA_UNDERFLOW is returned
  *                just call AACDecode again with more data in inbuf
  **********************************************************************************************************************/
-int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
+int32_t AACDecode(AACDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
 {
     int32_t err, offset, bitOffset, bitsAvail;
     int32_t ch, baseChan, elementChans;
+    int32_t blocksLeft = 0;
     uint8_t *inptr;
 
 #ifdef AAC_ENABLE_SBR
@@ -1918,56 +1947,58 @@ int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
     bitsAvail = (*bytesLeft) << 3;
 
     /* first time through figure out what the file format is */
-    if (m_AACDecInfo->format == AAC_FF_Unknown) {
+    if (dec->aacDecInfo->format == AAC_FF_Unknown) {
         if (bitsAvail < 32)
             return ERR_AAC_INDATA_UNDERFLOW;
 
         if ((inptr)[0] == 'A' && (inptr)[1] == 'D' && (inptr)[2] == 'I' && (inptr)[3] == 'F') {
             /* unpack ADIF header */
-            m_AACDecInfo->format = AAC_FF_ADIF;
-            err = UnpackADIFHeader(&inptr, &bitOffset, &bitsAvail);
+            dec->aacDecInfo->format = AAC_FF_ADIF;
+            err = UnpackADIFHeader(dec, &inptr, &bitOffset, &bitsAvail);
             if (err)
                 return err;
         } else {
             /* assume ADTS by default */
-            m_AACDecInfo->format = AAC_FF_ADTS;
+            dec->aacDecInfo->format = AAC_FF_ADTS;
         }
     }
     /* if ADTS, search for start of next frame */
-    if (m_AACDecInfo->format == AAC_FF_ADTS) {
+    if (dec->aacDecInfo->format == AAC_FF_ADTS) {
         /* can have 1-4 raw data blocks per ADTS frame (header only present for first one) */
-        if (m_AACDecInfo->adtsBlocksLeft == 0) {
+        if (dec->aacDecInfo->adtsBlocksLeft == 0) {
             offset = AACFindSyncWord(inptr, bitsAvail >> 3);
             if (offset < 0)
                 return ERR_AAC_INDATA_UNDERFLOW;
             inptr += offset;
             bitsAvail -= (offset << 3);
 
-            err = UnpackADTSHeader(&inptr, &bitOffset, &bitsAvail);
+            err = UnpackADTSHeader(dec, &inptr, &bitOffset, &bitsAvail);
             if (err)
                 return err;
 
-            if (m_AACDecInfo->nChans == -1) {
+            if (dec->aacDecInfo->nChans == -1) {
                 /* figure out implicit channel mapping if necessary */
-                err = GetADTSChannelMapping(inptr, bitOffset, bitsAvail);
+                err = GetADTSChannelMapping(dec, inptr, bitOffset, bitsAvail);
                 if (err)
                     return err;
             }
         }
-        m_AACDecInfo->adtsBlocksLeft--;
-    } else if (m_AACDecInfo->format == AAC_FF_RAW) {
-        err = PrepareRawBlock();
+        /* the further raw data blocks of a frame that fails are dropped, the next call starts with a header again */
+        blocksLeft = dec->aacDecInfo->adtsBlocksLeft - 1;
+        dec->aacDecInfo->adtsBlocksLeft = 0;
+    } else if (dec->aacDecInfo->format == AAC_FF_RAW) {
+        err = PrepareRawBlock(dec);
         if (err)
             return err;
     }
 
     /* check for valid number of channels */
-    if (m_AACDecInfo->nChans > AAC_MAX_NCHANS || m_AACDecInfo->nChans <= 0)
+    if (dec->aacDecInfo->nChans > AAC_MAX_NCHANS || dec->aacDecInfo->nChans <= 0)
         return ERR_AAC_NCHANS_TOO_HIGH;
 
     /* will be set later if active in this frame */
-    m_AACDecInfo->tnsUsed = 0;
-    m_AACDecInfo->pnsUsed = 0;
+    dec->aacDecInfo->tnsUsed = 0;
+    dec->aacDecInfo->pnsUsed = 0;
 
     bitOffset = 0;
     baseChan = 0;
@@ -1979,59 +2010,59 @@ int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
     do {
         /* parse next syntactic element */
         if(bitsAvail < 0) return ERR_AAC_INDATA_UNDERFLOW;
-        err = DecodeNextElement(&inptr, &bitOffset, &bitsAvail);
+        err = DecodeNextElement(dec, &inptr, &bitOffset, &bitsAvail);
         if (err)
             return err;
 
-        elementChans = elementNumChans[m_AACDecInfo->currBlockID];
+        elementChans = elementNumChans[dec->aacDecInfo->currBlockID];
         if (baseChan + elementChans > AAC_MAX_NCHANS)
             return ERR_AAC_NCHANS_TOO_HIGH;
 
         /* noiseless decoder and dequantizer */
         for (ch = 0; ch < elementChans; ch++) {
-            err = DecodeNoiselessData(&inptr, &bitOffset, &bitsAvail, ch);
+            err = DecodeNoiselessData(dec, &inptr, &bitOffset, &bitsAvail, ch);
 
             if (err)
                 return err;
 
-            if (AACDequantize(ch))
+            if (AACDequantize(dec, ch))
                 return ERR_AAC_DEQUANT;
         }
 
         /* mid-side and intensity stereo */
-        if (m_AACDecInfo->currBlockID == AAC_ID_CPE) {
-            if (StereoProcess())
+        if (dec->aacDecInfo->currBlockID == AAC_ID_CPE) {
+            if (StereoProcess(dec))
                 return ERR_AAC_STEREO_PROCESS;
         }
 
         /* PNS, TNS, inverse transform */
         for (ch = 0; ch < elementChans; ch++) {
 
-            if (PNS(ch))
+            if (PNS(dec, ch))
                 return ERR_AAC_PNS;
 
-            if (m_AACDecInfo->sbDeinterleaveReqd[ch]) {
+            if (dec->aacDecInfo->sbDeinterleaveReqd[ch]) {
                 /* deinterleave short blocks, if required */
                 if (DeinterleaveShortBlocks(ch))
                     return ERR_AAC_SHORT_BLOCK_DEINT;
-                m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
+                dec->aacDecInfo->sbDeinterleaveReqd[ch] = 0;
             }
 
-            if (TNSFilter(ch))
+            if (TNSFilter(dec, ch))
                 return ERR_AAC_TNS;
 
-            if (IMDCT(ch, baseChan + ch, outbuf))
+            if (IMDCT(dec, ch, baseChan + ch, outbuf))
                 return ERR_AAC_IMDCT;
         }
 
 #ifdef AAC_ENABLE_SBR
-        if (m_AACDecInfo->sbrEnabled && (m_AACDecInfo->currBlockID == AAC_ID_FIL ||
-                                         m_AACDecInfo->currBlockID == AAC_ID_LFE)) {
-            if (m_AACDecInfo->currBlockID == AAC_ID_LFE)
+        if (dec->aacDecInfo->sbrEnabled && (dec->aacDecInfo->currBlockID == AAC_ID_FIL ||
+                                         dec->aacDecInfo->currBlockID == AAC_ID_LFE)) {
+            if (dec->aacDecInfo->currBlockID == AAC_ID_LFE)
                 elementChansSBR = elementNumChans[AAC_ID_LFE];
-            else if (m_AACDecInfo->currBlockID == AAC_ID_FIL && (m_AACDecInfo->prevBlockID == AAC_ID_SCE ||
-                                                                 m_AACDecInfo->prevBlockID == AAC_ID_CPE))
-                elementChansSBR = elementNumChans[m_AACDecInfo->prevBlockID];
+            else if (dec->aacDecInfo->currBlockID == AAC_ID_FIL && (dec->aacDecInfo->prevBlockID == AAC_ID_SCE ||
+                                                                 dec->aacDecInfo->prevBlockID == AAC_ID_CPE))
+                elementChansSBR = elementNumChans[dec->aacDecInfo->prevBlockID];
             else
                 elementChansSBR = 0;
 
@@ -2039,11 +2070,11 @@ int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
                 return ERR_AAC_SBR_NCHANS_TOO_HIGH;
 
             /* parse SBR extension data if present (contained in a fill element) */
-            if (DecodeSBRBitstream(baseChanSBR))
+            if (DecodeSBRBitstream(dec, baseChanSBR))
                 return ERR_AAC_SBR_BITSTREAM;
 
             /* apply SBR */
-            if (DecodeSBRData(baseChanSBR, outbuf))
+            if (DecodeSBRData(dec, baseChanSBR, outbuf))
                 return ERR_AAC_SBR_DATA;
 
             baseChanSBR += elementChansSBR;
@@ -2051,7 +2082,7 @@ int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
 #endif
 
     baseChan += elementChans;
-    } while (m_AACDecInfo->currBlockID != AAC_ID_END);
+    } while (dec->aacDecInfo->currBlockID != AAC_ID_END);
 
     /* byte align after each raw_data_block */
     if (bitOffset) {
@@ -2062,10 +2093,12 @@ int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf)
             return ERR_AAC_INDATA_UNDERFLOW;
     }
 
-    m_AACDecInfo->compressionRatio = (float)(AACGetOutputSamps()) * 2 / (inptr - inbuf);
+    dec->aacDecInfo->compressionRatio = (float)(AACGetOutputSamps(dec)) * 2 / (inptr - inbuf);
 
     /* update pointers */
-    m_AACDecInfo->frameCount++;
+    if (dec->aacDecInfo->format == AAC_FF_ADTS)
+        dec->aacDecInfo->adtsBlocksLeft = blocksLeft;
+    dec->aacDecInfo->frameCount++;
     *bytesLeft -= (inptr - inbuf);
     inbuf = inptr;
 
@@ -2185,7 +2218,7 @@ int32_t FilterRegion(int32_t size, int32_t dir, int32_t order, int32_t *audioCoe
  *
  * Return:      0 if successful, -1 if error
  **********************************************************************************************************************/
-int32_t TNSFilter(int32_t ch)
+int32_t TNSFilter(AACDecoder_t* dec, int32_t ch)
 {
     int32_t win, winLen, nWindows, nSFB, filt, bottom, top, order, maxOrder, dir;
     int32_t start, end, size, tnsMaxBand, numFilt, gbMask;
@@ -2197,8 +2230,8 @@ int32_t TNSFilter(int32_t ch)
     ICSInfo_t *icsInfo;
     TNSInfo_t *ti;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
-    ti = &m_PSInfoBase->tnsInfo[ch];
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
+    ti = &dec->psInfoBase->tnsInfo[ch];
 
     if (!ti->tnsDataPresent)
         return 0;
@@ -2206,19 +2239,19 @@ int32_t TNSFilter(int32_t ch)
     if (icsInfo->winSequence == 2) {
         nWindows = NWINDOWS_SHORT;
         winLen = NSAMPS_SHORT;
-        nSFB = sfBandTotalShort[m_PSInfoBase->sampRateIdx];
-        maxOrder = tnsMaxOrderShort[m_AACDecInfo->profile];
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
-        tnsMaxBandTab = tnsMaxBandsShort + tnsMaxBandsShortOffset[m_AACDecInfo->profile];
-        tnsMaxBand = tnsMaxBandTab[m_PSInfoBase->sampRateIdx];
+        nSFB = sfBandTotalShort[dec->psInfoBase->sampRateIdx];
+        maxOrder = tnsMaxOrderShort[dec->aacDecInfo->profile];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[dec->psInfoBase->sampRateIdx];
+        tnsMaxBandTab = tnsMaxBandsShort + tnsMaxBandsShortOffset[dec->aacDecInfo->profile];
+        tnsMaxBand = tnsMaxBandTab[dec->psInfoBase->sampRateIdx];
     } else {
         nWindows = NWINDOWS_LONG;
         winLen = NSAMPS_LONG;
-        nSFB = sfBandTotalLong[m_PSInfoBase->sampRateIdx];
-        maxOrder = tnsMaxOrderLong[m_AACDecInfo->profile];
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
-        tnsMaxBandTab = tnsMaxBandsLong + tnsMaxBandsLongOffset[m_AACDecInfo->profile];
-        tnsMaxBand = tnsMaxBandTab[m_PSInfoBase->sampRateIdx];
+        nSFB = sfBandTotalLong[dec->psInfoBase->sampRateIdx];
+        maxOrder = tnsMaxOrderLong[dec->aacDecInfo->profile];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[dec->psInfoBase->sampRateIdx];
+        tnsMaxBandTab = tnsMaxBandsLong + tnsMaxBandsLongOffset[dec->aacDecInfo->profile];
+        tnsMaxBand = tnsMaxBandTab[dec->psInfoBase->sampRateIdx];
     }
 
     if (tnsMaxBand > icsInfo->maxSFB)
@@ -2231,7 +2264,7 @@ int32_t TNSFilter(int32_t ch)
     filtCoef =   ti->coef;
 
     gbMask = 0;
-    audioCoef =  m_PSInfoBase->coef[ch];
+    audioCoef =  dec->psInfoBase->coef[ch];
     for (win = 0; win < nWindows; win++) {
         bottom = nSFB;
         numFilt = ti->numFilt[win];
@@ -2251,9 +2284,9 @@ int32_t TNSFilter(int32_t ch)
                     if (dir)
                         start = end - 1;
 
-                    DecodeLPCCoefs(order, filtRes[win], filtCoef, m_PSInfoBase->tnsLPCBuf, m_PSInfoBase->tnsWorkBuf);
-                    gbMask |= FilterRegion(size, dir, order, audioCoef + start, m_PSInfoBase->tnsLPCBuf,
-                                                                                           m_PSInfoBase->tnsWorkBuf);
+                    DecodeLPCCoefs(order, filtRes[win], filtCoef, dec->psInfoBase->tnsLPCBuf, dec->psInfoBase->tnsWorkBuf);
+                    gbMask |= FilterRegion(size, dir, order, audioCoef + start, dec->psInfoBase->tnsLPCBuf,
+                                                                                           dec->psInfoBase->tnsWorkBuf);
                 }
                 filtCoef += order;
             }
@@ -2263,8 +2296,8 @@ int32_t TNSFilter(int32_t ch)
 
     /* update guard bit count if necessary */
     size = CLZ(gbMask) - 1;
-    if (m_PSInfoBase->gbCurrent[ch] > size)
-        m_PSInfoBase->gbCurrent[ch] = size;
+    if (dec->psInfoBase->gbCurrent[ch] > size)
+        dec->psInfoBase->gbCurrent[ch] = size;
 
     return 0;
 }
@@ -2282,10 +2315,10 @@ int32_t TNSFilter(int32_t ch)
  *
  * Notes:       doesn't decode individual channel stream (part of DecodeNoiselessData)
  **********************************************************************************************************************/
-int32_t DecodeSingleChannelElement()
+int32_t DecodeSingleChannelElement(AACDecoder_t* dec)
 {
     /* read instance tag */
-    m_AACDecInfo->currInstTag = GetBits(NUM_INST_TAG_BITS);
+    dec->aacDecInfo->currInstTag = GetBits(dec, NUM_INST_TAG_BITS);
 
     return 0;
 }
@@ -2306,37 +2339,37 @@ int32_t DecodeSingleChannelElement()
  *
  * Notes:       doesn't decode individual channel stream (part of DecodeNoiselessData)
  **********************************************************************************************************************/
-int32_t DecodeChannelPairElement()
+int32_t DecodeChannelPairElement(AACDecoder_t* dec)
 {
     int32_t sfb, gp, maskOffset;
     uint8_t currBit, *maskPtr;
     ICSInfo_t *icsInfo;
 
 
-    icsInfo = m_PSInfoBase->icsInfo;
+    icsInfo = dec->psInfoBase->icsInfo;
 
     /* read instance tag */
-    m_AACDecInfo->currInstTag = GetBits(NUM_INST_TAG_BITS);
+    dec->aacDecInfo->currInstTag = GetBits(dec, NUM_INST_TAG_BITS);
 
     /* read common window flag and mid-side info (if present)
-     * store msMask bits in m_PSInfoBase->msMaskBits[] as follows:
+     * store msMask bits in dec->psInfoBase->msMaskBits[] as follows:
      *  long blocks -  pack bits for each SFB in range [0, maxSFB) starting with lsb of msMaskBits[0]
      *  short blocks - pack bits for each SFB in range [0, maxSFB), for each group [0, 7]
      * msMaskPresent = 0 means no M/S coding
-     *               = 1 means m_PSInfoBase->msMaskBits contains 1 bit per SFB to toggle M/S coding
-     *               = 2 means all SFB's are M/S coded (so m_PSInfoBase->msMaskBits is not needed)
+     *               = 1 means dec->psInfoBase->msMaskBits contains 1 bit per SFB to toggle M/S coding
+     *               = 2 means all SFB's are M/S coded (so dec->psInfoBase->msMaskBits is not needed)
      */
-    m_PSInfoBase->commonWin = GetBits(1);
-    if (m_PSInfoBase->commonWin) {
-        DecodeICSInfo(icsInfo, m_PSInfoBase->sampRateIdx);
-        m_PSInfoBase->msMaskPresent = GetBits(2);
-        if (m_PSInfoBase->msMaskPresent == 1) {
-            maskPtr = m_PSInfoBase->msMaskBits;
+    dec->psInfoBase->commonWin = GetBits(dec, 1);
+    if (dec->psInfoBase->commonWin) {
+        DecodeICSInfo(dec, icsInfo, dec->psInfoBase->sampRateIdx);
+        dec->psInfoBase->msMaskPresent = GetBits(dec, 2);
+        if (dec->psInfoBase->msMaskPresent == 1) {
+            maskPtr = dec->psInfoBase->msMaskBits;
             *maskPtr = 0;
             maskOffset = 0;
             for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
                 for (sfb = 0; sfb < icsInfo->maxSFB; sfb++) {
-                    currBit = (uint8_t)GetBits(1);
+                    currBit = (uint8_t)GetBits(dec, 1);
                     *maskPtr |= currBit << maskOffset;
                     if (++maskOffset == 8) {
                         maskPtr++;
@@ -2364,10 +2397,10 @@ int32_t DecodeChannelPairElement()
  *
  * Notes:       doesn't decode individual channel stream (part of DecodeNoiselessData)
  **********************************************************************************************************************/
-int32_t DecodeLFEChannelElement()
+int32_t DecodeLFEChannelElement(AACDecoder_t* dec)
 {
     /* read instance tag */
-    m_AACDecInfo->currInstTag = GetBits( NUM_INST_TAG_BITS);
+    dec->aacDecInfo->currInstTag = GetBits(dec,  NUM_INST_TAG_BITS);
 
     return 0;
 }
@@ -2384,24 +2417,24 @@ int32_t DecodeLFEChannelElement()
  *
  * Return:      0 if successful, -1 if error
  **********************************************************************************************************************/
-int32_t DecodeDataStreamElement()
+int32_t DecodeDataStreamElement(AACDecoder_t* dec)
 {
     uint32_t byteAlign, dataCount;
     uint8_t *dataBuf;
 
-    m_AACDecInfo->currInstTag = GetBits( NUM_INST_TAG_BITS);
-    byteAlign = GetBits(1);
-    dataCount = GetBits(8);
+    dec->aacDecInfo->currInstTag = GetBits(dec,  NUM_INST_TAG_BITS);
+    byteAlign = GetBits(dec, 1);
+    dataCount = GetBits(dec, 8);
     if (dataCount == 255)
-        dataCount += GetBits(8);
+        dataCount += GetBits(dec, 8);
 
     if (byteAlign)
-        ByteAlignBitstream();
+        ByteAlignBitstream(dec);
 
-    m_PSInfoBase->dataCount = dataCount;
-    dataBuf = m_PSInfoBase->dataBuf;
+    dec->psInfoBase->dataCount = dataCount;
+    dataBuf = dec->psInfoBase->dataBuf;
     while (dataCount--)
-        *dataBuf++ = GetBits(8);
+        *dataBuf++ = GetBits(dec, 8);
 
     return 0;
 }
@@ -2421,65 +2454,65 @@ int32_t DecodeDataStreamElement()
  * Notes:       #define KEEP_PCE_COMMENTS to save the comment field of the PCE
  *                (otherwise we just skip it in the bitstream, to save memory)
  **********************************************************************************************************************/
-int32_t DecodeProgramConfigElement(uint8_t idx)
+int32_t DecodeProgramConfigElement(AACDecoder_t* dec, uint8_t idx)
 {
     int32_t i;
 
-    m_pce[idx]->elemInstTag =   GetBits(4);
-    m_pce[idx]->profile =       GetBits(2);
-    m_pce[idx]->sampRateIdx =   GetBits(4);
-    m_pce[idx]->numFCE =        GetBits(4);
-    m_pce[idx]->numSCE =        GetBits(4);
-    m_pce[idx]->numBCE =        GetBits(4);
-    m_pce[idx]->numLCE =        GetBits(2);
-    m_pce[idx]->numADE =        GetBits(3);
-    m_pce[idx]->numCCE =        GetBits(4);
+    dec->pce[idx]->elemInstTag =   GetBits(dec, 4);
+    dec->pce[idx]->profile =       GetBits(dec, 2);
+    dec->pce[idx]->sampRateIdx =   GetBits(dec, 4);
+    dec->pce[idx]->numFCE =        GetBits(dec, 4);
+    dec->pce[idx]->numSCE =        GetBits(dec, 4);
+    dec->pce[idx]->numBCE =        GetBits(dec, 4);
+    dec->pce[idx]->numLCE =        GetBits(dec, 2);
+    dec->pce[idx]->numADE =        GetBits(dec, 3);
+    dec->pce[idx]->numCCE =        GetBits(dec, 4);
 
-    m_pce[idx]->monoMixdown = GetBits(1) << 4;    /* present flag */
-    if (m_pce[idx]->monoMixdown)
-        m_pce[idx]->monoMixdown |= GetBits(4);    /* element number */
+    dec->pce[idx]->monoMixdown = GetBits(dec, 1) << 4;    /* present flag */
+    if (dec->pce[idx]->monoMixdown)
+        dec->pce[idx]->monoMixdown |= GetBits(dec, 4);    /* element number */
 
-    m_pce[idx]->stereoMixdown = GetBits(1) << 4;    /* present flag */
-    if (m_pce[idx]->stereoMixdown)
-        m_pce[idx]->stereoMixdown  |= GetBits(4);    /* element number */
+    dec->pce[idx]->stereoMixdown = GetBits(dec, 1) << 4;    /* present flag */
+    if (dec->pce[idx]->stereoMixdown)
+        dec->pce[idx]->stereoMixdown  |= GetBits(dec, 4);    /* element number */
 
-    m_pce[idx]->matrixMixdown = GetBits(1) << 4;    /* present flag */
-    if (m_pce[idx]->matrixMixdown) {
-        m_pce[idx]->matrixMixdown  |= GetBits(2) << 1;    /* index */
-        m_pce[idx]->matrixMixdown  |= GetBits(1);            /* pseudo-surround enable */
+    dec->pce[idx]->matrixMixdown = GetBits(dec, 1) << 4;    /* present flag */
+    if (dec->pce[idx]->matrixMixdown) {
+        dec->pce[idx]->matrixMixdown  |= GetBits(dec, 2) << 1;    /* index */
+        dec->pce[idx]->matrixMixdown  |= GetBits(dec, 1);            /* pseudo-surround enable */
     }
 
-    for (i = 0; i < m_pce[idx]->numFCE; i++) {
-        m_pce[idx]->fce[i]  = GetBits(1) << 4;    /* is_cpe flag */
-        m_pce[idx]->fce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < dec->pce[idx]->numFCE; i++) {
+        dec->pce[idx]->fce[i]  = GetBits(dec, 1) << 4;    /* is_cpe flag */
+        dec->pce[idx]->fce[i] |= GetBits(dec, 4);            /* tag select */
     }
 
-    for (i = 0; i < m_pce[idx]->numSCE; i++) {
-        m_pce[idx]->sce[i]  = GetBits(1) << 4;    /* is_cpe flag */
-        m_pce[idx]->sce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < dec->pce[idx]->numSCE; i++) {
+        dec->pce[idx]->sce[i]  = GetBits(dec, 1) << 4;    /* is_cpe flag */
+        dec->pce[idx]->sce[i] |= GetBits(dec, 4);            /* tag select */
     }
 
-    for (i = 0; i < m_pce[idx]->numBCE; i++) {
-        m_pce[idx]->bce[i]  = GetBits(1) << 4;    /* is_cpe flag */
-        m_pce[idx]->bce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < dec->pce[idx]->numBCE; i++) {
+        dec->pce[idx]->bce[i]  = GetBits(dec, 1) << 4;    /* is_cpe flag */
+        dec->pce[idx]->bce[i] |= GetBits(dec, 4);            /* tag select */
     }
 
-    for (i = 0; i < m_pce[idx]->numLCE; i++)
-        m_pce[idx]->lce[i] = GetBits(4);            /* tag select */
+    for (i = 0; i < dec->pce[idx]->numLCE; i++)
+        dec->pce[idx]->lce[i] = GetBits(dec, 4);            /* tag select */
 
-    for (i = 0; i < m_pce[idx]->numADE; i++)
-        m_pce[idx]->ade[i] = GetBits(4);            /* tag select */
+    for (i = 0; i < dec->pce[idx]->numADE; i++)
+        dec->pce[idx]->ade[i] = GetBits(dec, 4);            /* tag select */
 
-    for (i = 0; i < m_pce[idx]->numCCE; i++) {
-        m_pce[idx]->cce[i]  = GetBits(1) << 4;    /* independent/dependent flag */
-        m_pce[idx]->cce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < dec->pce[idx]->numCCE; i++) {
+        dec->pce[idx]->cce[i]  = GetBits(dec, 1) << 4;    /* independent/dependent flag */
+        dec->pce[idx]->cce[i] |= GetBits(dec, 4);            /* tag select */
     }
 
-    ByteAlignBitstream();
+    ByteAlignBitstream(dec);
     /* eat comment bytes and throw away */
-    i = GetBits(8);
+    i = GetBits(dec, 8);
     while (i--)
-        GetBits(8);
+        GetBits(dec, 8);
 
     return 0;
 }
@@ -2497,22 +2530,22 @@ int32_t DecodeProgramConfigElement(uint8_t idx)
  *
  * Return:      0 if successful, -1 if error
  **********************************************************************************************************************/
-int32_t DecodeFillElement()
+int32_t DecodeFillElement(AACDecoder_t* dec)
 {
     uint32_t fillCount;
     uint8_t *fillBuf;
 
-    fillCount = GetBits(4);
+    fillCount = GetBits(dec, 4);
     if (fillCount == 15)
-        fillCount += (GetBits(8) - 1);
+        fillCount += (GetBits(dec, 8) - 1);
 
-    m_PSInfoBase->fillCount = fillCount;
-    fillBuf = m_PSInfoBase->fillBuf;
+    dec->psInfoBase->fillCount = fillCount;
+    fillBuf = dec->psInfoBase->fillBuf;
     while (fillCount--)
-        *fillBuf++ = GetBits(8);
+        *fillBuf++ = GetBits(dec, 8);
 
-    m_AACDecInfo->currInstTag = -1;    /* fill elements don't have instance tag */
-    m_AACDecInfo->fillExtType = 0;
+    dec->aacDecInfo->currInstTag = -1;    /* fill elements don't have instance tag */
+    dec->aacDecInfo->fillExtType = 0;
 
 #ifdef AAC_ENABLE_SBR
     /* check for SBR
@@ -2520,16 +2553,16 @@ int32_t DecodeFillElement()
      *    need to verify that all SCE/CPE/ICCE have valid SBR fill element following, and
      *    must upsample by 2 for LFE
      */
-    if (m_PSInfoBase->fillCount > 0) {
-        m_AACDecInfo->fillExtType = (int32_t)((m_PSInfoBase->fillBuf[0] >> 4) & 0x0f);
-        if (m_AACDecInfo->fillExtType == EXT_SBR_DATA || m_AACDecInfo->fillExtType == EXT_SBR_DATA_CRC)
-            m_AACDecInfo->sbrEnabled = 1;
+    if (dec->psInfoBase->fillCount > 0) {
+        dec->aacDecInfo->fillExtType = (int32_t)((dec->psInfoBase->fillBuf[0] >> 4) & 0x0f);
+        if (dec->aacDecInfo->fillExtType == EXT_SBR_DATA || dec->aacDecInfo->fillExtType == EXT_SBR_DATA_CRC)
+            dec->aacDecInfo->sbrEnabled = 1;
     }
 #endif
 
 
-    m_AACDecInfo->fillBuf = m_PSInfoBase->fillBuf;
-    m_AACDecInfo->fillCount = m_PSInfoBase->fillCount;
+    dec->aacDecInfo->fillBuf = dec->psInfoBase->fillBuf;
+    dec->aacDecInfo->fillCount = dec->psInfoBase->fillCount;
 
     return 0;
 }
@@ -2552,41 +2585,41 @@ int32_t DecodeFillElement()
  *
  * Return:      0 if successful, error code (< 0) if error
  **********************************************************************************************************************/
-int32_t DecodeNextElement(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
+int32_t DecodeNextElement(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
 {
     int32_t err, bitsUsed;
 
     /* init bitstream reader */
-    SetBitstreamPointer((*bitsAvail + 7) >> 3, *buf);
-    GetBits(*bitOffset);
+    SetBitstreamPointer(dec, (*bitsAvail + 7) >> 3, *buf);
+    GetBits(dec, *bitOffset);
 
-    m_AACDecInfo->prevBlockID = m_AACDecInfo->currBlockID;
-    m_AACDecInfo->currBlockID = GetBits(NUM_SYN_ID_BITS);
+    dec->aacDecInfo->prevBlockID = dec->aacDecInfo->currBlockID;
+    dec->aacDecInfo->currBlockID = GetBits(dec, NUM_SYN_ID_BITS);
 
     /* set defaults (could be overwritten by DecodeXXXElement(), depending on currBlockID) */
-    m_PSInfoBase->commonWin = 0;
+    dec->psInfoBase->commonWin = 0;
 
     err = 0;
-    switch (m_AACDecInfo->currBlockID) {
+    switch (dec->aacDecInfo->currBlockID) {
     case AAC_ID_SCE:
-        err = DecodeSingleChannelElement();
+        err = DecodeSingleChannelElement(dec);
         break;
     case AAC_ID_CPE:
-        err = DecodeChannelPairElement();
+        err = DecodeChannelPairElement(dec);
         break;
     case AAC_ID_CCE:
         break;
     case AAC_ID_LFE:
-        err = DecodeLFEChannelElement();
+        err = DecodeLFEChannelElement(dec);
         break;
     case AAC_ID_DSE:
-        err = DecodeDataStreamElement();
+        err = DecodeDataStreamElement(dec);
         break;
     case AAC_ID_PCE:
-        err = DecodeProgramConfigElement(0);
+        err = DecodeProgramConfigElement(dec, 0);
         break;
     case AAC_ID_FIL:
-        err = DecodeFillElement();
+        err = DecodeFillElement(dec);
         break;
     case AAC_ID_END:
         break;
@@ -2595,7 +2628,7 @@ int32_t DecodeNextElement(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
         return ERR_AAC_SYNTAX_ELEMENT;
 
     /* update bitstream reader */
-    bitsUsed = CalcBitsUsed(*buf, *bitOffset);
+    bitsUsed = CalcBitsUsed(dec, *buf, *bitOffset);
     *buf += (bitsUsed + *bitOffset) >> 3;
     *bitOffset = (bitsUsed + *bitOffset) & 0x07;
     *bitsAvail -= bitsUsed;
@@ -2905,7 +2938,7 @@ void DCT4(int32_t tabidx, int32_t *coef, int32_t gb)
  *
  * Return:      none
  **********************************************************************************************************************/
-void BitReverse(int32_t *inout, int32_t tabidx)
+CODEC_HOT_FUNC void BitReverse(int32_t *inout, int32_t tabidx)
 {
     int32_t *part0, *part1;
     int32_t a,b, t;
@@ -3000,7 +3033,7 @@ void R4FirstPass(int32_t *x, int32_t bg)
  *                or guard bits in - 2 (if inputs bounded to +/- sqrt(2)/2)
  *              see scaling comments in code
  **********************************************************************************************************************/
-void R8FirstPass(int32_t *x, int32_t bg)
+CODEC_HOT_FUNC void R8FirstPass(int32_t *x, int32_t bg)
 {
     int32_t ar, ai, br, bi, cr, ci, dr, di;
     int32_t sr, si, tr, ti, ur, ui, vr, vi;
@@ -3105,7 +3138,7 @@ void R8FirstPass(int32_t *x, int32_t bg)
  *              gbOut = gbIn - 1 (short block) or gbIn - 2 (long block)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void R4Core(int32_t *x, int32_t bg, int32_t gp, int32_t *wtab)
+CODEC_HOT_FUNC void R4Core(int32_t *x, int32_t bg, int32_t gp, int32_t *wtab)
 {
     int32_t ar, ai, br, bi, cr, ci, dr, di, tr, ti;
     int32_t wd, ws, wi;
@@ -3278,7 +3311,7 @@ void UnpackZeros(int32_t nVals, int32_t *coef)
  * Notes:       assumes nVals is always a multiple of 4 because all scalefactor bands
  *                are a multiple of 4 coefficients long
  **********************************************************************************************************************/
-void UnpackQuads(int32_t cb, int32_t nVals, int32_t *coef)
+void UnpackQuads(AACDecoder_t* dec, int32_t cb, int32_t nVals, int32_t *coef)
 {
     int32_t w, x, y, z, maxBits, nCodeBits, nSignBits, val;
     uint32_t bitBuf;
@@ -3286,7 +3319,7 @@ void UnpackQuads(int32_t cb, int32_t nVals, int32_t *coef)
     maxBits = huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET].maxBits + 4;
     while (nVals > 0) {
         /* decode quad */
-        bitBuf = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+        bitBuf = GetBitsNoAdvance(dec, maxBits) << (32 - maxBits);
         nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET], bitBuf, &val);
 
         w = (((int32_t)(val) << 20) >>   29);    /* bits 11-9, sign-extend */
@@ -3297,7 +3330,7 @@ void UnpackQuads(int32_t cb, int32_t nVals, int32_t *coef)
         bitBuf <<= nCodeBits;
         nSignBits = (int32_t)(((uint32_t)(val) << 17) >> 29);    /* bits 14-12, unsigned */
 
-        AdvanceBitstream(nCodeBits + nSignBits);
+        AdvanceBitstream(dec, nCodeBits + nSignBits);
         if (nSignBits) {
             if (w)    {w ^= ((int32_t)bitBuf >> 31); w -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
             if (x)    {x ^= ((int32_t)bitBuf >> 31); x -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
@@ -3325,7 +3358,7 @@ void UnpackQuads(int32_t cb, int32_t nVals, int32_t *coef)
  * Notes:       assumes nVals is always a multiple of 2 because all scalefactor bands
  *                are a multiple of 4 coefficients long
  **********************************************************************************************************************/
-void UnpackPairsNoEsc(int32_t cb, int32_t nVals, int32_t *coef)
+void UnpackPairsNoEsc(AACDecoder_t* dec, int32_t cb, int32_t nVals, int32_t *coef)
 {
     int32_t y, z, maxBits, nCodeBits, nSignBits, val;
     uint32_t bitBuf;
@@ -3333,7 +3366,7 @@ void UnpackPairsNoEsc(int32_t cb, int32_t nVals, int32_t *coef)
     maxBits = huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET].maxBits + 2;
     while (nVals > 0) {
         /* decode pair */
-        bitBuf = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+        bitBuf = GetBitsNoAdvance(dec, maxBits) << (32 - maxBits);
         nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb-HUFFTAB_SPEC_OFFSET], bitBuf, &val);
 
         y = (((int32_t)(val) << 22) >>   27);    /* bits  9-5, sign-extend */
@@ -3341,7 +3374,7 @@ void UnpackPairsNoEsc(int32_t cb, int32_t nVals, int32_t *coef)
 
         bitBuf <<= nCodeBits;
         nSignBits = (((uint32_t)(val) << 20) >> 30);    /* bits 11-10, unsigned */
-        AdvanceBitstream(nCodeBits + nSignBits);
+        AdvanceBitstream(dec, nCodeBits + nSignBits);
         if (nSignBits) {
             if (y)    {y ^= ((int32_t)bitBuf >> 31); y -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
             if (z)    {z ^= ((int32_t)bitBuf >> 31); z -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
@@ -3367,7 +3400,7 @@ void UnpackPairsNoEsc(int32_t cb, int32_t nVals, int32_t *coef)
  * Notes:       assumes nVals is always a multiple of 2 because all scalefactor bands
  *                are a multiple of 4 coefficients long
  **********************************************************************************************************************/
-void UnpackPairsEsc(int32_t cb, int32_t nVals, int32_t *coef)
+void UnpackPairsEsc(AACDecoder_t* dec, int32_t cb, int32_t nVals, int32_t *coef)
 {
     int32_t y, z, maxBits, nCodeBits, nSignBits, n, val;
     uint32_t bitBuf;
@@ -3375,7 +3408,7 @@ void UnpackPairsEsc(int32_t cb, int32_t nVals, int32_t *coef)
     maxBits = huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET].maxBits + 2;
     while (nVals > 0) {
         /* decode pair with escape value */
-        bitBuf = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+        bitBuf = GetBitsNoAdvance(dec, maxBits) << (32 - maxBits);
         nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb-HUFFTAB_SPEC_OFFSET], bitBuf, &val);
 
         y = (((int32_t)(val) << 20) >>   26);    /* bits 11-6, sign-extend */
@@ -3383,19 +3416,19 @@ void UnpackPairsEsc(int32_t cb, int32_t nVals, int32_t *coef)
 
         bitBuf <<= nCodeBits;
         nSignBits = (((uint32_t)(val) << 18) >> 30);    /* bits 13-12, unsigned */
-        AdvanceBitstream(nCodeBits + nSignBits);
+        AdvanceBitstream(dec, nCodeBits + nSignBits);
 
         if (y == 16) {
             n = 4;
-            while (GetBits(1) == 1)
+            while (GetBits(dec, 1) == 1)
                 n++;
-            y = (1 << n) + GetBits(n);
+            y = (1 << n) + GetBits(dec, n);
         }
         if (z == 16) {
             n = 4;
-            while (GetBits(1) == 1)
+            while (GetBits(dec, 1) == 1)
                 n++;
-            z = (1 << n) + GetBits(n);
+            z = (1 << n) + GetBits(dec, n);
         }
 
         if (nSignBits) {
@@ -3423,7 +3456,7 @@ void UnpackPairsEsc(int32_t cb, int32_t nVals, int32_t *coef)
  *              fills coefficient buffer with zeros in any region not coded with
  *                codebook in range [1, 11] (including sfb's above sfbMax)
  **********************************************************************************************************************/
-void DecodeSpectrumLong(int32_t ch)
+void DecodeSpectrumLong(AACDecoder_t* dec, int32_t ch)
 {
     int32_t i, sfb, cb, nVals, offset;
     const uint16_t *sfbTab;
@@ -3431,12 +3464,12 @@ void DecodeSpectrumLong(int32_t ch)
     int32_t *coef;
     ICSInfo_t *icsInfo;
 
-    coef = m_PSInfoBase->coef[ch];
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    coef = dec->psInfoBase->coef[ch];
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
 
     /* decode long block */
-    sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
+    sfbTab = sfBandTabLong + sfBandTabLongOffset[dec->psInfoBase->sampRateIdx];
+    sfbCodeBook = dec->psInfoBase->sfbCodeBook[ch];
     for (sfb = 0; sfb < icsInfo->maxSFB; sfb++) {
         cb = *sfbCodeBook++;
         nVals = sfbTab[sfb+1] - sfbTab[sfb];
@@ -3444,11 +3477,11 @@ void DecodeSpectrumLong(int32_t ch)
         if (cb == 0)
             UnpackZeros(nVals, coef);
         else if (cb <= 4)
-            UnpackQuads(cb, nVals, coef);
+            UnpackQuads(dec, cb, nVals, coef);
         else if (cb <= 10)
-            UnpackPairsNoEsc(cb, nVals, coef);
+            UnpackPairsNoEsc(dec, cb, nVals, coef);
         else if (cb == 11)
-            UnpackPairsEsc(cb, nVals, coef);
+            UnpackPairsEsc(dec, cb, nVals, coef);
         else
             UnpackZeros(nVals, coef);
 
@@ -3460,15 +3493,15 @@ void DecodeSpectrumLong(int32_t ch)
     UnpackZeros(nVals, coef);
 
     /* add pulse data, if present */
-    if (m_pulseInfo[ch].pulseDataPresent) {
-        coef = m_PSInfoBase->coef[ch];
-        offset = sfbTab[m_pulseInfo[ch].startSFB];
-        for (i = 0; i < m_pulseInfo[ch].numPulse; i++) {
-            offset += m_pulseInfo[ch].offset[i];
+    if (dec->pulseInfo[ch].pulseDataPresent) {
+        coef = dec->psInfoBase->coef[ch];
+        offset = sfbTab[dec->pulseInfo[ch].startSFB];
+        for (i = 0; i < dec->pulseInfo[ch].numPulse; i++) {
+            offset += dec->pulseInfo[ch].offset[i];
             if (coef[offset] > 0)
-                coef[offset] += m_pulseInfo[ch].amp[i];
+                coef[offset] += dec->pulseInfo[ch].amp[i];
             else
-                coef[offset] -= m_pulseInfo[ch].amp[i];
+                coef[offset] -= dec->pulseInfo[ch].amp[i];
         }
         ASSERT(offset < NSAMPS_LONG);
     }
@@ -3489,7 +3522,7 @@ void DecodeSpectrumLong(int32_t ch)
  *                codebook in range [1, 11] (including sfb's above sfbMax)
  *              deinterleaves window groups into 8 windows
  **********************************************************************************************************************/
-void DecodeSpectrumShort(int32_t ch)
+void DecodeSpectrumShort(AACDecoder_t* dec, int32_t ch)
 {
     int32_t gp, cb, nVals=0, win, offset, sfb;
     const uint16_t *sfbTab;
@@ -3497,12 +3530,12 @@ void DecodeSpectrumShort(int32_t ch)
     int32_t *coef;
     ICSInfo_t *icsInfo;
 
-    coef = m_PSInfoBase->coef[ch];
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    coef = dec->psInfoBase->coef[ch];
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
 
     /* decode short blocks, deinterleaving in-place */
-    sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
+    sfbTab = sfBandTabShort + sfBandTabShortOffset[dec->psInfoBase->sampRateIdx];
+    sfbCodeBook = dec->psInfoBase->sfbCodeBook[ch];
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (sfb = 0; sfb < icsInfo->maxSFB; sfb++) {
             nVals = sfbTab[sfb+1] - sfbTab[sfb];
@@ -3513,11 +3546,11 @@ void DecodeSpectrumShort(int32_t ch)
                 if (cb == 0)
                     UnpackZeros(nVals, coef + offset);
                 else if (cb <= 4)
-                    UnpackQuads(cb, nVals, coef + offset);
+                    UnpackQuads(dec, cb, nVals, coef + offset);
                 else if (cb <= 10)
-                    UnpackPairsNoEsc(cb, nVals, coef + offset);
+                    UnpackPairsNoEsc(dec, cb, nVals, coef + offset);
                 else if (cb == 11)
-                    UnpackPairsEsc(cb, nVals, coef + offset);
+                    UnpackPairsEsc(dec, cb, nVals, coef + offset);
                 else
                     UnpackZeros(nVals, coef + offset);
             }
@@ -3534,7 +3567,7 @@ void DecodeSpectrumShort(int32_t ch)
         coef += (icsInfo->winGroupLen[gp] - 1)*NSAMPS_SHORT;
     }
 
-    ASSERT(coef == m_PSInfoBase->coef[ch] + NSAMPS_LONG);
+    ASSERT(coef == dec->psInfoBase->coef[ch] + NSAMPS_LONG);
 }
 
 #ifndef AAC_ENABLE_SBR
@@ -3997,22 +4030,22 @@ void DecWindowOverlapShort(int32_t *buf0, int32_t *over0, int16_t *pcm0, int32_t
  *                a separate pass over the 32-bit PCM to produce 16-bit PCM output.
  *                This inflicts a slight performance hit when decoding non-SBR files.
  **********************************************************************************************************************/
-int32_t IMDCT(int32_t ch, int32_t chOut, int16_t *outbuf)
+int32_t IMDCT(AACDecoder_t* dec, int32_t ch, int32_t chOut, int16_t *outbuf)
 {
     int32_t i;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
     outbuf += chOut;
 
     /* optimized type-IV DCT (operates inplace) */
     if (icsInfo->winSequence == 2) {
         /* 8 short blocks */
         for (i = 0; i < 8; i++)
-            DCT4(0, m_PSInfoBase->coef[ch] + i*128, m_PSInfoBase->gbCurrent[ch]);
+            DCT4(0, dec->psInfoBase->coef[ch] + i*128, dec->psInfoBase->gbCurrent[ch]);
     } else {
         /* 1 long block */
-        DCT4(1, m_PSInfoBase->coef[ch], m_PSInfoBase->gbCurrent[ch]);
+        DCT4(1, dec->psInfoBase->coef[ch], dec->psInfoBase->gbCurrent[ch]);
     }
 
 #ifdef AAC_ENABLE_SBR
@@ -4020,49 +4053,49 @@ int32_t IMDCT(int32_t ch, int32_t chOut, int16_t *outbuf)
      * store the decoded 32-bit samples in top half (second AAC_MAX_NSAMPS samples) of coef buffer
      */
     if (icsInfo->winSequence == 0)
-        DecWindowOverlapNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                               m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapNoClip(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut],
+                               dec->psInfoBase->sbrWorkBuf[ch], icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 1)
-        DecWindowOverlapLongStartNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                                        m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStartNoClip(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut],
+                                        dec->psInfoBase->sbrWorkBuf[ch], icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 2)
-        DecWindowOverlapShortNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                                    m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapShortNoClip(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut],
+                                    dec->psInfoBase->sbrWorkBuf[ch], icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 3)
-        DecWindowOverlapLongStopNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                                       m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStopNoClip(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut],
+                                       dec->psInfoBase->sbrWorkBuf[ch], icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
 
-    if (!m_AACDecInfo->sbrEnabled) {
+    if (!dec->aacDecInfo->sbrEnabled) {
         for (i = 0; i < AAC_MAX_NSAMPS; i++) {
-            *outbuf = CLIPTOSHORT((m_PSInfoBase->sbrWorkBuf[ch][i] + RND_VAL) >> FBITS_OUT_IMDCT);
-            outbuf += m_AACDecInfo->nChans;
+            *outbuf = CLIPTOSHORT((dec->psInfoBase->sbrWorkBuf[ch][i] + RND_VAL) >> FBITS_OUT_IMDCT);
+            outbuf += dec->aacDecInfo->nChans;
         }
     }
 
-    m_AACDecInfo->rawSampleBuf[ch] = m_PSInfoBase->sbrWorkBuf[ch];
-    m_AACDecInfo->rawSampleBytes = sizeof(int32_t);
-    m_AACDecInfo->rawSampleFBits = FBITS_OUT_IMDCT;
+    dec->aacDecInfo->rawSampleBuf[ch] = dec->psInfoBase->sbrWorkBuf[ch];
+    dec->aacDecInfo->rawSampleBytes = sizeof(int32_t);
+    dec->aacDecInfo->rawSampleFBits = FBITS_OUT_IMDCT;
 #else
     /* window, overlap-add, round to PCM - optimized for each window sequence */
     if (icsInfo->winSequence == 0)
-        DecWindowOverlap(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlap(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut], outbuf, dec->aacDecInfo->nChans,
+                                                                  icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 1)
-        DecWindowOverlapLongStart(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStart(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut], outbuf, dec->aacDecInfo->nChans,
+                                                                  icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 2)
-        DecWindowOverlapShort(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapShort(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut], outbuf, dec->aacDecInfo->nChans,
+                                                                  icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 3)
-        DecWindowOverlapLongStop(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStop(dec->psInfoBase->coef[ch], dec->psInfoBase->overlap[chOut], outbuf, dec->aacDecInfo->nChans,
+                                                                  icsInfo->winShape, dec->psInfoBase->prevWinShape[chOut]);
 
-    m_AACDecInfo->rawSampleBuf[ch] = 0;
-    m_AACDecInfo->rawSampleBytes = 0;
-    m_AACDecInfo->rawSampleFBits = 0;
+    dec->aacDecInfo->rawSampleBuf[ch] = 0;
+    dec->aacDecInfo->rawSampleBytes = 0;
+    dec->aacDecInfo->rawSampleFBits = 0;
 #endif
 
-    m_PSInfoBase->prevWinShape[chOut] = icsInfo->winShape;
+    dec->psInfoBase->prevWinShape[chOut] = icsInfo->winShape;
 
     return 0;
 }
@@ -4078,17 +4111,17 @@ int32_t IMDCT(int32_t ch, int32_t chOut, int16_t *outbuf)
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodeICSInfo(ICSInfo_t *icsInfo, int32_t sampRateIdx)
+void DecodeICSInfo(AACDecoder_t* dec, ICSInfo_t *icsInfo, int32_t sampRateIdx)
 {
     int32_t sfb, g, mask;
 
-    icsInfo->icsResBit =      GetBits(1);
-    icsInfo->winSequence =    GetBits(2);
-    icsInfo->winShape =       GetBits(1);
+    icsInfo->icsResBit =      GetBits(dec, 1);
+    icsInfo->winSequence =    GetBits(dec, 2);
+    icsInfo->winShape =       GetBits(dec, 1);
     if (icsInfo->winSequence == 2) {
         /* short block */
-        icsInfo->maxSFB =     GetBits(4);
-        icsInfo->sfGroup =    GetBits(7);
+        icsInfo->maxSFB =     GetBits(dec, 4);
+        icsInfo->sfGroup =    GetBits(dec, 7);
         icsInfo->numWinGroup =    1;
         icsInfo->winGroupLen[0] = 1;
         mask = 0x40;    /* start with bit 6 */
@@ -4103,14 +4136,14 @@ void DecodeICSInfo(ICSInfo_t *icsInfo, int32_t sampRateIdx)
         }
     } else {
         /* long block */
-        icsInfo->maxSFB =               GetBits(6);
-        icsInfo->predictorDataPresent = GetBits(1);
+        icsInfo->maxSFB =               GetBits(dec, 6);
+        icsInfo->predictorDataPresent = GetBits(dec, 1);
         if (icsInfo->predictorDataPresent) {
-            icsInfo->predictorReset =   GetBits(1);
+            icsInfo->predictorReset =   GetBits(dec, 1);
             if (icsInfo->predictorReset)
-                icsInfo->predictorResetGroupNum = GetBits(5);
+                icsInfo->predictorResetGroupNum = GetBits(dec, 5);
             for (sfb = 0; sfb < MIN(icsInfo->maxSFB, predSFBMax[sampRateIdx]); sfb++)
-                icsInfo->predictionUsed[sfb] = GetBits(1);
+                icsInfo->predictionUsed[sfb] = GetBits(dec, 1);
         }
         icsInfo->numWinGroup = 1;
         icsInfo->winGroupLen[0] = 1;
@@ -4133,7 +4166,7 @@ void DecodeICSInfo(ICSInfo_t *icsInfo, int32_t sampRateIdx)
  *
  * Notes:       sectCB, sectEnd, sfbCodeBook, ordered by window groups for short blocks
  **********************************************************************************************************************/
-void DecodeSectionData(int32_t winSequence, int32_t numWinGrp, int32_t maxSFB, uint8_t *sfbCodeBook)
+void DecodeSectionData(AACDecoder_t* dec, int32_t winSequence, int32_t numWinGrp, int32_t maxSFB, uint8_t *sfbCodeBook)
 {
     int32_t g, cb, sfb;
     int32_t sectLen, sectLenBits, sectLenIncr, sectEscapeVal;
@@ -4144,10 +4177,10 @@ void DecodeSectionData(int32_t winSequence, int32_t numWinGrp, int32_t maxSFB, u
     for (g = 0; g < numWinGrp; g++) {
         sfb = 0;
         while (sfb < maxSFB) {
-            cb = GetBits(4);    /* next section codebook */
+            cb = GetBits(dec, 4);    /* next section codebook */
             sectLen = 0;
             do {
-                sectLenIncr = GetBits(sectLenBits);
+                sectLenIncr = GetBits(dec, sectLenBits);
                 sectLen += sectLenIncr;
             } while (sectLenIncr == sectEscapeVal);
 
@@ -4170,15 +4203,15 @@ void DecodeSectionData(int32_t winSequence, int32_t numWinGrp, int32_t maxSFB, u
  *
  * Return:      one decoded scalefactor, including index_offset of -60
  **********************************************************************************************************************/
-int32_t DecodeOneScaleFactor()
+int32_t DecodeOneScaleFactor(AACDecoder_t* dec)
 {
     int32_t nBits, val;
     uint32_t bitBuf;
 
     /* decode next scalefactor from bitstream */
-    bitBuf = GetBitsNoAdvance(huffTabScaleFactInfo.maxBits) << (32 - huffTabScaleFactInfo.maxBits);
+    bitBuf = GetBitsNoAdvance(dec, huffTabScaleFactInfo.maxBits) << (32 - huffTabScaleFactInfo.maxBits);
     nBits = DecodeHuffmanScalar(huffTabScaleFact, &huffTabScaleFactInfo, bitBuf, &val);
-    AdvanceBitstream(nBits);
+    AdvanceBitstream(dec, nBits);
     return val;
 }
 
@@ -4202,7 +4235,7 @@ int32_t DecodeOneScaleFactor()
  *              for section with codebook 14 or 15, scaleFactors buffer has intensity
  *                stereo weight instead of regular scalefactor
  **********************************************************************************************************************/
-void DecodeScaleFactors(int32_t numWinGrp, int32_t maxSFB, int32_t globalGain,
+void DecodeScaleFactors(AACDecoder_t* dec, int32_t numWinGrp, int32_t maxSFB, int32_t globalGain,
                                uint8_t *sfbCodeBook, int16_t *scaleFactors)
 {
     int32_t g, sfbCB, nrg, npf, val, sf, is;
@@ -4218,22 +4251,22 @@ void DecodeScaleFactors(int32_t numWinGrp, int32_t maxSFB, int32_t globalGain,
 
         if (sfbCB  == 14 || sfbCB == 15) {
             /* intensity stereo - differential coding */
-            val = DecodeOneScaleFactor();
+            val = DecodeOneScaleFactor(dec);
             is += val;
             *scaleFactors++ = (int16_t)is;
         } else if (sfbCB == 13) {
             /* PNS - first energy is directly coded, rest are Huffman coded (npf = noise_pcm_flag) */
             if (npf) {
-                val = GetBits(9);
+                val = GetBits(dec, 9);
                 npf = 0;
             } else {
-                val = DecodeOneScaleFactor();
+                val = DecodeOneScaleFactor(dec);
             }
             nrg += val;
             *scaleFactors++ = (int16_t)nrg;
         } else if (sfbCB >= 1 && sfbCB <= 11) {
             /* regular (non-zero) region - differential coding */
-            val = DecodeOneScaleFactor();
+            val = DecodeOneScaleFactor(dec);
             sf += val;
             *scaleFactors++ = (int16_t)sf;
         } else {
@@ -4254,15 +4287,15 @@ void DecodeScaleFactors(int32_t numWinGrp, int32_t maxSFB, int32_t globalGain,
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodePulseInfo(uint8_t ch)
+void DecodePulseInfo(AACDecoder_t* dec, uint8_t ch)
 {
     int32_t i;
 
-    m_pulseInfo[ch].numPulse = GetBits(2) + 1;        /* add 1 here */
-    m_pulseInfo[ch].startSFB = GetBits(6);
-    for (i = 0; i < m_pulseInfo[ch].numPulse; i++) {
-        m_pulseInfo[ch].offset[i] = GetBits(5);
-        m_pulseInfo[ch].amp[i] = GetBits(4);
+    dec->pulseInfo[ch].numPulse = GetBits(dec, 2) + 1;        /* add 1 here */
+    dec->pulseInfo[ch].startSFB = GetBits(dec, 6);
+    for (i = 0; i < dec->pulseInfo[ch].numPulse; i++) {
+        dec->pulseInfo[ch].offset[i] = GetBits(dec, 5);
+        dec->pulseInfo[ch].amp[i] = GetBits(dec, 4);
     }
 }
 
@@ -4278,7 +4311,7 @@ void DecodePulseInfo(uint8_t ch)
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodeTNSInfo(int32_t winSequence, TNSInfo_t *ti, int8_t *tnsCoef)
+void DecodeTNSInfo(AACDecoder_t* dec, int32_t winSequence, TNSInfo_t *ti, int8_t *tnsCoef)
 {
     int32_t i, w, f, coefBits, compress;
     int8_t c, s, n;
@@ -4291,19 +4324,19 @@ void DecodeTNSInfo(int32_t winSequence, TNSInfo_t *ti, int8_t *tnsCoef)
     if (winSequence == 2) {
         /* short blocks */
         for (w = 0; w < NWINDOWS_SHORT; w++) {
-            ti->numFilt[w] = GetBits(1);
+            ti->numFilt[w] = GetBits(dec, 1);
             if (ti->numFilt[w]) {
-                ti->coefRes[w] = GetBits(1) + 3;
-                *filtLength =    GetBits(4);
-                *filtOrder =     GetBits(3);
+                ti->coefRes[w] = GetBits(dec, 1) + 3;
+                *filtLength =    GetBits(dec, 4);
+                *filtOrder =     GetBits(dec, 3);
                 if (*filtOrder) {
-                    *filtDir++ =      GetBits(1);
-                    compress =        GetBits(1);
+                    *filtDir++ =      GetBits(dec, 1);
+                    compress =        GetBits(dec, 1);
                     coefBits = (int32_t)ti->coefRes[w] - compress;    /* 2, 3, or 4 */
                     s = sgnMask[coefBits - 2];
                     n = negMask[coefBits - 2];
                     for (i = 0; i < *filtOrder; i++) {
-                        c = GetBits(coefBits);
+                        c = GetBits(dec, coefBits);
                         if (c & s)    c |= n;
                         *tnsCoef++ = c;
                     }
@@ -4314,20 +4347,20 @@ void DecodeTNSInfo(int32_t winSequence, TNSInfo_t *ti, int8_t *tnsCoef)
         }
     } else {
         /* long blocks */
-        ti->numFilt[0] = GetBits(2);
+        ti->numFilt[0] = GetBits(dec, 2);
         if (ti->numFilt[0])
-            ti->coefRes[0] = GetBits(1) + 3;
+            ti->coefRes[0] = GetBits(dec, 1) + 3;
         for (f = 0; f < ti->numFilt[0]; f++) {
-            *filtLength =      GetBits(6);
-            *filtOrder =       GetBits(5);
+            *filtLength =      GetBits(dec, 6);
+            *filtOrder =       GetBits(dec, 5);
             if (*filtOrder) {
-                *filtDir++ =     GetBits(1);
-                compress =       GetBits(1);
+                *filtDir++ =     GetBits(dec, 1);
+                compress =       GetBits(dec, 1);
                 coefBits = (int32_t)ti->coefRes[0] - compress;    /* 2, 3, or 4 */
                 s = sgnMask[coefBits - 2];
                 n = negMask[coefBits - 2];
                 for (i = 0; i < *filtOrder; i++) {
-                    c = GetBits(coefBits);
+                    c = GetBits(dec, coefBits);
                     if (c & s)    c |= n;
                     *tnsCoef++ = c;
                 }
@@ -4361,22 +4394,22 @@ static const uint8_t gainBits[4][3] = {
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodeGainControlInfo(int32_t winSequence, GainControlInfo_t *gi)
+void DecodeGainControlInfo(AACDecoder_t* dec, int32_t winSequence, GainControlInfo_t *gi)
 {
     int32_t bd, wd, ad;
     int32_t locBits, locBitsZero, maxWin;
 
-    gi->maxBand = GetBits(2);
+    gi->maxBand = GetBits(dec, 2);
     maxWin =      (int32_t)gainBits[winSequence][0];
     locBitsZero = (int32_t)gainBits[winSequence][1];
     locBits =     (int32_t)gainBits[winSequence][2];
 
     for (bd = 1; bd <= gi->maxBand; bd++) {
         for (wd = 0; wd < maxWin; wd++) {
-            gi->adjNum[bd][wd] = GetBits(3);
+            gi->adjNum[bd][wd] = GetBits(dec, 3);
             for (ad = 0; ad < gi->adjNum[bd][wd]; ad++) {
-                gi->alevCode[bd][wd][ad] = GetBits(4);
-                gi->alocCode[bd][wd][ad] = GetBits(wd == 0 ? locBitsZero : locBits);
+                gi->alevCode[bd][wd][ad] = GetBits(dec, 4);
+                gi->alocCode[bd][wd][ad] = GetBits(dec, wd == 0 ? locBitsZero : locBits);
             }
         }
     }
@@ -4394,37 +4427,37 @@ void DecodeGainControlInfo(int32_t winSequence, GainControlInfo_t *gi)
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodeICS(int32_t ch)
+void DecodeICS(AACDecoder_t* dec, int32_t ch)
 {
     int32_t globalGain;
     ICSInfo_t *icsInfo;
     TNSInfo_t *ti;
     GainControlInfo_t *gi;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
 
-    globalGain = GetBits(8);
-    if (!m_PSInfoBase->commonWin)
-        DecodeICSInfo(icsInfo, m_PSInfoBase->sampRateIdx);
+    globalGain = GetBits(dec, 8);
+    if (!dec->psInfoBase->commonWin)
+        DecodeICSInfo(dec, icsInfo, dec->psInfoBase->sampRateIdx);
 
-    DecodeSectionData(icsInfo->winSequence, icsInfo->numWinGroup, icsInfo->maxSFB, m_PSInfoBase->sfbCodeBook[ch]);
+    DecodeSectionData(dec, icsInfo->winSequence, icsInfo->numWinGroup, icsInfo->maxSFB, dec->psInfoBase->sfbCodeBook[ch]);
 
-    DecodeScaleFactors(icsInfo->numWinGroup, icsInfo->maxSFB, globalGain, m_PSInfoBase->sfbCodeBook[ch],
-                                                                                        m_PSInfoBase->scaleFactors[ch]);
+    DecodeScaleFactors(dec, icsInfo->numWinGroup, icsInfo->maxSFB, globalGain, dec->psInfoBase->sfbCodeBook[ch],
+                                                                                        dec->psInfoBase->scaleFactors[ch]);
 
-    m_pulseInfo[ch].pulseDataPresent = GetBits(1);
-    if (m_pulseInfo[ch].pulseDataPresent)
-        DecodePulseInfo(ch);
+    dec->pulseInfo[ch].pulseDataPresent = GetBits(dec, 1);
+    if (dec->pulseInfo[ch].pulseDataPresent)
+        DecodePulseInfo(dec, ch);
 
-    ti = &m_PSInfoBase->tnsInfo[ch];
-    ti->tnsDataPresent = GetBits(1);
+    ti = &dec->psInfoBase->tnsInfo[ch];
+    ti->tnsDataPresent = GetBits(dec, 1);
     if (ti->tnsDataPresent)
-        DecodeTNSInfo(icsInfo->winSequence, ti, ti->coef);
+        DecodeTNSInfo(dec, icsInfo->winSequence, ti, ti->coef);
 
-    gi = &m_PSInfoBase->gainControlInfo[ch];
-    gi->gainControlDataPresent = GetBits(1);
+    gi = &dec->psInfoBase->gainControlInfo[ch];
+    gi->gainControlDataPresent = GetBits(dec, 1);
     if (gi->gainControlDataPresent)
-        DecodeGainControlInfo(icsInfo->winSequence, gi);
+        DecodeGainControlInfo(dec, icsInfo->winSequence, gi);
 }
 
 /***********************************************************************************************************************
@@ -4443,30 +4476,35 @@ void DecodeICS(int32_t ch)
  *
  * Return:      0 if successful, error code (< 0) if error
  **********************************************************************************************************************/
-int32_t DecodeNoiselessData(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail, int32_t ch)
+int32_t DecodeNoiselessData(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail, int32_t ch)
 {
     int32_t bitsUsed;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
+
+    SetBitstreamPointer(dec, (*bitsAvail+7) >> 3, *buf);
+    GetBits(dec, *bitOffset);
 
-    SetBitstreamPointer((*bitsAvail+7) >> 3, *buf);
-    GetBits(*bitOffset);
+    DecodeICS(dec, ch);
 
-    DecodeICS(ch);
+    /* max_sfb of a damaged frame would index past the band tables and the stereo and spectrum buffers */
+    if (icsInfo->maxSFB > (icsInfo->winSequence == 2 ? sfBandTotalShort[dec->psInfoBase->sampRateIdx] :
+                                                      sfBandTotalLong[dec->psInfoBase->sampRateIdx]))
+        return ERR_AAC_INVALID_FRAME;
 
     if (icsInfo->winSequence == 2)
-        DecodeSpectrumShort(ch);
+        DecodeSpectrumShort(dec, ch);
     else
-        DecodeSpectrumLong(ch);
+        DecodeSpectrumLong(dec, ch);
 
-    bitsUsed = CalcBitsUsed(*buf, *bitOffset);
+    bitsUsed = CalcBitsUsed(dec, *buf, *bitOffset);
     *buf += ((bitsUsed + *bitOffset) >> 3);
     *bitOffset = ((bitsUsed + *bitOffset) & 0x07);
     *bitsAvail -= bitsUsed;
 
-    m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
-    m_AACDecInfo->tnsUsed |= m_PSInfoBase->tnsInfo[ch].tnsDataPresent;    /* set flag if TNS used for any channel */
+    dec->aacDecInfo->sbDeinterleaveReqd[ch] = 0;
+    dec->aacDecInfo->tnsUsed |= dec->psInfoBase->tnsInfo[ch].tnsDataPresent;    /* set flag if TNS used for any channel */
 
     return ERR_AAC_NONE;
 }
@@ -4530,76 +4568,76 @@ int32_t DecodeHuffmanScalar(const uint16_t *huffTab, const HuffInfo_t *huffTabIn
 * Return:      0 if successful, error code (< 0) if error
 *              verify that fixed fields don't change between frames
 ***********************************************************************************************************************/
-int32_t UnpackADTSHeader(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
+int32_t UnpackADTSHeader(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
 {
     int32_t bitsUsed;
 
     /* init bitstream reader */
-    SetBitstreamPointer((*bitsAvail + 7) >> 3, *buf);
-    GetBits(*bitOffset);
+    SetBitstreamPointer(dec, (*bitsAvail + 7) >> 3, *buf);
+    GetBits(dec, *bitOffset);
 
     /* verify that first 12 bits of header are syncword */
-    if (GetBits(12) != 0x0fff) {
+    if (GetBits(dec, 12) != 0x0fff) {
         return ERR_AAC_INVALID_ADTS_HEADER;
     }
 
     /* fixed fields - should not change from frame to frame */
-    m_fhADTS.id =               GetBits(1);
-    m_fhADTS.layer =            GetBits(2);
-    m_fhADTS.protectBit =       GetBits(1);
-    m_fhADTS.profile =          GetBits(2);
-    m_fhADTS.sampRateIdx =      GetBits(4);
-    m_fhADTS.privateBit =       GetBits(1);
-    m_fhADTS.channelConfig =    GetBits(3);
-    m_fhADTS.origCopy =         GetBits(1);
-    m_fhADTS.home =             GetBits(1);
+    dec->fhADTS.id =               GetBits(dec, 1);
+    dec->fhADTS.layer =            GetBits(dec, 2);
+    dec->fhADTS.protectBit =       GetBits(dec, 1);
+    dec->fhADTS.profile =          GetBits(dec, 2);
+    dec->fhADTS.sampRateIdx =      GetBits(dec, 4);
+    dec->fhADTS.privateBit =       GetBits(dec, 1);
+    dec->fhADTS.channelConfig =    GetBits(dec, 3);
+    dec->fhADTS.origCopy =         GetBits(dec, 1);
+    dec->fhADTS.home =             GetBits(dec, 1);
 
     /* variable fields - can change from frame to frame */
-    m_fhADTS.copyBit =          GetBits(1);
-    m_fhADTS.copyStart =        GetBits(1);
-    m_fhADTS.frameLength =      GetBits(13);
-    m_fhADTS.bufferFull =       GetBits(11);
-    m_fhADTS.numRawDataBlocks = GetBits(2) + 1;
+    dec->fhADTS.copyBit =          GetBits(dec, 1);
+    dec->fhADTS.copyStart =        GetBits(dec, 1);
+    dec->fhADTS.frameLength =      GetBits(dec, 13);
+    dec->fhADTS.bufferFull =       GetBits(dec, 11);
+    dec->fhADTS.numRawDataBlocks = GetBits(dec, 2) + 1;
 
     /* note - MPEG4 spec, correction 1 changes how CRC is handled when protectBit == 0 and numRawDataBlocks > 1 */
-    if (m_fhADTS.protectBit == 0)
-        m_fhADTS.crcCheckWord = GetBits(16);
+    if (dec->fhADTS.protectBit == 0)
+        dec->fhADTS.crcCheckWord = GetBits(dec, 16);
 
     /* byte align */
-    ByteAlignBitstream();    /* should always be aligned anyway */
+    ByteAlignBitstream(dec);    /* should always be aligned anyway */
 
     /* check validity of header */
-    if (m_fhADTS.layer != 0 || m_fhADTS.profile != AAC_PROFILE_LC ||
-        m_fhADTS.sampRateIdx >= NUM_SAMPLE_RATES || m_fhADTS.channelConfig >= NUM_DEF_CHAN_MAPS)
+    if (dec->fhADTS.layer != 0 || dec->fhADTS.profile != AAC_PROFILE_LC ||
+        dec->fhADTS.sampRateIdx >= NUM_SAMPLE_RATES || dec->fhADTS.channelConfig >= NUM_DEF_CHAN_MAPS)
         return ERR_AAC_INVALID_ADTS_HEADER;
 
 #ifndef AAC_ENABLE_MPEG4
-    if (m_fhADTS.id != 1)
+    if (dec->fhADTS.id != 1)
         return ERR_AAC_MPEG4_UNSUPPORTED;
 #endif
 
 
     /* update codec info */
-    m_PSInfoBase->sampRateIdx = m_fhADTS.sampRateIdx;
-    if (!m_PSInfoBase->useImpChanMap)
-        m_PSInfoBase->nChans = channelMapTab[m_fhADTS.channelConfig];
+    dec->psInfoBase->sampRateIdx = dec->fhADTS.sampRateIdx;
+    if (!dec->psInfoBase->useImpChanMap)
+        dec->psInfoBase->nChans = channelMapTab[dec->fhADTS.channelConfig];
 
     /* syntactic element fields will be read from bitstream for each element */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    dec->aacDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currInstTag = -1;
 
     /* fill in user-accessible data */
-    m_AACDecInfo->bitRate = 0;
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_AACDecInfo->sampRate = sampRateTab[m_PSInfoBase->sampRateIdx];
-    m_AACDecInfo->id = m_fhADTS.id;
-    m_AACDecInfo->profile = m_fhADTS.profile;
-    m_AACDecInfo->sbrEnabled = 0;
-    m_AACDecInfo->adtsBlocksLeft = m_fhADTS.numRawDataBlocks;
+    dec->aacDecInfo->bitRate = 0;
+    dec->aacDecInfo->nChans = dec->psInfoBase->nChans;
+    dec->aacDecInfo->sampRate = sampRateTab[dec->psInfoBase->sampRateIdx];
+    dec->aacDecInfo->id = dec->fhADTS.id;
+    dec->aacDecInfo->profile = dec->fhADTS.profile;
+    dec->aacDecInfo->sbrEnabled = 0;
+    dec->aacDecInfo->adtsBlocksLeft = dec->fhADTS.numRawDataBlocks;
 
     /* update bitstream reader */
-    bitsUsed = CalcBitsUsed(*buf, *bitOffset);
+    bitsUsed = CalcBitsUsed(dec, *buf, *bitOffset);
     *buf += (bitsUsed + *bitOffset) >> 3;
     *bitOffset = (bitsUsed + *bitOffset) & 0x07;
     *bitsAvail -= bitsUsed ;
@@ -4625,34 +4663,34 @@ int32_t UnpackADTSHeader(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
 * Notes:       calculates total number of channels using rules in 14496-3, 4.5.1.2.1
 *              does not attempt to deduce speaker geometry
 ***********************************************************************************************************************/
-int32_t GetADTSChannelMapping(uint8_t *buf, int32_t bitOffset, int32_t bitsAvail)
+int32_t GetADTSChannelMapping(AACDecoder_t* dec, uint8_t *buf, int32_t bitOffset, int32_t bitsAvail)
 {
     int32_t ch, nChans, elementChans, err;
 
     nChans = 0;
     do {
         /* parse next syntactic element */
-        err = DecodeNextElement(&buf, &bitOffset, &bitsAvail);
+        err = DecodeNextElement(dec, &buf, &bitOffset, &bitsAvail);
         if (err)
             return err;
 
-        elementChans = elementNumChans[m_AACDecInfo->currBlockID];
+        elementChans = elementNumChans[dec->aacDecInfo->currBlockID];
         nChans += elementChans;
 
         for (ch = 0; ch < elementChans; ch++) {
-            err = DecodeNoiselessData(&buf, &bitOffset, &bitsAvail, ch);
+            err = DecodeNoiselessData(dec, &buf, &bitOffset, &bitsAvail, ch);
             if (err)
                 return err;
         }
-    } while (m_AACDecInfo->currBlockID != AAC_ID_END);
+    } while (dec->aacDecInfo->currBlockID != AAC_ID_END);
 
     if (nChans <= 0)
         return ERR_AAC_CHANNEL_MAP;
 
     /* update number of channels in codec state and user-accessible info structs */
-    m_PSInfoBase->nChans = nChans;
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_PSInfoBase->useImpChanMap = 1;
+    dec->psInfoBase->nChans = nChans;
+    dec->aacDecInfo->nChans = dec->psInfoBase->nChans;
+    dec->psInfoBase->useImpChanMap = 1;
 
     return ERR_AAC_NONE;
 }
@@ -4670,7 +4708,7 @@ int32_t GetADTSChannelMapping(uint8_t *buf, int32_t bitOffset, int32_t bitsAvail
 * Return:      total number of channels in file
 *              -1 if error (invalid number of PCE's or unsupported mode)
 ***********************************************************************************************************************/
-int32_t GetNumChannelsADIF(int32_t nPCE)
+int32_t GetNumChannelsADIF(AACDecoder_t* dec, int32_t nPCE)
 {
     int32_t i, j, nChans;
 
@@ -4680,26 +4718,26 @@ int32_t GetNumChannelsADIF(int32_t nPCE)
     nChans = 0;
     for (i = 0; i < nPCE; i++) {
         /* for now: only support LC, no channel coupling */
-        if (m_pce[i]->profile != AAC_PROFILE_LC || m_pce[i]->numCCE > 0)
+        if (dec->pce[i]->profile != AAC_PROFILE_LC || dec->pce[i]->numCCE > 0)
             return -1;
 
         /* add up number of channels in all channel elements (assume all single-channel) */
-       nChans += m_pce[i]->numFCE;
-       nChans += m_pce[i]->numSCE;
-       nChans += m_pce[i]->numBCE;
-       nChans += m_pce[i]->numLCE;
+       nChans += dec->pce[i]->numFCE;
+       nChans += dec->pce[i]->numSCE;
+       nChans += dec->pce[i]->numBCE;
+       nChans += dec->pce[i]->numLCE;
 
         /* add one more for every element which is a channel pair */
-       for (j = 0; j < m_pce[i]->numFCE; j++) {
-           if ((m_pce[i]->fce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
+       for (j = 0; j < dec->pce[i]->numFCE; j++) {
+           if ((dec->pce[i]->fce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
                nChans++;
        }
-       for (j = 0; j < m_pce[i]->numSCE; j++) {
-           if ((m_pce[i]->sce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
+       for (j = 0; j < dec->pce[i]->numSCE; j++) {
+           if ((dec->pce[i]->sce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
                nChans++;
        }
-       for (j = 0; j < m_pce[i]->numBCE; j++) {
-           if ((m_pce[i]->bce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
+       for (j = 0; j < dec->pce[i]->numBCE; j++) {
+           if ((dec->pce[i]->bce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
                nChans++;
        }
 
@@ -4721,7 +4759,7 @@ int32_t GetNumChannelsADIF(int32_t nPCE)
 * Return:      sample rate of file
 *              -1 if error (invalid number of PCE's or sample rate mismatch)
 ***********************************************************************************************************************/
-int32_t GetSampleRateIdxADIF(int32_t nPCE)
+int32_t GetSampleRateIdxADIF(AACDecoder_t* dec, int32_t nPCE)
 {
     int32_t i, idx;
 
@@ -4729,9 +4767,9 @@ int32_t GetSampleRateIdxADIF(int32_t nPCE)
         return -1;
 
     /* make sure all PCE's have the same sample rate */
-    idx = m_pce[0]->sampRateIdx;
+    idx = dec->pce[0]->sampRateIdx;
     for (i = 1; i < nPCE; i++) {
-        if (m_pce[i]->sampRateIdx != idx)
+        if (dec->pce[i]->sampRateIdx != idx)
             return -1;
     }
 
@@ -4755,62 +4793,62 @@ int32_t GetSampleRateIdxADIF(int32_t nPCE)
 *
 * Return:      0 if successful, error code (< 0) if error
 ***********************************************************************************************************************/
-int32_t UnpackADIFHeader(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
+int32_t UnpackADIFHeader(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
 {
     uint8_t i;
     int32_t bitsUsed;
 
     /* init bitstream reader */
-    SetBitstreamPointer((*bitsAvail + 7) >> 3, *buf);
-    GetBits(*bitOffset);
+    SetBitstreamPointer(dec, (*bitsAvail + 7) >> 3, *buf);
+    GetBits(dec, *bitOffset);
 
     /* verify that first 32 bits of header are "ADIF" */
-    if (GetBits(8) != 'A' || GetBits(8) != 'D' || GetBits(8) != 'I' || GetBits(8) != 'F')
+    if (GetBits(dec, 8) != 'A' || GetBits(dec, 8) != 'D' || GetBits(dec, 8) != 'I' || GetBits(dec, 8) != 'F')
         return ERR_AAC_INVALID_ADIF_HEADER;
 
     /* read ADIF header fields */
-    m_fhADIF.copyBit = GetBits(1);
-    if (m_fhADIF.copyBit) {
+    dec->fhADIF.copyBit = GetBits(dec, 1);
+    if (dec->fhADIF.copyBit) {
         for (i = 0; i < ADIF_COPYID_SIZE; i++)
-            m_fhADIF.copyID[i] = GetBits(8);
+            dec->fhADIF.copyID[i] = GetBits(dec, 8);
     }
-    m_fhADIF.origCopy = GetBits(1);
-    m_fhADIF.home =     GetBits(1);
-    m_fhADIF.bsType =   GetBits(1);
-    m_fhADIF.bitRate =  GetBits(23);
-    m_fhADIF.numPCE =   GetBits(4) + 1;    /* add 1 (so range = [1, 16]) */
-    if (m_fhADIF.bsType == 0)
-        m_fhADIF.bufferFull = GetBits(20);
+    dec->fhADIF.origCopy = GetBits(dec, 1);
+    dec->fhADIF.home =     GetBits(dec, 1);
+    dec->fhADIF.bsType =   GetBits(dec, 1);
+    dec->fhADIF.bitRate =  GetBits(dec, 23);
+    dec->fhADIF.numPCE =   GetBits(dec, 4) + 1;    /* add 1 (so range = [1, 16]) */
+    if (dec->fhADIF.bsType == 0)
+        dec->fhADIF.bufferFull = GetBits(dec, 20);
 
     /* parse all program config elements */
-    for (i = 0; i < m_fhADIF.numPCE; i++)
-        DecodeProgramConfigElement(i);
+    for (i = 0; i < dec->fhADIF.numPCE; i++)
+        DecodeProgramConfigElement(dec, i);
 
     /* byte align */
-    ByteAlignBitstream();
+    ByteAlignBitstream(dec);
 
     /* update codec info */
-    m_PSInfoBase->nChans = GetNumChannelsADIF(m_fhADIF.numPCE);
-    m_PSInfoBase->sampRateIdx = GetSampleRateIdxADIF(m_fhADIF.numPCE);
+    dec->psInfoBase->nChans = GetNumChannelsADIF(dec, dec->fhADIF.numPCE);
+    dec->psInfoBase->sampRateIdx = GetSampleRateIdxADIF(dec, dec->fhADIF.numPCE);
 
     /* check validity of header */
-    if (m_PSInfoBase->nChans < 0 || m_PSInfoBase->sampRateIdx < 0 || m_PSInfoBase->sampRateIdx >= NUM_SAMPLE_RATES)
+    if (dec->psInfoBase->nChans < 0 || dec->psInfoBase->sampRateIdx < 0 || dec->psInfoBase->sampRateIdx >= NUM_SAMPLE_RATES)
         return ERR_AAC_INVALID_ADIF_HEADER;
 
     /* syntactic element fields will be read from bitstream for each element */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    dec->aacDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currInstTag = -1;
 
     /* fill in user-accessible data */
-    m_AACDecInfo->bitRate = 0;
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_AACDecInfo->sampRate = sampRateTab[m_PSInfoBase->sampRateIdx];
-    m_AACDecInfo->profile = m_pce[0]->profile;
-    m_AACDecInfo->sbrEnabled = 0;
+    dec->aacDecInfo->bitRate = 0;
+    dec->aacDecInfo->nChans = dec->psInfoBase->nChans;
+    dec->aacDecInfo->sampRate = sampRateTab[dec->psInfoBase->sampRateIdx];
+    dec->aacDecInfo->profile = dec->pce[0]->profile;
+    dec->aacDecInfo->sbrEnabled = 0;
 
     /* update bitstream reader */
-    bitsUsed = CalcBitsUsed(*buf, *bitOffset);
+    bitsUsed = CalcBitsUsed(dec, *buf, *bitOffset);
     *buf += (bitsUsed + *bitOffset) >> 3;
     *bitOffset = (bitsUsed + *bitOffset) & 0x07;
     *bitsAvail -= bitsUsed ;
@@ -4835,33 +4873,33 @@ int32_t UnpackADIFHeader(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail)
 *
 * Return:      0 if successful, error code (< 0) if error
 *
-* Notes:       if copyLast == 1, then m_PSInfoBase->nChans, m_PSInfoBase->sampRateIdx, and
+* Notes:       if copyLast == 1, then dec->psInfoBase->nChans, dec->psInfoBase->sampRateIdx, and
 *                aacDecInfo->profile are not changed (it's assumed that we already
 *                set them, such as by a previous call to UnpackADTSHeader())
 *              if copyLast == 0, then the parameters we passed in are used instead
 ***********************************************************************************************************************/
-int32_t SetRawBlockParams(int32_t copyLast, int32_t nChans, int32_t sampRate, int32_t profile)
+int32_t SetRawBlockParams(AACDecoder_t* dec, int32_t copyLast, int32_t nChans, int32_t sampRate, int32_t profile)
 {
     int32_t idx;
 
     if (!copyLast) {
-        m_AACDecInfo->profile = profile;
-        m_PSInfoBase->nChans = nChans;
+        dec->aacDecInfo->profile = profile;
+        dec->psInfoBase->nChans = nChans;
         for (idx = 0; idx < NUM_SAMPLE_RATES; idx++) {
             if (sampRate == sampRateTab[idx]) {
-                m_PSInfoBase->sampRateIdx = idx;
+                dec->psInfoBase->sampRateIdx = idx;
                 break;
             }
         }
         if (idx == NUM_SAMPLE_RATES)
             return ERR_AAC_INVALID_FRAME;
     }
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_AACDecInfo->sampRate = sampRateTab[m_PSInfoBase->sampRateIdx];
+    dec->aacDecInfo->nChans = dec->psInfoBase->nChans;
+    dec->aacDecInfo->sampRate = sampRateTab[dec->psInfoBase->sampRateIdx];
 
     /* check validity of header */
-    if (m_PSInfoBase->sampRateIdx >= NUM_SAMPLE_RATES || m_PSInfoBase->sampRateIdx < 0 ||
-        m_AACDecInfo->profile != AAC_PROFILE_LC)
+    if (dec->psInfoBase->sampRateIdx >= NUM_SAMPLE_RATES || dec->psInfoBase->sampRateIdx < 0 ||
+        dec->aacDecInfo->profile != AAC_PROFILE_LC)
         return ERR_AAC_RAWBLOCK_PARAMS;
 
     return ERR_AAC_NONE;
@@ -4878,16 +4916,16 @@ int32_t SetRawBlockParams(int32_t copyLast, int32_t nChans, int32_t sampRate, in
 *
 * Return:      0 if successful, error code (< 0) if error
 ***********************************************************************************************************************/
-int32_t PrepareRawBlock()
+int32_t PrepareRawBlock(AACDecoder_t* dec)
 {
     /* syntactic element fields will be read from bitstream for each element */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    dec->aacDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->aacDecInfo->currInstTag = -1;
 
     /* fill in user-accessible data */
-    m_AACDecInfo->bitRate = 0;
-    m_AACDecInfo->sbrEnabled = 0;
+    dec->aacDecInfo->bitRate = 0;
+    dec->aacDecInfo->sbrEnabled = 0;
 
     return ERR_AAC_NONE;
 }
@@ -5056,7 +5094,7 @@ int32_t DequantBlock(int32_t *inbuf, int32_t nSamps, int32_t scale)
  *
  * Return:      0 if successful, error code (< 0) if error
  **********************************************************************************************************************/
-int32_t AACDequantize(int32_t ch)
+int32_t AACDequantize(AACDecoder_t* dec, int32_t ch)
 {
     int32_t gp, cb, sfb, win, width, nSamps, gbMask;
     int32_t *coef;
@@ -5065,21 +5103,21 @@ int32_t AACDequantize(int32_t ch)
     int16_t *scaleFactors;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
 
     if (icsInfo->winSequence == 2) {
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[dec->psInfoBase->sampRateIdx];
         nSamps = NSAMPS_SHORT;
     } else {
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[dec->psInfoBase->sampRateIdx];
         nSamps = NSAMPS_LONG;
     }
-    coef = m_PSInfoBase->coef[ch];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
-    scaleFactors = m_PSInfoBase->scaleFactors[ch];
+    coef = dec->psInfoBase->coef[ch];
+    sfbCodeBook = dec->psInfoBase->sfbCodeBook[ch];
+    scaleFactors = dec->psInfoBase->scaleFactors[ch];
 
-    m_PSInfoBase->intensityUsed[ch] = 0;
-    m_PSInfoBase->pnsUsed[ch] = 0;
+    dec->psInfoBase->intensityUsed[ch] = 0;
+    dec->psInfoBase->pnsUsed[ch] = 0;
     gbMask = 0;
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (win = 0; win < icsInfo->winGroupLen[gp]; win++) {
@@ -5092,9 +5130,9 @@ int32_t AACDequantize(int32_t ch)
                 if (cb >= 0 && cb <= 11)
                     gbMask |= DequantBlock(coef, width, scaleFactors[sfb]);
                 else if (cb == 13)
-                    m_PSInfoBase->pnsUsed[ch] = 1;
+                    dec->psInfoBase->pnsUsed[ch] = 1;
                 else if (cb == 14 || cb == 15)
-                    m_PSInfoBase->intensityUsed[ch] = 1;    /* should only happen if ch == 1 */
+                    dec->psInfoBase->intensityUsed[ch] = 1;    /* should only happen if ch == 1 */
                 coef += width;
             }
             coef += (nSamps - sfbTab[icsInfo->maxSFB]);
@@ -5102,10 +5140,10 @@ int32_t AACDequantize(int32_t ch)
         sfbCodeBook += icsInfo->maxSFB;
         scaleFactors += icsInfo->maxSFB;
     }
-    m_AACDecInfo->pnsUsed |= m_PSInfoBase->pnsUsed[ch];    /* set flag if PNS used for any channel */
+    dec->aacDecInfo->pnsUsed |= dec->psInfoBase->pnsUsed[ch];    /* set flag if PNS used for any channel */
 
     /* calculate number of guard bits in dequantized data */
-    m_PSInfoBase->gbCurrent[ch] = CLZ(gbMask) - 1;
+    dec->psInfoBase->gbCurrent[ch] = CLZ(gbMask) - 1;
 
     return ERR_AAC_NONE;
 }
@@ -5346,7 +5384,7 @@ void CopyNoiseVector(int32_t *coefL, int32_t *coefR, int32_t nVals)
  *
  * Return:      0 if successful, -1 if error
  **********************************************************************************************************************/
-int32_t PNS(int32_t ch)
+int32_t PNS(AACDecoder_t* dec, int32_t ch)
 {
     int32_t gp, sfb, win, width, nSamps, gb, gbMask;
     int32_t *coef;
@@ -5358,27 +5396,27 @@ int32_t PNS(int32_t ch)
     uint8_t *msMaskPtr;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && dec->psInfoBase->commonWin == 1) ? &(dec->psInfoBase->icsInfo[0]) : &(dec->psInfoBase->icsInfo[ch]);
 
-    if (!m_PSInfoBase->pnsUsed[ch])
+    if (!dec->psInfoBase->pnsUsed[ch])
         return 0;
 
     if (icsInfo->winSequence == 2) {
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[dec->psInfoBase->sampRateIdx];
         nSamps = NSAMPS_SHORT;
     } else {
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[dec->psInfoBase->sampRateIdx];
         nSamps = NSAMPS_LONG;
     }
-    coef = m_PSInfoBase->coef[ch];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
-    scaleFactors = m_PSInfoBase->scaleFactors[ch];
-    checkCorr = (m_AACDecInfo->currBlockID == AAC_ID_CPE && m_PSInfoBase->commonWin == 1 ? 1 : 0);
+    coef = dec->psInfoBase->coef[ch];
+    sfbCodeBook = dec->psInfoBase->sfbCodeBook[ch];
+    scaleFactors = dec->psInfoBase->scaleFactors[ch];
+    checkCorr = (dec->aacDecInfo->currBlockID == AAC_ID_CPE && dec->psInfoBase->commonWin == 1 ? 1 : 0);
 
     gbMask = 0;
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (win = 0; win < icsInfo->winGroupLen[gp]; win++) {
-            msMaskPtr = m_PSInfoBase->msMaskBits + ((gp*icsInfo->maxSFB) >> 3);
+            msMaskPtr = dec->psInfoBase->msMaskBits + ((gp*icsInfo->maxSFB) >> 3);
             msMaskOffset = ((gp*icsInfo->maxSFB) & 0x07);
             msMask = (*msMaskPtr++) >> msMaskOffset;
 
@@ -5390,20 +5428,20 @@ int32_t PNS(int32_t ch)
                          * if ch 1 has PNS enabled for this SFB but it's uncorrelated (i.e. ms_used == 0),
                          *    the copied values will be overwritten when we process ch 1
                          */
-                        GenerateNoiseVector(coef, &m_PSInfoBase->pnsLastVal, width);
-                        if (checkCorr && m_PSInfoBase->sfbCodeBook[1][gp*icsInfo->maxSFB + sfb] == 13)
-                            CopyNoiseVector(coef, m_PSInfoBase->coef[1] + (coef - m_PSInfoBase->coef[0]), width);
+                        GenerateNoiseVector(coef, &dec->psInfoBase->pnsLastVal, width);
+                        if (checkCorr && dec->psInfoBase->sfbCodeBook[1][gp*icsInfo->maxSFB + sfb] == 13)
+                            CopyNoiseVector(coef, dec->psInfoBase->coef[1] + (coef - dec->psInfoBase->coef[0]), width);
                     } else {
                         /* generate new vector if no correlation between channels */
                         genNew = 1;
-                        if (checkCorr && m_PSInfoBase->sfbCodeBook[0][gp*icsInfo->maxSFB + sfb] == 13) {
-                            if((m_PSInfoBase->msMaskPresent==1 && (msMask & 0x01)) || m_PSInfoBase->msMaskPresent == 2 )
+                        if (checkCorr && dec->psInfoBase->sfbCodeBook[0][gp*icsInfo->maxSFB + sfb] == 13) {
+                            if((dec->psInfoBase->msMaskPresent==1 && (msMask & 0x01)) || dec->psInfoBase->msMaskPresent == 2 )
                                 genNew = 0;
                         }
                         if (genNew)
-                            GenerateNoiseVector(coef, &m_PSInfoBase->pnsLastVal, width);
+                            GenerateNoiseVector(coef, &dec->psInfoBase->pnsLastVal, width);
                     }
-                    gbMask |= ScaleNoiseVector(coef, width, m_PSInfoBase->scaleFactors[ch][gp*icsInfo->maxSFB + sfb]);
+                    gbMask |= ScaleNoiseVector(coef, width, dec->psInfoBase->scaleFactors[ch][gp*icsInfo->maxSFB + sfb]);
                 }
                 coef += width;
 
@@ -5422,8 +5460,8 @@ int32_t PNS(int32_t ch)
 
     /* update guard bit count if necessary */
     gb = CLZ(gbMask) - 1;
-    if (m_PSInfoBase->gbCurrent[ch] > gb)
-        m_PSInfoBase->gbCurrent[ch] = gb;
+    if (dec->psInfoBase->gbCurrent[ch] > gb)
+        dec->psInfoBase->gbCurrent[ch] = gb;
 
     return 0;
 }
@@ -5589,7 +5627,7 @@ static const uint32_t pow14[2][4] PROGMEM = {
  *
  * Return:      0 if successful, -1 if error
  **********************************************************************************************************************/
-int32_t StereoProcess()
+int32_t StereoProcess(AACDecoder_t* dec)
 {
     ICSInfo_t *icsInfo;
     int32_t gp, win, nSamps, msMaskOffset;
@@ -5599,32 +5637,32 @@ int32_t StereoProcess()
 
 
     /* mid-side and intensity stereo require common_window == 1 (see MPEG4 spec, Correction 2, 2004) */
-    if (m_PSInfoBase->commonWin != 1 || m_AACDecInfo->currBlockID != AAC_ID_CPE)
+    if (dec->psInfoBase->commonWin != 1 || dec->aacDecInfo->currBlockID != AAC_ID_CPE)
         return 0;
 
     /* nothing to do */
-    if (!m_PSInfoBase->msMaskPresent && !m_PSInfoBase->intensityUsed[1])
+    if (!dec->psInfoBase->msMaskPresent && !dec->psInfoBase->intensityUsed[1])
         return 0;
 
-    icsInfo = &(m_PSInfoBase->icsInfo[0]);
+    icsInfo = &(dec->psInfoBase->icsInfo[0]);
     if (icsInfo->winSequence == 2) {
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[dec->psInfoBase->sampRateIdx];
         nSamps = NSAMPS_SHORT;
     } else {
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[dec->psInfoBase->sampRateIdx];
         nSamps = NSAMPS_LONG;
     }
-    coefL = m_PSInfoBase->coef[0];
-    coefR = m_PSInfoBase->coef[1];
+    coefL = dec->psInfoBase->coef[0];
+    coefR = dec->psInfoBase->coef[1];
 
     /* do fused mid-side/intensity processing for each block (one long or eight short) */
     msMaskOffset = 0;
-    msMaskPtr = m_PSInfoBase->msMaskBits;
+    msMaskPtr = dec->psInfoBase->msMaskBits;
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (win = 0; win < icsInfo->winGroupLen[gp]; win++) {
-            StereoProcessGroup(coefL, coefR, sfbTab, m_PSInfoBase->msMaskPresent,
-                msMaskPtr, msMaskOffset, icsInfo->maxSFB, m_PSInfoBase->sfbCodeBook[1] + gp*icsInfo->maxSFB,
-                m_PSInfoBase->scaleFactors[1] + gp*icsInfo->maxSFB, m_PSInfoBase->gbCurrent);
+            StereoProcessGroup(coefL, coefR, sfbTab, dec->psInfoBase->msMaskPresent,
+                msMaskPtr, msMaskOffset, icsInfo->maxSFB, dec->psInfoBase->sfbCodeBook[1] + gp*icsInfo->maxSFB,
+                dec->psInfoBase->scaleFactors[1] + gp*icsInfo->maxSFB, dec->psInfoBase->gbCurrent);
             coefL += nSamps;
             coefR += nSamps;
         }
@@ -5633,8 +5671,8 @@ int32_t StereoProcess()
         msMaskOffset = (msMaskOffset + icsInfo->maxSFB) & 0x07;
     }
 
-    ASSERT(coefL == m_PSInfoBase->coef[0] + 1024);
-    ASSERT(coefR == m_PSInfoBase->coef[1] + 1024);
+    ASSERT(coefL == dec->psInfoBase->coef[0] + 1024);
+    ASSERT(coefR == dec->psInfoBase->coef[1] + 1024);
 
     return 0;
 }
@@ -5789,7 +5827,7 @@ int32_t InvRNormalized(int32_t r)
  *
  * Return:      none
 ***********************************************************************************************************************/
-void BitReverse32(int32_t *inout)
+CODEC_HOT_FUNC void BitReverse32(int32_t *inout)
 {
     int32_t t;
     t=inout[2] ; inout[2]=inout[32]; inout[32]=t;
@@ -5848,7 +5886,7 @@ void BitReverse32(int32_t *inout)
  *              should compile with no stack spills on ARM (verify compiled output)
  *              current instruction count (per pass): 16 LDR, 16 STR, 4 SMULL, 61 ALU
  **********************************************************************************************************************/
-void R8FirstPass32(int32_t *r0)
+CODEC_HOT_FUNC void R8FirstPass32(int32_t *r0)
 {
     int32_t r1, r2, r3, r4, r5, r6, r7;
     int32_t r8, r9, r10, r11, r12, r14;
@@ -5998,7 +6036,7 @@ void R8FirstPass32(int32_t *r0)
  *              should compile with no stack spills on ARM (verify compiled output)
  *              current instruction count (per pass): 16 LDR, 16 STR, 4 SMULL, 61 ALU
  **********************************************************************************************************************/
-void R4Core32(int32_t *r0)
+CODEC_HOT_FUNC void R4Core32(int32_t *r0)
 {
     int32_t r2, r3, r4, r5, r6, r7;
     int32_t r8, r9, r10, r12, r14;
@@ -6238,13 +6276,13 @@ void CVKernel2(int32_t *XBuf, int32_t *accBuf)
  *
  * Return:      none
  **********************************************************************************************************************/
-void SetBitstreamPointer(int32_t nBytes, uint8_t *buf)
+void SetBitstreamPointer(AACDecoder_t* dec, int32_t nBytes, uint8_t *buf)
 {
     /* init bitstream */
-    m_aac_BitStreamInfo.bytePtr = buf;
-    m_aac_BitStreamInfo.iCache = 0;        /* 4-byte uint32_t */
-    m_aac_BitStreamInfo.cachedBits = 0;    /* i.e. zero bits in cache */
-    m_aac_BitStreamInfo.nBytes = nBytes;
+    dec->bsi.bytePtr = buf;
+    dec->bsi.iCache = 0;        /* 4-byte uint32_t */
+    dec->bsi.cachedBits = 0;    /* i.e. zero bits in cache */
+    dec->bsi.nBytes = nBytes;
 }
 
 /***********************************************************************************************************************
@@ -6263,27 +6301,27 @@ void SetBitstreamPointer(int32_t nBytes, uint8_t *buf)
  *              stores data as big-endian in cache, regardless of machine endian-ness
  **********************************************************************************************************************/
 //Optimized for REV16, REV32 (FB)
-inline void RefillBitstreamCache()
+inline void RefillBitstreamCache(AACDecoder_t* dec)
 {
-    int32_t nBytes = m_aac_BitStreamInfo.nBytes;
+    int32_t nBytes = dec->bsi.nBytes;
     if (nBytes >= 4) {
         /* optimize for common case, independent of machine endian-ness */
-        m_aac_BitStreamInfo.iCache  = (*m_aac_BitStreamInfo.bytePtr++) << 24;
-        m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++) << 16;
-        m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++) <<  8;
-        m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++);
+        dec->bsi.iCache  = (*dec->bsi.bytePtr++) << 24;
+        dec->bsi.iCache |= (*dec->bsi.bytePtr++) << 16;
+        dec->bsi.iCache |= (*dec->bsi.bytePtr++) <<  8;
+        dec->bsi.iCache |= (*dec->bsi.bytePtr++);
 
-        m_aac_BitStreamInfo.cachedBits = 32;
-        m_aac_BitStreamInfo.nBytes -= 4;
+        dec->bsi.cachedBits = 32;
+        dec->bsi.nBytes -= 4;
     } else {
-        m_aac_BitStreamInfo.iCache = 0;
+        dec->bsi.iCache = 0;
         while (nBytes--) {
-            m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++);
-            m_aac_BitStreamInfo.iCache <<= 8;
+            dec->bsi.iCache |= (*dec->bsi.bytePtr++);
+            dec->bsi.iCache <<= 8;
         }
-        m_aac_BitStreamInfo.iCache <<= ((3 - m_aac_BitStreamInfo.nBytes)*8);
-        m_aac_BitStreamInfo.cachedBits = 8*m_aac_BitStreamInfo.nBytes;
-        m_aac_BitStreamInfo.nBytes = 0;
+        dec->bsi.iCache <<= ((3 - dec->bsi.nBytes)*8);
+        dec->bsi.cachedBits = 8*dec->bsi.nBytes;
+        dec->bsi.nBytes = 0;
     }
 }
 
@@ -6303,24 +6341,24 @@ inline void RefillBitstreamCache()
  *              for speed, does not indicate error if you overrun bit buffer
  *              if nBits == 0, returns 0
  **********************************************************************************************************************/
-uint32_t GetBits(int32_t nBits)
+uint32_t GetBits(AACDecoder_t* dec, int32_t nBits)
 {
     uint32_t data, lowBits;
 
     nBits &= 0x1f;                          /* nBits mod 32 to avoid unpredictable results like >> by negative amount */
-    data = m_aac_BitStreamInfo.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
+    data = dec->bsi.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
     data >>= 1;                                         /* do as >> 31, >> 1 so that nBits = 0 works okay (returns 0) */
-    m_aac_BitStreamInfo.iCache <<= nBits;                    /* left-justify cache */
-    m_aac_BitStreamInfo.cachedBits -= nBits;                 /* how many bits have we drawn from the cache so far */
+    dec->bsi.iCache <<= nBits;                    /* left-justify cache */
+    dec->bsi.cachedBits -= nBits;                 /* how many bits have we drawn from the cache so far */
 
     /* if we cross an int32_t boundary, refill the cache */
-    if (m_aac_BitStreamInfo.cachedBits < 0) {
-        lowBits = -m_aac_BitStreamInfo.cachedBits;
-        RefillBitstreamCache();
-        data |= m_aac_BitStreamInfo.iCache >> (32 - lowBits);        /* get the low-order bits */
+    if (dec->bsi.cachedBits < 0) {
+        lowBits = -dec->bsi.cachedBits;
+        RefillBitstreamCache(dec);
+        data |= dec->bsi.iCache >> (32 - lowBits);        /* get the low-order bits */
 
-        m_aac_BitStreamInfo.cachedBits -= lowBits;            /* how many bits have we drawn from the cache so far */
-        m_aac_BitStreamInfo.iCache <<= lowBits;            /* left-justify cache */
+        dec->bsi.cachedBits -= lowBits;            /* how many bits have we drawn from the cache so far */
+        dec->bsi.iCache <<= lowBits;            /* left-justify cache */
     }
 
     return data;
@@ -6342,24 +6380,24 @@ uint32_t GetBits(int32_t nBits)
  *              for speed, does not indicate error if you overrun bit buffer
  *              if nBits == 0, returns 0
  **********************************************************************************************************************/
-uint32_t GetBitsNoAdvance(int32_t nBits)
+uint32_t GetBitsNoAdvance(AACDecoder_t* dec, int32_t nBits)
 {
     uint8_t *buf;
     uint32_t data, iCache;
     int32_t lowBits;
 
     nBits &= 0x1f;                          /* nBits mod 32 to avoid unpredictable results like >> by negative amount */
-    data = m_aac_BitStreamInfo.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
+    data = dec->bsi.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
     data >>= 1;                                         /* do as >> 31, >> 1 so that nBits = 0 works okay (returns 0) */
-    lowBits = nBits - m_aac_BitStreamInfo.cachedBits;        /* how many bits do we have left to read */
+    lowBits = nBits - dec->bsi.cachedBits;        /* how many bits do we have left to read */
 
     /* if we cross an int32_t boundary, read next bytes in buffer */
     if (lowBits > 0) {
         iCache = 0;
-        buf = m_aac_BitStreamInfo.bytePtr;
+        buf = dec->bsi.bytePtr;
         while (lowBits > 0) {
             iCache <<= 8;
-            if (buf < m_aac_BitStreamInfo.bytePtr + m_aac_BitStreamInfo.nBytes)
+            if (buf < dec->bsi.bytePtr + dec->bsi.nBytes)
                 iCache |= (uint32_t)*buf++;
             lowBits -= 8;
         }
@@ -6383,15 +6421,15 @@ uint32_t GetBitsNoAdvance(int32_t nBits)
  *
  * Notes:       generally used following GetBitsNoAdvance(bsi, maxBits)
  **********************************************************************************************************************/
-void AdvanceBitstream(int32_t nBits)
+void AdvanceBitstream(AACDecoder_t* dec, int32_t nBits)
 {
     nBits &= 0x1f;
-    if (nBits > m_aac_BitStreamInfo.cachedBits) {
-        nBits -= m_aac_BitStreamInfo.cachedBits;
-        RefillBitstreamCache();
+    if (nBits > dec->bsi.cachedBits) {
+        nBits -= dec->bsi.cachedBits;
+        RefillBitstreamCache(dec);
     }
-    m_aac_BitStreamInfo.iCache <<= nBits;
-    m_aac_BitStreamInfo.cachedBits -= nBits;
+    dec->bsi.iCache <<= nBits;
+    dec->bsi.cachedBits -= nBits;
 }
 
 /***********************************************************************************************************************
@@ -6406,12 +6444,12 @@ void AdvanceBitstream(int32_t nBits)
  *
  * Return:      number of bits read from bitstream, as offset from startBuf:startOffset
  **********************************************************************************************************************/
-int32_t CalcBitsUsed(uint8_t *startBuf, int32_t startOffset) {
+int32_t CalcBitsUsed(AACDecoder_t* dec, uint8_t *startBuf, int32_t startOffset) {
 
     int32_t bitsUsed;
 
-    bitsUsed  = (m_aac_BitStreamInfo.bytePtr - startBuf) * 8;
-    bitsUsed -= m_aac_BitStreamInfo.cachedBits;
+    bitsUsed  = (dec->bsi.bytePtr - startBuf) * 8;
+    bitsUsed -= dec->bsi.cachedBits;
     bitsUsed -= startOffset;
 
     return bitsUsed;
@@ -6429,12 +6467,12 @@ int32_t CalcBitsUsed(uint8_t *startBuf, int32_t startOffset) {
  *
  * Notes:       if bitstream is already byte-aligned, do nothing
  **********************************************************************************************************************/
-void ByteAlignBitstream(){
+void ByteAlignBitstream(AACDecoder_t* dec){
 
     int32_t offset;
 
-    offset = m_aac_BitStreamInfo.cachedBits & 0x07;
-    AdvanceBitstream(offset);
+    offset = dec->bsi.cachedBits & 0x07;
+    AdvanceBitstream(dec, offset);
 }
 
 #ifdef AAC_ENABLE_SBR
@@ -6450,23 +6488,23 @@ void ByteAlignBitstream(){
  *
  * Return:      none
  **************************************************************************************/
-void InitSBRState() {
+void InitSBRState(AACDecoder_t* dec) {
 
     int32_t i, ch;
     uint8_t *c;
 
-    if (!m_PSInfoSBR)
+    if (!dec->psInfoSBR)
         return;
 
     /* clear SBR state structure */
-    c = (uint8_t *)m_PSInfoSBR;
-    for (i = 0; i < (int32_t)sizeof(m_PSInfoSBR); i++)
+    c = (uint8_t *)dec->psInfoSBR;
+    for (i = 0; i < (int32_t)sizeof(dec->psInfoSBR); i++)
         *c++ = 0;
 
     /* initialize non-zero state variables */
     for (ch = 0; ch < AAC_MAX_NCHANS; ch++) {
-        m_PSInfoSBR->sbrChan[ch].reset = 1;
-        m_PSInfoSBR->sbrChan[ch].laPrev = -1;
+        dec->psInfoSBR->sbrChan[ch].reset = 1;
+        dec->psInfoSBR->sbrChan[ch].laPrev = -1;
     }
 }
 #endif
@@ -6486,54 +6524,54 @@ void InitSBRState() {
  *              returns with no error if fill buffer is not an SBR extension block,
  *                or if current block is not a fill block (e.g. for LFE upsampling)
  **********************************************************************************************************************/
-int32_t DecodeSBRBitstream(int32_t chBase) {
+int32_t DecodeSBRBitstream(AACDecoder_t* dec, int32_t chBase) {
 
     int32_t headerFlag;
 
-    if(m_AACDecInfo->currBlockID != AAC_ID_FIL
-            || (m_AACDecInfo->fillExtType != EXT_SBR_DATA && m_AACDecInfo->fillExtType != EXT_SBR_DATA_CRC))
+    if(dec->aacDecInfo->currBlockID != AAC_ID_FIL
+            || (dec->aacDecInfo->fillExtType != EXT_SBR_DATA && dec->aacDecInfo->fillExtType != EXT_SBR_DATA_CRC))
         return ERR_AAC_NONE;
 
-    SetBitstreamPointer(m_AACDecInfo->fillCount, m_AACDecInfo->fillBuf);
-    if(GetBits(4) != (uint32_t) m_AACDecInfo->fillExtType) return ERR_AAC_SBR_BITSTREAM;
+    SetBitstreamPointer(dec, dec->aacDecInfo->fillCount, dec->aacDecInfo->fillBuf);
+    if(GetBits(dec, 4) != (uint32_t) dec->aacDecInfo->fillExtType) return ERR_AAC_SBR_BITSTREAM;
 
-    if(m_AACDecInfo->fillExtType == EXT_SBR_DATA_CRC) m_PSInfoSBR->crcCheckWord = GetBits(10);
+    if(dec->aacDecInfo->fillExtType == EXT_SBR_DATA_CRC) dec->psInfoSBR->crcCheckWord = GetBits(dec, 10);
 
-    headerFlag = GetBits(1);
+    headerFlag = GetBits(dec, 1);
     if(headerFlag) {
         /* get sample rate index for output sample rate (2x base rate) */
-        m_PSInfoSBR->sampRateIdx = GetSampRateIdx(2 * m_AACDecInfo->sampRate);
-        if(m_PSInfoSBR->sampRateIdx < 0 || m_PSInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES)
+        dec->psInfoSBR->sampRateIdx = GetSampRateIdx(2 * dec->aacDecInfo->sampRate);
+        if(dec->psInfoSBR->sampRateIdx < 0 || dec->psInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES)
             return ERR_AAC_SBR_BITSTREAM;
-        else if(m_PSInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES_SBR) return ERR_AAC_SBR_SINGLERATE_UNSUPPORTED;
+        else if(dec->psInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES_SBR) return ERR_AAC_SBR_SINGLERATE_UNSUPPORTED;
 
         /* reset flag = 1 if header values changed */
-        if(UnpackSBRHeader(&(m_PSInfoSBR->sbrHdr[chBase]))) m_PSInfoSBR->sbrChan[chBase].reset = 1;
+        if(UnpackSBRHeader(dec, &(dec->psInfoSBR->sbrHdr[chBase]))) dec->psInfoSBR->sbrChan[chBase].reset = 1;
 
         /* first valid SBR header should always trigger CalcFreqTables(), since psi->reset was set in InitSBR() */
-        if(m_PSInfoSBR->sbrChan[chBase].reset)
-            CalcFreqTables(&(m_PSInfoSBR->sbrHdr[chBase + 0]), &(m_PSInfoSBR->sbrFreq[chBase]),
-                    m_PSInfoSBR->sampRateIdx);
+        if(dec->psInfoSBR->sbrChan[chBase].reset)
+            CalcFreqTables(&(dec->psInfoSBR->sbrHdr[chBase + 0]), &(dec->psInfoSBR->sbrFreq[chBase]),
+                    dec->psInfoSBR->sampRateIdx);
 
         /* copy and reset state to right channel for CPE */
-        if(m_AACDecInfo->prevBlockID == AAC_ID_CPE)
-            m_PSInfoSBR->sbrChan[chBase + 1].reset = m_PSInfoSBR->sbrChan[chBase + 0].reset;
+        if(dec->aacDecInfo->prevBlockID == AAC_ID_CPE)
+            dec->psInfoSBR->sbrChan[chBase + 1].reset = dec->psInfoSBR->sbrChan[chBase + 0].reset;
     }
 
     /* if no header has been received, upsample only */
-    if(m_PSInfoSBR->sbrHdr[chBase].count == 0) return ERR_AAC_NONE;
+    if(dec->psInfoSBR->sbrHdr[chBase].count == 0) return ERR_AAC_NONE;
 
-    if(m_AACDecInfo->prevBlockID == AAC_ID_SCE) {
-        UnpackSBRSingleChannel(chBase);
+    if(dec->aacDecInfo->prevBlockID == AAC_ID_SCE) {
+        UnpackSBRSingleChannel(dec, chBase);
     }
-    else if(m_AACDecInfo->prevBlockID == AAC_ID_CPE) {
-        UnpackSBRChannelPair(chBase);
+    else if(dec->aacDecInfo->prevBlockID == AAC_ID_CPE) {
+        UnpackSBRChannelPair(dec, chBase);
     }
     else {
         return ERR_AAC_SBR_BITSTREAM;
     }
 
-    ByteAlignBitstream();
+    ByteAlignBitstream(dec);
 
     return ERR_AAC_NONE;
 }
@@ -6555,7 +6593,7 @@ int32_t DecodeSBRBitstream(int32_t chBase) {
  *
  * Return:      0 if successful, error code (< 0) if error
  **********************************************************************************************************************/
-int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf) {
+int32_t DecodeSBRData(AACDecoder_t* dec, int32_t chBase, int16_t *outbuf) {
 
     int32_t k, l, ch, chBlock, qmfaBands, qmfsBands;
     int32_t upsampleOnly, gbIdx, gbMask;
@@ -6568,24 +6606,24 @@ int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf) {
     SBRChan *sbrChan;
 
     /* same header and freq tables for both channels in CPE */
-    sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
-    sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
+    sbrHdr = &(dec->psInfoSBR->sbrHdr[chBase]);
+    sbrFreq = &(dec->psInfoSBR->sbrFreq[chBase]);
 
     /* upsample only if we haven't received an SBR header yet or if we have an LFE block */
-    if(m_AACDecInfo->currBlockID == AAC_ID_LFE) {
+    if(dec->aacDecInfo->currBlockID == AAC_ID_LFE) {
         chBlock = 1;
         upsampleOnly = 1;
     }
-    else if(m_AACDecInfo->currBlockID == AAC_ID_FIL) {
-        if(m_AACDecInfo->prevBlockID == AAC_ID_SCE)
+    else if(dec->aacDecInfo->currBlockID == AAC_ID_FIL) {
+        if(dec->aacDecInfo->prevBlockID == AAC_ID_SCE)
             chBlock = 1;
-        else if(m_AACDecInfo->prevBlockID == AAC_ID_CPE)
+        else if(dec->aacDecInfo->prevBlockID == AAC_ID_CPE)
             chBlock = 2;
         else
             return ERR_AAC_NONE;
 
         upsampleOnly = (sbrHdr->count == 0 ? 1 : 0);
-        if(m_AACDecInfo->fillExtType != EXT_SBR_DATA && m_AACDecInfo->fillExtType != EXT_SBR_DATA_CRC)
+        if(dec->aacDecInfo->fillExtType != EXT_SBR_DATA && dec->aacDecInfo->fillExtType != EXT_SBR_DATA_CRC)
             return ERR_AAC_NONE;
     }
     else {
@@ -6599,26 +6637,26 @@ int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf) {
     }
 
     for(ch = 0; ch < chBlock; ch++) {
-        sbrGrid = &(m_PSInfoSBR->sbrGrid[chBase + ch]);
-        sbrChan = &(m_PSInfoSBR->sbrChan[chBase + ch]);
+        sbrGrid = &(dec->psInfoSBR->sbrGrid[chBase + ch]);
+        sbrChan = &(dec->psInfoSBR->sbrChan[chBase + ch]);
 
-        if(m_AACDecInfo->rawSampleBuf[ch] == 0 || m_AACDecInfo->rawSampleBytes != 4) return ERR_AAC_SBR_PCM_FORMAT;
-        inbuf = (int32_t*) m_AACDecInfo->rawSampleBuf[ch];
+        if(dec->aacDecInfo->rawSampleBuf[ch] == 0 || dec->aacDecInfo->rawSampleBytes != 4) return ERR_AAC_SBR_PCM_FORMAT;
+        inbuf = (int32_t*) dec->aacDecInfo->rawSampleBuf[ch];
         outptr = outbuf + chBase + ch;
 
         /* restore delay buffers (could use ring buffer or keep in temp buffer for nChans == 1) */
         for(l = 0; l < HF_GEN; l++) {
             for(k = 0; k < 64; k++) {
-                m_PSInfoSBR->XBuf[l][k][0] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][0];
-                m_PSInfoSBR->XBuf[l][k][1] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][1];
+                dec->psInfoSBR->XBuf[l][k][0] = dec->psInfoSBR->XBufDelay[chBase + ch][l][k][0];
+                dec->psInfoSBR->XBuf[l][k][1] = dec->psInfoSBR->XBufDelay[chBase + ch][l][k][1];
             }
         }
 
         /* step 1 - analysis QMF */
         qmfaBands = sbrFreq->kStart;
         for(l = 0; l < 32; l++) {
-            gbMask = QMFAnalysis(inbuf + l * 32, m_PSInfoSBR->delayQMFA[chBase + ch], m_PSInfoSBR->XBuf[l + HF_GEN][0],
-                    m_AACDecInfo->rawSampleFBits, &(m_PSInfoSBR->delayIdxQMFA[chBase + ch]), qmfaBands);
+            gbMask = QMFAnalysis(inbuf + l * 32, dec->psInfoSBR->delayQMFA[chBase + ch], dec->psInfoSBR->XBuf[l + HF_GEN][0],
+                    dec->aacDecInfo->rawSampleFBits, &(dec->psInfoSBR->delayIdxQMFA[chBase + ch]), qmfaBands);
 
             gbIdx = ((l + HF_GEN) >> 5) & 0x01;
             sbrChan->gbMask[gbIdx] |= gbMask; /* gbIdx = (0 if i < 32), (1 if i >= 32) */
@@ -6629,9 +6667,9 @@ int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf) {
             qmfsBands = 32;
             for(l = 0; l < 32; l++) {
                 /* step 4 - synthesis QMF */
-                QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
-                        &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
-                outptr += 64 * m_AACDecInfo->nChans;
+                QMFSynthesis(dec->psInfoSBR->XBuf[l + HF_ADJ][0], dec->psInfoSBR->delayQMFS[chBase + ch],
+                        &(dec->psInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, dec->aacDecInfo->nChans);
+                outptr += 64 * dec->aacDecInfo->nChans;
             }
         }
         else {
@@ -6642,48 +6680,48 @@ int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf) {
              */
             for(k = sbrFreq->kStartPrev; k < sbrFreq->kStart; k++) {
                 for(l = 0; l < sbrGrid->envTimeBorder[0] + HF_ADJ; l++) {
-                    m_PSInfoSBR->XBuf[l][k][0] = 0;
-                    m_PSInfoSBR->XBuf[l][k][1] = 0;
+                    dec->psInfoSBR->XBuf[l][k][0] = 0;
+                    dec->psInfoSBR->XBuf[l][k][1] = 0;
                 }
             }
 
             /* step 2 - HF generation */
-            GenerateHighFreq(sbrGrid, sbrFreq, sbrChan, ch);
+            GenerateHighFreq(dec, sbrGrid, sbrFreq, sbrChan, ch);
 
             /* restore SBR bands that were cleared before patch generation (time slots 0, 1 no longer needed) */
             for(k = sbrFreq->kStartPrev; k < sbrFreq->kStart; k++) {
                 for(l = HF_ADJ; l < sbrGrid->envTimeBorder[0] + HF_ADJ; l++) {
-                    m_PSInfoSBR->XBuf[l][k][0] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][0];
-                    m_PSInfoSBR->XBuf[l][k][1] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][1];
+                    dec->psInfoSBR->XBuf[l][k][0] = dec->psInfoSBR->XBufDelay[chBase + ch][l][k][0];
+                    dec->psInfoSBR->XBuf[l][k][1] = dec->psInfoSBR->XBufDelay[chBase + ch][l][k][1];
                 }
             }
 
             /* step 3 - HF adjustment */
-            AdjustHighFreq(sbrHdr, sbrGrid, sbrFreq, sbrChan, ch);
+            AdjustHighFreq(dec, sbrHdr, sbrGrid, sbrFreq, sbrChan, ch);
 
             /* step 4 - synthesis QMF */
             qmfsBands = sbrFreq->kStartPrev + sbrFreq->numQMFBandsPrev;
             for(l = 0; l < sbrGrid->envTimeBorder[0]; l++) {
                 /* if new envelope starts mid-frame, use old settings until start of first envelope in this frame */
-                QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
-                        &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
-                outptr += 64 * m_AACDecInfo->nChans;
+                QMFSynthesis(dec->psInfoSBR->XBuf[l + HF_ADJ][0], dec->psInfoSBR->delayQMFS[chBase + ch],
+                        &(dec->psInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, dec->aacDecInfo->nChans);
+                outptr += 64 * dec->aacDecInfo->nChans;
             }
 
             qmfsBands = sbrFreq->kStart + sbrFreq->numQMFBands;
             for(; l < 32; l++) {
                 /* use new settings for rest of frame (usually the entire frame, unless the first envelope starts mid-frame) */
-                QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
-                        &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
-                outptr += 64 * m_AACDecInfo->nChans;
+                QMFSynthesis(dec->psInfoSBR->XBuf[l + HF_ADJ][0], dec->psInfoSBR->delayQMFS[chBase + ch],
+                        &(dec->psInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, dec->aacDecInfo->nChans);
+                outptr += 64 * dec->aacDecInfo->nChans;
             }
         }
 
         /* save delay */
         for(l = 0; l < HF_GEN; l++) {
             for(k = 0; k < 64; k++) {
-                m_PSInfoSBR->XBufDelay[chBase + ch][l][k][0] = m_PSInfoSBR->XBuf[l + 32][k][0];
-                m_PSInfoSBR->XBufDelay[chBase + ch][l][k][1] = m_PSInfoSBR->XBuf[l + 32][k][1];
+                dec->psInfoSBR->XBufDelay[chBase + ch][l][k][0] = dec->psInfoSBR->XBuf[l + 32][k][0];
+                dec->psInfoSBR->XBufDelay[chBase + ch][l][k][1] = dec->psInfoSBR->XBuf[l + 32][k][1];
             }
         }
         sbrChan->gbMask[0] = sbrChan->gbMask[1];
@@ -6694,7 +6732,7 @@ int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf) {
     sbrFreq->kStartPrev = sbrFreq->kStart;
     sbrFreq->numQMFBandsPrev = sbrFreq->numQMFBands;
 
-    if(m_AACDecInfo->nChans > 0 && (chBase + ch) == m_AACDecInfo->nChans) m_PSInfoSBR->frameCount++;
+    if(dec->aacDecInfo->nChans > 0 && (chBase + ch) == dec->aacDecInfo->nChans) dec->psInfoSBR->frameCount++;
 
     return ERR_AAC_NONE;
 }
@@ -7295,7 +7333,7 @@ int32_t CalcFreqTables(SBRHeader *sbrHdr, SBRFreq *sbrFreq, int32_t sampRateIdx)
  *
  * Return:      none
  **********************************************************************************************************************/
-void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t env) {
+void EstimateEnvelope(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t env) {
 
     int32_t i, m, iStart, iEnd, xre, xim, nScale, expMax;
     int32_t p, n, mStart, mEnd, invFact, t;
@@ -7320,7 +7358,7 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
     if(sbrHdr->interpFreq) {
         for(m = 0; m < sbrFreq->numQMFBands; m++) {
             eCurr.w64 = 0;
-            XBuf = m_PSInfoSBR->XBuf[iStart][sbrFreq->kStart + m];
+            XBuf = dec->psInfoSBR->XBuf[iStart][sbrFreq->kStart + m];
             for(i = iStart; i < iEnd; i++) {
                 /* scale to int32_t before calculating power (precision not critical, and avoids overflow) */
                 xre = (*XBuf) >> FBITS_OUT_QMFA;
@@ -7349,9 +7387,9 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
             }
 
             invFact = invBandTab[(iEnd - iStart) - 1];
-            m_PSInfoSBR->eCurr[m] = MULSHIFT32(t, invFact);
-            m_PSInfoSBR->eCurrExp[m] = nScale + 1; /* +1 for invFact = Q31 */
-            if(m_PSInfoSBR->eCurrExp[m] > expMax) expMax = m_PSInfoSBR->eCurrExp[m];
+            dec->psInfoSBR->eCurr[m] = MULSHIFT32(t, invFact);
+            dec->psInfoSBR->eCurrExp[m] = nScale + 1; /* +1 for invFact = Q31 */
+            if(dec->psInfoSBR->eCurrExp[m] > expMax) expMax = dec->psInfoSBR->eCurrExp[m];
         }
     }
     else {
@@ -7360,7 +7398,7 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
             mEnd = freqBandTab[p + 1];
             eCurr.w64 = 0;
             for(i = iStart; i < iEnd; i++) {
-                XBuf = m_PSInfoSBR->XBuf[i][mStart];
+                XBuf = dec->psInfoSBR->XBuf[i][mStart];
                 for(m = mStart; m < mEnd; m++) {
                     xre = (*XBuf++) >> FBITS_OUT_QMFA;
                     xim = (*XBuf++) >> FBITS_OUT_QMFA;
@@ -7388,14 +7426,14 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
             t = MULSHIFT32(t, invFact);
 
             for(m = mStart; m < mEnd; m++) {
-                m_PSInfoSBR->eCurr[m - sbrFreq->kStart] = t;
-                m_PSInfoSBR->eCurrExp[m - sbrFreq->kStart] = nScale + 1; /* +1 for invFact = Q31 */
+                dec->psInfoSBR->eCurr[m - sbrFreq->kStart] = t;
+                dec->psInfoSBR->eCurrExp[m - sbrFreq->kStart] = nScale + 1; /* +1 for invFact = Q31 */
             }
-            if(m_PSInfoSBR->eCurrExp[mStart - sbrFreq->kStart] > expMax)
-                expMax = m_PSInfoSBR->eCurrExp[mStart - sbrFreq->kStart];
+            if(dec->psInfoSBR->eCurrExp[mStart - sbrFreq->kStart] > expMax)
+                expMax = dec->psInfoSBR->eCurrExp[mStart - sbrFreq->kStart];
         }
     }
-    m_PSInfoSBR->eCurrExpMax = expMax;
+    dec->psInfoSBR->eCurrExpMax = expMax;
 }
 /***********************************************************************************************************************
  * Function:    GetSMapped
@@ -7463,7 +7501,7 @@ static const uint32_t limGainTab[4] PROGMEM = {0x20138ca7, 0x40000000, 0x7fb27dc
  *
  * Return:      none
  **********************************************************************************************************************/
-void CalcMaxGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ) {
+void CalcMaxGain(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ) {
 
     int32_t m, mStart, mEnd, q, z, r;
     int32_t sumEOrigMapped, sumECurr, gainMax, eOMGainMax, envBand;
@@ -7477,28 +7515,28 @@ void CalcMaxGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t
     /* calculate max gain to apply to signal in this limiter band */
     sumECurr = 0;
     sumEOrigMapped = 0;
-    eCurrExpMax = m_PSInfoSBR->eCurrExpMax;
-    eOMGainMax = m_PSInfoSBR->eOMGainMax;
-    envBand = m_PSInfoSBR->envBand;
+    eCurrExpMax = dec->psInfoSBR->eCurrExpMax;
+    eOMGainMax = dec->psInfoSBR->eOMGainMax;
+    envBand = dec->psInfoSBR->envBand;
     for(m = mStart; m < mEnd; m++) {
         /* map current QMF band to appropriate envelope band */
         if(m == freqBandTab[envBand + 1] - sbrFreq->kStart) {
             envBand++;
-            eOMGainMax = m_PSInfoSBR->envDataDequant[ch][env][envBand] >> ACC_SCALE; /* summing max 48 bands */
+            eOMGainMax = dec->psInfoSBR->envDataDequant[ch][env][envBand] >> ACC_SCALE; /* summing max 48 bands */
         }
         sumEOrigMapped += eOMGainMax;
 
         /* easy test for overflow on ARM */
-        sumECurr += (m_PSInfoSBR->eCurr[m] >> (eCurrExpMax - m_PSInfoSBR->eCurrExp[m]));
+        sumECurr += (dec->psInfoSBR->eCurr[m] >> (eCurrExpMax - dec->psInfoSBR->eCurrExp[m]));
         if(sumECurr >> 30) {
             sumECurr >>= 1;
             eCurrExpMax++;
         }
     }
-    m_PSInfoSBR->eOMGainMax = eOMGainMax;
-    m_PSInfoSBR->envBand = envBand;
+    dec->psInfoSBR->eOMGainMax = eOMGainMax;
+    dec->psInfoSBR->envBand = envBand;
 
-    m_PSInfoSBR->gainMaxFBits = 30; /* Q30 tables */
+    dec->psInfoSBR->gainMaxFBits = 30; /* Q30 tables */
     if(sumECurr == 0) {
         /* any non-zero numerator * 1/EPS_0 is > G_MAX */
         gainMax = (sumEOrigMapped == 0 ? (int32_t) limGainTab[sbrHdr->limiterGains] : (int32_t) 0x80000000);
@@ -7515,11 +7553,11 @@ void CalcMaxGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t
             z = CLZ(sumECurr) - 1;
             r = InvRNormalized(sumECurr << z); /* in =  Q(z - eCurrExpMax), out = Q(29 + 31 - z + eCurrExpMax) */
             gainMax = MULSHIFT32(q, r); /* Q(29 + 31 - z + eCurrExpMax + fbitsDQ - ACC_SCALE - 2 - 32) */
-            m_PSInfoSBR->gainMaxFBits = 26 - z + eCurrExpMax + fbitsDQ - ACC_SCALE;
+            dec->psInfoSBR->gainMaxFBits = 26 - z + eCurrExpMax + fbitsDQ - ACC_SCALE;
         }
     }
-    m_PSInfoSBR->sumEOrigMapped = sumEOrigMapped;
-    m_PSInfoSBR->gainMax = gainMax;
+    dec->psInfoSBR->sumEOrigMapped = sumEOrigMapped;
+    dec->psInfoSBR->gainMax = gainMax;
 }
 /***********************************************************************************************************************
  * Function:    CalcNoiseDivFactors
@@ -7570,7 +7608,7 @@ void CalcNoiseDivFactors(int32_t q, int32_t *qp1Inv, int32_t *qqp1Inv) {
  *
  * Return:      none
  **********************************************************************************************************************/
-void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ) {
+void CalcComponentGains(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ) {
 
     int32_t d, m, mStart, mEnd, q, qm, noiseFloor, sIndexMapped;
     int32_t shift, eCurr, maxFlag, gainMax, gainMaxFBits;
@@ -7580,40 +7618,40 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
     mStart = sbrFreq->freqLimiter[lim]; /* these are offsets from kStart */
     mEnd = sbrFreq->freqLimiter[lim + 1];
 
-    gainMax = m_PSInfoSBR->gainMax;
-    gainMaxFBits = m_PSInfoSBR->gainMaxFBits;
+    gainMax = dec->psInfoSBR->gainMax;
+    gainMaxFBits = dec->psInfoSBR->gainMaxFBits;
 
-    d = (env == m_PSInfoSBR->la || env == sbrChan->laPrev ? 0 : 1);
+    d = (env == dec->psInfoSBR->la || env == sbrChan->laPrev ? 0 : 1);
     freqBandTab = (sbrGrid->freqRes[env] ? sbrFreq->freqHigh : sbrFreq->freqLow);
 
     /* figure out which noise floor this envelope is in (only 1 or 2 noise floors allowed) */
     noiseFloor = 0;
     if(sbrGrid->numNoiseFloors == 2 && sbrGrid->noiseTimeBorder[1] <= sbrGrid->envTimeBorder[env]) noiseFloor++;
 
-    m_PSInfoSBR->sumECurrGLim = 0;
-    m_PSInfoSBR->sumSM = 0;
-    m_PSInfoSBR->sumQM = 0;
+    dec->psInfoSBR->sumECurrGLim = 0;
+    dec->psInfoSBR->sumSM = 0;
+    dec->psInfoSBR->sumQM = 0;
     /* calculate energy of noise to add in this limiter band */
     for(m = mStart; m < mEnd; m++) {
-        if(m == sbrFreq->freqNoise[m_PSInfoSBR->noiseFloorBand + 1] - sbrFreq->kStart) {
+        if(m == sbrFreq->freqNoise[dec->psInfoSBR->noiseFloorBand + 1] - sbrFreq->kStart) {
             /* map current QMF band to appropriate noise floor band (NOTE: freqLimiter[0] == freqLow[0] = freqHigh[0]) */
-            m_PSInfoSBR->noiseFloorBand++;
-            CalcNoiseDivFactors(m_PSInfoSBR->noiseDataDequant[ch][noiseFloor][m_PSInfoSBR->noiseFloorBand],
-                    &(m_PSInfoSBR->qp1Inv), &(m_PSInfoSBR->qqp1Inv));
+            dec->psInfoSBR->noiseFloorBand++;
+            CalcNoiseDivFactors(dec->psInfoSBR->noiseDataDequant[ch][noiseFloor][dec->psInfoSBR->noiseFloorBand],
+                    &(dec->psInfoSBR->qp1Inv), &(dec->psInfoSBR->qqp1Inv));
         }
-        if(m == sbrFreq->freqHigh[m_PSInfoSBR->highBand + 1] - sbrFreq->kStart) m_PSInfoSBR->highBand++;
-        if(m == freqBandTab[m_PSInfoSBR->sBand + 1] - sbrFreq->kStart) {
-            m_PSInfoSBR->sBand++;
-            m_PSInfoSBR->sMapped = GetSMapped(sbrGrid, sbrFreq, sbrChan, env, m_PSInfoSBR->sBand, m_PSInfoSBR->la);
+        if(m == sbrFreq->freqHigh[dec->psInfoSBR->highBand + 1] - sbrFreq->kStart) dec->psInfoSBR->highBand++;
+        if(m == freqBandTab[dec->psInfoSBR->sBand + 1] - sbrFreq->kStart) {
+            dec->psInfoSBR->sBand++;
+            dec->psInfoSBR->sMapped = GetSMapped(sbrGrid, sbrFreq, sbrChan, env, dec->psInfoSBR->sBand, dec->psInfoSBR->la);
         }
 
         /* get sIndexMapped for this QMF subband */
         sIndexMapped = 0;
-        r = ((sbrFreq->freqHigh[m_PSInfoSBR->highBand + 1] + sbrFreq->freqHigh[m_PSInfoSBR->highBand]) >> 1);
+        r = ((sbrFreq->freqHigh[dec->psInfoSBR->highBand + 1] + sbrFreq->freqHigh[dec->psInfoSBR->highBand]) >> 1);
         if(m + sbrFreq->kStart == r) {
             /* r = center frequency, deltaStep = (env >= la || sIndexMapped'(r, numEnv'-1) == 1) */
-            if(env >= m_PSInfoSBR->la || sbrChan->addHarmonic[0][r] == 1) sIndexMapped =
-                    sbrChan->addHarmonic[1][m_PSInfoSBR->highBand];
+            if(env >= dec->psInfoSBR->la || sbrChan->addHarmonic[0][r] == 1) sIndexMapped =
+                    sbrChan->addHarmonic[1][dec->psInfoSBR->highBand];
         }
 
         /* save sine flags from last envelope in this frame:
@@ -7624,27 +7662,27 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
          */
         if(env == sbrGrid->numEnv - 1) {
             if(m + sbrFreq->kStart == r)
-                sbrChan->addHarmonic[0][m + sbrFreq->kStart] = sbrChan->addHarmonic[1][m_PSInfoSBR->highBand];
+                sbrChan->addHarmonic[0][m + sbrFreq->kStart] = sbrChan->addHarmonic[1][dec->psInfoSBR->highBand];
             else
                 sbrChan->addHarmonic[0][m + sbrFreq->kStart] = 0;
         }
 
-        gain = m_PSInfoSBR->envDataDequant[ch][env][m_PSInfoSBR->sBand];
-        qm = MULSHIFT32(gain, m_PSInfoSBR->qqp1Inv) << 1;
-        sm = (sIndexMapped ? MULSHIFT32(gain, m_PSInfoSBR->qp1Inv) << 1 : 0);
+        gain = dec->psInfoSBR->envDataDequant[ch][env][dec->psInfoSBR->sBand];
+        qm = MULSHIFT32(gain, dec->psInfoSBR->qqp1Inv) << 1;
+        sm = (sIndexMapped ? MULSHIFT32(gain, dec->psInfoSBR->qp1Inv) << 1 : 0);
 
         /* three cases: (sMapped == 0 && delta == 1), (sMapped == 0 && delta == 0), (sMapped == 1) */
-        if(d == 1 && m_PSInfoSBR->sMapped == 0)
-            gain = MULSHIFT32(m_PSInfoSBR->qp1Inv, gain) << 1;
-        else if(m_PSInfoSBR->sMapped != 0) gain = MULSHIFT32(m_PSInfoSBR->qqp1Inv, gain) << 1;
+        if(d == 1 && dec->psInfoSBR->sMapped == 0)
+            gain = MULSHIFT32(dec->psInfoSBR->qp1Inv, gain) << 1;
+        else if(dec->psInfoSBR->sMapped != 0) gain = MULSHIFT32(dec->psInfoSBR->qqp1Inv, gain) << 1;
 
         /* gain, qm, sm = Q(fbitsDQ), gainMax = Q(fbitsGainMax) */
-        eCurr = m_PSInfoSBR->eCurr[m];
+        eCurr = dec->psInfoSBR->eCurr[m];
         if(eCurr) {
             z = CLZ(eCurr) - 1;
             r = InvRNormalized(eCurr << z); /* in = Q(z - eCurrExp), out = Q(29 + 31 - z + eCurrExp) */
             gainScale = MULSHIFT32(gain, r); /* out = Q(29 + 31 - z + eCurrExp + fbitsDQ - 32) */
-            fbitsGain = 29 + 31 - z + m_PSInfoSBR->eCurrExp[m] + fbitsDQ - 32;
+            fbitsGain = 29 + 31 - z + dec->psInfoSBR->eCurrExp[m] + fbitsDQ - 32;
         }
         else {
             /* if eCurr == 0, then gain is unchanged (divide by EPS = 1) */
@@ -7688,25 +7726,25 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
 
             qm = MULSHIFT32(qm, r) << 2;
             gain = MULSHIFT32(gain, r) << 2;
-            m_PSInfoSBR->gLimBuf[m] = gainMax;
-            m_PSInfoSBR->gLimFbits[m] = gainMaxFBits;
+            dec->psInfoSBR->gLimBuf[m] = gainMax;
+            dec->psInfoSBR->gLimFbits[m] = gainMaxFBits;
         }
         else {
-            m_PSInfoSBR->gLimBuf[m] = gainScale;
-            m_PSInfoSBR->gLimFbits[m] = fbitsGain;
+            dec->psInfoSBR->gLimBuf[m] = gainScale;
+            dec->psInfoSBR->gLimFbits[m] = fbitsGain;
         }
 
         /* sumSM, sumQM, sumECurrGLim = Q(fbitsDQ - ACC_SCALE) */
-        m_PSInfoSBR->smBuf[m] = sm;
-        m_PSInfoSBR->sumSM += (sm >> ACC_SCALE);
+        dec->psInfoSBR->smBuf[m] = sm;
+        dec->psInfoSBR->sumSM += (sm >> ACC_SCALE);
 
-        m_PSInfoSBR->qmLimBuf[m] = qm;
-        if(env != m_PSInfoSBR->la && env != sbrChan->laPrev && sm == 0) m_PSInfoSBR->sumQM += (qm >> ACC_SCALE);
+        dec->psInfoSBR->qmLimBuf[m] = qm;
+        if(env != dec->psInfoSBR->la && env != sbrChan->laPrev && sm == 0) dec->psInfoSBR->sumQM += (qm >> ACC_SCALE);
 
         /* eCurr * gain^2 same as gain^2, before division by eCurr
          * (but note that gain != 0 even if eCurr == 0, since it's divided by eps)
          */
-        if(eCurr) m_PSInfoSBR->sumECurrGLim += (gain >> ACC_SCALE);
+        if(eCurr) dec->psInfoSBR->sumECurrGLim += (gain >> ACC_SCALE);
     }
 }
 /***********************************************************************************************************************
@@ -7728,7 +7766,7 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
  *
  * Notes:       after scaling, each component has at least 1 GB
  **********************************************************************************************************************/
-void ApplyBoost(SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ) {
+void ApplyBoost(AACDecoder_t* dec, SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ) {
 
     int32_t m, mStart, mEnd, q, z, r;
     int32_t sumEOrigMapped, gBoost;
@@ -7736,8 +7774,8 @@ void ApplyBoost(SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ) {
     mStart = sbrFreq->freqLimiter[lim]; /* these are offsets from kStart */
     mEnd = sbrFreq->freqLimiter[lim + 1];
 
-    sumEOrigMapped = m_PSInfoSBR->sumEOrigMapped >> 1;
-    r = (m_PSInfoSBR->sumECurrGLim >> 1) + (m_PSInfoSBR->sumSM >> 1) + (m_PSInfoSBR->sumQM >> 1); /* 1 GB fine (sm and qm are mutually exclusive in acc) */
+    sumEOrigMapped = dec->psInfoSBR->sumEOrigMapped >> 1;
+    r = (dec->psInfoSBR->sumECurrGLim >> 1) + (dec->psInfoSBR->sumSM >> 1) + (dec->psInfoSBR->sumQM >> 1); /* 1 GB fine (sm and qm are mutually exclusive in acc) */
     if(r < (1 << (31 - 28))) {
         /* any non-zero numerator * 1/EPS_0 is > GBOOST_MAX
          * round very small r to zero to avoid scaling problems
@@ -7773,40 +7811,40 @@ void ApplyBoost(SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ) {
          *   unless limiterGains == 3 (limiter off) and eCurr ~= 0 (i.e. huge gain, but only
          *   because the envelope has 0 power anyway)
          */
-        q = MULSHIFT32(m_PSInfoSBR->gLimBuf[m], gBoost) << 2; /* Q(gLimFbits) * Q(28) --> Q(gLimFbits[m]-2) */
-        r = SqrtFix(q, m_PSInfoSBR->gLimFbits[m] - 2, &z);
+        q = MULSHIFT32(dec->psInfoSBR->gLimBuf[m], gBoost) << 2; /* Q(gLimFbits) * Q(28) --> Q(gLimFbits[m]-2) */
+        r = SqrtFix(q, dec->psInfoSBR->gLimFbits[m] - 2, &z);
         z -= FBITS_GLIM_BOOST;
         if(z >= 0) {
-            m_PSInfoSBR->gLimBoost[m] = r >> MIN(z, (int32_t)31);
+            dec->psInfoSBR->gLimBoost[m] = r >> MIN(z, (int32_t)31);
         }
         else {
             z = MIN((int32_t)30, -z);
             r = CLIP_2N_SHIFT30(r, z);
-            m_PSInfoSBR->gLimBoost[m] = r;
+            dec->psInfoSBR->gLimBoost[m] = r;
         }
 
-        q = MULSHIFT32(m_PSInfoSBR->qmLimBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
+        q = MULSHIFT32(dec->psInfoSBR->qmLimBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
         r = SqrtFix(q, fbitsDQ - 2, &z);
         z -= FBITS_QLIM_BOOST; /* << by 14, since integer sqrt of x < 2^16, and we want to leave 1 GB */
         if(z >= 0) {
-            m_PSInfoSBR->qmLimBoost[m] = r >> MIN((int32_t)31, z);
+            dec->psInfoSBR->qmLimBoost[m] = r >> MIN((int32_t)31, z);
         }
         else {
             z = MIN((int32_t)30, -z);
             r = CLIP_2N_SHIFT30(r, z);
-            m_PSInfoSBR->qmLimBoost[m] = r;
+            dec->psInfoSBR->qmLimBoost[m] = r;
         }
 
-        q = MULSHIFT32(m_PSInfoSBR->smBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
+        q = MULSHIFT32(dec->psInfoSBR->smBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
         r = SqrtFix(q, fbitsDQ - 2, &z);
         z -= FBITS_OUT_QMFA; /* justify for adding to signal (xBuf) later */
         if(z >= 0) {
-            m_PSInfoSBR->smBoost[m] = r >> MIN((int32_t)31, z);
+            dec->psInfoSBR->smBoost[m] = r >> MIN((int32_t)31, z);
         }
         else {
             z = MIN((int32_t)30, -z);
             r = CLIP_2N_SHIFT30(r, z);
-            m_PSInfoSBR->smBoost[m] = r;
+            dec->psInfoSBR->smBoost[m] = r;
         }
     }
 }
@@ -7827,22 +7865,22 @@ void ApplyBoost(SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ) {
  *
  * Return:      none
  **********************************************************************************************************************/
-void CalcGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env) {
+void CalcGain(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env) {
 
     int32_t lim, fbitsDQ;
 
     /* initialize to -1 so that mapping limiter bands to env/noise bands works right on first pass */
-    m_PSInfoSBR->envBand = -1;
-    m_PSInfoSBR->noiseFloorBand = -1;
-    m_PSInfoSBR->sBand = -1;
-    m_PSInfoSBR->highBand = -1;
+    dec->psInfoSBR->envBand = -1;
+    dec->psInfoSBR->noiseFloorBand = -1;
+    dec->psInfoSBR->sBand = -1;
+    dec->psInfoSBR->highBand = -1;
 
-    fbitsDQ = (FBITS_OUT_DQ_ENV - m_PSInfoSBR->envDataDequantScale[ch][env]); /* Q(29 - optional scalefactor) */
+    fbitsDQ = (FBITS_OUT_DQ_ENV - dec->psInfoSBR->envDataDequantScale[ch][env]); /* Q(29 - optional scalefactor) */
     for(lim = 0; lim < sbrFreq->nLimiter; lim++) {
         /* the QMF bands are divided into lim regions (consecutive, non-overlapping) */
-        CalcMaxGain(sbrHdr, sbrGrid, sbrFreq, ch, env, lim, fbitsDQ);
-        CalcComponentGains(sbrGrid, sbrFreq, sbrChan, ch, env, lim, fbitsDQ);
-        ApplyBoost(sbrFreq, lim, fbitsDQ);
+        CalcMaxGain(dec, sbrHdr, sbrGrid, sbrFreq, ch, env, lim, fbitsDQ);
+        CalcComponentGains(dec, sbrGrid, sbrFreq, sbrChan, ch, env, lim, fbitsDQ);
+        ApplyBoost(dec, sbrFreq, lim, fbitsDQ);
     }
 }
 
@@ -7870,7 +7908,7 @@ static const int32_t hSmoothCoef[MAX_NUM_SMOOTH_COEFS] PROGMEM = { 0x2aaaaaab, 0
  * Notes:       ensures that output has >= MIN_GBITS_IN_QMFS guard bits,
  *                so it's not necessary to check anything in the synth QMF
  **********************************************************************************************************************/
-void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t env, int32_t hfReset) {
+void MapHF(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t env, int32_t hfReset) {
 
     int32_t noiseTabIndex, sinIndex, gainNoiseIndex, hSL;
     int32_t i, iStart, iEnd, m, idx, j, s, n, smre, smim;
@@ -7887,8 +7925,8 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
     if(hfReset) {
         for(i = 0; i < hSL; i++) {
             for(m = 0; m < sbrFreq->numQMFBands; m++) {
-                sbrChan->gTemp[gainNoiseIndex][m] = m_PSInfoSBR->gLimBoost[m];
-                sbrChan->qTemp[gainNoiseIndex][m] = m_PSInfoSBR->qmLimBoost[m];
+                sbrChan->gTemp[gainNoiseIndex][m] = dec->psInfoSBR->gLimBoost[m];
+                sbrChan->qTemp[gainNoiseIndex][m] = dec->psInfoSBR->qmLimBoost[m];
             }
             gainNoiseIndex++;
             if(gainNoiseIndex == MAX_NUM_SMOOTH_COEFS) gainNoiseIndex = 0;
@@ -7904,27 +7942,27 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
          */
         if(i - iStart < MAX_NUM_SMOOTH_COEFS) {
             for(m = 0; m < sbrFreq->numQMFBands; m++) {
-                sbrChan->gTemp[gainNoiseIndex][m] = m_PSInfoSBR->gLimBoost[m];
-                sbrChan->qTemp[gainNoiseIndex][m] = m_PSInfoSBR->qmLimBoost[m];
+                sbrChan->gTemp[gainNoiseIndex][m] = dec->psInfoSBR->gLimBoost[m];
+                sbrChan->qTemp[gainNoiseIndex][m] = dec->psInfoSBR->qmLimBoost[m];
             }
         }
 
         /* see 4.6.18.7.6 */
-        XBuf = m_PSInfoSBR->XBuf[i + HF_ADJ][sbrFreq->kStart];
+        XBuf = dec->psInfoSBR->XBuf[i + HF_ADJ][sbrFreq->kStart];
         gbMask = 0;
         for(m = 0; m < sbrFreq->numQMFBands; m++) {
-            if(env == m_PSInfoSBR->la || env == sbrChan->laPrev) {
+            if(env == dec->psInfoSBR->la || env == sbrChan->laPrev) {
                 /* no smoothing filter for gain, and qFilt = 0 (only need to do once) */
                 if(i == iStart) {
-                    m_PSInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
-                    m_PSInfoSBR->qFiltLast[m] = 0;
+                    dec->psInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
+                    dec->psInfoSBR->qFiltLast[m] = 0;
                 }
             }
             else if(hSL == 0) {
                 /* no smoothing filter for gain, (only need to do once) */
                 if(i == iStart) {
-                    m_PSInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
-                    m_PSInfoSBR->qFiltLast[m] = sbrChan->qTemp[gainNoiseIndex][m];
+                    dec->psInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
+                    dec->psInfoSBR->qFiltLast[m] = sbrChan->qTemp[gainNoiseIndex][m];
                 }
             }
             else {
@@ -7940,14 +7978,14 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
                         idx--;
                         if(idx < 0) idx += MAX_NUM_SMOOTH_COEFS;
                     }
-                    m_PSInfoSBR->gFiltLast[m] = gFilt << 1; /* restore to Q(FBITS_GLIM_BOOST) (gain of filter < 1.0, so no overflow) */
-                    m_PSInfoSBR->qFiltLast[m] = qFilt << 1; /* restore to Q(FBITS_QLIM_BOOST) */
+                    dec->psInfoSBR->gFiltLast[m] = gFilt << 1; /* restore to Q(FBITS_GLIM_BOOST) (gain of filter < 1.0, so no overflow) */
+                    dec->psInfoSBR->qFiltLast[m] = qFilt << 1; /* restore to Q(FBITS_QLIM_BOOST) */
                 }
             }
 
-            if(m_PSInfoSBR->smBoost[m] != 0) {
+            if(dec->psInfoSBR->smBoost[m] != 0) {
                 /* add scaled signal and sinusoid, don't add noise (qFilt = 0) */
-                smre = m_PSInfoSBR->smBoost[m];
+                smre = dec->psInfoSBR->smBoost[m];
                 smim = smre;
 
                 /* sinIndex:  [0] xre += sm   [1] xim += sm*s   [2] xre -= sm   [3] xim -= sm*s  */
@@ -7969,7 +8007,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
             }
             else {
                 /* add scaled signal and scaled noise */
-                qFilt = m_PSInfoSBR->qFiltLast[m];
+                qFilt = dec->psInfoSBR->qFiltLast[m];
                 n = noiseTab[noiseTabIndex++];
                 smre = MULSHIFT32(n, qFilt) >> (FBITS_QLIM_BOOST - 1 - FBITS_OUT_QMFA);
 
@@ -7978,7 +8016,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
             }
             noiseTabIndex &= 1023; /* 512 complex numbers */
 
-            gFilt = m_PSInfoSBR->gFiltLast[m];
+            gFilt = dec->psInfoSBR->gFiltLast[m];
             xre = MULSHIFT32(gFilt, XBuf[0]);
             xim = MULSHIFT32(gFilt, XBuf[1]);
             xre = CLIP_2N_SHIFT30(xre, 32 - FBITS_GLIM_BOOST);
@@ -8003,7 +8041,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
          * almost never occurs in practice, but checking here makes synth QMF logic very simple
          */
         if(gbMask >> (31 - MIN_GBITS_IN_QMFS)) {
-            XBuf = m_PSInfoSBR->XBuf[i + HF_ADJ][sbrFreq->kStart];
+            XBuf = dec->psInfoSBR->XBuf[i + HF_ADJ][sbrFreq->kStart];
             for(m = 0; m < sbrFreq->numQMFBands; m++) {
                 xre = XBuf[0];
                 xim = XBuf[1];
@@ -8036,7 +8074,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
  *
  * Return:      none
  **********************************************************************************************************************/
-void AdjustHighFreq(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
+void AdjustHighFreq(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
 
     int32_t i, env, hfReset;
     uint8_t frameClass, pointer;
@@ -8046,18 +8084,18 @@ void AdjustHighFreq(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRCh
 
     /* derive la from table 4.159 */
     if ((frameClass == SBR_GRID_FIXVAR || frameClass == SBR_GRID_VARVAR) && pointer > 0)
-        m_PSInfoSBR->la = sbrGrid->numEnv + 1 - pointer;
+        dec->psInfoSBR->la = sbrGrid->numEnv + 1 - pointer;
     else if (frameClass == SBR_GRID_VARFIX && pointer > 1)
-        m_PSInfoSBR->la = pointer - 1;
+        dec->psInfoSBR->la = pointer - 1;
     else
-        m_PSInfoSBR->la = -1;
+        dec->psInfoSBR->la = -1;
 
     /* for each envelope, estimate gain and adjust SBR QMF bands */
     hfReset = sbrChan->reset;
     for (env = 0; env < sbrGrid->numEnv; env++) {
-        EstimateEnvelope(sbrHdr, sbrGrid, sbrFreq, env);
-        CalcGain(sbrHdr, sbrGrid, sbrFreq, sbrChan, ch, env);
-        MapHF(sbrHdr, sbrGrid, sbrFreq, sbrChan, env, hfReset);
+        EstimateEnvelope(dec, sbrHdr, sbrGrid, sbrFreq, env);
+        CalcGain(dec, sbrHdr, sbrGrid, sbrFreq, sbrChan, ch, env);
+        MapHF(dec, sbrHdr, sbrGrid, sbrFreq, sbrChan, env, hfReset);
         hfReset = 0;    /* only set for first envelope after header reset */
     }
 
@@ -8069,7 +8107,7 @@ void AdjustHighFreq(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRCh
     sbrChan->addHarmonicFlag[0] = sbrChan->addHarmonicFlag[1];
 
     /* save la for next frame */
-    if (m_PSInfoSBR->la == sbrGrid->numEnv)
+    if (dec->psInfoSBR->la == sbrGrid->numEnv)
         sbrChan->laPrev = 0;
     else
         sbrChan->laPrev = -1;
@@ -8365,7 +8403,7 @@ void CalcLPCoefs(int32_t *XBuf, int32_t *a0re, int32_t *a0im, int32_t *a1re, int
  *
  * Return:      none
  **********************************************************************************************************************/
-void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
+void GenerateHighFreq(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
 
     int32_t band, newBW, c, t, gb, gbMask, gbIdx;
     int32_t currPatch, p, x, k, g, i, iStart, iEnd, bw, bwsq;
@@ -8419,16 +8457,16 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int3
             }
 
             p = sbrFreq->patchStartSubband[currPatch] + x;  /* low QMF band */
-            XBufHi = m_PSInfoSBR->XBuf[iStart][k];
+            XBufHi = dec->psInfoSBR->XBuf[iStart][k];
             if (bw) {
-                CalcLPCoefs(m_PSInfoSBR->XBuf[0][p], &a0re, &a0im, &a1re, &a1im, gb);
+                CalcLPCoefs(dec->psInfoSBR->XBuf[0][p], &a0re, &a0im, &a1re, &a1im, gb);
 
                 a0re = MULSHIFT32(bw, a0re);    /* Q31 * Q29 = Q28 */
                 a0im = MULSHIFT32(bw, a0im);
                 a1re = MULSHIFT32(bwsq, a1re);
                 a1im = MULSHIFT32(bwsq, a1im);
 
-                XBufLo = m_PSInfoSBR->XBuf[iStart-2][p];
+                XBufLo = dec->psInfoSBR->XBuf[iStart-2][p];
 
                 x2re = XBufLo[0];   /* RE{XBuf[n-2]} */
                 x2im = XBufLo[1];   /* IM{XBuf[n-2]} */
@@ -8470,7 +8508,7 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int3
                     sbrChan->gbMask[gbIdx] |= gbMask;
                 }
             } else {
-                XBufLo = (int32_t *)m_PSInfoSBR->XBuf[iStart][p];
+                XBufLo = (int32_t *)dec->psInfoSBR->XBuf[iStart][p];
                 for (i = iStart; i < iEnd; i++) {
                     XBufHi[0] = XBufLo[0];
                     XBufHi[1] = XBufLo[1];
@@ -8538,7 +8576,7 @@ int32_t DecodeHuffmanScalar(const int16_t *huffTab, const HuffInfo_t *huffTabInf
  *
  * Return:      one decoded symbol
  **********************************************************************************************************************/
-int32_t DecodeOneSymbol(int32_t huffTabIndex) {
+int32_t DecodeOneSymbol(AACDecoder_t* dec, int32_t huffTabIndex) {
 
     int32_t nBits, val;
     uint32_t bitBuf;
@@ -8546,9 +8584,9 @@ int32_t DecodeOneSymbol(int32_t huffTabIndex) {
 
     hi = &(huffTabSBRInfo[huffTabIndex]);
 
-    bitBuf = GetBitsNoAdvance(hi->maxBits) << (32 - hi->maxBits);
+    bitBuf = GetBitsNoAdvance(dec, hi->maxBits) << (32 - hi->maxBits);
     nBits = DecodeHuffmanScalar(huffTabSBR, hi, bitBuf, &val);
-    AdvanceBitstream(nBits);
+    AdvanceBitstream(dec, nBits);
 
     return val;
 }
@@ -8672,12 +8710,12 @@ void DequantizeNoise(int32_t nBands, int8_t *noiseQuant, int32_t *noiseDequant)
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
+void DecodeSBREnvelope(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
 
     int32_t huffIndexTime, huffIndexFreq, env, envStartBits, band, nBands, sf, lastEnv;
     int32_t freqRes, freqResPrev, dShift, i;
 
-    if(m_PSInfoSBR->couplingFlag && ch) {
+    if(dec->psInfoSBR->couplingFlag && ch) {
         dShift = 1;
         if(sbrGrid->ampResFrame) {
             huffIndexTime = HuffTabSBR_tEnv30b;
@@ -8716,24 +8754,24 @@ void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
 
         if(sbrChan->deltaFlagEnv[env] == 0) {
             /* delta coding in freq */
-            sf = GetBits(envStartBits) << dShift;
+            sf = GetBits(dec, envStartBits) << dShift;
             sbrChan->envDataQuant[env][0] = sf;
             for(band = 1; band < nBands; band++) {
-                sf = DecodeOneSymbol(huffIndexFreq) << dShift;
+                sf = DecodeOneSymbol(dec, huffIndexFreq) << dShift;
                 sbrChan->envDataQuant[env][band] = sf + sbrChan->envDataQuant[env][band - 1];
             }
         }
         else if(freqRes == freqResPrev) {
             /* delta coding in time - same freq resolution for both frames */
             for(band = 0; band < nBands; band++) {
-                sf = DecodeOneSymbol(huffIndexTime) << dShift;
+                sf = DecodeOneSymbol(dec, huffIndexTime) << dShift;
                 sbrChan->envDataQuant[env][band] = sf + sbrChan->envDataQuant[lastEnv][band];
             }
         }
         else if(freqRes == 0 && freqResPrev == 1) {
             /* delta coding in time - low freq resolution for new frame, high freq resolution for old frame */
             for(band = 0; band < nBands; band++) {
-                sf = DecodeOneSymbol(huffIndexTime) << dShift;
+                sf = DecodeOneSymbol(dec, huffIndexTime) << dShift;
                 sbrChan->envDataQuant[env][band] = sf;
                 for(i = 0; i < sbrFreq->nHigh; i++) {
                     if(sbrFreq->freqHigh[i] == sbrFreq->freqLow[band]) {
@@ -8746,7 +8784,7 @@ void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
         else if(freqRes == 1 && freqResPrev == 0) {
             /* delta coding in time - high freq resolution for new frame, low freq resolution for old frame */
             for(band = 0; band < nBands; band++) {
-                sf = DecodeOneSymbol(huffIndexTime) << dShift;
+                sf = DecodeOneSymbol(dec, huffIndexTime) << dShift;
                 sbrChan->envDataQuant[env][band] = sf;
                 for(i = 0; i < sbrFreq->nLow; i++) {
                     if(sbrFreq->freqLow[i] <= sbrFreq->freqHigh[band]
@@ -8759,9 +8797,9 @@ void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
         }
 
         /* skip coupling channel */
-        if(ch != 1 || m_PSInfoSBR->couplingFlag != 1)
-            m_PSInfoSBR->envDataDequantScale[ch][env] = DequantizeEnvelope(nBands, sbrGrid->ampResFrame,
-                    sbrChan->envDataQuant[env], m_PSInfoSBR->envDataDequant[ch][env]);
+        if(ch != 1 || dec->psInfoSBR->couplingFlag != 1)
+            dec->psInfoSBR->envDataDequantScale[ch][env] = DequantizeEnvelope(nBands, sbrGrid->ampResFrame,
+                    sbrChan->envDataQuant[env], dec->psInfoSBR->envDataDequant[ch][env]);
     }
     sbrGrid->numEnvPrev = sbrGrid->numEnv;
     sbrGrid->freqResPrev = sbrGrid->freqRes[sbrGrid->numEnv - 1];
@@ -8782,11 +8820,11 @@ void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
  *
  * Return:      none
  **********************************************************************************************************************/
-void DecodeSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
+void DecodeSBRNoise(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch) {
 
     int32_t huffIndexTime, huffIndexFreq, noiseFloor, band, dShift, sf, lastNoiseFloor;
 
-    if(m_PSInfoSBR->couplingFlag && ch) {
+    if(dec->psInfoSBR->couplingFlag && ch) {
         dShift = 1;
         huffIndexTime = HuffTabSBR_tNoise30b;
         huffIndexFreq = HuffTabSBR_fNoise30b;
@@ -8805,24 +8843,24 @@ void DecodeSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_
 
         if(sbrChan->deltaFlagNoise[noiseFloor] == 0) {
             /* delta coding in freq */
-            sbrChan->noiseDataQuant[noiseFloor][0] = GetBits(5) << dShift;
+            sbrChan->noiseDataQuant[noiseFloor][0] = GetBits(dec, 5) << dShift;
             for(band = 1; band < sbrFreq->numNoiseFloorBands; band++) {
-                sf = DecodeOneSymbol(huffIndexFreq) << dShift;
+                sf = DecodeOneSymbol(dec, huffIndexFreq) << dShift;
                 sbrChan->noiseDataQuant[noiseFloor][band] = sf + sbrChan->noiseDataQuant[noiseFloor][band - 1];
             }
         }
         else {
             /* delta coding in time */
             for(band = 0; band < sbrFreq->numNoiseFloorBands; band++) {
-                sf = DecodeOneSymbol(huffIndexTime) << dShift;
+                sf = DecodeOneSymbol(dec, huffIndexTime) << dShift;
                 sbrChan->noiseDataQuant[noiseFloor][band] = sf + sbrChan->noiseDataQuant[lastNoiseFloor][band];
             }
         }
 
         /* skip coupling channel */
-        if(ch != 1 || m_PSInfoSBR->couplingFlag != 1)
+        if(ch != 1 || dec->psInfoSBR->couplingFlag != 1)
             DequantizeNoise(sbrFreq->numNoiseFloorBands, sbrChan->noiseDataQuant[noiseFloor],
-                    m_PSInfoSBR->noiseDataDequant[ch][noiseFloor]);
+                    dec->psInfoSBR->noiseDataDequant[ch][noiseFloor]);
     }
     sbrGrid->numNoiseFloorsPrev = sbrGrid->numNoiseFloors;
 }
@@ -8851,14 +8889,14 @@ static const int32_t dqTabCouple[25] PROGMEM = {
  *
  * Return:      none
  **********************************************************************************************************************/
-void UncoupleSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR) {
+void UncoupleSBREnvelope(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR) {
 
     int32_t env, band, nBands, scalei, E_1;
 
     scalei = (sbrGrid->ampResFrame ? 0 : 1);
     for(env = 0; env < sbrGrid->numEnv; env++) {
         nBands = (sbrGrid->freqRes[env] ? sbrFreq->nHigh : sbrFreq->nLow);
-        m_PSInfoSBR->envDataDequantScale[1][env] = m_PSInfoSBR->envDataDequantScale[0][env];
+        dec->psInfoSBR->envDataDequantScale[1][env] = dec->psInfoSBR->envDataDequantScale[0][env];
         for(band = 0; band < nBands; band++) {
             /* clip E_1 to [0, 24] (scalefactors approach 0 or 2) */
             E_1 = sbrChanR->envDataQuant[env][band] >> scalei;
@@ -8866,9 +8904,9 @@ void UncoupleSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR)
             if(E_1 > 24) E_1 = 24;
 
             /* envDataDequant[0] has 1 GB, so << by 2 is okay */
-            m_PSInfoSBR->envDataDequant[1][env][band] = MULSHIFT32(m_PSInfoSBR->envDataDequant[0][env][band],
+            dec->psInfoSBR->envDataDequant[1][env][band] = MULSHIFT32(dec->psInfoSBR->envDataDequant[0][env][band],
                     dqTabCouple[24 - E_1]) << 2;
-            m_PSInfoSBR->envDataDequant[0][env][band] = MULSHIFT32(m_PSInfoSBR->envDataDequant[0][env][band],
+            dec->psInfoSBR->envDataDequant[0][env][band] = MULSHIFT32(dec->psInfoSBR->envDataDequant[0][env][band],
                     dqTabCouple[E_1]) << 2;
         }
     }
@@ -8889,7 +8927,7 @@ void UncoupleSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR)
  *
  * Return:      none
  **********************************************************************************************************************/
-void UncoupleSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR) {
+void UncoupleSBRNoise(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR) {
 
     int32_t noiseFloor, band, Q_1;
 
@@ -8901,10 +8939,10 @@ void UncoupleSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR) {
             if (Q_1 > 24)   Q_1 = 24;
 
             /* noiseDataDequant[0] has 1 GB, so << by 2 is okay */
-            m_PSInfoSBR->noiseDataDequant[1][noiseFloor][band] =
-                    MULSHIFT32(m_PSInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[24 - Q_1]) << 2;
-            m_PSInfoSBR->noiseDataDequant[0][noiseFloor][band] =
-                    MULSHIFT32(m_PSInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[Q_1]) << 2;
+            dec->psInfoSBR->noiseDataDequant[1][noiseFloor][band] =
+                    MULSHIFT32(dec->psInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[24 - Q_1]) << 2;
+            dec->psInfoSBR->noiseDataDequant[0][noiseFloor][band] =
+                    MULSHIFT32(dec->psInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[Q_1]) << 2;
         }
     }
 }
@@ -9725,7 +9763,7 @@ void QMFSynthesis(int32_t *inbuf, int32_t *delay, int32_t *delayIdx, int32_t qmf
  *
  * Return:      non-zero if frame reset is triggered, zero otherwise
  **********************************************************************************************************************/
-int32_t UnpackSBRHeader(SBRHeader *sbrHdr) {
+int32_t UnpackSBRHeader(AACDecoder_t* dec, SBRHeader *sbrHdr) {
 
     SBRHeader sbrHdrPrev;
 
@@ -9737,18 +9775,18 @@ int32_t UnpackSBRHeader(SBRHeader *sbrHdr) {
     sbrHdrPrev.crossOverBand = sbrHdr->crossOverBand;
     sbrHdrPrev.noiseBands =    sbrHdr->noiseBands;
 
-    sbrHdr->ampRes =        GetBits(1);
-    sbrHdr->startFreq =     GetBits(4);
-    sbrHdr->stopFreq =      GetBits(4);
-    sbrHdr->crossOverBand = GetBits(3);
-    sbrHdr->resBitsHdr =    GetBits(2);
-    sbrHdr->hdrExtra1 =     GetBits(1);
-    sbrHdr->hdrExtra2 =     GetBits(1);
+    sbrHdr->ampRes =        GetBits(dec, 1);
+    sbrHdr->startFreq =     GetBits(dec, 4);
+    sbrHdr->stopFreq =      GetBits(dec, 4);
+    sbrHdr->crossOverBand = GetBits(dec, 3);
+    sbrHdr->resBitsHdr =    GetBits(dec, 2);
+    sbrHdr->hdrExtra1 =     GetBits(dec, 1);
+    sbrHdr->hdrExtra2 =     GetBits(dec, 1);
 
     if (sbrHdr->hdrExtra1) {
-        sbrHdr->freqScale =    GetBits(2);
-        sbrHdr->alterScale =   GetBits(1);
-        sbrHdr->noiseBands =   GetBits(2);
+        sbrHdr->freqScale =    GetBits(dec, 2);
+        sbrHdr->alterScale =   GetBits(dec, 1);
+        sbrHdr->noiseBands =   GetBits(dec, 2);
     } else {
         /* defaults */
         sbrHdr->freqScale =    2;
@@ -9757,10 +9795,10 @@ int32_t UnpackSBRHeader(SBRHeader *sbrHdr) {
     }
 
     if (sbrHdr->hdrExtra2) {
-        sbrHdr->limiterBands = GetBits(2);
-        sbrHdr->limiterGains = GetBits(2);
-        sbrHdr->interpFreq =   GetBits(1);
-        sbrHdr->smoothMode =   GetBits(1);
+        sbrHdr->limiterBands = GetBits(dec, 2);
+        sbrHdr->limiterGains = GetBits(dec, 2);
+        sbrHdr->interpFreq =   GetBits(dec, 1);
+        sbrHdr->smoothMode =   GetBits(dec, 1);
     } else {
         /* defaults */
         sbrHdr->limiterBands = 2;
@@ -9794,7 +9832,7 @@ static const uint8_t cLog2[9] = {0, 0, 1, 2, 2, 3, 3, 3, 3};
  *
  * Return:      none
  **********************************************************************************************************************/
-void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
+void UnpackSBRGrid(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
 
     int32_t numEnvRaw, env, rel, pBits, border, middleBorder = 0;
     uint8_t relBordLead[MAX_NUM_ENV], relBordTrail[MAX_NUM_ENV];
@@ -9803,17 +9841,17 @@ void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
     uint8_t absBordLead = 0, absBordTrail = 0, absBorder;
 
     sbrGrid->ampResFrame = sbrHdr->ampRes;
-    sbrGrid->frameClass = GetBits(2);
+    sbrGrid->frameClass = GetBits(dec, 2);
     switch(sbrGrid->frameClass){
 
         case SBR_GRID_FIXFIX:
-            numEnvRaw = GetBits(2);
+            numEnvRaw = GetBits(dec, 2);
             sbrGrid->numEnv = (1 << numEnvRaw);
             if(sbrGrid->numEnv == 1) sbrGrid->ampResFrame = 0;
 
             ASSERT(sbrGrid->numEnv == 1 || sbrGrid->numEnv == 2 || sbrGrid->numEnv == 4);
 
-            sbrGrid->freqRes[0] = GetBits(1);
+            sbrGrid->freqRes[0] = GetBits(dec, 1);
             for(env = 1; env < sbrGrid->numEnv; env++)
                 sbrGrid->freqRes[env] = sbrGrid->freqRes[0];
 
@@ -9838,17 +9876,17 @@ void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
             break;
 
         case SBR_GRID_FIXVAR:
-            absBorder = GetBits(2) + NUM_TIME_SLOTS;
-            numRelBorder = GetBits(2);
+            absBorder = GetBits(dec, 2) + NUM_TIME_SLOTS;
+            numRelBorder = GetBits(dec, 2);
             sbrGrid->numEnv = numRelBorder + 1;
             for(rel = 0; rel < numRelBorder; rel++)
-                relBorder[rel] = 2 * GetBits(2) + 2;
+                relBorder[rel] = 2 * GetBits(dec, 2) + 2;
 
             pBits = cLog2[sbrGrid->numEnv + 1];
-            sbrGrid->pointer = GetBits(pBits);
+            sbrGrid->pointer = GetBits(dec, pBits);
 
             for(env = sbrGrid->numEnv - 1; env >= 0; env--)
-                sbrGrid->freqRes[env] = GetBits(1);
+                sbrGrid->freqRes[env] = GetBits(dec, 1);
 
             absBordLead = 0;
             absBordTrail = absBorder;
@@ -9866,17 +9904,17 @@ void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
             break;
 
         case SBR_GRID_VARFIX:
-            absBorder = GetBits(2);
-            numRelBorder = GetBits(2);
+            absBorder = GetBits(dec, 2);
+            numRelBorder = GetBits(dec, 2);
             sbrGrid->numEnv = numRelBorder + 1;
             for(rel = 0; rel < numRelBorder; rel++)
-                relBorder[rel] = 2 * GetBits(2) + 2;
+                relBorder[rel] = 2 * GetBits(dec, 2) + 2;
 
             pBits = cLog2[sbrGrid->numEnv + 1];
-            sbrGrid->pointer = GetBits(pBits);
+            sbrGrid->pointer = GetBits(dec, pBits);
 
             for(env = 0; env < sbrGrid->numEnv; env++)
-                sbrGrid->freqRes[env] = GetBits(1);
+                sbrGrid->freqRes[env] = GetBits(dec, 1);
 
             absBordLead = absBorder;
             absBordTrail = NUM_TIME_SLOTS;
@@ -9896,25 +9934,25 @@ void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
             break;
 
         case SBR_GRID_VARVAR:
-            absBordLead = GetBits(2); /* absBorder0 */
-            absBordTrail = GetBits(2) + NUM_TIME_SLOTS; /* absBorder1 */
-            numRelBorder0 = GetBits(2);
-            numRelBorder1 = GetBits(2);
+            absBordLead = GetBits(dec, 2); /* absBorder0 */
+            absBordTrail = GetBits(dec, 2) + NUM_TIME_SLOTS; /* absBorder1 */
+            numRelBorder0 = GetBits(dec, 2);
+            numRelBorder1 = GetBits(dec, 2);
 
             sbrGrid->numEnv = numRelBorder0 + numRelBorder1 + 1;
             ASSERT(sbrGrid->numEnv <= 5);
 
             for(rel = 0; rel < numRelBorder0; rel++)
-                relBorder0[rel] = 2 * GetBits(2) + 2;
+                relBorder0[rel] = 2 * GetBits(dec, 2) + 2;
 
             for(rel = 0; rel < numRelBorder1; rel++)
-                relBorder1[rel] = 2 * GetBits(2) + 2;
+                relBorder1[rel] = 2 * GetBits(dec, 2) + 2;
 
             pBits = cLog2[numRelBorder0 + numRelBorder1 + 2];
-            sbrGrid->pointer = GetBits(pBits);
+            sbrGrid->pointer = GetBits(dec, pBits);
 
             for(env = 0; env < sbrGrid->numEnv; env++)
-                sbrGrid->freqRes[env] = GetBits(1);
+                sbrGrid->freqRes[env] = GetBits(dec, 1);
 
             numRelLead = numRelBorder0;
             numRelTrail = numRelBorder1;
@@ -9977,15 +10015,15 @@ void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid) {
  *
  * Return:      none
  **********************************************************************************************************************/
-void UnpackDeltaTimeFreq(int32_t numEnv, uint8_t *deltaFlagEnv, int32_t numNoiseFloors, uint8_t *deltaFlagNoise) {
+void UnpackDeltaTimeFreq(AACDecoder_t* dec, int32_t numEnv, uint8_t *deltaFlagEnv, int32_t numNoiseFloors, uint8_t *deltaFlagNoise) {
 
     int32_t env, noiseFloor;
 
     for (env = 0; env < numEnv; env++)
-        deltaFlagEnv[env] = GetBits(1);
+        deltaFlagEnv[env] = GetBits(dec, 1);
 
     for (noiseFloor = 0; noiseFloor < numNoiseFloors; noiseFloor++)
-        deltaFlagNoise[noiseFloor] = GetBits(1);
+        deltaFlagNoise[noiseFloor] = GetBits(dec, 1);
 }
 /***********************************************************************************************************************
  * Function:    UnpackInverseFilterMode
@@ -9999,12 +10037,12 @@ void UnpackDeltaTimeFreq(int32_t numEnv, uint8_t *deltaFlagEnv, int32_t numNoise
  *
  * Return:      none
  **********************************************************************************************************************/
-void UnpackInverseFilterMode(int32_t numNoiseFloorBands, uint8_t *mode) {
+void UnpackInverseFilterMode(AACDecoder_t* dec, int32_t numNoiseFloorBands, uint8_t *mode) {
 
     int32_t n;
 
     for (n = 0; n < numNoiseFloorBands; n++)
-        mode[n] = GetBits(2);
+        mode[n] = GetBits(dec, 2);
 }
 /***********************************************************************************************************************
  * Function:    UnpackSinusoids
@@ -10018,14 +10056,14 @@ void UnpackInverseFilterMode(int32_t numNoiseFloorBands, uint8_t *mode) {
  *
  * Return:      none
  **********************************************************************************************************************/
-void UnpackSinusoids(int32_t nHigh, int32_t addHarmonicFlag, uint8_t *addHarmonic) {
+void UnpackSinusoids(AACDecoder_t* dec, int32_t nHigh, int32_t addHarmonicFlag, uint8_t *addHarmonic) {
 
     int32_t n;
 
     n = 0;
     if(addHarmonicFlag) {
         for(; n < nHigh; n++)
-            addHarmonic[n] = GetBits(1);
+            addHarmonic[n] = GetBits(dec, 1);
     }
 
     /* zero out unused bands */
@@ -10098,37 +10136,37 @@ void CopyCouplingInverseFilterMode(int32_t numNoiseFloorBands, uint8_t *modeLeft
  *
  * Return:      none
  **********************************************************************************************************************/
-void UnpackSBRSingleChannel(int32_t chBase) {
+void UnpackSBRSingleChannel(AACDecoder_t* dec, int32_t chBase) {
 
     int32_t bitsLeft;
-    SBRHeader *sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
-    SBRGrid *sbrGridL = &(m_PSInfoSBR->sbrGrid[chBase + 0]);
-    SBRFreq *sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
-    SBRChan *sbrChanL = &(m_PSInfoSBR->sbrChan[chBase + 0]);
+    SBRHeader *sbrHdr = &(dec->psInfoSBR->sbrHdr[chBase]);
+    SBRGrid *sbrGridL = &(dec->psInfoSBR->sbrGrid[chBase + 0]);
+    SBRFreq *sbrFreq = &(dec->psInfoSBR->sbrFreq[chBase]);
+    SBRChan *sbrChanL = &(dec->psInfoSBR->sbrChan[chBase + 0]);
 
-    m_PSInfoSBR->dataExtra = GetBits(1);
-    if(m_PSInfoSBR->dataExtra) m_PSInfoSBR->resBitsData = GetBits(4);
+    dec->psInfoSBR->dataExtra = GetBits(dec, 1);
+    if(dec->psInfoSBR->dataExtra) dec->psInfoSBR->resBitsData = GetBits(dec, 4);
 
-    UnpackSBRGrid(sbrHdr, sbrGridL);
-    UnpackDeltaTimeFreq(sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors, sbrChanL->deltaFlagNoise);
-    UnpackInverseFilterMode(sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1]);
+    UnpackSBRGrid(dec, sbrHdr, sbrGridL);
+    UnpackDeltaTimeFreq(dec, sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors, sbrChanL->deltaFlagNoise);
+    UnpackInverseFilterMode(dec, sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1]);
 
-    DecodeSBREnvelope(sbrGridL, sbrFreq, sbrChanL, 0);
-    DecodeSBRNoise(sbrGridL, sbrFreq, sbrChanL, 0);
+    DecodeSBREnvelope(dec, sbrGridL, sbrFreq, sbrChanL, 0);
+    DecodeSBRNoise(dec, sbrGridL, sbrFreq, sbrChanL, 0);
 
-    sbrChanL->addHarmonicFlag[1] = GetBits(1);
-    UnpackSinusoids(sbrFreq->nHigh, sbrChanL->addHarmonicFlag[1], sbrChanL->addHarmonic[1]);
+    sbrChanL->addHarmonicFlag[1] = GetBits(dec, 1);
+    UnpackSinusoids(dec, sbrFreq->nHigh, sbrChanL->addHarmonicFlag[1], sbrChanL->addHarmonic[1]);
 
-    m_PSInfoSBR->extendedDataPresent = GetBits(1);
-    if(m_PSInfoSBR->extendedDataPresent) {
-        m_PSInfoSBR->extendedDataSize = GetBits(4);
-        if(m_PSInfoSBR->extendedDataSize == 15) m_PSInfoSBR->extendedDataSize += GetBits(8);
+    dec->psInfoSBR->extendedDataPresent = GetBits(dec, 1);
+    if(dec->psInfoSBR->extendedDataPresent) {
+        dec->psInfoSBR->extendedDataSize = GetBits(dec, 4);
+        if(dec->psInfoSBR->extendedDataSize == 15) dec->psInfoSBR->extendedDataSize += GetBits(dec, 8);
 
-        bitsLeft = 8 * m_PSInfoSBR->extendedDataSize;
+        bitsLeft = 8 * dec->psInfoSBR->extendedDataSize;
 
         /* get ID, unpack extension info, do whatever is necessary with it... */
         while(bitsLeft > 0) {
-            GetBits(8);
+            GetBits(dec, 8);
             bitsLeft -= 8;
         }
     }
@@ -10145,76 +10183,77 @@ void UnpackSBRSingleChannel(int32_t chBase) {
  *
  * Return:      none
  **********************************************************************************************************************/
-void UnpackSBRChannelPair(int32_t chBase) {
+void UnpackSBRChannelPair(AACDecoder_t* dec, int32_t chBase) {
 
     int32_t bitsLeft;
-    SBRHeader *sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
-    SBRGrid *sbrGridL = &(m_PSInfoSBR->sbrGrid[chBase + 0]), *sbrGridR = &(m_PSInfoSBR->sbrGrid[chBase + 1]);
-    SBRFreq *sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
-    SBRChan *sbrChanL = &(m_PSInfoSBR->sbrChan[chBase + 0]), *sbrChanR = &(m_PSInfoSBR->sbrChan[chBase + 1]);
+    SBRHeader *sbrHdr = &(dec->psInfoSBR->sbrHdr[chBase]);
+    SBRGrid *sbrGridL = &(dec->psInfoSBR->sbrGrid[chBase + 0]), *sbrGridR = &(dec->psInfoSBR->sbrGrid[chBase + 1]);
+    SBRFreq *sbrFreq = &(dec->psInfoSBR->sbrFreq[chBase]);
+    SBRChan *sbrChanL = &(dec->psInfoSBR->sbrChan[chBase + 0]), *sbrChanR = &(dec->psInfoSBR->sbrChan[chBase + 1]);
 
-    m_PSInfoSBR->dataExtra = GetBits(1);
-    if(m_PSInfoSBR->dataExtra) {
-        m_PSInfoSBR->resBitsData = GetBits(4);
-        m_PSInfoSBR->resBitsData = GetBits(4);
+    dec->psInfoSBR->dataExtra = GetBits(dec, 1);
+    if(dec->psInfoSBR->dataExtra) {
+        dec->psInfoSBR->resBitsData = GetBits(dec, 4);
+        dec->psInfoSBR->resBitsData = GetBits(dec, 4);
     }
 
-    m_PSInfoSBR->couplingFlag = GetBits(1);
-    if(m_PSInfoSBR->couplingFlag) {
-        UnpackSBRGrid(sbrHdr, sbrGridL);
+    dec->psInfoSBR->couplingFlag = GetBits(dec, 1);
+    if(dec->psInfoSBR->couplingFlag) {
+        UnpackSBRGrid(dec, sbrHdr, sbrGridL);
         CopyCouplingGrid(sbrGridL, sbrGridR);
 
-        UnpackDeltaTimeFreq(sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors,
+        UnpackDeltaTimeFreq(dec, sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors,
                 sbrChanL->deltaFlagNoise);
-        UnpackDeltaTimeFreq(sbrGridR->numEnv, sbrChanR->deltaFlagEnv, sbrGridR->numNoiseFloors,
+        UnpackDeltaTimeFreq(dec, sbrGridR->numEnv, sbrChanR->deltaFlagEnv, sbrGridR->numNoiseFloors,
                 sbrChanR->deltaFlagNoise);
 
-        UnpackInverseFilterMode(sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1]);
+        UnpackInverseFilterMode(dec, sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1]);
         CopyCouplingInverseFilterMode(sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1], sbrChanR->invfMode[1]);
 
-        DecodeSBREnvelope(sbrGridL, sbrFreq, sbrChanL, 0);
-        DecodeSBRNoise(sbrGridL, sbrFreq, sbrChanL, 0);
-        DecodeSBREnvelope(sbrGridR, sbrFreq, sbrChanR, 1);
-        DecodeSBRNoise(sbrGridR, sbrFreq, sbrChanR, 1);
+        DecodeSBREnvelope(dec, sbrGridL, sbrFreq, sbrChanL, 0);
+        DecodeSBRNoise(dec, sbrGridL, sbrFreq, sbrChanL, 0);
+        DecodeSBREnvelope(dec, sbrGridR, sbrFreq, sbrChanR, 1);
+        DecodeSBRNoise(dec, sbrGridR, sbrFreq, sbrChanR, 1);
 
         /* pass RIGHT sbrChan struct */
-        UncoupleSBREnvelope(sbrGridL, sbrFreq, sbrChanR);
-        UncoupleSBRNoise(sbrGridL, sbrFreq, sbrChanR);
+        UncoupleSBREnvelope(dec, sbrGridL, sbrFreq, sbrChanR);
+        UncoupleSBRNoise(dec, sbrGridL, sbrFreq, sbrChanR);
 
     }
     else {
-        UnpackSBRGrid(sbrHdr, sbrGridL);
-        UnpackSBRGrid(sbrHdr, sbrGridR);
-        UnpackDeltaTimeFreq(sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors,
+        UnpackSBRGrid(dec, sbrHdr, sbrGridL);
+        UnpackSBRGrid(dec, sbrHdr, sbrGridR);
+        UnpackDeltaTimeFreq(dec, sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors,
                 sbrChanL->deltaFlagNoise);
-        UnpackDeltaTimeFreq(sbrGridR->numEnv, sbrChanR->deltaFlagEnv, sbrGridR->numNoiseFloors,
+        UnpackDeltaTimeFreq(dec, sbrGridR->numEnv, sbrChanR->deltaFlagEnv, sbrGridR->numNoiseFloors,
                 sbrChanR->deltaFlagNoise);
-        UnpackInverseFilterMode(sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1]);
-        UnpackInverseFilterMode(sbrFreq->numNoiseFloorBands, sbrChanR->invfMode[1]);
+        UnpackInverseFilterMode(dec, sbrFreq->numNoiseFloorBands, sbrChanL->invfMode[1]);
+        UnpackInverseFilterMode(dec, sbrFreq->numNoiseFloorBands, sbrChanR->invfMode[1]);
 
-        DecodeSBREnvelope(sbrGridL, sbrFreq, sbrChanL, 0);
-        DecodeSBREnvelope(sbrGridR, sbrFreq, sbrChanR, 1);
-        DecodeSBRNoise(sbrGridL, sbrFreq, sbrChanL, 0);
-        DecodeSBRNoise(sbrGridR, sbrFreq, sbrChanR, 1);
+        DecodeSBREnvelope(dec, sbrGridL, sbrFreq, sbrChanL, 0);
+        DecodeSBREnvelope(dec, sbrGridR, sbrFreq, sbrChanR, 1);
+        DecodeSBRNoise(dec, sbrGridL, sbrFreq, sbrChanL, 0);
+        DecodeSBRNoise(dec, sbrGridR, sbrFreq, sbrChanR, 1);
     }
 
-    sbrChanL->addHarmonicFlag[1] = GetBits(1);
-    UnpackSinusoids(sbrFreq->nHigh, sbrChanL->addHarmonicFlag[1], sbrChanL->addHarmonic[1]);
+    sbrChanL->addHarmonicFlag[1] = GetBits(dec, 1);
+    UnpackSinusoids(dec, sbrFreq->nHigh, sbrChanL->addHarmonicFlag[1], sbrChanL->addHarmonic[1]);
 
-    sbrChanR->addHarmonicFlag[1] = GetBits(1);
-    UnpackSinusoids(sbrFreq->nHigh, sbrChanR->addHarmonicFlag[1], sbrChanR->addHarmonic[1]);
+    sbrChanR->addHarmonicFlag[1] = GetBits(dec, 1);
+    UnpackSinusoids(dec, sbrFreq->nHigh, sbrChanR->addHarmonicFlag[1], sbrChanR->addHarmonic[1]);
 
-    m_PSInfoSBR->extendedDataPresent = GetBits(1);
-    if(m_PSInfoSBR->extendedDataPresent) {
-        m_PSInfoSBR->extendedDataSize = GetBits(4);
-        if(m_PSInfoSBR->extendedDataSize == 15) m_PSInfoSBR->extendedDataSize += GetBits(8);
+    dec->psInfoSBR->extendedDataPresent = GetBits(dec, 1);
+    if(dec->psInfoSBR->extendedDataPresent) {
+        dec->psInfoSBR->extendedDataSize = GetBits(dec, 4);
+        if(dec->psInfoSBR->extendedDataSize == 15) dec->psInfoSBR->extendedDataSize += GetBits(dec, 8);
 
-        bitsLeft = 8 * m_PSInfoSBR->extendedDataSize;
+        bitsLeft = 8 * dec->psInfoSBR->extendedDataSize;
 
         /* get ID, unpack extension info, do whatever is necessary with it... */
         while(bitsLeft > 0) {
-            GetBits(8);
+            GetBits(dec, 8);
             bitsLeft -= 8;
         }
     }
 }
+#endif // AUDIO_CODEC_AAC
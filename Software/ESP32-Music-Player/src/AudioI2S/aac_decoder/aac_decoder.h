@@ -4,6 +4,8 @@
 //#pragma GCC diagnostic ignored "-Wnarrowing"
 
 #include "Arduino.h"
+#include "../codec_arena.h"
+#include "../codec_mem.h"
 
 #define AAC_ENABLE_MPEG4
 
@@ -431,32 +433,48 @@ typedef struct _PSInfoSBR {
     int32_t      XBuf[32+8][64][2];
 } PSInfoSBR_t;
 
-bool AACDecoder_AllocateBuffers(void);
-int32_t AACFlushCodec();
-void AACDecoder_FreeBuffers(void);
-bool AACDecoder_IsInit(void);
+typedef struct AACDecoder_t { // complete decoder state, one per stream, the buffers come from AACDecoder_AllocateBuffers()
+    PSInfoBase_t*        psInfoBase = NULL;
+    AACDecInfo_t*        aacDecInfo = NULL;
+    AACFrameInfo_t       aacFrameInfo = {};
+    ADTSHeader_t         fhADTS = {};
+    ADIFHeader_t         fhADIF = {};
+    ProgConfigElement_t* pce[16] = {};
+    PulseInfo_t          pulseInfo[2] = {}; // [MAX_NCHANS_ELEM]
+    aac_BitStreamInfo_t  bsi = {};
+    PSInfoSBR_t*         psInfoSBR = NULL;
+}AACDecoder_t;
+
+AACDecoder_t* AACDecoder_Create();
+void AACDecoder_Destroy(AACDecoder_t* dec);
+AACDecoder_t* AACDecoder_Default();
+uint32_t AACDecoder_ArenaSize(void);
+bool AACDecoder_AllocateBuffers(AACDecoder_t* dec);
+int32_t AACFlushCodec(AACDecoder_t* dec);
+void AACDecoder_FreeBuffers(AACDecoder_t* dec);
+bool AACDecoder_IsInit(AACDecoder_t* dec);
 int32_t AACFindSyncWord(uint8_t *buf, int32_t nBytes);
-int32_t AACSetRawBlockParams(int32_t copyLast, int32_t nChans, int32_t sampRateCore, int32_t profile);
-int32_t AACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf);
-int32_t AACGetSampRate();
-int32_t AACGetChannels();
-int32_t AACGetID(); // 0-MPEG4, 1-MPEG2
-uint8_t AACGetProfile(); // 0-Main, 1-LC, 2-SSR, 3-reserved
-uint8_t AACGetFormat(); // 0-unknown 1-ADTS 2-ADIF, 3-RAW
+int32_t AACSetRawBlockParams(AACDecoder_t* dec, int32_t copyLast, int32_t nChans, int32_t sampRateCore, int32_t profile);
+int32_t AACDecode(AACDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf);
+int32_t AACGetSampRate(AACDecoder_t* dec);
+int32_t AACGetChannels(AACDecoder_t* dec);
+int32_t AACGetID(AACDecoder_t* dec); // 0-MPEG4, 1-MPEG2
+uint8_t AACGetProfile(AACDecoder_t* dec); // 0-Main, 1-LC, 2-SSR, 3-reserved
+uint8_t AACGetFormat(AACDecoder_t* dec); // 0-unknown 1-ADTS 2-ADIF, 3-RAW
 int32_t AACGetBitsPerSample();
-int32_t AACGetBitrate();
-int32_t AACGetOutputSamps();
-int32_t AACGetBitrate();
+int32_t AACGetBitrate(AACDecoder_t* dec);
+int32_t AACGetOutputSamps(AACDecoder_t* dec);
+int32_t AACGetBitrate(AACDecoder_t* dec);
 void DecodeLPCCoefs(int32_t order, int32_t res, int8_t *filtCoef, int32_t *a, int32_t *b);
 int32_t FilterRegion(int32_t size, int32_t dir, int32_t order, int32_t *audioCoef, int32_t *a, int32_t *hist);
-int32_t TNSFilter(int32_t ch);
-int32_t DecodeSingleChannelElement();
-int32_t DecodeChannelPairElement();
-int32_t DecodeLFEChannelElement();
-int32_t DecodeDataStreamElement();
-int32_t DecodeProgramConfigElement(uint8_t idx);
-int32_t DecodeFillElement();
-int32_t DecodeNextElement(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail);
+int32_t TNSFilter(AACDecoder_t* dec, int32_t ch);
+int32_t DecodeSingleChannelElement(AACDecoder_t* dec);
+int32_t DecodeChannelPairElement(AACDecoder_t* dec);
+int32_t DecodeLFEChannelElement(AACDecoder_t* dec);
+int32_t DecodeDataStreamElement(AACDecoder_t* dec);
+int32_t DecodeProgramConfigElement(AACDecoder_t* dec, uint8_t idx);
+int32_t DecodeFillElement(AACDecoder_t* dec);
+int32_t DecodeNextElement(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail);
 void PreMultiply(int32_t tabidx, int32_t *zbuf1);
 void PostMultiply(int32_t tabidx, int32_t *fft1);
 void PreMultiplyRescale(int32_t tabidx, int32_t *zbuf1, int32_t es);
@@ -468,45 +486,45 @@ void R8FirstPass(int32_t *x, int32_t bg);
 void R4Core(int32_t *x, int32_t bg, int32_t gp, int32_t *wtab);
 void R4FFT(int32_t tabidx, int32_t *x);
 void UnpackZeros(int32_t nVals, int32_t *coef);
-void UnpackQuads(int32_t cb, int32_t nVals, int32_t *coef);
-void UnpackPairsNoEsc(int32_t cb, int32_t nVals, int32_t *coef);
-void UnpackPairsEsc(int32_t cb, int32_t nVals, int32_t *coef);
-void DecodeSpectrumLong(int32_t ch);
-void DecodeSpectrumShort(int32_t ch);
+void UnpackQuads(AACDecoder_t* dec, int32_t cb, int32_t nVals, int32_t *coef);
+void UnpackPairsNoEsc(AACDecoder_t* dec, int32_t cb, int32_t nVals, int32_t *coef);
+void UnpackPairsEsc(AACDecoder_t* dec, int32_t cb, int32_t nVals, int32_t *coef);
+void DecodeSpectrumLong(AACDecoder_t* dec, int32_t ch);
+void DecodeSpectrumShort(AACDecoder_t* dec, int32_t ch);
 void DecWindowOverlap(int32_t *buf0, int32_t *over0, int16_t *pcm0, int32_t nChans, int32_t winTypeCurr, int32_t winTypePrev);
 void DecWindowOverlapLongStart(int32_t *buf0, int32_t *over0, int16_t *pcm0, int32_t nChans, int32_t winTypeCurr, int32_t winTypePrev);
 void DecWindowOverlapLongStop(int32_t *buf0, int32_t *over0, int16_t *pcm0, int32_t nChans, int32_t winTypeCurr, int32_t winTypePrev);
 void DecWindowOverlapShort(int32_t *buf0, int32_t *over0, int16_t *pcm0, int32_t nChans, int32_t winTypeCurr, int32_t winTypePrev);
-int32_t IMDCT(int32_t ch, int32_t chOut, int16_t *outbuf);
-void DecodeICSInfo(ICSInfo_t *icsInfo, int32_t sampRateIdx);
-void DecodeSectionData(int32_t winSequence, int32_t numWinGrp, int32_t maxSFB, uint8_t *sfbCodeBook);
-int32_t DecodeOneScaleFactor();
-void DecodeScaleFactors(int32_t numWinGrp, int32_t maxSFB, int32_t globalGain, uint8_t *sfbCodeBook, int16_t *scaleFactors);
-void DecodePulseInfo(uint8_t ch);
-void DecodeTNSInfo(int32_t winSequence, TNSInfo_t *ti, int8_t *tnsCoef);
-void DecodeGainControlInfo(int32_t winSequence, GainControlInfo_t *gi);
-void DecodeICS(int32_t ch);
-int32_t DecodeNoiselessData(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail, int32_t ch);
-int32_t UnpackADTSHeader(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail);
-int32_t GetADTSChannelMapping(uint8_t *buf, int32_t bitOffset, int32_t bitsAvail);
-int32_t GetNumChannelsADIF(int32_t nPCE);
-int32_t GetSampleRateIdxADIF(int32_t nPCE);
-int32_t UnpackADIFHeader(uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail);
-int32_t SetRawBlockParams(int32_t copyLast, int32_t nChans, int32_t sampRate, int32_t profile);
-int32_t PrepareRawBlock();
+int32_t IMDCT(AACDecoder_t* dec, int32_t ch, int32_t chOut, int16_t *outbuf);
+void DecodeICSInfo(AACDecoder_t* dec, ICSInfo_t *icsInfo, int32_t sampRateIdx);
+void DecodeSectionData(AACDecoder_t* dec, int32_t winSequence, int32_t numWinGrp, int32_t maxSFB, uint8_t *sfbCodeBook);
+int32_t DecodeOneScaleFactor(AACDecoder_t* dec);
+void DecodeScaleFactors(AACDecoder_t* dec, int32_t numWinGrp, int32_t maxSFB, int32_t globalGain, uint8_t *sfbCodeBook, int16_t *scaleFactors);
+void DecodePulseInfo(AACDecoder_t* dec, uint8_t ch);
+void DecodeTNSInfo(AACDecoder_t* dec, int32_t winSequence, TNSInfo_t *ti, int8_t *tnsCoef);
+void DecodeGainControlInfo(AACDecoder_t* dec, int32_t winSequence, GainControlInfo_t *gi);
+void DecodeICS(AACDecoder_t* dec, int32_t ch);
+int32_t DecodeNoiselessData(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail, int32_t ch);
+int32_t UnpackADTSHeader(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail);
+int32_t GetADTSChannelMapping(AACDecoder_t* dec, uint8_t *buf, int32_t bitOffset, int32_t bitsAvail);
+int32_t GetNumChannelsADIF(AACDecoder_t* dec, int32_t nPCE);
+int32_t GetSampleRateIdxADIF(AACDecoder_t* dec, int32_t nPCE);
+int32_t UnpackADIFHeader(AACDecoder_t* dec, uint8_t **buf, int32_t *bitOffset, int32_t *bitsAvail);
+int32_t SetRawBlockParams(AACDecoder_t* dec, int32_t copyLast, int32_t nChans, int32_t sampRate, int32_t profile);
+int32_t PrepareRawBlock(AACDecoder_t* dec);
 int32_t DequantBlock(int32_t *inbuf, int32_t nSamps, int32_t scale);
-int32_t AACDequantize(int32_t ch);
+int32_t AACDequantize(AACDecoder_t* dec, int32_t ch);
 int32_t DeinterleaveShortBlocks(int32_t ch);
 uint32_t Get32BitVal(uint32_t *last);
 int32_t InvRootR(int32_t r);
 int32_t ScaleNoiseVector(int32_t *coef, int32_t nVals, int32_t sf);
 void GenerateNoiseVector(int32_t *coef, int32_t *last, int32_t nVals);
 void CopyNoiseVector(int32_t *coefL, int32_t *coefR, int32_t nVals);
-int32_t PNS(int32_t ch);
+int32_t PNS(AACDecoder_t* dec, int32_t ch);
 int32_t GetSampRateIdx(int32_t sampRate);
 void StereoProcessGroup(int32_t *coefL, int32_t *coefR, const uint16_t *sfbTab, int32_t msMaskPres, uint8_t *msMaskPtr,
         int32_t msMaskOffset, int32_t maxSFB, uint8_t *cbRight, int16_t *sfRight, int32_t *gbCurrent);
-int32_t StereoProcess();
+int32_t StereoProcess(AACDecoder_t* dec);
 int32_t RatioPowInv(int32_t a, int32_t b, int32_t c);
 int32_t SqrtFix(int32_t q, int32_t fBitsIn, int32_t *fBitsOut);
 int32_t InvRNormalized(int32_t r);
@@ -516,17 +534,17 @@ void R4Core32(int32_t *r0);
 void FFT32C(int32_t *x);
 void CVKernel1(int32_t *XBuf, int32_t *accBuf);
 void CVKernel2(int32_t *XBuf, int32_t *accBuf);
-void SetBitstreamPointer(int32_t nBytes, uint8_t *buf);
-inline void RefillBitstreamCache();
-uint32_t GetBits(int32_t nBits);
-uint32_t GetBitsNoAdvance(int32_t nBits);
-void AdvanceBitstream(int32_t nBits);
-int32_t CalcBitsUsed(uint8_t *startBuf, int32_t startOffset);
-void ByteAlignBitstream();
+void SetBitstreamPointer(AACDecoder_t* dec, int32_t nBytes, uint8_t *buf);
+inline void RefillBitstreamCache(AACDecoder_t* dec);
+uint32_t GetBits(AACDecoder_t* dec, int32_t nBits);
+uint32_t GetBitsNoAdvance(AACDecoder_t* dec, int32_t nBits);
+void AdvanceBitstream(AACDecoder_t* dec, int32_t nBits);
+int32_t CalcBitsUsed(AACDecoder_t* dec, uint8_t *startBuf, int32_t startOffset);
+void ByteAlignBitstream(AACDecoder_t* dec);
 // SBR
-void InitSBRState();
-int32_t DecodeSBRBitstream(int32_t chBase);
-int32_t DecodeSBRData(int32_t chBase, int16_t *outbuf);
+void InitSBRState(AACDecoder_t* dec);
+int32_t DecodeSBRBitstream(AACDecoder_t* dec, int32_t chBase);
+int32_t DecodeSBRData(AACDecoder_t* dec, int32_t chBase, int16_t *outbuf);
 int32_t FlushCodecSBR();
 void BubbleSort(uint8_t *v, int32_t nItems);
 uint8_t VMin(uint8_t *v, int32_t nItems);
@@ -543,27 +561,27 @@ void RemoveFreq(uint8_t *freq, int32_t nFreq, int32_t removeIdx);
 int32_t CalcFreqLimiter(uint8_t *freqLimiter, uint8_t *patchNumSubbands, uint8_t *freqLow, int32_t nLow, int32_t kStart,
         int32_t limiterBands, int32_t numPatches);
 int32_t CalcFreqTables(SBRHeader *sbrHdr, SBRFreq *sbrFreq, int32_t sampRateIdx);
-void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t env);
+void EstimateEnvelope(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t env);
 int32_t GetSMapped(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t env, int32_t band, int32_t la);
-void CalcMaxGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ);
+void CalcMaxGain(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ);
 void CalcNoiseDivFactors(int32_t q, int32_t *qp1Inv, int32_t *qqp1Inv);
-void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ);
-void ApplyBoost(SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ);
-void CalcGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env);
-void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t env, int32_t hfReset);
-void AdjustHighFreq(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
+void CalcComponentGains(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env, int32_t lim, int32_t fbitsDQ);
+void ApplyBoost(AACDecoder_t* dec, SBRFreq *sbrFreq, int32_t lim, int32_t fbitsDQ);
+void CalcGain(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch, int32_t env);
+void MapHF(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t env, int32_t hfReset);
+void AdjustHighFreq(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
 int32_t CalcCovariance1(int32_t *XBuf, int32_t *p01reN, int32_t *p01imN, int32_t *p12reN, int32_t *p12imN, int32_t *p11reN, int32_t *p22reN);
 int32_t CalcCovariance2(int32_t *XBuf, int32_t *p02reN, int32_t *p02imN);
 void CalcLPCoefs(int32_t *XBuf, int32_t *a0re, int32_t *a0im, int32_t *a1re, int32_t *a1im, int32_t gb);
-void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
+void GenerateHighFreq(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
 int32_t DecodeHuffmanScalar(const int16_t *huffTab, const HuffInfo_t *huffTabInfo, uint32_t bitBuf, int32_t *val);
-int32_t DecodeOneSymbol(int32_t huffTabIndex);
+int32_t DecodeOneSymbol(AACDecoder_t* dec, int32_t huffTabIndex);
 int32_t DequantizeEnvelope(int32_t nBands, int32_t ampRes, int8_t *envQuant, int32_t *envDequant);
 void DequantizeNoise(int32_t nBands, int8_t *noiseQuant, int32_t *noiseDequant);
-void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
-void DecodeSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
-void UncoupleSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR);
-void UncoupleSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR);
+void DecodeSBREnvelope(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
+void DecodeSBRNoise(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int32_t ch);
+void UncoupleSBREnvelope(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR);
+void UncoupleSBRNoise(AACDecoder_t* dec, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR);
 void DecWindowOverlapNoClip(int32_t *buf0, int32_t *over0, int32_t *out0, int32_t winTypeCurr, int32_t winTypePrev);
 void DecWindowOverlapLongStartNoClip(int32_t *buf0, int32_t *over0, int32_t *out0, int32_t winTypeCurr, int32_t winTypePrev);
 void DecWindowOverlapLongStopNoClip(int32_t *buf0, int32_t *over0, int32_t *out0, int32_t winTypeCurr, int32_t winTypePrev);
@@ -574,12 +592,12 @@ void QMFAnalysisConv(int32_t *cTab, int32_t *delay, int32_t dIdx, int32_t *uBuf)
 int32_t QMFAnalysis(int32_t *inbuf, int32_t *delay, int32_t *XBuf, int32_t fBitsIn, int32_t *delayIdx, int32_t qmfaBands);
 void QMFSynthesisConv(int32_t *cPtr, int32_t *delay, int32_t dIdx, int16_t *outbuf, int32_t nChans);
 void QMFSynthesis(int32_t *inbuf, int32_t *delay, int32_t *delayIdx, int32_t qmfsBands, int16_t *outbuf, int32_t nChans);
-int32_t UnpackSBRHeader(SBRHeader *sbrHdr);
-void UnpackSBRGrid(SBRHeader *sbrHdr, SBRGrid *sbrGrid);
-void UnpackDeltaTimeFreq(int32_t numEnv, uint8_t *deltaFlagEnv, int32_t numNoiseFloors, uint8_t *deltaFlagNoise);
-void UnpackInverseFilterMode(int32_t numNoiseFloorBands, uint8_t *mode);
-void UnpackSinusoids(int32_t nHigh, int32_t addHarmonicFlag, uint8_t *addHarmonic);
+int32_t UnpackSBRHeader(AACDecoder_t* dec, SBRHeader *sbrHdr);
+void UnpackSBRGrid(AACDecoder_t* dec, SBRHeader *sbrHdr, SBRGrid *sbrGrid);
+void UnpackDeltaTimeFreq(AACDecoder_t* dec, int32_t numEnv, uint8_t *deltaFlagEnv, int32_t numNoiseFloors, uint8_t *deltaFlagNoise);
+void UnpackInverseFilterMode(AACDecoder_t* dec, int32_t numNoiseFloorBands, uint8_t *mode);
+void UnpackSinusoids(AACDecoder_t* dec, int32_t nHigh, int32_t addHarmonicFlag, uint8_t *addHarmonic);
 void CopyCouplingGrid(SBRGrid *sbrGridLeft, SBRGrid *sbrGridRight);
 void CopyCouplingInverseFilterMode(int32_t numNoiseFloorBands, uint8_t *modeLeft, uint8_t *modeRight);
-void UnpackSBRSingleChannel(int32_t chBase);
-void UnpackSBRChannelPair(int32_t chBase);
+void UnpackSBRSingleChannel(AACDecoder_t* dec, int32_t chBase);
+void UnpackSBRChannelPair(AACDecoder_t* dec, int32_t chBase);
@@ -0,0 +1,170 @@
+/*
+ * audio_codecs.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "audio_codecs.h"
+#if AUDIO_CODEC_MP3
+  #include "mp3_decoder/mp3_decoder.h"
+#endif
+#if AUDIO_CODEC_AAC
+  #include "aac_decoder/aac_decoder.h"
+#endif
+#if AUDIO_CODEC_FLAC
+  #include "flac_decoder/flac_decoder.h"
+#endif
+#if AUDIO_CODEC_OPUS
+  #include "opus_decoder/opus_decoder.h"
+#endif
+#if AUDIO_CODEC_VORBIS
+  #include "vorbis_decoder/vorbis_decoder.h"
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_MP3
+const AudioCodec_t s_codecMP3 = { // on the default context, further ones come from MP3Decoder_Create()
+    "MP3", 1600, false, true, 0,
+    MP3Decoder_ArenaSize,
+    []() -> bool { return MP3Decoder_IsInit(MP3Decoder_Default()); },
+    []() -> bool { return MP3Decoder_AllocateBuffers(MP3Decoder_Default()); },
+    []() { MP3Decoder_FreeBuffers(MP3Decoder_Default()); }, NULL, MP3FindSyncWord, 2900,
+    MP3FindSyncWord,
+    [](uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) -> int32_t { return MP3Decode(MP3Decoder_Default(), inbuf, bytesLeft, outbuf, 0); },
+    []() -> uint8_t  { return MP3GetChannels(MP3Decoder_Default()); },
+    []() -> uint32_t { return MP3GetSampRate(MP3Decoder_Default()); },
+    []() -> uint8_t  { return MP3GetBitsPerSample(MP3Decoder_Default()); },
+    []() -> uint32_t { return MP3GetBitrate(MP3Decoder_Default()); },
+    []() -> uint32_t { return MP3GetOutputSamps(MP3Decoder_Default()); },
+    NULL, NULL, NULL
+};
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_AAC
+const AudioCodec_t s_codecAAC = { // on the default context, further ones come from AACDecoder_Create()
+    "AAC", 1600, false, true, 0,
+    AACDecoder_ArenaSize,
+    []() -> bool { return AACDecoder_IsInit(AACDecoder_Default()); },
+    []() -> bool { return AACDecoder_AllocateBuffers(AACDecoder_Default()); },
+    []() { AACDecoder_FreeBuffers(AACDecoder_Default()); }, NULL, AACFindSyncWord, 1600,
+    AACFindSyncWord,
+    [](uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) -> int32_t { return AACDecode(AACDecoder_Default(), inbuf, bytesLeft, outbuf); },
+    []() -> uint8_t  { return AACGetChannels(AACDecoder_Default()); },
+    []() -> uint32_t { return AACGetSampRate(AACDecoder_Default()); },
+    []() -> uint8_t  { return AACGetBitsPerSample(); },
+    []() -> uint32_t { return AACGetBitrate(AACDecoder_Default()); },
+    []() -> uint32_t { return AACGetOutputSamps(AACDecoder_Default()); },
+    NULL, NULL, NULL
+};
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_FLAC
+const AudioCodec_t s_codecFLAC = { // on the default context, further ones come from FLACDecoder_Create()
+    "FLAC", 4096 * 4, true, true, FLAC_PARSE_OGG_DONE,
+    FLACDecoder_ArenaSize, NULL,
+    []() -> bool { return FLACDecoder_AllocateBuffers(FLACDecoder_Default()); },
+    []() { FLACDecoder_FreeBuffers(FLACDecoder_Default()); },
+    []() { FLACDecoderReset(FLACDecoder_Default()); }, FLACFindFrameHeader, 16,
+    [](uint8_t* buf, int32_t nBytes) -> int32_t { return FLACFindSyncWord(FLACDecoder_Default(), buf, nBytes); },
+    [](uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) -> int32_t { return FLACDecode(FLACDecoder_Default(), inbuf, bytesLeft, outbuf); },
+    []() -> uint8_t  { return FLACGetChannels(FLACDecoder_Default()); },
+    []() -> uint32_t { return FLACGetSampRate(FLACDecoder_Default()); },
+    []() -> uint8_t  { return FLACGetBitsPerSample(FLACDecoder_Default()); },
+    []() -> uint32_t { return FLACGetBitRate(FLACDecoder_Default()); },
+    []() -> uint32_t { return FLACGetOutputSamps(FLACDecoder_Default()); },
+    []() -> uint32_t { return FLACGetAudioDataStart(FLACDecoder_Default()); },
+    []() -> char*    { return FLACgetStreamTitle(FLACDecoder_Default()); },
+    []() -> std::vector<uint32_t> { return FLACgetMetadataBlockPicture(FLACDecoder_Default()); }
+};
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_OPUS
+const AudioCodec_t s_codecOPUS = { // on the default context, further ones come from OPUSDecoder_Create()
+    "OPUS", 1024, false, false, OPUS_PARSE_OGG_DONE,
+    NULL, NULL,
+    []() -> bool { return OPUSDecoder_AllocateBuffers(OPUSDecoder_Default()); },
+    []() { OPUSDecoder_FreeBuffers(OPUSDecoder_Default()); }, NULL, NULL, 0,
+    [](uint8_t* buf, int32_t nBytes) -> int32_t { return OPUSFindSyncWord(OPUSDecoder_Default(), buf, nBytes); },
+    [](uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) -> int32_t { return OPUSDecode(OPUSDecoder_Default(), inbuf, bytesLeft, outbuf); },
+    []() -> uint8_t  { return OPUSGetChannels(OPUSDecoder_Default()); },
+    []() -> uint32_t { return OPUSGetSampRate(OPUSDecoder_Default()); },
+    []() -> uint8_t  { return OPUSGetBitsPerSample(); },
+    []() -> uint32_t { return OPUSGetBitRate(OPUSDecoder_Default()); },
+    []() -> uint32_t { return OPUSGetOutputSamps(OPUSDecoder_Default()); },
+    []() -> uint32_t { return OPUSGetAudioDataStart(OPUSDecoder_Default()); },
+    []() -> char*    { return OPUSgetStreamTitle(OPUSDecoder_Default()); },
+    []() -> std::vector<uint32_t> { return OPUSgetMetadataBlockPicture(OPUSDecoder_Default()); }
+};
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_VORBIS
+const AudioCodec_t s_codecVORBIS = { // on the default context, further ones come from VORBISDecoder_Create()
+    "VORBIS", 4096 * 2, true, false, VORBIS_PARSE_OGG_DONE,
+    NULL, NULL,
+    []() -> bool { return VORBISDecoder_AllocateBuffers(VORBISDecoder_Default()); },
+    []() { VORBISDecoder_FreeBuffers(VORBISDecoder_Default()); }, NULL, NULL, 0,
+    [](uint8_t* buf, int32_t nBytes) -> int32_t { return VORBISFindSyncWord(buf, nBytes); },
+    [](uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) -> int32_t { return VORBISDecode(VORBISDecoder_Default(), inbuf, bytesLeft, outbuf); },
+    []() -> uint8_t  { return VORBISGetChannels(VORBISDecoder_Default()); },
+    []() -> uint32_t { return VORBISGetSampRate(VORBISDecoder_Default()); },
+    []() -> uint8_t  { return VORBISGetBitsPerSample(); },
+    []() -> uint32_t { return VORBISGetBitRate(VORBISDecoder_Default()); },
+    []() -> uint32_t { return VORBISGetOutputSamps(VORBISDecoder_Default()); },
+    []() -> uint32_t { return VORBISGetAudioDataStart(VORBISDecoder_Default()); },
+    []() -> char*    { return VORBISgetStreamTitle(VORBISDecoder_Default()); },
+    []() -> std::vector<uint32_t> { return VORBISgetMetadataBlockPicture(VORBISDecoder_Default()); }
+};
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+const AudioCodec_t* const s_codecs[] = {
+#if AUDIO_CODEC_MP3
+    &s_codecMP3,
+#endif
+#if AUDIO_CODEC_AAC
+    &s_codecAAC,
+#endif
+#if AUDIO_CODEC_FLAC
+    &s_codecFLAC,
+#endif
+#if AUDIO_CODEC_OPUS
+    &s_codecOPUS,
+#endif
+#if AUDIO_CODEC_VORBIS
+    &s_codecVORBIS,
+#endif
+    NULL
+};
+//----------------------------------------------------------------------------------------------------------------------
+const AudioCodec_t* AudioCodec_Get(int codec){
+    switch(codec){
+#if AUDIO_CODEC_MP3
+        case CODEC_MP3:    return &s_codecMP3;
+#endif
+#if AUDIO_CODEC_AAC
+        case CODEC_AAC:    return &s_codecAAC;
+        case CODEC_M4A:    return &s_codecAAC;
+#endif
+#if AUDIO_CODEC_FLAC
+        case CODEC_FLAC:   return &s_codecFLAC;
+#endif
+#if AUDIO_CODEC_OPUS
+        case CODEC_OPUS:   return &s_codecOPUS;
+#endif
+#if AUDIO_CODEC_VORBIS
+        case CODEC_VORBIS: return &s_codecVORBIS;
+#endif
+        default:           return NULL;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AudioCodec_FreeAll(){
+    for(int i = 0; s_codecs[i]; i++) s_codecs[i]->freeBuffers();
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t AudioCodec_MaxArenaSize(){
+    uint32_t size = 0;
+    for(int i = 0; s_codecs[i]; i++){
+        if(s_codecs[i]->arenaSize) size = max(size, s_codecs[i]->arenaSize());
+    }
+    return size;
+}
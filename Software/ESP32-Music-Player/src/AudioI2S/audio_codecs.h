@@ -0,0 +1,62 @@
+/*
+ * audio_codecs.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Codec registry: each built-in decoder is described by one AudioCodec_t, the Audio class
+ * reaches the decoders through it instead of per-codec branches.
+ * Decoders can be left out of the build, e.g. -DAUDIO_CODEC_AAC=0 in the build flags,
+ * a file of an omitted format is then rejected with "not supported".
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <vector>
+
+#ifndef AUDIO_CODEC_MP3
+  #define AUDIO_CODEC_MP3    1
+#endif
+#ifndef AUDIO_CODEC_AAC
+  #define AUDIO_CODEC_AAC    1  // also M4A
+#endif
+#ifndef AUDIO_CODEC_FLAC
+  #define AUDIO_CODEC_FLAC   1
+#endif
+#ifndef AUDIO_CODEC_OPUS
+  #define AUDIO_CODEC_OPUS   1
+#endif
+#ifndef AUDIO_CODEC_VORBIS
+  #define AUDIO_CODEC_VORBIS 1
+#endif
+
+enum : int { CODEC_NONE = 0, CODEC_WAV = 1, CODEC_MP3 = 2, CODEC_AAC = 3, CODEC_M4A = 4, CODEC_FLAC = 5,
+             CODEC_AACP = 6, CODEC_OPUS = 7, CODEC_OGG = 8, CODEC_VORBIS = 9};
+
+typedef struct AudioCodec_t {
+    const char* name;
+    uint16_t    frameSize;                                       // max block size of the input buffer
+    bool        f_needsPSRAM;
+    bool        f_interleavedSamps;                              // getOutputSamps() counts the samples of all channels
+    int8_t      parseOggDone;                                    // decode() result: header parsed, nothing to play, 0 if unused
+    uint32_t    (*arenaSize)();                                  // bytes taken from the codec arena, may be NULL
+    bool        (*isInit)();                                     // may be NULL, then allocate() is always called
+    bool        (*allocateBuffers)();
+    void        (*freeBuffers)();
+    void        (*flush)();                                      // drops the decoder state after a seek or a loop, may be NULL
+    int32_t     (*seekFrame)(uint8_t* buf, int32_t nBytes);      // the first frame to resume at after a seek, NULL: no seek
+    uint16_t    seekLookahead;                                   // bytes seekFrame() needs behind a frame (next header)
+    int32_t     (*findSyncWord)(uint8_t* buf, int32_t nBytes);
+    int32_t     (*decode)(uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf);
+    uint8_t     (*getChannels)();
+    uint32_t    (*getSampRate)();
+    uint8_t     (*getBitsPerSample)();
+    uint32_t    (*getBitRate)();
+    uint32_t    (*getOutputSamps)();
+    uint32_t    (*getAudioDataStart)();                          // ogg only, may be NULL
+    char*       (*getStreamTitle)();                             // may be NULL
+    std::vector<uint32_t> (*getMetadataBlockPicture)();          // may be NULL
+} AudioCodec_t;
+
+const AudioCodec_t* AudioCodec_Get(int codec);  // NULL if the codec is not built in (or WAV, OGG)
+void                AudioCodec_FreeAll();
+uint32_t            AudioCodec_MaxArenaSize();
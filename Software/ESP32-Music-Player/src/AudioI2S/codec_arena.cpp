@@ -0,0 +1,88 @@
+/*
+ * codec_arena.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "codec_arena.h"
+#include "codec_mem.h"
+
+uint8_t*  s_arena = NULL;
+uint32_t  s_arenaSize = 0;
+uint32_t  s_arenaMax = 0;         // the size of the largest codec
+uint32_t  s_arenaUsed = 0;
+uint32_t  s_arenaHighWater = 0;
+uint16_t  s_arenaBlocks = 0;      // blocks currently handed out
+
+//----------------------------------------------------------------------------------------------------------------------
+bool CodecArena_Init(uint32_t size){
+    if(CODEC_ARENA_SIZE) size = CODEC_ARENA_SIZE;
+    size = (size + 7) & ~7;
+    if(size > s_arenaMax) s_arenaMax = size; // e.g. a second Audio object
+    return s_arenaMax > 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool CodecArena_Reserve(uint32_t size){
+    // without PSRAM a board that plays only MP3 does not hold the FLAC buffers in DRAM for nothing
+    size = (size + 7) & ~7;
+    if(!s_arenaMax || !size) return false;
+    if(s_arena && s_arenaSize >= size) return true;
+    if(s_arenaBlocks) return false; // in use, the codec takes the heap
+    uint32_t want = psramFound() ? s_arenaMax : min(max(size, s_arenaSize), s_arenaMax);
+    if(s_arena) {free(s_arena); s_arena = NULL; s_arenaSize = 0;}
+    s_arena = (uint8_t*)CodecMem_Alloc(want, CODEC_MEM_COLD, "codec arena");
+    if(!s_arena){
+        log_e("codec arena: can't allocate %lu bytes, decoders use the heap", (long unsigned int)want);
+        return false;
+    }
+    s_arenaSize = want;
+    CodecArena_Reset();
+    return s_arenaSize >= size;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CodecArena_Deinit(){
+    if(s_arenaBlocks) {log_e("codec arena: %i blocks still in use", s_arenaBlocks); return;}
+    if(s_arena) {free(s_arena); s_arena = NULL;}
+    s_arenaSize = 0;
+    s_arenaMax = 0;
+    s_arenaUsed = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* CodecArena_Alloc(uint32_t size){ // 8 byte aligned, falls back to the heap
+    size = (size + 7) & ~7;
+    if(s_arena && s_arenaUsed + size <= s_arenaSize){
+        void* p = s_arena + s_arenaUsed;
+        s_arenaUsed += size;
+        s_arenaBlocks++;
+        if(s_arenaUsed > s_arenaHighWater) s_arenaHighWater = s_arenaUsed;
+        return p;
+    }
+    if(s_arena) log_w("codec arena exhausted, %lu bytes taken from the heap", (long unsigned int)size);
+    return CodecMem_Alloc(size, CODEC_MEM_AUTO, "arena overflow");
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CodecArena_Free(void* ptr){ // blocks of the arena are not freed one by one, the arena rewinds with the last one
+    if(!ptr) return;
+    if(!CodecArena_Contains(ptr)) {free(ptr); return;}
+    if(s_arenaBlocks) s_arenaBlocks--;
+    if(!s_arenaBlocks) s_arenaUsed = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CodecArena_Reset(){
+    s_arenaUsed = 0;
+    s_arenaBlocks = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool CodecArena_Contains(const void* ptr){
+    return s_arena && (const uint8_t*)ptr >= s_arena && (const uint8_t*)ptr < s_arena + s_arenaSize;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t CodecArena_GetSize(){
+    return s_arenaSize;
+}
+uint32_t CodecArena_GetUsed(){
+    return s_arenaUsed;
+}
+uint32_t CodecArena_GetHighWaterMark(){
+    return s_arenaHighWater;
+}
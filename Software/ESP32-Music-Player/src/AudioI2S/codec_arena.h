@@ -0,0 +1,31 @@
+/*
+ * codec_arena.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * One preallocated memory block shared by the decoders. The fixed-size decoder
+ * buffers are taken from it with a bump allocator instead of malloc/free per track,
+ * so that the heap does not fragment over a long uptime.
+ * The arena rewinds as soon as the last block is released (stream change).
+ * If the arena is not initialized or exhausted, the heap is used as before.
+ * The block is taken on the first codec open, not at startup: in PSRAM and sized to the largest codec when PSRAM
+ * is there, otherwise in DRAM and sized to the codec being opened, grown later while no block is handed out.
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#ifndef CODEC_ARENA_SIZE
+  #define CODEC_ARENA_SIZE 0 // 0: size of the largest codec, given to CodecArena_Init()
+#endif
+
+bool     CodecArena_Init(uint32_t size);       // the size of the largest codec, nothing is allocated yet
+bool     CodecArena_Reserve(uint32_t size);    // before a codec allocates its buffers, size: its need
+void     CodecArena_Deinit();
+void*    CodecArena_Alloc(uint32_t size);
+void     CodecArena_Free(void* ptr);
+void     CodecArena_Reset();
+bool     CodecArena_Contains(const void* ptr);
+uint32_t CodecArena_GetSize();
+uint32_t CodecArena_GetUsed();
+uint32_t CodecArena_GetHighWaterMark();
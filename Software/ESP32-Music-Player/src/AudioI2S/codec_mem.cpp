@@ -0,0 +1,91 @@
+/*
+ * codec_mem.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "codec_mem.h"
+
+#define CAPS_DRAM   (MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL)
+#define CAPS_PSRAM  (MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM)
+
+#if CODEC_MEM_PROFILE
+#define CODEC_MEM_PROFILE_TAGS 32
+
+typedef struct _memProfile{
+    const char* tag;
+    uint16_t    allocs;
+    uint16_t    misplaced;  // HOT/AUTO(ESP32) landed in PSRAM or COLD/AUTO(S3) in DRAM
+    uint32_t    dramBytes;
+    uint32_t    psramBytes;
+    uint32_t    failed;     // bytes that could not be allocated at all
+} memProfile_t;
+
+memProfile_t s_memProfile[CODEC_MEM_PROFILE_TAGS];
+
+//----------------------------------------------------------------------------------------------------------------------
+void memProfileCount(const char* tag, uint32_t size, bool dram, bool preferred, bool ok){
+    if(!tag) tag = "?";
+    memProfile_t* mp = NULL;
+    for(int i = 0; i < CODEC_MEM_PROFILE_TAGS; i++){
+        if(!s_memProfile[i].tag){ s_memProfile[i].tag = tag; mp = &s_memProfile[i]; break; }
+        if(s_memProfile[i].tag == tag || !strcmp(s_memProfile[i].tag, tag)){ mp = &s_memProfile[i]; break; }
+    }
+    if(!mp) return; // table full
+    mp->allocs++;
+    if(!ok)            { mp->failed += size; return; }
+    if(!preferred)     mp->misplaced++;
+    if(dram)           mp->dramBytes += size;
+    else               mp->psramBytes += size;
+}
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+void* CodecMem_Alloc(uint32_t size, uint8_t use, const char* tag){
+    uint32_t first = CAPS_DRAM, second = CAPS_PSRAM;
+    switch(use){
+        case CODEC_MEM_HOT:  break;
+        case CODEC_MEM_COLD: first = CAPS_PSRAM; second = CAPS_DRAM; break;
+        case CODEC_MEM_DRAM: second = 0; break;
+        default:
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+            first = CAPS_PSRAM; second = CAPS_DRAM; // ESP32-S3: If there is PSRAM, prefer it
+#endif
+            break;                                  // ESP32, PSRAM is too slow, prefer SRAM
+    }
+    bool preferred = true;
+    void* p = heap_caps_malloc(size, first);
+    if(!p && second){ p = heap_caps_malloc(size, second); preferred = false; }
+#if CODEC_MEM_PROFILE
+    bool dram = (preferred ? first : second) == CAPS_DRAM;
+    memProfileCount(tag, size, dram, preferred, p != NULL);
+#else
+    (void)tag; (void)preferred;
+#endif
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* CodecMem_Calloc(uint32_t n, uint32_t size, uint8_t use, const char* tag){
+    void* p = CodecMem_Alloc(n * size, use, tag);
+    if(p) memset(p, 0, n * size);
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CodecMem_PrintProfile(Print& out){
+#if CODEC_MEM_PROFILE
+    out.printf("tag                 allocs   DRAM bytes  PSRAM bytes  misplaced  failed\n");
+    for(int i = 0; i < CODEC_MEM_PROFILE_TAGS; i++){
+        const memProfile_t* mp = &s_memProfile[i];
+        if(!mp->tag) break;
+        out.printf("%-18s %7u %12lu %12lu %10u %7lu\n", mp->tag, mp->allocs, (long unsigned int)mp->dramBytes,
+                   (long unsigned int)mp->psramBytes, mp->misplaced, (long unsigned int)mp->failed);
+    }
+#else
+    out.printf("memory profile is disabled, build with -DCODEC_MEM_PROFILE=1\n");
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CodecMem_ResetProfile(){
+#if CODEC_MEM_PROFILE
+    memset(s_memProfile, 0, sizeof(s_memProfile));
+#endif
+}
@@ -0,0 +1,47 @@
+/*
+ * codec_mem.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Placement policy for the decoders, instead of a private heap_caps macro in every codec.
+ * Buffers are requested as HOT (inner loops, DRAM first), COLD (headers, setup, PSRAM first),
+ * DRAM (internal only) or AUTO (the target default: DRAM on ESP32, PSRAM on ESP32-S3 with its faster PSRAM cache).
+ * Memory of CodecMem_Alloc() is released with free().
+ *
+ * Build flags:
+ *   CODEC_IRAM_FUNCS=1   functions marked CODEC_HOT_FUNC (synthesis filters, FFT kernels, LPC) are placed in IRAM,
+ *                        costs about 6 KB IRAM, avoids flash cache misses while WiFi or SD use the cache
+ *   CODEC_DRAM_TABLES=1  constant tables marked CODEC_HOT_TABLE are copied to DRAM, about 10 KB
+ *   CODEC_MEM_PROFILE=1  every CodecMem_Alloc() is counted per tag, see CodecMem_PrintProfile()
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#ifndef CODEC_IRAM_FUNCS
+  #define CODEC_IRAM_FUNCS  0
+#endif
+#ifndef CODEC_DRAM_TABLES
+  #define CODEC_DRAM_TABLES 0
+#endif
+#ifndef CODEC_MEM_PROFILE
+  #define CODEC_MEM_PROFILE 0
+#endif
+
+#if CODEC_IRAM_FUNCS
+  #define CODEC_HOT_FUNC  IRAM_ATTR
+#else
+  #define CODEC_HOT_FUNC
+#endif
+#if CODEC_DRAM_TABLES
+  #define CODEC_HOT_TABLE DRAM_ATTR
+#else
+  #define CODEC_HOT_TABLE PROGMEM
+#endif
+
+enum : uint8_t { CODEC_MEM_AUTO = 0, CODEC_MEM_HOT = 1, CODEC_MEM_COLD = 2, CODEC_MEM_DRAM = 3 };
+
+void*    CodecMem_Alloc(uint32_t size, uint8_t use, const char* tag);
+void*    CodecMem_Calloc(uint32_t n, uint32_t size, uint8_t use, const char* tag);
+void     CodecMem_PrintProfile(Print& out);
+void     CodecMem_ResetProfile();
@@ -0,0 +1,206 @@
+/*
+ * fat_runs.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "fat_runs.h"
+
+#define SECTOR_SIZE 512
+
+static uint16_t le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t fold(uint16_t c) { return c >= 'a' && c <= 'z' ? c - 32 : c; }
+
+//----------------------------------------------------------------------------------------------------------------------
+bool FatVolume::bootSector(const uint8_t* b) {
+    uint8_t spc = b[13];
+    if(le16(b + 510) != 0xAA55 || (b[0] != 0xEB && b[0] != 0xE9)) return false;
+    if(le16(b + 11) != SECTOR_SIZE || !spc || (spc & (spc - 1))) return false;
+    return le16(b + 14) && (b[16] == 1 || b[16] == 2); // reserved sectors, FATs
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatVolume::mount(fatRead_t read, void* ctx) {
+    m_read = read;
+    m_ctx = ctx;
+    m_type = 0;
+    m_winLba = UINT32_MAX;
+    uint32_t vol = 0;
+    if(!read(ctx, 0, 1, m_win)) return false;
+    if(!bootSector(m_win)) { // a partition table
+        if(le16(m_win + 510) != 0xAA55) return false;
+        for(int i = 0; i < 4 && !vol; i++) {
+            const uint8_t* e = m_win + 446 + 16 * i;
+            if(e[4] == 0x01 || e[4] == 0x04 || e[4] == 0x06 || e[4] == 0x0B || e[4] == 0x0C || e[4] == 0x0E) vol = le32(e + 8);
+        }
+        if(!vol || !read(ctx, vol, 1, m_win) || !bootSector(m_win)) return false;
+    }
+    const uint8_t* b = m_win;
+    uint32_t spc = b[13];
+    uint32_t rsvd = le16(b + 14);
+    uint32_t fats = b[16];
+    uint32_t rootEntries = le16(b + 17);
+    uint32_t total = le16(b + 19) ? le16(b + 19) : le32(b + 32);
+    uint32_t fatSize = le16(b + 22) ? le16(b + 22) : le32(b + 36);
+    m_rootSectors = (rootEntries * 32 + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    uint32_t meta = rsvd + fats * fatSize + m_rootSectors;
+    if(!fatSize || total <= meta) return false;
+    m_fatLba = vol + rsvd;
+    m_rootLba = m_fatLba + fats * fatSize;
+    m_dataLba = m_rootLba + m_rootSectors;
+    m_clusterSectors = spc;
+    m_clusters = (total - meta) / spc;
+    if(m_clusters < 4085) return false;           // FAT12
+    uint8_t type = m_clusters < 65525 ? 16 : 32;  // by the number of clusters, as FatFs decides it
+    if(type == 32 && (rootEntries || le16(b + 22))) return false;
+    if((uint64_t)fatSize * SECTOR_SIZE < (uint64_t)(m_clusters + 2) * (type / 8)) return false;
+    m_rootCluster = type == 32 ? le32(b + 44) : 0;
+    m_type = type;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FatVolume::next(uint32_t cluster) {
+    uint32_t off = cluster * (m_type / 8);
+    uint32_t lba = m_fatLba + off / SECTOR_SIZE;
+    if(lba != m_winLba) {
+        m_winLba = UINT32_MAX;
+        if(!read(lba, 1, m_win)) return 0;
+        m_winLba = lba;
+    }
+    off %= SECTOR_SIZE;
+    uint32_t e = m_type == 32 ? le32(m_win + off) & 0x0FFFFFFF : le16(m_win + off);
+    if(e < 2 || e >= m_clusters + 2) return 0; // end of chain, free or bad cluster
+    return e;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatVolume::lfnEquals(const char* name, size_t len) {
+    // UTF-8 of the path against UTF-16 of the long name
+    int16_t n = 0, i = 0;
+    size_t  k = 0;
+    while(n < m_lfnLen && m_lfn[n]) n++;
+    while(k < len && i < n) {
+        uint8_t  c = name[k];
+        int      more = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        uint32_t u = more ? c & (0x3F >> more) : c;
+        if(k + more >= len) return false;
+        for(int j = 1; j <= more; j++) u = (u << 6) | (name[k + j] & 0x3F);
+        k += more + 1;
+        if(u >= 0x10000) { // a surrogate pair
+            if(i + 1 >= n || m_lfn[i] != 0xD800 + ((u - 0x10000) >> 10) || m_lfn[i + 1] != 0xDC00 + (u & 0x3FF)) return false;
+            i += 2;
+            continue;
+        }
+        if(fold(m_lfn[i]) != fold(u)) return false;
+        i++;
+    }
+    return k == len && i == n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatVolume::entryMatches(const uint8_t* e, const char* name, size_t len) {
+    // the long name if it belongs to this entry (checksum of the short name), else the short name
+    uint8_t sum = 0;
+    for(int i = 0; i < 11; i++) sum = ((sum & 1) << 7) + (sum >> 1) + e[i];
+    if(m_lfnLen > 0 && sum == m_lfnSum && lfnEquals(name, len)) return true;
+    char sfn[13];
+    int  n = 0;
+    for(int i = 0; i < 8 && e[i] != ' '; i++) sfn[n++] = i == 0 && e[0] == 0x05 ? 0xE5 : e[i];
+    if(e[8] != ' ') sfn[n++] = '.';
+    for(int i = 8; i < 11 && e[i] != ' '; i++) sfn[n++] = e[i];
+    if((size_t)n != len) return false;
+    for(int i = 0; i < n; i++) {
+        if(fold((uint8_t)sfn[i]) != fold((uint8_t)name[i])) return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatVolume::findEntry(uint32_t dirCluster, const char* name, size_t len, uint8_t* entry) {
+    // dirCluster 0: the fixed root directory of FAT16
+    static const uint8_t lfnOffs[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+    uint32_t cluster = dirCluster;
+    uint32_t sectors = dirCluster ? m_clusterSectors : m_rootSectors;
+    uint32_t lba0 = dirCluster ? lba(dirCluster) : m_rootLba;
+    m_lfnLen = -1;
+    for(uint32_t chain = 0; chain <= m_clusters; chain++) {
+        for(uint32_t s = 0; s < sectors; s++) {
+            if(!read(lba0 + s, 1, m_win)) return false;
+            m_winLba = UINT32_MAX; // no longer a FAT sector
+            for(const uint8_t* e = m_win; e < m_win + SECTOR_SIZE; e += 32) {
+                if(e[0] == 0) return false; // end of the directory
+                if(e[0] == 0xE5) { m_lfnLen = -1; continue; }
+                if(e[11] == 0x0F) { // a part of a long name, the last part comes first
+                    uint8_t ord = e[0] & 0x3F;
+                    if(ord < 1 || ord > 20) { m_lfnLen = -1; continue; }
+                    if(e[0] & 0x40) { m_lfnLen = ord * 13; m_lfnSum = e[13]; }
+                    else if(m_lfnLen < 0 || e[13] != m_lfnSum || ord * 13 > m_lfnLen) { m_lfnLen = -1; continue; }
+                    for(int k = 0; k < 13; k++) m_lfn[(ord - 1) * 13 + k] = le16(e + lfnOffs[k]);
+                    continue;
+                }
+                bool match = !(e[11] & 0x08) && entryMatches(e, name, len); // not the volume label
+                m_lfnLen = -1;
+                if(match) { memcpy(entry, e, 32); return true; }
+            }
+        }
+        if(!dirCluster) return false;
+        cluster = next(cluster);
+        if(!cluster) return false;
+        lba0 = lba(cluster);
+    }
+    return false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatVolume::find(const char* path, uint32_t* cluster, uint32_t* size) {
+    uint32_t dir = m_rootCluster;
+    uint8_t  e[32];
+    if(!m_type) return false;
+    while(*path) {
+        while(*path == '/') path++;
+        size_t len = strcspn(path, "/");
+        if(!len) return false; // the path of a directory
+        if(!findEntry(dir, path, len, e)) return false;
+        path += len;
+        uint32_t c = (m_type == 32 ? le16(e + 20) << 16 : 0) | le16(e + 26);
+        bool     isDir = e[11] & 0x10;
+        while(*path == '/') path++;
+        if(*path) {
+            if(!isDir || (c && c < 2)) return false;
+            dir = c ? c : m_rootCluster; // ".." of a first level directory is 0
+            continue;
+        }
+        if(isDir) return false;
+        *cluster = c;
+        *size = le32(e + 28);
+        return true;
+    }
+    return false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FatRuns::build(FatVolume& vol, uint32_t cluster, uint32_t size, uint32_t maxRuns) {
+    uint32_t clusterBytes = vol.clusterSectors() * SECTOR_SIZE;
+    uint32_t n = size / clusterBytes + (size % clusterBytes != 0);
+    uint32_t prev = 0;
+    clear();
+    for(uint32_t i = 0; i < n; i++) {
+        if(cluster < 2) { clear(); return false; } // the chain ends before the file
+        if(i == 0 || cluster != prev + 1) {
+            if(m_runs.size() == maxRuns) { clear(); return false; }
+            m_runs.push_back({i * clusterBytes, vol.lba(cluster)});
+        }
+        prev = cluster;
+        if(i + 1 < n) cluster = vol.next(cluster);
+    }
+    m_size = size;
+    return n > 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FatRuns::map(uint32_t pos, uint32_t* lba) const {
+    if(pos >= m_size) return 0;
+    size_t lo = 0, hi = m_runs.size(); // the last run that starts at or before pos
+    while(hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if(m_runs[mid].pos <= pos) lo = mid;
+        else hi = mid;
+    }
+    uint32_t end = lo + 1 < m_runs.size() ? m_runs[lo + 1].pos : m_size;
+    *lba = m_runs[lo].lba + (pos - m_runs[lo].pos) / SECTOR_SIZE;
+    return end - pos;
+}
@@ -0,0 +1,71 @@
+/*
+ * fat_runs.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * The cluster runs of a file on a FAT16 or FAT32 volume: the clusters of its FAT chain that follow each other on the
+ * card, each run as the file position and the sector where it starts. The chain is walked once when the file is
+ * opened, then a file position maps to a sector without a FAT lookup, as the fast seek table of FatFs (CLMT) does it.
+ * FatFs itself follows the chain cluster by cluster and reads a FAT sector whenever the next link is not in its
+ * window, on a fragmented card every few clusters; the fast seek needs FF_USE_FASTSEEK, which the core leaves off.
+ * FatVolume reads the card through a sector read function, on the ESP32 the FatFs disk driver, on the host an image.
+ * Read only, 512 byte sectors, long file names are compared case insensitively for ASCII.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <vector>
+
+typedef bool (*fatRead_t)(void* ctx, uint32_t lba, uint32_t count, uint8_t* buf); // count sectors of 512 bytes
+
+class FatVolume {
+
+public:
+    bool     mount(fatRead_t read, void* ctx);  // the first FAT partition of the MBR or a volume without partitions
+    bool     find(const char* path, uint32_t* cluster, uint32_t* size); // first cluster and size of a file
+    uint32_t next(uint32_t cluster);            // the next cluster of the chain, 0 at its end or for a bad link
+    bool     read(uint32_t lba, uint32_t count, uint8_t* buf) { return m_read(m_ctx, lba, count, buf); }
+    uint32_t lba(uint32_t cluster) { return m_dataLba + (cluster - 2) * m_clusterSectors; }
+    uint32_t clusterSectors() { return m_clusterSectors; }
+    uint8_t  type() { return m_type; }          // 16 or 32, 0 if not mounted
+
+private:
+    bool     bootSector(const uint8_t* b);
+    bool     findEntry(uint32_t dirCluster, const char* name, size_t len, uint8_t* entry);
+    bool     entryMatches(const uint8_t* e, const char* name, size_t len);
+    bool     lfnEquals(const char* name, size_t len);
+
+    fatRead_t m_read = NULL;
+    void*     m_ctx = NULL;
+    uint8_t   m_type = 0;
+    uint32_t  m_fatLba = 0;
+    uint32_t  m_rootLba = 0;         // FAT16: the fixed root directory
+    uint32_t  m_rootSectors = 0;
+    uint32_t  m_rootCluster = 0;     // FAT32: the first cluster of the root directory
+    uint32_t  m_dataLba = 0;         // cluster 2
+    uint32_t  m_clusterSectors = 0;
+    uint32_t  m_clusters = 0;
+    uint32_t  m_winLba = UINT32_MAX; // the sector in m_win
+    uint8_t   m_win[512];            // a FAT or directory sector
+    uint16_t  m_lfn[260];            // the long name of the entries that precede a directory entry
+    int16_t   m_lfnLen = -1;
+    uint8_t   m_lfnSum = 0;
+};
+
+typedef struct _fatRun{
+    uint32_t pos;  // file position of the run, a multiple of the cluster size
+    uint32_t lba;  // its first sector
+} fatRun_t;
+
+class FatRuns {
+
+public:
+    bool     build(FatVolume& vol, uint32_t cluster, uint32_t size, uint32_t maxRuns); // false: chain broken or too many runs
+    uint32_t map(uint32_t pos, uint32_t* lba) const; // sector of pos (a multiple of 512), returns the bytes to the end of its run
+    uint32_t count() const { return m_runs.size(); }
+    void     clear() { std::vector<fatRun_t>().swap(m_runs); m_size = 0; }
+
+private:
+    std::vector<fatRun_t> m_runs;
+    uint32_t              m_size = 0;
+};
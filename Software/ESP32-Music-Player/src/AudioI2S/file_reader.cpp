@@ -0,0 +1,341 @@
+/*
+ * file_reader.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "file_reader.h"
+#include "codec_mem.h"
+#include "ff.h"
+#include "diskio_impl.h"
+
+#define SECTOR_SIZE 512
+
+static_assert(AUDIO_FILE_READER_CHUNK >= SECTOR_SIZE && !(AUDIO_FILE_READER_CHUNK & (AUDIO_FILE_READER_CHUNK - 1)),
+              "AUDIO_FILE_READER_CHUNK must be a power of two of at least 512");
+
+fatRead_t FileReader::s_blockRead = NULL;
+void*     FileReader::s_blockCtx = NULL;
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool ffRead(void* ctx, uint32_t lba, uint32_t count, uint8_t* buf) {
+    // the disk driver FatFs reads the drive with, SDMMC or SDSPI
+    return ff_disk_read((BYTE)(uintptr_t)ctx, buf, lba, count) == RES_OK;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+FileReader::FileReader() {
+    m_mutex = xSemaphoreCreateMutex();
+}
+//----------------------------------------------------------------------------------------------------------------------
+FileReader::~FileReader() {
+    end();
+    vSemaphoreDelete(m_mutex);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FileReader::begin(fs::FS& fs, const char* path, uint32_t pos) {
+    end();
+    m_file = fs.open(path);
+    if(!m_file) { log_e("file reader: can't open %s", path); return false; }
+    for(int i = 0; i < 2; i++) {
+        bool dma;
+        m_chunk[i].data = chunkAlloc(&dma);
+        m_chunk[i].state = CHUNK_FREE;
+        if(!m_chunk[i].data) { log_e("file reader: not enough memory"); end(); return false; }
+        if(!dma) log_w("file reader: chunk %i in PSRAM, the card driver copies it sector by sector", i);
+    }
+    m_fileSize = m_file.size();
+    m_path = strdup(path);
+    m_runCount = 0;
+    m_readPos = pos;
+    m_nextPos = pos;
+    m_seekGen = 0;
+    m_stackUnused = AUDIO_FILE_READER_STACK;
+    m_f_stop = false;
+    m_f_taskRunning = true;
+    if(xTaskCreate(taskEntry, "AudioFileReader", AUDIO_FILE_READER_STACK, this, AUDIO_FILE_READER_PRIO, &m_task) != pdPASS) {
+        log_e("file reader: can't create task");
+        m_task = NULL;
+        m_f_taskRunning = false;
+        end();
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::end() {
+    if(m_task) {
+        m_f_stop = true;
+        xTaskNotifyGive(m_task);
+        while(m_f_taskRunning) vTaskDelay(1); // a read in flight has to finish first
+        m_task = NULL;
+    }
+    if(m_file) m_file.close();
+    if(m_path) { free(m_path); m_path = NULL; }
+    m_runs.clear();
+    m_blockRead = NULL;
+    for(int i = 0; i < 2; i++) {
+        if(m_chunk[i].data) { free(m_chunk[i].data); m_chunk[i].data = NULL; }
+        m_chunk[i].state = CHUNK_FREE;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t FileReader::read(uint8_t* buf, size_t len) {
+    size_t   bytes = 0;
+    bool     f_freed = false;
+    if(!m_task) return 0;
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    while(len) {
+        chunk_t* c = NULL;
+        for(int i = 0; i < 2; i++) {
+            if(m_chunk[i].state == CHUNK_FULL && m_chunk[i].filePos + m_chunk[i].rd == m_readPos) { c = &m_chunk[i]; break; }
+        }
+        if(!c) break; // next chunk not prefetched yet
+        size_t n = min((size_t)(c->len - c->rd), len);
+        memcpy(buf, c->data + c->rd, n);
+        c->rd += n;
+        buf += n;
+        len -= n;
+        bytes += n;
+        m_readPos += n;
+        if(c->rd == c->len) { c->state = CHUNK_FREE; f_freed = true; }
+    }
+    xSemaphoreGive(m_mutex);
+    if(f_freed) xTaskNotifyGive(m_task);
+    return bytes;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::seek(uint32_t pos) {
+    if(!m_task) return;
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    m_seekGen++; // the chunk in flight is dropped when its read returns
+    for(int i = 0; i < 2; i++) {
+        if(m_chunk[i].state == CHUNK_FULL) m_chunk[i].state = CHUNK_FREE;
+    }
+    m_readPos = pos;
+    m_nextPos = pos;
+    xSemaphoreGive(m_mutex);
+    xTaskNotifyGive(m_task);
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t* FileReader::chunkAlloc(bool* dma) {
+    uint8_t* p = NULL;
+#if AUDIO_FILE_READER_DMA
+    p = (uint8_t*)heap_caps_malloc(AUDIO_FILE_READER_CHUNK, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#endif
+    *dma = p != NULL;
+    if(!p) p = (uint8_t*)CodecMem_Alloc(AUDIO_FILE_READER_CHUNK, CODEC_MEM_COLD, "file reader");
+    return p;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FileReader::readLen(uint32_t pos, uint32_t fileSize) {
+    // after a seek the first read ends on a chunk boundary, all further reads are chunk aligned
+    uint32_t len = AUDIO_FILE_READER_CHUNK - (pos % AUDIO_FILE_READER_CHUNK);
+    if(pos + len > fileSize) len = fileSize - pos;
+    return len;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::setBlockDevice(fatRead_t read, void* ctx) {
+    s_blockRead = read;
+    s_blockCtx = ctx;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FileReader::findRuns(const char* path, uint32_t size, FatRuns* runs, fatRead_t* read, void** ctx) {
+    // the volume of setBlockDevice() or the FatFs drive that holds a file of this path and size ("0:" is the physical
+    // drive 0, the core mounts one partition per drive)
+    *read = s_blockRead;
+    *ctx = s_blockCtx;
+    if(!*read) {
+        typedef struct { FILINFO fno; char path[FF_MAX_LFN + 8]; } probe_t; // not on the task stack
+        probe_t* p = (probe_t*)malloc(sizeof(probe_t));
+        if(!p) return false;
+        for(int d = 0; d < FF_VOLUMES && !*read; d++) {
+            snprintf(p->path, sizeof(p->path), "%d:%s", d, path);
+            if(f_stat(p->path, &p->fno) == FR_OK && !(p->fno.fattrib & AM_DIR) && p->fno.fsize == size) {
+                *read = ffRead;
+                *ctx = (void*)(uintptr_t)d;
+            }
+        }
+        free(p);
+        if(!*read) return false;
+    }
+    FatVolume* vol = new FatVolume;
+    uint32_t   cluster = 0, fileSize = 0;
+    bool       ok = vol->mount(*read, *ctx) && vol->find(path, &cluster, &fileSize) && fileSize == size &&
+                    runs->build(*vol, cluster, size, AUDIO_FILE_READER_MAX_RUNS);
+    delete vol;
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int32_t FileReader::readRuns(const FatRuns& runs, fatRead_t read, void* ctx, uint32_t pos, uint32_t len, uint8_t* buf) {
+    // pos on a sector, a multi-sector read up to len or the end of the run, the last sector of the file is read whole
+    uint32_t done = 0;
+    while(done < len) {
+        uint32_t lba;
+        uint32_t n = runs.map(pos + done, &lba);
+        if(!n) break;
+        if(n > len - done) n = len - done;
+        if(!read(ctx, lba, (n + SECTOR_SIZE - 1) / SECTOR_SIZE, buf + done)) return done ? done : -1;
+        done += n;
+    }
+    return done;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::taskEntry(void* param) {
+    ((FileReader*)param)->taskLoop();
+    vTaskDelete(NULL);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::taskLoop() {
+    uint32_t filePos = 0; // position of m_file
+#if AUDIO_FILE_READER_RUNS
+    uint32_t t = millis();
+    if(findRuns(m_path, m_fileSize, &m_runs, &m_blockRead, &m_blockCtx)) {
+        log_d("file reader: %lu cluster runs in %lu ms", (long unsigned)m_runs.count(), (long unsigned)(millis() - t));
+        xSemaphoreTake(m_mutex, portMAX_DELAY);
+        m_runCount = m_runs.count();
+        xSemaphoreGive(m_mutex);
+    }
+    else {
+        m_runs.clear();
+        m_blockRead = NULL;
+    }
+#endif
+    while(!m_f_stop) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+        while(!m_f_stop) {
+            xSemaphoreTake(m_mutex, portMAX_DELAY);
+            chunk_t* c = NULL;
+            if(m_nextPos < m_fileSize) {
+                for(int i = 0; i < 2; i++) {
+                    if(m_chunk[i].state == CHUNK_FREE) { c = &m_chunk[i]; break; }
+                }
+            }
+            if(!c) { xSemaphoreGive(m_mutex); break; } // both chunks full or end of file
+            uint32_t gen = m_seekGen;
+            uint32_t pos = m_nextPos;
+            c->state = CHUNK_FILLING;
+            xSemaphoreGive(m_mutex);
+
+            uint32_t len = readLen(pos, m_fileSize);
+            uint32_t start = m_blockRead ? pos & ~(SECTOR_SIZE - 1) : pos; // the runs are read in whole sectors
+            if(!m_blockRead && pos != filePos) m_file.seek(pos);
+            uint32_t t0 = micros();
+            int32_t  n = m_blockRead ? readRuns(m_runs, m_blockRead, m_blockCtx, start, pos + len - start, c->data)
+                                     : m_file.read(c->data, len);
+            uint32_t us = micros() - t0;
+            uint32_t stackUnused = uxTaskGetStackHighWaterMark(NULL); // read() down to the card driver is the deepest
+            if(!m_blockRead) filePos = pos + (n > 0 ? n : 0);
+
+            xSemaphoreTake(m_mutex, portMAX_DELAY);
+            countLatency(us);
+            if(stackUnused < m_stackUnused) m_stackUnused = stackUnused;
+            if(gen == m_seekGen && n > (int32_t)(pos - start)) {
+                c->filePos = start;
+                c->len = n;
+                c->rd = pos - start;
+                c->state = CHUNK_FULL;
+                m_nextPos = start + n;
+            }
+            else {
+                c->state = CHUNK_FREE;
+                if(gen == m_seekGen) m_nextPos = m_fileSize; // read error, stop prefetching
+            }
+            xSemaphoreGive(m_mutex);
+        }
+    }
+    log_d("file reader: %lu bytes of the stack unused", (long unsigned)uxTaskGetStackHighWaterMark(NULL));
+    m_f_taskRunning = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::countLatency(uint32_t us) {
+    uint8_t i = 0;
+    while(i < 23 && (1UL << i) <= us) i++;
+    m_latHist[i]++;
+    if(us > m_latMax) m_latMax = us;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::getLatency(uint32_t* p50, uint32_t* p99, uint32_t* maxUs) {
+    // percentiles from the histogram, given as the upper bound of the bucket
+    uint32_t total = 0, sum = 0;
+    uint32_t hist[24];
+    xSemaphoreTake(m_mutex, portMAX_DELAY); // the task counts under the mutex
+    memcpy(hist, m_latHist, sizeof(hist));
+    *maxUs = m_latMax;
+    xSemaphoreGive(m_mutex);
+    *p50 = 0; *p99 = 0;
+    for(int i = 0; i < 24; i++) total += hist[i];
+    if(!total) return;
+    for(int i = 0; i < 24; i++) {
+        sum += hist[i];
+        if(!*p50 && sum * 100 >= total * 50) *p50 = 1UL << i;
+        if(!*p99 && sum * 100 >= total * 99) { *p99 = 1UL << i; break; }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FileReader::getRuns() {
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    uint32_t n = m_runCount;
+    xSemaphoreGive(m_mutex);
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FileReader::getStackUnused() {
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    uint32_t n = m_stackUnused;
+    xSemaphoreGive(m_mutex);
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FileReader::resetLatency() {
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    memset(m_latHist, 0, sizeof(m_latHist));
+    m_latMax = 0;
+    xSemaphoreGive(m_mutex);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FileReader::benchmark(fs::FS& fs, const char* path, Print& out, readBench_t* result) {
+    // reads the whole file twice in the task's manner, through the file system and through the cluster runs, run it
+    // with the player stopped
+    fs::File file = fs.open(path);
+    if(!file) { out.printf("benchmark: can't open %s\n", path); return false; }
+    bool     dma;
+    uint8_t* buf = chunkAlloc(&dma); // as the task
+    if(!buf) { file.close(); return false; }
+    out.printf("chunk of %u bytes in %s\n", AUDIO_FILE_READER_CHUNK, dma ? "DMA capable DRAM" : "PSRAM");
+    uint32_t  fileSize = file.size();
+    FatRuns   runs;
+    fatRead_t read = NULL;
+    void*     ctx = NULL;
+    bool      f_runs = findRuns(path, fileSize, &runs, &read, &ctx);
+    if(f_runs) out.printf("%lu cluster runs\n", (long unsigned)runs.count());
+    else out.printf("no cluster runs: not on a FAT16/FAT32 volume or more than %u runs\n", AUDIO_FILE_READER_MAX_RUNS);
+    if(result) memset(result, 0, 2 * sizeof(readBench_t));
+    for(int pass = 0; pass < (f_runs ? 2 : 1); pass++) {
+        uint32_t pos = 0, maxUs = 0, reads = 0;
+        file.seek(0);
+        uint32_t t0 = micros();
+        while(pos < fileSize) {
+            uint32_t len = readLen(pos, fileSize);
+            uint32_t t1 = micros();
+            int32_t  n = pass ? readRuns(runs, read, ctx, pos, len, buf) : (int32_t)file.read(buf, len);
+            uint32_t us = micros() - t1;
+            if(n <= 0) break;
+            if(us > maxUs) maxUs = us;
+            pos += n;
+            reads++;
+        }
+        uint32_t total = micros() - t0;
+        uint32_t kBps = total ? (uint64_t)pos * 1000 / total : 0;
+        out.printf("%-12s %lu reads, %lu.%02lu MB/s, worst read %lu us\n", pass ? "cluster runs" : "file system",
+                   (long unsigned)reads, (long unsigned)(kBps / 1000), (long unsigned)(kBps / 10 % 100), (long unsigned)maxUs);
+        if(result) {
+            result[pass].reads = reads;
+            result[pass].kBps = kBps;
+            result[pass].worstUs = maxUs;
+        }
+    }
+    free(buf);
+    file.close();
+    return true;
+}
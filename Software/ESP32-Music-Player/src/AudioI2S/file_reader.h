@@ -0,0 +1,113 @@
+/*
+ * file_reader.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Prefetches a local audio file in its own task, so that SD card latency (card internal garbage collection,
+ * FAT lookups) stalls this task and not Audio::loop(), which feeds the decoder and I2S.
+ * The task reads sector aligned chunks through a second file handle into two buffers, Audio::processLocalFile()
+ * takes the data from there without waiting. A seek drops the prefetched data, a read in flight is discarded.
+ * Reads end on chunk boundaries, after a seek too, so they start on a sector and FatFs transfers whole sectors straight
+ * into the chunk instead of copying them through its sector buffer.
+ * On a FAT16/FAT32 card the task takes the cluster runs of the file first (fat_runs.h) and then reads the sectors from
+ * the disk driver itself: one multi-sector read per chunk, split only where a run ends, no FAT lookups while playing.
+ * The chunk size is a power of two and so is the cluster size, every read begins on a cluster boundary or stays within
+ * one cluster. Without a FAT volume under the file (SPIFFS, exFAT, more than AUDIO_FILE_READER_MAX_RUNS runs) the
+ * task reads through the file handle.
+ * The chunks are taken from DMA capable internal RAM, the card driver transfers all sectors of a read in one go. A
+ * chunk in PSRAM costs a bounce copy: the SDMMC and SDSPI drivers read it one sector per transfer through their own
+ * DMA buffer and copy each sector. PSRAM is used if there is not enough DMA capable RAM or AUDIO_FILE_READER_DMA is 0
+ * (the 16 KB of DRAM are needed elsewhere), a smaller AUDIO_FILE_READER_CHUNK keeps the DRAM use down instead.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <FS.h>
+#include "fat_runs.h"
+
+#ifndef AUDIO_FILE_READER
+  #define AUDIO_FILE_READER         1     // 0: Audio reads the file synchronously in loop() as before
+#endif
+#ifndef AUDIO_FILE_READER_CHUNK
+  #define AUDIO_FILE_READER_CHUNK   8192  // bytes per read, a power of two of at least 512, two of them are used
+#endif
+#ifndef AUDIO_FILE_READER_DMA
+  #define AUDIO_FILE_READER_DMA     1     // chunks in DMA capable DRAM, 0: PSRAM first (bounce copy in the card driver)
+#endif
+#ifndef AUDIO_FILE_READER_STACK
+  #define AUDIO_FILE_READER_STACK   4096  // bytes, 3.4 KB used on the host (test_file_reader), on the target see
+                                          // readerStackUnused of Audio::getStats()
+#endif
+#ifndef AUDIO_FILE_READER_RUNS
+  #define AUDIO_FILE_READER_RUNS    1     // 0: always read through FatFs
+#endif
+#ifndef AUDIO_FILE_READER_MAX_RUNS
+  #define AUDIO_FILE_READER_MAX_RUNS 512  // 8 bytes each, a file in more runs is read through FatFs
+#endif
+#ifndef AUDIO_FILE_READER_PRIO
+  #define AUDIO_FILE_READER_PRIO    2     // above the Arduino loop task
+#endif
+
+typedef struct _readBench{ // FileReader::benchmark(), [0] through the file system, [1] the cluster runs
+    uint32_t reads;
+    uint32_t kBps;        // sustained
+    uint32_t worstUs;     // the slowest read
+} readBench_t;
+
+class FileReader {
+
+public:
+    FileReader();
+    ~FileReader();
+    bool     begin(fs::FS& fs, const char* path, uint32_t pos); // opens a second handle and starts the task
+    void     end();                                            // stops the task and closes the file
+    bool     isActive() { return m_task != NULL; }
+    size_t   read(uint8_t* buf, size_t len);                   // prefetched bytes only, does not wait
+    void     seek(uint32_t pos);                               // drops the prefetched data
+    uint32_t position() { return m_readPos; }                  // file position of the next byte read() returns
+    void     getLatency(uint32_t* p50, uint32_t* p99, uint32_t* maxUs); // SD read latency in µs
+    void     resetLatency();
+    uint32_t getStackUnused();                                 // bytes of AUDIO_FILE_READER_STACK never used since begin(), kept after end()
+    uint32_t getRuns();                                        // cluster runs of the file, 0: read through the file system
+    static void setBlockDevice(fatRead_t read, void* ctx);     // the card under the files, default: the FatFs drive of the file
+    static bool benchmark(fs::FS& fs, const char* path, Print& out = Serial, readBench_t* result = NULL);
+
+private:
+    enum : uint8_t { CHUNK_FREE = 0, CHUNK_FILLING = 1, CHUNK_FULL = 2 };
+    typedef struct _chunk{
+        uint8_t* data;
+        uint32_t filePos;  // file position of data[0]
+        uint32_t len;      // valid bytes
+        uint32_t rd;       // bytes already taken by read()
+        uint8_t  state;
+    } chunk_t;
+
+    static uint8_t*  chunkAlloc(bool* dma);
+    static uint32_t  readLen(uint32_t pos, uint32_t fileSize);
+    static bool      findRuns(const char* path, uint32_t size, FatRuns* runs, fatRead_t* read, void** ctx);
+    static int32_t   readRuns(const FatRuns& runs, fatRead_t read, void* ctx, uint32_t pos, uint32_t len, uint8_t* buf);
+    static void      taskEntry(void* param);
+    void             taskLoop();
+    void             countLatency(uint32_t us);
+
+    fs::File          m_file;
+    char*             m_path = NULL;      // for the cluster runs
+    FatRuns           m_runs;             // of the task
+    fatRead_t         m_blockRead = NULL; // the card if m_runs are known
+    void*             m_blockCtx = NULL;
+    uint32_t          m_runCount = 0;     // under m_mutex
+    TaskHandle_t      m_task = NULL;
+    SemaphoreHandle_t m_mutex = NULL;
+    chunk_t           m_chunk[2] = {};
+    uint32_t          m_readPos = 0;     // consumer position
+    uint32_t          m_nextPos = 0;     // position of the next prefetch
+    uint32_t          m_fileSize = 0;
+    uint32_t          m_seekGen = 0;     // incremented by seek(), a read of an older generation is discarded
+    uint32_t          m_latHist[24] = {}; // read latency, bucket i counts reads below 2^i µs, under m_mutex
+    uint32_t          m_latMax = 0;
+    uint32_t          m_stackUnused = 0;  // high-water mark after the reads, under m_mutex
+    volatile bool     m_f_stop = false;
+    volatile bool     m_f_taskRunning = false;
+    static fatRead_t  s_blockRead;
+    static void*      s_blockCtx;
+};
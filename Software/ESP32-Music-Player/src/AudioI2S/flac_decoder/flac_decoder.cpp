@@ -9,156 +9,136 @@
  * Author: Wolle
  *
  */
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_FLAC
+
 #include "flac_decoder.h"
 #include "vector"
+#include <new>
 using namespace std;
 
-FLACFrameHeader_t*   FLACFrameHeader;
-FLACMetadataBlock_t* FLACMetadataBlock;
-
-vector<uint16_t> s_flacSegmTableVec;
-vector<int32_t>  coefs;
-vector<uint32_t> s_flacBlockPicItem;
-uint64_t         s_flac_bitBuffer = 0;
-uint32_t         s_flacBitrate = 0;
-uint32_t         s_flacBlockPicLenUntilFrameEnd = 0;
-uint32_t         s_flacCurrentFilePos = 0;
-uint32_t         s_flacBlockPicPos = 0;
-uint32_t         s_flacBlockPicLen = 0;
-uint32_t         s_flacAudioDataStart = 0;
-int32_t          s_flacRemainBlockPicLen = 0;
 const uint16_t   s_flacOutBuffSize = 2048;
-uint16_t         s_blockSize = 0;
-uint16_t         s_blockSizeLeft = 0;
-uint16_t         s_flacValidSamples = 0;
-uint16_t         s_rIndex = 0;
-uint16_t         s_offset = 0;
-uint8_t          s_flacStatus = 0;
-uint8_t*         s_flacInptr;
-float            s_flacCompressionRatio = 0;
-uint8_t          s_flacBitBufferLen = 0;
-bool             s_f_flacParseOgg = false;
-bool             s_f_bitReaderError = false;
-uint8_t          s_flac_pageSegments = 0;
-char*            s_flacStreamTitle = NULL;
-char*            s_flacVendorString = NULL;
-bool             s_f_flacNewStreamtitle = false;
-bool             s_f_flacFirstCall = true;
-bool             s_f_oggWrapper = false;
-bool             s_f_lastMetaDataBlock = false;
-bool             s_f_flacNewMetadataBlockPicture = false;
-uint8_t          s_flacPageNr = 0;
-int32_t**        s_samplesBuffer = NULL;
-uint16_t         s_maxBlocksize = MAX_BLOCKSIZE;
-int32_t          s_nBytes = 0;
+FLACDecoder_t    s_flacDefault;             // the context of the codec registry
 
 //----------------------------------------------------------------------------------------------------------------------
 //          FLAC INI SECTION
 //----------------------------------------------------------------------------------------------------------------------
 
-// prefer PSRAM
-#define __malloc_heap_psram(size) \
-    heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
-
-bool FLACDecoder_AllocateBuffers(void){
+FLACDecoder_t* FLACDecoder_Create(){ // a further, independent decoder, e.g. to probe or preroll a second stream
+    FLACDecoder_t* dec = new (std::nothrow) FLACDecoder_t;
+    if(!dec) log_e("not enough memory to allocate a flacdecoder context");
+    return dec;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FLACDecoder_Destroy(FLACDecoder_t* dec){
+    if(!dec || dec == &s_flacDefault) return;
+    FLACDecoder_FreeBuffers(dec);
+    delete dec;
+}
+//----------------------------------------------------------------------------------------------------------------------
+FLACDecoder_t* FLACDecoder_Default(){
+    return &s_flacDefault;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t FLACDecoder_ArenaSize(void){ // bytes FLACDecoder_AllocateBuffers() takes from the codec arena
+    return ((sizeof(FLACFrameHeader_t) + 7) & ~7) + ((sizeof(FLACMetadataBlock_t) + 7) & ~7) + 256 +
+           ((MAX_CHANNELS * sizeof(int32_t*) + 7) & ~7) + MAX_CHANNELS * ((MAX_BLOCKSIZE * sizeof(int32_t) + 7) & ~7);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FLACDecoder_AllocateBuffers(FLACDecoder_t* dec){
 
-    if(!FLACFrameHeader)    {FLACFrameHeader    = (FLACFrameHeader_t*)    __malloc_heap_psram(sizeof(FLACFrameHeader_t));}
-    if(!FLACMetadataBlock)  {FLACMetadataBlock  = (FLACMetadataBlock_t*)  __malloc_heap_psram(sizeof(FLACMetadataBlock_t));}
-    if(!s_flacStreamTitle)  {s_flacStreamTitle  = (char*)                 __malloc_heap_psram(256);}
+    if(!dec->frameHeader)   {dec->frameHeader   = (FLACFrameHeader_t*)   CodecArena_Alloc(sizeof(FLACFrameHeader_t));}
+    if(!dec->metadataBlock) {dec->metadataBlock = (FLACMetadataBlock_t*) CodecArena_Alloc(sizeof(FLACMetadataBlock_t));}
+    if(!dec->streamTitle)   {dec->streamTitle   = (char*)                CodecArena_Alloc(256);}
 
-    if(!FLACFrameHeader || !FLACMetadataBlock || !s_flacStreamTitle){
+    if(!dec->frameHeader || !dec->metadataBlock || !dec->streamTitle){
         log_e("not enough memory to allocate flacdecoder buffers");
         return false;
     }
 
-    if(psramFound()){
-        s_samplesBuffer = (int32_t**)ps_malloc(MAX_CHANNELS * sizeof(int32_t*));
-        for (int32_t i = 0; i < MAX_CHANNELS; i++){
-            s_samplesBuffer[i] = (int32_t*)ps_malloc(s_maxBlocksize * sizeof(int32_t));
-            if(!s_samplesBuffer[i]){
-                log_e("not enough memory to allocate flacdecoder buffers");
-                return false;
-            }
+    if(!dec->samplesBuffer){
+        dec->samplesBuffer = (int32_t**)CodecArena_Alloc(MAX_CHANNELS * sizeof(int32_t*));
+        if(!dec->samplesBuffer){
+            log_e("not enough memory to allocate flacdecoder buffers");
+            return false;
         }
-    }
-    else  {
-        s_samplesBuffer = (int32_t**)malloc(MAX_CHANNELS * sizeof(int32_t*));
+        memset(dec->samplesBuffer, 0, MAX_CHANNELS * sizeof(int32_t*));
         for (int32_t i = 0; i < MAX_CHANNELS; i++){
-            s_samplesBuffer[i] = (int32_t*)malloc(s_maxBlocksize * sizeof(int32_t));
-            if(!s_samplesBuffer[i]){
+            dec->samplesBuffer[i] = (int32_t*)CodecArena_Alloc(dec->maxBlocksize * sizeof(int32_t));
+            if(!dec->samplesBuffer[i]){
                 log_e("not enough memory to allocate flacdecoder buffers");
                 return false;
             }
         }
     }
 
-    FLACDecoder_ClearBuffer();
-    FLACDecoder_setDefaults();
-    s_flacPageNr = 0;
+    FLACDecoder_ClearBuffer(dec);
+    FLACDecoder_setDefaults(dec);
+    dec->pageNr = 0;
     return true;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void FLACDecoder_ClearBuffer(){
-    memset(FLACFrameHeader,   0, sizeof(FLACFrameHeader_t));
-    memset(FLACMetadataBlock, 0, sizeof(FLACMetadataBlock_t));
+void FLACDecoder_ClearBuffer(FLACDecoder_t* dec){
+    memset(dec->frameHeader,   0, sizeof(FLACFrameHeader_t));
+    memset(dec->metadataBlock, 0, sizeof(FLACMetadataBlock_t));
 
-    if(s_samplesBuffer) {
+    if(dec->samplesBuffer) {
         for (int32_t i = 0; i < MAX_CHANNELS; i++){
-            memset(s_samplesBuffer[i], 0, s_maxBlocksize * sizeof(int32_t));
+            memset(dec->samplesBuffer[i], 0, dec->maxBlocksize * sizeof(int32_t));
         }
     }
 
-    s_flacSegmTableVec.clear(); s_flacSegmTableVec.shrink_to_fit();
-    s_flacStatus = DECODE_FRAME;
+    dec->segmTableVec.clear(); dec->segmTableVec.shrink_to_fit();
+    dec->status = DECODE_FRAME;
     return;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void FLACDecoder_FreeBuffers(){
-    if(FLACFrameHeader)    {free(FLACFrameHeader);    FLACFrameHeader    = NULL;}
-    if(FLACMetadataBlock)  {free(FLACMetadataBlock);  FLACMetadataBlock  = NULL;}
-    if(s_flacStreamTitle)  {free(s_flacStreamTitle);  s_flacStreamTitle  = NULL;}
-    if(s_flacVendorString) {free(s_flacVendorString); s_flacVendorString = NULL;}
+void FLACDecoder_FreeBuffers(FLACDecoder_t* dec){
+    if(dec->frameHeader)   {CodecArena_Free(dec->frameHeader);   dec->frameHeader   = NULL;}
+    if(dec->metadataBlock) {CodecArena_Free(dec->metadataBlock); dec->metadataBlock = NULL;}
+    if(dec->streamTitle)   {CodecArena_Free(dec->streamTitle);   dec->streamTitle   = NULL;}
+    if(dec->vendorString)  {free(dec->vendorString);             dec->vendorString  = NULL;}
 
-    if(s_samplesBuffer){
+    if(dec->samplesBuffer){
         for (int32_t i = 0; i < MAX_CHANNELS; i++){
-            if(s_samplesBuffer[i]){free(s_samplesBuffer[i]);}
+            if(dec->samplesBuffer[i]){CodecArena_Free(dec->samplesBuffer[i]);}
         }
-        free(s_samplesBuffer); s_samplesBuffer = NULL;
+        CodecArena_Free(dec->samplesBuffer); dec->samplesBuffer = NULL;
     }
-    coefs.clear(); coefs.shrink_to_fit();
-    s_flacSegmTableVec.clear(); s_flacSegmTableVec.shrink_to_fit();
-    s_flacBlockPicItem.clear(); s_flacBlockPicItem.shrink_to_fit();
+    dec->coefs.clear(); dec->coefs.shrink_to_fit();
+    dec->segmTableVec.clear(); dec->segmTableVec.shrink_to_fit();
+    dec->blockPicItem.clear(); dec->blockPicItem.shrink_to_fit();
 }
 //----------------------------------------------------------------------------------------------------------------------
-void FLACDecoder_setDefaults(){
-    coefs.clear(); coefs.shrink_to_fit();
-    s_flacSegmTableVec.clear(); s_flacSegmTableVec.shrink_to_fit();
-    s_flacBlockPicItem.clear(); s_flacBlockPicItem.shrink_to_fit();
-    s_flac_bitBuffer = 0;
-    s_flacBitrate = 0;
-    s_flacBlockPicLenUntilFrameEnd = 0;
-    s_flacCurrentFilePos = 0;
-    s_flacBlockPicPos = 0;
-    s_flacBlockPicLen = 0;
-    s_flacRemainBlockPicLen = 0;
-    s_flacAudioDataStart = 0;
-    s_blockSize = 0;
-    s_offset = 0;
-    s_blockSizeLeft = 0;
-    s_flacValidSamples = 0;
-    s_rIndex = 0;
-    s_flacStatus = DECODE_FRAME;
-    s_flacCompressionRatio = 0;
-    s_flacBitBufferLen = 0;
-    s_flac_pageSegments = 0;
-    s_f_flacNewStreamtitle = false;
-    s_f_flacFirstCall = true;
-    s_f_oggWrapper = false;
-    s_f_lastMetaDataBlock = false;
-    s_f_flacNewMetadataBlockPicture = false;
-    s_f_flacParseOgg = false;
-    s_f_bitReaderError = false;
-    s_nBytes = 0;
+void FLACDecoder_setDefaults(FLACDecoder_t* dec){
+    dec->coefs.clear(); dec->coefs.shrink_to_fit();
+    dec->segmTableVec.clear(); dec->segmTableVec.shrink_to_fit();
+    dec->blockPicItem.clear(); dec->blockPicItem.shrink_to_fit();
+    dec->bitBuffer = 0;
+    dec->bitrate = 0;
+    dec->blockPicLenUntilFrameEnd = 0;
+    dec->currentFilePos = 0;
+    dec->blockPicPos = 0;
+    dec->blockPicLen = 0;
+    dec->remainBlockPicLen = 0;
+    dec->audioDataStart = 0;
+    dec->blockSize = 0;
+    dec->offset = 0;
+    dec->blockSizeLeft = 0;
+    dec->validSamples = 0;
+    dec->rIndex = 0;
+    dec->status = DECODE_FRAME;
+    dec->compressionRatio = 0;
+    dec->bitBufferLen = 0;
+    dec->pageSegments = 0;
+    dec->f_newStreamtitle = false;
+    dec->f_firstCall = true;
+    dec->f_oggWrapper = false;
+    dec->f_lastMetaDataBlock = false;
+    dec->f_newMetadataBlockPicture = false;
+    dec->f_parseOgg = false;
+    dec->f_bitReaderError = false;
+    dec->nBytes = 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
 //            B I T R E A D E R
@@ -169,70 +149,70 @@ const uint32_t mask[] = {0x00000000, 0x00000001, 0x00000003, 0x00000007, 0x00000
                          0x001fffff, 0x003fffff, 0x007fffff, 0x00ffffff, 0x01ffffff, 0x03ffffff, 0x07ffffff,
                          0x0fffffff, 0x1fffffff, 0x3fffffff, 0x7fffffff, 0xffffffff};
 
-uint32_t readUint(uint8_t nBits, int32_t *bytesLeft){
-    while (s_flacBitBufferLen < nBits){
-        uint8_t temp = *(s_flacInptr + s_rIndex);
-        s_rIndex++;
+uint32_t readUint(FLACDecoder_t* dec, uint8_t nBits, int32_t *bytesLeft){
+    while (dec->bitBufferLen < nBits){
+        uint8_t temp = *(dec->inptr + dec->rIndex);
+        dec->rIndex++;
         (*bytesLeft)--;
-        if(*bytesLeft < 0) { log_e("error in bitreader"); s_f_bitReaderError = true; break;}
-        s_flac_bitBuffer = (s_flac_bitBuffer << 8) | temp;
-        s_flacBitBufferLen += 8;
+        if(*bytesLeft < 0) { log_e("error in bitreader"); dec->f_bitReaderError = true; break;}
+        dec->bitBuffer = (dec->bitBuffer << 8) | temp;
+        dec->bitBufferLen += 8;
     }
-    s_flacBitBufferLen -= nBits;
-    uint32_t result = s_flac_bitBuffer >> s_flacBitBufferLen;
+    dec->bitBufferLen -= nBits;
+    uint32_t result = dec->bitBuffer >> dec->bitBufferLen;
     if (nBits < 32)
         result &= mask[nBits];
     return result;
 }
 
-int32_t readSignedInt(int32_t nBits, int32_t* bytesLeft){
-    int32_t temp = readUint(nBits, bytesLeft) << (32 - nBits);
+int32_t readSignedInt(FLACDecoder_t* dec, int32_t nBits, int32_t* bytesLeft){
+    int32_t temp = readUint(dec, nBits, bytesLeft) << (32 - nBits);
     temp = temp >> (32 - nBits); // The C++ compiler uses the sign bit to fill vacated bit positions
     return temp;
 }
 
-int64_t readRiceSignedInt(uint8_t param, int32_t* bytesLeft){
+int64_t readRiceSignedInt(FLACDecoder_t* dec, uint8_t param, int32_t* bytesLeft){
     long val = 0;
-    while (readUint(1, bytesLeft) == 0)
+    while (readUint(dec, 1, bytesLeft) == 0)
         val++;
-    val = (val << param) | readUint(param, bytesLeft);
+    val = (val << param) | readUint(dec, param, bytesLeft);
     return (val >> 1) ^ -(val & 1);
 }
 
-void alignToByte() {
-    s_flacBitBufferLen -= s_flacBitBufferLen % 8;
+void alignToByte(FLACDecoder_t* dec) {
+    dec->bitBufferLen -= dec->bitBufferLen % 8;
 }
 //----------------------------------------------------------------------------------------------------------------------
 //              F L A C - D E C O D E R
 //----------------------------------------------------------------------------------------------------------------------
-void FLACSetRawBlockParams(uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis, uint32_t AuDaLength){
-    FLACMetadataBlock->numChannels = Chans;
-    FLACMetadataBlock->sampleRate = SampRate;
-    FLACMetadataBlock->bitsPerSample = BPS;
-    FLACMetadataBlock->totalSamples = tsis;  // total samples in stream
-    FLACMetadataBlock->audioDataLength = AuDaLength;
+void FLACSetRawBlockParams(FLACDecoder_t* dec, uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis, uint32_t AuDaLength){
+    dec->metadataBlock->numChannels = Chans;
+    dec->metadataBlock->sampleRate = SampRate;
+    dec->metadataBlock->bitsPerSample = BPS;
+    dec->metadataBlock->totalSamples = tsis;  // total samples in stream
+    dec->metadataBlock->audioDataLength = AuDaLength;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void FLACDecoderReset(){ // set var to default
-    FLACDecoder_setDefaults();
-    FLACDecoder_ClearBuffer();
+void FLACDecoderReset(FLACDecoder_t* dec){ // set var to default
+    FLACDecoder_setDefaults(dec);
+    FLACDecoder_ClearBuffer(dec);
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t FLACFindSyncWord(unsigned char *buf, int32_t nBytes) {
+int32_t FLACFindSyncWord(FLACDecoder_t* dec, unsigned char *buf, int32_t nBytes) {
 
     int32_t i = FLAC_specialIndexOf(buf, "OggS", nBytes);
-    if(i == 0) {s_f_bitReaderError = false; return 0;}  // flag has ogg wrapper
+    if(i == 0) {dec->f_bitReaderError = false; return 0;}  // flag has ogg wrapper
 
-    if(s_f_oggWrapper && i > 0){
-        s_f_bitReaderError = false;
+    if(dec->f_oggWrapper && i > 0){
+        dec->f_bitReaderError = false;
         return i;
     }
     else{
          /* find byte-aligned sync code - need 14 matching bits */
         for (i = 0; i < nBytes - 1; i++) {
             if ((buf[i + 0] & 0xFF) == 0xFF  && (buf[i + 1] & 0xFC) == 0xF8) { // <14> Sync code '11111111111110xx'
-                if(i) FLACDecoderReset();
-            //    s_f_bitReaderError = false;
+                if(i) FLACDecoderReset(dec);
+            //    dec->f_bitReaderError = false;
                 return i;
             }
         }
@@ -240,6 +220,40 @@ int32_t FLACFindSyncWord(unsigned char *buf, int32_t nBytes) {
     return -1;
 }
 //----------------------------------------------------------------------------------------------------------------------
+int32_t FLACFindFrameHeader(uint8_t* buf, int32_t nBytes) {
+    // byte aligned sync code 0xFFF8/9, no reserved values, the header is proven by its CRC-8
+    const int32_t maxHeaderLen = 16;
+    uint8_t* end = buf + nBytes;
+    uint8_t* p = buf;
+    while(end - p >= maxHeaderLen) {
+        p = (uint8_t*)memchr(p, 0xFF, end - p - (maxHeaderLen - 1));
+        if(!p) return -1;
+        uint8_t bs = p[2] >> 4, sr = p[2] & 0x0F, ch = p[3] >> 4, ss = (p[3] >> 1) & 0x07;
+        if((p[1] & 0xFE) != 0xF8 || bs == 0 || sr == 0x0F || ch > 10 || ss == 3 || (p[3] & 0x01)) { p++; continue; }
+        int32_t len = 4;
+        uint8_t n = p[4];     // frame or sample number, UTF-8 coded
+        if(n < 0x80) len += 1;
+        else if(n >= 0xC0 && n < 0xFE) { // 2...7 bytes
+            uint8_t u = 2;
+            while(u < 7 && (n & (0x80 >> u))) u++;
+            len += u;
+        }
+        else { p++; continue; }
+        if(bs == 6) len += 1;
+        if(bs == 7) len += 2;
+        if(sr == 12) len += 1;
+        if(sr == 13 || sr == 14) len += 2;
+        uint8_t crc = 0; // CRC-8, polynomial x^8 + x^2 + x^1 + x^0
+        for(int32_t i = 0; i < len; i++) {
+            crc ^= p[i];
+            for(int j = 0; j < 8; j++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+        if(crc == p[len]) return p - buf;
+        p++;
+    }
+    return -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
 boolean FLACFindMagicWord(unsigned char* buf, int32_t nBytes){
     int32_t idx = FLAC_specialIndexOf(buf, "fLaC", nBytes);
     if(idx >0){ // Metadatablock follows
@@ -257,17 +271,17 @@ boolean FLACFindMagicWord(unsigned char* buf, int32_t nBytes){
     return false;
 }
 //----------------------------------------------------------------------------------------------------------------------
-char* FLACgetStreamTitle(){
-    if(s_f_flacNewStreamtitle){
-        s_f_flacNewStreamtitle = false;
-        return s_flacStreamTitle;
+char* FLACgetStreamTitle(FLACDecoder_t* dec){
+    if(dec->f_newStreamtitle){
+        dec->f_newStreamtitle = false;
+        return dec->streamTitle;
     }
     return NULL;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t FLACparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://www.xiph.org/ogg/doc/rfc3533.txt
+int32_t FLACparseOGG(FLACDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft){  // reference https://www.xiph.org/ogg/doc/rfc3533.txt
 
-    s_f_flacParseOgg = false;
+    dec->f_parseOgg = false;
     int32_t idx = FLAC_specialIndexOf(inbuf, "OggS", 6);
     if(idx != 0) return ERR_FLAC_DECODER_ASYNC;
 
@@ -297,8 +311,8 @@ int32_t FLACparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://
 
     // read the segment table (contains pageSegments bytes),  1...251: Length of the frame in bytes,
     // 255: A second byte is needed.  The total length is first_byte + second byte
-    s_flacSegmTableVec.clear();
-    s_flacSegmTableVec.shrink_to_fit();
+    dec->segmTableVec.clear();
+    dec->segmTableVec.shrink_to_fit();
     for(int32_t i = 0; i < pageSegments; i++){
         int32_t n = *(inbuf + 27 + i);
         while(*(inbuf + 27 + i) == 255){
@@ -306,9 +320,9 @@ int32_t FLACparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://
             if(i == pageSegments) break;
             n+= *(inbuf + 27 + i);
         }
-        s_flacSegmTableVec.insert(s_flacSegmTableVec.begin(), n);
+        dec->segmTableVec.insert(dec->segmTableVec.begin(), n);
     }
-    // for(int32_t i = 0; i< s_flacSegmTableVec.size(); i++){log_i("%i", s_flacSegmTableVec[i]);}
+    // for(int32_t i = 0; i< dec->segmTableVec.size(); i++){log_i("%i", dec->segmTableVec[i]);}
 
     bool     continuedPage = headerType & 0x01; // set: page contains data of a packet continued from the previous page
     bool     firstPage     = headerType & 0x02; // set: this is the first page of a logical bitstream (bos)
@@ -318,26 +332,26 @@ int32_t FLACparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://
 
     // log_i("firstPage %i, continuedPage %i, lastPage %i", firstPage, continuedPage, lastPage);
 
-    if(firstPage) s_flacPageNr = 0;
+    if(firstPage) dec->pageNr = 0;
 
     uint16_t headerSize = pageSegments + 27;
 
     *bytesLeft -= headerSize;
-    s_flacCurrentFilePos += headerSize;
+    dec->currentFilePos += headerSize;
     return ERR_FLAC_NONE; // no error
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-vector<uint32_t> FLACgetMetadataBlockPicture(){
-    if(s_f_flacNewMetadataBlockPicture){
-        s_f_flacNewMetadataBlockPicture = false;
-        return s_flacBlockPicItem;
+vector<uint32_t> FLACgetMetadataBlockPicture(FLACDecoder_t* dec){
+    if(dec->f_newMetadataBlockPicture){
+        dec->f_newMetadataBlockPicture = false;
+        return dec->blockPicItem;
     }
-    if(s_flacBlockPicItem.size() > 0){
-        s_flacBlockPicItem.clear();
-        s_flacBlockPicItem.shrink_to_fit();
+    if(dec->blockPicItem.size() > 0){
+        dec->blockPicItem.clear();
+        dec->blockPicItem.shrink_to_fit();
     }
-    return s_flacBlockPicItem;
+    return dec->blockPicItem;
 }
 //----------------------------------------------------------------------------------------------------------------------------------------------------
 int32_t parseFlacFirstPacket(uint8_t *inbuf, int16_t nBytes){ // 4.2.2. Identification header   https://xiph.org/flac/ogg_mapping.html
@@ -355,7 +369,7 @@ int32_t parseFlacFirstPacket(uint8_t *inbuf, int16_t nBytes){ // 4.2.2. Identifi
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
+int32_t parseMetaDataBlockHeader(FLACDecoder_t* dec, uint8_t *inbuf, int16_t nBytes){
     int8_t   ret = FLAC_PARSE_OGG_DONE;
     uint16_t pos = 0;
     int32_t  blockLength = 0;
@@ -380,7 +394,7 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
 
     while(true){
         mdBlockHeader         = *(inbuf + pos);
-        s_f_lastMetaDataBlock = mdBlockHeader & 0b10000000; //log_w("lastMdBlockFlag %i", s_f_lastMetaDataBlock);
+        dec->f_lastMetaDataBlock = mdBlockHeader & 0b10000000; //log_w("lastMdBlockFlag %i", dec->f_lastMetaDataBlock);
         blockType             = mdBlockHeader & 0b01111111; //log_w("blockType %i", blockType);
 
         blockLength        = *(inbuf + pos + 1) << 16;
@@ -434,8 +448,8 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
                 maxBlocksize += *(inbuf + pos + 3);
                 //log_i("minBlocksize %i", minBlocksize);
                 //log_i("maxBlocksize %i", maxBlocksize);
-                FLACMetadataBlock->minblocksize = minBlocksize;
-                FLACMetadataBlock->maxblocksize = maxBlocksize;
+                dec->metadataBlock->minblocksize = minBlocksize;
+                dec->metadataBlock->maxblocksize = maxBlocksize;
 
                 if(maxBlocksize > 8192 * 2){log_e("s_blocksizes[1] is too big"); return ERR_FLAC_BLOCKSIZE_TOO_BIG;}
 
@@ -447,22 +461,22 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
                 maxFrameSize += *(inbuf + pos + 9);
                 //log_i("minFrameSize %i", minFrameSize);
                 //log_i("maxFrameSize %i", maxFrameSize);
-                FLACMetadataBlock->minframesize = minFrameSize;
-                FLACMetadataBlock->maxframesize = maxFrameSize;
+                dec->metadataBlock->minframesize = minFrameSize;
+                dec->metadataBlock->maxframesize = maxFrameSize;
 
                 sampleRate   =  *(inbuf + pos + 10) << 12;
                 sampleRate  +=  *(inbuf + pos + 11) << 4;
                 sampleRate  += (*(inbuf + pos + 12) & 0xF0) >> 4;
                 //log_i("sampleRate %i", sampleRate);
-                FLACMetadataBlock->sampleRate = sampleRate;
+                dec->metadataBlock->sampleRate = sampleRate;
 
                 nrOfChannels = ((*(inbuf + pos + 12) & 0x0E) >> 1) + 1;
                 //log_i("nrOfChannels %i", nrOfChannels);
-                FLACMetadataBlock->numChannels = nrOfChannels;
+                dec->metadataBlock->numChannels = nrOfChannels;
 
                 bitsPerSample  =  (*(inbuf + pos + 12) & 0x01) << 5;
                 bitsPerSample += ((*(inbuf + pos + 13) & 0xF0) >> 4) + 1;
-                FLACMetadataBlock->bitsPerSample = bitsPerSample;
+                dec->metadataBlock->bitsPerSample = bitsPerSample;
                 //log_i("bitsPerSample %i", bitsPerSample);
 
                 totalSamplesInStream  = (uint64_t)(*(inbuf + pos + 17) & 0x0F) << 32;
@@ -471,7 +485,7 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
                 totalSamplesInStream += (*(inbuf + pos + 15)) << 8;
                 totalSamplesInStream += (*(inbuf + pos + 16));
                 //log_i("totalSamplesInStream %lli", totalSamplesInStream);
-                FLACMetadataBlock->totalSamples = totalSamplesInStream;
+                dec->metadataBlock->totalSamples = totalSamplesInStream;
 
                 //log_i("nBytes %i, blockLength %i", nBytes, blockLength);
                 pos += blockLength;
@@ -487,10 +501,10 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
                 if(vendorLength > 1024){
                     log_e("vendorLength > 1024 bytes");
                 }
-                if(s_flacVendorString) {free(s_flacVendorString); s_flacVendorString = NULL;}
-                s_flacVendorString = (char*) flac_x_ps_calloc(vendorLength + 1, sizeof(char));
-                memcpy(s_flacVendorString, inbuf + pos + 4, vendorLength);
-                //log_i("%s", s_flacVendorString);
+                if(dec->vendorString) {free(dec->vendorString); dec->vendorString = NULL;}
+                dec->vendorString = (char*) flac_x_ps_calloc(vendorLength + 1, sizeof(char));
+                memcpy(dec->vendorString, inbuf + pos + 4, vendorLength);
+                //log_i("%s", dec->vendorString);
 
                 pos += 4 + vendorLength;
                 userCommentListLength  = *(inbuf + pos + 3) << 24;
@@ -536,44 +550,44 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
                     }
                     if((FLAC_specialIndexOf(inbuf + pos + 4, "METADATA_BLOCK_PICTURE", 23) == 0) || (FLAC_specialIndexOf(inbuf + pos + 4, "metadata_block_picture", 23) == 0)){
                         //log_w("METADATA_BLOCK_PICTURE found, commemtStringLength %i", commemtStringLength);
-                        s_flacBlockPicLen = commemtStringLength - 23;
-                        s_flacBlockPicPos = s_flacCurrentFilePos + pos + 4 + 23;
-                        s_flacBlockPicLenUntilFrameEnd = nBytes - (pos + 23);
-                        if(s_flacBlockPicLen < s_flacBlockPicLenUntilFrameEnd) s_flacBlockPicLenUntilFrameEnd = s_flacBlockPicLen;
-                        s_flacRemainBlockPicLen = s_flacBlockPicLen - s_flacBlockPicLenUntilFrameEnd;
-                        //log_i("s_flacBlockPicPos %i, s_flacBlockPicLen %i", s_flacBlockPicPos, s_flacBlockPicLen);
-                        //log_i("s_flacBlockPicLenUntilFrameEnd %i, s_flacRemainBlockPicLen %i", s_flacBlockPicLenUntilFrameEnd, s_flacRemainBlockPicLen);
-                        if(s_flacRemainBlockPicLen <= 0) s_f_lastMetaDataBlock = true; // exeption:: goto audiopage after commemt if lastMetaDataFlag is not set
-                        if(s_flacBlockPicLen){
-                            s_flacBlockPicItem.clear();
-                            s_flacBlockPicItem.shrink_to_fit();
-                            s_flacBlockPicItem.push_back(s_flacBlockPicPos);
-                            s_flacBlockPicItem.push_back(s_flacBlockPicLenUntilFrameEnd);
+                        dec->blockPicLen = commemtStringLength - 23;
+                        dec->blockPicPos = dec->currentFilePos + pos + 4 + 23;
+                        dec->blockPicLenUntilFrameEnd = nBytes - (pos + 23);
+                        if(dec->blockPicLen < dec->blockPicLenUntilFrameEnd) dec->blockPicLenUntilFrameEnd = dec->blockPicLen;
+                        dec->remainBlockPicLen = dec->blockPicLen - dec->blockPicLenUntilFrameEnd;
+                        //log_i("dec->blockPicPos %i, dec->blockPicLen %i", dec->blockPicPos, dec->blockPicLen);
+                        //log_i("dec->blockPicLenUntilFrameEnd %i, dec->remainBlockPicLen %i", dec->blockPicLenUntilFrameEnd, dec->remainBlockPicLen);
+                        if(dec->remainBlockPicLen <= 0) dec->f_lastMetaDataBlock = true; // exeption:: goto audiopage after commemt if lastMetaDataFlag is not set
+                        if(dec->blockPicLen){
+                            dec->blockPicItem.clear();
+                            dec->blockPicItem.shrink_to_fit();
+                            dec->blockPicItem.push_back(dec->blockPicPos);
+                            dec->blockPicItem.push_back(dec->blockPicLenUntilFrameEnd);
                         }
                     }
                     pos += 4 + commemtStringLength;
                     //log_i("nBytes %i, pos %i, commemtStringLength %i", nBytes, pos, commemtStringLength);
                 }
-                memset(s_flacStreamTitle, 0, 256);
+                memset(dec->streamTitle, 0, 256);
                 if(vb[1] && vb[0]){ // artist and title
-                    strcpy(s_flacStreamTitle, vb[1]);
-                    strcat(s_flacStreamTitle, " - ");
-                    strcat(s_flacStreamTitle, vb[0]);
-                    s_f_flacNewStreamtitle = true;
+                    strcpy(dec->streamTitle, vb[1]);
+                    strcat(dec->streamTitle, " - ");
+                    strcat(dec->streamTitle, vb[0]);
+                    dec->f_newStreamtitle = true;
                 }
                 else if(vb[1]){
-                    strcpy(s_flacStreamTitle, vb[1]);
-                    s_f_flacNewStreamtitle = true;
+                    strcpy(dec->streamTitle, vb[1]);
+                    dec->f_newStreamtitle = true;
                 }
                 else if(vb[0]){
-                    strcpy(s_flacStreamTitle, vb[0]);
-                    s_f_flacNewStreamtitle = true;
+                    strcpy(dec->streamTitle, vb[0]);
+                    dec->f_newStreamtitle = true;
                 }
                 for(int32_t i = 0; i < 8; i++){
                     if(vb[i]){free(vb[i]); vb[i] = NULL;}
                 }
 
-                if(!s_flacBlockPicLen && s_flacSegmTableVec.size() == 1) s_f_lastMetaDataBlock = true; // exeption:: goto audiopage after commemt if lastMetaDataFlag is not set
+                if(!dec->blockPicLen && dec->segmTableVec.size() == 1) dec->f_lastMetaDataBlock = true; // exeption:: goto audiopage after commemt if lastMetaDataFlag is not set
                 if(ret == FLAC_PARSE_OGG_DONE) return ret;
                 break;
 
@@ -589,79 +603,78 @@ int32_t parseMetaDataBlockHeader(uint8_t *inbuf, int16_t nBytes){
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t FLACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf){ //  MAIN LOOP
+int8_t FLACDecode(FLACDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf){ //  MAIN LOOP
 
     int32_t             ret = 0;
     uint16_t        segmLen = 0;
-    static uint16_t segmLenTmp = 0;
 
-    if(s_f_flacFirstCall){ // determine if ogg or flag
-        s_f_flacFirstCall = false;
-        s_nBytes = 0;
-        segmLenTmp = 0;
+    if(dec->f_firstCall){ // determine if ogg or flag
+        dec->f_firstCall = false;
+        dec->nBytes = 0;
+        dec->segmLenTmp = 0;
         if(FLAC_specialIndexOf(inbuf, "OggS", 5) == 0){
-            s_f_oggWrapper = true;
-            s_f_flacParseOgg = true;
+            dec->f_oggWrapper = true;
+            dec->f_parseOgg = true;
         }
     }
 
-    if(s_f_oggWrapper){
+    if(dec->f_oggWrapper){
 
-        if(segmLenTmp){ // can't skip more than 16K
-            if(segmLenTmp > 16384){
-                s_flacCurrentFilePos += 16384;
+        if(dec->segmLenTmp){ // can't skip more than 16K
+            if(dec->segmLenTmp > 16384){
+                dec->currentFilePos += 16384;
                 *bytesLeft -= 16384;
-                segmLenTmp -= 16384;
+                dec->segmLenTmp -= 16384;
             }
             else{
-                s_flacCurrentFilePos += segmLenTmp;
-                *bytesLeft -= segmLenTmp;
-                segmLenTmp  = 0;
+                dec->currentFilePos += dec->segmLenTmp;
+                *bytesLeft -= dec->segmLenTmp;
+                dec->segmLenTmp  = 0;
             }
             return FLAC_PARSE_OGG_DONE;
         }
 
-        if(s_nBytes > 0){
-            int16_t diff = s_nBytes;
-            if(s_flacAudioDataStart == 0){
-                s_flacAudioDataStart = s_flacCurrentFilePos;
+        if(dec->nBytes > 0){
+            int16_t diff = dec->nBytes;
+            if(dec->audioDataStart == 0){
+                dec->audioDataStart = dec->currentFilePos;
             }
-            ret = FLACDecodeNative(inbuf, &s_nBytes, outbuf);
-            diff -= s_nBytes;
-            s_flacCurrentFilePos += diff;
+            ret = FLACDecodeNative(dec, inbuf, &dec->nBytes, outbuf);
+            diff -= dec->nBytes;
+            dec->currentFilePos += diff;
             *bytesLeft -= diff;
             return ret;
         }
-        if(s_nBytes < 0){return ERR_FLAC_DECODER_ASYNC;}
+        if(dec->nBytes < 0){return ERR_FLAC_DECODER_ASYNC;}
 
-        if(s_f_flacParseOgg == true){
-            s_f_flacParseOgg = false;
-            ret = FLACparseOGG(inbuf, bytesLeft);
+        if(dec->f_parseOgg == true){
+            dec->f_parseOgg = false;
+            ret = FLACparseOGG(dec, inbuf, bytesLeft);
             if(ret == ERR_FLAC_NONE) return FLAC_PARSE_OGG_DONE; // ok
             else return ret;  // error
         }
         //-------------------------------------------------------
-        if(!s_flacSegmTableVec.size()) log_e("size is 0");
-        segmLen = s_flacSegmTableVec.back();
-        s_flacSegmTableVec.pop_back();
-        if(!s_flacSegmTableVec.size()) s_f_flacParseOgg = true;
+        if(!dec->segmTableVec.size()) log_e("size is 0");
+        segmLen = dec->segmTableVec.back();
+        dec->segmTableVec.pop_back();
+        if(!dec->segmTableVec.size()) dec->f_parseOgg = true;
         //-------------------------------------------------------
 
-        if(s_flacRemainBlockPicLen <= 0 && !s_f_flacNewMetadataBlockPicture) {
-            if(s_flacBlockPicItem.size() > 0) { // get blockpic data
+        if(dec->remainBlockPicLen <= 0 && !dec->f_newMetadataBlockPicture) {
+            if(dec->blockPicItem.size() > 0) { // get blockpic data
                 // log_i("---------------------------------------------------------------------------");
-                // log_i("metadata blockpic found at pos %i, size %i bytes", s_flacBlockPicPos, s_flacBlockPicLen);
-                // for(int32_t i = 0; i < s_flacBlockPicItem.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, s_flacBlockPicItem[i], s_flacBlockPicItem[i + 1]); }
+                // log_i("metadata blockpic found at pos %i, size %i bytes", dec->blockPicPos, dec->blockPicLen);
+                // for(int32_t i = 0; i < dec->blockPicItem.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, dec->blockPicItem[i], dec->blockPicItem[i + 1]); }
                 // log_i("---------------------------------------------------------------------------");
-                s_f_flacNewMetadataBlockPicture = true;
+                dec->f_newMetadataBlockPicture = true;
             }
         }
 
-        switch(s_flacPageNr) {
+        switch(dec->pageNr) {
             case 0:
                 ret = parseFlacFirstPacket(inbuf, segmLen);
                 if(ret == segmLen) {
-                    s_flacPageNr = 1;
+                    dec->pageNr = 1;
                     ret = FLAC_PARSE_OGG_DONE;
                     break;
                 }
@@ -671,146 +684,145 @@ int8_t FLACDecode(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf){ //  MAIN
                 if(ret < segmLen){
                     segmLen -= ret;
                     *bytesLeft -= ret;
-                    s_flacCurrentFilePos += ret;
+                    dec->currentFilePos += ret;
                     inbuf += ret;
-                    s_flacPageNr = 1;
+                    dec->pageNr = 1;
                 } /* fallthrough */
             case 1:
-                if(s_flacRemainBlockPicLen > 0){
-                    s_flacRemainBlockPicLen -= segmLen;
-                    //log_i("s_flacCurrentFilePos %i, len %i, s_flacRemainBlockPicLen %i", s_flacCurrentFilePos, segmLen, s_flacRemainBlockPicLen);
-                    s_flacBlockPicItem.push_back(s_flacCurrentFilePos);
-                    s_flacBlockPicItem.push_back(segmLen);
-                    if(s_flacRemainBlockPicLen <= 0){s_flacPageNr = 2;}
+                if(dec->remainBlockPicLen > 0){
+                    dec->remainBlockPicLen -= segmLen;
+                    //log_i("dec->currentFilePos %i, len %i, dec->remainBlockPicLen %i", dec->currentFilePos, segmLen, dec->remainBlockPicLen);
+                    dec->blockPicItem.push_back(dec->currentFilePos);
+                    dec->blockPicItem.push_back(segmLen);
+                    if(dec->remainBlockPicLen <= 0){dec->pageNr = 2;}
                     ret = FLAC_PARSE_OGG_DONE;
                     break;
                 }
-                ret = parseMetaDataBlockHeader(inbuf, segmLen);
-                if(s_f_lastMetaDataBlock) s_flacPageNr = 2;
+                ret = parseMetaDataBlockHeader(dec, inbuf, segmLen);
+                if(dec->f_lastMetaDataBlock) dec->pageNr = 2;
                 break;
             case 2:
-                s_nBytes = segmLen;
+                dec->nBytes = segmLen;
                 return FLAC_PARSE_OGG_DONE;
                 break;
         }
         if(segmLen > 16384){
-            segmLenTmp = segmLen;
+            dec->segmLenTmp = segmLen;
             return FLAC_PARSE_OGG_DONE;
         }
         *bytesLeft -= segmLen;
-        s_flacCurrentFilePos += segmLen;
+        dec->currentFilePos += segmLen;
         return ret;
     }
-    ret = FLACDecodeNative(inbuf, bytesLeft, outbuf);
+    ret = FLACDecodeNative(dec, inbuf, bytesLeft, outbuf);
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t FLACDecodeNative(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf){
+int8_t FLACDecodeNative(FLACDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf){
 
     int32_t bl = *bytesLeft;
-    static int32_t sbl = 0;
 
-    if(s_flacStatus != OUT_SAMPLES){
-        s_rIndex = 0;
-        s_flacInptr = inbuf;
+    if(dec->status != OUT_SAMPLES){
+        dec->rIndex = 0;
+        dec->inptr = inbuf;
     }
 
-    while(s_flacStatus == DECODE_FRAME){// Read a ton of header fields, and ignore most of them
-        int32_t ret = flacDecodeFrame (inbuf, bytesLeft);
+    while(dec->status == DECODE_FRAME){// Read a ton of header fields, and ignore most of them
+        int32_t ret = flacDecodeFrame (dec, inbuf, bytesLeft);
         if(ret != 0) return ret;
         if(*bytesLeft < MAX_BLOCKSIZE) return FLAC_DECODE_FRAMES_LOOP; // need more data
-        sbl += bl - *bytesLeft;
+        dec->sbl += bl - *bytesLeft;
     }
 
-    if(s_flacStatus == DECODE_SUBFRAMES){
+    if(dec->status == DECODE_SUBFRAMES){
 
         // Decode each channel's subframe, then skip footer
-        int32_t ret = decodeSubframes(bytesLeft);
+        int32_t ret = decodeSubframes(dec, bytesLeft);
         if(ret != 0) return ret;
-        s_flacStatus = OUT_SAMPLES;
-        sbl += bl - *bytesLeft;
+        dec->status = OUT_SAMPLES;
+        dec->sbl += bl - *bytesLeft;
     }
 
-    if(s_flacStatus == OUT_SAMPLES){  // Write the decoded samples
+    if(dec->status == OUT_SAMPLES){  // Write the decoded samples
         // blocksize can be much greater than outbuff, so we can't stuff all in once
         // therefore we need often more than one loop (split outputblock into pieces)
         uint16_t blockSize;
-        if(s_blockSize < s_flacOutBuffSize + s_offset) blockSize = s_blockSize - s_offset;
+        if(dec->blockSize < s_flacOutBuffSize + dec->offset) blockSize = dec->blockSize - dec->offset;
         else blockSize = s_flacOutBuffSize;
 
         for (int32_t i = 0; i < blockSize; i++) {
-            for (int32_t j = 0; j < FLACMetadataBlock->numChannels; j++) {
-                int32_t val = s_samplesBuffer[j][i + s_offset];
-                if (FLACMetadataBlock->bitsPerSample == 8) val += 128;
+            for (int32_t j = 0; j < dec->metadataBlock->numChannels; j++) {
+                int32_t val = dec->samplesBuffer[j][i + dec->offset];
+                if (dec->metadataBlock->bitsPerSample == 8) val += 128;
                 outbuf[2*i+j] = val;
             }
         }
 
-        s_flacValidSamples = blockSize * FLACMetadataBlock->numChannels;
-        s_offset += blockSize;
-        if(sbl > 0){
-            s_flacCompressionRatio = (float)((s_flacValidSamples * 2) * FLACMetadataBlock->numChannels) / sbl; // valid samples are 16 bit
-            sbl = 0;
-            s_flacBitrate = FLACMetadataBlock->sampleRate * FLACMetadataBlock->bitsPerSample * FLACMetadataBlock->numChannels;
-            s_flacBitrate /= s_flacCompressionRatio;
-      //      log_e("s_flacBitrate %i, s_flacCompressionRatio %f, FLACMetadataBlock->sampleRate %i ", s_flacBitrate, s_flacCompressionRatio, FLACMetadataBlock->sampleRate);
+        dec->validSamples = blockSize * dec->metadataBlock->numChannels;
+        dec->offset += blockSize;
+        if(dec->sbl > 0){
+            dec->compressionRatio = (float)((dec->validSamples * 2) * dec->metadataBlock->numChannels) / dec->sbl; // valid samples are 16 bit
+            dec->sbl = 0;
+            dec->bitrate = dec->metadataBlock->sampleRate * dec->metadataBlock->bitsPerSample * dec->metadataBlock->numChannels;
+            dec->bitrate /= dec->compressionRatio;
+      //      log_e("dec->bitrate %i, dec->compressionRatio %f, dec->metadataBlock->sampleRate %i ", dec->bitrate, dec->compressionRatio, dec->metadataBlock->sampleRate);
         }
-        if(s_offset != s_blockSize) return GIVE_NEXT_LOOP;
-        if(s_offset > s_blockSize) { log_e("offset has a wrong value"); }
-        s_offset = 0;
+        if(dec->offset != dec->blockSize) return GIVE_NEXT_LOOP;
+        if(dec->offset > dec->blockSize) { log_e("offset has a wrong value"); }
+        dec->offset = 0;
     }
 
-    alignToByte();
-    readUint(16, bytesLeft);
+    alignToByte(dec);
+    readUint(dec, 16, bytesLeft);
 
-//    s_flacCompressionRatio = (float)m_bytesDecoded / (float)s_blockSize * FLACMetadataBlock->numChannels * (16/8);
-//    log_i("s_flacCompressionRatio % f", s_flacCompressionRatio);
-    s_flacStatus = DECODE_FRAME;
+//    dec->compressionRatio = (float)m_bytesDecoded / (float)dec->blockSize * dec->metadataBlock->numChannels * (16/8);
+//    log_i("dec->compressionRatio % f", dec->compressionRatio);
+    dec->status = DECODE_FRAME;
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t flacDecodeFrame(uint8_t *inbuf, int32_t *bytesLeft){
+int8_t flacDecodeFrame(FLACDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft){
     if(FLAC_specialIndexOf(inbuf, "OggS", *bytesLeft) == 0){ // async? => new sync is OggS => reset and decode (not page 0 or 1)
-        FLACDecoderReset();
-        s_flacPageNr = 2;
+        FLACDecoderReset(dec);
+        dec->pageNr = 2;
         return OGG_SYNC_FOUND;
     }
-    readUint(14 + 1, bytesLeft); // synccode + reserved bit
-    FLACFrameHeader->blockingStrategy = readUint(1, bytesLeft);
-    FLACFrameHeader->blockSizeCode = readUint(4, bytesLeft);
-    FLACFrameHeader->sampleRateCode = readUint(4, bytesLeft);
-    FLACFrameHeader->chanAsgn = readUint(4, bytesLeft);
-    FLACFrameHeader->sampleSizeCode = readUint(3, bytesLeft);
-    if(!FLACMetadataBlock->numChannels){
-        if(FLACFrameHeader->chanAsgn == 0) FLACMetadataBlock->numChannels = 1;
-        if(FLACFrameHeader->chanAsgn == 1) FLACMetadataBlock->numChannels = 2;
-        if(FLACFrameHeader->chanAsgn > 7)  FLACMetadataBlock->numChannels = 2;
+    readUint(dec, 14 + 1, bytesLeft); // synccode + reserved bit
+    dec->frameHeader->blockingStrategy = readUint(dec, 1, bytesLeft);
+    dec->frameHeader->blockSizeCode = readUint(dec, 4, bytesLeft);
+    dec->frameHeader->sampleRateCode = readUint(dec, 4, bytesLeft);
+    dec->frameHeader->chanAsgn = readUint(dec, 4, bytesLeft);
+    dec->frameHeader->sampleSizeCode = readUint(dec, 3, bytesLeft);
+    if(!dec->metadataBlock->numChannels){
+        if(dec->frameHeader->chanAsgn == 0) dec->metadataBlock->numChannels = 1;
+        if(dec->frameHeader->chanAsgn == 1) dec->metadataBlock->numChannels = 2;
+        if(dec->frameHeader->chanAsgn > 7)  dec->metadataBlock->numChannels = 2;
     }
-    if(FLACMetadataBlock->numChannels < 1) return ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT;
-    if(!FLACMetadataBlock->bitsPerSample){
-        if(FLACFrameHeader->sampleSizeCode == 1) FLACMetadataBlock->bitsPerSample =  8;
-        if(FLACFrameHeader->sampleSizeCode == 2) FLACMetadataBlock->bitsPerSample = 12;
-        if(FLACFrameHeader->sampleSizeCode == 4) FLACMetadataBlock->bitsPerSample = 16;
-        if(FLACFrameHeader->sampleSizeCode == 5) FLACMetadataBlock->bitsPerSample = 20;
-        if(FLACFrameHeader->sampleSizeCode == 6) FLACMetadataBlock->bitsPerSample = 24;
+    if(dec->metadataBlock->numChannels < 1) return ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT;
+    if(!dec->metadataBlock->bitsPerSample){
+        if(dec->frameHeader->sampleSizeCode == 1) dec->metadataBlock->bitsPerSample =  8;
+        if(dec->frameHeader->sampleSizeCode == 2) dec->metadataBlock->bitsPerSample = 12;
+        if(dec->frameHeader->sampleSizeCode == 4) dec->metadataBlock->bitsPerSample = 16;
+        if(dec->frameHeader->sampleSizeCode == 5) dec->metadataBlock->bitsPerSample = 20;
+        if(dec->frameHeader->sampleSizeCode == 6) dec->metadataBlock->bitsPerSample = 24;
     }
-    if(FLACMetadataBlock->bitsPerSample > 16) return ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG;
-    if(FLACMetadataBlock->bitsPerSample < 8 ) return ERR_FLAC_BITS_PER_SAMPLE_UNKNOWN;
-    if(!FLACMetadataBlock->sampleRate){
-        if(FLACFrameHeader->sampleRateCode == 1)  FLACMetadataBlock->sampleRate =  88200;
-        if(FLACFrameHeader->sampleRateCode == 2)  FLACMetadataBlock->sampleRate = 176400;
-        if(FLACFrameHeader->sampleRateCode == 3)  FLACMetadataBlock->sampleRate = 192000;
-        if(FLACFrameHeader->sampleRateCode == 4)  FLACMetadataBlock->sampleRate =   8000;
-        if(FLACFrameHeader->sampleRateCode == 5)  FLACMetadataBlock->sampleRate =  16000;
-        if(FLACFrameHeader->sampleRateCode == 6)  FLACMetadataBlock->sampleRate =  22050;
-        if(FLACFrameHeader->sampleRateCode == 7)  FLACMetadataBlock->sampleRate =  24000;
-        if(FLACFrameHeader->sampleRateCode == 8)  FLACMetadataBlock->sampleRate =  32000;
-        if(FLACFrameHeader->sampleRateCode == 9)  FLACMetadataBlock->sampleRate =  44100;
-        if(FLACFrameHeader->sampleRateCode == 10) FLACMetadataBlock->sampleRate =  48000;
-        if(FLACFrameHeader->sampleRateCode == 11) FLACMetadataBlock->sampleRate =  96000;
+    if(dec->metadataBlock->bitsPerSample > 16) return ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG;
+    if(dec->metadataBlock->bitsPerSample < 8 ) return ERR_FLAC_BITS_PER_SAMPLE_UNKNOWN;
+    if(!dec->metadataBlock->sampleRate){
+        if(dec->frameHeader->sampleRateCode == 1)  dec->metadataBlock->sampleRate =  88200;
+        if(dec->frameHeader->sampleRateCode == 2)  dec->metadataBlock->sampleRate = 176400;
+        if(dec->frameHeader->sampleRateCode == 3)  dec->metadataBlock->sampleRate = 192000;
+        if(dec->frameHeader->sampleRateCode == 4)  dec->metadataBlock->sampleRate =   8000;
+        if(dec->frameHeader->sampleRateCode == 5)  dec->metadataBlock->sampleRate =  16000;
+        if(dec->frameHeader->sampleRateCode == 6)  dec->metadataBlock->sampleRate =  22050;
+        if(dec->frameHeader->sampleRateCode == 7)  dec->metadataBlock->sampleRate =  24000;
+        if(dec->frameHeader->sampleRateCode == 8)  dec->metadataBlock->sampleRate =  32000;
+        if(dec->frameHeader->sampleRateCode == 9)  dec->metadataBlock->sampleRate =  44100;
+        if(dec->frameHeader->sampleRateCode == 10) dec->metadataBlock->sampleRate =  48000;
+        if(dec->frameHeader->sampleRateCode == 11) dec->metadataBlock->sampleRate =  96000;
     }
-    readUint(1, bytesLeft);
-    uint32_t temp = (readUint(8, bytesLeft) << 24);
+    readUint(dec, 1, bytesLeft);
+    uint32_t temp = (readUint(dec, 8, bytesLeft) << 24);
     temp = ~temp;
     uint32_t shift = 0x80000000; // Number of leading zeros
     int8_t count = 0;
@@ -819,122 +831,122 @@ int8_t flacDecodeFrame(uint8_t *inbuf, int32_t *bytesLeft){
         else break;
     }
     count--;
-    for (int32_t i = 0; i < count; i++) readUint(8, bytesLeft);
-    s_blockSize = 0;
-    if (FLACFrameHeader->blockSizeCode == 1)
-        s_blockSize = 192;
-    else if (2 <= FLACFrameHeader->blockSizeCode && FLACFrameHeader->blockSizeCode <= 5)
-        s_blockSize = 576 << (FLACFrameHeader->blockSizeCode - 2);
-    else if (FLACFrameHeader->blockSizeCode == 6)
-        s_blockSize = readUint(8, bytesLeft) + 1;
-    else if (FLACFrameHeader->blockSizeCode == 7)
-        s_blockSize = readUint(16, bytesLeft) + 1;
-    else if (8 <= FLACFrameHeader->blockSizeCode && FLACFrameHeader->blockSizeCode <= 15)
-        s_blockSize = 256 << (FLACFrameHeader->blockSizeCode - 8);
+    for (int32_t i = 0; i < count; i++) readUint(dec, 8, bytesLeft);
+    dec->blockSize = 0;
+    if (dec->frameHeader->blockSizeCode == 1)
+        dec->blockSize = 192;
+    else if (2 <= dec->frameHeader->blockSizeCode && dec->frameHeader->blockSizeCode <= 5)
+        dec->blockSize = 576 << (dec->frameHeader->blockSizeCode - 2);
+    else if (dec->frameHeader->blockSizeCode == 6)
+        dec->blockSize = readUint(dec, 8, bytesLeft) + 1;
+    else if (dec->frameHeader->blockSizeCode == 7)
+        dec->blockSize = readUint(dec, 16, bytesLeft) + 1;
+    else if (8 <= dec->frameHeader->blockSizeCode && dec->frameHeader->blockSizeCode <= 15)
+        dec->blockSize = 256 << (dec->frameHeader->blockSizeCode - 8);
     else{
         return ERR_FLAC_RESERVED_BLOCKSIZE_UNSUPPORTED;
     }
     uint16_t maxBS = 8192;
     if(psramFound()) maxBS = 8192 * 4;
-    if(s_blockSize > maxBS){
-        log_e("Error: blockSize too big ,%i bytes", s_blockSize);
+    if(dec->blockSize > maxBS){
+        log_e("Error: blockSize too big ,%i bytes", dec->blockSize);
         return ERR_FLAC_BLOCKSIZE_TOO_BIG;
     }
-    if(FLACFrameHeader->sampleRateCode == 12)
-        readUint(8, bytesLeft);
-    else if (FLACFrameHeader->sampleRateCode == 13 || FLACFrameHeader->sampleRateCode == 14){
-        readUint(16, bytesLeft);
+    if(dec->frameHeader->sampleRateCode == 12)
+        readUint(dec, 8, bytesLeft);
+    else if (dec->frameHeader->sampleRateCode == 13 || dec->frameHeader->sampleRateCode == 14){
+        readUint(dec, 16, bytesLeft);
     }
-    readUint(8, bytesLeft);
-    s_flacStatus = DECODE_SUBFRAMES;
-    s_blockSizeLeft = s_blockSize;
+    readUint(dec, 8, bytesLeft);
+    dec->status = DECODE_SUBFRAMES;
+    dec->blockSizeLeft = dec->blockSize;
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint16_t FLACGetOutputSamps(){
-    int32_t vs = s_flacValidSamples;
-    s_flacValidSamples=0;
+uint16_t FLACGetOutputSamps(FLACDecoder_t* dec){
+    int32_t vs = dec->validSamples;
+    dec->validSamples=0;
     return vs;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint64_t FLACGetTotoalSamplesInStream(){
-    if(!FLACMetadataBlock) return 0;
-    return FLACMetadataBlock->totalSamples;
+uint64_t FLACGetTotoalSamplesInStream(FLACDecoder_t* dec){
+    if(!dec->metadataBlock) return 0;
+    return dec->metadataBlock->totalSamples;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint8_t FLACGetBitsPerSample(){
-    if(!FLACMetadataBlock) return 0;
-    return FLACMetadataBlock->bitsPerSample;
+uint8_t FLACGetBitsPerSample(FLACDecoder_t* dec){
+    if(!dec->metadataBlock) return 0;
+    return dec->metadataBlock->bitsPerSample;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint8_t FLACGetChannels(){
-    if(!FLACMetadataBlock) return 0;
-    return FLACMetadataBlock->numChannels;
+uint8_t FLACGetChannels(FLACDecoder_t* dec){
+    if(!dec->metadataBlock) return 0;
+    return dec->metadataBlock->numChannels;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetSampRate(){
-    if(!FLACMetadataBlock) return 0;
-    return FLACMetadataBlock->sampleRate;
+uint32_t FLACGetSampRate(FLACDecoder_t* dec){
+    if(!dec->metadataBlock) return 0;
+    return dec->metadataBlock->sampleRate;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetBitRate(){
-    return s_flacBitrate;
+uint32_t FLACGetBitRate(FLACDecoder_t* dec){
+    return dec->bitrate;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetAudioDataStart(){
-    return s_flacAudioDataStart;
+uint32_t FLACGetAudioDataStart(FLACDecoder_t* dec){
+    return dec->audioDataStart;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetAudioFileDuration() {
-    if(FLACGetSampRate()){ // DIV0
-        uint32_t afd = FLACGetTotoalSamplesInStream()/ FLACGetSampRate(); // AudioFileDuration
+uint32_t FLACGetAudioFileDuration(FLACDecoder_t* dec) {
+    if(FLACGetSampRate(dec)){ // DIV0
+        uint32_t afd = FLACGetTotoalSamplesInStream(dec)/ FLACGetSampRate(dec); // AudioFileDuration
         return afd;
     }
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t decodeSubframes(int32_t* bytesLeft){
-    if(FLACFrameHeader->chanAsgn <= 7) {
-        for (int32_t ch = 0; ch < FLACMetadataBlock->numChannels; ch++)
-            decodeSubframe(FLACMetadataBlock->bitsPerSample, ch, bytesLeft);
+int8_t decodeSubframes(FLACDecoder_t* dec, int32_t* bytesLeft){
+    if(dec->frameHeader->chanAsgn <= 7) {
+        for (int32_t ch = 0; ch < dec->metadataBlock->numChannels; ch++)
+            decodeSubframe(dec, dec->metadataBlock->bitsPerSample, ch, bytesLeft);
     }
-    else if (8 <= FLACFrameHeader->chanAsgn && FLACFrameHeader->chanAsgn <= 10) {
-        decodeSubframe(FLACMetadataBlock->bitsPerSample + (FLACFrameHeader->chanAsgn == 9 ? 1 : 0), 0, bytesLeft);
-        decodeSubframe(FLACMetadataBlock->bitsPerSample + (FLACFrameHeader->chanAsgn == 9 ? 0 : 1), 1, bytesLeft);
-        if(FLACFrameHeader->chanAsgn == 8) {
-            for (int32_t i = 0; i < s_blockSize; i++)
-                s_samplesBuffer[1][i] = (
-                        s_samplesBuffer[0][i] -
-                        s_samplesBuffer[1][i]);
+    else if (8 <= dec->frameHeader->chanAsgn && dec->frameHeader->chanAsgn <= 10) {
+        decodeSubframe(dec, dec->metadataBlock->bitsPerSample + (dec->frameHeader->chanAsgn == 9 ? 1 : 0), 0, bytesLeft);
+        decodeSubframe(dec, dec->metadataBlock->bitsPerSample + (dec->frameHeader->chanAsgn == 9 ? 0 : 1), 1, bytesLeft);
+        if(dec->frameHeader->chanAsgn == 8) {
+            for (int32_t i = 0; i < dec->blockSize; i++)
+                dec->samplesBuffer[1][i] = (
+                        dec->samplesBuffer[0][i] -
+                        dec->samplesBuffer[1][i]);
         }
-        else if (FLACFrameHeader->chanAsgn == 9) {
-            for (int32_t i = 0; i < s_blockSize; i++)
-                s_samplesBuffer[0][i] += s_samplesBuffer[1][i];
+        else if (dec->frameHeader->chanAsgn == 9) {
+            for (int32_t i = 0; i < dec->blockSize; i++)
+                dec->samplesBuffer[0][i] += dec->samplesBuffer[1][i];
         }
-        else if (FLACFrameHeader->chanAsgn == 10) {
-            for (int32_t i = 0; i < s_blockSize; i++) {
-                int32_t side =  s_samplesBuffer[1][i];
-                int32_t right = s_samplesBuffer[0][i] - (side >> 1);
-                s_samplesBuffer[1][i] = right;
-                s_samplesBuffer[0][i] = right + side;
+        else if (dec->frameHeader->chanAsgn == 10) {
+            for (int32_t i = 0; i < dec->blockSize; i++) {
+                int32_t side =  dec->samplesBuffer[1][i];
+                int32_t right = dec->samplesBuffer[0][i] - (side >> 1);
+                dec->samplesBuffer[1][i] = right;
+                dec->samplesBuffer[0][i] = right + side;
             }
         }
         else {
-            log_e("unknown channel assignment, %i", FLACFrameHeader->chanAsgn);
+            log_e("unknown channel assignment, %i", dec->frameHeader->chanAsgn);
             return ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT;
         }
     }
     else{
-        log_e("Reserved channel assignment, %i", FLACFrameHeader->chanAsgn);
+        log_e("Reserved channel assignment, %i", dec->frameHeader->chanAsgn);
         return ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT;
     }
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t decodeSubframe(uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft) {
+int8_t decodeSubframe(FLACDecoder_t* dec, uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft) {
     int8_t ret = 0;
-    readUint(1, bytesLeft);                // Zero bit padding, to prevent sync-fooling string of 1s
-    uint8_t type = readUint(6, bytesLeft); // Subframe type: 000000 : SUBFRAME_CONSTANT
+    readUint(dec, 1, bytesLeft);                // Zero bit padding, to prevent sync-fooling string of 1s
+    uint8_t type = readUint(dec, 6, bytesLeft); // Subframe type: 000000 : SUBFRAME_CONSTANT
                                            //                000001 : SUBFRAME_VERBATIM
                                            //                00001x : reserved
                                            //                0001xx : reserved
@@ -942,127 +954,127 @@ int8_t decodeSubframe(uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft) {
                                            //                01xxxx : reserved
                                            //                1xxxxx : SUBFRAME_LPC, xxxxx=order-1
 
-    int32_t shift = readUint(1, bytesLeft);    // Wasted bits-per-sample' flag:
+    int32_t shift = readUint(dec, 1, bytesLeft);    // Wasted bits-per-sample' flag:
                                            // 0 : no wasted bits-per-sample in source subblock, k=0
                                            // 1 : k wasted bits-per-sample in source subblock, k-1 follows, unary coded; e.g. k=3 => 001 follows, k=7 => 0000001 follows.
     if (shift == 1) {
-        while (readUint(1, bytesLeft) == 0) { shift++;}
+        while (readUint(dec, 1, bytesLeft) == 0) { shift++;}
     }
     sampleDepth -= shift;
 
     if(type == 0){  // Constant coding
-        int32_t s= readSignedInt(sampleDepth, bytesLeft);                                    // SUBFRAME_CONSTANT
-        for(int32_t i=0; i < s_blockSize; i++){
-            s_samplesBuffer[ch][i] = s;
+        int32_t s= readSignedInt(dec, sampleDepth, bytesLeft);                                    // SUBFRAME_CONSTANT
+        for(int32_t i=0; i < dec->blockSize; i++){
+            dec->samplesBuffer[ch][i] = s;
         }
     }
     else if (type == 1) {  // Verbatim coding
-        for (int32_t i = 0; i < s_blockSize; i++)
-            s_samplesBuffer[ch][i] = readSignedInt(sampleDepth, bytesLeft);                  // SUBFRAME_VERBATIM
+        for (int32_t i = 0; i < dec->blockSize; i++)
+            dec->samplesBuffer[ch][i] = readSignedInt(dec, sampleDepth, bytesLeft);                  // SUBFRAME_VERBATIM
     }
     else if (8 <= type && type <= 12){
-        ret = decodeFixedPredictionSubframe(type - 8, sampleDepth, ch, bytesLeft);           // SUBFRAME_FIXED
+        ret = decodeFixedPredictionSubframe(dec, type - 8, sampleDepth, ch, bytesLeft);           // SUBFRAME_FIXED
         if(ret) return ret;
     }
     else if (32 <= type && type <= 63){
-        ret = decodeLinearPredictiveCodingSubframe(type - 31, sampleDepth, ch, bytesLeft);   // SUBFRAME_LPC
+        ret = decodeLinearPredictiveCodingSubframe(dec, type - 31, sampleDepth, ch, bytesLeft);   // SUBFRAME_LPC
         if(ret) return ret;
     }
     else{
         return ERR_FLAC_RESERVED_SUB_TYPE;
     }
     if(shift>0){
-        for (int32_t i = 0; i < s_blockSize; i++){
-            s_samplesBuffer[ch][i] <<= shift;
+        for (int32_t i = 0; i < dec->blockSize; i++){
+            dec->samplesBuffer[ch][i] <<= shift;
         }
     }
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int8_t decodeFixedPredictionSubframe(uint8_t predOrder, uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft) {     // SUBFRAME_FIXED
+int8_t decodeFixedPredictionSubframe(FLACDecoder_t* dec, uint8_t predOrder, uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft) {     // SUBFRAME_FIXED
 
     uint8_t ret = 0;
     for(uint8_t i = 0; i < predOrder; i++)
-        s_samplesBuffer[ch][i] = readSignedInt(sampleDepth, bytesLeft); // Unencoded warm-up samples (n = frame's bits-per-sample * predictor order).
-    ret = decodeResiduals(predOrder, ch, bytesLeft);
+        dec->samplesBuffer[ch][i] = readSignedInt(dec, sampleDepth, bytesLeft); // Unencoded warm-up samples (n = frame's bits-per-sample * predictor order).
+    ret = decodeResiduals(dec, predOrder, ch, bytesLeft);
     if(ret) return ret;
-    coefs.clear(); coefs.shrink_to_fit();
-    if(predOrder == 0) coefs.resize(0);
-    if(predOrder == 1) coefs.push_back(1);  // FIXED_PREDICTION_COEFFICIENTS
-    if(predOrder == 2){coefs.push_back(2); coefs.push_back(-1);}
-    if(predOrder == 3){coefs.push_back(3); coefs.push_back(-3); coefs.push_back(1);}
-    if(predOrder == 4){coefs.push_back(4); coefs.push_back(-6); coefs.push_back(4); coefs.push_back(-1);}
+    dec->coefs.clear(); dec->coefs.shrink_to_fit();
+    if(predOrder == 0) dec->coefs.resize(0);
+    if(predOrder == 1) dec->coefs.push_back(1);  // FIXED_PREDICTION_COEFFICIENTS
+    if(predOrder == 2){dec->coefs.push_back(2); dec->coefs.push_back(-1);}
+    if(predOrder == 3){dec->coefs.push_back(3); dec->coefs.push_back(-3); dec->coefs.push_back(1);}
+    if(predOrder == 4){dec->coefs.push_back(4); dec->coefs.push_back(-6); dec->coefs.push_back(4); dec->coefs.push_back(-1);}
     if(predOrder > 4) return ERR_FLAC_PREORDER_TOO_BIG; // Error: preorder > 4"
-    restoreLinearPrediction(ch, 0);
+    restoreLinearPrediction(dec, ch, 0);
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t decodeLinearPredictiveCodingSubframe(int32_t lpcOrder, int32_t sampleDepth, uint8_t ch, int32_t* bytesLeft){
+int8_t decodeLinearPredictiveCodingSubframe(FLACDecoder_t* dec, int32_t lpcOrder, int32_t sampleDepth, uint8_t ch, int32_t* bytesLeft){
 
     int8_t ret = 0;
     for (int32_t i = 0; i < lpcOrder; i++){
-        s_samplesBuffer[ch][i] = readSignedInt(sampleDepth, bytesLeft); // Unencoded warm-up samples (n = frame's bits-per-sample * lpc order).
+        dec->samplesBuffer[ch][i] = readSignedInt(dec, sampleDepth, bytesLeft); // Unencoded warm-up samples (n = frame's bits-per-sample * lpc order).
     }
-    int32_t precision = readUint(4, bytesLeft) + 1;                         // (Quantized linear predictor coefficients' precision in bits)-1 (1111 = invalid).
-    int32_t shift = readSignedInt(5, bytesLeft);                            // Quantized linear predictor coefficient shift needed in bits (NOTE: this number is signed two's-complement).
-    coefs.clear(); coefs.shrink_to_fit();
+    int32_t precision = readUint(dec, 4, bytesLeft) + 1;                         // (Quantized linear predictor coefficients' precision in bits)-1 (1111 = invalid).
+    int32_t shift = readSignedInt(dec, 5, bytesLeft);                            // Quantized linear predictor coefficient shift needed in bits (NOTE: this number is signed two's-complement).
+    dec->coefs.clear(); dec->coefs.shrink_to_fit();
     for (uint8_t i = 0; i < lpcOrder; i++){
-        coefs.push_back(readSignedInt(precision, bytesLeft));           // Unencoded predictor coefficients (n = qlp coeff precision * lpc order) (NOTE: the coefficients are signed two's-complement).
+        dec->coefs.push_back(readSignedInt(dec, precision, bytesLeft));           // Unencoded predictor coefficients (n = qlp coeff precision * lpc order) (NOTE: the coefficients are signed two's-complement).
     }
-    ret = decodeResiduals(lpcOrder, ch, bytesLeft);
+    ret = decodeResiduals(dec, lpcOrder, ch, bytesLeft);
     if(ret) return ret;
-    restoreLinearPrediction(ch, shift);
+    restoreLinearPrediction(dec, ch, shift);
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int8_t decodeResiduals(uint8_t warmup, uint8_t ch, int32_t* bytesLeft) {
+CODEC_HOT_FUNC int8_t decodeResiduals(FLACDecoder_t* dec, uint8_t warmup, uint8_t ch, int32_t* bytesLeft) {
 
-    int32_t method = readUint(2, bytesLeft);                          // Residual coding method:
+    int32_t method = readUint(dec, 2, bytesLeft);                          // Residual coding method:
                                                                   // 00 : partitioned Rice coding with 4-bit Rice parameter; RESIDUAL_CODING_METHOD_PARTITIONED_RICE follows
                                                                   // 01 : partitioned Rice coding with 5-bit Rice parameter; RESIDUAL_CODING_METHOD_PARTITIONED_RICE2 follows
                                                                   // 10-11 : reserved
     if (method >= 2) {return ERR_FLAC_RESERVED_RESIDUAL_CODING;}
     uint8_t paramBits = method == 0 ? 4 : 5;                      // RESIDUAL_CODING_METHOD_PARTITIONED_RICE || RESIDUAL_CODING_METHOD_PARTITIONED_RICE2
     int32_t escapeParam = ( method == 0 ? 0xF : 0x1F);
-    int32_t partitionOrder = readUint(4, bytesLeft);                  // Partition order
+    int32_t partitionOrder = readUint(dec, 4, bytesLeft);                  // Partition order
     int32_t numPartitions = 1 << partitionOrder;                      // There will be 2^order partitions.
 
-    if (s_blockSize % numPartitions != 0){
+    if (dec->blockSize % numPartitions != 0){
         return ERR_FLAC_WRONG_RICE_PARTITION_NR;                  //Error: Block size not divisible by number of Rice partitions
     }
-    int32_t partitionSize = s_blockSize / numPartitions;
+    int32_t partitionSize = dec->blockSize / numPartitions;
 
     for (int32_t i = 0; i < numPartitions; i++) {
         int32_t start = i * partitionSize + (i == 0 ? warmup : 0);
         int32_t end = (i + 1) * partitionSize;
 
-        int32_t param = readUint(paramBits, bytesLeft);
+        int32_t param = readUint(dec, paramBits, bytesLeft);
         if (param < escapeParam) {
             for (int32_t j = start; j < end; j++){
-                if(s_f_bitReaderError) break;
-                s_samplesBuffer[ch][j] = readRiceSignedInt(param, bytesLeft);
+                if(dec->f_bitReaderError) break;
+                dec->samplesBuffer[ch][j] = readRiceSignedInt(dec, param, bytesLeft);
             }
         }
         else {
-            int32_t numBits = readUint(5, bytesLeft);                 // Escape code, meaning the partition is in unencoded binary form using n bits per sample; n follows as a 5-bit number.
+            int32_t numBits = readUint(dec, 5, bytesLeft);                 // Escape code, meaning the partition is in unencoded binary form using n bits per sample; n follows as a 5-bit number.
             for (int32_t j = start; j < end; j++){
-                if(s_f_bitReaderError) break;
-                s_samplesBuffer[ch][j] = readSignedInt(numBits, bytesLeft);
+                if(dec->f_bitReaderError) break;
+                dec->samplesBuffer[ch][j] = readSignedInt(dec, numBits, bytesLeft);
             }
         }
     }
-    if(s_f_bitReaderError) return ERR_FLAC_BITREADER_UNDERFLOW;
+    if(dec->f_bitReaderError) return ERR_FLAC_BITREADER_UNDERFLOW;
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void restoreLinearPrediction(uint8_t ch, uint8_t shift) {
+CODEC_HOT_FUNC void restoreLinearPrediction(FLACDecoder_t* dec, uint8_t ch, uint8_t shift) {
 
-    for (int32_t i = coefs.size(); i < s_blockSize; i++) {
+    for (int32_t i = dec->coefs.size(); i < dec->blockSize; i++) {
         int32_t sum = 0;
-        for (int32_t j = 0; j < coefs.size(); j++){
-            sum += s_samplesBuffer[ch][i - 1 - j] * coefs[j];
+        for (int32_t j = 0; j < dec->coefs.size(); j++){
+            sum += dec->samplesBuffer[ch][i - 1 - j] * dec->coefs[j];
         }
-        s_samplesBuffer[ch][i] += (sum >> shift);
+        dec->samplesBuffer[ch][i] += (sum >> shift);
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -1112,3 +1124,4 @@ char* flac_x_ps_strndup(const char* str, uint16_t n) {
     return ps_str;
 }
 //----------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_FLAC
@@ -18,6 +18,8 @@
 
 #include "Arduino.h"
 #include <vector>
+#include "../codec_arena.h"
+#include "../codec_mem.h"
 using namespace std;
 
 #define MAX_CHANNELS 2
@@ -146,40 +148,86 @@ typedef struct FLACFrameHeader_t {
 
 }FLACFrameHeader_t;
 
-int32_t          FLACFindSyncWord(unsigned char* buf, int32_t nBytes);
+typedef struct FLACDecoder_t { // complete decoder state, one per stream
+    FLACFrameHeader_t*   frameHeader = NULL;
+    FLACMetadataBlock_t* metadataBlock = NULL;
+    vector<uint16_t>     segmTableVec;
+    vector<int32_t>      coefs;
+    vector<uint32_t>     blockPicItem;
+    uint64_t             bitBuffer = 0;
+    uint32_t             bitrate = 0;
+    uint32_t             blockPicLenUntilFrameEnd = 0;
+    uint32_t             currentFilePos = 0;
+    uint32_t             blockPicPos = 0;
+    uint32_t             blockPicLen = 0;
+    uint32_t             audioDataStart = 0;
+    int32_t              remainBlockPicLen = 0;
+    uint16_t             blockSize = 0;
+    uint16_t             blockSizeLeft = 0;
+    uint16_t             validSamples = 0;
+    uint16_t             rIndex = 0;
+    uint16_t             offset = 0;
+    uint16_t             segmLenTmp = 0;
+    uint8_t              status = 0;
+    uint8_t*             inptr = NULL;
+    float                compressionRatio = 0;
+    uint8_t              bitBufferLen = 0;
+    bool                 f_parseOgg = false;
+    bool                 f_bitReaderError = false;
+    uint8_t              pageSegments = 0;
+    char*                streamTitle = NULL;
+    char*                vendorString = NULL;
+    bool                 f_newStreamtitle = false;
+    bool                 f_firstCall = true;
+    bool                 f_oggWrapper = false;
+    bool                 f_lastMetaDataBlock = false;
+    bool                 f_newMetadataBlockPicture = false;
+    uint8_t              pageNr = 0;
+    int32_t**            samplesBuffer = NULL;
+    uint16_t             maxBlocksize = MAX_BLOCKSIZE;
+    int32_t              nBytes = 0;
+    int32_t              sbl = 0;
+}FLACDecoder_t;
+
+int32_t          FLACFindSyncWord(FLACDecoder_t* dec, unsigned char* buf, int32_t nBytes);
+int32_t          FLACFindFrameHeader(uint8_t* buf, int32_t nBytes);
 boolean          FLACFindMagicWord(unsigned char* buf, int32_t nBytes);
-char*            FLACgetStreamTitle();
-int32_t          FLACparseOGG(uint8_t* inbuf, int32_t* bytesLeft);
-vector<uint32_t> FLACgetMetadataBlockPicture();
+char*            FLACgetStreamTitle(FLACDecoder_t* dec);
+int32_t          FLACparseOGG(FLACDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft);
+vector<uint32_t> FLACgetMetadataBlockPicture(FLACDecoder_t* dec);
 int32_t          parseFlacFirstPacket(uint8_t* inbuf, int16_t nBytes);
-int32_t          parseMetaDataBlockHeader(uint8_t* inbuf, int16_t nBytes);
-bool             FLACDecoder_AllocateBuffers(void);
-void             FLACDecoder_setDefaults();
-void             FLACDecoder_ClearBuffer();
-void             FLACDecoder_FreeBuffers();
-void             FLACSetRawBlockParams(uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis, uint32_t AuDaLength);
-void             FLACDecoderReset();
-int8_t           FLACDecode(uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf);
-int8_t           FLACDecodeNative(uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf);
-int8_t           flacDecodeFrame(uint8_t* inbuf, int32_t* bytesLeft);
-uint16_t         FLACGetOutputSamps();
-uint64_t         FLACGetTotoalSamplesInStream();
-uint8_t          FLACGetBitsPerSample();
-uint8_t          FLACGetChannels();
-uint32_t         FLACGetSampRate();
-uint32_t         FLACGetBitRate();
-uint32_t         FLACGetAudioDataStart();
-uint32_t         FLACGetAudioFileDuration();
-uint32_t         readUint(uint8_t nBits, int32_t* bytesLeft);
-int32_t          readSignedInt(int32_t nBits, int32_t* bytesLeft);
-int64_t          readRiceSignedInt(uint8_t param, int32_t* bytesLeft);
-void             alignToByte();
-int8_t           decodeSubframes(int32_t* bytesLeft);
-int8_t           decodeSubframe(uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft);
-int8_t           decodeFixedPredictionSubframe(uint8_t predOrder, uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft);
-int8_t           decodeLinearPredictiveCodingSubframe(int32_t lpcOrder, int32_t sampleDepth, uint8_t ch, int32_t* bytesLeft);
-int8_t           decodeResiduals(uint8_t warmup, uint8_t ch, int32_t* bytesLeft);
-void             restoreLinearPrediction(uint8_t ch, uint8_t shift);
+int32_t          parseMetaDataBlockHeader(FLACDecoder_t* dec, uint8_t* inbuf, int16_t nBytes);
+FLACDecoder_t*   FLACDecoder_Create();
+void             FLACDecoder_Destroy(FLACDecoder_t* dec);
+FLACDecoder_t*   FLACDecoder_Default();
+uint32_t         FLACDecoder_ArenaSize(void);
+bool             FLACDecoder_AllocateBuffers(FLACDecoder_t* dec);
+void             FLACDecoder_setDefaults(FLACDecoder_t* dec);
+void             FLACDecoder_ClearBuffer(FLACDecoder_t* dec);
+void             FLACDecoder_FreeBuffers(FLACDecoder_t* dec);
+void             FLACSetRawBlockParams(FLACDecoder_t* dec, uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis, uint32_t AuDaLength);
+void             FLACDecoderReset(FLACDecoder_t* dec);
+int8_t           FLACDecode(FLACDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf);
+int8_t           FLACDecodeNative(FLACDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf);
+int8_t           flacDecodeFrame(FLACDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft);
+uint16_t         FLACGetOutputSamps(FLACDecoder_t* dec);
+uint64_t         FLACGetTotoalSamplesInStream(FLACDecoder_t* dec);
+uint8_t          FLACGetBitsPerSample(FLACDecoder_t* dec);
+uint8_t          FLACGetChannels(FLACDecoder_t* dec);
+uint32_t         FLACGetSampRate(FLACDecoder_t* dec);
+uint32_t         FLACGetBitRate(FLACDecoder_t* dec);
+uint32_t         FLACGetAudioDataStart(FLACDecoder_t* dec);
+uint32_t         FLACGetAudioFileDuration(FLACDecoder_t* dec);
+uint32_t         readUint(FLACDecoder_t* dec, uint8_t nBits, int32_t* bytesLeft);
+int32_t          readSignedInt(FLACDecoder_t* dec, int32_t nBits, int32_t* bytesLeft);
+int64_t          readRiceSignedInt(FLACDecoder_t* dec, uint8_t param, int32_t* bytesLeft);
+void             alignToByte(FLACDecoder_t* dec);
+int8_t           decodeSubframes(FLACDecoder_t* dec, int32_t* bytesLeft);
+int8_t           decodeSubframe(FLACDecoder_t* dec, uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft);
+int8_t           decodeFixedPredictionSubframe(FLACDecoder_t* dec, uint8_t predOrder, uint8_t sampleDepth, uint8_t ch, int32_t* bytesLeft);
+int8_t           decodeLinearPredictiveCodingSubframe(FLACDecoder_t* dec, int32_t lpcOrder, int32_t sampleDepth, uint8_t ch, int32_t* bytesLeft);
+int8_t           decodeResiduals(FLACDecoder_t* dec, uint8_t warmup, uint8_t ch, int32_t* bytesLeft);
+void             restoreLinearPrediction(FLACDecoder_t* dec, uint8_t ch, uint8_t shift);
 int32_t          FLAC_specialIndexOf(uint8_t* base, const char* str, int32_t baselen, bool exact = false);
 char*            flac_x_ps_malloc(uint16_t len);
 char*            flac_x_ps_calloc(uint16_t len, uint8_t size);
@@ -0,0 +1,401 @@
+/*
+ * hls_prefetch.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "hls_prefetch.h"
+#include "codec_mem.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+HlsPrefetch::HlsPrefetch() {
+    for(int i = 0; i <= HLS_PREFETCH_MAX_DEPTH; i++) {
+        m_slots[i].url = NULL;
+        m_slots[i].state = SEG_FREE;
+        m_slots[i].bytes = 0;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+HlsPrefetch::~HlsPrefetch() {
+    end();
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::begin(uint8_t depth) {
+    end();
+    if(!psramFound()) { log_e("hls prefetch: needs PSRAM"); return false; }
+    m_depth = constrain(depth, 1, HLS_PREFETCH_MAX_DEPTH);
+    m_size = AUDIO_HLS_PREFETCH_BUFFER;
+    m_buffer = (uint8_t*)CodecMem_Alloc(m_size, CODEC_MEM_COLD, "hls prefetch");
+    m_playlistBuf = (char*)CodecMem_Alloc(AUDIO_HLS_PLAYLIST_SIZE + 1, CODEC_MEM_COLD, "hls playlist");
+    if(!m_buffer || !m_playlistBuf) { log_e("hls prefetch: not enough memory"); end(); return false; }
+    m_head = 0;
+    m_count = 0;
+    m_load = 0;
+    m_writeIdx = 0;
+    m_readIdx = 0;
+    m_playlistState = PL_IDLE;
+    m_secure.setInsecure();
+    m_f_stop = false;
+    m_f_taskRunning = true;
+    if(xTaskCreate(taskEntry, "AudioHlsPrefetch", 8192, this, AUDIO_HLS_PREFETCH_PRIO, &m_task) != pdPASS) { // TLS needs the stack
+        log_e("hls prefetch: can't create task");
+        m_task = NULL;
+        m_f_taskRunning = false;
+        end();
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HlsPrefetch::end() {
+    if(m_task) {
+        m_f_stop = true;
+        xTaskNotifyGive(m_task);
+        while(m_f_taskRunning) vTaskDelay(1); // a download in flight has to stop first
+        m_task = NULL;
+    }
+    if(m_client) m_client->stop();
+    m_client = NULL;
+    m_host[0] = '\0';
+    for(int i = 0; i <= HLS_PREFETCH_MAX_DEPTH; i++) {
+        if(m_slots[i].url) { free(m_slots[i].url); m_slots[i].url = NULL; }
+        m_slots[i].state = SEG_FREE;
+    }
+    m_count = 0;
+    if(m_location) { free(m_location); m_location = NULL; }
+    if(m_playlistUrl) { free(m_playlistUrl); m_playlistUrl = NULL; }
+    if(m_playlistBuf) { free(m_playlistBuf); m_playlistBuf = NULL; }
+    if(m_buffer) { free(m_buffer); m_buffer = NULL; }
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::hasRoom() {
+    return m_task && m_count < m_depth + 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::push(const char* url, uint32_t durationMs) {
+    if(!hasRoom()) return false;
+    slot_t* s = &m_slots[(m_head + m_count) % (m_depth + 1)];
+    s->url = strdup(url);
+    if(!s->url) return false;
+    s->durationMs = durationMs;
+    s->bytes = 0;
+    s->readBytes = 0;
+    s->ttfbMs = 0;
+    s->loadMs = 0;
+    s->state.store(SEG_QUEUED, std::memory_order_release);
+    m_count++;
+    xTaskNotifyGive(m_task);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t HlsPrefetch::available() {
+    if(!m_count) return 0;
+    slot_t* s = &m_slots[m_head];
+    return s->bytes.load(std::memory_order_acquire) - s->readBytes;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t HlsPrefetch::read(uint8_t* buf, size_t len) {
+    // the bytes of the current segment start at the read index, earlier segments have been read or skipped completely
+    len = min(len, available());
+    size_t bytes = 0;
+    size_t rd = m_readIdx.load(std::memory_order_relaxed);
+    while(len) {
+        size_t n = min(len, m_size - rd);
+        memcpy(buf, m_buffer + rd, n);
+        buf += n;
+        len -= n;
+        bytes += n;
+        rd += n;
+        if(rd == m_size) rd = 0;
+    }
+    m_readIdx.store(rd, std::memory_order_release);
+    if(bytes) {
+        m_slots[m_head].readBytes += bytes;
+        xTaskNotifyGive(m_task); // there is space again
+    }
+    return bytes;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HlsPrefetch::skipRead(size_t n) {
+    size_t rd = m_readIdx.load(std::memory_order_relaxed) + n;
+    if(rd >= m_size) rd -= m_size;
+    m_readIdx.store(rd, std::memory_order_release);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::segmentEnd() {
+    if(!m_count) return true;
+    uint8_t st = m_slots[m_head].state.load(std::memory_order_acquire);
+    return (st == SEG_DONE || st == SEG_FAILED) && !available();
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::nextSegment(hlsSegmentStat_t* st) {
+    if(!m_count) return false;
+    slot_t* s = &m_slots[m_head];
+    uint8_t state = s->state.load(std::memory_order_acquire);
+    if(state != SEG_DONE && state != SEG_FAILED) return false;
+    skipRead(available()); // the unread rest of a failed segment
+    st->bytes = s->bytes;
+    st->ttfbMs = s->ttfbMs;
+    st->loadMs = s->loadMs;
+    st->durationMs = s->durationMs;
+    st->failed = (state == SEG_FAILED);
+    free(s->url);
+    s->url = NULL;
+    s->state.store(SEG_FREE, std::memory_order_release);
+    m_head = (m_head + 1) % (m_depth + 1);
+    m_count--;
+    xTaskNotifyGive(m_task);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::fetchPlaylist(const char* url) {
+    if(!m_task || m_playlistState.load(std::memory_order_acquire) != PL_IDLE) return false;
+    if(m_playlistUrl) free(m_playlistUrl);
+    m_playlistUrl = strdup(url);
+    if(!m_playlistUrl) return false;
+    m_playlistState.store(PL_REQUESTED, std::memory_order_release);
+    xTaskNotifyGive(m_task);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+char* HlsPrefetch::playlist(size_t* len) {
+    if(m_playlistState.load(std::memory_order_acquire) != PL_READY) return NULL;
+    *len = m_playlistLen; // 0 if the refresh has failed
+    m_playlistState.store(PL_IDLE, std::memory_order_release);
+    return m_playlistBuf;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HlsPrefetch::taskEntry(void* param) {
+    ((HlsPrefetch*)param)->taskLoop();
+    vTaskDelete(NULL);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HlsPrefetch::taskLoop() {
+    while(!m_f_stop) {
+        if(m_playlistState.load(std::memory_order_acquire) == PL_REQUESTED) {
+            loadPlaylist();
+            continue;
+        }
+        slot_t* s = &m_slots[m_load];
+        if(s->state.load(std::memory_order_acquire) == SEG_QUEUED) {
+            loadSegment(s);
+            m_load = (m_load + 1) % (m_depth + 1);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+    m_f_taskRunning = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HlsPrefetch::loadSegment(slot_t* s) {
+    uint32_t t0 = millis();
+    s->state = SEG_LOADING;
+    if(!request(s->url)) {
+        s->loadMs = millis() - t0;
+        s->state.store(SEG_FAILED, std::memory_order_release);
+        return;
+    }
+    s->ttfbMs = m_firstByte - t0;
+    uint32_t lastData = millis();
+    uint32_t waitMs = 0;
+    while(!m_f_stop && !bodyComplete()) {
+        size_t rd = m_readIdx.load(std::memory_order_acquire);
+        size_t space = (rd > m_writeIdx) ? rd - m_writeIdx - 1 : m_size - m_writeIdx - (rd == 0 ? 1 : 0); // one byte stays free
+        if(!space) { // the consumer is behind, that is not the server's fault
+            uint32_t t = millis();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+            waitMs += millis() - t;
+            lastData = millis();
+            continue;
+        }
+        int32_t n = body(m_buffer + m_writeIdx, space);
+        if(n < 0) break;
+        if(n == 0) {
+            if(millis() - lastData > HLS_TIMEOUT_MS) break;
+            vTaskDelay(1);
+            continue;
+        }
+        lastData = millis();
+        m_writeIdx += n;
+        if(m_writeIdx == m_size) m_writeIdx = 0;
+        s->bytes.fetch_add(n, std::memory_order_release);
+    }
+    bool ok = bodyComplete();
+    if(!ok || !m_f_keepAlive) m_client->stop(); // a rest of the body would be taken as the next response
+    s->loadMs = millis() - t0 - waitMs;
+    s->state.store(ok ? SEG_DONE : SEG_FAILED, std::memory_order_release);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HlsPrefetch::loadPlaylist() {
+    m_playlistLen = 0;
+    if(request(m_playlistUrl)) {
+        uint32_t lastData = millis();
+        while(!m_f_stop && !bodyComplete() && m_playlistLen < AUDIO_HLS_PLAYLIST_SIZE) {
+            int32_t n = body((uint8_t*)m_playlistBuf + m_playlistLen, AUDIO_HLS_PLAYLIST_SIZE - m_playlistLen);
+            if(n < 0) break;
+            if(n == 0) {
+                if(millis() - lastData > HLS_TIMEOUT_MS) break;
+                vTaskDelay(1);
+                continue;
+            }
+            lastData = millis();
+            m_playlistLen += n;
+        }
+        if(!bodyComplete()) {
+            if(m_playlistLen == AUDIO_HLS_PLAYLIST_SIZE) log_w("hls prefetch: playlist cut at %u bytes", AUDIO_HLS_PLAYLIST_SIZE);
+            else m_playlistLen = 0;
+            m_client->stop();
+        }
+        else if(!m_f_keepAlive) m_client->stop();
+    }
+    m_playlistBuf[m_playlistLen] = '\0';
+    m_playlistState.store(PL_READY, std::memory_order_release);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::request(const char* url) {
+    // GET with redirects, a kept connection that the server has closed meanwhile is opened again once; a new
+    // connection that breaks is not asked again, the server may have had the request (RFC 7230, 6.3.1)
+    char* u = strdup(url);
+    bool  ok = false;
+    for(int redirects = 0; u && redirects < 4; redirects++) {
+        int status = sendRequest(u, false);
+        if(status < 0 && m_f_reused) status = sendRequest(u, true);
+        free(u);
+        u = NULL;
+        if(status >= 200 && status < 300) { ok = true; break; }
+        m_client->stop(); // the body of an error or redirect is not read
+        if(status >= 300 && status < 400 && m_location) {
+            u = m_location;
+            m_location = NULL;
+            continue;
+        }
+        log_e("hls prefetch: %s, status %i", url, status);
+    }
+    if(u) free(u);
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int HlsPrefetch::sendRequest(const char* url, bool reconnect) {
+    // returns the status code, -1 if the connection broke before the response
+    char        host[sizeof(m_host)];
+    uint16_t    port;
+    bool        ssl;
+    const char* path;
+    if(!splitUrl(url, host, sizeof(host), &port, &ssl, &path)) { log_e("hls prefetch: invalid url %s", url); return 0; }
+
+    WiFiClient* client = ssl ? static_cast<WiFiClient*>(&m_secure) : &m_plain;
+    m_f_reused = true;
+    if(reconnect || client != m_client || port != m_port || strcmp(host, m_host) || !client->connected()) {
+        if(m_client) m_client->stop();
+        m_f_reused = false;
+        m_client = client;
+        strcpy(m_host, host);
+        m_port = port;
+        if(!m_client->connect(m_host, m_port, ssl ? 5000 : 2000)) {
+            log_e("hls prefetch: can't connect to %s:%u", m_host, m_port);
+            m_host[0] = '\0';
+            return 0;
+        }
+    }
+
+    char* rqh = (char*)malloc(strlen(path) * 3 + strlen(host) + 120);
+    if(!rqh) return 0;
+    strcpy(rqh, "GET ");
+    char* p = rqh + 4;
+    for(const char* c = path; *c; c++) { // spaces only, as Audio::httpPrint()
+        if(*c == ' ') { memcpy(p, "%20", 3); p += 3; }
+        else *p++ = *c;
+    }
+    sprintf(p, " HTTP/1.1\r\nHost: %s\r\nAccept-Encoding: identity;q=1,*;q=0\r\nConnection: keep-alive\r\n\r\n", host);
+    size_t len = strlen(rqh);
+    size_t written = m_client->write((const uint8_t*)rqh, len);
+    free(rqh);
+    if(written != len) return -1;
+
+    int      status = -1;
+    uint32_t t0 = millis();
+    m_parser.reset();
+    m_bodyLeft = UINT32_MAX;
+    m_f_chunked = false;
+    m_f_keepAlive = true;
+    m_f_closed = false;
+    if(m_location) { free(m_location); m_location = NULL; }
+    while(true) { // the header in blocks, the bytes behind it stay in the parser for body()
+        if(m_f_stop) return 0;
+        if(!m_parser.nextLine()) {
+            int avail = m_client->available();
+            if(avail <= 0) {
+                if(!m_client->connected()) return (status < 0) ? -1 : 0;
+                if(millis() - t0 > HLS_TIMEOUT_MS) { log_e("hls prefetch: response timeout"); return 0; }
+                vTaskDelay(1);
+                continue;
+            }
+            size_t   space;
+            uint8_t* rx = m_parser.rxSpace(&space);
+            int      r = m_client->read(rx, min(space, (size_t)avail));
+            if(r <= 0) continue;
+            m_parser.rxWritten(r);
+            if(status < 0) { status = 0; m_firstByte = millis(); }
+            continue;
+        }
+        char* line = m_parser.line();
+        if(!line[0]) break; // end of the header
+        if(!strncmp(line, "HTTP/", 5)) {
+            const char* sp = strchr(line, ' ');
+            status = sp ? atoi(sp + 1) : 0;
+            if(!strncmp(line, "HTTP/1.0", 8)) m_f_keepAlive = false;
+        }
+        else if(!strncasecmp(line, "content-length:", 15)) { m_bodyLeft = strtoul(line + 15, NULL, 10); }
+        else if(!strncasecmp(line, "transfer-encoding:", 18)) { m_f_chunked = strcasestr(line, "chunked") != NULL; }
+        else if(!strncasecmp(line, "connection:", 11)) { if(strcasestr(line, "close")) m_f_keepAlive = false; }
+        else if(!strncasecmp(line, "location:", 9)) {
+            const char* loc = line + 9;
+            while(*loc == ' ') loc++;
+            if(*loc == '/') { // relative to this host
+                m_location = (char*)malloc(strlen(loc) + strlen(host) + 16);
+                if(m_location) sprintf(m_location, "%s://%s:%u%s", ssl ? "https" : "http", host, port, loc);
+            }
+            else m_location = strdup(loc);
+        }
+    }
+    if(m_f_chunked) m_bodyLeft = UINT32_MAX;
+    m_parser.setBody(m_f_chunked, 0);
+    return status;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HlsPrefetch::bodyComplete() {
+    if(m_f_chunked) return m_parser.endOfBody();
+    if(m_bodyLeft != UINT32_MAX) return m_bodyLeft == 0;
+    return m_f_closed; // neither length nor chunks: the body ends with the connection
+}
+//----------------------------------------------------------------------------------------------------------------------
+int32_t HlsPrefetch::body(uint8_t* dst, size_t len) {
+    // raw bytes, first those read with the header, then from the socket; chunk framing is removed in place,
+    // -1: the connection is gone
+    size_t n = m_f_chunked ? len : min(len, (size_t)m_bodyLeft);
+    int    r;
+    if(m_parser.rxAvailable()) r = m_parser.rxRead(dst, n);
+    else {
+        int avail = m_client->available();
+        if(avail <= 0) {
+            if(m_client->connected()) return 0;
+            m_f_closed = true;
+            m_f_keepAlive = false;
+            return -1;
+        }
+        r = m_client->read(dst, min(n, (size_t)avail));
+    }
+    if(r <= 0) return 0;
+    if(!m_f_chunked) {
+        if(m_bodyLeft != UINT32_MAX) m_bodyLeft -= r;
+        return r;
+    }
+    size_t pos = 0, produced = 0;
+    while(pos < (size_t)r) {
+        size_t used = 0;
+        produced += m_parser.unframe(dst + pos, r - pos, dst + produced, &used);
+        pos += used;
+        if(!used) break;
+    }
+    return produced;
+}
@@ -0,0 +1,113 @@
+/*
+ * hls_prefetch.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Downloads HLS media segments in its own task while the current one is decoded, so the connection setup and the time
+ * to first byte of segment N+1 are hidden behind the playback of segment N. Audio pushes the segment URLs in playlist
+ * order, the task fetches them one after the other over a kept connection into a ring in PSRAM, chunked transfer
+ * encoding is removed on the way. The playlist refresh goes through the same task, the stream never waits for it.
+ * Every finished segment reports its time to first byte and its download time, to be held against its duration.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <atomic>
+#include "http_parser.h"
+#include "tls_client.h"
+
+#ifndef AUDIO_HLS_PREFETCH
+  #define AUDIO_HLS_PREFETCH        2            // segments downloaded ahead of the current one, 0: Audio loads them as before
+#endif
+#ifndef AUDIO_HLS_PREFETCH_BUFFER
+  #define AUDIO_HLS_PREFETCH_BUFFER (640 * 1024) // PSRAM ring for the current and the prefetched segments
+#endif
+#ifndef AUDIO_HLS_PLAYLIST_SIZE
+  #define AUDIO_HLS_PLAYLIST_SIZE   (32 * 1024)  // a longer playlist refresh is cut
+#endif
+#ifndef AUDIO_HLS_PREFETCH_PRIO
+  #define AUDIO_HLS_PREFETCH_PRIO   1            // as the loop task, a TLS handshake must not starve the decoder
+#endif
+#define HLS_PREFETCH_MAX_DEPTH      8
+#define HLS_TIMEOUT_MS              5000         // no header or body byte for that long: the download has failed
+
+typedef struct {
+    uint32_t bytes;      // payload, without chunk framing
+    uint32_t ttfbMs;     // request (connect included) to the first byte of the response
+    uint32_t loadMs;     // request to the last byte, without the waits for space in the ring
+    uint32_t durationMs; // from #EXTINF
+    bool     failed;
+} hlsSegmentStat_t;
+
+class HlsPrefetch {
+
+public:
+    HlsPrefetch();
+    ~HlsPrefetch();
+    bool     begin(uint8_t depth);                       // allocates the ring, starts the task, needs PSRAM
+    void     end();                                      // stops the task, queued segments are dropped
+    bool     isActive() { return m_task != NULL; }
+    bool     hasRoom();                                  // fewer than depth segments wait behind the current one
+    bool     push(const char* url, uint32_t durationMs); // the next segment in playlist order
+    size_t   available();                                // downloaded, unread bytes of the current segment
+    size_t   read(uint8_t* buf, size_t len);             // current segment only, does not wait
+    bool     segmentEnd();                               // the current segment is downloaded and read completely
+    bool     nextSegment(hlsSegmentStat_t* st);          // drops the current segment, false if there is none
+    bool     fetchPlaylist(const char* url);             // refresh in the background, false if one is pending
+    char*    playlist(size_t* len);                      // the refreshed playlist once, NULL while pending
+
+private:
+    enum : uint8_t { SEG_FREE, SEG_QUEUED, SEG_LOADING, SEG_DONE, SEG_FAILED };
+    enum : uint8_t { PL_IDLE, PL_REQUESTED, PL_READY };
+    typedef struct {
+        char*                 url;
+        uint32_t              durationMs;
+        std::atomic<uint8_t>  state;
+        std::atomic<uint32_t> bytes;     // written by the task
+        uint32_t              readBytes; // consumer
+        uint32_t              ttfbMs;
+        uint32_t              loadMs;
+    } slot_t;
+
+    static void taskEntry(void* param);
+    void        taskLoop();
+    void        loadSegment(slot_t* s);
+    void        loadPlaylist();
+    bool        request(const char* url);
+    int         sendRequest(const char* url, bool reconnect);
+    int32_t     body(uint8_t* dst, size_t len);
+    bool        bodyComplete();
+    void        skipRead(size_t n);
+
+    WiFiClient         m_plain;
+    TlsClient          m_secure;               // shares the TLS session cache with Audio
+    WiFiClient*        m_client = NULL;
+    HttpParser         m_parser;
+    TaskHandle_t       m_task = NULL;
+    slot_t             m_slots[HLS_PREFETCH_MAX_DEPTH + 1];
+    uint8_t            m_depth = 0;
+    uint8_t            m_head = 0;              // current segment, consumer
+    uint8_t            m_count = 0;             // current and queued segments, consumer
+    uint8_t            m_load = 0;              // next slot the task looks at
+    uint8_t*           m_buffer = NULL;
+    size_t             m_size = 0;
+    size_t             m_writeIdx = 0;          // task only
+    std::atomic<size_t> m_readIdx{0};           // written by the consumer only
+    char               m_host[128] = {0};       // of the kept connection
+    uint16_t           m_port = 0;
+    char*              m_location = NULL;       // redirect target of the last response
+    uint32_t           m_bodyLeft = 0;          // raw body bytes, UINT32_MAX: up to the end of the connection
+    uint32_t           m_firstByte = 0;         // millis() of the first response byte
+    bool               m_f_chunked = false;
+    bool               m_f_keepAlive = false;
+    bool               m_f_closed = false;
+    bool               m_f_reused = false;      // the last request went over a kept connection
+    char*              m_playlistUrl = NULL;
+    char*              m_playlistBuf = NULL;
+    size_t             m_playlistLen = 0;
+    std::atomic<uint8_t> m_playlistState{PL_IDLE};
+    volatile bool      m_f_stop = false;
+    volatile bool      m_f_taskRunning = false;
+};
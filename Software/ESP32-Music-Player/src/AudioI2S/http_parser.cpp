@@ -0,0 +1,198 @@
+/*
+ * http_parser.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "http_parser.h"
+#include "codec_mem.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+HttpParser::~HttpParser() {
+    if(m_meta) { free(m_meta); m_meta = NULL; }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HttpParser::reset() {
+    m_line[0] = '\0';
+    m_linePos = 0;
+    m_lineCount = 0;
+    m_rxPos = 0;
+    m_rxLen = 0;
+    setBody(false, 0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HttpParser::headerLine(const uint8_t* data, size_t len, size_t* used) {
+    for(size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        if(m_lineCount < UINT16_MAX) m_lineCount++;
+        if(b == '\n') {
+            m_line[m_linePos] = '\0';
+            m_linePos = 0;
+            m_lineBytes = m_lineCount;
+            m_lineCount = 0;
+            *used = i + 1;
+            return true;
+        }
+        if(b < 0x20) continue;                             // CR and other control characters
+        if(m_linePos < HTTP_LINE_SIZE - 1) m_line[m_linePos++] = b; // the rest of a long line is dropped
+    }
+    *used = len;
+    return false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t* HttpParser::rxSpace(size_t* len) {
+    if(m_rxPos == m_rxLen) { m_rxPos = 0; m_rxLen = 0; }
+    *len = HTTP_RX_SIZE - m_rxLen;
+    return m_rx + m_rxLen;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HttpParser::nextLine() {
+    size_t used = 0;
+    bool   f_line = headerLine(m_rx + m_rxPos, m_rxLen - m_rxPos, &used);
+    m_rxPos += used;
+    return f_line;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t HttpParser::rxRead(uint8_t* buf, size_t len) {
+    size_t n = min(len, rxAvailable());
+    memcpy(buf, m_rx + m_rxPos, n);
+    m_rxPos += n;
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HttpParser::chunkSize(const char* line, uint32_t* size) {
+    // "1f40", "1F40 ; name=value", false for no digits, more than 32 bit or anything else in front of the extensions
+    uint32_t n = 0;
+    uint8_t  digits = 0;
+    for(; isxdigit((uint8_t)*line); line++) {
+        if(++digits > HTTP_CHUNK_DIGITS) return false;
+        n = (n << 4) + (isdigit((uint8_t)*line) ? *line - '0' : toupper(*line) - 'A' + 10);
+    }
+    while(*line == ' ' || *line == '\t') line++;
+    if(!digits || (*line && *line != ';')) return false;
+    *size = n;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool HttpParser::setBody(bool chunked, uint32_t metaint) {
+    m_f_chunked = chunked;
+    m_chunkState = chunked ? CHUNK_SIZE : CHUNK_DATA;
+    m_chunkLeft = 0;
+    m_digits = 0;
+    m_trailerLen = 0;
+    m_metaint = metaint;
+    m_icyLeft = metaint;
+    m_icyState = ICY_AUDIO;
+    m_metaPos = 0;
+    m_metaLeft = 0;
+    m_f_metaReady = false;
+    m_f_error = false;
+    if(metaint && !m_meta) m_meta = (char*)CodecMem_Alloc(HTTP_META_SIZE, CODEC_MEM_COLD, "icy metadata");
+    if(metaint && !m_meta) { m_metaint = 0; return false; }
+    if(m_meta) m_meta[0] = '\0';
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void HttpParser::chunkByte(uint8_t b) {
+    // chunk-size [; extensions] CRLF, data CRLF, ..., 0 CRLF, trailer lines, CRLF
+    switch(m_chunkState) {
+        case CHUNK_SIZE:
+            if(isxdigit(b)) {
+                if(++m_digits > HTTP_CHUNK_DIGITS) { m_f_error = true; break; } // more than 32 bit, the size is cut
+                m_chunkLeft = (m_chunkLeft << 4) + (isdigit(b) ? b - '0' : (toupper(b) - 'A' + 10));
+            }
+            else if(b == ';' || b == ' ' || b == '\t') { m_chunkState = CHUNK_EXT; }
+            else if(b == '\n') {
+                if(!m_digits) break; // empty line, tolerated
+                m_chunkState = m_chunkLeft ? CHUNK_DATA : CHUNK_TRAILER;
+            }
+            else if(b != '\r') { m_f_error = true; }
+            break;
+        case CHUNK_EXT:
+            if(b == '\n') m_chunkState = m_chunkLeft ? CHUNK_DATA : CHUNK_TRAILER;
+            break;
+        case CHUNK_DATA_END: // CRLF behind the data
+            if(b == '\n') {
+                m_chunkState = CHUNK_SIZE;
+                m_chunkLeft = 0;
+                m_digits = 0;
+            }
+            break;
+        case CHUNK_TRAILER:
+            if(b == '\n') {
+                if(!m_trailerLen) m_chunkState = CHUNK_END;
+                m_trailerLen = 0;
+            }
+            else if(b != '\r') { m_trailerLen++; }
+            break;
+        default: break; // CHUNK_END: anything behind the body is ignored
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t HttpParser::unframe(const uint8_t* in, size_t len, uint8_t* out, size_t* used) {
+    size_t i = 0, o = 0;
+    while(i < len && !m_f_metaReady) {
+        if(m_chunkState != CHUNK_DATA) { // framing, a few bytes only
+            chunkByte(in[i++]);
+            continue;
+        }
+        size_t run = len - i;
+        if(m_f_chunked) run = min(run, (size_t)m_chunkLeft);
+        size_t n = run;
+        if(!m_metaint) { // audio only
+            memmove(out + o, in + i, n);
+            o += n;
+        }
+        else if(m_icyState == ICY_AUDIO) {
+            n = min(run, (size_t)m_icyLeft);
+            memmove(out + o, in + i, n);
+            o += n;
+            m_icyLeft -= n;
+            if(!m_icyLeft) m_icyState = ICY_LEN;
+        }
+        else if(m_icyState == ICY_LEN) {
+            n = 1;
+            m_metaLeft = in[i] * 16;
+            m_metaPos = 0;
+            if(m_metaLeft) m_icyState = ICY_META;
+            else { m_icyState = ICY_AUDIO; m_icyLeft = m_metaint; }
+        }
+        else { // ICY_META
+            n = min(run, (size_t)m_metaLeft);
+            memcpy(m_meta + m_metaPos, in + i, n);
+            m_metaPos += n;
+            m_metaLeft -= n;
+            if(!m_metaLeft) {
+                m_meta[m_metaPos] = '\0';
+                m_f_metaReady = true;
+                m_icyState = ICY_AUDIO;
+                m_icyLeft = m_metaint;
+            }
+        }
+        i += n;
+        if(m_f_chunked) {
+            m_chunkLeft -= n;
+            if(!m_chunkLeft) m_chunkState = CHUNK_DATA_END;
+        }
+    }
+    *used = i;
+    return o;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool splitUrl(const char* url, char* host, size_t hostSize, uint16_t* port, bool* ssl, const char** path) {
+    // "https://host:port/path?query" -> host, port, ssl, path
+    if(!strncmp(url, "https://", 8)) { *ssl = true; url += 8; *port = 443; }
+    else if(!strncmp(url, "http://", 7)) { *ssl = false; url += 7; *port = 80; }
+    else return false;
+    size_t len = strcspn(url, ":/?");
+    if(!len || len >= hostSize) return false;
+    memcpy(host, url, len);
+    host[len] = '\0';
+    url += len;
+    if(*url == ':') {
+        *port = atoi(url + 1);
+        url += strcspn(url, "/?");
+    }
+    *path = *url ? url : "/";
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * http_parser.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Incremental parser for a HTTP response: header lines, chunked transfer encoding and ICY metadata.
+ * It takes whatever bytes are there, keeps its state between the calls and never waits for more data.
+ * Header and chunk size lines are read from the socket in blocks (rxSpace(), rxWritten(), nextLine()), the bytes behind
+ * the line are kept and are the first ones of the body (rxRead()).
+ * unframe() strips the chunk and metadata framing from a contiguous block in bulk (in place if out == in), the
+ * metaint counts the de-chunked bytes, so a metadata block may span chunks.
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#define HTTP_LINE_SIZE   512             // longer header lines are cut
+#define HTTP_META_SIZE   (255 * 16 + 1)  // the longest ICY metadata block and its terminator
+#define HTTP_RX_SIZE     512             // block read for header lines
+#define HTTP_CHUNK_DIGITS 8              // hex digits of a chunk size, 32 bit
+
+class HttpParser {
+
+public:
+    HttpParser() {}
+    ~HttpParser();
+    void   reset();                                                  // a new response follows
+    bool   headerLine(const uint8_t* data, size_t len, size_t* used); // true: a line is complete, see line()
+    char*  line() { return m_line; }                                 // without CR LF and control characters, empty: end of header
+    size_t lineBytes() { return m_lineBytes; }                       // of the last complete line, CR LF included
+    uint8_t* rxSpace(size_t* len);                                   // where the next block read goes, nextLine() took all before
+    void   rxWritten(size_t n) { m_rxLen += n; }
+    bool   nextLine();                                               // headerLine() on the block read
+    size_t rxAvailable() { return m_rxLen - m_rxPos; }               // bytes read behind the last line
+    size_t rxRead(uint8_t* buf, size_t len);
+    static bool chunkSize(const char* line, uint32_t* size);         // hex, extensions behind ';' are ignored
+    bool   setBody(bool chunked, uint32_t metaint);                  // framing of the body, from the header lines
+    size_t unframe(const uint8_t* in, size_t len, uint8_t* out, size_t* used); // returns the audio bytes written to out
+    bool   metadataReady() { return m_f_metaReady; }                 // unframe() stops behind a complete metadata block
+    char*  metadata() { m_f_metaReady = false; return m_meta; }
+    bool   endOfBody() { return m_chunkState == CHUNK_END; }         // last chunk and trailer received
+    bool   error() { return m_f_error; }                             // unexpected character or too many digits in a chunk size line
+
+private:
+    enum : uint8_t { CHUNK_SIZE, CHUNK_EXT, CHUNK_DATA, CHUNK_DATA_END, CHUNK_TRAILER, CHUNK_END };
+    enum : uint8_t { ICY_AUDIO, ICY_LEN, ICY_META };
+    void   chunkByte(uint8_t b);
+
+    char     m_line[HTTP_LINE_SIZE];
+    uint16_t m_linePos = 0;
+    uint16_t m_lineCount = 0;            // bytes of the line so far
+    uint16_t m_lineBytes = 0;
+    uint8_t  m_rx[HTTP_RX_SIZE];
+    uint16_t m_rxPos = 0;
+    uint16_t m_rxLen = 0;
+    char*    m_meta = NULL;              // allocated by setBody() if there is a metaint
+    uint16_t m_metaPos = 0;
+    uint16_t m_metaLeft = 0;             // bytes of the current metadata block still to come
+    uint32_t m_metaint = 0;
+    uint32_t m_icyLeft = 0;              // audio bytes up to the next metadata length byte
+    uint32_t m_chunkLeft = 0;            // data bytes left in the current chunk
+    uint16_t m_trailerLen = 0;           // length of the current trailer line
+    uint8_t  m_chunkState = CHUNK_SIZE;
+    uint8_t  m_icyState = ICY_AUDIO;
+    bool     m_f_chunked = false;
+    uint8_t  m_digits = 0;               // hex digits of the chunk size line
+    bool     m_f_metaReady = false;
+    bool     m_f_error = false;
+};
+
+bool splitUrl(const char* url, char* host, size_t hostSize, uint16_t* port, bool* ssl, const char** path); // "https://host:port/path?query"
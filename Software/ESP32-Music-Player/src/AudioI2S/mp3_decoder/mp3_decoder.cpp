@@ -5,7 +5,11 @@
  *  Created on: 26.10.2018
  *  Updated on: 27.05.2024
  */
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_MP3
+
 #include "mp3_decoder.h"
+#include <new>
 /* clip to range [-2^n, 2^n - 1] */
 #if 0 //Fast on ARM:
 #define CLIP_2N(y, n) { \
@@ -37,21 +41,21 @@ const uint8_t  m_NGRANS_MPEG2           =1;
 const uint32_t m_SQRTHALF               =0x5a82799a;  // sqrt(0.5) in Q31 format
 
 
-MP3FrameInfo_t *m_MP3FrameInfo;
-SFBandTable_t m_SFBandTable;
-StereoMode_t m_sMode;  /* mono/stereo mode */
-MPEGVersion_t m_MPEGVersion;  /* version ID */
-FrameHeader_t *m_FrameHeader;
-SideInfoSub_t m_SideInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
-SideInfo_t *m_SideInfo;
-CriticalBandInfo_t m_CriticalBandInfo[m_MAX_NCHAN];  /* filled in dequantizer, used in joint stereo reconstruction */
-DequantInfo_t *m_DequantInfo;
-HuffmanInfo_t *m_HuffmanInfo;
-IMDCTInfo_t *m_IMDCTInfo;
-ScaleFactorInfoSub_t m_ScaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
-ScaleFactorJS_t *m_ScaleFactorJS;
-SubbandInfo_t *m_SubbandInfo;
-MP3DecInfo_t *m_MP3DecInfo;
+MP3Decoder_t s_mp3Default; // the context of the codec registry
+
+MP3Decoder_t* MP3Decoder_Create(){ // a further, independent decoder, e.g. to probe or preroll a second stream
+    MP3Decoder_t* dec = new (std::nothrow) MP3Decoder_t;
+    if(!dec) log_e("not enough memory to allocate a mp3decoder context");
+    return dec;
+}
+void MP3Decoder_Destroy(MP3Decoder_t* dec){
+    if(!dec || dec == &s_mp3Default) return;
+    MP3Decoder_FreeBuffers(dec);
+    delete dec;
+}
+MP3Decoder_t* MP3Decoder_Default(){
+    return &s_mp3Default;
+}
 
 const uint16_t huffTable[4242] PROGMEM = {
     /* huffTable01[9] */
@@ -462,7 +466,7 @@ const int32_t pow43[48] PROGMEM = {
     0x70416360, 0x72d7e8b0, 0x75722ef9, 0x78102b85, 0x7ab1d3ec, 0x7d571e09,
 };
 
-const uint32_t polyCoef[264] PROGMEM = {
+const uint32_t polyCoef[264] CODEC_HOT_TABLE = {
     /* shuffled vs. original from 0, 1, ... 15 to 0, 15, 2, 13, ... 14, 1 */
     0x00000000, 0x00000074, 0x00000354, 0x0000072c, 0x00001fd4, 0x00005084, 0x000066b8, 0x000249c4,
     0x00049478, 0xfffdb63c, 0x000066b8, 0xffffaf7c, 0x00001fd4, 0xfffff8d4, 0x00000354, 0xffffff8c,
@@ -748,92 +752,92 @@ int32_t CalcBitsUsed(BitStreamInfo_t *bsi, uint8_t *startBuf, int32_t startOffse
     return bitsUsed;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t CheckPadBit(){
-    return (m_FrameHeader->paddingBit ? 1 : 0);
+int32_t CheckPadBit(MP3Decoder_t* dec){
+    return (dec->frameHeader->paddingBit ? 1 : 0);
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t UnpackFrameHeader(uint8_t *buf){
+int32_t UnpackFrameHeader(MP3Decoder_t* dec, uint8_t *buf){
    int32_t verIdx;
     /* validate pointers and sync word */
     if ((buf[0] & m_SYNCWORDH) != m_SYNCWORDH || (buf[1] & m_SYNCWORDL) != m_SYNCWORDL){return -1;}
     /* read header fields - use bitmasks instead of GetBits() for speed, since format never varies */
     verIdx = (buf[1] >> 3) & 0x03;
-    m_MPEGVersion = (MPEGVersion_t) (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
-    m_FrameHeader->layer = 4 - ((buf[1] >> 1) & 0x03); /* easy mapping of index to layer number, 4 = error */
-    m_FrameHeader->crc = 1 - ((buf[1] >> 0) & 0x01);
-    m_FrameHeader->brIdx = (buf[2] >> 4) & 0x0f;
-    m_FrameHeader->srIdx = (buf[2] >> 2) & 0x03;
-    m_FrameHeader->paddingBit = (buf[2] >> 1) & 0x01;
-    m_FrameHeader->privateBit = (buf[2] >> 0) & 0x01;
-    m_sMode = (StereoMode_t) ((buf[3] >> 6) & 0x03); /* maps to correct enum (see definition) */
-    m_FrameHeader->modeExt = (buf[3] >> 4) & 0x03;
-    m_FrameHeader->copyFlag = (buf[3] >> 3) & 0x01;
-    m_FrameHeader->origFlag = (buf[3] >> 2) & 0x01;
-    m_FrameHeader->emphasis = (buf[3] >> 0) & 0x03;
+    dec->mpegVersion = (MPEGVersion_t) (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
+    dec->frameHeader->layer = 4 - ((buf[1] >> 1) & 0x03); /* easy mapping of index to layer number, 4 = error */
+    dec->frameHeader->crc = 1 - ((buf[1] >> 0) & 0x01);
+    dec->frameHeader->brIdx = (buf[2] >> 4) & 0x0f;
+    dec->frameHeader->srIdx = (buf[2] >> 2) & 0x03;
+    dec->frameHeader->paddingBit = (buf[2] >> 1) & 0x01;
+    dec->frameHeader->privateBit = (buf[2] >> 0) & 0x01;
+    dec->sMode = (StereoMode_t) ((buf[3] >> 6) & 0x03); /* maps to correct enum (see definition) */
+    dec->frameHeader->modeExt = (buf[3] >> 4) & 0x03;
+    dec->frameHeader->copyFlag = (buf[3] >> 3) & 0x01;
+    dec->frameHeader->origFlag = (buf[3] >> 2) & 0x01;
+    dec->frameHeader->emphasis = (buf[3] >> 0) & 0x03;
     /* check parameters to avoid indexing tables with bad values */
-    if (m_FrameHeader->srIdx == 3 || m_FrameHeader->layer == 4 || m_FrameHeader->brIdx == 15) {return -1;}
+    if (dec->frameHeader->srIdx == 3 || dec->frameHeader->layer == 4 || dec->frameHeader->brIdx == 15) {return -1;}
     /* for readability (we reference sfBandTable many times in decoder) */
-    m_SFBandTable = sfBandTable[m_MPEGVersion][m_FrameHeader->srIdx];
-    if (m_sMode != Joint) /* just to be safe (dequant, stproc check fh->modeExt) */
-        m_FrameHeader->modeExt = 0;
+    dec->sfBand = sfBandTable[dec->mpegVersion][dec->frameHeader->srIdx];
+    if (dec->sMode != Joint) /* just to be safe (dequant, stproc check fh->modeExt) */
+        dec->frameHeader->modeExt = 0;
     /* init user-accessible data */
-    m_MP3DecInfo->nChans = (m_sMode == Mono ? 1 : 2);
-    m_MP3DecInfo->samprate = samplerateTab[m_MPEGVersion][m_FrameHeader->srIdx];
-    m_MP3DecInfo->nGrans = (m_MPEGVersion == MPEG1 ? m_NGRANS_MPEG1 : m_NGRANS_MPEG2);
-    m_MP3DecInfo->nGranSamps = ((int32_t) samplesPerFrameTab[m_MPEGVersion][m_FrameHeader->layer - 1])/m_MP3DecInfo->nGrans;
-    m_MP3DecInfo->layer = m_FrameHeader->layer;
+    dec->mp3DecInfo->nChans = (dec->sMode == Mono ? 1 : 2);
+    dec->mp3DecInfo->samprate = samplerateTab[dec->mpegVersion][dec->frameHeader->srIdx];
+    dec->mp3DecInfo->nGrans = (dec->mpegVersion == MPEG1 ? m_NGRANS_MPEG1 : m_NGRANS_MPEG2);
+    dec->mp3DecInfo->nGranSamps = ((int32_t) samplesPerFrameTab[dec->mpegVersion][dec->frameHeader->layer - 1])/dec->mp3DecInfo->nGrans;
+    dec->mp3DecInfo->layer = dec->frameHeader->layer;
 
     /* get bitrate and nSlots from table, unless brIdx == 0 (free mode) in which case caller must figure it out himself
      * question - do we want to overwrite mp3DecInfo->bitrate with 0 each time if it's free mode, and
      *  copy the pre-calculated actual free bitrate into it in mp3dec.c (according to the spec,
      *  this shouldn't be necessary, since it should be either all frames free or none free)
      */
-    if (m_FrameHeader->brIdx) {
-        m_MP3DecInfo->bitrate=((int32_t) bitrateTab[m_MPEGVersion][m_FrameHeader->layer - 1][m_FrameHeader->brIdx]) * 1000;
+    if (dec->frameHeader->brIdx) {
+        dec->mp3DecInfo->bitrate=((int32_t) bitrateTab[dec->mpegVersion][dec->frameHeader->layer - 1][dec->frameHeader->brIdx]) * 1000;
         /* nSlots = total frame bytes (from table) - sideInfo bytes - header - CRC (if present) + pad (if present) */
-        m_MP3DecInfo->nSlots= (int32_t) slotTab[m_MPEGVersion][m_FrameHeader->srIdx][m_FrameHeader->brIdx]
-                - (int32_t) sideBytesTab[m_MPEGVersion][(m_sMode == Mono ? 0 : 1)] - 4
-                - (m_FrameHeader->crc ? 2 : 0) + (m_FrameHeader->paddingBit ? 1 : 0);
+        dec->mp3DecInfo->nSlots= (int32_t) slotTab[dec->mpegVersion][dec->frameHeader->srIdx][dec->frameHeader->brIdx]
+                - (int32_t) sideBytesTab[dec->mpegVersion][(dec->sMode == Mono ? 0 : 1)] - 4
+                - (dec->frameHeader->crc ? 2 : 0) + (dec->frameHeader->paddingBit ? 1 : 0);
     }
     /* load crc word, if enabled, and return length of frame header (in bytes) */
-    if (m_FrameHeader->crc) {
-        m_FrameHeader->CRCWord = ((int32_t) buf[4] << 8 | (int32_t) buf[5] << 0);
+    if (dec->frameHeader->crc) {
+        dec->frameHeader->CRCWord = ((int32_t) buf[4] << 8 | (int32_t) buf[5] << 0);
         return 6;
     } else {
-        m_FrameHeader->CRCWord = 0;
+        dec->frameHeader->CRCWord = 0;
         return 4;
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t UnpackSideInfo( uint8_t *buf) {
+int32_t UnpackSideInfo(MP3Decoder_t* dec,  uint8_t *buf) {
    int32_t gr, ch, bd, nBytes;
     BitStreamInfo_t bitStreamInfo, *bsi;
 
     SideInfoSub_t *sis;
     /* validate pointers and sync word */
     bsi = &bitStreamInfo;
-    if (m_MPEGVersion == MPEG1) {
+    if (dec->mpegVersion == MPEG1) {
         /* MPEG 1 */
-        nBytes=(m_sMode == Mono ? m_SIBYTES_MPEG1_MONO : m_SIBYTES_MPEG1_STEREO);
+        nBytes=(dec->sMode == Mono ? m_SIBYTES_MPEG1_MONO : m_SIBYTES_MPEG1_STEREO);
         SetBitstreamPointer(bsi, nBytes, buf);
-        m_SideInfo->mainDataBegin = GetBits(bsi, 9);
-        m_SideInfo->privateBits= GetBits(bsi, (m_sMode == Mono ? 5 : 3));
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++)
-            for (bd = 0; bd < m_MAX_SCFBD; bd++) m_SideInfo->scfsi[ch][bd] = GetBits(bsi, 1);
+        dec->sideInfo->mainDataBegin = GetBits(bsi, 9);
+        dec->sideInfo->privateBits= GetBits(bsi, (dec->sMode == Mono ? 5 : 3));
+        for (ch = 0; ch < dec->mp3DecInfo->nChans; ch++)
+            for (bd = 0; bd < m_MAX_SCFBD; bd++) dec->sideInfo->scfsi[ch][bd] = GetBits(bsi, 1);
     } else {
         /* MPEG 2, MPEG 2.5 */
-        nBytes=(m_sMode == Mono ? m_SIBYTES_MPEG2_MONO : m_SIBYTES_MPEG2_STEREO);
+        nBytes=(dec->sMode == Mono ? m_SIBYTES_MPEG2_MONO : m_SIBYTES_MPEG2_STEREO);
         SetBitstreamPointer(bsi, nBytes, buf);
-        m_SideInfo->mainDataBegin = GetBits(bsi, 8);
-        m_SideInfo->privateBits = GetBits(bsi, (m_sMode == Mono ? 1 : 2));
+        dec->sideInfo->mainDataBegin = GetBits(bsi, 8);
+        dec->sideInfo->privateBits = GetBits(bsi, (dec->sMode == Mono ? 1 : 2));
     }
-    for (gr = 0; gr < m_MP3DecInfo->nGrans; gr++) {
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-            sis = &m_SideInfoSub[gr][ch]; /* side info subblock for this granule, channel */
+    for (gr = 0; gr < dec->mp3DecInfo->nGrans; gr++) {
+        for (ch = 0; ch < dec->mp3DecInfo->nChans; ch++) {
+            sis = &dec->sideInfoSub[gr][ch]; /* side info subblock for this granule, channel */
             sis->part23Length = GetBits(bsi, 12);
             sis->nBigvals = GetBits(bsi, 9);
             sis->globalGain = GetBits(bsi, 8);
-            sis->sfCompress = GetBits(bsi, (m_MPEGVersion == MPEG1 ? 4 : 9));
+            sis->sfCompress = GetBits(bsi, (dec->mpegVersion == MPEG1 ? 4 : 9));
             sis->winSwitchFlag = GetBits(bsi, 1);
             if (sis->winSwitchFlag) {
                 /* this is a start, stop, short, or mixed block */
@@ -868,12 +872,12 @@ int32_t UnpackSideInfo( uint8_t *buf) {
                 sis->region0Count = GetBits(bsi, 4);
                 sis->region1Count = GetBits(bsi, 3);
             }
-            sis->preFlag = (m_MPEGVersion == MPEG1 ? GetBits(bsi, 1) : 0);
+            sis->preFlag = (dec->mpegVersion == MPEG1 ? GetBits(bsi, 1) : 0);
             sis->sfactScale = GetBits(bsi, 1);
             sis->count1TableSelect = GetBits(bsi, 1);
         }
     }
-    m_MP3DecInfo->mainDataBegin = m_SideInfo->mainDataBegin; /* needed by main decode loop */
+    dec->mp3DecInfo->mainDataBegin = dec->sideInfo->mainDataBegin; /* needed by main decode loop */
     assert(nBytes == CalcBitsUsed(bsi, buf, 0) >> 3);
     return nBytes;
 }
@@ -1135,7 +1139,7 @@ void UnpackSFMPEG2(BitStreamInfo_t *bsi, SideInfoSub_t *sis,
  *
  * Return:      length (in bytes) of scale factor data, -1 if null input pointers
  **********************************************************************************************************************/
-int32_t UnpackScaleFactors( uint8_t *buf, int32_t *bitOffset, int32_t bitsAvail, int32_t gr, int32_t ch){
+int32_t UnpackScaleFactors(MP3Decoder_t* dec,  uint8_t *buf, int32_t *bitOffset, int32_t bitsAvail, int32_t gr, int32_t ch){
    int32_t bitsUsed;
     uint8_t *startBuf;
     BitStreamInfo_t bitStreamInfo, *bsi;
@@ -1147,14 +1151,14 @@ int32_t UnpackScaleFactors( uint8_t *buf, int32_t *bitOffset, int32_t bitsAvail,
     if (*bitOffset)
         GetBits(bsi, *bitOffset);
 
-    if (m_MPEGVersion == MPEG1)
-        UnpackSFMPEG1(bsi, &m_SideInfoSub[gr][ch], &m_ScaleFactorInfoSub[gr][ch],
-                      m_SideInfo->scfsi[ch], gr, &m_ScaleFactorInfoSub[0][ch]);
+    if (dec->mpegVersion == MPEG1)
+        UnpackSFMPEG1(bsi, &dec->sideInfoSub[gr][ch], &dec->scaleFactorInfoSub[gr][ch],
+                      dec->sideInfo->scfsi[ch], gr, &dec->scaleFactorInfoSub[0][ch]);
     else
-        UnpackSFMPEG2(bsi, &m_SideInfoSub[gr][ch], &m_ScaleFactorInfoSub[gr][ch],
-                      gr, ch, m_FrameHeader->modeExt, m_ScaleFactorJS);
+        UnpackSFMPEG2(bsi, &dec->sideInfoSub[gr][ch], &dec->scaleFactorInfoSub[gr][ch],
+                      gr, ch, dec->frameHeader->modeExt, dec->scaleFactorJS);
 
-    m_MP3DecInfo->part23Length[gr][ch] = m_SideInfoSub[gr][ch].part23Length;
+    dec->mp3DecInfo->part23Length[gr][ch] = dec->sideInfoSub[gr][ch].part23Length;
 
     bitsUsed = CalcBitsUsed(bsi, buf, *bitOffset);
     buf += (bitsUsed + *bitOffset) >> 3;
@@ -1178,56 +1182,51 @@ int32_t UnpackScaleFactors( uint8_t *buf, int32_t *bitOffset, int32_t bitsAvail,
  *
  * Return:      offset to first sync word (bytes from start of buf)
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       memchr() scans a word at a time for the first byte of the sync word.
+ *              A candidate needs a valid header (version, layer, bitrate and sampling rate index),
+ *              for layer 3 the header of the following frame is checked too if it lies inside buf,
+ *              so that a 0xFFF inside corrupt audio data is not taken as frame start
  ****************************************************************************************************************************************************/
 int32_t MP3FindSyncWord(uint8_t *buf, int32_t nBytes) {
 
     const uint8_t mp3FHsize = 4; // frame header size
-    uint8_t firstFH[4];
+    uint8_t* end = buf + nBytes;
+    uint8_t* p = buf;
 
     //————————————————————————————————————————————————————————————————————————————————————————————————————————
-    auto findSync = [&](uint8_t* buf, uint16_t offset, uint16_t len) { // lambda, inner function
-        for (int32_t i = 0; i < nBytes - 1; i++) {
-            if ((buf[i + offset] & m_SYNCWORDH) == m_SYNCWORDH && (buf[i + offset + 1] & m_SYNCWORDL) == m_SYNCWORDL){
-                return i;
-            }
-        }
-        return (int32_t)-1;
+    auto headerOk = [&](uint8_t* h) { // lambda, inner function
+        if((h[0] & m_SYNCWORDH) != m_SYNCWORDH || (h[1] & m_SYNCWORDL) != m_SYNCWORDL) return false;
+        if(((h[1] >> 3) & 0x03) == 0x01) return false;  // reserved version
+        if(((h[1] >> 1) & 0x03) == 0x00) return false;  // reserved layer
+        if((h[2] & 0b11110000) == 0b11110000) return false; // wrong bitrate index
+        if((h[2] & 0b00001100) == 0b00001100) return false; // wrong sampling rate frequency index
+        return true;
     };
     //————————————————————————————————————————————————————————————————————————————————————————————————————————
-    /* find byte-aligned syncword - need 12 (MPEG 1,2) or 11 (MPEG 2.5) matching bits */
-   int32_t pos = findSync(buf, 0, nBytes);
-    if(pos == -1) return pos; // syncword not found
-    nBytes -= pos;
-
-    while(nBytes > 0){
-        firstFH[0] = buf[pos + 0];
-        firstFH[1] = buf[pos + 1];
-        firstFH[2] = buf[pos + 2];
-        firstFH[3] = buf[pos + 2];
-
-        if((firstFH[2] & 0b11110000) == 0b11110000){ // wrong bitrate index
-            log_d("wrong bitrate index");
-            pos += mp3FHsize;
-            nBytes -= mp3FHsize;
-           int32_t i = findSync(buf, pos, nBytes);
-            pos += i;
-            nBytes -= i;
-            continue;
-        }
-
-        if((firstFH[2] & 0b00001100) == 0b00001100){ // wrong sampling rate frequency index
-            log_d("wrong sampling rate");
-            pos += mp3FHsize;
-            nBytes -= mp3FHsize;
-           int32_t i = findSync(buf, pos, nBytes);
-            pos += i;
-            nBytes -= i;
-            continue;
+    while(end - p >= mp3FHsize){
+        p = (uint8_t*)memchr(p, m_SYNCWORDH, end - p - (mp3FHsize - 1));
+        if(!p) return -1; // syncword not found
+        if(!headerOk(p)) {p++; continue;}
+
+        uint8_t verIdx = (p[1] >> 3) & 0x03;
+        uint8_t brIdx  = (p[2] >> 4) & 0x0f;
+        uint8_t srIdx  = (p[2] >> 2) & 0x03;
+        if(((p[1] >> 1) & 0x03) == 0x01 && brIdx){ // layer 3, not free format: frame length is known
+            uint8_t ver = (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
+            int32_t frameLen = slotTab[ver][srIdx][brIdx] + ((p[2] >> 1) & 0x01);
+            uint8_t* n = p + frameLen;
+            if(n + mp3FHsize <= end){
+                if(n[0] != m_SYNCWORDH || (n[1] & 0xFE) != (p[1] & 0xFE) || ((n[2] >> 2) & 0x03) != srIdx){
+                    log_d("no valid frame header follows");
+                    p++;
+                    continue;
+                }
+            }
         }
-        break;
+        return p - buf;
     }
-
-    return pos;
+    return -1;
 }
 /*****************************************************************************************************************************************************
  * Function:    MP3FindFreeSync
@@ -1295,32 +1294,32 @@ int32_t MP3FindFreeSync(uint8_t *buf, uint8_t firstFH[4], int32_t nBytes){
  *
  * Notes:       call this right after calling MP3Decode
  **********************************************************************************************************************/
-void MP3GetLastFrameInfo() {
-    if (m_MP3DecInfo->layer != 3){
-        m_MP3FrameInfo->bitrate=0;
-        m_MP3FrameInfo->nChans=0;
-        m_MP3FrameInfo->samprate=0;
-        m_MP3FrameInfo->bitsPerSample=0;
-        m_MP3FrameInfo->outputSamps=0;
-        m_MP3FrameInfo->layer=0;
-        m_MP3FrameInfo->version=0;
+void MP3GetLastFrameInfo(MP3Decoder_t* dec) {
+    if (dec->mp3DecInfo->layer != 3){
+        dec->mp3FrameInfo->bitrate=0;
+        dec->mp3FrameInfo->nChans=0;
+        dec->mp3FrameInfo->samprate=0;
+        dec->mp3FrameInfo->bitsPerSample=0;
+        dec->mp3FrameInfo->outputSamps=0;
+        dec->mp3FrameInfo->layer=0;
+        dec->mp3FrameInfo->version=0;
     }
     else{
-        m_MP3FrameInfo->bitrate=m_MP3DecInfo->bitrate;
-        m_MP3FrameInfo->nChans=m_MP3DecInfo->nChans;
-        m_MP3FrameInfo->samprate=m_MP3DecInfo->samprate;
-        m_MP3FrameInfo->bitsPerSample=16;
-        m_MP3FrameInfo->outputSamps=m_MP3DecInfo->nChans
-                * (int32_t) samplesPerFrameTab[m_MPEGVersion][m_MP3DecInfo->layer-1];
-        m_MP3FrameInfo->layer=m_MP3DecInfo->layer;
-        m_MP3FrameInfo->version=m_MPEGVersion;
+        dec->mp3FrameInfo->bitrate=dec->mp3DecInfo->bitrate;
+        dec->mp3FrameInfo->nChans=dec->mp3DecInfo->nChans;
+        dec->mp3FrameInfo->samprate=dec->mp3DecInfo->samprate;
+        dec->mp3FrameInfo->bitsPerSample=16;
+        dec->mp3FrameInfo->outputSamps=dec->mp3DecInfo->nChans
+                * (int32_t) samplesPerFrameTab[dec->mpegVersion][dec->mp3DecInfo->layer-1];
+        dec->mp3FrameInfo->layer=dec->mp3DecInfo->layer;
+        dec->mp3FrameInfo->version=dec->mpegVersion;
     }
 }
-int32_t MP3GetSampRate(){return m_MP3FrameInfo->samprate;}
-int32_t MP3GetChannels(){return m_MP3FrameInfo->nChans;}
-int32_t MP3GetBitsPerSample(){return m_MP3FrameInfo->bitsPerSample;}
-int32_t MP3GetBitrate(){return m_MP3FrameInfo->bitrate;}
-int32_t MP3GetOutputSamps(){return m_MP3FrameInfo->outputSamps;}
+int32_t MP3GetSampRate(MP3Decoder_t* dec){return dec->mp3FrameInfo->samprate;}
+int32_t MP3GetChannels(MP3Decoder_t* dec){return dec->mp3FrameInfo->nChans;}
+int32_t MP3GetBitsPerSample(MP3Decoder_t* dec){return dec->mp3FrameInfo->bitsPerSample;}
+int32_t MP3GetBitrate(MP3Decoder_t* dec){return dec->mp3FrameInfo->bitrate;}
+int32_t MP3GetOutputSamps(MP3Decoder_t* dec){return dec->mp3FrameInfo->outputSamps;}
 /***********************************************************************************************************************
  * Function:    MP3GetNextFrameInfo
  *
@@ -1333,12 +1332,12 @@ int32_t MP3GetOutputSamps(){return m_MP3FrameInfo->outputSamps;}
  *
  * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
  **********************************************************************************************************************/
-int32_t MP3GetNextFrameInfo(uint8_t *buf) {
+int32_t MP3GetNextFrameInfo(MP3Decoder_t* dec, uint8_t *buf) {
 
-    if (UnpackFrameHeader( buf) == -1 || m_MP3DecInfo->layer != 3)
+    if (UnpackFrameHeader(dec,  buf) == -1 || dec->mp3DecInfo->layer != 3)
         return ERR_MP3_INVALID_FRAMEHEADER;
 
-    MP3GetLastFrameInfo();
+    MP3GetLastFrameInfo(dec);
 
     return ERR_MP3_NONE;
 }
@@ -1354,9 +1353,9 @@ int32_t MP3GetNextFrameInfo(uint8_t *buf) {
  *
  * Return:      none
  **********************************************************************************************************************/
-void MP3ClearBadFrame(int16_t *outbuf) {
+void MP3ClearBadFrame(MP3Decoder_t* dec, int16_t *outbuf) {
    int32_t i;
-    for (i = 0; i < m_MP3DecInfo->nGrans * m_MP3DecInfo->nGranSamps * m_MP3DecInfo->nChans; i++)
+    for (i = 0; i < dec->mp3DecInfo->nGrans * dec->mp3DecInfo->nGranSamps * dec->mp3DecInfo->nChans; i++)
         outbuf[i] = 0;
 }
 /***********************************************************************************************************************
@@ -1378,43 +1377,42 @@ void MP3ClearBadFrame(int16_t *outbuf) {
  * Notes:       switching useSize on and off between frames in the same stream
  *                is not supported (bit reservoir is not maintained if useSize on)
  **********************************************************************************************************************/
-int32_t MP3Decode( uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t useSize){
+int32_t MP3Decode(MP3Decoder_t* dec,  uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t useSize){
    int32_t offset, bitOffset, mainBits, gr, ch, fhBytes, siBytes, freeFrameBytes;
    int32_t prevBitOffset, sfBlockBits, huffBlockBits;
     uint8_t *mainPtr;
-    static uint8_t underflowCounter = 0; // http://macslons-irish-pub-radio.stream.laut.fm/macslons-irish-pub-radio
 
     /* unpack frame header */
-    fhBytes = UnpackFrameHeader(inbuf);
+    fhBytes = UnpackFrameHeader(dec, inbuf);
     if (fhBytes < 0){
         return ERR_MP3_INVALID_FRAMEHEADER; /* don't clear outbuf since we don't know size (failed to parse header) */
     }
     inbuf += fhBytes;
     /* unpack side info */
-    siBytes = UnpackSideInfo( inbuf);
+    siBytes = UnpackSideInfo(dec,  inbuf);
     if (siBytes < 0) {
-        MP3ClearBadFrame(outbuf);
+        MP3ClearBadFrame(dec, outbuf);
         return ERR_MP3_INVALID_SIDEINFO;
     }
     inbuf += siBytes;
     *bytesLeft -= (fhBytes + siBytes);
 
     /* if free mode, need to calculate bitrate and nSlots manually, based on frame size */
-    if (m_MP3DecInfo->bitrate == 0 || m_MP3DecInfo->freeBitrateFlag) {
-        if(!m_MP3DecInfo->freeBitrateFlag){
+    if (dec->mp3DecInfo->bitrate == 0 || dec->mp3DecInfo->freeBitrateFlag) {
+        if(!dec->mp3DecInfo->freeBitrateFlag){
             /* first time through, need to scan for next sync word and figure out frame size */
-            m_MP3DecInfo->freeBitrateFlag=1;
-            m_MP3DecInfo->freeBitrateSlots=MP3FindFreeSync(inbuf, inbuf - fhBytes - siBytes, *bytesLeft);
-            if(m_MP3DecInfo->freeBitrateSlots < 0){
-                MP3ClearBadFrame(outbuf);
-                m_MP3DecInfo->freeBitrateFlag = 0;
+            dec->mp3DecInfo->freeBitrateFlag=1;
+            dec->mp3DecInfo->freeBitrateSlots=MP3FindFreeSync(inbuf, inbuf - fhBytes - siBytes, *bytesLeft);
+            if(dec->mp3DecInfo->freeBitrateSlots < 0){
+                MP3ClearBadFrame(dec, outbuf);
+                dec->mp3DecInfo->freeBitrateFlag = 0;
                 return ERR_MP3_FREE_BITRATE_SYNC;
             }
-            freeFrameBytes=m_MP3DecInfo->freeBitrateSlots + fhBytes + siBytes;
-            m_MP3DecInfo->bitrate=(freeFrameBytes * m_MP3DecInfo->samprate * 8)
-                    / (m_MP3DecInfo->nGrans * m_MP3DecInfo->nGranSamps);
+            freeFrameBytes=dec->mp3DecInfo->freeBitrateSlots + fhBytes + siBytes;
+            dec->mp3DecInfo->bitrate=(freeFrameBytes * dec->mp3DecInfo->samprate * 8)
+                    / (dec->mp3DecInfo->nGrans * dec->mp3DecInfo->nGranSamps);
         }
-        m_MP3DecInfo->nSlots = m_MP3DecInfo->freeBitrateSlots + CheckPadBit(); /* add pad byte, if required */
+        dec->mp3DecInfo->nSlots = dec->mp3DecInfo->freeBitrateSlots + CheckPadBit(dec); /* add pad byte, if required */
     }
 
     /* useSize != 0 means we're getting reformatted (RTP) packets (see RFC 3119)
@@ -1424,103 +1422,103 @@ int32_t MP3Decode( uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t
      *      frame is (in bytesLeft)
      */
     if (useSize) {
-        m_MP3DecInfo->nSlots = *bytesLeft;
-        if (m_MP3DecInfo->mainDataBegin != 0 || m_MP3DecInfo->nSlots <= 0) {
+        dec->mp3DecInfo->nSlots = *bytesLeft;
+        if (dec->mp3DecInfo->mainDataBegin != 0 || dec->mp3DecInfo->nSlots <= 0) {
             /* error - non self-contained frame, or missing frame (size <= 0), could do loss concealment here */
-            MP3ClearBadFrame(outbuf);
+            MP3ClearBadFrame(dec, outbuf);
             return ERR_MP3_INVALID_FRAMEHEADER;
         }
 
         /* can operate in-place on reformatted frames */
-        m_MP3DecInfo->mainDataBytes = m_MP3DecInfo->nSlots;
+        dec->mp3DecInfo->mainDataBytes = dec->mp3DecInfo->nSlots;
         mainPtr = inbuf;
-        inbuf += m_MP3DecInfo->nSlots;
-        *bytesLeft -= (m_MP3DecInfo->nSlots);
+        inbuf += dec->mp3DecInfo->nSlots;
+        *bytesLeft -= (dec->mp3DecInfo->nSlots);
     } else {
         /* out of data - assume last or truncated frame */
-        if (m_MP3DecInfo->nSlots > *bytesLeft) {
-            MP3ClearBadFrame(outbuf);
+        if (dec->mp3DecInfo->nSlots > *bytesLeft) {
+            MP3ClearBadFrame(dec, outbuf);
             return ERR_MP3_INDATA_UNDERFLOW;
         }
         /* fill main data buffer with enough new data for this frame */
-        if (m_MP3DecInfo->mainDataBytes >= m_MP3DecInfo->mainDataBegin) {
+        if (dec->mp3DecInfo->mainDataBytes >= dec->mp3DecInfo->mainDataBegin) {
             /* adequate "old" main data available (i.e. bit reservoir) */
-            underflowCounter = 0;
-            memmove(m_MP3DecInfo->mainBuf,
-                    m_MP3DecInfo->mainBuf + m_MP3DecInfo->mainDataBytes - m_MP3DecInfo->mainDataBegin,
-                    m_MP3DecInfo->mainDataBegin);
-            memcpy (m_MP3DecInfo->mainBuf + m_MP3DecInfo->mainDataBegin, inbuf,
-                    m_MP3DecInfo->nSlots);
-
-            m_MP3DecInfo->mainDataBytes = m_MP3DecInfo->mainDataBegin + m_MP3DecInfo->nSlots;
-            inbuf += m_MP3DecInfo->nSlots;
-            *bytesLeft -= (m_MP3DecInfo->nSlots);
-            mainPtr = m_MP3DecInfo->mainBuf;
+            dec->underflowCounter = 0;
+            memmove(dec->mp3DecInfo->mainBuf,
+                    dec->mp3DecInfo->mainBuf + dec->mp3DecInfo->mainDataBytes - dec->mp3DecInfo->mainDataBegin,
+                    dec->mp3DecInfo->mainDataBegin);
+            memcpy (dec->mp3DecInfo->mainBuf + dec->mp3DecInfo->mainDataBegin, inbuf,
+                    dec->mp3DecInfo->nSlots);
+
+            dec->mp3DecInfo->mainDataBytes = dec->mp3DecInfo->mainDataBegin + dec->mp3DecInfo->nSlots;
+            inbuf += dec->mp3DecInfo->nSlots;
+            *bytesLeft -= (dec->mp3DecInfo->nSlots);
+            mainPtr = dec->mp3DecInfo->mainBuf;
         } else {
             /* not enough data in bit reservoir from previous frames (perhaps starting in middle of file) */
-            underflowCounter ++;
-            memcpy(m_MP3DecInfo->mainBuf + m_MP3DecInfo->mainDataBytes, inbuf, m_MP3DecInfo->nSlots);
-            m_MP3DecInfo->mainDataBytes += m_MP3DecInfo->nSlots;
-            inbuf += m_MP3DecInfo->nSlots;
-            *bytesLeft -= (m_MP3DecInfo->nSlots);
-            if(underflowCounter < 4){
+            dec->underflowCounter ++;
+            memcpy(dec->mp3DecInfo->mainBuf + dec->mp3DecInfo->mainDataBytes, inbuf, dec->mp3DecInfo->nSlots);
+            dec->mp3DecInfo->mainDataBytes += dec->mp3DecInfo->nSlots;
+            inbuf += dec->mp3DecInfo->nSlots;
+            *bytesLeft -= (dec->mp3DecInfo->nSlots);
+            if(dec->underflowCounter < 4){
                 return ERR_MP3_NONE;
             }
-            MP3ClearBadFrame( outbuf);
+            MP3ClearBadFrame(dec,  outbuf);
             return ERR_MP3_MAINDATA_UNDERFLOW;
         }
     }
     bitOffset = 0;
-    mainBits = m_MP3DecInfo->mainDataBytes * 8;
+    mainBits = dec->mp3DecInfo->mainDataBytes * 8;
 
     /* decode one complete frame */
-    for (gr = 0; gr < m_MP3DecInfo->nGrans; gr++) {
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
+    for (gr = 0; gr < dec->mp3DecInfo->nGrans; gr++) {
+        for (ch = 0; ch < dec->mp3DecInfo->nChans; ch++) {
             /* unpack scale factors and compute size of scale factor block */
             prevBitOffset = bitOffset;
-            offset = UnpackScaleFactors( mainPtr, &bitOffset,
+            offset = UnpackScaleFactors(dec,  mainPtr, &bitOffset,
                     mainBits, gr, ch);
             sfBlockBits = 8 * offset - prevBitOffset + bitOffset;
-            huffBlockBits = m_MP3DecInfo->part23Length[gr][ch] - sfBlockBits;
+            huffBlockBits = dec->mp3DecInfo->part23Length[gr][ch] - sfBlockBits;
             mainPtr += offset;
             mainBits -= sfBlockBits;
 
             if (offset < 0 || mainBits < huffBlockBits) {
-                MP3ClearBadFrame(outbuf);
+                MP3ClearBadFrame(dec, outbuf);
                 return ERR_MP3_INVALID_SCALEFACT;
             }
             /* decode Huffman code words */
             prevBitOffset = bitOffset;
-            offset = DecodeHuffman( mainPtr, &bitOffset, huffBlockBits, gr, ch);
+            offset = DecodeHuffman(dec,  mainPtr, &bitOffset, huffBlockBits, gr, ch);
             if (offset < 0) {
-                MP3ClearBadFrame( outbuf);
+                MP3ClearBadFrame(dec,  outbuf);
                 return ERR_MP3_INVALID_HUFFCODES;
             }
             mainPtr += offset;
             mainBits -= (8 * offset - prevBitOffset + bitOffset);
         }
         /* dequantize coefficients, decode stereo, reorder int16_t blocks */
-        if (MP3Dequantize( gr) < 0) {
-            MP3ClearBadFrame(outbuf);
+        if (MP3Dequantize(dec,  gr) < 0) {
+            MP3ClearBadFrame(dec, outbuf);
             return ERR_MP3_INVALID_DEQUANTIZE;
         }
 
         /* alias reduction, inverse MDCT, overlap-add, frequency inversion */
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-            if (IMDCT( gr, ch) < 0) {
-                MP3ClearBadFrame(outbuf);
+        for (ch = 0; ch < dec->mp3DecInfo->nChans; ch++) {
+            if (IMDCT(dec,  gr, ch) < 0) {
+                MP3ClearBadFrame(dec, outbuf);
                 return ERR_MP3_INVALID_IMDCT;
             }
         }
         /* subband transform - if stereo, interleaves pcm LRLRLR */
-        if (Subband(
-                outbuf + gr * m_MP3DecInfo->nGranSamps * m_MP3DecInfo->nChans)
+        if (Subband(dec, 
+                outbuf + gr * dec->mp3DecInfo->nGranSamps * dec->mp3DecInfo->nChans)
                 < 0) {
-            MP3ClearBadFrame(outbuf);
+            MP3ClearBadFrame(dec, outbuf);
             return ERR_MP3_INVALID_SUBBAND;
         }
     }
-    MP3GetLastFrameInfo();
+    MP3GetLastFrameInfo(dec);
     return ERR_MP3_NONE;
 }
 
@@ -1536,22 +1534,22 @@ int32_t MP3Decode( uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t
  * Return:      none
  *
  **********************************************************************************************************************/
-void MP3Decoder_ClearBuffer(void) {
+void MP3Decoder_ClearBuffer(MP3Decoder_t* dec) {
 
     /* important to do this - DSP primitives assume a bunch of state variables are 0 on first use */
-    memset( m_MP3DecInfo,         0, sizeof(MP3DecInfo_t));                                    //Clear MP3DecInfo
-    memset(&m_ScaleFactorInfoSub, 0, sizeof(ScaleFactorInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN)); //Clear ScaleFactorInfo
-    memset( m_SideInfo,           0, sizeof(SideInfo_t));                                      //Clear SideInfo
-    memset( m_FrameHeader,        0, sizeof(FrameHeader_t));                                   //Clear FrameHeader
-    memset( m_HuffmanInfo,        0, sizeof(HuffmanInfo_t));                                   //Clear HuffmanInfo
-    memset( m_DequantInfo,        0, sizeof(DequantInfo_t));                                   //Clear DequantInfo
-    memset( m_IMDCTInfo,          0, sizeof(IMDCTInfo_t));                                     //Clear IMDCTInfo
-    memset( m_SubbandInfo,        0, sizeof(SubbandInfo_t));                                   //Clear SubbandInfo
-    memset(&m_CriticalBandInfo,   0, sizeof(CriticalBandInfo_t)*m_MAX_NCHAN);                  //Clear CriticalBandInfo
-    memset( m_ScaleFactorJS,      0, sizeof(ScaleFactorJS_t));                                 //Clear ScaleFactorJS
-    memset(&m_SideInfoSub,        0, sizeof(SideInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN));        //Clear SideInfoSub
-    memset(&m_SFBandTable,        0, sizeof(SFBandTable_t));                                   //Clear SFBandTable
-    memset( m_MP3FrameInfo,       0, sizeof(MP3FrameInfo_t));                                  //Clear MP3FrameInfo
+    memset( dec->mp3DecInfo,         0, sizeof(MP3DecInfo_t));                                    //Clear MP3DecInfo
+    memset(&dec->scaleFactorInfoSub, 0, sizeof(ScaleFactorInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN)); //Clear ScaleFactorInfo
+    memset( dec->sideInfo,           0, sizeof(SideInfo_t));                                      //Clear SideInfo
+    memset( dec->frameHeader,        0, sizeof(FrameHeader_t));                                   //Clear FrameHeader
+    memset( dec->huffmanInfo,        0, sizeof(HuffmanInfo_t));                                   //Clear HuffmanInfo
+    memset( dec->dequantInfo,        0, sizeof(DequantInfo_t));                                   //Clear DequantInfo
+    memset( dec->imdctInfo,          0, sizeof(IMDCTInfo_t));                                     //Clear IMDCTInfo
+    memset( dec->subbandInfo,        0, sizeof(SubbandInfo_t));                                   //Clear SubbandInfo
+    memset(&dec->criticalBandInfo,   0, sizeof(CriticalBandInfo_t)*m_MAX_NCHAN);                  //Clear CriticalBandInfo
+    memset( dec->scaleFactorJS,      0, sizeof(ScaleFactorJS_t));                                 //Clear ScaleFactorJS
+    memset(&dec->sideInfoSub,        0, sizeof(SideInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN));        //Clear SideInfoSub
+    memset(&dec->sfBand,        0, sizeof(SFBandTable_t));                                   //Clear SFBandTable
+    memset( dec->mp3FrameInfo,       0, sizeof(MP3FrameInfo_t));                                  //Clear MP3FrameInfo
 
     return;
 
@@ -1573,34 +1571,30 @@ void MP3Decoder_ClearBuffer(void) {
  *
  **********************************************************************************************************************/
 
-#ifdef CONFIG_IDF_TARGET_ESP32S3
-    // ESP32-S3: If there is PSRAM, prefer it
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
-#else
-    // ESP32, PSRAM is too slow, prefer SRAM
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM)
-#endif
+uint32_t MP3Decoder_ArenaSize(void) { // bytes MP3Decoder_AllocateBuffers() takes from the codec arena
+    return ((sizeof(MP3DecInfo_t)    + 7) & ~7) + ((sizeof(FrameHeader_t)   + 7) & ~7) + ((sizeof(SideInfo_t)     + 7) & ~7) +
+           ((sizeof(ScaleFactorJS_t) + 7) & ~7) + ((sizeof(HuffmanInfo_t)   + 7) & ~7) + ((sizeof(DequantInfo_t)  + 7) & ~7) +
+           ((sizeof(IMDCTInfo_t)     + 7) & ~7) + ((sizeof(SubbandInfo_t)   + 7) & ~7) + ((sizeof(MP3FrameInfo_t) + 7) & ~7);
+}
 
-bool MP3Decoder_AllocateBuffers(void) {
-    if(!m_MP3DecInfo)       {m_MP3DecInfo    = (MP3DecInfo_t*)    __malloc_heap_psram(sizeof(MP3DecInfo_t)   );}
-    if(!m_FrameHeader)      {m_FrameHeader   = (FrameHeader_t*)   __malloc_heap_psram(sizeof(FrameHeader_t)  );}
-    if(!m_SideInfo)         {m_SideInfo      = (SideInfo_t*)      __malloc_heap_psram(sizeof(SideInfo_t)     );}
-    if(!m_ScaleFactorJS)    {m_ScaleFactorJS = (ScaleFactorJS_t*) __malloc_heap_psram(sizeof(ScaleFactorJS_t));}
-    if(!m_HuffmanInfo)      {m_HuffmanInfo   = (HuffmanInfo_t*)   __malloc_heap_psram(sizeof(HuffmanInfo_t)  );}
-    if(!m_DequantInfo)      {m_DequantInfo   = (DequantInfo_t*)   __malloc_heap_psram(sizeof(DequantInfo_t)  );}
-    if(!m_IMDCTInfo)        {m_IMDCTInfo     = (IMDCTInfo_t*)     __malloc_heap_psram(sizeof(IMDCTInfo_t)    );}
-    if(!m_SubbandInfo)      {m_SubbandInfo   = (SubbandInfo_t*)   __malloc_heap_psram(sizeof(SubbandInfo_t)  );}
-    if(!m_MP3FrameInfo)     {m_MP3FrameInfo  = (MP3FrameInfo_t*)  __malloc_heap_psram(sizeof(MP3FrameInfo_t) );}
-
-    if(!m_MP3DecInfo || !m_FrameHeader || !m_SideInfo || !m_ScaleFactorJS || !m_HuffmanInfo ||
-       !m_DequantInfo || !m_IMDCTInfo || !m_SubbandInfo || !m_MP3FrameInfo) {
-        MP3Decoder_FreeBuffers();
+bool MP3Decoder_AllocateBuffers(MP3Decoder_t* dec) {
+    if(!dec->mp3DecInfo)       {dec->mp3DecInfo    = (MP3DecInfo_t*)    CodecArena_Alloc(sizeof(MP3DecInfo_t)   );}
+    if(!dec->frameHeader)      {dec->frameHeader   = (FrameHeader_t*)   CodecArena_Alloc(sizeof(FrameHeader_t)  );}
+    if(!dec->sideInfo)         {dec->sideInfo      = (SideInfo_t*)      CodecArena_Alloc(sizeof(SideInfo_t)     );}
+    if(!dec->scaleFactorJS)    {dec->scaleFactorJS = (ScaleFactorJS_t*) CodecArena_Alloc(sizeof(ScaleFactorJS_t));}
+    if(!dec->huffmanInfo)      {dec->huffmanInfo   = (HuffmanInfo_t*)   CodecArena_Alloc(sizeof(HuffmanInfo_t)  );}
+    if(!dec->dequantInfo)      {dec->dequantInfo   = (DequantInfo_t*)   CodecArena_Alloc(sizeof(DequantInfo_t)  );}
+    if(!dec->imdctInfo)        {dec->imdctInfo     = (IMDCTInfo_t*)     CodecArena_Alloc(sizeof(IMDCTInfo_t)    );}
+    if(!dec->subbandInfo)      {dec->subbandInfo   = (SubbandInfo_t*)   CodecArena_Alloc(sizeof(SubbandInfo_t)  );}
+    if(!dec->mp3FrameInfo)     {dec->mp3FrameInfo  = (MP3FrameInfo_t*)  CodecArena_Alloc(sizeof(MP3FrameInfo_t) );}
+
+    if(!dec->mp3DecInfo || !dec->frameHeader || !dec->sideInfo || !dec->scaleFactorJS || !dec->huffmanInfo ||
+       !dec->dequantInfo || !dec->imdctInfo || !dec->subbandInfo || !dec->mp3FrameInfo) {
+        MP3Decoder_FreeBuffers(dec);
         log_e("not enough memory to allocate mp3decoder buffers");
         return false;
     }
-    MP3Decoder_ClearBuffer();
+    MP3Decoder_ClearBuffer(dec);
     return true;
 }
 /***********************************************************************************************************************
@@ -1615,9 +1609,9 @@ bool MP3Decoder_AllocateBuffers(void) {
  * Return:      true if buffers allocated, otherwise false
 
  **********************************************************************************************************************/
-bool MP3Decoder_IsInit(void) {
-    if(!m_MP3DecInfo || !m_FrameHeader || !m_SideInfo || !m_ScaleFactorJS || !m_HuffmanInfo ||
-       !m_DequantInfo || !m_IMDCTInfo || !m_SubbandInfo || !m_MP3FrameInfo) {
+bool MP3Decoder_IsInit(MP3Decoder_t* dec) {
+    if(!dec->mp3DecInfo || !dec->frameHeader || !dec->sideInfo || !dec->scaleFactorJS || !dec->huffmanInfo ||
+       !dec->dequantInfo || !dec->imdctInfo || !dec->subbandInfo || !dec->mp3FrameInfo) {
         return false;
     }
     return true;
@@ -1635,19 +1629,19 @@ bool MP3Decoder_IsInit(void) {
  *
  * Notes:       safe to call even if some buffers were not allocated
  **********************************************************************************************************************/
-void MP3Decoder_FreeBuffers()
+void MP3Decoder_FreeBuffers(MP3Decoder_t* dec)
 {
 //    uint32_t i = ESP.getFreeHeap();
 
-    if(m_MP3DecInfo)        {free(m_MP3DecInfo);      m_MP3DecInfo=NULL;}
-    if(m_FrameHeader)       {free(m_FrameHeader);     m_FrameHeader=NULL;}
-    if(m_SideInfo)          {free(m_SideInfo);        m_SideInfo=NULL;}
-    if(m_ScaleFactorJS )    {free(m_ScaleFactorJS);   m_ScaleFactorJS=NULL;}
-    if(m_HuffmanInfo)       {free(m_HuffmanInfo);     m_HuffmanInfo=NULL;}
-    if(m_DequantInfo)       {free(m_DequantInfo);     m_DequantInfo=NULL;}
-    if(m_IMDCTInfo)         {free(m_IMDCTInfo);       m_IMDCTInfo=NULL;}
-    if(m_SubbandInfo)       {free(m_SubbandInfo);     m_SubbandInfo=NULL;}
-    if(m_MP3FrameInfo)      {free(m_MP3FrameInfo);    m_MP3FrameInfo=NULL;}
+    if(dec->mp3DecInfo)        {CodecArena_Free(dec->mp3DecInfo);      dec->mp3DecInfo=NULL;}
+    if(dec->frameHeader)       {CodecArena_Free(dec->frameHeader);     dec->frameHeader=NULL;}
+    if(dec->sideInfo)          {CodecArena_Free(dec->sideInfo);        dec->sideInfo=NULL;}
+    if(dec->scaleFactorJS )    {CodecArena_Free(dec->scaleFactorJS);   dec->scaleFactorJS=NULL;}
+    if(dec->huffmanInfo)       {CodecArena_Free(dec->huffmanInfo);     dec->huffmanInfo=NULL;}
+    if(dec->dequantInfo)       {CodecArena_Free(dec->dequantInfo);     dec->dequantInfo=NULL;}
+    if(dec->imdctInfo)         {CodecArena_Free(dec->imdctInfo);       dec->imdctInfo=NULL;}
+    if(dec->subbandInfo)       {CodecArena_Free(dec->subbandInfo);     dec->subbandInfo=NULL;}
+    if(dec->mp3FrameInfo)      {CodecArena_Free(dec->mp3FrameInfo);    dec->mp3FrameInfo=NULL;}
 
 //    log_i("MP3Decoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
 }
@@ -2027,15 +2021,15 @@ int32_t DecodeHuffmanQuads(int32_t *vwxy, int32_t nVals, int32_t tabIdx, int32_t
  *                out of bits prematurely (invalid bitstream)
  **********************************************************************************************************************/
 // .data about 1ms faster per frame
-int32_t DecodeHuffman(uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, int32_t gr, int32_t ch){
+int32_t DecodeHuffman(MP3Decoder_t* dec, uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, int32_t gr, int32_t ch){
 
    int32_t r1Start, r2Start, rEnd[4]; /* region boundaries */
    int32_t i, w, bitsUsed, bitsLeft;
     uint8_t *startBuf = buf;
 
     SideInfoSub_t *sis;
-    sis = &m_SideInfoSub[gr][ch];
-    //hi = (HuffmanInfo_t*) (m_MP3DecInfo->HuffmanInfoPS);
+    sis = &dec->sideInfoSub[gr][ch];
+    //hi = (HuffmanInfo_t*) (dec->mp3DecInfo->HuffmanInfoPS);
 
     if (huffBlockBits < 0)
         return -1;
@@ -2043,20 +2037,20 @@ int32_t DecodeHuffman(uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, i
     /* figure out region boundaries (the first 2*bigVals coefficients divided into 3 regions) */
     if (sis->winSwitchFlag && sis->blockType == 2) {
         if (sis->mixedBlock == 0) {
-            r1Start = m_SFBandTable.s[(sis->region0Count + 1) / 3] * 3;
+            r1Start = dec->sfBand.s[(sis->region0Count + 1) / 3] * 3;
         } else {
-            if (m_MPEGVersion == MPEG1) {
-                r1Start = m_SFBandTable.l[sis->region0Count + 1];
+            if (dec->mpegVersion == MPEG1) {
+                r1Start = dec->sfBand.l[sis->region0Count + 1];
             } else {
                 /* see MPEG2 spec for explanation */
-                w = m_SFBandTable.s[4] - m_SFBandTable.s[3];
-                r1Start = m_SFBandTable.l[6] + 2 * w;
+                w = dec->sfBand.s[4] - dec->sfBand.s[3];
+                r1Start = dec->sfBand.l[6] + 2 * w;
             }
         }
         r2Start = m_MAX_NSAMP; /* short blocks don't have region 2 */
     } else {
-        r1Start = m_SFBandTable.l[sis->region0Count + 1];
-        r2Start = m_SFBandTable.l[sis->region0Count + 1 + sis->region1Count + 1];
+        r1Start = dec->sfBand.l[sis->region0Count + 1];
+        r2Start = dec->sfBand.l[sis->region0Count + 1 + sis->region1Count + 1];
     }
 
     /* offset rEnd index by 1 so first region = rEnd[1] - rEnd[0], etc. */
@@ -2066,12 +2060,12 @@ int32_t DecodeHuffman(uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, i
     rEnd[0] = 0;
 
     /* rounds up to first all-zero pair (we don't check last pair for (x,y) == (non-zero, zero)) */
-    m_HuffmanInfo->nonZeroBound[ch] = rEnd[3];
+    dec->huffmanInfo->nonZeroBound[ch] = rEnd[3];
 
     /* decode Huffman pairs (rEnd[i] are always even numbers) */
     bitsLeft = huffBlockBits;
     for (i = 0; i < 3; i++) {
-        bitsUsed = DecodeHuffmanPairs(m_HuffmanInfo->huffDecBuf[ch] + rEnd[i],
+        bitsUsed = DecodeHuffmanPairs(dec->huffmanInfo->huffDecBuf[ch] + rEnd[i],
                 rEnd[i + 1] - rEnd[i], sis->tableSelect[i], bitsLeft, buf,
                 *bitOffset);
         if (bitsUsed < 0 || bitsUsed > bitsLeft) /* error - overran end of bitstream */
@@ -2084,13 +2078,13 @@ int32_t DecodeHuffman(uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, i
     }
 
     /* decode Huffman quads (if any) */
-    m_HuffmanInfo->nonZeroBound[ch] += DecodeHuffmanQuads(m_HuffmanInfo->huffDecBuf[ch] + rEnd[3],
+    dec->huffmanInfo->nonZeroBound[ch] += DecodeHuffmanQuads(dec->huffmanInfo->huffDecBuf[ch] + rEnd[3],
             m_MAX_NSAMP - rEnd[3], sis->count1TableSelect, bitsLeft, buf,
             *bitOffset);
 
-    assert(m_HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
-    for (i = m_HuffmanInfo->nonZeroBound[ch]; i < m_MAX_NSAMP; i++)
-        m_HuffmanInfo->huffDecBuf[ch][i] = 0;
+    assert(dec->huffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
+    for (i = dec->huffmanInfo->nonZeroBound[ch]; i < m_MAX_NSAMP; i++)
+        dec->huffmanInfo->huffDecBuf[ch][i] = 0;
 
     /* If bits used for 576 samples < huffBlockBits, then the extras are considered
      *  to be stuffing bits (throw away, but need to return correct bitstream position)
@@ -2128,16 +2122,16 @@ int32_t DecodeHuffman(uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, i
  *              Equivalently, we can think of the dequantized coefficients as
  *                Q(DQ_FRACBITS_OUT - 15) with no implicit bias.
  **********************************************************************************************************************/
-int32_t MP3Dequantize(int32_t gr){
+int32_t MP3Dequantize(MP3Decoder_t* dec, int32_t gr){
    int32_t i, ch, nSamps, mOut[2];
     CriticalBandInfo_t *cbi;
-    cbi = &m_CriticalBandInfo[0];
+    cbi = &dec->criticalBandInfo[0];
     mOut[0] = mOut[1] = 0;
 
     /* dequantize all the samples in each channel */
-    for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-        m_HuffmanInfo->gb[ch] = DequantChannel(m_HuffmanInfo->huffDecBuf[ch], m_DequantInfo->workBuf,
-                &m_HuffmanInfo->nonZeroBound[ch], &m_SideInfoSub[gr][ch], &m_ScaleFactorInfoSub[gr][ch], &cbi[ch]);
+    for (ch = 0; ch < dec->mp3DecInfo->nChans; ch++) {
+        dec->huffmanInfo->gb[ch] = DequantChannel(dec, dec->huffmanInfo->huffDecBuf[ch], dec->dequantInfo->workBuf,
+                &dec->huffmanInfo->nonZeroBound[ch], &dec->sideInfoSub[gr][ch], &dec->scaleFactorInfoSub[gr][ch], &cbi[ch]);
     }
 
     /* joint stereo processing assumes one guard bit in input samples
@@ -2145,53 +2139,53 @@ int32_t MP3Dequantize(int32_t gr){
      *   just make a pass over the data and clip to [-2^30+1, 2^30-1]
      * in practice this may never happen
      */
-    if (m_FrameHeader->modeExt && (m_HuffmanInfo->gb[0] < 1 || m_HuffmanInfo->gb[1] < 1)) {
-        for (i = 0; i < m_HuffmanInfo->nonZeroBound[0]; i++) {
-            if (m_HuffmanInfo->huffDecBuf[0][i] < -0x3fffffff)  m_HuffmanInfo->huffDecBuf[0][i] = -0x3fffffff;
-            if (m_HuffmanInfo->huffDecBuf[0][i] >  0x3fffffff)  m_HuffmanInfo->huffDecBuf[0][i] =  0x3fffffff;
+    if (dec->frameHeader->modeExt && (dec->huffmanInfo->gb[0] < 1 || dec->huffmanInfo->gb[1] < 1)) {
+        for (i = 0; i < dec->huffmanInfo->nonZeroBound[0]; i++) {
+            if (dec->huffmanInfo->huffDecBuf[0][i] < -0x3fffffff)  dec->huffmanInfo->huffDecBuf[0][i] = -0x3fffffff;
+            if (dec->huffmanInfo->huffDecBuf[0][i] >  0x3fffffff)  dec->huffmanInfo->huffDecBuf[0][i] =  0x3fffffff;
         }
-        for (i = 0; i < m_HuffmanInfo->nonZeroBound[1]; i++) {
-            if (m_HuffmanInfo->huffDecBuf[1][i] < -0x3fffffff)  m_HuffmanInfo->huffDecBuf[1][i] = -0x3fffffff;
-            if (m_HuffmanInfo->huffDecBuf[1][i] >  0x3fffffff)  m_HuffmanInfo->huffDecBuf[1][i] =  0x3fffffff;
+        for (i = 0; i < dec->huffmanInfo->nonZeroBound[1]; i++) {
+            if (dec->huffmanInfo->huffDecBuf[1][i] < -0x3fffffff)  dec->huffmanInfo->huffDecBuf[1][i] = -0x3fffffff;
+            if (dec->huffmanInfo->huffDecBuf[1][i] >  0x3fffffff)  dec->huffmanInfo->huffDecBuf[1][i] =  0x3fffffff;
         }
     }
 
     /* do mid-side stereo processing, if enabled */
-    if (m_FrameHeader->modeExt >> 1) {
-        if (m_FrameHeader->modeExt & 0x01) {
+    if (dec->frameHeader->modeExt >> 1) {
+        if (dec->frameHeader->modeExt & 0x01) {
             /* intensity stereo enabled - run mid-side up to start of right zero region */
             if (cbi[1].cbType == 0)
-                nSamps = m_SFBandTable.l[cbi[1].cbEndL + 1];
+                nSamps = dec->sfBand.l[cbi[1].cbEndL + 1];
             else
-                nSamps = 3 * m_SFBandTable.s[cbi[1].cbEndSMax + 1];
+                nSamps = 3 * dec->sfBand.s[cbi[1].cbEndSMax + 1];
         } else {
             /* intensity stereo disabled - run mid-side on whole spectrum */
-            nSamps = (m_HuffmanInfo->nonZeroBound[0] > m_HuffmanInfo->nonZeroBound[1] ?
-                                                       m_HuffmanInfo->nonZeroBound[0] : m_HuffmanInfo->nonZeroBound[1]);
+            nSamps = (dec->huffmanInfo->nonZeroBound[0] > dec->huffmanInfo->nonZeroBound[1] ?
+                                                       dec->huffmanInfo->nonZeroBound[0] : dec->huffmanInfo->nonZeroBound[1]);
         }
-        MidSideProc(m_HuffmanInfo->huffDecBuf, nSamps, mOut);
+        MidSideProc(dec->huffmanInfo->huffDecBuf, nSamps, mOut);
     }
 
     /* do intensity stereo processing, if enabled */
-    if (m_FrameHeader->modeExt & 0x01) {
-        nSamps = m_HuffmanInfo->nonZeroBound[0];
-        if (m_MPEGVersion == MPEG1) {
-            IntensityProcMPEG1(m_HuffmanInfo->huffDecBuf, nSamps, &m_ScaleFactorInfoSub[gr][1], &m_CriticalBandInfo[0],
-                    m_FrameHeader->modeExt >> 1, m_SideInfoSub[gr][1].mixedBlock, mOut);
+    if (dec->frameHeader->modeExt & 0x01) {
+        nSamps = dec->huffmanInfo->nonZeroBound[0];
+        if (dec->mpegVersion == MPEG1) {
+            IntensityProcMPEG1(dec, dec->huffmanInfo->huffDecBuf, nSamps, &dec->scaleFactorInfoSub[gr][1], &dec->criticalBandInfo[0],
+                    dec->frameHeader->modeExt >> 1, dec->sideInfoSub[gr][1].mixedBlock, mOut);
         } else {
-            IntensityProcMPEG2(m_HuffmanInfo->huffDecBuf, nSamps, &m_ScaleFactorInfoSub[gr][1], &m_CriticalBandInfo[0],
-                    m_ScaleFactorJS, m_FrameHeader->modeExt >> 1, m_SideInfoSub[gr][1].mixedBlock, mOut);
+            IntensityProcMPEG2(dec, dec->huffmanInfo->huffDecBuf, nSamps, &dec->scaleFactorInfoSub[gr][1], &dec->criticalBandInfo[0],
+                    dec->scaleFactorJS, dec->frameHeader->modeExt >> 1, dec->sideInfoSub[gr][1].mixedBlock, mOut);
         }
     }
 
     /* adjust guard bit count and nonZeroBound if we did any stereo processing */
-    if (m_FrameHeader->modeExt) {
-        m_HuffmanInfo->gb[0] = CLZ(mOut[0]) - 1;
-        m_HuffmanInfo->gb[1] = CLZ(mOut[1]) - 1;
-        nSamps = (m_HuffmanInfo->nonZeroBound[0] > m_HuffmanInfo->nonZeroBound[1] ?
-                                                       m_HuffmanInfo->nonZeroBound[0] : m_HuffmanInfo->nonZeroBound[1]);
-        m_HuffmanInfo->nonZeroBound[0] = nSamps;
-        m_HuffmanInfo->nonZeroBound[1] = nSamps;
+    if (dec->frameHeader->modeExt) {
+        dec->huffmanInfo->gb[0] = CLZ(mOut[0]) - 1;
+        dec->huffmanInfo->gb[1] = CLZ(mOut[1]) - 1;
+        nSamps = (dec->huffmanInfo->nonZeroBound[0] > dec->huffmanInfo->nonZeroBound[1] ?
+                                                       dec->huffmanInfo->nonZeroBound[0] : dec->huffmanInfo->nonZeroBound[1]);
+        dec->huffmanInfo->nonZeroBound[0] = nSamps;
+        dec->huffmanInfo->nonZeroBound[1] = nSamps;
     }
 
     /* output format Q(DQ_FRACBITS_OUT) */
@@ -2319,7 +2313,7 @@ int32_t DequantBlock(int32_t *inbuf, int32_t *outbuf, int32_t num, int32_t scale
  *
  * Notes:       dequantized samples in Q(DQ_FRACBITS_OUT) format
  **********************************************************************************************************************/
-int32_t DequantChannel(int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBound,  SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis,
+int32_t DequantChannel(MP3Decoder_t* dec, int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBound,  SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis,
                                                                                               CriticalBandInfo_t *cbi)
 {
    int32_t i, j, w, cb;
@@ -2334,7 +2328,7 @@ int32_t DequantChannel(int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBou
     if (sis->blockType == 2) {
         // cbStartL = 0;
         if (sis->mixedBlock) {
-            cbEndL = (m_MPEGVersion == MPEG1 ? 8 : 6);
+            cbEndL = (dec->mpegVersion == MPEG1 ? 8 : 6);
             cbStartS = 3;
         } else {
             cbEndL = 0;
@@ -2363,7 +2357,7 @@ int32_t DequantChannel(int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBou
      *   dividing every sample by sqrt(2) = multiplying by 2^-.5)
      */
     globalGain = sis->globalGain;
-    if (m_FrameHeader->modeExt >> 1)
+    if (dec->frameHeader->modeExt >> 1)
          globalGain -= 2;
     globalGain += m_IMDCT_SCALE;      /* scale everything by sqrt(2), for fast IMDCT36 */
 
@@ -2371,7 +2365,7 @@ int32_t DequantChannel(int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBou
     for (cb = 0; cb < cbEndL; cb++) {
 
         nonZero = 0;
-        nSamps = m_SFBandTable.l[cb + 1] - m_SFBandTable.l[cb];
+        nSamps = dec->sfBand.l[cb + 1] - dec->sfBand.l[cb];
         gainI = 210 - globalGain + sfactMultiplier * (sfis->l[cb] + (sis->preFlag ? (int32_t)preTab[cb] : 0));
 
         nonZero |= DequantBlock(sampleBuf + i, sampleBuf + i, nSamps, gainI);
@@ -2400,7 +2394,7 @@ int32_t DequantChannel(int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBou
     cbMax[2] = cbMax[1] = cbMax[0] = cbStartS;
     for (cb = cbStartS; cb < cbEndS; cb++) {
 
-        nSamps = m_SFBandTable.s[cb + 1] - m_SFBandTable.s[cb];
+        nSamps = dec->sfBand.s[cb + 1] - dec->sfBand.s[cb];
         for (w = 0; w < 3; w++) {
             nonZero =  0;
             gainI = 210 - globalGain + 8*sis->subBlockGain[w] + sfactMultiplier*(sfis->s[cb][w]);
@@ -2512,7 +2506,7 @@ void MidSideProc(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps, int32_t mO
  * Notes:       assume at least 1 GB in input
  *
  **********************************************************************************************************************/
-void IntensityProcMPEG1(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,  ScaleFactorInfoSub_t *sfis,
+void IntensityProcMPEG1(MP3Decoder_t* dec, int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,  ScaleFactorInfoSub_t *sfis,
                                                     CriticalBandInfo_t *cbi, int32_t midSideFlag, int32_t mixFlag, int32_t mOut[2])
 {
    int32_t i = 0, j = 0, n = 0, cb = 0, w = 0;
@@ -2531,13 +2525,13 @@ void IntensityProcMPEG1(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,  Sc
         cbStartL = cbi[1].cbEndL + 1;
         cbEndL = cbi[0].cbEndL + 1;
         cbStartS = cbEndS = 0;
-        i = m_SFBandTable.l[cbStartL];
+        i = dec->sfBand.l[cbStartL];
     } else if (cbi[1].cbType == 1 || cbi[1].cbType == 2) {
         /* short or mixed block */
         cbStartS = cbi[1].cbEndSMax + 1;
         cbEndS = cbi[0].cbEndSMax + 1;
         cbStartL = cbEndL = 0;
-        i = 3 * m_SFBandTable.s[cbStartS];
+        i = 3 * dec->sfBand.s[cbStartS];
     }
     sampsLeft = nSamps - i; /* process to length of left */
     isfTab = (int32_t *) ISFMpeg1[midSideFlag];
@@ -2554,7 +2548,7 @@ void IntensityProcMPEG1(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,  Sc
             fr = isfTab[6] - isfTab[isf];
         }
 
-        n = m_SFBandTable.l[cb + 1] - m_SFBandTable.l[cb];
+        n = dec->sfBand.l[cb + 1] - dec->sfBand.l[cb];
         for (j = 0; j < n && sampsLeft > 0; j++, i++) {
             xr = MULSHIFT32(fr, x[0][i]) << 2;
             x[1][i] = xr;
@@ -2577,7 +2571,7 @@ void IntensityProcMPEG1(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,  Sc
                 frs[w] = isfTab[6] - isfTab[isf];
             }
         }
-        n = m_SFBandTable.s[cb + 1] - m_SFBandTable.s[cb];
+        n = dec->sfBand.s[cb + 1] - dec->sfBand.s[cb];
         for (j = 0; j < n && sampsLeft >= 3; j++, i += 3) {
             xr = MULSHIFT32(frs[0], x[0][i + 0]) << 2;
             x[1][i + 0] = xr;
@@ -2626,7 +2620,7 @@ void IntensityProcMPEG1(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,  Sc
  * Notes:       assume at least 1 GB in input
  *
  **********************************************************************************************************************/
-void IntensityProcMPEG2(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,
+void IntensityProcMPEG2(MP3Decoder_t* dec, int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,
          ScaleFactorInfoSub_t *sfis, CriticalBandInfo_t *cbi,
         ScaleFactorJS_t *sfjs, int32_t midSideFlag, int32_t mixFlag, int32_t mOut[2]) {
    int32_t i, j, k, n, r, cb, w;
@@ -2653,7 +2647,7 @@ void IntensityProcMPEG2(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,
         il[21] = il[22] = 1;
         cbStartL = cbi[1].cbEndL + 1; /* start at end of right */
         cbEndL = cbi[0].cbEndL + 1; /* process to end of left */
-        i = m_SFBandTable.l[cbStartL];
+        i = dec->sfBand.l[cbStartL];
         sampsLeft = nSamps - i;
 
         for (cb = cbStartL; cb < cbEndL; cb++) {
@@ -2666,7 +2660,7 @@ void IntensityProcMPEG2(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,
                 fl = isfTab[(sfIdx & 0x01 ? isf : 0)];
                 fr = isfTab[(sfIdx & 0x01 ? 0 : isf)];
             }
-           int32_t r=m_SFBandTable.l[cb + 1] - m_SFBandTable.l[cb];
+           int32_t r=dec->sfBand.l[cb + 1] - dec->sfBand.l[cb];
             n=(r < sampsLeft ? r : sampsLeft);
             //n = MIN(fh->sfBand->l[cb + 1] - fh->sfBand->l[cb], sampsLeft);
             for (j = 0; j < n; j++, i++) {
@@ -2689,7 +2683,7 @@ void IntensityProcMPEG2(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,
         for (w = 0; w < 3; w++) {
             cbStartS = cbi[1].cbEndS[w] + 1; /* start at end of right */
             cbEndS = cbi[0].cbEndS[w] + 1; /* process to end of left */
-            i = 3 * m_SFBandTable.s[cbStartS] + w;
+            i = 3 * dec->sfBand.s[cbStartS] + w;
 
             /* skip through sample array by 3, so early-exit logic would be more tricky */
             for (cb = cbStartS; cb < cbEndS; cb++) {
@@ -2702,7 +2696,7 @@ void IntensityProcMPEG2(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps,
                     fl = isfTab[(sfIdx & 0x01 ? isf : 0)];
                     fr = isfTab[(sfIdx & 0x01 ? 0 : isf)];
                 }
-                n = m_SFBandTable.s[cb + 1] - m_SFBandTable.s[cb];
+                n = dec->sfBand.s[cb + 1] - dec->sfBand.s[cb];
 
                 for (j = 0; j < n; j++, i += 3) {
                     xr = MULSHIFT32(fr, x[0][i]) << 2;
@@ -3428,24 +3422,24 @@ int32_t HybridTransform(int32_t *xCurr, int32_t *xPrev, int32_t y[m_BLOCK_SIZE][
  **********************************************************************************************************************/
 // a bit faster in RAM
 /*__attribute__ ((section (".data")))*/
-int32_t IMDCT(int32_t gr, int32_t ch) {
+int32_t IMDCT(MP3Decoder_t* dec, int32_t gr, int32_t ch) {
    int32_t nBfly, blockCutoff;
     BlockCount_t bc;
 
-    /* m_SideInfo is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
+    /* dec->sideInfo is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
     /* anti-aliasing done on whole long blocks only
      * for mixed blocks, nBfly always 1, except 3 for 8 kHz MPEG 2.5 (see sfBandTab)
      *   nLongBlocks = number of blocks with (possibly) non-zero power
      *   nBfly = number of butterflies to do (nLongBlocks - 1, unless no long blocks)
      */
-    blockCutoff = m_SFBandTable.l[(m_MPEGVersion == MPEG1 ? 8 : 6)] / 18; /* same as 3* num short sfb's in spec */
-    if (m_SideInfoSub[gr][ch].blockType != 2) {
+    blockCutoff = dec->sfBand.l[(dec->mpegVersion == MPEG1 ? 8 : 6)] / 18; /* same as 3* num short sfb's in spec */
+    if (dec->sideInfoSub[gr][ch].blockType != 2) {
         /* all long transforms */
-       int32_t x=(m_HuffmanInfo->nonZeroBound[ch] + 7) / 18 + 1;
+       int32_t x=(dec->huffmanInfo->nonZeroBound[ch] + 7) / 18 + 1;
         bc.nBlocksLong=(x<32 ? x : 32);
         //bc.nBlocksLong = min((hi->nonZeroBound[ch] + 7) / 18 + 1, 32);
         nBfly = bc.nBlocksLong - 1;
-    } else if (m_SideInfoSub[gr][ch].blockType == 2 && m_SideInfoSub[gr][ch].mixedBlock) {
+    } else if (dec->sideInfoSub[gr][ch].blockType == 2 && dec->sideInfoSub[gr][ch].mixedBlock) {
         /* mixed block - long transforms until cutoff, then short transforms */
         bc.nBlocksLong = blockCutoff;
         nBfly = bc.nBlocksLong - 1;
@@ -3455,29 +3449,29 @@ int32_t IMDCT(int32_t gr, int32_t ch) {
         nBfly = 0;
     }
 
-    AntiAlias(m_HuffmanInfo->huffDecBuf[ch], nBfly);
-   int32_t x=m_HuffmanInfo->nonZeroBound[ch];
+    AntiAlias(dec->huffmanInfo->huffDecBuf[ch], nBfly);
+   int32_t x=dec->huffmanInfo->nonZeroBound[ch];
    int32_t y=nBfly * 18 + 8;
-    m_HuffmanInfo->nonZeroBound[ch]=(x>y ? x: y);
+    dec->huffmanInfo->nonZeroBound[ch]=(x>y ? x: y);
 
-    assert(m_HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
+    assert(dec->huffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
 
     /* for readability, use a struct instead of passing a million parameters to HybridTransform() */
-    bc.nBlocksTotal = (m_HuffmanInfo->nonZeroBound[ch] + 17) / 18;
-    bc.nBlocksPrev = m_IMDCTInfo->numPrevIMDCT[ch];
-    bc.prevType = m_IMDCTInfo->prevType[ch];
-    bc.prevWinSwitch = m_IMDCTInfo->prevWinSwitch[ch];
+    bc.nBlocksTotal = (dec->huffmanInfo->nonZeroBound[ch] + 17) / 18;
+    bc.nBlocksPrev = dec->imdctInfo->numPrevIMDCT[ch];
+    bc.prevType = dec->imdctInfo->prevType[ch];
+    bc.prevWinSwitch = dec->imdctInfo->prevWinSwitch[ch];
     /* where WINDOW switches (not nec. transform) */
-    bc.currWinSwitch = (m_SideInfoSub[gr][ch].mixedBlock ? blockCutoff : 0);
-    bc.gbIn = m_HuffmanInfo->gb[ch];
+    bc.currWinSwitch = (dec->sideInfoSub[gr][ch].mixedBlock ? blockCutoff : 0);
+    bc.gbIn = dec->huffmanInfo->gb[ch];
 
-    m_IMDCTInfo->numPrevIMDCT[ch] = HybridTransform(m_HuffmanInfo->huffDecBuf[ch], m_IMDCTInfo->overBuf[ch],
-            m_IMDCTInfo->outBuf[ch], &m_SideInfoSub[gr][ch], &bc);
-    m_IMDCTInfo->prevType[ch] = m_SideInfoSub[gr][ch].blockType;
-    m_IMDCTInfo->prevWinSwitch[ch] = bc.currWinSwitch; /* 0 means not a mixed block (either all short or all long) */
-    m_IMDCTInfo->gb[ch] = bc.gbOut;
+    dec->imdctInfo->numPrevIMDCT[ch] = HybridTransform(dec->huffmanInfo->huffDecBuf[ch], dec->imdctInfo->overBuf[ch],
+            dec->imdctInfo->outBuf[ch], &dec->sideInfoSub[gr][ch], &bc);
+    dec->imdctInfo->prevType[ch] = dec->sideInfoSub[gr][ch].blockType;
+    dec->imdctInfo->prevWinSwitch[ch] = bc.currWinSwitch; /* 0 means not a mixed block (either all short or all long) */
+    dec->imdctInfo->gb[ch] = bc.gbOut;
 
-    assert(m_IMDCTInfo->numPrevIMDCT[ch] <= m_NBANDS);
+    assert(dec->imdctInfo->numPrevIMDCT[ch] <= m_NBANDS);
 
     /* output has gained 2int32_t bits */
     return 0;
@@ -3499,28 +3493,28 @@ int32_t IMDCT(int32_t gr, int32_t ch) {
  *
  * Return:      0 on success,  -1 if null input pointers
  **********************************************************************************************************************/
-int32_t Subband(int16_t *pcmBuf) {
+int32_t Subband(MP3Decoder_t* dec, int16_t *pcmBuf) {
    int32_t b;
-    if (m_MP3DecInfo->nChans == 2) {
+    if (dec->mp3DecInfo->nChans == 2) {
         /* stereo */
         for (b = 0; b < m_BLOCK_SIZE; b++) {
-            FDCT32(m_IMDCTInfo->outBuf[0][b], m_SubbandInfo->vbuf + 0 * 32, m_SubbandInfo->vindex,
-                    (b & 0x01), m_IMDCTInfo->gb[0]);
-            FDCT32(m_IMDCTInfo->outBuf[1][b], m_SubbandInfo->vbuf + 1 * 32, m_SubbandInfo->vindex,
-                    (b & 0x01), m_IMDCTInfo->gb[1]);
+            FDCT32(dec->imdctInfo->outBuf[0][b], dec->subbandInfo->vbuf + 0 * 32, dec->subbandInfo->vindex,
+                    (b & 0x01), dec->imdctInfo->gb[0]);
+            FDCT32(dec->imdctInfo->outBuf[1][b], dec->subbandInfo->vbuf + 1 * 32, dec->subbandInfo->vindex,
+                    (b & 0x01), dec->imdctInfo->gb[1]);
             PolyphaseStereo(pcmBuf,
-                    m_SubbandInfo->vbuf + m_SubbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01),
+                    dec->subbandInfo->vbuf + dec->subbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01),
                     polyCoef);
-            m_SubbandInfo->vindex = (m_SubbandInfo->vindex - (b & 0x01)) & 7;
+            dec->subbandInfo->vindex = (dec->subbandInfo->vindex - (b & 0x01)) & 7;
             pcmBuf += (2 * m_NBANDS);
         }
     } else {
         /* mono */
         for (b = 0; b < m_BLOCK_SIZE; b++) {
-            FDCT32(m_IMDCTInfo->outBuf[0][b], m_SubbandInfo->vbuf + 0 * 32, m_SubbandInfo->vindex,
-                    (b & 0x01), m_IMDCTInfo->gb[0]);
-            PolyphaseMono(pcmBuf, m_SubbandInfo->vbuf + m_SubbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
-            m_SubbandInfo->vindex = (m_SubbandInfo->vindex - (b & 0x01)) & 7;
+            FDCT32(dec->imdctInfo->outBuf[0][b], dec->subbandInfo->vbuf + 0 * 32, dec->subbandInfo->vindex,
+                    (b & 0x01), dec->imdctInfo->gb[0]);
+            PolyphaseMono(pcmBuf, dec->subbandInfo->vbuf + dec->subbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+            dec->subbandInfo->vindex = (dec->subbandInfo->vindex - (b & 0x01)) & 7;
             pcmBuf += m_NBANDS;
         }
     }
@@ -3738,7 +3732,7 @@ short ClipToShort(int32_t x, int32_t fracBits){
  *
  * Return:      none
  **********************************************************************************************************************/
-void PolyphaseMono(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
+CODEC_HOT_FUNC void PolyphaseMono(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
    int32_t i;
     const uint32_t *coef;
    int32_t *vb1;
@@ -3803,7 +3797,7 @@ void PolyphaseMono(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
  *
  * Notes:       interleaves PCM samples LRLRLR...
  **********************************************************************************************************************/
-void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
+CODEC_HOT_FUNC void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
    int32_t i;
     const uint32_t *coef;
    int32_t *vb1;
@@ -3864,3 +3858,4 @@ void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
         pcm += 2;
     }
 }
+#endif // AUDIO_CODEC_MP3
@@ -3,6 +3,8 @@
 
 #include "Arduino.h"
 #include "assert.h"
+#include "../codec_arena.h"
+#include "../codec_mem.h"
 
 static const uint8_t  m_HUFF_PAIRTABS          =32;
 static const uint8_t  m_BLOCK_SIZE             =18;
@@ -454,46 +456,69 @@ const uint32_t csa[8][2] PROGMEM = {
  *   see PolyphaseStereo() and PolyphaseMono()
  */
 
+typedef struct MP3Decoder_t { // complete decoder state, one per stream, the buffers come from MP3Decoder_AllocateBuffers()
+    MP3FrameInfo_t*      mp3FrameInfo = NULL;
+    SFBandTable_t        sfBand = {};
+    StereoMode_t         sMode = Stereo;                                   // mono/stereo mode
+    MPEGVersion_t        mpegVersion = MPEG1;                              // version ID
+    FrameHeader_t*       frameHeader = NULL;
+    SideInfoSub_t        sideInfoSub[m_MAX_NGRAN][m_MAX_NCHAN] = {};
+    SideInfo_t*          sideInfo = NULL;
+    CriticalBandInfo_t   criticalBandInfo[m_MAX_NCHAN] = {};               // filled in dequantizer, used in joint stereo reconstruction
+    DequantInfo_t*       dequantInfo = NULL;
+    HuffmanInfo_t*       huffmanInfo = NULL;
+    IMDCTInfo_t*         imdctInfo = NULL;
+    ScaleFactorInfoSub_t scaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN] = {};
+    ScaleFactorJS_t*     scaleFactorJS = NULL;
+    SubbandInfo_t*       subbandInfo = NULL;
+    MP3DecInfo_t*        mp3DecInfo = NULL;
+    uint8_t              underflowCounter = 0;                             // http://macslons-irish-pub-radio.stream.laut.fm/macslons-irish-pub-radio
+}MP3Decoder_t;
+
 // prototypes
-bool MP3Decoder_AllocateBuffers(void);
-bool MP3Decoder_IsInit();
-void MP3Decoder_FreeBuffers();
-int32_t  MP3Decode( uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t useSize);
-void MP3GetLastFrameInfo();
-int32_t  MP3GetNextFrameInfo(uint8_t *buf);
+MP3Decoder_t* MP3Decoder_Create();
+void MP3Decoder_Destroy(MP3Decoder_t* dec);
+MP3Decoder_t* MP3Decoder_Default();
+uint32_t MP3Decoder_ArenaSize(void);
+bool MP3Decoder_AllocateBuffers(MP3Decoder_t* dec);
+bool MP3Decoder_IsInit(MP3Decoder_t* dec);
+void MP3Decoder_FreeBuffers(MP3Decoder_t* dec);
+int32_t  MP3Decode(MP3Decoder_t* dec,  uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t useSize);
+void MP3GetLastFrameInfo(MP3Decoder_t* dec);
+int32_t  MP3GetNextFrameInfo(MP3Decoder_t* dec, uint8_t *buf);
 int32_t  MP3FindSyncWord(uint8_t *buf, int32_t nBytes);
-int32_t  MP3GetSampRate();
-int32_t  MP3GetChannels();
-int32_t  MP3GetBitsPerSample();
-int32_t  MP3GetBitrate();
-int32_t  MP3GetOutputSamps();
+int32_t  MP3GetSampRate(MP3Decoder_t* dec);
+int32_t  MP3GetChannels(MP3Decoder_t* dec);
+int32_t  MP3GetBitsPerSample(MP3Decoder_t* dec);
+int32_t  MP3GetBitrate(MP3Decoder_t* dec);
+int32_t  MP3GetOutputSamps(MP3Decoder_t* dec);
 
 //internally used
-void MP3Decoder_ClearBuffer(void);
+void MP3Decoder_ClearBuffer(MP3Decoder_t* dec);
 void PolyphaseMono(int16_t *pcm, int32_t *vbuf, const uint32_t* coefBase);
 void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t* coefBase);
 void SetBitstreamPointer(BitStreamInfo_t *bsi, int32_t nBytes, uint8_t *buf);
 uint32_t GetBits(BitStreamInfo_t *bsi, int32_t nBits);
 int32_t CalcBitsUsed(BitStreamInfo_t *bsi, uint8_t *startBuf, int32_t startOffset);
-int32_t DequantChannel(int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBound, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, CriticalBandInfo_t *cbi);
+int32_t DequantChannel(MP3Decoder_t* dec, int32_t *sampleBuf, int32_t *workBuf, int32_t *nonZeroBound, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, CriticalBandInfo_t *cbi);
 void MidSideProc(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps, int32_t mOut[2]);
-void IntensityProcMPEG1(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps, ScaleFactorInfoSub_t *sfis,	CriticalBandInfo_t *cbi, int32_t midSideFlag, int32_t mixFlag, int32_t mOut[2]);
-void IntensityProcMPEG2(int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps, ScaleFactorInfoSub_t *sfis, CriticalBandInfo_t *cbi, ScaleFactorJS_t *sfjs, int32_t midSideFlag, int32_t mixFlag, int32_t mOut[2]);
+void IntensityProcMPEG1(MP3Decoder_t* dec, int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps, ScaleFactorInfoSub_t *sfis,	CriticalBandInfo_t *cbi, int32_t midSideFlag, int32_t mixFlag, int32_t mOut[2]);
+void IntensityProcMPEG2(MP3Decoder_t* dec, int32_t x[m_MAX_NCHAN][m_MAX_NSAMP], int32_t nSamps, ScaleFactorInfoSub_t *sfis, CriticalBandInfo_t *cbi, ScaleFactorJS_t *sfjs, int32_t midSideFlag, int32_t mixFlag, int32_t mOut[2]);
 void FDCT32(int32_t *x, int32_t *d, int32_t offset, int32_t oddBlock, int32_t gb);// __attribute__ ((section (".data")));
-int32_t CheckPadBit();
-int32_t UnpackFrameHeader(uint8_t *buf);
-int32_t UnpackSideInfo(uint8_t *buf);
-int32_t DecodeHuffman( uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, int32_t gr, int32_t ch);
-int32_t MP3Dequantize( int32_t gr);
-int32_t IMDCT( int32_t gr, int32_t ch);
-int32_t UnpackScaleFactors( uint8_t *buf, int32_t *bitOffset, int32_t bitsAvail, int32_t gr, int32_t ch);
-int32_t Subband(int16_t *pcmBuf);
+int32_t CheckPadBit(MP3Decoder_t* dec);
+int32_t UnpackFrameHeader(MP3Decoder_t* dec, uint8_t *buf);
+int32_t UnpackSideInfo(MP3Decoder_t* dec, uint8_t *buf);
+int32_t DecodeHuffman(MP3Decoder_t* dec,  uint8_t *buf, int32_t *bitOffset, int32_t huffBlockBits, int32_t gr, int32_t ch);
+int32_t MP3Dequantize(MP3Decoder_t* dec,  int32_t gr);
+int32_t IMDCT(MP3Decoder_t* dec,  int32_t gr, int32_t ch);
+int32_t UnpackScaleFactors(MP3Decoder_t* dec,  uint8_t *buf, int32_t *bitOffset, int32_t bitsAvail, int32_t gr, int32_t ch);
+int32_t Subband(MP3Decoder_t* dec, int16_t *pcmBuf);
 int16_t ClipToShort(int32_t x, int32_t fracBits);
 void RefillBitstreamCache(BitStreamInfo_t *bsi);
 void UnpackSFMPEG1(BitStreamInfo_t *bsi, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, int32_t *scfsi, int32_t gr, ScaleFactorInfoSub_t *sfisGr0);
 void UnpackSFMPEG2(BitStreamInfo_t *bsi, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, int32_t gr, int32_t ch, int32_t modeExt, ScaleFactorJS_t *sfjs);
 int32_t MP3FindFreeSync(uint8_t *buf, uint8_t firstFH[4], int32_t nBytes);
-void MP3ClearBadFrame( int16_t *outbuf);
+void MP3ClearBadFrame(MP3Decoder_t* dec,  int16_t *outbuf);
 int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t bitsLeft, uint8_t *buf, int32_t bitOffset);
 int32_t DecodeHuffmanQuads(int32_t *vwxy, int32_t nVals, int32_t tabIdx, int32_t bitsLeft, uint8_t *buf, int32_t bitOffset);
 int32_t DequantBlock(int32_t *inbuf, int32_t *outbuf, int32_t num, int32_t scale);
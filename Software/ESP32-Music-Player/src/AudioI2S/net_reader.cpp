@@ -0,0 +1,144 @@
+/*
+ * net_reader.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "net_reader.h"
+#include "codec_mem.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+NetReader::NetReader() {}
+//----------------------------------------------------------------------------------------------------------------------
+NetReader::~NetReader() {
+    end();
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool NetReader::begin(WiFiClient* client) {
+    end();
+    m_size = psramFound() ? AUDIO_NET_READER_BUFFER : AUDIO_NET_READER_BUFFER / 4;
+    m_buffer = (uint8_t*)CodecMem_Alloc(m_size, CODEC_MEM_COLD, "net reader");
+    if(!m_buffer) { log_e("net reader: not enough memory"); return false; }
+    m_client = client;
+    m_writeIdx = 0;
+    m_readIdx = 0;
+    m_lastArrival = 0;
+    m_gapAvg = 0;
+    m_jitter = 0;
+    m_maxGap = 0;
+    m_rate = 0;
+    m_target = AUDIO_NET_READER_MIN_DEPTH;
+    m_rateBytes = 0;
+    m_rateStart = millis();
+    m_f_stop = false;
+    m_f_taskRunning = true;
+    if(xTaskCreate(taskEntry, "AudioNetReader", AUDIO_NET_READER_STACK, this, AUDIO_NET_READER_PRIO, &m_task) != pdPASS) {
+        log_e("net reader: can't create task");
+        m_task = NULL;
+        m_f_taskRunning = false;
+        end();
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void NetReader::end() {
+    if(m_task) {
+        m_f_stop = true;
+        xTaskNotifyGive(m_task);
+        while(m_f_taskRunning) vTaskDelay(1); // a read in flight has to finish first
+        m_task = NULL;
+    }
+    if(m_buffer) { free(m_buffer); m_buffer = NULL; }
+    m_client = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t NetReader::available() {
+    if(!m_task) return 0;
+    size_t wr = m_writeIdx.load(std::memory_order_acquire);
+    size_t rd = m_readIdx.load(std::memory_order_relaxed);
+    return (wr >= rd) ? wr - rd : m_size - rd + wr;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t NetReader::read(uint8_t* buf, size_t len) {
+    size_t bytes = 0;
+    if(!m_task) return 0;
+    size_t wr = m_writeIdx.load(std::memory_order_acquire);
+    size_t rd = m_readIdx.load(std::memory_order_relaxed);
+    while(len && rd != wr) {
+        size_t n = min(len, (wr > rd) ? wr - rd : m_size - rd); // contiguous part
+        memcpy(buf, m_buffer + rd, n);
+        buf += n;
+        len -= n;
+        bytes += n;
+        rd += n;
+        if(rd == m_size) rd = 0;
+    }
+    m_readIdx.store(rd, std::memory_order_release);
+    if(bytes) xTaskNotifyGive(m_task); // there is space again
+    return bytes;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int NetReader::read() {
+    uint8_t b;
+    if(read(&b, 1) != 1) return -1;
+    return b;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void NetReader::taskEntry(void* param) {
+    ((NetReader*)param)->taskLoop();
+    vTaskDelete(NULL);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void NetReader::taskLoop() {
+    while(!m_f_stop) {
+        size_t wr = m_writeIdx.load(std::memory_order_relaxed);
+        size_t rd = m_readIdx.load(std::memory_order_acquire);
+        size_t space = (rd > wr) ? rd - wr - 1 : m_size - wr - (rd == 0 ? 1 : 0); // contiguous, one byte stays free
+        if(!space) { // buffer full, the gap until the next read is not the network's fault
+            m_lastArrival = 0;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+            continue;
+        }
+        int avail = m_client->available();
+        if(avail <= 0) {
+            vTaskDelay(1);
+            continue;
+        }
+        int n = m_client->read(m_buffer + wr, min(space, (size_t)avail));
+        if(n <= 0) continue;
+        measure(n);
+        wr += n;
+        if(wr == m_size) wr = 0;
+        m_writeIdx.store(wr, std::memory_order_release);
+    }
+    log_d("net reader: %lu bytes of the stack unused", (long unsigned)uxTaskGetStackHighWaterMark(NULL));
+    m_f_taskRunning = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void NetReader::measure(uint32_t bytes) {
+    // inter-arrival gap and jitter as running means (1/16 as in RFC 3550), throughput over windows of one second
+    uint32_t now = micros();
+    if(m_lastArrival) {
+        uint32_t gap = now - m_lastArrival;
+        int32_t  d = (int32_t)gap - (int32_t)m_gapAvg;
+        m_gapAvg += d / 16;
+        m_jitter += ((int32_t)abs(d) - (int32_t)m_jitter) / 16;
+        m_maxGap = max(gap, m_maxGap - m_maxGap / 1024);
+    }
+    m_lastArrival = now;
+    m_rateBytes += bytes;
+    uint32_t ms = millis() - m_rateStart;
+    if(ms >= 1000) {
+        uint32_t rate = (uint64_t)m_rateBytes * 1000 / ms;
+        rate = m_rate ? (m_rate * 3 + rate) / 4 : rate;
+        m_rateBytes = 0;
+        m_rateStart = millis();
+        // the consumer reads rate and target, not the running means they come from
+        uint32_t holdUs = max(m_gapAvg + 4 * m_jitter, m_maxGap) + 200000; // plus 200ms for the scheduler and the decoder
+        uint32_t target = (uint64_t)rate * holdUs / 1000000;
+        target = max(target, (uint32_t)AUDIO_NET_READER_MIN_DEPTH);
+        m_target = min(target, (uint32_t)(m_size * 3 / 4));
+        m_rate = rate;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * net_reader.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Receives a web stream in its own task, so that WiFi hiccups are absorbed by a jitter buffer instead of hitting
+ * Audio::loop() and the decoder. The task moves the raw socket data (chunk framing and ICY metadata included) into a
+ * ring, Audio::processWebStream() parses it from there without waiting on the socket.
+ * The task measures the inter-arrival time of the received blocks and the throughput and turns them once a second
+ * into the fill level that covers the observed stalls: rate * (mean gap + 4 * jitter or the longest recent stall).
+ * getRate() and getTargetDepth() return these results, they can be called from any task.
+ * For https the client is a WiFiClientSecure, mbedtls_ssl_read() decrypts the records on the stack of this task, hence
+ * the 8 KB stack. The unused part is logged (log level debug) when the task ends.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <WiFi.h>
+#include <atomic>
+
+#ifndef AUDIO_NET_READER
+  #define AUDIO_NET_READER          1            // 0: Audio reads the socket in loop() as before
+#endif
+#ifndef AUDIO_NET_READER_BUFFER
+  #define AUDIO_NET_READER_BUFFER   (64 * 1024)  // jitter buffer with PSRAM, a quarter of it without
+#endif
+#ifndef AUDIO_NET_READER_MIN_DEPTH
+  #define AUDIO_NET_READER_MIN_DEPTH 8192        // target depth before the first throughput measurement
+#endif
+#ifndef AUDIO_NET_READER_STACK
+  #define AUDIO_NET_READER_STACK    8192         // bytes, TLS needs the stack
+#endif
+#ifndef AUDIO_NET_READER_PRIO
+  #define AUDIO_NET_READER_PRIO     2            // above the Arduino loop task
+#endif
+
+class NetReader {
+
+public:
+    NetReader();
+    ~NetReader();
+    bool     begin(WiFiClient* client);       // starts the task, the client must not be read elsewhere until end()
+    void     end();                           // stops the task, buffered data is dropped
+    bool     isActive() { return m_task != NULL; }
+    size_t   available();                     // bytes in the jitter buffer
+    size_t   read(uint8_t* buf, size_t len);  // buffered bytes only, does not wait
+    int      read();                          // one byte, -1 if the buffer is empty
+    uint32_t getTargetDepth() { return m_target; } // fill level that covers the measured jitter, in bytes
+    uint32_t getRate() { return m_rate; }     // measured throughput in bytes/s
+
+private:
+    static void      taskEntry(void* param);
+    void             taskLoop();
+    void             measure(uint32_t bytes);
+
+    WiFiClient*          m_client = NULL;
+    TaskHandle_t         m_task = NULL;
+    uint8_t*             m_buffer = NULL;
+    size_t               m_size = 0;
+    std::atomic<size_t>  m_writeIdx{0};       // written by the task only
+    std::atomic<size_t>  m_readIdx{0};        // written by the consumer only
+    uint32_t             m_lastArrival = 0;   // µs, 0: no reference (start, buffer was full)
+    uint32_t             m_gapAvg = 0;        // µs, mean time between two received blocks
+    uint32_t             m_jitter = 0;        // µs, mean deviation from m_gapAvg
+    uint32_t             m_maxGap = 0;        // µs, longest recent stall, decays slowly
+    std::atomic<uint32_t> m_rate{0};          // bytes/s, the results are written by the task only
+    std::atomic<uint32_t> m_target{AUDIO_NET_READER_MIN_DEPTH}; // from the measurements above
+    uint32_t             m_rateBytes = 0;     // bytes received in the current measurement window
+    uint32_t             m_rateStart = 0;     // ms, begin of the window
+    volatile bool        m_f_stop = false;
+    volatile bool        m_f_taskRunning = false;
+};
@@ -31,22 +31,12 @@
    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ----------------------------------------------------------------------------------------------------------------------*/
 
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_OPUS
+
 #include "celt.h"
 #include "opus_decoder.h"
-
-CELTDecoder  *s_celtDec;
-band_ctx_t    s_band_ctx;
-ec_ctx_t      s_ec;
-int32_t*      s_freqBuff;           // mem in celt_synthesis
-int32_t*      s_iyBuff;             // mem in alg_unquant
-int16_t*      s_normBuff;           // mem in quant_all_bands
-int16_t*      s_XBuff;              // mem in celt_decode_with_ec
-int32_t*      s_bits1Buff;          // mem in clt_compute_allocation
-int32_t*      s_bits2Buff;          // mem in clt_compute_allocation
-int32_t*      s_threshBuff;         // mem in clt_compute_allocation
-int32_t*      s_trim_offsetBuff;    // mem in clt_compute_allocation
-uint8_t*      s_collapse_masksBuff; // mem n celt_decode_with_ec
-int16_t*      s_tmpBuff;            // mem in deinterleave_hadamard and interleave_hadamard
+#include <new>
 
 const uint32_t CELT_GET_AND_CLEAR_ERROR_REQUEST = 10007;
 const uint32_t CELT_SET_CHANNELS_REQUEST        = 10008;
@@ -645,9 +635,21 @@ const mdct_lookup_t m_mdct_lookup = {
 
 const uint32_t row_idx[15] = {0, 176, 351, 525, 698, 870, 1041, 1131, 1178, 1207, 1226, 1240, 1248, 1254, 1257};
 
+// row pointers into the PVQ table, rebased to a DRAM copy of CELT_PVQ_U_DATA in CELTDecoder_AllocateBuffers()
+uint32_t* s_pvqUData = NULL;
+uint16_t  s_pvqUUsers = 0; // decoders holding s_pvqUData
+const uint32_t* s_pvqURow[15] = {
+    CELT_PVQ_U_DATA +    0, CELT_PVQ_U_DATA +  176, CELT_PVQ_U_DATA +  351, CELT_PVQ_U_DATA +  525,
+    CELT_PVQ_U_DATA +  698, CELT_PVQ_U_DATA +  870, CELT_PVQ_U_DATA + 1041, CELT_PVQ_U_DATA + 1131,
+    CELT_PVQ_U_DATA + 1178, CELT_PVQ_U_DATA + 1207, CELT_PVQ_U_DATA + 1226, CELT_PVQ_U_DATA + 1240,
+    CELT_PVQ_U_DATA + 1248, CELT_PVQ_U_DATA + 1254, CELT_PVQ_U_DATA + 1257};
+
+void celt_pvq_u_rebase(const uint32_t* data){
+    for(int32_t i = 0; i < 15; i++) s_pvqURow[i] = data + row_idx[i];
+}
+
 uint32_t celt_pvq_u_row(uint32_t row, uint32_t data){
-    uint32_t  ret = CELT_PVQ_U_DATA[row_idx[row] + data];
-    return ret;
+    return s_pvqURow[row][data];
 }
 
 #define DECODE_BUFFER_SIZE 2048
@@ -762,14 +764,14 @@ uint32_t extract_collapse_mask(int32_t *iy, int32_t N, int32_t B) {
 
 /** Decode pulse vector and combine the result with the pitch vector to produce
     the final normalised signal in the current band. */
-uint32_t alg_unquant(int16_t *X, int32_t N, int32_t K, int32_t spread, int32_t B, int16_t gain) {
+uint32_t alg_unquant(celt_ctx_t* celt, int16_t *X, int32_t N, int32_t K, int32_t spread, int32_t B, int16_t gain) {
     int32_t Ryy;
     uint32_t collapse_mask;
     if(K <= 0) log_e("alg_unquant() needs at least one pulse");
     if(N <= 1) log_e("alg_unquant() needs at least two dimensions");
 
-    int32_t* iy = s_iyBuff; assert(N <= 176);
-    Ryy = decode_pulses(iy, N, K);
+    int32_t* iy = celt->iyBuff; assert(N <= 176);
+    Ryy = decode_pulses(celt, iy, N, K);
     normalise_residual(iy, X, N, Ryy, gain);
     exp_rotation(X, N, -1, B, K, spread);
     collapse_mask = extract_collapse_mask(iy, N, B);
@@ -801,18 +803,31 @@ void renormalise_vector(int16_t *X, int32_t N, int16_t gain) {
 
 void comb_filter_const(int32_t *y, int32_t *x, int32_t T, int32_t N, int16_t g10, int16_t g11, int16_t g12) {
     int32_t x0, x1, x2, x3, x4;
-    int32_t i;
+    int32_t i, acc;
     x4 = x[-T - 2];
     x3 = x[-T - 1];
     x2 = x[-T];
     x1 = x[-T + 1];
-    for (i = 0; i < N; i++) {
+    if(g12 == 0) { // tapsets 1 and 2, the outer taps have no weight
+        for (i = 0; i < N; i++) {
+            x0 = x[i - T + 2];
+            acc  = x[i];
+            acc += MULT16_32_Q15(g10, x2);
+            acc += MULT16_32_Q15(g11, ADD32(x1, x3));
+            y[i] = SATURATE(acc, (300000000));
+            x3 = x2;
+            x2 = x1;
+            x1 = x0;
+        }
+        return;
+    }
+    for (i = 0; i < N; i++) { // accumulate in a register, y and x are the same buffer in most calls
         x0 = x[i - T + 2];
-        y[i]  = x[i];
-        y[i] += MULT16_32_Q15(g10, x2);
-        y[i] += MULT16_32_Q15(g11, ADD32(x1, x3));
-        y[i] += MULT16_32_Q15(g12, ADD32(x0, x4));
-        y[i] = SATURATE(y[i], (300000000));
+        acc  = x[i];
+        acc += MULT16_32_Q15(g10, x2);
+        acc += MULT16_32_Q15(g11, ADD32(x1, x3));
+        acc += MULT16_32_Q15(g12, ADD32(x0, x4));
+        y[i] = SATURATE(acc, (300000000));
         x4 = x3;
         x3 = x2;
         x2 = x1;
@@ -857,15 +872,16 @@ void comb_filter(int32_t *y, int32_t *x, int32_t T0, int32_t T1, int32_t N, int1
     for(i = 0; i < overlap; i++) {
         int16_t f;
         x0 = x[i - T1 + 2];
+        int32_t acc;
         f = MULT16_16_Q15(window120[i], window120[i]);
-        y[i] = x[i];
-        y[i] += MULT16_32_Q15(MULT16_16_Q15((32767 - f), g00), x[i - T0]);
-        y[i] += MULT16_32_Q15(MULT16_16_Q15((32767 - f), g01), ADD32(x[i - T0 + 1], x[i - T0 - 1]));
-        y[i] += MULT16_32_Q15(MULT16_16_Q15((32767 - f), g02), ADD32(x[i - T0 + 2], x[i - T0 - 2]));
-        y[i] += MULT16_32_Q15(MULT16_16_Q15(f, g10), x2);
-        y[i] += MULT16_32_Q15(MULT16_16_Q15(f, g11), ADD32(x1, x3));
-        y[i] += MULT16_32_Q15(MULT16_16_Q15(f, g12), ADD32(x0, x4));
-        y[i] = SATURATE(y[i], (300000000));
+        acc  = x[i];
+        acc += MULT16_32_Q15(MULT16_16_Q15((32767 - f), g00), x[i - T0]);
+        acc += MULT16_32_Q15(MULT16_16_Q15((32767 - f), g01), ADD32(x[i - T0 + 1], x[i - T0 - 1]));
+        acc += MULT16_32_Q15(MULT16_16_Q15((32767 - f), g02), ADD32(x[i - T0 + 2], x[i - T0 - 2]));
+        acc += MULT16_32_Q15(MULT16_16_Q15(f, g10), x2);
+        acc += MULT16_32_Q15(MULT16_16_Q15(f, g11), ADD32(x1, x3));
+        acc += MULT16_32_Q15(MULT16_16_Q15(f, g12), ADD32(x0, x4));
+        y[i] = SATURATE(acc, (300000000));
         x4 = x3;
         x3 = x2;
         x2 = x1;
@@ -1000,11 +1016,11 @@ void denormalise_bands(const int16_t * X, int32_t * freq,
 //----------------------------------------------------------------------------------------------------------------------
 
 /* This prevents energy collapse for transients with multiple short MDCTs */
-void anti_collapse(int16_t *X_, uint8_t *collapse_masks, int32_t LM, int32_t C, int32_t size,
+void anti_collapse(celt_ctx_t* celt, int16_t *X_, uint8_t *collapse_masks, int32_t LM, int32_t C, int32_t size,
                    const int16_t *logE, const int16_t *prev1logE, const int16_t *prev2logE, const int32_t *pulses,
                    uint32_t seed){
     int32_t c, i, j, k;
-    const uint8_t  end = s_celtDec->end;  // 21
+    const uint8_t  end = celt->st->end;  // 21
     for (i = 0; i < end; i++) {
         int32_t N0;
         int16_t thresh, sqrt_1;
@@ -1169,13 +1185,13 @@ static const int32_t ordery_table[] = {
 };
 //----------------------------------------------------------------------------------------------------------------------
 
-void deinterleave_hadamard(int16_t *X, int32_t N0, int32_t stride, int32_t hadamard){
+void deinterleave_hadamard(celt_ctx_t* celt, int16_t *X, int32_t N0, int32_t stride, int32_t hadamard){
     int32_t i, j;
     int32_t N;
     N = N0 * stride;
 
     assert(N <= 176);
-    int16_t* tmp = s_tmpBuff;
+    int16_t* tmp = celt->tmpBuff;
 
     assert(stride > 0);
     if (hadamard) {
@@ -1194,13 +1210,13 @@ void deinterleave_hadamard(int16_t *X, int32_t N0, int32_t stride, int32_t hadam
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void interleave_hadamard(int16_t *X, int32_t N0, int32_t stride, int32_t hadamard){
+void interleave_hadamard(celt_ctx_t* celt, int16_t *X, int32_t N0, int32_t stride, int32_t hadamard){
     int32_t i, j;
     int32_t N;
     N = N0 * stride;
 
     assert(N <= 176);
-    int16_t* tmp = s_tmpBuff;
+    int16_t* tmp = celt->tmpBuff;
 
     if (hadamard) {
         const int32_t *ordery = ordery_table + stride - 2;
@@ -1258,7 +1274,7 @@ int32_t compute_qn(int32_t N, int32_t b, int32_t offset, int32_t pulse_cap, int3
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, int32_t *b, int32_t B,
+void compute_theta(celt_ctx_t* celt, struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, int32_t *b, int32_t B,
                           int32_t __B0, int32_t LM, int32_t stereo, int32_t *fill) {
     int32_t qn;
     int32_t itheta = 0;
@@ -1271,8 +1287,8 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
     int32_t inv = 0;
     int32_t i;
     int32_t intensity;
-    i = s_band_ctx.i;
-    intensity = s_band_ctx.intensity;
+    i = celt->band_ctx.i;
+    intensity = celt->band_ctx.intensity;
 
     /* Decide on the resolution to give to the split parameter theta */
     pulse_cap = logN400[i] + LM * (1 << BITRES);
@@ -1280,7 +1296,7 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
     qn = compute_qn(N, *b, offset, pulse_cap, stereo);
     if (stereo && i >= intensity)
         qn = 1;
-    tell = ec_tell_frac();
+    tell = ec_tell_frac(celt);
     if (qn != 1) {
         /* Entropy coding of the angle. We use a uniform pdf for the time split, a step for stereo,
            and a triangular one for the rest. */
@@ -1292,18 +1308,18 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
             /* Use a probability of p0 up to itheta=8192 and then use 1 after */
 
             int32_t fs;
-            fs = ec_decode(ft);
+            fs = ec_decode(celt, ft);
             if (fs < (x0 + 1) * p0)
                 x = fs / p0;
             else
                 x = x0 + 1 + (fs - (x0 + 1) * p0);
-            ec_dec_update(x <= x0 ? p0 * x : (x - 1 - x0) + (x0 + 1) * p0, x <= x0 ? p0 * (x + 1) : (x - x0) + (x0 + 1) * p0, ft);
+            ec_dec_update(celt, x <= x0 ? p0 * x : (x - 1 - x0) + (x0 + 1) * p0, x <= x0 ? p0 * (x + 1) : (x - x0) + (x0 + 1) * p0, ft);
             itheta = x;
 
         }
         else if (__B0 > 1 || stereo) {
             /* Uniform pdf */
-            itheta = ec_dec_uint(qn + 1);
+            itheta = ec_dec_uint(celt, qn + 1);
         }
         else {
             int32_t fs = 1, ft;
@@ -1311,7 +1327,7 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
             /* Triangular pdf */
             int32_t fl = 0;
             int32_t fm;
-            fm = ec_decode(ft);
+            fm = ec_decode(celt, ft);
             if (fm < ((qn >> 1) * ((qn >> 1) + 1) >> 1))
             {
                 itheta = (isqrt32(8 * (uint32_t)fm + 1) - 1) >> 1;
@@ -1324,7 +1340,7 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
                 fs = qn + 1 - itheta;
                 fl = ft - ((qn + 1 - itheta) * (qn + 2 - itheta) >> 1);
             }
-            ec_dec_update(fl, fl + fs, ft);
+            ec_dec_update(celt, fl, fl + fs, ft);
 
         }
         assert(itheta >= 0);
@@ -1335,17 +1351,17 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
                  Let's do that at higher complexity */
     }
     else if (stereo) {
-        if (*b > 2 << BITRES && s_band_ctx.remaining_bits > 2 << BITRES) {
-            inv = ec_dec_bit_logp(2);
+        if (*b > 2 << BITRES && celt->band_ctx.remaining_bits > 2 << BITRES) {
+            inv = ec_dec_bit_logp(celt, 2);
         }
         else
             inv = 0;
         /* inv flag override to avoid problems with downmixing. */
-        if (s_band_ctx.disable_inv)
+        if (celt->band_ctx.disable_inv)
             inv = 0;
         itheta = 0;
     }
-    qalloc = ec_tell_frac() - tell;
+    qalloc = ec_tell_frac(celt) - tell;
     *b -= qalloc;
 
     if (itheta == 0) {
@@ -1377,7 +1393,7 @@ void compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, in
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-uint32_t quant_band_n1(int16_t *X, int16_t *Y, int32_t b,  int16_t *lowband_out) {
+uint32_t quant_band_n1(celt_ctx_t* celt, int16_t *X, int16_t *Y, int32_t b,  int16_t *lowband_out) {
 
     int32_t c;
     int32_t stereo;
@@ -1386,11 +1402,11 @@ uint32_t quant_band_n1(int16_t *X, int16_t *Y, int32_t b,  int16_t *lowband_out)
     stereo = Y != NULL;
     c = 0;
     do {
-        if (s_band_ctx.remaining_bits >= 1 << BITRES) {
-            s_band_ctx.remaining_bits -= 1 << BITRES;
+        if (celt->band_ctx.remaining_bits >= 1 << BITRES) {
+            celt->band_ctx.remaining_bits -= 1 << BITRES;
             b -= 1 << BITRES;
         }
-        if (s_band_ctx.resynth)
+        if (celt->band_ctx.resynth)
             x[0] = 16384;  // NORM_SCALING
         x = Y;
     } while (++c < 1 + stereo);
@@ -1403,7 +1419,7 @@ uint32_t quant_band_n1(int16_t *X, int16_t *Y, int32_t b,  int16_t *lowband_out)
 /* This function is responsible for encoding and decoding a mono partition. It can split the band in two and transmit
    the energy difference with the two half-bands. It can be called recursively so bands can end up being
    split in 8 parts. */
-uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM,
+uint32_t quant_partition(celt_ctx_t* celt, int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM,
                                 int16_t gain, int32_t fill){
     const uint8_t *cache;
     int32_t q;
@@ -1415,8 +1431,8 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
     int16_t *Y = NULL;
     int32_t i;
     int32_t spread;
-    i = s_band_ctx.i;
-    spread = s_band_ctx.spread;
+    i = celt->band_ctx.i;
+    spread = celt->band_ctx.spread;
 
     /* If we need 1.5 more bit than we can produce, split the band in two. */
     cache = cache_bits50 + cache_index50[(LM + 1) * m_CELTMode.nbEBands + i];
@@ -1435,7 +1451,7 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
             fill = (fill & 1) | (fill << 1);
         B = (B + 1) >> 1;
 
-        compute_theta(&sctx, X, Y, N, &b, B, _B0, LM, 0, &fill);
+        compute_theta(celt, &sctx, X, Y, N, &b, B, _B0, LM, 0, &fill);
         imid = sctx.imid;
         iside = sctx.iside;
         delta = sctx.delta;
@@ -1456,30 +1472,30 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
         }
         mbits = _max(0, _min(b, (b - delta) / 2));
         sbits = b - mbits;
-        s_band_ctx.remaining_bits -= qalloc;
+        celt->band_ctx.remaining_bits -= qalloc;
 
         if (lowband)
             next_lowband2 = lowband + N; /* >32-bit split case */
 
-        rebalance = s_band_ctx.remaining_bits;
+        rebalance = celt->band_ctx.remaining_bits;
         if (mbits >= sbits)  {
-            cm = quant_partition(X, N, mbits, B, lowband, LM,
+            cm = quant_partition(celt, X, N, mbits, B, lowband, LM,
                                  MULT16_16_P15(gain, mid), fill);
-            rebalance = mbits - (rebalance - s_band_ctx.remaining_bits);
+            rebalance = mbits - (rebalance - celt->band_ctx.remaining_bits);
             if (rebalance > 3 << BITRES && itheta != 0)
                 sbits += rebalance - (3 << BITRES);
-            cm |= quant_partition(Y, N, sbits, B, next_lowband2, LM,
+            cm |= quant_partition(celt, Y, N, sbits, B, next_lowband2, LM,
                                   MULT16_16_P15(gain, side), fill >> B)
                   << (_B0 >> 1);
         }
         else {
-            cm = quant_partition(Y, N, sbits, B, next_lowband2, LM,
+            cm = quant_partition(celt, Y, N, sbits, B, next_lowband2, LM,
                                  MULT16_16_P15(gain, side), fill >> B)
                  << (_B0 >> 1);
-            rebalance = sbits - (rebalance - s_band_ctx.remaining_bits);
+            rebalance = sbits - (rebalance - celt->band_ctx.remaining_bits);
             if (rebalance > 3 << BITRES && itheta != 16384)
                 mbits += rebalance - (3 << BITRES);
-            cm |= quant_partition(X, N, mbits, B, lowband, LM,
+            cm |= quant_partition(celt, X, N, mbits, B, lowband, LM,
                                   MULT16_16_P15(gain, mid), fill);
         }
     }
@@ -1487,27 +1503,27 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
         /* This is the basic no-split case */
         q = bits2pulses(i, LM, b);
         curr_bits = pulses2bits(i, LM, q);
-        s_band_ctx.remaining_bits -= curr_bits;
+        celt->band_ctx.remaining_bits -= curr_bits;
 
         /* Ensures we can never bust the budget */
-        while (s_band_ctx.remaining_bits < 0 && q > 0) {
-            s_band_ctx.remaining_bits += curr_bits;
+        while (celt->band_ctx.remaining_bits < 0 && q > 0) {
+            celt->band_ctx.remaining_bits += curr_bits;
             q--;
             curr_bits = pulses2bits(i, LM, q);
-            s_band_ctx.remaining_bits -= curr_bits;
+            celt->band_ctx.remaining_bits -= curr_bits;
         }
 
         if (q != 0) {
             int32_t K = get_pulses(q);
 
             /* Finally do the actual quantization */
-            cm = alg_unquant(X, N, K, spread, B, gain);
+            cm = alg_unquant(celt, X, N, K, spread, B, gain);
 
         }
         else {
             /* If there's no pulse, fill the band anyway */
             int32_t j;
-            if (s_band_ctx.resynth)
+            if (celt->band_ctx.resynth)
             {
                 uint32_t cm_mask;
                 /* B can be as large as 16, so this shift might overflow an int32_t on a
@@ -1521,8 +1537,8 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
                     if (lowband == NULL) {
                         /* Noise */
                         for (j = 0; j < N; j++) {
-                            s_band_ctx.seed = celt_lcg_rand(s_band_ctx.seed);
-                            X[j] = (int16_t)((int32_t)s_band_ctx.seed >> 20);
+                            celt->band_ctx.seed = celt_lcg_rand(celt->band_ctx.seed);
+                            X[j] = (int16_t)((int32_t)celt->band_ctx.seed >> 20);
                         }
                         cm = cm_mask;
                     }
@@ -1530,10 +1546,10 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
                         /* Folded spectrum */
                         for (j = 0; j < N; j++) {
                             int16_t tmp;
-                            s_band_ctx.seed = celt_lcg_rand(s_band_ctx.seed);
+                            celt->band_ctx.seed = celt_lcg_rand(celt->band_ctx.seed);
                             /* About 48 dB below the "normal" folding level */
                             tmp = QCONST16(1.0f / 256, 10);
-                            tmp = (s_band_ctx.seed) & 0x8000 ? tmp : -tmp;
+                            tmp = (celt->band_ctx.seed) & 0x8000 ? tmp : -tmp;
                             X[j] = lowband[j] + tmp;
                         }
                         cm = fill;
@@ -1549,7 +1565,7 @@ uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *l
 //----------------------------------------------------------------------------------------------------------------------
 
 /* This function is responsible for encoding and decoding a band for the mono case. */
-uint32_t quant_band(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM,
+uint32_t quant_band(celt_ctx_t* celt, int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM,
                            int16_t *lowband_out, int16_t gain, int16_t *lowband_scratch, int32_t fill) {
     int32_t N0 = N;
     int32_t N_B = N;
@@ -1561,7 +1577,7 @@ uint32_t quant_band(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowban
     uint32_t cm = 0;
     int32_t k;
     int32_t tf_change;
-    tf_change = s_band_ctx.tf_change;
+    tf_change = celt->band_ctx.tf_change;
 
     longBlocks = _B0 == 1;
 
@@ -1570,7 +1586,7 @@ uint32_t quant_band(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowban
 
     /* Special case for one sample */
     if (N == 1) {
-        return quant_band_n1(X, NULL, b, lowband_out);
+        return quant_band_n1(celt, X, NULL, b, lowband_out);
     }
 
     if (tf_change > 0)
@@ -1608,15 +1624,15 @@ uint32_t quant_band(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowban
     /* Reorganize the samples in time order instead of frequency order */
     if (_B0 > 1) {
         if (lowband)
-            deinterleave_hadamard(lowband, N_B >> recombine, _B0 << recombine, longBlocks);
+            deinterleave_hadamard(celt, lowband, N_B >> recombine, _B0 << recombine, longBlocks);
     }
 
-    cm = quant_partition(X, N, b, B, lowband, LM, gain, fill);
+    cm = quant_partition(celt, X, N, b, B, lowband, LM, gain, fill);
 
-    if (s_band_ctx.resynth) {
+    if (celt->band_ctx.resynth) {
         /* Undo the sample reorganization going from time order to frequency order */
         if (_B0 > 1)
-            interleave_hadamard(X, N_B >> recombine, _B0 << recombine, longBlocks);
+            interleave_hadamard(celt, X, N_B >> recombine, _B0 << recombine, longBlocks);
 
         /* Undo time-freq changes that we did earlier */
         N_B = N__B0;
@@ -1652,7 +1668,7 @@ uint32_t quant_band(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowban
 //----------------------------------------------------------------------------------------------------------------------
 
 /* This function is responsible for encoding and decoding a band for the stereo case. */
-uint32_t quant_band_stereo(int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t B, int16_t *lowband,
+uint32_t quant_band_stereo(celt_ctx_t* celt, int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t B, int16_t *lowband,
                                   int32_t LM, int16_t *lowband_out, int16_t *lowband_scratch, int32_t fill) {
     int32_t imid = 0, iside = 0;
     int32_t inv = 0;
@@ -1666,12 +1682,12 @@ uint32_t quant_band_stereo(int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t
 
     /* Special case for one sample */
     if (N == 1){
-        return quant_band_n1(X, Y, b, lowband_out);
+        return quant_band_n1(celt, X, Y, b, lowband_out);
     }
 
     orig_fill = fill;
 
-    compute_theta(&sctx, X, Y, N, &b, B, B, LM, 1, &fill);
+    compute_theta(celt, &sctx, X, Y, N, &b, B, B, LM, 1, &fill);
     inv = sctx.inv;
     imid = sctx.imid;
     iside = sctx.iside;
@@ -1696,23 +1712,23 @@ uint32_t quant_band_stereo(int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t
             sbits = 1 << BITRES;
         mbits -= sbits;
         c = itheta > 8192;
-        s_band_ctx.remaining_bits -= qalloc + sbits;
+        celt->band_ctx.remaining_bits -= qalloc + sbits;
 
         x2 = c ? Y : X;
         y2 = c ? X : Y;
         if (sbits) {
-            sign = ec_dec_bits(1);
+            sign = ec_dec_bits(celt, 1);
         }
         sign = 1 - 2 * sign;
         /* We use orig_fill here because we want to fold the side, but if
            itheta==16384, we'll have cleared the low bits of fill. */
-        cm = quant_band(x2, N, mbits, B, lowband, LM, lowband_out, 32767,
+        cm = quant_band(celt, x2, N, mbits, B, lowband, LM, lowband_out, 32767,
                         lowband_scratch, orig_fill);
         /* We don't split N=2 bands, so cm is either 1 or 0 (for a fold-collapse),
            and there's no need to worry about mixing with the other channel. */
         y2[0] = -sign * x2[1];
         y2[1] = sign * x2[0];
-        if (s_band_ctx.resynth) {
+        if (celt->band_ctx.resynth) {
             int16_t tmp;
             X[0] = MULT16_16_Q15(mid, X[0]);
             X[1] = MULT16_16_Q15(mid, X[1]);
@@ -1732,36 +1748,36 @@ uint32_t quant_band_stereo(int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t
 
         mbits = _max(0, _min(b, (b - delta) / 2));
         sbits = b - mbits;
-        s_band_ctx.remaining_bits -= qalloc;
+        celt->band_ctx.remaining_bits -= qalloc;
 
-        rebalance = s_band_ctx.remaining_bits;
+        rebalance = celt->band_ctx.remaining_bits;
         if (mbits >= sbits) {
             /* In stereo mode, we do not apply a scaling to the mid because we need the normalized
                mid for folding later. */
-            cm = quant_band(X, N, mbits, B, lowband, LM, lowband_out, 32767,
+            cm = quant_band(celt, X, N, mbits, B, lowband, LM, lowband_out, 32767,
                             lowband_scratch, fill);
-            rebalance = mbits - (rebalance - s_band_ctx.remaining_bits);
+            rebalance = mbits - (rebalance - celt->band_ctx.remaining_bits);
             if (rebalance > 3 << BITRES && itheta != 0)
                 sbits += rebalance - (3 << BITRES);
 
             /* For a stereo split, the high bits of fill are always zero, so no
                folding will be done to the side. */
-            cm |= quant_band(Y, N, sbits, B, NULL, LM, NULL, side, NULL, fill >> B);
+            cm |= quant_band(celt, Y, N, sbits, B, NULL, LM, NULL, side, NULL, fill >> B);
         }
         else {
             /* For a stereo split, the high bits of fill are always zero, so no
                folding will be done to the side. */
-            cm = quant_band(Y, N, sbits, B, NULL, LM, NULL, side, NULL, fill >> B);
-            rebalance = sbits - (rebalance - s_band_ctx.remaining_bits);
+            cm = quant_band(celt, Y, N, sbits, B, NULL, LM, NULL, side, NULL, fill >> B);
+            rebalance = sbits - (rebalance - celt->band_ctx.remaining_bits);
             if (rebalance > 3 << BITRES && itheta != 16384)
                 mbits += rebalance - (3 << BITRES);
             /* In stereo mode, we do not apply a scaling to the mid because we need the normalized
                mid for folding later. */
-            cm |= quant_band(X, N, mbits, B, lowband, LM, lowband_out, 32767,
+            cm |= quant_band(celt, X, N, mbits, B, lowband, LM, lowband_out, 32767,
                              lowband_scratch, fill);
         }
     }
-    if (s_band_ctx.resynth) {
+    if (celt->band_ctx.resynth) {
         if (N != 2)
             stereo_merge(X, Y, mid, N);
         if (inv)
@@ -1788,7 +1804,7 @@ void special_hybrid_folding(int16_t *norm, int16_t *norm2, int32_t M, int32_t du
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t *pulses,
+void quant_all_bands(celt_ctx_t* celt, int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t *pulses,
                      int32_t shortBlocks, int32_t spread,
                      int32_t dual_stereo, int32_t intensity, int32_t *tf_res, int32_t total_bits, int32_t balance,
                      int32_t LM, int32_t codedBands){
@@ -1805,8 +1821,8 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
     int32_t C = Y_ != NULL ? 2 : 1;
     int32_t norm_offset;
     int32_t resynth = 1;
-    const uint8_t end = s_celtDec->end;  // 21
-    uint8_t disable_inv = s_celtDec->disable_inv; // 1- mono, 0- stereo
+    const uint8_t end = celt->st->end;  // 21
+    uint8_t disable_inv = celt->st->disable_inv; // 1- mono, 0- stereo
 
     M = 1 << LM;
     B = shortBlocks ? M : 1;
@@ -1815,7 +1831,7 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
        output in that band. */
 
 //    assert(C * (M * eBands[m_CELTMode.nbEBands - 1] - norm_offset) >= 1248);
-    norm = s_normBuff;
+    norm = celt->normBuff;
 
     norm2 = norm + M * eBands[m_CELTMode.nbEBands - 1] - norm_offset;
 
@@ -1826,15 +1842,15 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
     lowband_scratch = X_ + M * eBands[m_CELTMode.nbEBands - 1];
 
     lowband_offset = 0;
-    s_band_ctx.encode = 0;
-    s_band_ctx.intensity = intensity;
-    s_band_ctx.seed = 0;
-    s_band_ctx.spread = spread;
-    s_band_ctx.disable_inv = disable_inv; // 0 - stereo, 1 - mono
-    s_band_ctx.resynth = resynth;
-    s_band_ctx.theta_round = 0;
+    celt->band_ctx.encode = 0;
+    celt->band_ctx.intensity = intensity;
+    celt->band_ctx.seed = 0;
+    celt->band_ctx.spread = spread;
+    celt->band_ctx.disable_inv = disable_inv; // 0 - stereo, 1 - mono
+    celt->band_ctx.resynth = resynth;
+    celt->band_ctx.theta_round = 0;
     /* Avoid injecting noise in the first band on transients. */
-    s_band_ctx.avoid_split_noise = B > 1;
+    celt->band_ctx.avoid_split_noise = B > 1;
     for (i = 0; i < end; i++){
         int32_t tell;
         int32_t b;
@@ -1847,7 +1863,7 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
         uint32_t y_cm;
         int32_t last;
 
-        s_band_ctx.i = i;
+        celt->band_ctx.i = i;
         last = (i == end - 1);
 
         X = X_ + M * eBands[i];
@@ -1857,13 +1873,13 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
             Y = NULL;
         N = M * eBands[i + 1] - M * eBands[i];
         assert(N > 0);
-        tell = ec_tell_frac();
+        tell = ec_tell_frac(celt);
 
         /* Compute how many bits we want to allocate to this band */
         if (i != 0)
             balance -= tell;
         remaining_bits = total_bits - tell - 1;
-        s_band_ctx.remaining_bits = remaining_bits;
+        celt->band_ctx.remaining_bits = remaining_bits;
         if (i <= codedBands - 1){
             curr_balance = celt_sudiv(balance, _min(3, codedBands - i));
             b = _max(0, _min(16383, _min(remaining_bits + 1, pulses[i] + curr_balance)));
@@ -1878,7 +1894,7 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
             special_hybrid_folding(norm, norm2, M, dual_stereo);
 
         tf_change = tf_res[i];
-        s_band_ctx.tf_change = tf_change;
+        celt->band_ctx.tf_change = tf_change;
         if (i >= m_CELTMode.effEBands) {
             X = norm;
             if (Y_ != NULL)
@@ -1926,23 +1942,23 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
                     norm[j] = HALF32(norm[j] + norm2[j]);
         }
         if (dual_stereo) {
-            x_cm = quant_band(X, N, b / 2, B,
+            x_cm = quant_band(celt, X, N, b / 2, B,
                               effective_lowband != -1 ? norm + effective_lowband : NULL, LM,
                               last ? NULL : norm + M * eBands[i] - norm_offset, 32767, lowband_scratch, x_cm);
-            y_cm = quant_band(Y, N, b / 2, B,
+            y_cm = quant_band(celt, Y, N, b / 2, B,
                               effective_lowband != -1 ? norm2 + effective_lowband : NULL, LM,
                               last ? NULL : norm2 + M * eBands[i] - norm_offset, 32767, lowband_scratch, y_cm);
         }
         else {
             if (Y != NULL) {
-                s_band_ctx.theta_round = 0;
-                x_cm = quant_band_stereo(X, Y, N, b, B,
+                celt->band_ctx.theta_round = 0;
+                x_cm = quant_band_stereo(celt, X, Y, N, b, B,
                                     effective_lowband != -1 ? norm + effective_lowband : NULL, LM,
                                     last ? NULL : norm + M * eBands[i] - norm_offset, lowband_scratch, x_cm | y_cm);
 
             }
             else {
-                x_cm = quant_band(X, N, b, B,
+                x_cm = quant_band(celt, X, N, b, B,
                                   effective_lowband != -1 ? norm + effective_lowband : NULL, LM,
                                   last ? NULL : norm + M * eBands[i] - norm_offset, 32767, lowband_scratch, x_cm | y_cm);
             }
@@ -1956,112 +1972,123 @@ void quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t
         update_lowband = b > (N << BITRES);
         /* We only need to avoid noise on a split for the first band. After that, we
            have folding. */
-        s_band_ctx.avoid_split_noise = 0;
+        celt->band_ctx.avoid_split_noise = 0;
     }
 
 }
 //----------------------------------------------------------------------------------------------------------------------
 
 int32_t celt_decoder_get_size(int32_t channels){
-    static int32_t size;
-    size = sizeof(struct CELTDecoder) + (channels * (DECODE_BUFFER_SIZE + m_CELTMode.overlap) - 1) * sizeof(int32_t)
+    int32_t size = sizeof(struct CELTDecoder) + (channels * (DECODE_BUFFER_SIZE + m_CELTMode.overlap) - 1) * sizeof(int32_t)
            + channels * 24 * sizeof(int16_t) + 4 * 2 * m_CELTMode.nbEBands * sizeof(int16_t);
     return size;
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t celt_decoder_init(int32_t channels){
+int32_t celt_decoder_init(celt_ctx_t* celt, int32_t channels){
     // allocate buffers first
     if (channels < 0 || channels > 2){
         return ERR_OPUS_CHANNELS_OUT_OF_RANGE;
     }
-    if (s_celtDec == NULL){
+    if (celt->st == NULL){
         return ERR_OPUS_CELT_ALLOC_FAIL;
     }
 
     int32_t n = celt_decoder_get_size(channels);
-    memset(s_celtDec, 0, n * sizeof(char));
-
-    s_celtDec->channels = channels;
-    if(channels == 1) s_celtDec->disable_inv = 1; else s_celtDec->disable_inv = 0; // 1 mono ,  0 stereo
-    s_celtDec->end = s_celtDec->mode->effEBands; // 21
-    s_celtDec->error = 0;
-    s_celtDec->mode = &m_CELTMode;
-    s_celtDec->overlap = m_CELTMode.overlap;
-
-    s_celtDec->postfilter_gain = 0;
-    s_celtDec->postfilter_gain_old = 0;
-
-    s_celtDec->postfilter_period = 0;
-    s_celtDec->postfilter_tapset = 0;
-    s_celtDec->postfilter_tapset_old = 0;
-    s_celtDec->preemph_memD[0] = 0;
-    s_celtDec->preemph_memD[1] = 0;
-    s_celtDec->rng = 0;
-    s_celtDec->signalling = 1;
-    s_celtDec->start = 0;
-    s_celtDec->stream_channels = channels;
-    s_celtDec->_decode_mem[0] = 0;
-    s_celtDec->end = s_celtDec->mode->effEBands; // 21
-
-    int32_t ret = celt_decoder_ctl(OPUS_RESET_STATE);
+    memset(celt->st, 0, n * sizeof(char));
+
+    celt->st->channels = channels;
+    if(channels == 1) celt->st->disable_inv = 1; else celt->st->disable_inv = 0; // 1 mono ,  0 stereo
+    celt->st->end = celt->st->mode->effEBands; // 21
+    celt->st->error = 0;
+    celt->st->mode = &m_CELTMode;
+    celt->st->overlap = m_CELTMode.overlap;
+
+    celt->st->postfilter_gain = 0;
+    celt->st->postfilter_gain_old = 0;
+
+    celt->st->postfilter_period = 0;
+    celt->st->postfilter_tapset = 0;
+    celt->st->postfilter_tapset_old = 0;
+    celt->st->preemph_memD[0] = 0;
+    celt->st->preemph_memD[1] = 0;
+    celt->st->rng = 0;
+    celt->st->signalling = 1;
+    celt->st->start = 0;
+    celt->st->stream_channels = channels;
+    celt->st->_decode_mem[0] = 0;
+    celt->st->end = celt->st->mode->effEBands; // 21
+
+    int32_t ret = celt_decoder_ctl(celt, OPUS_RESET_STATE);
     if(ret < 0) return ret;
     return ERR_OPUS_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-// save stack arrays in heap, prefer PSRAM
-#ifdef BOARD_HAS_PSRAM
-    #define __heap_caps_malloc(size) heap_caps_malloc(size, MALLOC_CAP_SPIRAM)
-#else
-    #define __heap_caps_malloc(size) heap_caps_malloc(size, MALLOC_CAP_DEFAULT)
-#endif
+celt_ctx_t* CELTDecoder_Create(){ // the CELT part of an OPUSDecoder_t, buffers come with CELTDecoder_AllocateBuffers()
+    celt_ctx_t* celt = new (std::nothrow) celt_ctx_t;
+    if(!celt) log_e("not enough memory to allocate a celtdecoder context");
+    return celt;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void CELTDecoder_Destroy(celt_ctx_t* celt){
+    if(!celt) return;
+    CELTDecoder_FreeBuffers(celt);
+    delete celt;
+}
+//----------------------------------------------------------------------------------------------------------------------
 
-bool CELTDecoder_AllocateBuffers(void) {
+// decoder state prefers PSRAM, buffers and tables of the inner loops (band decoding, PVQ, imdct) prefer DRAM
+bool CELTDecoder_AllocateBuffers(celt_ctx_t* celt) {
     size_t omd = celt_decoder_get_size(2);
-    if(!s_celtDec)              {s_celtDec = (CELTDecoder*)       __heap_caps_malloc(omd);}
-    if(!s_freqBuff)             {s_freqBuff = (int32_t*)          __heap_caps_malloc(960  * sizeof(int32_t));}
-    if(!s_iyBuff)               {s_iyBuff = (int32_t*)            __heap_caps_malloc(176  * sizeof(int32_t));}
-    if(!s_normBuff)             {s_normBuff = (int16_t*)          __heap_caps_malloc(1248 * sizeof(int16_t));}
-    if(!s_XBuff)                {s_XBuff = (int16_t*)             __heap_caps_malloc(1920 * sizeof(int16_t));}
-    if(!s_bits1Buff)            {s_bits1Buff = (int32_t*)         __heap_caps_malloc(21   * sizeof(int32_t));}
-    if(!s_bits2Buff)            {s_bits2Buff = (int32_t*)         __heap_caps_malloc(21   * sizeof(int32_t));}
-    if(!s_threshBuff)           {s_threshBuff = (int32_t*)        __heap_caps_malloc(21   * sizeof(int32_t));}
-    if(!s_trim_offsetBuff)      {s_trim_offsetBuff = (int32_t*)   __heap_caps_malloc(21   * sizeof(int32_t));}
-    if(!s_collapse_masksBuff)   {s_collapse_masksBuff = (uint8_t*)__heap_caps_malloc(42   * sizeof(uint8_t));}
-    if(!s_tmpBuff)              {s_tmpBuff = (int16_t*)           __heap_caps_malloc(176  * sizeof(int16_t));}
-
-    if(!s_celtDec) {
-        CELTDecoder_FreeBuffers();
+    if(!celt->st)                 {celt->st = (CELTDecoder*)                 CodecMem_Alloc(omd, CODEC_MEM_COLD, "celt state");}
+    if(!celt->freqBuff)           {celt->freqBuff = (int32_t*)               CodecMem_Alloc(960  * sizeof(int32_t), CODEC_MEM_HOT, "celt freq");}
+    if(!celt->iyBuff)             {celt->iyBuff = (int32_t*)                 CodecMem_Alloc(176  * sizeof(int32_t), CODEC_MEM_HOT, "celt pvq");}
+    if(!celt->normBuff)           {celt->normBuff = (int16_t*)               CodecMem_Alloc(1248 * sizeof(int16_t), CODEC_MEM_HOT, "celt norm");}
+    if(!celt->XBuff)              {celt->XBuff = (int16_t*)                  CodecMem_Alloc(1920 * sizeof(int16_t), CODEC_MEM_HOT, "celt X");}
+    if(!celt->bits1Buff)          {celt->bits1Buff = (int32_t*)              CodecMem_Alloc(21   * sizeof(int32_t), CODEC_MEM_HOT, "celt alloc");}
+    if(!celt->bits2Buff)          {celt->bits2Buff = (int32_t*)              CodecMem_Alloc(21   * sizeof(int32_t), CODEC_MEM_HOT, "celt alloc");}
+    if(!celt->threshBuff)         {celt->threshBuff = (int32_t*)             CodecMem_Alloc(21   * sizeof(int32_t), CODEC_MEM_HOT, "celt alloc");}
+    if(!celt->trim_offsetBuff)    {celt->trim_offsetBuff = (int32_t*)        CodecMem_Alloc(21   * sizeof(int32_t), CODEC_MEM_HOT, "celt alloc");}
+    if(!celt->collapse_masksBuff) {celt->collapse_masksBuff = (uint8_t*)     CodecMem_Alloc(42   * sizeof(uint8_t), CODEC_MEM_HOT, "celt alloc");}
+    if(!celt->tmpBuff)            {celt->tmpBuff = (int16_t*)                CodecMem_Alloc(176  * sizeof(int16_t), CODEC_MEM_HOT, "celt pvq");}
+    if(!celt->f_pvqUUser)         {celt->f_pvqUUser = true; // the DRAM copy of the PVQ table is read only and shared by all decoders
+                                   if(!s_pvqUUsers++) {s_pvqUData = (uint32_t*) CodecMem_Alloc(sizeof(CELT_PVQ_U_DATA), CODEC_MEM_DRAM, "celt pvq_u");
+                                   if(s_pvqUData) {memcpy(s_pvqUData, CELT_PVQ_U_DATA, sizeof(CELT_PVQ_U_DATA)); celt_pvq_u_rebase(s_pvqUData);}}}
+
+    if(!celt->st) {
+        CELTDecoder_FreeBuffers(celt);
         log_e("not enough memory to allocate celtdecoder buffers");
         return false;
     }
     return true;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void CELTDecoder_FreeBuffers(){
-    if(s_celtDec)            { free(s_celtDec);            s_celtDec =            NULL; }
-    if(s_freqBuff)           { free(s_freqBuff),           s_freqBuff =           NULL; }
-    if(s_iyBuff)             { free(s_iyBuff),             s_iyBuff =             NULL; }
-    if(s_normBuff)           { free(s_normBuff),           s_normBuff =           NULL; }
-    if(s_XBuff)              { free(s_XBuff),              s_XBuff =              NULL; }
-    if(s_bits1Buff)          { free(s_bits1Buff),          s_bits1Buff =          NULL; }
-    if(s_bits2Buff)          { free(s_bits2Buff),          s_bits2Buff =          NULL; }
-    if(s_threshBuff)         { free(s_threshBuff),         s_threshBuff =         NULL; }
-    if(s_trim_offsetBuff)    { free(s_trim_offsetBuff),    s_trim_offsetBuff =    NULL; }
-    if(s_collapse_masksBuff) { free(s_collapse_masksBuff), s_collapse_masksBuff = NULL; }
-    if(s_tmpBuff)            { free(s_tmpBuff),            s_tmpBuff =            NULL; }
+void CELTDecoder_FreeBuffers(celt_ctx_t* celt){
+    if(celt->st)                 { free(celt->st);                 celt->st =                 NULL; }
+    if(celt->freqBuff)           { free(celt->freqBuff),           celt->freqBuff =           NULL; }
+    if(celt->iyBuff)             { free(celt->iyBuff),             celt->iyBuff =             NULL; }
+    if(celt->normBuff)           { free(celt->normBuff),           celt->normBuff =           NULL; }
+    if(celt->XBuff)              { free(celt->XBuff),              celt->XBuff =              NULL; }
+    if(celt->bits1Buff)          { free(celt->bits1Buff),          celt->bits1Buff =          NULL; }
+    if(celt->bits2Buff)          { free(celt->bits2Buff),          celt->bits2Buff =          NULL; }
+    if(celt->threshBuff)         { free(celt->threshBuff),         celt->threshBuff =         NULL; }
+    if(celt->trim_offsetBuff)    { free(celt->trim_offsetBuff),    celt->trim_offsetBuff =    NULL; }
+    if(celt->collapse_masksBuff) { free(celt->collapse_masksBuff), celt->collapse_masksBuff = NULL; }
+    if(celt->tmpBuff)            { free(celt->tmpBuff),            celt->tmpBuff =            NULL; }
+    if(celt->f_pvqUUser)         { celt->f_pvqUUser = false; // the last decoder frees the PVQ table copy
+                                   if(!--s_pvqUUsers && s_pvqUData) { celt_pvq_u_rebase(CELT_PVQ_U_DATA); free(s_pvqUData), s_pvqUData = NULL; }}
 }
 //----------------------------------------------------------------------------------------------------------------------
-void CELTDecoder_ClearBuffer(void){
+void CELTDecoder_ClearBuffer(celt_ctx_t* celt){
     size_t omd = celt_decoder_get_size(2);
-    memset(s_celtDec, 0, omd * sizeof(char));
+    memset(celt->st, 0, omd * sizeof(char));
 }
 //----------------------------------------------------------------------------------------------------------------------
 
 /* Special case for stereo with no downsampling and no accumulation. This is quite common and we can make it faster by
    processing both channels in the same loop, reducing overhead due to the dependency loop in the IIR filter. */
-void deemphasis_stereo_simple(int32_t *in[], int16_t *pcm, int32_t N, const int16_t coef0, int32_t *mem) {
+CODEC_HOT_FUNC void deemphasis_stereo_simple(int32_t *in[], int16_t *pcm, int32_t N, const int16_t coef0, int32_t *mem) {
     int32_t * x0;
     int32_t * x1;
     int32_t m0, m1;
@@ -2084,14 +2111,14 @@ void deemphasis_stereo_simple(int32_t *in[], int16_t *pcm, int32_t N, const int1
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void deemphasis(int32_t *in[], int16_t *pcm, int32_t N) {
+void deemphasis(celt_ctx_t* celt, int32_t *in[], int16_t *pcm, int32_t N) {
     int32_t        c;
     int32_t        Nd;
     int32_t        apply_downsampling = 0;
     int16_t        coef0;
-    const int32_t  CC = s_celtDec->channels;
+    const int32_t  CC = celt->st->channels;
     const int16_t *coef = m_CELTMode.preemph;
-    int32_t       *mem = s_celtDec->preemph_memD;
+    int32_t       *mem = celt->st->preemph_memD;
 
     /* Short version for common case. */
     if(CC == 2) {
@@ -2128,7 +2155,7 @@ void deemphasis(int32_t *in[], int16_t *pcm, int32_t N) {
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void celt_synthesis(int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C,
+void celt_synthesis(celt_ctx_t* celt, int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C,
                     int32_t isTransient, int32_t LM, int32_t silence) {
     int32_t c, i;
     int32_t M;
@@ -2138,13 +2165,13 @@ void celt_synthesis(int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C
     int32_t shift;
     int32_t nbEBands;
     int32_t overlap;
-    const int32_t  CC = s_celtDec->channels;
-    const uint8_t effEnd = s_celtDec->end;  // 21
+    const int32_t  CC = celt->st->channels;
+    const uint8_t effEnd = celt->st->end;  // 21
 
     overlap = m_CELTMode.overlap;
     nbEBands = m_CELTMode.nbEBands;
     N = m_CELTMode.shortMdctSize << LM;
-    int32_t* freq = s_freqBuff; assert(N <= 960); /**< Interleaved signal MDCTs */
+    int32_t* freq = celt->freqBuff; assert(N <= 960); /**< Interleaved signal MDCTs */
     M = 1 << LM;
 
     if(isTransient) {
@@ -2194,25 +2221,25 @@ void celt_synthesis(int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void tf_decode(int32_t isTransient, int32_t *tf_res, int32_t LM){
+void tf_decode(celt_ctx_t* celt, int32_t isTransient, int32_t *tf_res, int32_t LM){
     int32_t i, curr, tf_select;
     int32_t tf_select_rsv;
     int32_t tf_changed;
     int32_t logp;
     uint32_t budget;
     uint32_t tell;
-    const uint8_t end = s_celtDec->end;
+    const uint8_t end = celt->st->end;
 
-    budget = s_ec.storage * 8;
-    tell = ec_tell();
+    budget = celt->ec.storage * 8;
+    tell = ec_tell(&celt->ec);
     logp = isTransient ? 2 : 4;
     tf_select_rsv = LM > 0 && tell + logp + 1 <= budget;
     budget -= tf_select_rsv;
     tf_changed = curr = 0;
     for (i = 0; i < end; i++) {
         if (tell + logp <= budget) {
-            curr ^= ec_dec_bit_logp(logp);
-            tell = ec_tell();
+            curr ^= ec_dec_bit_logp(celt, logp);
+            tell = ec_tell(&celt->ec);
             tf_changed |= curr;
         }
         tf_res[i] = curr;
@@ -2222,7 +2249,7 @@ void tf_decode(int32_t isTransient, int32_t *tf_res, int32_t LM){
     if (tf_select_rsv &&
         tf_select_table[LM][4 * isTransient + 0 + tf_changed] !=
             tf_select_table[LM][4 * isTransient + 2 + tf_changed]) {
-        tf_select = ec_dec_bit_logp(1);
+        tf_select = ec_dec_bit_logp(celt, 1);
     }
     for (i = 0; i < end; i++) {
         tf_res[i] = tf_select_table[LM][4 * isTransient + 2 * tf_select + tf_res[i]];
@@ -2230,7 +2257,7 @@ void tf_decode(int32_t isTransient, int32_t *tf_res, int32_t LM){
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
+int32_t celt_decode_with_ec(celt_ctx_t* celt, int16_t *outbuf, int32_t frame_size) {
 
     int32_t  c, i, N;
     int32_t  spread_decision;
@@ -2243,9 +2270,9 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
     int32_t        shortBlocks;
     int32_t        isTransient;
     int32_t        intra_ener;
-    const uint8_t  CC = s_celtDec->channels;
+    const uint8_t  CC = celt->st->channels;
     int32_t        LM, M;
-    const uint8_t  end = s_celtDec->end;  // 21
+    const uint8_t  end = celt->st->end;  // 21
     int32_t        codedBands;
     int32_t        alloc_trim;
     int32_t        postfilter_pitch;
@@ -2260,12 +2287,12 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
     int32_t        anti_collapse_rsv;
     int32_t        anti_collapse_on = 0;
     int32_t        silence;
-    const uint8_t  C = s_celtDec->stream_channels; // =channels=2
+    const uint8_t  C = celt->st->stream_channels; // =channels=2
     const uint8_t  nbEBands = m_CELTMode.nbEBands; // =21
     const uint8_t  overlap = m_CELTMode.overlap; // =120
     const int16_t *eBands = eband5ms;
 
-    lpc = (int16_t *)(s_celtDec->_decode_mem + (DECODE_BUFFER_SIZE + overlap) * CC);
+    lpc = (int16_t *)(celt->st->_decode_mem + (DECODE_BUFFER_SIZE + overlap) * CC);
     oldBandE = lpc + CC * 24;
     oldLogE = oldBandE + 2 * nbEBands;
     oldLogE2 = oldLogE + 2 * nbEBands;
@@ -2279,54 +2306,54 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
 
     M = 1 << LM; // LM=3 -> M = 8
 
-    if(s_ec.storage > 1275 || outbuf == NULL) {log_e("OPUS_BAD_ARG"); return ERR_OPUS_CELT_BAD_ARG;}
+    if(celt->ec.storage > 1275 || outbuf == NULL) {log_e("OPUS_BAD_ARG"); return ERR_OPUS_CELT_BAD_ARG;}
 
     N = M * m_CELTMode.shortMdctSize; // const m_CELTMode.shortMdctSize == 120, M == 8 -> N = 960
 
     c = 0;
     do {
-        decode_mem[c] = s_celtDec->_decode_mem + c * (DECODE_BUFFER_SIZE + overlap);
+        decode_mem[c] = celt->st->_decode_mem + c * (DECODE_BUFFER_SIZE + overlap);
         out_syn[c] = decode_mem[c] + DECODE_BUFFER_SIZE - N;
     } while(++c < CC);
 
-    if(s_ec.storage <= 1) {log_e("OPUS_BAD_ARG"); return ERR_OPUS_CELT_BAD_ARG;}
+    if(celt->ec.storage <= 1) {log_e("OPUS_BAD_ARG"); return ERR_OPUS_CELT_BAD_ARG;}
 
     if(C == 1) {
         for(i = 0; i < nbEBands; i++) oldBandE[i] = _max(oldBandE[i], oldBandE[nbEBands + i]);
     }
 
-    total_bits = s_ec.storage * 8;
-    tell = ec_tell();
+    total_bits = celt->ec.storage * 8;
+    tell = ec_tell(&celt->ec);
 
     if(tell >= total_bits) silence = 1;
     else if(tell == 1)
-        silence = ec_dec_bit_logp(15);
+        silence = ec_dec_bit_logp(celt, 15);
     else
         silence = 0;
     if(silence) {
         /* Pretend we've read all the remaining bits */
-        tell = s_ec.storage * 8;
-        s_ec.nbits_total += tell - ec_tell();
+        tell = celt->ec.storage * 8;
+        celt->ec.nbits_total += tell - ec_tell(&celt->ec);
     }
 
     postfilter_gain = 0;
     postfilter_pitch = 0;
     postfilter_tapset = 0;
     if(tell + 16 <= total_bits) {
-        if(ec_dec_bit_logp(1)) {
+        if(ec_dec_bit_logp(celt, 1)) {
             int32_t qg, octave;
-            octave = ec_dec_uint(6);
-            postfilter_pitch = (16 << octave) + ec_dec_bits(4 + octave) - 1;
-            qg = ec_dec_bits(3);
-            if(ec_tell() + 2 <= total_bits) postfilter_tapset = ec_dec_icdf(tapset_icdf, 2);
+            octave = ec_dec_uint(celt, 6);
+            postfilter_pitch = (16 << octave) + ec_dec_bits(celt, 4 + octave) - 1;
+            qg = ec_dec_bits(celt, 3);
+            if(ec_tell(&celt->ec) + 2 <= total_bits) postfilter_tapset = ec_dec_icdf(celt, tapset_icdf, 2);
             postfilter_gain = QCONST16(.09375f, 15) * (qg + 1);
         }
-        tell = ec_tell();
+        tell = ec_tell(&celt->ec);
     }
 
     if(LM > 0 && tell + 3 <= total_bits) {
-        isTransient = ec_dec_bit_logp(3);
-        tell = ec_tell();
+        isTransient = ec_dec_bit_logp(celt, 3);
+        tell = ec_tell(&celt->ec);
     } else
         isTransient = 0;
 
@@ -2335,16 +2362,16 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
         shortBlocks = 0;
 
     /* Decode the global flags (first symbols in the stream) */
-    intra_ener = tell + 3 <= total_bits ? ec_dec_bit_logp(3) : 0;
+    intra_ener = tell + 3 <= total_bits ? ec_dec_bit_logp(celt, 3) : 0;
     /* Get band energies */
-    unquant_coarse_energy(oldBandE, intra_ener, C, LM);
+    unquant_coarse_energy(celt, oldBandE, intra_ener, C, LM);
 
     int32_t tf_res[nbEBands];
-    tf_decode(isTransient, tf_res, LM);
+    tf_decode(celt, isTransient, tf_res, LM);
 
-    tell = ec_tell();
+    tell = ec_tell(&celt->ec);
     spread_decision = 2;  // SPREAD_NORMAL
-    if(tell + 4 <= total_bits) spread_decision = ec_dec_icdf(spread_icdf, 5);
+    if(tell + 4 <= total_bits) spread_decision = ec_dec_icdf(celt, spread_icdf, 5);
 
     int32_t cap[nbEBands];
     init_caps(cap, LM, C);
@@ -2352,7 +2379,7 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
     int32_t offsets[nbEBands];
     dynalloc_logp = 6;
     total_bits <<= BITRES;
-    tell = ec_tell_frac();
+    tell = ec_tell_frac(celt);
     for(i = 0; i < end; i++) {
         int32_t width, quanta;
         int32_t dynalloc_loop_logp;
@@ -2365,8 +2392,8 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
         boost = 0;
         while(tell + (dynalloc_loop_logp << BITRES) < total_bits && boost < cap[i]) {
             int32_t flag;
-            flag = ec_dec_bit_logp(dynalloc_loop_logp);
-            tell = ec_tell_frac();
+            flag = ec_dec_bit_logp(celt, dynalloc_loop_logp);
+            tell = ec_tell_frac(celt);
             if(!flag) break;
             boost += quanta;
             total_bits -= quanta;
@@ -2378,69 +2405,69 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
     }
 
     int32_t fine_quant[nbEBands];
-    alloc_trim = tell + (6 << BITRES) <= total_bits ? ec_dec_icdf(trim_icdf, 7) : 5;
+    alloc_trim = tell + (6 << BITRES) <= total_bits ? ec_dec_icdf(celt, trim_icdf, 7) : 5;
 
-    bits = (((int32_t)s_ec.storage * 8) << BITRES) - ec_tell_frac() - 1;
+    bits = (((int32_t)celt->ec.storage * 8) << BITRES) - ec_tell_frac(celt) - 1;
     anti_collapse_rsv = isTransient && LM >= 2 && bits >= ((LM + 2) << BITRES) ? (1 << BITRES) : 0;
     bits -= anti_collapse_rsv;
 
     int32_t pulses[nbEBands];
     int32_t fine_priority[nbEBands];
 
-    codedBands = clt_compute_allocation(offsets, cap, alloc_trim, &intensity, &dual_stereo, bits, &balance,
+    codedBands = clt_compute_allocation(celt, offsets, cap, alloc_trim, &intensity, &dual_stereo, bits, &balance,
                                         pulses, fine_quant, fine_priority, C, LM);
 
-    unquant_fine_energy(oldBandE, fine_quant, C);
+    unquant_fine_energy(celt, oldBandE, fine_quant, C);
 
     c = 0;
     do { OPUS_MOVE(decode_mem[c], decode_mem[c] + N, DECODE_BUFFER_SIZE - N + overlap / 2); } while(++c < CC);
 
     /* Decode fixed codebook */
     assert(C * nbEBands <= 42);
-    uint8_t* collapse_masks = s_collapse_masksBuff;
+    uint8_t* collapse_masks = celt->collapse_masksBuff;
 
     assert(C * N <= 1920);
-    int16_t* X = s_XBuff;
+    int16_t* X = celt->XBuff;
 
-    quant_all_bands(X, C == 2 ? X + N : NULL, collapse_masks, pulses, shortBlocks, spread_decision,
-                    dual_stereo, intensity, tf_res, s_ec.storage * (8 << BITRES) - anti_collapse_rsv, balance, LM, codedBands);
+    quant_all_bands(celt, X, C == 2 ? X + N : NULL, collapse_masks, pulses, shortBlocks, spread_decision,
+                    dual_stereo, intensity, tf_res, celt->ec.storage * (8 << BITRES) - anti_collapse_rsv, balance, LM, codedBands);
 
-    if(anti_collapse_rsv > 0) { anti_collapse_on = ec_dec_bits(1); }
+    if(anti_collapse_rsv > 0) { anti_collapse_on = ec_dec_bits(celt, 1); }
 
-    unquant_energy_finalise(oldBandE, fine_quant, fine_priority, s_ec.storage * 8 - ec_tell(), C);
+    unquant_energy_finalise(celt, oldBandE, fine_quant, fine_priority, celt->ec.storage * 8 - ec_tell(&celt->ec), C);
 
-    if(anti_collapse_on) anti_collapse(X, collapse_masks, LM, C, N, oldBandE, oldLogE, oldLogE2, pulses, s_celtDec->rng);
+    if(anti_collapse_on) anti_collapse(celt, X, collapse_masks, LM, C, N, oldBandE, oldLogE, oldLogE2, pulses, celt->st->rng);
 
     if(silence) {
         for(i = 0; i < C * nbEBands; i++) oldBandE[i] = -QCONST16(28.f, 10);
     }
 
-    celt_synthesis(X, out_syn, oldBandE, C, isTransient, LM, silence);
+    celt_synthesis(celt, X, out_syn, oldBandE, C, isTransient, LM, silence);
 
     c = 0;
     const uint8_t COMBFILTER_MINPERIOD = 15;
     do {
-        s_celtDec->postfilter_period = _max(s_celtDec->postfilter_period, COMBFILTER_MINPERIOD);
-        s_celtDec->postfilter_period_old = _max(s_celtDec->postfilter_period_old, COMBFILTER_MINPERIOD);
-        comb_filter(out_syn[c], out_syn[c], s_celtDec->postfilter_period_old, s_celtDec->postfilter_period,
-                    m_CELTMode.shortMdctSize, s_celtDec->postfilter_gain_old, s_celtDec->postfilter_gain,
-                    s_celtDec->postfilter_tapset_old, s_celtDec->postfilter_tapset);
+        celt->st->postfilter_period = _max(celt->st->postfilter_period, COMBFILTER_MINPERIOD);
+        celt->st->postfilter_period_old = _max(celt->st->postfilter_period_old, COMBFILTER_MINPERIOD);
+        comb_filter(out_syn[c], out_syn[c], celt->st->postfilter_period_old, celt->st->postfilter_period,
+                    m_CELTMode.shortMdctSize, celt->st->postfilter_gain_old, celt->st->postfilter_gain,
+                    celt->st->postfilter_tapset_old, celt->st->postfilter_tapset);
         if(LM != 0)
             comb_filter(out_syn[c] + m_CELTMode.shortMdctSize, out_syn[c] + m_CELTMode.shortMdctSize,
-                        s_celtDec->postfilter_period, postfilter_pitch, N - m_CELTMode.shortMdctSize, s_celtDec->postfilter_gain,
-                        postfilter_gain, s_celtDec->postfilter_tapset, postfilter_tapset);
+                        celt->st->postfilter_period, postfilter_pitch, N - m_CELTMode.shortMdctSize, celt->st->postfilter_gain,
+                        postfilter_gain, celt->st->postfilter_tapset, postfilter_tapset);
 
     } while(++c < CC);
-    s_celtDec->postfilter_period_old = s_celtDec->postfilter_period;
-    s_celtDec->postfilter_gain_old = s_celtDec->postfilter_gain;
-    s_celtDec->postfilter_tapset_old = s_celtDec->postfilter_tapset;
-    s_celtDec->postfilter_period = postfilter_pitch;
-    s_celtDec->postfilter_gain = postfilter_gain;
-    s_celtDec->postfilter_tapset = postfilter_tapset;
+    celt->st->postfilter_period_old = celt->st->postfilter_period;
+    celt->st->postfilter_gain_old = celt->st->postfilter_gain;
+    celt->st->postfilter_tapset_old = celt->st->postfilter_tapset;
+    celt->st->postfilter_period = postfilter_pitch;
+    celt->st->postfilter_gain = postfilter_gain;
+    celt->st->postfilter_tapset = postfilter_tapset;
     if(LM != 0) {
-        s_celtDec->postfilter_period_old = s_celtDec->postfilter_period;
-        s_celtDec->postfilter_gain_old = s_celtDec->postfilter_gain;
-        s_celtDec->postfilter_tapset_old = s_celtDec->postfilter_tapset;
+        celt->st->postfilter_period_old = celt->st->postfilter_period;
+        celt->st->postfilter_gain_old = celt->st->postfilter_gain;
+        celt->st->postfilter_tapset_old = celt->st->postfilter_tapset;
     }
 
     if(C == 1) memcpy(&oldBandE[nbEBands], oldBandE, nbEBands * sizeof(*oldBandE));
@@ -2467,61 +2494,61 @@ int32_t celt_decode_with_ec(int16_t *outbuf, int32_t frame_size) {
             oldLogE[c * nbEBands + i] = oldLogE2[c * nbEBands + i] = -QCONST16(28.f, 10);
         }
     } while(++c < 2);
-    s_celtDec->rng = 0; //dec->rng;
+    celt->st->rng = 0; //dec->rng;
 
-    deemphasis(out_syn, outbuf, N);
+    deemphasis(celt, out_syn, outbuf, N);
 
-    if(ec_tell() > 8 * s_ec.storage) return ERR_CELT_OPUS_INTERNAL_ERROR;
-    if(s_ec.error) s_celtDec->error = 1;
+    if(ec_tell(&celt->ec) > 8 * celt->ec.storage) return ERR_CELT_OPUS_INTERNAL_ERROR;
+    if(celt->ec.error) celt->st->error = 1;
 
     return frame_size;
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t celt_decoder_ctl(int32_t request, ...) {
+int32_t celt_decoder_ctl(celt_ctx_t* celt, int32_t request, ...) {
     va_list ap;
 
     va_start(ap, request);
     switch (request) {
         case CELT_SET_END_BAND_REQUEST: {
             int32_t value = va_arg(ap, int32_t);
-            if (value < 1 || value > s_celtDec->mode->nbEBands) {va_end(ap); return ERR_OPUS_CELT_END_BAND;}
-            s_celtDec->end = value;
+            if (value < 1 || value > celt->st->mode->nbEBands) {va_end(ap); return ERR_OPUS_CELT_END_BAND;}
+            celt->st->end = value;
         } break;
         case CELT_SET_CHANNELS_REQUEST: {
             int32_t value = va_arg(ap, int32_t);
             if (value < 1 || value > 2) {va_end(ap); return ERR_OPUS_CELT_SET_CHANNELS;}
-            s_celtDec->stream_channels = value;
+            celt->st->stream_channels = value;
         } break;
         case CELT_GET_AND_CLEAR_ERROR_REQUEST: {
             int32_t *value = va_arg(ap, int32_t *);
             if (value == NULL)  {va_end(ap); return ERR_OPUS_CELT_CLEAR_REQUEST;}
-            *value = s_celtDec->error;
-            s_celtDec->error = 0;
+            *value = celt->st->error;
+            celt->st->error = 0;
         } break;
         case OPUS_RESET_STATE: {
             int32_t i;
             int16_t *lpc, *oldBandE, *oldLogE, *oldLogE2;
-            lpc = (int16_t *)(s_celtDec->_decode_mem + (DECODE_BUFFER_SIZE + s_celtDec->overlap) * s_celtDec->channels);
-            oldBandE = lpc + s_celtDec->channels * 24;
-            oldLogE = oldBandE + 2 * s_celtDec->mode->nbEBands;
-            oldLogE2 = oldLogE + 2 * s_celtDec->mode->nbEBands;
+            lpc = (int16_t *)(celt->st->_decode_mem + (DECODE_BUFFER_SIZE + celt->st->overlap) * celt->st->channels);
+            oldBandE = lpc + celt->st->channels * 24;
+            oldLogE = oldBandE + 2 * celt->st->mode->nbEBands;
+            oldLogE2 = oldLogE + 2 * celt->st->mode->nbEBands;
 
-            int32_t n = celt_decoder_get_size(s_celtDec->channels);
-            char* dest   = (char*)&s_celtDec->rng;
-            char* offset = (char*)s_celtDec;
-            memset(dest, 0,  n - (dest - offset) * sizeof(s_celtDec));
+            int32_t n = celt_decoder_get_size(celt->st->channels);
+            char* dest   = (char*)&celt->st->rng;
+            char* offset = (char*)celt->st;
+            memset(dest, 0,  n - (dest - offset) * sizeof(celt->st));
 
-            for (i = 0; i < 2 * s_celtDec->mode->nbEBands; i++) oldLogE[i] = oldLogE2[i] = -QCONST16(28.f, 10);
+            for (i = 0; i < 2 * celt->st->mode->nbEBands; i++) oldLogE[i] = oldLogE2[i] = -QCONST16(28.f, 10);
         } break;
         case CELT_GET_MODE_REQUEST: {
             const CELTMode **value = va_arg(ap, const CELTMode **);
             if (value == 0){va_end(ap); return ERR_OPUS_CELT_GET_MODE_REQUEST;}
-            *value = s_celtDec->mode;
+            *value = celt->st->mode;
         } break;
         case CELT_SET_SIGNALLING_REQUEST: {
             int32_t value = va_arg(ap, int32_t);
-            s_celtDec->signalling = value;
+            celt->st->signalling = value;
         } break;
         default:
             va_end(ap);
@@ -2546,8 +2573,7 @@ int32_t cwrsi(int32_t _n, int32_t _k, uint32_t _i, int32_t *_y) {
         /*Lots of pulses case:*/
         if (_k >= _n) {
             const uint32_t *row;
-            //row = celt_pvq_u_row[_n];
-            row = &CELT_PVQ_U_DATA[row_idx[_n]];
+            row = s_pvqURow[_n];
 
             /*Are the pulses in this dimension negative?*/
             p = row[_k + 1];
@@ -2571,8 +2597,8 @@ int32_t cwrsi(int32_t _n, int32_t _k, uint32_t _i, int32_t *_y) {
         /*Lots of dimensions case:*/
         else {
             /*Are there any pulses in this dimension at all?*/
-            p = celt_pvq_u_row(_k, _n);
-            q = celt_pvq_u_row(_k + 1, _n);
+            p = s_pvqURow[_k][_n];
+            q = s_pvqURow[_k + 1][_n];
             if (p <= _i && _i < q) {
                 _i -= p;
                 *_y++ = 0;
@@ -2582,7 +2608,7 @@ int32_t cwrsi(int32_t _n, int32_t _k, uint32_t _i, int32_t *_y) {
                 _i -= q & s;
                 /*Count how many pulses were placed in this dimension.*/
                 k0 = _k;
-                do p = celt_pvq_u_row(--_k, _n);
+                do p = s_pvqURow[--_k][_n];
                 while (p > _i);
                 _i -= p;
                 val = (k0 - _k + s) ^ s;
@@ -2611,22 +2637,22 @@ int32_t cwrsi(int32_t _n, int32_t _k, uint32_t _i, int32_t *_y) {
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t decode_pulses(int32_t *_y, int32_t _n, int32_t _k) {
-    return cwrsi(_n, _k, ec_dec_uint(CELT_PVQ_V(_n, _k)), _y);
+int32_t decode_pulses(celt_ctx_t* celt, int32_t *_y, int32_t _n, int32_t _k) {
+    return cwrsi(_n, _k, ec_dec_uint(celt, CELT_PVQ_V(_n, _k)), _y);
 }
 //----------------------------------------------------------------------------------------------------------------------
 
 /* This is a faster version of ec_tell_frac() that takes advantage of the low (1/8 bit) resolution to use just a linear
    function followed by a lookup to determine the exact transition thresholds. */
-uint32_t ec_tell_frac() {
+uint32_t ec_tell_frac(celt_ctx_t* celt) {
     static const uint32_t correction[8] = {35733, 38967, 42495, 46340, 50535, 55109, 60097, 65535};
     uint32_t nbits;
     uint32_t r;
     int32_t l;
     uint32_t b;
-    nbits = s_ec.nbits_total << BITRES;
-    l = EC_ILOG(s_ec.rng);
-    r = s_ec.rng >> (l - 16);
+    nbits = celt->ec.nbits_total << BITRES;
+    l = EC_ILOG(celt->ec.rng);
+    r = celt->ec.rng >> (l - 16);
     b = (r >> 12) - 8;
     b += r > correction[b];
     l = (l << 3) + b;
@@ -2634,122 +2660,122 @@ uint32_t ec_tell_frac() {
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t ec_read_byte() { return s_ec.offs < s_ec.storage ? s_ec.buf[s_ec.offs++] : 0; }
+int32_t ec_read_byte(celt_ctx_t* celt) { return celt->ec.offs < celt->ec.storage ? celt->ec.buf[celt->ec.offs++] : 0; }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t ec_read_byte_from_end() {
-    return s_ec.end_offs < s_ec.storage ? s_ec.buf[s_ec.storage - ++(s_ec.end_offs)] : 0;
+int32_t ec_read_byte_from_end(celt_ctx_t* celt) {
+    return celt->ec.end_offs < celt->ec.storage ? celt->ec.buf[celt->ec.storage - ++(celt->ec.end_offs)] : 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
 
 /*Normalizes the contents of val and rng so that rng lies entirely in the high-order symbol.*/
-void ec_dec_normalize() {
+void ec_dec_normalize(celt_ctx_t* celt) {
     /*If the range is too small, rescale it and input some bits.*/
-    while (s_ec.rng <= EC_CODE_BOT) {
+    while (celt->ec.rng <= EC_CODE_BOT) {
         int32_t sym;
-        s_ec.nbits_total += EC_SYM_BITS;
-        s_ec.rng <<= EC_SYM_BITS;
+        celt->ec.nbits_total += EC_SYM_BITS;
+        celt->ec.rng <<= EC_SYM_BITS;
         /*Use up the remaining bits from our last symbol.*/
-        sym = s_ec.rem;
+        sym = celt->ec.rem;
         /*Read the next value from the input.*/
-        s_ec.rem = ec_read_byte();
+        celt->ec.rem = ec_read_byte(celt);
         /*Take the rest of the bits we need from this new symbol.*/
-        sym = (sym << EC_SYM_BITS | s_ec.rem) >> (EC_SYM_BITS - EC_CODE_EXTRA);
+        sym = (sym << EC_SYM_BITS | celt->ec.rem) >> (EC_SYM_BITS - EC_CODE_EXTRA);
         /*And subtract them from val, capped to be less than EC_CODE_TOP.*/
-        s_ec.val = ((s_ec.val << EC_SYM_BITS) + (EC_SYM_MAX & ~sym)) & (EC_CODE_TOP - 1);
+        celt->ec.val = ((celt->ec.val << EC_SYM_BITS) + (EC_SYM_MAX & ~sym)) & (EC_CODE_TOP - 1);
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void ec_dec_init(uint8_t *_buf, uint32_t _storage) {
-    s_ec.buf = _buf;
-    s_ec.storage = _storage;
-    s_ec.end_offs = 0;
-    s_ec.end_window = 0;
-    s_ec.nend_bits = 0;
-    s_ec.nbits_total = EC_CODE_BITS + 1 - ((EC_CODE_BITS - EC_CODE_EXTRA) / EC_SYM_BITS) * EC_SYM_BITS;
-    s_ec.offs = 0;
-    s_ec.rng = 1U << EC_CODE_EXTRA;
-    s_ec.rem = ec_read_byte();
-    s_ec.val = s_ec.rng - 1 - (s_ec.rem >> (EC_SYM_BITS - EC_CODE_EXTRA));
-    s_ec.error = 0;
+void ec_dec_init(celt_ctx_t* celt, uint8_t *_buf, uint32_t _storage) {
+    celt->ec.buf = _buf;
+    celt->ec.storage = _storage;
+    celt->ec.end_offs = 0;
+    celt->ec.end_window = 0;
+    celt->ec.nend_bits = 0;
+    celt->ec.nbits_total = EC_CODE_BITS + 1 - ((EC_CODE_BITS - EC_CODE_EXTRA) / EC_SYM_BITS) * EC_SYM_BITS;
+    celt->ec.offs = 0;
+    celt->ec.rng = 1U << EC_CODE_EXTRA;
+    celt->ec.rem = ec_read_byte(celt);
+    celt->ec.val = celt->ec.rng - 1 - (celt->ec.rem >> (EC_SYM_BITS - EC_CODE_EXTRA));
+    celt->ec.error = 0;
     /*Normalize the interval.*/
-    ec_dec_normalize();
+    ec_dec_normalize(celt);
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-uint32_t ec_decode(uint32_t _ft) {
+uint32_t ec_decode(celt_ctx_t* celt, uint32_t _ft) {
     uint32_t s;
     assert(_ft > 0);
-    s_ec.ext = s_ec.rng / _ft;
-    s = (uint32_t)(s_ec.val / s_ec.ext);
+    celt->ec.ext = celt->ec.rng / _ft;
+    s = (uint32_t)(celt->ec.val / celt->ec.ext);
     return _ft - EC_MINI(s + 1, _ft);
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-uint32_t ec_decode_bin(uint32_t _bits) {
+uint32_t ec_decode_bin(celt_ctx_t* celt, uint32_t _bits) {
     uint32_t s;
-    s_ec.ext = s_ec.rng >> _bits;
-    s = (uint32_t)(s_ec.val / s_ec.ext);
+    celt->ec.ext = celt->ec.rng >> _bits;
+    s = (uint32_t)(celt->ec.val / celt->ec.ext);
     return (1U << _bits) - EC_MINI(s + 1U, 1U << _bits);
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void ec_dec_update(uint32_t _fl, uint32_t _fh, uint32_t _ft) {
+void ec_dec_update(celt_ctx_t* celt, uint32_t _fl, uint32_t _fh, uint32_t _ft) {
     uint32_t s;
-    s = s_ec.ext *  (_ft - _fh);
-    s_ec.val -= s;
+    s = celt->ec.ext *  (_ft - _fh);
+    celt->ec.val -= s;
 
     if(_fl > 0){
-        s_ec.rng = s_ec.ext * (_fh - _fl);
+        celt->ec.rng = celt->ec.ext * (_fh - _fl);
     }
     else{
-        s_ec.rng = s_ec.rng - s;
+        celt->ec.rng = celt->ec.rng - s;
     }
-    ec_dec_normalize();
+    ec_dec_normalize(celt);
 }
 //----------------------------------------------------------------------------------------------------------------------
 
 /*The probability of having a "one" is 1/(1<<_logp).*/
-int32_t ec_dec_bit_logp(uint32_t _logp) {
+int32_t ec_dec_bit_logp(celt_ctx_t* celt, uint32_t _logp) {
     uint32_t r;
     uint32_t d;
     uint32_t s;
     int32_t ret;
-    r = s_ec.rng;
-    d = s_ec.val;
+    r = celt->ec.rng;
+    d = celt->ec.val;
     s = r >> _logp;
     ret = d < s;
-    if (!ret) s_ec.val = d - s;
-    s_ec.rng = ret ? s : r - s;
-    ec_dec_normalize();
+    if (!ret) celt->ec.val = d - s;
+    celt->ec.rng = ret ? s : r - s;
+    ec_dec_normalize(celt);
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t ec_dec_icdf(const uint8_t *_icdf, uint32_t _ftb) {
+int32_t ec_dec_icdf(celt_ctx_t* celt, const uint8_t *_icdf, uint32_t _ftb) {
     uint32_t r;
     uint32_t d;
     uint32_t s;
     uint32_t t;
     int32_t ret;
-    s = s_ec.rng;
-    d = s_ec.val;
+    s = celt->ec.rng;
+    d = celt->ec.val;
     r = s >> _ftb;
     ret = -1;
     do {
         t = s;
         s = r * _icdf[++ret];
     } while (d < s);
-    s_ec.val = d - s;
-    s_ec.rng = t - s;
-    ec_dec_normalize();
+    celt->ec.val = d - s;
+    celt->ec.rng = t - s;
+    ec_dec_normalize(celt);
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-uint32_t ec_dec_uint(uint32_t _ft) {
+uint32_t ec_dec_uint(celt_ctx_t* celt, uint32_t _ft) {
     uint32_t ft;
     uint32_t s;
     int32_t ftb;
@@ -2761,39 +2787,39 @@ uint32_t ec_dec_uint(uint32_t _ft) {
         uint32_t t;
         ftb -= EC_UINT_BITS;
         ft = (uint32_t)(_ft >> ftb) + 1;
-        s = ec_decode(ft);
-        ec_dec_update(s, s + 1, ft);
-        t = (uint32_t)s << ftb | ec_dec_bits(ftb);
+        s = ec_decode(celt, ft);
+        ec_dec_update(celt, s, s + 1, ft);
+        t = (uint32_t)s << ftb | ec_dec_bits(celt, ftb);
         if (t <= _ft) return t;
-        s_ec.error = 1;
+        celt->ec.error = 1;
         return _ft;
     } else {
         _ft++;
-        s = ec_decode((uint32_t)_ft);
-        ec_dec_update(s, s + 1, (uint32_t)_ft);
+        s = ec_decode(celt, (uint32_t)_ft);
+        ec_dec_update(celt, s, s + 1, (uint32_t)_ft);
         return s;
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-uint32_t ec_dec_bits(uint32_t _bits) {
+uint32_t ec_dec_bits(celt_ctx_t* celt, uint32_t _bits) {
     uint32_t window;
     int32_t available;
     uint32_t ret;
-    window = s_ec.end_window;
-    available = s_ec.nend_bits;
+    window = celt->ec.end_window;
+    available = celt->ec.nend_bits;
     if ((uint32_t)available < _bits) {
         do {
-            window |= (uint32_t)ec_read_byte_from_end() << available;
+            window |= (uint32_t)ec_read_byte_from_end(celt) << available;
             available += EC_SYM_BITS;
         } while (available <= EC_WINDOW_SIZE - EC_SYM_BITS);
     }
     ret = (uint32_t)window & (((uint32_t)1 << _bits) - 1U);
     window >>= _bits;
     available -= _bits;
-    s_ec.end_window = window;
-    s_ec.nend_bits = available;
-    s_ec.nbits_total += _bits;
+    celt->ec.end_window = window;
+    celt->ec.nend_bits = available;
+    celt->ec.nbits_total += _bits;
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -3057,11 +3083,11 @@ uint32_t ec_laplace_get_freq1(uint32_t fs0, int32_t decay) {
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t ec_laplace_decode(uint32_t fs, int32_t decay) {
+int32_t ec_laplace_decode(celt_ctx_t* celt, uint32_t fs, int32_t decay) {
     int32_t val = 0;
     uint32_t fl;
     uint32_t fm;
-    fm = ec_decode_bin(15);
+    fm = ec_decode_bin(celt, 15);
     fl = 0;
     if (fm >= fs) {
         val++;
@@ -3091,7 +3117,7 @@ int32_t ec_laplace_decode(uint32_t fs, int32_t decay) {
     assert(fs > 0);
     assert(fl <= fm);
     assert(fm < _min(fl + fs, 32768));
-    ec_dec_update(fl, _min(fl + fs, 32768), 32768);
+    ec_dec_update(celt, fl, _min(fl + fs, 32768), 32768);
     return val;
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -3319,7 +3345,7 @@ void clt_mdct_backward(int32_t *in, int32_t * out, int32_t overlap, int32_t shif
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t interp_bits2pulses(int32_t end, int32_t skip_start, const int32_t *bits1, const int32_t *bits2,
+int32_t interp_bits2pulses(celt_ctx_t* celt, int32_t end, int32_t skip_start, const int32_t *bits1, const int32_t *bits2,
                            const int32_t *thresh, const int32_t *cap, int32_t total, int32_t *_balance,
                            int32_t skip_rsv, int32_t *intensity, int32_t intensity_rsv, int32_t *dual_stereo,
                            int32_t dual_stereo_rsv, int32_t *bits, int32_t *ebits, int32_t *fine_priority, int32_t C,
@@ -3406,7 +3432,7 @@ int32_t interp_bits2pulses(int32_t end, int32_t skip_start, const int32_t *bits1
           Otherwise it is force-skipped.
           This ensures that we have enough bits to code the skip flag.*/
         if(band_bits >= max(thresh[j], alloc_floor + (1 << BITRES))) {
-            if(ec_dec_bit_logp(1)) { break; }
+            if(ec_dec_bit_logp(celt, 1)) { break; }
             /*We used a bit to skip this band.*/
             psum += 1 << BITRES;
             band_bits -= 1 << BITRES;
@@ -3428,7 +3454,7 @@ int32_t interp_bits2pulses(int32_t end, int32_t skip_start, const int32_t *bits1
     assert(codedBands > 0);
     /* Code the intensity and dual stereo parameters. */
     if(intensity_rsv > 0) {
-        *intensity = ec_dec_uint(codedBands + 1);
+        *intensity = ec_dec_uint(celt, codedBands + 1);
     } else
         *intensity = 0;
     if(*intensity <= 0) {
@@ -3436,7 +3462,7 @@ int32_t interp_bits2pulses(int32_t end, int32_t skip_start, const int32_t *bits1
         dual_stereo_rsv = 0;
     }
     if(dual_stereo_rsv > 0) {
-        *dual_stereo = ec_dec_bit_logp(1);
+        *dual_stereo = ec_dec_bit_logp(celt, 1);
     } else
         *dual_stereo = 0;
 
@@ -3547,7 +3573,7 @@ int32_t interp_bits2pulses(int32_t end, int32_t skip_start, const int32_t *bits1
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t clt_compute_allocation(const int32_t *offsets, const int32_t *cap, int32_t alloc_trim,
+int32_t clt_compute_allocation(celt_ctx_t* celt, const int32_t *offsets, const int32_t *cap, int32_t alloc_trim,
                            int32_t *intensity, int32_t *dual_stereo, int32_t total, int32_t *balance, int32_t *pulses, int32_t *ebits,
                            int32_t *fine_priority, int32_t C, int32_t LM) {
     int32_t lo, hi, len, j;
@@ -3556,7 +3582,7 @@ int32_t clt_compute_allocation(const int32_t *offsets, const int32_t *cap, int32
     int32_t skip_rsv;
     int32_t intensity_rsv;
     int32_t dual_stereo_rsv;
-    const uint8_t end = s_celtDec->end;  // 21
+    const uint8_t end = celt->st->end;  // 21
 
     total = _max(total, 0);
     len = m_CELTMode.nbEBands; // =21
@@ -3577,10 +3603,10 @@ int32_t clt_compute_allocation(const int32_t *offsets, const int32_t *cap, int32
     }
 
     assert(len <= 21);
-    int32_t* bits1       = s_bits1Buff;
-    int32_t* bits2       = s_bits2Buff;
-    int32_t* thresh      = s_threshBuff;
-    int32_t* trim_offset = s_trim_offsetBuff;
+    int32_t* bits1       = celt->bits1Buff;
+    int32_t* bits2       = celt->bits2Buff;
+    int32_t* thresh      = celt->threshBuff;
+    int32_t* trim_offset = celt->trim_offsetBuff;
 
     for (j = 0; j < end; j++) {
         /* Below this threshold, we're sure not to allocate any PVQ bits */
@@ -3634,7 +3660,7 @@ int32_t clt_compute_allocation(const int32_t *offsets, const int32_t *cap, int32
         bits1[j] = bits1j;
         bits2[j] = bits2j;
     }
-    codedBands = interp_bits2pulses(end, skip_start, bits1, bits2, thresh, cap, total, balance, skip_rsv,
+    codedBands = interp_bits2pulses(celt, end, skip_start, bits1, bits2, thresh, cap, total, balance, skip_rsv,
                                     intensity, intensity_rsv, dual_stereo, dual_stereo_rsv, pulses, ebits,
                                     fine_priority, C, LM);
 
@@ -3642,7 +3668,7 @@ int32_t clt_compute_allocation(const int32_t *offsets, const int32_t *cap, int32
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void unquant_coarse_energy(int16_t *oldEBands, int32_t intra, int32_t C, int32_t LM) {
+void unquant_coarse_energy(celt_ctx_t* celt, int16_t *oldEBands, int32_t intra, int32_t C, int32_t LM) {
     const uint8_t *prob_model = e_prob_model[LM][intra];
     int32_t i, c;
     int32_t prev[2] = {0, 0};
@@ -3650,7 +3676,7 @@ void unquant_coarse_energy(int16_t *oldEBands, int32_t intra, int32_t C, int32_t
     int16_t beta;
     int32_t budget;
     int32_t tell;
-    const uint8_t end = s_celtDec->end;  // 21
+    const uint8_t end = celt->st->end;  // 21
 
     if (intra) {
         coef = 0;
@@ -3660,7 +3686,7 @@ void unquant_coarse_energy(int16_t *oldEBands, int32_t intra, int32_t C, int32_t
         coef = pred_coef[LM];
     }
 
-    budget = s_ec.storage * 8;
+    budget = celt->ec.storage * 8;
 
     /* Decode at a fixed coarse resolution */
     for (i = 0; i < end; i++) {
@@ -3673,16 +3699,16 @@ void unquant_coarse_energy(int16_t *oldEBands, int32_t intra, int32_t C, int32_t
                test on C at function entry, but that isn't enough
                to make the static analyzer happy. */
             assert(c < 2);
-            tell = ec_tell();
+            tell = ec_tell(&celt->ec);
             if (budget - tell >= 15) {
                 int32_t pi;
                 pi = 2 * _min(i, 20);
-                qi = ec_laplace_decode(prob_model[pi] << 7, prob_model[pi + 1] << 6);
+                qi = ec_laplace_decode(celt, prob_model[pi] << 7, prob_model[pi + 1] << 6);
             } else if (budget - tell >= 2) {
-                qi = ec_dec_icdf(small_energy_icdf, 2);
+                qi = ec_dec_icdf(celt, small_energy_icdf, 2);
                 qi = (qi >> 1) ^ -(qi & 1);
             } else if (budget - tell >= 1) {
-                qi = -ec_dec_bit_logp(1);
+                qi = -ec_dec_bit_logp(celt, 1);
             } else
                 qi = -1;
             q = (int32_t)SHL32(EXTEND32(qi), 10);
@@ -3697,9 +3723,9 @@ void unquant_coarse_energy(int16_t *oldEBands, int32_t intra, int32_t C, int32_t
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void unquant_fine_energy(int16_t *oldEBands, int32_t *fine_quant, int32_t C) {
+void unquant_fine_energy(celt_ctx_t* celt, int16_t *oldEBands, int32_t *fine_quant, int32_t C) {
     int32_t i, c;
-    const uint8_t end = s_celtDec->end;  // 21
+    const uint8_t end = celt->st->end;  // 21
     /* Decode finer resolution */
     for (i = 0; i < end; i++) {
         if (fine_quant[i] <= 0) continue;
@@ -3707,7 +3733,7 @@ void unquant_fine_energy(int16_t *oldEBands, int32_t *fine_quant, int32_t C) {
         do {
             int32_t q2;
             int16_t offset;
-            q2 = ec_dec_bits(fine_quant[i]);
+            q2 = ec_dec_bits(celt, fine_quant[i]);
             offset = SUB16(SHR32(SHL32(EXTEND32(q2), 10) + QCONST16(.5f, 10), fine_quant[i]),
                            QCONST16(.5f, 10));
             oldEBands[i + c * m_CELTMode.nbEBands] += offset;
@@ -3716,10 +3742,10 @@ void unquant_fine_energy(int16_t *oldEBands, int32_t *fine_quant, int32_t C) {
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-void unquant_energy_finalise(int16_t *oldEBands, int32_t *fine_quant,
+void unquant_energy_finalise(celt_ctx_t* celt, int16_t *oldEBands, int32_t *fine_quant,
                              int32_t *fine_priority, int32_t bits_left, int32_t C) {
     int32_t i, prio, c;
-    const uint8_t  end = s_celtDec->end;  // 21
+    const uint8_t  end = celt->st->end;  // 21
 
     /* Use up the remaining bits */
     for (prio = 0; prio < 2; prio++) {
@@ -3729,7 +3755,7 @@ void unquant_energy_finalise(int16_t *oldEBands, int32_t *fine_quant,
             do {
                 int32_t q2;
                 int16_t offset;
-                q2 = ec_dec_bits(1);
+                q2 = ec_dec_bits(celt, 1);
                 offset = SHR16(SHL16(q2, 10) - QCONST16(.5f, 10), fine_quant[i] + 1);
                 oldEBands[i + c * m_CELTMode.nbEBands] += offset;
                 bits_left--;
@@ -3738,3 +3764,4 @@ void unquant_energy_finalise(int16_t *oldEBands, int32_t *fine_quant,
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_OPUS
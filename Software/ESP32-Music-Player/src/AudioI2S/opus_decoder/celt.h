@@ -39,6 +39,7 @@
 #include <stdint.h>
 //#include <cstddef>
 #include <assert.h>
+#include "../codec_mem.h"
 
 #define OPUS_RESET_STATE             4028
 #define OPUS_GET_SAMPLE_RATE_REQUEST 4029
@@ -82,7 +83,6 @@ typedef struct _ec_ctx {
     int32_t  error; /*Nonzero if an error occurred.*/
 } ec_ctx_t;
 
-extern ec_ctx_t s_ec;
 extern const uint8_t cache_bits50[392];
 extern const int16_t cache_index50[105];
 
@@ -138,6 +138,23 @@ struct CELTDecoder {
                             /* int16_t backgroundLogE[], Size = 2*mode->nbEBands */
 };
 
+typedef struct celt_ctx { // CELT state of one Opus stream, see OPUSDecoder_t
+    CELTDecoder* st = NULL;
+    band_ctx_t   band_ctx = {};
+    ec_ctx_t     ec = {};
+    int32_t*     freqBuff = NULL;           // mem in celt_synthesis
+    int32_t*     iyBuff = NULL;             // mem in alg_unquant
+    int16_t*     normBuff = NULL;           // mem in quant_all_bands
+    int16_t*     XBuff = NULL;              // mem in celt_decode_with_ec
+    int32_t*     bits1Buff = NULL;          // mem in clt_compute_allocation
+    int32_t*     bits2Buff = NULL;          // mem in clt_compute_allocation
+    int32_t*     threshBuff = NULL;         // mem in clt_compute_allocation
+    int32_t*     trim_offsetBuff = NULL;    // mem in clt_compute_allocation
+    uint8_t*     collapse_masksBuff = NULL; // mem n celt_decode_with_ec
+    int16_t*     tmpBuff = NULL;            // mem in deinterleave_hadamard and interleave_hadamard
+    bool         f_pvqUUser = false;        // holds a reference to the shared DRAM copy of the PVQ table
+}celt_ctx_t;
+
 typedef struct {
     int32_t r;
     int32_t i;
@@ -354,8 +371,8 @@ inline int16_t sig2word16(int32_t x){
    return (int16_t)(x);
 }
 
-inline int32_t ec_tell(){
-  return s_ec.nbits_total-EC_ILOG(s_ec.rng);
+inline int32_t ec_tell(const ec_ctx_t* ec){
+  return ec->nbits_total-EC_ILOG(ec->rng);
 }
 
 /* Atan approximation using a 4th order polynomial. Input is in Q15 format and normalized by pi/4. Output is in
@@ -510,58 +527,58 @@ int16_t  bitexact_cos(int16_t x);
 int32_t  bitexact_log2tan(int32_t isin, int32_t icos);
 void     denormalise_bands(const int16_t *X, int32_t *freq, const int16_t *bandLogE, int32_t end, int32_t M,
                            int32_t silence);
-void     anti_collapse(int16_t *X_, uint8_t *collapse_masks, int32_t LM, int32_t C, int32_t size, const int16_t *logE,
+void     anti_collapse(celt_ctx_t* celt, int16_t *X_, uint8_t *collapse_masks, int32_t LM, int32_t C, int32_t size, const int16_t *logE,
                        const int16_t *prev1logE, const int16_t *prev2logE, const int32_t *pulses, uint32_t seed);
 void     compute_channel_weights(int32_t Ex, int32_t Ey, int16_t w[2]);
 void     stereo_split(int16_t *X, int16_t *Y, int32_t N);
 void     stereo_merge(int16_t *X, int16_t *Y, int16_t mid, int32_t N);
-void     deinterleave_hadamard(int16_t *X, int32_t N0, int32_t stride, int32_t hadamard);
-void     interleave_hadamard(int16_t *X, int32_t N0, int32_t stride, int32_t hadamard);
+void     deinterleave_hadamard(celt_ctx_t* celt, int16_t *X, int32_t N0, int32_t stride, int32_t hadamard);
+void     interleave_hadamard(celt_ctx_t* celt, int16_t *X, int32_t N0, int32_t stride, int32_t hadamard);
 void     haar1(int16_t *X, int32_t N0, int32_t stride);
 int32_t  compute_qn(int32_t N, int32_t b, int32_t offset, int32_t pulse_cap, int32_t stereo);
-void     compute_theta(struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, int32_t *b, int32_t B, int32_t __B0,
+void     compute_theta(celt_ctx_t* celt, struct split_ctx *sctx, int16_t *X, int16_t *Y, int32_t N, int32_t *b, int32_t B, int32_t __B0,
                        int32_t LM, int32_t stereo, int32_t *fill);
-uint32_t quant_band_n1(int16_t *X, int16_t *Y, int32_t b, int16_t *lowband_out);
-uint32_t quant_partition(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM, int16_t gain,
+uint32_t quant_band_n1(celt_ctx_t* celt, int16_t *X, int16_t *Y, int32_t b, int16_t *lowband_out);
+uint32_t quant_partition(celt_ctx_t* celt, int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM, int16_t gain,
                          int32_t fill);
-uint32_t quant_band(int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM, int16_t *lowband_out,
+uint32_t quant_band(celt_ctx_t* celt, int16_t *X, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM, int16_t *lowband_out,
                     int16_t gain, int16_t *lowband_scratch, int32_t fill);
-uint32_t quant_band_stereo(int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM,
+uint32_t quant_band_stereo(celt_ctx_t* celt, int16_t *X, int16_t *Y, int32_t N, int32_t b, int32_t B, int16_t *lowband, int32_t LM,
                            int16_t *lowband_out, int16_t *lowband_scratch, int32_t fill);
 void     special_hybrid_folding(int16_t *norm, int16_t *norm2, int32_t M, int32_t dual_stereo);
-void     quant_all_bands(int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t *pulses, int32_t shortBlocks,
+void     quant_all_bands(celt_ctx_t* celt, int16_t *X_, int16_t *Y_, uint8_t *collapse_masks, int32_t *pulses, int32_t shortBlocks,
                          int32_t spread, int32_t dual_stereo, int32_t intensity, int32_t *tf_res, int32_t total_bits,
                          int32_t balance, int32_t LM, int32_t codedBands);
 int32_t  celt_decoder_get_size(int32_t channels);
-int32_t  celt_decoder_init(int32_t channels);
+int32_t  celt_decoder_init(celt_ctx_t* celt, int32_t channels);
 void     deemphasis_stereo_simple(int32_t *in[], int16_t *pcm, int32_t N, const int16_t coef0, int32_t *mem);
-void     deemphasis(int32_t *in[], int16_t *pcm, int32_t N);
-void     celt_synthesis(int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C, int32_t isTransient, int32_t LM,
+void     deemphasis(celt_ctx_t* celt, int32_t *in[], int16_t *pcm, int32_t N);
+void     celt_synthesis(celt_ctx_t* celt, int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C, int32_t isTransient, int32_t LM,
                         int32_t silence);
-void     tf_decode(int32_t isTransient, int32_t *tf_res, int32_t LM);
-int32_t  celt_decode_with_ec(int16_t *outbuf, int32_t frame_size);
-int32_t  celt_decoder_ctl(int32_t request, ...);
+void     tf_decode(celt_ctx_t* celt, int32_t isTransient, int32_t *tf_res, int32_t LM);
+int32_t  celt_decode_with_ec(celt_ctx_t* celt, int16_t *outbuf, int32_t frame_size);
+int32_t  celt_decoder_ctl(celt_ctx_t* celt, int32_t request, ...);
 int32_t  cwrsi(int32_t _n, int32_t _k, uint32_t _i, int32_t *_y);
-int32_t  decode_pulses(int32_t *_y, int32_t _n, int32_t _k);
-uint32_t ec_tell_frac();
-int32_t  ec_read_byte();
-int32_t  ec_read_byte_from_end();
-void     ec_dec_normalize();
-void     ec_dec_init(uint8_t *_buf, uint32_t _storage);
-uint32_t ec_decode(uint32_t _ft);
-uint32_t ec_decode_bin(uint32_t _bits);
-void     ec_dec_update(uint32_t _fl, uint32_t _fh, uint32_t _ft);
-int32_t  ec_dec_bit_logp(uint32_t _logp);
-int32_t  ec_dec_icdf(const uint8_t *_icdf, uint32_t _ftb);
-uint32_t ec_dec_uint(uint32_t _ft);
-uint32_t ec_dec_bits(uint32_t _bits);
+int32_t  decode_pulses(celt_ctx_t* celt, int32_t *_y, int32_t _n, int32_t _k);
+uint32_t ec_tell_frac(celt_ctx_t* celt);
+int32_t  ec_read_byte(celt_ctx_t* celt);
+int32_t  ec_read_byte_from_end(celt_ctx_t* celt);
+void     ec_dec_normalize(celt_ctx_t* celt);
+void     ec_dec_init(celt_ctx_t* celt, uint8_t *_buf, uint32_t _storage);
+uint32_t ec_decode(celt_ctx_t* celt, uint32_t _ft);
+uint32_t ec_decode_bin(celt_ctx_t* celt, uint32_t _bits);
+void     ec_dec_update(celt_ctx_t* celt, uint32_t _fl, uint32_t _fh, uint32_t _ft);
+int32_t  ec_dec_bit_logp(celt_ctx_t* celt, uint32_t _logp);
+int32_t  ec_dec_icdf(celt_ctx_t* celt, const uint8_t *_icdf, uint32_t _ftb);
+uint32_t ec_dec_uint(celt_ctx_t* celt, uint32_t _ft);
+uint32_t ec_dec_bits(celt_ctx_t* celt, uint32_t _bits);
 void     kf_bfly2(kiss_fft_cpx *Fout, int32_t m, int32_t N);
 void     kf_bfly4(kiss_fft_cpx *Fout, const size_t fstride, const kiss_fft_state *st, int32_t m, int32_t N, int32_t mm);
 void     kf_bfly3(kiss_fft_cpx *Fout, const size_t fstride, const kiss_fft_state *st, int32_t m, int32_t N, int32_t mm);
 void     kf_bfly5(kiss_fft_cpx *Fout, const size_t fstride, const kiss_fft_state *st, int32_t m, int32_t N, int32_t mm);
 void     opus_fft_impl(const kiss_fft_state *st, kiss_fft_cpx *fout);
 uint32_t ec_laplace_get_freq1(uint32_t fs0, int32_t decay);
-int32_t  ec_laplace_decode(uint32_t fs, int32_t decay);
+int32_t  ec_laplace_decode(celt_ctx_t* celt, uint32_t fs, int32_t decay);
 uint32_t isqrt32(uint32_t _val);
 int16_t  celt_rsqrt_norm(int32_t x);
 int32_t  celt_sqrt(int32_t x);
@@ -572,23 +589,26 @@ void     exp_rotation1(int16_t *X, int32_t len, int32_t stride, int16_t c, int16
 void     exp_rotation(int16_t *X, int32_t len, int32_t dir, int32_t stride, int32_t K, int32_t spread);
 void     normalise_residual(int32_t *iy, int16_t *X, int32_t N, int32_t Ryy, int16_t gain);
 uint32_t extract_collapse_mask(int32_t *iy, int32_t N, int32_t B);
-uint32_t alg_unquant(int16_t *X, int32_t N, int32_t K, int32_t spread, int32_t B, int16_t gain);
+uint32_t alg_unquant(celt_ctx_t* celt, int16_t *X, int32_t N, int32_t K, int32_t spread, int32_t B, int16_t gain);
 void     renormalise_vector(int16_t *X, int32_t N, int16_t gain);
-int32_t  interp_bits2pulses(int32_t end, int32_t skip_start, const int32_t *bits1, const int32_t *bits2,
+int32_t  interp_bits2pulses(celt_ctx_t* celt, int32_t end, int32_t skip_start, const int32_t *bits1, const int32_t *bits2,
                             const int32_t *thresh, const int32_t *cap, int32_t total, int32_t *_balance,
                             int32_t skip_rsv, int32_t *intensity, int32_t intensity_rsv, int32_t *dual_stereo,
                             int32_t dual_stereo_rsv, int32_t *bits, int32_t *ebits, int32_t *fine_priority, int32_t C,
                             int32_t LM);
-int32_t  clt_compute_allocation(const int32_t *offsets, const int32_t *cap, int32_t alloc_trim, int32_t *intensity,
+int32_t  clt_compute_allocation(celt_ctx_t* celt, const int32_t *offsets, const int32_t *cap, int32_t alloc_trim, int32_t *intensity,
                                 int32_t *dual_stereo, int32_t total, int32_t *balance, int32_t *pulses, int32_t *ebits,
                                 int32_t *fine_priority, int32_t C, int32_t LM);
-void     unquant_coarse_energy(int16_t *oldEBands, int32_t intra, int32_t C, int32_t LM);
-void     unquant_fine_energy(int16_t *oldEBands, int32_t *fine_quant, int32_t C);
-void     unquant_energy_finalise(int16_t *oldEBands, int32_t *fine_quant, int32_t *fine_priority, int32_t bits_left,
+void     unquant_coarse_energy(celt_ctx_t* celt, int16_t *oldEBands, int32_t intra, int32_t C, int32_t LM);
+void     unquant_fine_energy(celt_ctx_t* celt, int16_t *oldEBands, int32_t *fine_quant, int32_t C);
+void     unquant_energy_finalise(celt_ctx_t* celt, int16_t *oldEBands, int32_t *fine_quant, int32_t *fine_priority, int32_t bits_left,
                                  int32_t C);
 uint32_t celt_pvq_u_row(uint32_t row, uint32_t data);
+void     celt_pvq_u_rebase(const uint32_t* data);
 
-bool     CELTDecoder_AllocateBuffers(void);
-void     CELTDecoder_FreeBuffers();
-void     CELTDecoder_ClearBuffer(void);
+celt_ctx_t* CELTDecoder_Create();
+void     CELTDecoder_Destroy(celt_ctx_t* celt);
+bool     CELTDecoder_AllocateBuffers(celt_ctx_t* celt);
+void     CELTDecoder_FreeBuffers(celt_ctx_t* celt);
+void     CELTDecoder_ClearBuffer(celt_ctx_t* celt);
 
@@ -8,10 +8,14 @@
 //----------------------------------------------------------------------------------------------------------------------
 //                                     O G G / O P U S     I M P L.
 //----------------------------------------------------------------------------------------------------------------------
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_OPUS
+
 #include "opus_decoder.h"
 #include "celt.h"
 #include "Arduino.h"
 #include <vector>
+#include <new>
 
 
 // global vars
@@ -23,51 +27,30 @@ const uint32_t CELT_GET_AND_CLEAR_ERROR_REQUEST = 10007;
 enum {OPUS_BANDWIDTH_NARROWBAND = 8000, OPUS_BANDWIDTH_MEDIUMBAND = 12000, OPUS_BANDWIDTH_WIDEBAND = 16000};
 enum {MODE_CELT_ONLY, MODE_SILK_ONLY, MODE_HYBRID};
 
-bool      s_f_opusParseOgg = false;
-bool      s_f_newSteamTitle = false;  // streamTitle
-bool      s_f_opusNewMetadataBlockPicture = false; // new metadata block picture
-bool      s_f_opusStereoFlag = false;
-bool      s_f_continuedPage = false;
-bool      s_f_firstPage = false;
-bool      s_f_lastPage = false;
-bool      s_f_nextChunk = false;
-
-uint8_t   s_opusChannels = 0;
-uint8_t   s_mode = 0;
-uint8_t   s_opusCountCode =  0;
-uint8_t   s_opusPageNr = 0;
-uint8_t   s_frameCount = 0;
-uint16_t  s_opusOggHeaderSize = 0;
-uint16_t  s_bandWidth = 0;
-uint32_t  s_opusSamplerate = 0;
-uint32_t  s_opusSegmentLength = 0;
-uint32_t  s_opusCurrentFilePos = 0;
-uint32_t  s_opusAudioDataStart = 0;
-int32_t   s_opusBlockPicLen = 0;
-int32_t   s_blockPicLenUntilFrameEnd = 0;
-int32_t   s_opusRemainBlockPicLen = 0;
-int32_t   s_opusCommentBlockSize = 0;
-uint32_t  s_opusBlockPicPos = 0;
-uint32_t  s_opusBlockLen = 0;
-char     *s_opusChbuf = NULL;
-int32_t   s_opusValidSamples = 0;
-
-uint16_t *s_opusSegmentTable;
-uint8_t   s_opusSegmentTableSize = 0;
-int16_t   s_opusSegmentTableRdPtr = -1;
-int8_t    s_opusError = 0;
-float     s_opusCompressionRatio = 0;
-
-std::vector <uint32_t>s_opusBlockPicItem;
-
-bool OPUSDecoder_AllocateBuffers(){
-    s_opusChbuf = (char*)malloc(512);
-    if(!CELTDecoder_AllocateBuffers()) {log_e("CELT not init"); return false;}
-    s_opusSegmentTable = (uint16_t*)malloc(256 * sizeof(uint16_t));
-    if(!s_opusSegmentTable) {log_e("CELT not init"); return false;}
-    OPUSDecoder_ClearBuffers();
+OPUSDecoder_t s_opusDefault; // the context of the codec registry
+
+OPUSDecoder_t* OPUSDecoder_Create(){ // a further, independent decoder, e.g. to probe or preroll a second stream
+    OPUSDecoder_t* dec = new (std::nothrow) OPUSDecoder_t;
+    if(!dec) log_e("not enough memory to allocate an opusdecoder context");
+    return dec;
+}
+void OPUSDecoder_Destroy(OPUSDecoder_t* dec){
+    if(!dec || dec == &s_opusDefault) return;
+    OPUSDecoder_FreeBuffers(dec);
+    delete dec;
+}
+OPUSDecoder_t* OPUSDecoder_Default(){
+    return &s_opusDefault;
+}
+bool OPUSDecoder_AllocateBuffers(OPUSDecoder_t* dec){
+    dec->chbuf = (char*)malloc(512);
+    if(!dec->celt) dec->celt = CELTDecoder_Create();
+    if(!dec->celt || !CELTDecoder_AllocateBuffers(dec->celt)) {log_e("CELT not init"); return false;}
+    dec->segmentTable = (uint16_t*)malloc(256 * sizeof(uint16_t));
+    if(!dec->segmentTable) {log_e("CELT not init"); return false;}
+    OPUSDecoder_ClearBuffers(dec);
     // allocate CELT buffers after OPUS head (nr of channels is needed)
-    OPUSsetDefaults();
+    OPUSsetDefaults(dec);
 
     int32_t ret = 0, silkDecSizeBytes = 0;
     (void) ret;
@@ -81,220 +64,219 @@ bool OPUSDecoder_AllocateBuffers(){
     }
     return true;
 }
-void OPUSDecoder_FreeBuffers(){
-    if(s_opusChbuf)        {free(s_opusChbuf);        s_opusChbuf = NULL;}
-    if(s_opusSegmentTable) {free(s_opusSegmentTable); s_opusSegmentTable = NULL;}
-    CELTDecoder_FreeBuffers();
+void OPUSDecoder_FreeBuffers(OPUSDecoder_t* dec){
+    if(dec->chbuf)        {free(dec->chbuf);        dec->chbuf = NULL;}
+    if(dec->segmentTable) {free(dec->segmentTable); dec->segmentTable = NULL;}
+    CELTDecoder_Destroy(dec->celt); dec->celt = NULL;
 }
-void OPUSDecoder_ClearBuffers(){
-    if(s_opusChbuf)        memset(s_opusChbuf, 0, 512);
-    if(s_opusSegmentTable) memset(s_opusSegmentTable, 0, 256 * sizeof(int16_t));
+void OPUSDecoder_ClearBuffers(OPUSDecoder_t* dec){
+    if(dec->chbuf)        memset(dec->chbuf, 0, 512);
+    if(dec->segmentTable) memset(dec->segmentTable, 0, 256 * sizeof(int16_t));
 }
-void OPUSsetDefaults(){
-    s_f_opusParseOgg = false;
-    s_f_newSteamTitle = false;  // streamTitle
-    s_f_opusNewMetadataBlockPicture = false;
-    s_f_opusStereoFlag = false;
-    s_opusChannels = 0;
-    s_frameCount = 0;
-    s_mode = 0;
-    s_opusSamplerate = 0;
-    s_bandWidth = 0;
-    s_opusSegmentLength = 0;
-    s_opusValidSamples = 0;
-    s_opusSegmentTableSize = 0;
-    s_opusOggHeaderSize = 0;
-    s_opusSegmentTableRdPtr = -1;
-    s_opusCountCode = 0;
-    s_opusBlockPicPos = 0;
-    s_opusCurrentFilePos = 0;
-    s_opusAudioDataStart = 0;
-    s_opusBlockPicLen = 0;
-    s_opusCommentBlockSize = 0;
-    s_opusRemainBlockPicLen = 0;
-    s_blockPicLenUntilFrameEnd = 0;
-    s_opusBlockLen = 0;
-    s_opusPageNr = 0;
-    s_opusError = 0;
-    s_opusBlockPicItem.clear(); s_opusBlockPicItem.shrink_to_fit();
+void OPUSsetDefaults(OPUSDecoder_t* dec){
+    dec->f_parseOgg = false;
+    dec->f_newSteamTitle = false;  // streamTitle
+    dec->f_newMetadataBlockPicture = false;
+    dec->f_stereoFlag = false;
+    dec->channels = 0;
+    dec->frameCount = 0;
+    dec->mode = 0;
+    dec->samplerate = 0;
+    dec->bandWidth = 0;
+    dec->preSkip = 0;
+    dec->segmentLength = 0;
+    dec->validSamples = 0;
+    dec->segmentTableSize = 0;
+    dec->oggHeaderSize = 0;
+    dec->segmentTableRdPtr = -1;
+    dec->countCode = 0;
+    dec->blockPicPos = 0;
+    dec->currentFilePos = 0;
+    dec->audioDataStart = 0;
+    dec->blockPicLen = 0;
+    dec->commentBlockSize = 0;
+    dec->remainBlockPicLen = 0;
+    dec->blockPicLenUntilFrameEnd = 0;
+    dec->blockLen = 0;
+    dec->pageNr = 0;
+    dec->error = 0;
+    dec->blockPicItem.clear(); dec->blockPicItem.shrink_to_fit();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t OPUSDecode(uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) {
+int32_t OPUSDecode(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) {
 
     int32_t ret = ERR_OPUS_NONE;
     int32_t segmLen = 0;
 
-    if(s_opusCommentBlockSize) {
-        if(s_opusCommentBlockSize > 8192) {
-            s_opusRemainBlockPicLen -= 8192;
+    if(dec->commentBlockSize) {
+        if(dec->commentBlockSize > 8192) {
+            dec->remainBlockPicLen -= 8192;
             *bytesLeft -= 8192;
-            s_opusCurrentFilePos += 8192;
-            s_opusCommentBlockSize -= 8192;
+            dec->currentFilePos += 8192;
+            dec->commentBlockSize -= 8192;
         }
         else {
-            s_opusRemainBlockPicLen -= s_opusCommentBlockSize;
-            *bytesLeft -= s_opusCommentBlockSize;
-            s_opusCurrentFilePos += s_opusCommentBlockSize;
-            s_opusCommentBlockSize = 0;
+            dec->remainBlockPicLen -= dec->commentBlockSize;
+            *bytesLeft -= dec->commentBlockSize;
+            dec->currentFilePos += dec->commentBlockSize;
+            dec->commentBlockSize = 0;
         }
-        if(s_opusRemainBlockPicLen <= 0) {
-            if(s_opusBlockPicItem.size() > 0) { // get blockpic data
+        if(dec->remainBlockPicLen <= 0) {
+            if(dec->blockPicItem.size() > 0) { // get blockpic data
                 // log_i("---------------------------------------------------------------------------");
                 // log_i("metadata blockpic found at pos %i, size %i bytes", s_vorbisBlockPicPos, s_vorbisBlockPicLen);
                 // for(int32_t i = 0; i < s_vorbisBlockPicItem.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, s_vorbisBlockPicItem[i], s_vorbisBlockPicItem[i + 1]); }
                 // log_i("---------------------------------------------------------------------------");
-                s_f_opusNewMetadataBlockPicture = true;
+                dec->f_newMetadataBlockPicture = true;
             }
         }
         return OPUS_PARSE_OGG_DONE;
     }
 
-    if(s_frameCount > 0) return opusDecodePage3(inbuf, bytesLeft, segmLen, outbuf); // decode audio, next part
+    if(dec->frameCount > 0) return opusDecodePage3(dec, inbuf, bytesLeft, segmLen, outbuf); // decode audio, next part
 
-    if(!s_opusSegmentTableSize) {
-        s_f_opusParseOgg = false;
-        s_opusCountCode = 0;
-        ret = OPUSparseOGG(inbuf, bytesLeft);
+    if(!dec->segmentTableSize) {
+        dec->f_parseOgg = false;
+        dec->countCode = 0;
+        ret = OPUSparseOGG(dec, inbuf, bytesLeft);
         if(ret != ERR_OPUS_NONE) return ret; // error
-        inbuf += s_opusOggHeaderSize;
+        inbuf += dec->oggHeaderSize;
     }
 
-    if(s_opusSegmentTableSize > 0) {
-        s_opusSegmentTableRdPtr++;
-        s_opusSegmentTableSize--;
-        segmLen = s_opusSegmentTable[s_opusSegmentTableRdPtr];
+    if(dec->segmentTableSize > 0) {
+        dec->segmentTableRdPtr++;
+        dec->segmentTableSize--;
+        segmLen = dec->segmentTable[dec->segmentTableRdPtr];
     }
 
-    if(s_opusPageNr == 0) { // OpusHead
-        ret = opusDecodePage0(inbuf, bytesLeft, segmLen);
+    if(dec->pageNr == 0) { // OpusHead
+        ret = opusDecodePage0(dec, inbuf, bytesLeft, segmLen);
     }
-    else if(s_opusPageNr == 1) { // OpusComment
-        ret = parseOpusComment(inbuf, segmLen);
+    else if(dec->pageNr == 1) { // OpusComment
+        ret = parseOpusComment(dec, inbuf, segmLen);
         if(ret == 0) log_e("OpusCommemtPage not found");
-        s_opusRemainBlockPicLen = s_opusBlockPicLen;
-        *bytesLeft -= (segmLen - s_blockPicLenUntilFrameEnd);
-        s_opusCommentBlockSize = s_blockPicLenUntilFrameEnd;
-        s_opusPageNr++;
+        dec->remainBlockPicLen = dec->blockPicLen;
+        *bytesLeft -= (segmLen - dec->blockPicLenUntilFrameEnd);
+        dec->commentBlockSize = dec->blockPicLenUntilFrameEnd;
+        dec->pageNr++;
         ret = OPUS_PARSE_OGG_DONE;
     }
-    else if(s_opusPageNr == 2) { // OpusComment Subsequent Pages
-        s_opusCommentBlockSize = segmLen;
-        if(s_opusRemainBlockPicLen <= segmLen) s_opusPageNr++;
+    else if(dec->pageNr == 2) { // OpusComment Subsequent Pages
+        dec->commentBlockSize = segmLen;
+        if(dec->remainBlockPicLen <= segmLen) dec->pageNr++;
         ;
         ret = OPUS_PARSE_OGG_DONE;
     }
-    else if(s_opusPageNr == 3) {
-        ret = opusDecodePage3(inbuf, bytesLeft, segmLen, outbuf); // decode audio
+    else if(dec->pageNr == 3) {
+        ret = opusDecodePage3(dec, inbuf, bytesLeft, segmLen, outbuf); // decode audio
     }
     else { ; }
 
-    if(s_opusSegmentTableSize == 0) {
-        s_opusSegmentTableRdPtr = -1; // back to the parking position
+    if(dec->segmentTableSize == 0) {
+        dec->segmentTableRdPtr = -1; // back to the parking position
     }
     return ret;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t opusDecodePage0(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
+int32_t opusDecodePage0(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
     int32_t ret = 0;
-    ret = parseOpusHead(inbuf, segmentLength);
+    ret = parseOpusHead(dec, inbuf, segmentLength);
     *bytesLeft           -= segmentLength;
-    s_opusCurrentFilePos += segmentLength;
-    if(ret == 1){ s_opusPageNr++;}
+    dec->currentFilePos += segmentLength;
+    if(ret == 1){ dec->pageNr++;}
     if(ret == 0){ log_e("OpusHead not found"); }
     return OPUS_PARSE_OGG_DONE;
 }
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t opusDecodePage3(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength, int16_t *outbuf){
+int32_t opusDecodePage3(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength, int16_t *outbuf){
 
-    if(s_opusAudioDataStart == 0){
-        s_opusAudioDataStart = s_opusCurrentFilePos;
+    if(dec->audioDataStart == 0){
+        dec->audioDataStart = dec->currentFilePos;
     }
 
 
     uint8_t endband = 21;
-    static int8_t configNr = 0;
-    static uint16_t samplesPerFrame = 0;
 
     int32_t ret = 0;
 
-    if(s_frameCount > 0) goto FramePacking; // more than one frame in the packet
+    if(dec->frameCount > 0) goto FramePacking; // more than one frame in the packet
 
-    configNr = parseOpusTOC(inbuf[0]);
-    if(configNr < 0) return configNr; // SILK or Hybrid mode
+    dec->configNr = parseOpusTOC(dec, inbuf[0]);
+    if(dec->configNr < 0) return dec->configNr; // SILK or Hybrid mode
 
-    switch(configNr){
+    switch(dec->configNr){
         case  0 ... 3:  endband  = 0; // OPUS_BANDWIDTH_SILK_NARROWBAND
-                        s_mode = MODE_SILK_ONLY;
-                        s_bandWidth = OPUS_BANDWIDTH_NARROWBAND;
+                        dec->mode = MODE_SILK_ONLY;
+                        dec->bandWidth = OPUS_BANDWIDTH_NARROWBAND;
                         break;
         case  4 ... 7:  endband  = 0; // OPUS_BANDWIDTH_SILK_MEDIUMBAND
-                        s_mode = MODE_SILK_ONLY;
-                        s_bandWidth = OPUS_BANDWIDTH_MEDIUMBAND;
+                        dec->mode = MODE_SILK_ONLY;
+                        dec->bandWidth = OPUS_BANDWIDTH_MEDIUMBAND;
                         break;
         case  8 ... 11: endband  = 0; // OPUS_BANDWIDTH_SILK_WIDEBAND
-                        s_mode = MODE_SILK_ONLY;
-                        s_bandWidth = OPUS_BANDWIDTH_WIDEBAND;
+                        dec->mode = MODE_SILK_ONLY;
+                        dec->bandWidth = OPUS_BANDWIDTH_WIDEBAND;
                         break;
         case 12 ... 13: endband  = 0; // OPUS_BANDWIDTH_HYBRID_SUPERWIDEBAND
-                        s_mode = MODE_HYBRID;
+                        dec->mode = MODE_HYBRID;
                         break;
         case 14 ... 15: endband  = 0; // OPUS_BANDWIDTH_HYBRID_FULLBAND
-                        s_mode = MODE_HYBRID;
+                        dec->mode = MODE_HYBRID;
                        break;
         case 16 ... 19: endband = 13; // OPUS_BANDWIDTH_CELT_NARROWBAND
-                        s_mode = MODE_CELT_ONLY;
+                        dec->mode = MODE_CELT_ONLY;
                         break;
         case 20 ... 23: endband = 17; // OPUS_BANDWIDTH_CELT_WIDEBAND
-                        s_mode = MODE_CELT_ONLY;
+                        dec->mode = MODE_CELT_ONLY;
                         break;
         case 24 ... 27: endband = 19; // OPUS_BANDWIDTH_CELT_SUPERWIDEBAND
-                        s_mode = MODE_CELT_ONLY;
+                        dec->mode = MODE_CELT_ONLY;
                         break;
         case 28 ... 31: endband = 21; // OPUS_BANDWIDTH_CELT_FULLBAND
-                        s_mode = MODE_CELT_ONLY;
+                        dec->mode = MODE_CELT_ONLY;
                         break;
-        default:        log_e("unknown bandwidth, configNr is: %d", configNr);
+        default:        log_e("unknown bandwidth, configNr is: %d", dec->configNr);
                         endband = 21; // assume OPUS_BANDWIDTH_FULLBAND
                         break;
     }
 
 //    celt_decoder_ctl(CELT_SET_START_BAND_REQUEST, endband);
-    if (s_mode == MODE_CELT_ONLY){
-        celt_decoder_ctl(CELT_SET_END_BAND_REQUEST, endband);
+    if (dec->mode == MODE_CELT_ONLY){
+        celt_decoder_ctl(dec->celt, CELT_SET_END_BAND_REQUEST, endband);
     }
-    else if(s_mode == MODE_SILK_ONLY){
+    else if(dec->mode == MODE_SILK_ONLY){
         // silk_InitDecoder();
     }
 
-    samplesPerFrame = opus_packet_get_samples_per_frame(inbuf, s_opusSamplerate);
+    dec->samplesPerFrame = opus_packet_get_samples_per_frame(inbuf, dec->samplerate);
 
 FramePacking:            // https://www.tech-invite.com/y65/tinv-ietf-rfc-6716-2.html   3.2. Frame Packing
-//log_i("s_opusCountCode %i, configNr %i", s_opusCountCode, configNr);
+//log_i("countCode %i, configNr %i", dec->countCode, dec->configNr);
 
-    switch(s_opusCountCode){
+    switch(dec->countCode){
         case 0:  // Code 0: One Frame in the Packet
-            ret = opus_FramePacking_Code0(inbuf, bytesLeft, outbuf, segmentLength, samplesPerFrame);
+            ret = opus_FramePacking_Code0(dec, inbuf, bytesLeft, outbuf, segmentLength, dec->samplesPerFrame);
             break;
         case 1:  // Code 1: Two Frames in the Packet, Each with Equal Compressed Size
-            ret = opus_FramePacking_Code1(inbuf, bytesLeft, outbuf, segmentLength, samplesPerFrame, &s_frameCount);
+            ret = opus_FramePacking_Code1(dec, inbuf, bytesLeft, outbuf, segmentLength, dec->samplesPerFrame, &dec->frameCount);
             break;
         case 2:  // Code 2: Two Frames in the Packet, with Different Compressed Sizes
-            ret = opus_FramePacking_Code2(inbuf, bytesLeft, outbuf, segmentLength, samplesPerFrame, &s_frameCount);
+            ret = opus_FramePacking_Code2(dec, inbuf, bytesLeft, outbuf, segmentLength, dec->samplesPerFrame, &dec->frameCount);
             break;
         case 3: // Code 3: A Signaled Number of Frames in the Packet
-            ret = opus_FramePacking_Code3(inbuf, bytesLeft, outbuf, segmentLength, samplesPerFrame, &s_frameCount);
+            ret = opus_FramePacking_Code3(dec, inbuf, bytesLeft, outbuf, segmentLength, dec->samplesPerFrame, &dec->frameCount);
             break;
         default:
-            log_e("unknown countCode %i", s_opusCountCode);
+            log_e("unknown countCode %i", dec->countCode);
             break;
     }
     return ret;
 }
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int8_t opus_FramePacking_Code0(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame){
+int8_t opus_FramePacking_Code0(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame){
 
 /*  Code 0: One Frame in the Packet
 
@@ -313,18 +295,18 @@ int8_t opus_FramePacking_Code0(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outb
 */
     int32_t ret = 0;
     *bytesLeft -= packetLen;
-    s_opusCurrentFilePos += packetLen;
+    dec->currentFilePos += packetLen;
     packetLen--;
     inbuf++;
-    ec_dec_init((uint8_t *)inbuf, packetLen);
-    ret = celt_decode_with_ec((int16_t*)outbuf, samplesPerFrame);
+    ec_dec_init(dec->celt, (uint8_t *)inbuf, packetLen);
+    ret = celt_decode_with_ec(dec->celt, (int16_t*)outbuf, samplesPerFrame);
     if(ret < 0) return ret;
-    s_opusValidSamples = ret;
+    dec->validSamples = ret;
     return ERR_OPUS_NONE;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int8_t opus_FramePacking_Code1(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount){
+int8_t opus_FramePacking_Code1(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount){
 
 /*  Code 1: Two Frames in the Packet, Each with Equal Compressed Size
 
@@ -348,32 +330,31 @@ int8_t opus_FramePacking_Code1(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outb
 
 
     int32_t ret = 0;
-    static uint16_t c1fs = 0;
     if(*frameCount == 0){
         packetLen--;
         inbuf++;
         *bytesLeft -= 1;
-        s_opusCurrentFilePos += 1;
-        c1fs = packetLen / 2;
+        dec->currentFilePos += 1;
+        dec->c1FrameSize = packetLen / 2;
 //      log_w("OPUS countCode 1 len %i, c1fs %i", len, c1fs);
         *frameCount = 2;
     }
     if(*frameCount > 0){
-        ec_dec_init((uint8_t *)inbuf, c1fs);
-        ret = celt_decode_with_ec((int16_t*)outbuf, samplesPerFrame);
+        ec_dec_init(dec->celt, (uint8_t *)inbuf, dec->c1FrameSize);
+        ret = celt_decode_with_ec(dec->celt, (int16_t*)outbuf, samplesPerFrame);
         if(ret < 0){
             return ret;
         }
-        s_opusValidSamples = ret;
-        *bytesLeft -= c1fs;
-        s_opusCurrentFilePos += c1fs;
+        dec->validSamples = ret;
+        *bytesLeft -= dec->c1FrameSize;
+        dec->currentFilePos += dec->c1FrameSize;
     }
     *frameCount -= 1;
     return ERR_OPUS_NONE;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int8_t opus_FramePacking_Code2(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount){
+int8_t opus_FramePacking_Code2(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount){
 
 /*  Code 2: Two Frames in the Packet, with Different Compressed Sizes
 
@@ -404,51 +385,49 @@ int8_t opus_FramePacking_Code2(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outb
 
 //  log_w("OPUS countCode 2 packetLen %i", packetLen);
     int32_t ret = 0;
-    static uint16_t firstFrameLength = 0;
-    static uint16_t secondFrameLength = 0;
 
     if(*frameCount == 0){
         uint8_t b1 = inbuf[1];
         uint8_t b2 = inbuf[2];
         if(b1 < 252){
-            firstFrameLength = b1;
+            dec->c2FirstFrameLength = b1;
             packetLen -= 2;
             *bytesLeft -= 2;
-            s_opusCurrentFilePos += 2;
+            dec->currentFilePos += 2;
             inbuf += 2;
         }
         else{
-            firstFrameLength = b1 + (b2 * 4);
+            dec->c2FirstFrameLength = b1 + (b2 * 4);
             packetLen -= 3;
             *bytesLeft -= 3;
-            s_opusCurrentFilePos += 3;
+            dec->currentFilePos += 3;
             inbuf += 3;
         }
-        secondFrameLength = packetLen - firstFrameLength;
+        dec->c2SecondFrameLength = packetLen - dec->c2FirstFrameLength;
         *frameCount = 2;
     }
     if(*frameCount == 2){
-        ec_dec_init((uint8_t *)inbuf, firstFrameLength);
-        ret = celt_decode_with_ec((int16_t*)outbuf, samplesPerFrame);
+        ec_dec_init(dec->celt, (uint8_t *)inbuf, dec->c2FirstFrameLength);
+        ret = celt_decode_with_ec(dec->celt, (int16_t*)outbuf, samplesPerFrame);
         if(ret < 0){return ret;}
-        s_opusValidSamples = ret;
-        *bytesLeft -= firstFrameLength;
-        s_opusCurrentFilePos += firstFrameLength;
+        dec->validSamples = ret;
+        *bytesLeft -= dec->c2FirstFrameLength;
+        dec->currentFilePos += dec->c2FirstFrameLength;
     }
     if(*frameCount == 1){
-        ec_dec_init((uint8_t *)inbuf, secondFrameLength);
-        ret = celt_decode_with_ec((int16_t*)outbuf, samplesPerFrame);
+        ec_dec_init(dec->celt, (uint8_t *)inbuf, dec->c2SecondFrameLength);
+        ret = celt_decode_with_ec(dec->celt, (int16_t*)outbuf, samplesPerFrame);
         if(ret < 0){return ret;}
-        s_opusValidSamples = ret;
-        *bytesLeft -= secondFrameLength;
-        s_opusCurrentFilePos += secondFrameLength;
+        dec->validSamples = ret;
+        *bytesLeft -= dec->c2SecondFrameLength;
+        dec->currentFilePos += dec->c2SecondFrameLength;
     }
     *frameCount -= 1;
     return ERR_OPUS_NONE;
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------
-int8_t opus_FramePacking_Code3(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount){
+int8_t opus_FramePacking_Code3(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount){
 
 /*  Code 3: A Signaled Number of Frames in the Packet
 
@@ -547,48 +526,43 @@ int8_t opus_FramePacking_Code3(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outb
      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
 */
-    static uint16_t paddingBytes = 0;
-    static uint16_t fs = 0;
-    static uint8_t M = 0;
-    static bool v = false;
-    static bool p = false;
     int32_t ret = 0;
     uint8_t paddingLength = 0;
     if(*frameCount == 0){
-        v = ((inbuf[1] & 0x80) == 0x80);  // VBR indicator
-        p = ((inbuf[1] & 0x40) == 0x40);  // padding bit
-        M = inbuf[1] & 0x3F;              // max framecount
-        if(v != 0) {log_e("OPUS countCode 3 with VBR not supported yet"); vTaskDelay(1000);} // todo
+        dec->c3VBR = ((inbuf[1] & 0x80) == 0x80);  // VBR indicator
+        dec->c3Padding = ((inbuf[1] & 0x40) == 0x40);  // padding bit
+        dec->c3M = inbuf[1] & 0x3F;              // max framecount
+        if(dec->c3VBR != 0) {log_e("OPUS countCode 3 with VBR not supported yet"); vTaskDelay(1000);} // todo
         *bytesLeft -= 2;
         packetLen -= 2;
         inbuf += 2;
-        if(p) paddingLength = inbuf[0];
+        if(dec->c3Padding) paddingLength = inbuf[0];
         if(paddingLength == 255) {paddingLength += inbuf[3];   }
         paddingLength ++;
         *bytesLeft -= paddingLength;
         packetLen -= paddingLength;
         inbuf += paddingLength;
-        *frameCount = M;
-        if(M == 0) return -1; // div0
-        log_i("packetLen %i,  M %i   FS %i", packetLen, M, packetLen / M);
+        *frameCount = dec->c3M;
+        if(dec->c3M == 0) return -1; // div0
+        log_i("packetLen %i,  M %i   FS %i", packetLen, dec->c3M, packetLen / dec->c3M);
 
-        fs = (packetLen - paddingBytes) / *frameCount;
+        dec->c3FrameSize = (packetLen - dec->c3PaddingBytes) / *frameCount;
     }
-    *bytesLeft -= fs;
-    s_opusCurrentFilePos += fs;
-    ec_dec_init((uint8_t *)inbuf, fs);
-    ret = celt_decode_with_ec((int16_t*)outbuf, samplesPerFrame);
+    *bytesLeft -= dec->c3FrameSize;
+    dec->currentFilePos += dec->c3FrameSize;
+    ec_dec_init(dec->celt, (uint8_t *)inbuf, dec->c3FrameSize);
+    ret = celt_decode_with_ec(dec->celt, (int16_t*)outbuf, samplesPerFrame);
     if(ret < 0) return ret; // celt error
-    s_opusValidSamples = ret;
+    dec->validSamples = ret;
     *frameCount -= 1;
     if(*frameCount > 0) return OPUS_CONTINUE;
-    s_opusCountCode = 0;
-    *bytesLeft -= paddingBytes;
-    s_opusCurrentFilePos += paddingBytes;
-    paddingBytes = 0;
-    fs = 0;
-    v = false;
-    p = false;
+    dec->countCode = 0;
+    *bytesLeft -= dec->c3PaddingBytes;
+    dec->currentFilePos += dec->c3PaddingBytes;
+    dec->c3PaddingBytes = 0;
+    dec->c3FrameSize = 0;
+    dec->c3VBR = false;
+    dec->c3Padding = false;
     return ERR_OPUS_NONE;
 }
 
@@ -614,48 +588,51 @@ int32_t opus_packet_get_samples_per_frame(const uint8_t *data, int32_t Fs) {
 }
 //----------------------------------------------------------------------------------------------------------------------
 
-uint8_t OPUSGetChannels(){
-    return s_opusChannels;
+uint8_t OPUSGetChannels(OPUSDecoder_t* dec){
+    return dec->channels;
 }
-uint32_t OPUSGetSampRate(){
-    return s_opusSamplerate;
+uint32_t OPUSGetSampRate(OPUSDecoder_t* dec){
+    return dec->samplerate;
 }
 uint8_t OPUSGetBitsPerSample(){
     return 16;
 }
-uint32_t OPUSGetBitRate(){
-    if(s_opusCompressionRatio != 0){
-        return (16 * 2 * 48000) / s_opusCompressionRatio;  //bitsPerSample * channel* SampleRate/CompressionRatio
+uint32_t OPUSGetBitRate(OPUSDecoder_t* dec){
+    if(dec->compressionRatio != 0){
+        return (16 * 2 * 48000) / dec->compressionRatio;  //bitsPerSample * channel* SampleRate/CompressionRatio
     }
     else return 0;
 }
-uint16_t OPUSGetOutputSamps(){
-    return s_opusValidSamples; // 1024
+uint16_t OPUSGetOutputSamps(OPUSDecoder_t* dec){
+    return dec->validSamples; // 1024
+}
+uint32_t OPUSGetAudioDataStart(OPUSDecoder_t* dec){
+    return dec->audioDataStart;
 }
-uint32_t OPUSGetAudioDataStart(){
-    return s_opusAudioDataStart;
+uint16_t OPUSGetPreSkip(OPUSDecoder_t* dec){
+    return dec->preSkip; // samples (48kHz) to discard at the start, needed for the exact duration
 }
-char* OPUSgetStreamTitle(){
-    if(s_f_newSteamTitle){
-        s_f_newSteamTitle = false;
-        return s_opusChbuf;
+char* OPUSgetStreamTitle(OPUSDecoder_t* dec){
+    if(dec->f_newSteamTitle){
+        dec->f_newSteamTitle = false;
+        return dec->chbuf;
     }
     return NULL;
 }
-vector<uint32_t> OPUSgetMetadataBlockPicture(){
-    if(s_f_opusNewMetadataBlockPicture){
-        s_f_opusNewMetadataBlockPicture = false;
-        return s_opusBlockPicItem;
+vector<uint32_t> OPUSgetMetadataBlockPicture(OPUSDecoder_t* dec){
+    if(dec->f_newMetadataBlockPicture){
+        dec->f_newMetadataBlockPicture = false;
+        return dec->blockPicItem;
     }
-    if(s_opusBlockPicItem.size() > 0){
-        s_opusBlockPicItem.clear();
-        s_opusBlockPicItem.shrink_to_fit();
+    if(dec->blockPicItem.size() > 0){
+        dec->blockPicItem.clear();
+        dec->blockPicItem.shrink_to_fit();
     }
-    return s_opusBlockPicItem;
+    return dec->blockPicItem;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int8_t parseOpusTOC(uint8_t TOC_Byte){  // https://www.rfc-editor.org/rfc/rfc6716  page 16 ff
+int8_t parseOpusTOC(OPUSDecoder_t* dec, uint8_t TOC_Byte){  // https://www.rfc-editor.org/rfc/rfc6716  page 16 ff
 
     uint8_t configNr = 0;
     uint8_t s = 0;              // stereo flag
@@ -687,8 +664,8 @@ int8_t parseOpusTOC(uint8_t TOC_Byte){  // https://www.rfc-editor.org/rfc/rfc671
         c = 2: 2 frames in the packet, with different compressed sizes
         c = 3: an arbitrary number of frames in the packet
     */
-    s_opusCountCode = c;
-    s_f_opusStereoFlag = s;
+    dec->countCode = c;
+    dec->f_stereoFlag = s;
 
     if(configNr < 12) return ERR_OPUS_SILK_MODE_UNSUPPORTED;
     if(configNr < 16) return ERR_OPUS_HYBRID_MODE_UNSUPPORTED;
@@ -699,7 +676,7 @@ int8_t parseOpusTOC(uint8_t TOC_Byte){  // https://www.rfc-editor.org/rfc/rfc671
     return configNr;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t parseOpusComment(uint8_t *inbuf, int32_t nBytes){      // reference https://exiftool.org/TagNames/Vorbis.html#Comments
+int32_t parseOpusComment(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t nBytes){      // reference https://exiftool.org/TagNames/Vorbis.html#Comments
                                                        // reference https://www.rfc-editor.org/rfc/rfc7845#section-5
     int32_t idx = OPUS_specialIndexOf(inbuf, "OpusTags", 10);
     if(idx != 0) return 0; // is not OpusTags
@@ -739,33 +716,33 @@ int32_t parseOpusComment(uint8_t *inbuf, int32_t nBytes){      // reference http
         idx = OPUS_specialIndexOf(inbuf + pos, "metadata_block_picture=", 25);
         if(idx == -1) idx = OPUS_specialIndexOf(inbuf + pos, "METADATA_BLOCK_PICTURE=", 25);
         if(idx == 0){
-            s_opusBlockPicLen = commentStringLen - 23;
-            s_opusCurrentFilePos += pos + 23;
-            s_opusBlockPicPos += s_opusCurrentFilePos;
-            s_blockPicLenUntilFrameEnd = nBytes - 23;
-        //  log_i("metadata block picture found at pos %i, length %i", s_opusBlockPicPos, s_opusBlockPicLen);
-            uint32_t pLen = _min(s_blockPicLenUntilFrameEnd, s_opusBlockPicLen);
+            dec->blockPicLen = commentStringLen - 23;
+            dec->currentFilePos += pos + 23;
+            dec->blockPicPos += dec->currentFilePos;
+            dec->blockPicLenUntilFrameEnd = nBytes - 23;
+        //  log_i("metadata block picture found at pos %i, length %i", dec->blockPicPos, dec->blockPicLen);
+            uint32_t pLen = _min(dec->blockPicLenUntilFrameEnd, dec->blockPicLen);
             if(pLen){
-                s_opusBlockPicItem.push_back(s_opusBlockPicPos);
-                s_opusBlockPicItem.push_back(pLen);
+                dec->blockPicItem.push_back(dec->blockPicPos);
+                dec->blockPicItem.push_back(pLen);
             }
         }
         pos += commentStringLen;
         nBytes -= commentStringLen;
     }
     if(artist && title){
-        strcpy(s_opusChbuf, artist);
-        strcat(s_opusChbuf, " - ");
-        strcat(s_opusChbuf, title);
-        s_f_newSteamTitle = true;
+        strcpy(dec->chbuf, artist);
+        strcat(dec->chbuf, " - ");
+        strcat(dec->chbuf, title);
+        dec->f_newSteamTitle = true;
     }
     else if(artist){
-        strcpy(s_opusChbuf, artist);
-        s_f_newSteamTitle = true;
+        strcpy(dec->chbuf, artist);
+        dec->f_newSteamTitle = true;
     }
     else if(title){
-        strcpy(s_opusChbuf, title);
-        s_f_newSteamTitle = true;
+        strcpy(dec->chbuf, title);
+        dec->f_newSteamTitle = true;
     }
     if(artist){free(artist); artist = NULL;}
     if(title) {free(title);  title = NULL;}
@@ -773,7 +750,7 @@ int32_t parseOpusComment(uint8_t *inbuf, int32_t nBytes){      // reference http
     return 1;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t parseOpusHead(uint8_t *inbuf, int32_t nBytes){  // reference https://wiki.xiph.org/OggOpus
+int32_t parseOpusHead(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t nBytes){  // reference https://wiki.xiph.org/OggOpus
 
 
     int32_t idx = OPUS_specialIndexOf(inbuf, "OpusHead", 10);
@@ -793,23 +770,24 @@ int32_t parseOpusHead(uint8_t *inbuf, int32_t nBytes){  // reference https://wik
     uint8_t  channelMap         = *(inbuf + 18);
 
     if(channelCount == 0 || channelCount >2) return ERR_OPUS_CHANNELS_OUT_OF_RANGE;
-    s_opusChannels = channelCount;
+    dec->channels = channelCount;
     if(sampleRate != 48000) return ERR_OPUS_INVALID_SAMPLERATE;
-    s_opusSamplerate = sampleRate;
+    dec->samplerate = sampleRate;
+    dec->preSkip = preSkip;
     if(channelMap > 1) return ERR_OPUS_EXTRA_CHANNELS_UNSUPPORTED;
 
     (void)outputGain;
 
-    CELTDecoder_ClearBuffer();
-    s_opusError = celt_decoder_init(s_opusChannels); if(s_opusError < 0) {log_e("CELT not init"); return false;}
-    s_opusError = celt_decoder_ctl(CELT_SET_SIGNALLING_REQUEST,  0); if(s_opusError < 0) {log_e("CELT not init"); return false;}
-    s_opusError = celt_decoder_ctl(CELT_SET_END_BAND_REQUEST,   21); if(s_opusError < 0) {log_e("CELT not init"); return false;}
+    CELTDecoder_ClearBuffer(dec->celt);
+    dec->error = celt_decoder_init(dec->celt, dec->channels); if(dec->error < 0) {log_e("CELT not init"); return false;}
+    dec->error = celt_decoder_ctl(dec->celt, CELT_SET_SIGNALLING_REQUEST,  0); if(dec->error < 0) {log_e("CELT not init"); return false;}
+    dec->error = celt_decoder_ctl(dec->celt, CELT_SET_END_BAND_REQUEST,   21); if(dec->error < 0) {log_e("CELT not init"); return false;}
 
     return 1;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int32_t OPUSparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://www.xiph.org/ogg/doc/rfc3533.txt
+int32_t OPUSparseOGG(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft){  // reference https://www.xiph.org/ogg/doc/rfc3533.txt
 
     int32_t idx = OPUS_specialIndexOf(inbuf, "OggS", 6);
     if(idx != 0) return ERR_OPUS_DECODER_ASYNC;
@@ -842,7 +820,7 @@ int32_t OPUSparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://
 
     // read the segment table (contains pageSegments bytes),  1...251: Length of the frame in bytes,
     // 255: A second byte is needed.  The total length is first_byte + second byte
-    s_opusSegmentLength = 0;
+    dec->segmentLength = 0;
     segmentTableWrPtr = -1;
 
     for(int32_t i = 0; i < pageSegments; i++){
@@ -853,43 +831,43 @@ int32_t OPUSparseOGG(uint8_t *inbuf, int32_t *bytesLeft){  // reference https://
             n+= *(inbuf + 27 + i);
         }
         segmentTableWrPtr++;
-        s_opusSegmentTable[segmentTableWrPtr] = n;
-        s_opusSegmentLength += n;
+        dec->segmentTable[segmentTableWrPtr] = n;
+        dec->segmentLength += n;
     }
-    s_opusSegmentTableSize = segmentTableWrPtr + 1;
-    s_opusCompressionRatio = (float)(960 * 2 * pageSegments)/s_opusSegmentLength;  // const 960 validBytes out
+    dec->segmentTableSize = segmentTableWrPtr + 1;
+    dec->compressionRatio = (float)(960 * 2 * pageSegments)/dec->segmentLength;  // const 960 validBytes out
 
-    s_f_continuedPage = headerType & 0x01; // set: page contains data of a packet continued from the previous page
-    s_f_firstPage     = headerType & 0x02; // set: this is the first page of a logical bitstream (bos)
-    s_f_lastPage      = headerType & 0x04; // set: this is the last page of a logical bitstream (eos)
+    dec->f_continuedPage = headerType & 0x01; // set: page contains data of a packet continued from the previous page
+    dec->f_firstPage     = headerType & 0x02; // set: this is the first page of a logical bitstream (bos)
+    dec->f_lastPage      = headerType & 0x04; // set: this is the last page of a logical bitstream (eos)
 
-//  log_i("firstPage %i, continuedPage %i, lastPage %i",s_f_firstPage, s_f_continuedPage, s_f_lastPage);
+//  log_i("firstPage %i, continuedPage %i, lastPage %i",dec->f_firstPage, dec->f_continuedPage, dec->f_lastPage);
 
     uint16_t headerSize   = pageSegments + 27;
     *bytesLeft           -= headerSize;
-    s_opusCurrentFilePos += headerSize;
-    s_opusOggHeaderSize   = headerSize;
+    dec->currentFilePos += headerSize;
+    dec->oggHeaderSize   = headerSize;
 
-    int32_t pLen = _min((int32_t)s_opusSegmentLength, s_opusRemainBlockPicLen);
-//  log_i("s_opusSegmentLength %i, s_opusRemainBlockPicLen %i", s_opusSegmentLength, s_opusRemainBlockPicLen);
-    if(s_opusBlockPicLen && pLen > 0){
-        s_opusBlockPicItem.push_back(s_opusCurrentFilePos);
-        s_opusBlockPicItem.push_back(pLen);
+    int32_t pLen = _min((int32_t)dec->segmentLength, dec->remainBlockPicLen);
+//  log_i("segmentLength %i, remainBlockPicLen %i", dec->segmentLength, dec->remainBlockPicLen);
+    if(dec->blockPicLen && pLen > 0){
+        dec->blockPicItem.push_back(dec->currentFilePos);
+        dec->blockPicItem.push_back(pLen);
     }
     return ERR_OPUS_NONE;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int32_t OPUSFindSyncWord(unsigned char *buf, int32_t nBytes){
+int32_t OPUSFindSyncWord(OPUSDecoder_t* dec, unsigned char *buf, int32_t nBytes){
     // assume we have a ogg wrapper
     int32_t idx = OPUS_specialIndexOf(buf, "OggS", nBytes);
     if(idx >= 0){ // Magic Word found
     //    log_i("OggS found at %i", idx);
-        s_f_opusParseOgg = true;
+        dec->f_parseOgg = true;
         return idx;
     }
     log_i("find sync");
-    s_f_opusParseOgg = false;
+    dec->f_parseOgg = false;
     return ERR_OPUS_OGG_SYNC_NOT_FOUND;
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -908,3 +886,4 @@ int32_t OPUS_specialIndexOf(uint8_t* base, const char* str, int32_t baselen, boo
     }
     return result;
 }
+#endif // AUDIO_CODEC_OPUS
@@ -32,30 +32,84 @@ enum : int8_t  {OPUS_CONTINUE = 110,
                 ERR_OPUS_CELT_END_BAND = -26,
                 ERR_CELT_OPUS_INTERNAL_ERROR = -27};
 
-bool             OPUSDecoder_AllocateBuffers();
-void             OPUSDecoder_FreeBuffers();
-void             OPUSDecoder_ClearBuffers();
-void             OPUSsetDefaults();
-int32_t          OPUSDecode(uint8_t* inbuf, int32_t* bytesLeft, short* outbuf);
-int32_t          opusDecodePage0(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength);
-int32_t          opusDecodePage3(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength, short *outbuf);
-int8_t           opus_FramePacking_Code0(uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame);
-int8_t           opus_FramePacking_Code1(uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount);
-int8_t           opus_FramePacking_Code2(uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount);
-int8_t           opus_FramePacking_Code3(uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount);
-uint8_t          OPUSGetChannels();
-uint32_t         OPUSGetSampRate();
+typedef struct celt_ctx celt_ctx_t; // celt.h
+
+typedef struct OPUSDecoder_t { // complete decoder state, one per stream
+    bool                  f_parseOgg = false;
+    bool                  f_newSteamTitle = false;            // streamTitle
+    bool                  f_newMetadataBlockPicture = false;  // new metadata block picture
+    bool                  f_stereoFlag = false;
+    bool                  f_continuedPage = false;
+    bool                  f_firstPage = false;
+    bool                  f_lastPage = false;
+    bool                  f_nextChunk = false;
+    uint8_t               channels = 0;
+    uint8_t               mode = 0;
+    uint8_t               countCode = 0;
+    uint8_t               pageNr = 0;
+    uint8_t               frameCount = 0;
+    uint16_t              oggHeaderSize = 0;
+    uint16_t              bandWidth = 0;
+    uint16_t              preSkip = 0;
+    uint32_t              samplerate = 0;
+    uint32_t              segmentLength = 0;
+    uint32_t              currentFilePos = 0;
+    uint32_t              audioDataStart = 0;
+    int32_t               blockPicLen = 0;
+    int32_t               blockPicLenUntilFrameEnd = 0;
+    int32_t               remainBlockPicLen = 0;
+    int32_t               commentBlockSize = 0;
+    uint32_t              blockPicPos = 0;
+    uint32_t              blockLen = 0;
+    char*                 chbuf = NULL;
+    int32_t               validSamples = 0;
+    uint16_t*             segmentTable = NULL;
+    uint8_t               segmentTableSize = 0;
+    int16_t               segmentTableRdPtr = -1;
+    int8_t                error = 0;
+    float                 compressionRatio = 0;
+    int8_t                configNr = 0;                       // TOC of the current packet
+    uint16_t              samplesPerFrame = 0;
+    uint16_t              c1FrameSize = 0;                    // frame packing code 1
+    uint16_t              c2FirstFrameLength = 0;             // frame packing code 2
+    uint16_t              c2SecondFrameLength = 0;
+    uint16_t              c3PaddingBytes = 0;                 // frame packing code 3
+    uint16_t              c3FrameSize = 0;
+    uint8_t               c3M = 0;
+    bool                  c3VBR = false;
+    bool                  c3Padding = false;
+    celt_ctx_t*           celt = NULL;                        // from OPUSDecoder_AllocateBuffers()
+    std::vector<uint32_t> blockPicItem;
+}OPUSDecoder_t;
+
+OPUSDecoder_t*   OPUSDecoder_Create();
+void             OPUSDecoder_Destroy(OPUSDecoder_t* dec);
+OPUSDecoder_t*   OPUSDecoder_Default();
+bool             OPUSDecoder_AllocateBuffers(OPUSDecoder_t* dec);
+void             OPUSDecoder_FreeBuffers(OPUSDecoder_t* dec);
+void             OPUSDecoder_ClearBuffers(OPUSDecoder_t* dec);
+void             OPUSsetDefaults(OPUSDecoder_t* dec);
+int32_t          OPUSDecode(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, short* outbuf);
+int32_t          opusDecodePage0(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength);
+int32_t          opusDecodePage3(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength, short *outbuf);
+int8_t           opus_FramePacking_Code0(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame);
+int8_t           opus_FramePacking_Code1(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount);
+int8_t           opus_FramePacking_Code2(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount);
+int8_t           opus_FramePacking_Code3(OPUSDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft, short *outbuf, int32_t packetLen, uint16_t samplesPerFrame, uint8_t* frameCount);
+uint8_t          OPUSGetChannels(OPUSDecoder_t* dec);
+uint32_t         OPUSGetSampRate(OPUSDecoder_t* dec);
 uint8_t          OPUSGetBitsPerSample();
-uint32_t         OPUSGetBitRate();
-uint16_t         OPUSGetOutputSamps();
-uint32_t         OPUSGetAudioDataStart();
-char*            OPUSgetStreamTitle();
-vector<uint32_t> OPUSgetMetadataBlockPicture();
-int32_t          OPUSFindSyncWord(unsigned char* buf, int32_t nBytes);
-int32_t          OPUSparseOGG(uint8_t* inbuf, int32_t* bytesLeft);
-int32_t          parseOpusHead(uint8_t* inbuf, int32_t nBytes);
-int32_t          parseOpusComment(uint8_t* inbuf, int32_t nBytes);
-int8_t           parseOpusTOC(uint8_t TOC_Byte);
+uint32_t         OPUSGetBitRate(OPUSDecoder_t* dec);
+uint16_t         OPUSGetOutputSamps(OPUSDecoder_t* dec);
+uint32_t         OPUSGetAudioDataStart(OPUSDecoder_t* dec);
+uint16_t         OPUSGetPreSkip(OPUSDecoder_t* dec);
+char*            OPUSgetStreamTitle(OPUSDecoder_t* dec);
+vector<uint32_t> OPUSgetMetadataBlockPicture(OPUSDecoder_t* dec);
+int32_t          OPUSFindSyncWord(OPUSDecoder_t* dec, unsigned char* buf, int32_t nBytes);
+int32_t          OPUSparseOGG(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft);
+int32_t          parseOpusHead(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t nBytes);
+int32_t          parseOpusComment(OPUSDecoder_t* dec, uint8_t* inbuf, int32_t nBytes);
+int8_t           parseOpusTOC(OPUSDecoder_t* dec, uint8_t TOC_Byte);
 int32_t          opus_packet_get_samples_per_frame(const uint8_t* data, int32_t Fs);
 
 // some helper functions
@@ -0,0 +1,226 @@
+/*
+ * station_warmer.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "station_warmer.h"
+#include "http_parser.h"
+#include "codec_mem.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+StationWarmer::StationWarmer() {
+    for(auto& s : m_slots) {
+        s.url = NULL;
+        s.state = W_IDLE;
+        s.ssl = false;
+        s.buf = NULL;
+        s.len = 0;
+        s.header = false;
+        s.since = 0;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+StationWarmer::~StationWarmer() {
+    end();
+    if(m_mutex) vSemaphoreDelete(m_mutex);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool StationWarmer::begin() {
+    end();
+    if(AUDIO_WARM_STATIONS == 0) return false;
+    if(!psramFound()) { log_e("station warmer: needs PSRAM"); return false; }
+    if(!m_mutex) m_mutex = xSemaphoreCreateMutex();
+    if(!m_mutex) return false;
+    for(auto& s : m_slots) s.secure.setInsecure();
+    m_f_stop = false;
+    m_f_taskRunning = true;
+    if(xTaskCreate(taskEntry, "AudioWarmer", 8192, this, AUDIO_WARM_PRIO, &m_task) != pdPASS) { // TLS needs the stack
+        log_e("station warmer: can't create task");
+        m_task = NULL;
+        m_f_taskRunning = false;
+        return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void StationWarmer::end() {
+    if(m_task) {
+        m_f_stop = true;
+        xTaskNotifyGive(m_task);
+        while(m_f_taskRunning) vTaskDelay(1); // a connect in flight has to finish first
+        m_task = NULL;
+    }
+    for(auto& s : m_slots) {
+        close(&s);
+        if(s.url) { free(s.url); s.url = NULL; }
+        if(s.buf) { free(s.buf); s.buf = NULL; }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void StationWarmer::warm(char* const* urls, uint8_t n) {
+    // a station that stays keeps its slot and connection, a new one gets a slot of a station that goes
+    if(!m_task) return;
+    n = min(n, (uint8_t)AUDIO_WARM_STATIONS);
+    bool keep[AUDIO_WARM_STATIONS] = {false};
+    bool placed[AUDIO_WARM_STATIONS] = {false};
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    for(int i = 0; i < AUDIO_WARM_STATIONS; i++) {
+        if(!m_slots[i].url) continue;
+        for(int k = 0; k < n; k++) {
+            if(!placed[k] && !strcmp(m_slots[i].url, urls[k])) { keep[i] = placed[k] = true; break; }
+        }
+    }
+    for(int i = 0, k = 0; i < AUDIO_WARM_STATIONS; i++) {
+        if(keep[i]) continue;
+        slot_t* s = &m_slots[i];
+        if(s->state != W_CONNECTING) close(s); // else the task finds the url changed and closes it
+        if(s->url) { free(s->url); s->url = NULL; }
+        while(k < n && placed[k]) k++;
+        if(k < n) {
+            s->url = strdup(urls[k]);
+            placed[k] = true;
+        }
+        if(s->state != W_CONNECTING) s->state = W_IDLE;
+    }
+    xSemaphoreGive(m_mutex);
+    xTaskNotifyGive(m_task);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool StationWarmer::take(const char* url, ReplayClient<WiFiClient>* plain, ReplayClient<TlsClient>* secure, size_t* buffered) {
+    if(!m_task) return false;
+    bool ok = false;
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    for(auto& s : m_slots) {
+        if(s.state != W_READY || !s.header || !s.url || strcmp(s.url, url)) continue;
+        if(s.ssl) {
+            secure->swap(s.secure); // the slot gets the old connection, closed below
+            secure->replay(s.buf, s.len);
+        }
+        else {
+            *static_cast<WiFiClient*>(plain) = s.plain; // shares the socket, stop() releases the slot's reference only
+            plain->replay(s.buf, s.len);
+        }
+        *buffered = s.len;
+        s.buf = NULL; // a new one for the next station
+        close(&s);
+        free(s.url); // it plays now, preconnect() tells the next neighbours
+        s.url = NULL;
+        s.state = W_IDLE;
+        ok = true;
+        break;
+    }
+    xSemaphoreGive(m_mutex);
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void StationWarmer::taskEntry(void* param) {
+    static_cast<StationWarmer*>(param)->taskLoop();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void StationWarmer::taskLoop() {
+    while(!m_f_stop) {
+        for(auto& s : m_slots) {
+            if(m_f_stop) break;
+            xSemaphoreTake(m_mutex, portMAX_DELAY);
+            if(s.url && (s.state == W_IDLE || (s.state == W_FAILED && millis() - s.since > WARM_RETRY_MS))) {
+                char* url = strdup(s.url);
+                s.state = W_CONNECTING;
+                xSemaphoreGive(m_mutex);
+                bool ok = url && open(&s, url); // the only blocking part, without the mutex
+                xSemaphoreTake(m_mutex, portMAX_DELAY);
+                bool same = s.url && url && !strcmp(s.url, url); // else the station has changed meanwhile
+                if(ok && same) s.state = W_READY;
+                else {
+                    close(&s);
+                    s.state = (!ok && same) ? W_FAILED : W_IDLE;
+                }
+                s.since = millis();
+                if(url) free(url);
+            }
+            else if(s.state == W_READY) fill(&s);
+            xSemaphoreGive(m_mutex);
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+    m_f_taskRunning = false;
+    vTaskDelete(NULL);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool StationWarmer::open(slot_t* s, const char* url) {
+    // the request as connecttohost() sends it, byte for byte
+    char        host[128];
+    uint16_t    port;
+    bool        ssl;
+    const char* path;
+    if(!splitUrl(url, host, sizeof(host), &port, &ssl, &path)) { log_e("station warmer: invalid url %s", url); return false; }
+    if(!s->buf) s->buf = (uint8_t*)CodecMem_Alloc(AUDIO_WARM_BUFFER, CODEC_MEM_COLD, "station warmer");
+    if(!s->buf) { log_e("station warmer: not enough memory"); return false; }
+    s->ssl = ssl;
+    s->len = 0;
+    s->header = false;
+    uint32_t t = millis();
+    if(!client(s)->connect(host, port, ssl ? 5000 : 2000)) {
+        log_w("station warmer: can't connect to %s:%u", host, port);
+        return false;
+    }
+    char* rqh = (char*)malloc(strlen(path) * 3 + strlen(host) + 160);
+    if(!rqh) return false;
+    strcpy(rqh, "GET ");
+    char* p = rqh + 4;
+    for(const char* c = path; *c; c++) { // spaces only, as Audio::urlencode(..., true)
+        if(*c == ' ') { memcpy(p, "%20", 3); p += 3; }
+        else *p++ = *c;
+    }
+    sprintf(p, " HTTP/1.1\r\nHost: %s\r\nIcy-MetaData:1\r\nIcy-MetaData:2\r\nAccept-Encoding: identity;q=1,*;q=0\r\n"
+               "Connection: keep-alive\r\n\r\n", host);
+    size_t len = strlen(rqh);
+    bool   ok = client(s)->write((const uint8_t*)rqh, len) == len;
+    free(rqh);
+    log_d("station warmer: %s connected in %lu ms", url, (long unsigned)(millis() - t));
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void StationWarmer::fill(slot_t* s) {
+    // reads what is there up to the end of the buffer, then TCP holds the server back
+    WiFiClient* c = client(s);
+    int         avail = c->available();
+    if(avail > 0 && s->len < AUDIO_WARM_BUFFER) {
+        int n = c->read(s->buf + s->len, min((size_t)avail, AUDIO_WARM_BUFFER - s->len));
+        if(n > 0) s->len += n;
+    }
+    if(!s->header) {
+        for(size_t i = 3; i < s->len; i++) {
+            if(s->buf[i] != '\n' || s->buf[i - 1] != '\r' || s->buf[i - 2] != '\n' || s->buf[i - 3] != '\r') continue;
+            const char* sp = (const char*)memchr(s->buf, ' ', i); // "HTTP/1.1 200 OK", "ICY 200 OK"
+            int status = sp ? atoi(sp + 1) : 0;
+            if(status < 200 || status >= 400) { // an error is not worth keeping, a redirect is followed by Audio
+                log_w("station warmer: %s, status %i", s->url, status);
+                close(s);
+                s->state = W_FAILED;
+                s->since = millis();
+                return;
+            }
+            s->header = true;
+            break;
+        }
+        if(!s->header && (s->len == AUDIO_WARM_BUFFER || millis() - s->since > WARM_HEADER_TIMEOUT || (avail <= 0 && !c->connected()))) {
+            log_w("station warmer: no response from %s", s->url);
+            close(s);
+            s->state = W_FAILED;
+            s->since = millis();
+            return;
+        }
+    }
+    if(millis() - s->since > AUDIO_WARM_MAX_AGE) { // renewed right away, the buffered bytes are too old
+        close(s);
+        s->state = W_IDLE;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void StationWarmer::close(slot_t* s) {
+    s->plain.stop();
+    s->secure.stop();
+    s->len = 0;
+    s->header = false;
+}
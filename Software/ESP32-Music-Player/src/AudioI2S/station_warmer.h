@@ -0,0 +1,146 @@
+/*
+ * station_warmer.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * Keeps a few web radio stations connected in its own task, typically the previous and the next one in the station
+ * list, so a station change skips DNS, TCP, TLS and the wait for the response. Each warm station has its request sent
+ * and the response header and the first body bytes (the server's burst) buffered in PSRAM; then reading stops and TCP
+ * holds the server back. connecttohost() takes the connection over and reads the buffered bytes first, through
+ * ReplayClient, so the header is parsed and the input buffer filled as if they had just arrived. A connection older
+ * than AUDIO_WARM_MAX_AGE is renewed, the stream must not lag too far and a stalled client may be dropped by the server.
+ * Memory: AUDIO_WARM_BUFFER of PSRAM per station, plus the TLS buffers (about 40 KB heap) of each https station.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <WiFi.h>
+#include "tls_client.h"
+
+#ifndef AUDIO_WARM_STATIONS
+  #define AUDIO_WARM_STATIONS   2            // stations preconnect() keeps connected at most, 0: none
+#endif
+#ifndef AUDIO_WARM_BUFFER
+  #define AUDIO_WARM_BUFFER     (64 * 1024)  // per station: response header and first body bytes
+#endif
+#ifndef AUDIO_WARM_MAX_AGE
+  #define AUDIO_WARM_MAX_AGE    20000        // ms, an older connection is renewed
+#endif
+#ifndef AUDIO_WARM_PRIO
+  #define AUDIO_WARM_PRIO       1            // as the loop task
+#endif
+#define WARM_RETRY_MS           10000        // after a failed connect or an error response
+#define WARM_HEADER_TIMEOUT     5000         // connect to the end of the response header
+
+//----------------------------------------------------------------------------------------------------------------------
+// A client that delivers the bytes given to replay() before those of its socket.
+template <class T> class ReplayClient : public T {
+
+public:
+    ~ReplayClient() { drop(); }
+    void replay(uint8_t* data, size_t len) { // takes data over (free())
+        drop();
+        m_replay = data;
+        m_replayLen = len;
+        m_replayPos = 0;
+    }
+    int available() {
+        size_t rest = m_replayLen - m_replayPos; // before the socket, its error handling may stop()
+        m_f_inner = true;
+        int avail = T::available();
+        m_f_inner = false;
+        return rest + (avail > 0 ? avail : 0);
+    }
+    int read() {
+        if(m_replayPos == m_replayLen) return T::read();
+        int b = m_replay[m_replayPos++];
+        if(m_replayPos == m_replayLen) drop();
+        return b;
+    }
+    int read(uint8_t* buf, size_t size) { // the replay or the socket, not both in one call
+        if(m_replayPos == m_replayLen) {
+            m_f_inner = true;
+            int n = T::read(buf, size);
+            m_f_inner = false;
+            return n;
+        }
+        size_t n = min(size, m_replayLen - m_replayPos);
+        memcpy(buf, m_replay + m_replayPos, n);
+        m_replayPos += n;
+        if(m_replayPos == m_replayLen) drop();
+        return n;
+    }
+    int peek() { return (m_replayPos < m_replayLen) ? m_replay[m_replayPos] : T::peek(); }
+    uint8_t connected() {
+        if(m_replayPos < m_replayLen) return 1;
+        m_f_inner = true;
+        uint8_t c = T::connected();
+        m_f_inner = false;
+        return c;
+    }
+    int connect(const char* host, uint16_t port, int32_t timeout) {
+        drop();
+        return T::connect(host, port, timeout);
+    }
+    int connect(const char* host, uint16_t port) {
+        drop();
+        return T::connect(host, port);
+    }
+    using T::connect;
+    void stop() {
+        if(!m_f_inner) drop();
+        T::stop();
+    }
+
+private:
+    void drop() {
+        if(m_replay) free(m_replay);
+        m_replay = NULL;
+        m_replayLen = m_replayPos = 0;
+    }
+
+    uint8_t* m_replay = NULL;
+    size_t   m_replayLen = 0;
+    size_t   m_replayPos = 0;
+    bool     m_f_inner = false; // in a call of T, which may stop() on a socket error: the replay stays
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+class StationWarmer {
+
+public:
+    StationWarmer();
+    ~StationWarmer();
+    bool     begin();                                       // starts the task, the buffers are allocated in PSRAM
+    void     end();                                         // closes all warm stations
+    bool     isActive() { return m_task != NULL; }
+    void     warm(char* const* urls, uint8_t n);            // these stations from now on, the others are closed
+    bool     take(const char* url, ReplayClient<WiFiClient>* plain, ReplayClient<TlsClient>* secure, size_t* buffered);
+                                                            // the connection moves over, false: url is not warm (yet)
+private:
+    enum : uint8_t { W_IDLE, W_CONNECTING, W_READY, W_FAILED };
+    typedef struct {
+        char*      url;         // NULL: unused
+        uint8_t    state;
+        bool       ssl;
+        WiFiClient plain;
+        TlsClient  secure;
+        uint8_t*   buf;
+        size_t     len;
+        bool       header;      // the response header is complete
+        uint32_t   since;       // millis() of the connect or the failure
+    } slot_t;
+
+    static void taskEntry(void* param);
+    void        taskLoop();
+    bool        open(slot_t* s, const char* url);
+    void        fill(slot_t* s);
+    void        close(slot_t* s);
+    WiFiClient* client(slot_t* s) { return s->ssl ? static_cast<WiFiClient*>(&s->secure) : &s->plain; }
+
+    slot_t            m_slots[AUDIO_WARM_STATIONS > 0 ? AUDIO_WARM_STATIONS : 1];
+    SemaphoreHandle_t m_mutex = NULL;   // slots, except the clients of a slot in W_CONNECTING
+    TaskHandle_t      m_task = NULL;
+    volatile bool     m_f_stop = false;
+    volatile bool     m_f_taskRunning = false;
+};
@@ -0,0 +1,237 @@
+/*
+ * tls_client.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "tls_client.h"
+#if TLS_RESUMPTION
+  #include <lwip/sockets.h>
+#endif
+
+static SemaphoreHandle_t s_mutex = NULL; // cache and statistics, Audio and the prefetch task connect concurrently
+static tlsStats_t        s_stats = {0, 0, 0, 0, 0};
+
+#if TLS_RESUMPTION
+typedef struct {
+    char*               host;            // NULL: free entry
+    uint16_t            port;
+    uint32_t            lastUse;
+    mbedtls_ssl_session session;
+} tlsSession_t;
+
+static tlsSession_t s_sessions[AUDIO_TLS_SESSIONS];
+
+//----------------------------------------------------------------------------------------------------------------------
+static tlsSession_t* sessionFind(const char* host, uint16_t port) {
+    for(int i = 0; i < AUDIO_TLS_SESSIONS; i++) {
+        if(s_sessions[i].host && s_sessions[i].port == port && !strcmp(s_sessions[i].host, host)) return &s_sessions[i];
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void sessionDrop(tlsSession_t* e) {
+    mbedtls_ssl_session_free(&e->session);
+    free(e->host);
+    e->host = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool sessionLoad(const char* host, uint16_t port, mbedtls_ssl_context* ssl, uint8_t* master) {
+    // offers the cached session, master gets its master secret: the same one after the handshake means resumed
+    bool ok = false;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    tlsSession_t* e = sessionFind(host, port);
+    if(e && mbedtls_ssl_set_session(ssl, &e->session) == 0) {
+        memcpy(master, e->session.master, sizeof(e->session.master));
+        e->lastUse = millis();
+        ok = true;
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void sessionStore(const char* host, uint16_t port, mbedtls_ssl_context* ssl) {
+    // a new ticket may come with every handshake, the entry is replaced; the least recently used host has to go
+    mbedtls_ssl_session s;
+    mbedtls_ssl_session_init(&s);
+    if(mbedtls_ssl_get_session(ssl, &s) != 0) {
+        mbedtls_ssl_session_free(&s);
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    tlsSession_t* e = sessionFind(host, port);
+    if(!e) {
+        e = &s_sessions[0];
+        for(int i = 0; i < AUDIO_TLS_SESSIONS; i++) {
+            if(!s_sessions[i].host) { e = &s_sessions[i]; break; }
+            if(s_sessions[i].lastUse < e->lastUse) e = &s_sessions[i];
+        }
+        if(e->host) sessionDrop(e);
+        e->host = strdup(host);
+        e->port = port;
+    }
+    else mbedtls_ssl_session_free(&e->session);
+    e->session = s; // takes the peer certificate and the ticket over
+    e->lastUse = millis();
+    if(!e->host) mbedtls_ssl_session_free(&e->session); // out of memory, nothing is cached
+    xSemaphoreGive(s_mutex);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void sessionForget(const char* host, uint16_t port) {
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    tlsSession_t* e = sessionFind(host, port);
+    if(e) sessionDrop(e);
+    xSemaphoreGive(s_mutex);
+}
+#endif // TLS_RESUMPTION
+
+//----------------------------------------------------------------------------------------------------------------------
+TlsClient::TlsClient() {
+    if(!s_mutex) s_mutex = xSemaphoreCreateMutex(); // with Audio, before any TlsClient connects
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TlsClient::swap(TlsClient& other) {
+    // the whole connection is in sslclient, the rest is state of the last read
+    std::swap(sslclient, other.sslclient);
+    std::swap(_connected, other._connected);
+    std::swap(_peek, other._peek);
+    std::swap(_lastError, other._lastError);
+    std::swap(m_timing, other.m_timing);
+}
+//----------------------------------------------------------------------------------------------------------------------
+tlsStats_t TlsClient::stats() {
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    tlsStats_t st = s_stats;
+    xSemaphoreGive(s_mutex);
+    return st;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    uint32_t t = millis();
+    m_timing = {0, 0, 0, false};
+#if TLS_RESUMPTION
+    if(_use_insecure) {
+        IPAddress ip;
+        if(!WiFi.hostByName(host, ip)) {
+            log_e("tls: can't resolve %s", host);
+            return done(false);
+        }
+        m_timing.dnsMs = millis() - t;
+        return handshake(host, ip, port, timeout > 0 ? timeout : _timeout);
+    }
+#endif
+    int ret = WiFiClientSecure::connect(host, port, timeout);
+    m_timing.tlsMs = millis() - t;
+    return done(ret > 0);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int TlsClient::done(bool ok) {
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if(!ok) s_stats.failed++;
+    else if(m_timing.resumed) {
+        s_stats.resumed++;
+        s_stats.resumedMs += m_timing.tlsMs;
+    }
+    else {
+        s_stats.handshakes++;
+        s_stats.fullMs += m_timing.tlsMs;
+    }
+    xSemaphoreGive(s_mutex);
+    if(!ok) stop();
+    return ok ? 1 : 0;
+}
+#if TLS_RESUMPTION
+//----------------------------------------------------------------------------------------------------------------------
+int TlsClient::handshake(const char* host, IPAddress ip, uint16_t port, int32_t timeout) {
+    // as start_ssl_client() of the core for an insecure client, with the cached session offered before the handshake
+    stop(); // frees the contexts of the last connection
+    sslclient_context* c = sslclient;
+    mbedtls_ssl_init(&c->ssl_ctx);
+    mbedtls_ssl_config_init(&c->ssl_conf);
+    mbedtls_ctr_drbg_init(&c->drbg_ctx);
+    mbedtls_entropy_init(&c->entropy_ctx);
+
+    // TCP
+    uint32_t t = millis();
+    c->socket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(c->socket < 0) {
+        log_e("tls: no socket");
+        return done(false);
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+    fcntl(c->socket, F_SETFL, fcntl(c->socket, F_GETFL, 0) | O_NONBLOCK); // non-blocking as the core leaves it
+    int res = lwip_connect(c->socket, (struct sockaddr*)&addr, sizeof(addr));
+    if(res < 0 && errno != EINPROGRESS) {
+        log_e("tls: connect to %s:%u failed, errno %i", host, port, errno);
+        return done(false);
+    }
+    fd_set         fdset;
+    struct timeval tv;
+    FD_ZERO(&fdset);
+    FD_SET(c->socket, &fdset);
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    if(lwip_select(c->socket + 1, NULL, &fdset, NULL, &tv) <= 0) {
+        log_e("tls: connect to %s:%u timed out", host, port);
+        return done(false);
+    }
+    int       err = 0;
+    socklen_t len = sizeof(err);
+    lwip_getsockopt(c->socket, SOL_SOCKET, SO_ERROR, &err, &len);
+    if(err) {
+        log_e("tls: connect to %s:%u failed, error %i", host, port, err);
+        return done(false);
+    }
+    int enable = 1;
+    lwip_setsockopt(c->socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    lwip_setsockopt(c->socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    lwip_setsockopt(c->socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    lwip_setsockopt(c->socket, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    m_timing.tcpMs = millis() - t;
+
+    // TLS
+    t = millis();
+    const char* pers = "esp32-tls";
+    int         ret = mbedtls_ctr_drbg_seed(&c->drbg_ctx, mbedtls_entropy_func, &c->entropy_ctx, (const unsigned char*)pers, strlen(pers));
+    if(!ret) ret = mbedtls_ssl_config_defaults(&c->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if(ret) {
+        log_e("tls: setup failed, -0x%04X", -ret);
+        return done(false);
+    }
+    mbedtls_ssl_conf_authmode(&c->ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&c->ssl_conf, mbedtls_ctr_drbg_random, &c->drbg_ctx);
+    ret = mbedtls_ssl_setup(&c->ssl_ctx, &c->ssl_conf);
+    if(!ret) ret = mbedtls_ssl_set_hostname(&c->ssl_ctx, host); // SNI
+    if(ret) {
+        log_e("tls: setup failed, -0x%04X", -ret);
+        return done(false);
+    }
+    uint8_t master[sizeof(c->ssl_ctx.session_negotiate->master)];
+    bool    offered = sessionLoad(host, port, &c->ssl_ctx, master);
+    mbedtls_ssl_set_bio(&c->ssl_ctx, &c->socket, mbedtls_net_send, mbedtls_net_recv, NULL);
+    while((ret = mbedtls_ssl_handshake(&c->ssl_ctx)) != 0) {
+        if(ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            log_e("tls: handshake with %s failed, -0x%04X", host, -ret);
+            if(offered) sessionForget(host, port); // the next attempt without the session
+            return done(false);
+        }
+        if(millis() - t > (uint32_t)timeout) {
+            log_e("tls: handshake with %s timed out", host);
+            return done(false);
+        }
+        vTaskDelay(2);
+    }
+    m_timing.tlsMs = millis() - t;
+    m_timing.resumed = offered && !memcmp(master, c->ssl_ctx.session->master, sizeof(master)); // abbreviated handshake
+    sessionStore(host, port, &c->ssl_ctx);
+    log_d("tls %s: dns %lu ms, tcp %lu ms, %s handshake %lu ms", host, (long unsigned)m_timing.dnsMs, (long unsigned)m_timing.tcpMs,
+          m_timing.resumed ? "resumed" : "full", (long unsigned)m_timing.tlsMs);
+    _lastError = 0;
+    _connected = true;
+    return done(true);
+}
+#endif // TLS_RESUMPTION
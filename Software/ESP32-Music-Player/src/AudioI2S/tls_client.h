@@ -0,0 +1,61 @@
+/*
+ * tls_client.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * WiFiClientSecure that resumes TLS sessions. The session of every handshake is kept per host and port and offered
+ * again on the next connect to it; a server that accepts it skips the certificate and the key exchange, one round trip
+ * and no public key operation instead of two round trips and several 100 ms of ECDHE or RSA on the ESP32. Session IDs
+ * and session tickets both work, the cache is shared by all TlsClients (Audio and the HLS prefetch task).
+ * Every connect measures the name resolution, the TCP connect and the TLS handshake separately.
+ * Resumption needs setInsecure() and mbedtls 2 (core 2.x), otherwise WiFiClientSecure connects as before.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+#ifndef AUDIO_TLS_SESSIONS
+  #define AUDIO_TLS_SESSIONS    4   // hosts with a cached session, 0: every connect makes a full handshake
+#endif
+#if ESP_IDF_VERSION_MAJOR < 5 && AUDIO_TLS_SESSIONS > 0
+  #define TLS_RESUMPTION        1
+#else
+  #define TLS_RESUMPTION        0
+#endif
+
+typedef struct {
+    uint32_t dnsMs;
+    uint32_t tcpMs;
+    uint32_t tlsMs;   // without resumption: all three phases together
+    bool     resumed;
+} tlsTiming_t;
+
+typedef struct {
+    uint32_t handshakes;
+    uint32_t resumed;
+    uint32_t failed;
+    uint32_t fullMs;    // sum over the full handshakes
+    uint32_t resumedMs; // sum over the resumed ones
+} tlsStats_t;
+
+class TlsClient : public WiFiClientSecure {
+
+public:
+    TlsClient();
+    int                connect(const char* host, uint16_t port, int32_t timeout);
+    int                connect(const char* host, uint16_t port) { return connect(host, port, _timeout); }
+    using              WiFiClientSecure::connect;                 // IPAddress, CA certificates, PSK
+    const tlsTiming_t& timing() { return m_timing; }              // of the last connect
+    void               swap(TlsClient& other);                    // exchanges the connections with their TLS contexts
+    static tlsStats_t  stats();                                   // of all TlsClients
+
+private:
+#if TLS_RESUMPTION
+    int                handshake(const char* host, IPAddress ip, uint16_t port, int32_t timeout);
+#endif
+    int                done(bool ok);
+
+    tlsTiming_t        m_timing = {0, 0, 0, false};
+};
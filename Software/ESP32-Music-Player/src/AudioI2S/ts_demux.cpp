@@ -0,0 +1,182 @@
+/*
+ * ts_demux.cpp
+ *
+ * Created on: Oct 19,2026
+ *
+ */
+#include "ts_demux.h"
+
+// --------------------------------------------------------------------------------------------------------
+// 0. Byte SyncByte  | 0 | 1 | 0 | 0 | 0 | 1 | 1 | 1 | always bit pattern of 0x47
+//---------------------------------------------------------------------------------------------------------
+// 1. Byte           |TEI|PUSI|TP|PID|PID|PID|PID|PID|
+//---------------------------------------------------------------------------------------------------------
+// 2. Byte           |PID|PID|PID|PID|PID|PID|PID|PID|
+//---------------------------------------------------------------------------------------------------------
+// 3. Byte           |TSC|TSC|AFC|AFC|CC |CC |CC |CC |
+//---------------------------------------------------------------------------------------------------------
+// 4.-187. Byte      |Adaptation field if AFC==10 or 11, payload if AFC==01 or 11|
+//---------------------------------------------------------------------------------------------------------
+// TEI  Transport error indicator, the packet is damaged
+// PUSI Payload unit start indicator, a PES (or a section behind a pointer field) starts in this packet
+// AFC  Adaptation field control, its first byte is the length, bit 7 of the second is the discontinuity indicator
+// CC   Continuity counter, +1 (mod 16) with every packet with payload of the same PID, a repeated value is a duplicate
+
+//----------------------------------------------------------------------------------------------------------------------
+void TsDemux::reset() {
+    m_audioPid = 0;
+    m_pmtPid = 0;
+    m_f_pmtSeen = false;
+    m_packets = 0;
+    m_ccErrors = 0;
+    m_syncLosses = 0;
+    m_dropped = 0;
+    newSegment();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TsDemux::newSegment() {
+    m_cc = 0xFF;
+    m_pesState = PES_WAIT; // a PES does not continue in the next segment
+    m_pesHdrLen = 0;
+    m_pesSkip = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t TsDemux::demux(const uint8_t* in, size_t len, uint8_t* out, size_t outSize, size_t* used) {
+    // whole packets only, a partial one at the end is left for the next call; stops before out could overflow
+    size_t i = 0, o = 0;
+    while(len - i >= TS_PACKET_SIZE && outSize - o >= TS_MAX_PAYLOAD) {
+        const uint8_t* p = in + i;
+        if(p[0] != 0x47) {
+            m_syncLosses++;
+            m_pesState = PES_WAIT;
+            i += resync(p, len - i);
+            continue;
+        }
+        m_packets++;
+        uint16_t pid = ((p[1] & 0x1F) << 8) | p[2];
+        if(pid == m_audioPid && m_audioPid) { o += audioPayload(p, out + o); } // fast path
+        else if(pid == 0 || (pid == m_pmtPid && m_pmtPid)) {
+            uint8_t  afc = (p[3] >> 4) & 0x03;
+            uint16_t pls = 4; // 4 + 1 + 255 + 1 + 255 at most, more than a uint8_t
+            if(afc & 0x02) pls += 1 + p[4];
+            if((afc & 0x01) && (p[1] & 0x40) && !(p[1] & 0x80) && pls < TS_PACKET_SIZE) { // section start behind the pointer field
+                pls += 1 + p[pls];
+                if(pls < TS_PACKET_SIZE - 12) {
+                    if(pid == 0) parsePAT(p, pls);
+                    else parsePMT(p, pls);
+                }
+            }
+        }
+        i += TS_PACKET_SIZE;
+    }
+    *used = i;
+    return o;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t TsDemux::audioPayload(const uint8_t* p, uint8_t* out) {
+    uint8_t  afc = (p[3] >> 4) & 0x03;
+    uint8_t  cc = p[3] & 0x0F;
+    uint16_t pls = 4;
+    if((p[1] & 0x80) || ((afc & 0x02) && p[4] > TS_MAX_PAYLOAD - 1)) { // TEI, or an adaptation field beyond the packet
+        m_cc = 0xFF; // the counter of a damaged packet is not trusted, the next one is not counted as a gap
+        m_pesState = PES_WAIT;
+        m_dropped++;
+        return 0;
+    }
+    if(afc & 0x02) {
+        if(p[4] && (p[5] & 0x80)) m_cc = 0xFF; // discontinuity indicator, the counter may jump
+        pls += 1 + p[4];
+    }
+    if(!(afc & 0x01) || pls >= TS_PACKET_SIZE) return 0; // adaptation field only, the counter stays
+    if(m_cc != 0xFF) {
+        if(cc == m_cc) return 0; // duplicate
+        if(cc != ((m_cc + 1) & 0x0F)) {
+            m_ccErrors++;
+            m_pesState = PES_WAIT; // packets are missing, the PES is damaged
+        }
+    }
+    m_cc = cc;
+
+    const uint8_t* d = p + pls;
+    size_t         n = TS_PACKET_SIZE - pls;
+    if(p[1] & 0x40) { // PUSI
+        m_pesState = PES_HEADER;
+        m_pesHdrLen = 0;
+    }
+    else if(m_pesState == PES_WAIT) {
+        m_dropped++;
+        return 0;
+    }
+    if(m_pesState == PES_HEADER) {
+        // 00 00 01 | stream id | PES packet length (2) | flags (2) | header data length | optional fields
+        if(m_pesHdrLen < sizeof(m_pesHdr)) {
+            size_t k = min(n, sizeof(m_pesHdr) - m_pesHdrLen);
+            memcpy(m_pesHdr + m_pesHdrLen, d, k);
+            m_pesHdrLen += k;
+            d += k;
+            n -= k;
+            if(m_pesHdrLen < sizeof(m_pesHdr)) return 0;
+            if(m_pesHdr[0] || m_pesHdr[1] || m_pesHdr[2] != 0x01 || (m_pesHdr[3] & 0xF0) == 0xE0) { // no start code, video
+                m_pesState = PES_WAIT;
+                m_dropped++;
+                return 0;
+            }
+            m_pesSkip = m_pesHdr[8];
+        }
+        size_t k = min(n, (size_t)m_pesSkip);
+        d += k;
+        n -= k;
+        m_pesSkip -= k;
+        if(m_pesSkip) return 0;
+        m_pesState = PES_DATA;
+    }
+    memcpy(out, d, n); // the only copy of the payload
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TsDemux::parsePAT(const uint8_t* p, uint16_t pls) {
+    // table id 0, section length, ..., 4 bytes per program: number, PMT PID; the first program is played
+    const uint8_t* t = p + pls;
+    if(t[0] != 0x00) return;
+    int secLen = ((t[1] & 0x0F) << 8) | t[2];
+    int end = min(3 + secLen - 4, TS_PACKET_SIZE - pls); // without CRC
+    for(int k = 8; k + 4 <= end; k += 4) {
+        uint16_t program = (t[k] << 8) | t[k + 1];
+        if(!program) continue; // network PID
+        uint16_t pid = ((t[k + 2] & 0x1F) << 8) | t[k + 3];
+        if(pid != m_pmtPid) log_d("ts PMT PID 0x%04X", pid);
+        m_pmtPid = pid;
+        return;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void TsDemux::parsePMT(const uint8_t* p, uint16_t pls) {
+    // table id 2, section length, ..., program info length, then per stream: type, PID, ES info length, ES info
+    const uint8_t* t = p + pls;
+    if(t[0] != 0x02) return;
+    int      secLen = ((t[1] & 0x0F) << 8) | t[2];
+    int      end = min(3 + secLen - 4, TS_PACKET_SIZE - pls); // without CRC
+    int      k = 12 + (((t[10] & 0x0F) << 8) | t[11]);
+    uint16_t audio = 0;
+    while(k + 5 <= end) {
+        uint8_t  type = t[k];
+        uint16_t pid = ((t[k + 1] & 0x1F) << 8) | t[k + 2];
+        if((type == 0x0F || type == 0x11) && !audio) audio = pid; // AAC ADTS, AAC LATM
+        k += 5 + (((t[k + 3] & 0x0F) << 8) | t[k + 4]);
+    }
+    m_f_pmtSeen = true;
+    if(audio == m_audioPid) return;
+    log_d("ts audio PID 0x%04X", audio);
+    m_audioPid = audio;
+    m_cc = 0xFF;
+    m_pesState = PES_WAIT;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int TsDemux::resync(const uint8_t* in, size_t len) {
+    // the next sync byte with another one a packet behind it, or the end of the data
+    for(size_t k = 1; k < len; k++) {
+        if(in[k] != 0x47) continue;
+        if(k + TS_PACKET_SIZE >= len || in[k + TS_PACKET_SIZE] == 0x47) return k;
+    }
+    return len;
+}
@@ -0,0 +1,56 @@
+/*
+ * ts_demux.h
+ *
+ * Created on: Oct 19,2026
+ *
+ * MPEG transport stream demultiplexer for HLS segments. demux() takes a block of 188 byte packets and writes the
+ * AAC elementary stream into the caller's buffer: one copy per payload, no intermediate PES buffer. The packets of
+ * the audio PID take a fast path (sync, PID, continuity, payload offset), PAT and PMT are parsed only to find that
+ * PID, everything else is dropped by its PID. A continuity error drops the damaged PES up to the next unit start,
+ * lost sync is recovered on the next pair of sync bytes 188 bytes apart. A packet with the transport error indicator or
+ * an adaptation field longer than 183 bytes is damaged, it drops its PES as well.
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#ifndef AUDIO_TS_BATCH
+  #define AUDIO_TS_BATCH    16   // transport packets per demux() call
+#endif
+#define TS_PACKET_SIZE      188
+#define TS_MAX_PAYLOAD      184
+
+class TsDemux {
+
+public:
+    TsDemux() {}
+    void     reset();                 // new stream, PAT and PMT are searched again
+    void     newSegment();            // the next HLS segment follows, its first continuity counter is not checked
+    size_t   demux(const uint8_t* in, size_t len, uint8_t* out, size_t outSize, size_t* used); // returns the ES bytes
+    bool     noAudio() { return m_f_pmtSeen && !m_audioPid; } // the program has no AAC stream
+    uint16_t audioPid() { return m_audioPid; }
+    uint32_t packets() { return m_packets; }
+    uint32_t ccErrors() { return m_ccErrors; }
+    uint32_t syncLosses() { return m_syncLosses; }
+    uint32_t dropped() { return m_dropped; }                  // audio packets dropped with a damaged PES
+
+private:
+    enum : uint8_t { PES_WAIT, PES_HEADER, PES_DATA };       // PES_WAIT: up to the next payload unit start
+    size_t   audioPayload(const uint8_t* p, uint8_t* out);
+    void     parsePAT(const uint8_t* p, uint16_t pls);
+    void     parsePMT(const uint8_t* p, uint16_t pls);
+    int      resync(const uint8_t* in, size_t len);
+
+    uint16_t m_audioPid = 0;             // 0: not known yet (PID 0 is the PAT)
+    uint16_t m_pmtPid = 0;
+    uint8_t  m_cc = 0xFF;                // last continuity counter of the audio PID, 0xFF: none
+    uint8_t  m_pesState = PES_WAIT;
+    uint8_t  m_pesHdr[9];                // fixed part of a PES header that spans two packets
+    uint8_t  m_pesHdrLen = 0;
+    uint16_t m_pesSkip = 0;              // optional PES header bytes still to skip
+    bool     m_f_pmtSeen = false;
+    uint32_t m_packets = 0;
+    uint32_t m_ccErrors = 0;
+    uint32_t m_syncLosses = 0;
+    uint32_t m_dropped = 0;
+};
@@ -20,447 +20,408 @@
 //----------------------------------------------------------------------------------------------------------------------
 //                                     O G G    I M P L.
 //----------------------------------------------------------------------------------------------------------------------
+#include "../audio_codecs.h"
+#if AUDIO_CODEC_VORBIS
+
 #include "vorbis_decoder.h"
 #include "lookup.h"
 #include "alloca.h"
 #include <vector>
+#include <new>
 using namespace std;
 
-#define __malloc_heap_psram(size) \
-    heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL)
-#define __calloc_heap_psram(ch, size) \
-    heap_caps_calloc_prefer(ch, size, 2, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL)
-
-
-// global vars
-bool      s_f_vorbisNewSteamTitle = false;  // streamTitle
-bool      s_f_vorbisNewMetadataBlockPicture = false;
-bool      s_f_oggFirstPage = false;
-bool      s_f_oggContinuedPage = false;
-bool      s_f_oggLastPage = false;
-bool      s_f_parseOggDone = true;
-bool      s_f_lastSegmentTable = false;
-bool      s_f_vorbisStr_found = false;
-uint16_t  s_identificatonHeaderLength = 0;
-uint16_t  s_vorbisCommentHeaderLength = 0;
-uint16_t  s_setupHeaderLength = 0;
-uint8_t   s_pageNr = 0;
-uint16_t  s_oggHeaderSize = 0;
-uint8_t   s_vorbisChannels = 0;
-uint16_t  s_vorbisSamplerate = 0;
-uint16_t  s_lastSegmentTableLen = 0;
-uint8_t  *s_lastSegmentTable = NULL;
-uint32_t  s_vorbisBitRate = 0;
-uint32_t  s_vorbisSegmentLength = 0;
-uint32_t  s_vorbisBlockPicLenUntilFrameEnd = 0;
-uint32_t  s_vorbisCurrentFilePos = 0;
-uint32_t  s_vorbisAudioDataStart = 0;
-char     *s_vorbisChbuf = NULL;
-int32_t   s_vorbisValidSamples = 0;
-int32_t   s_commentBlockSegmentSize = 0;
-uint8_t   s_vorbisOldMode = 0;
-uint32_t  s_blocksizes[2];
-uint32_t  s_vorbisBlockPicPos = 0;
-uint32_t  s_vorbisBlockPicLen = 0;
-int32_t   s_vorbisRemainBlockPicLen = 0;
-int32_t   s_commentLength = 0;
-
-uint8_t   s_nrOfCodebooks = 0;
-uint8_t   s_nrOfFloors = 0;
-uint8_t   s_nrOfResidues = 0;
-uint8_t   s_nrOfMaps = 0;
-uint8_t   s_nrOfModes = 0;
-
-uint16_t *s_vorbisSegmentTable = NULL;
-uint16_t  s_oggPage3Len = 0; // length of the current audio segment
-uint8_t   s_vorbisSegmentTableSize = 0;
-int16_t   s_vorbisSegmentTableRdPtr = -1;
-int8_t    s_vorbisError = 0;
-float     s_vorbisCompressionRatio = 0;
-
-bitReader_t            s_bitReader;
-
-codebook_t            *s_codebooks = NULL;
-vorbis_info_floor_t  **s_floor_param = NULL;
-int8_t                *s_floor_type = NULL;
-vorbis_info_residue_t *s_residue_param = NULL;
-vorbis_info_mapping_t *s_map_param = NULL;
-vorbis_info_mode_t    *s_mode_param = NULL;
-vorbis_dsp_state_t    *s_dsp_state = NULL;
-
-vector<uint32_t>s_vorbisBlockPicItem;
-
-
-bool VORBISDecoder_AllocateBuffers(){
-    s_vorbisSegmentTable = (uint16_t*)__calloc_heap_psram(256, sizeof(uint16_t));
-    s_vorbisChbuf = (char*)__calloc_heap_psram(256, sizeof(char));
-    s_lastSegmentTable = (uint8_t*)__malloc_heap_psram(4096);
-    VORBISsetDefaults();
+#define __malloc_heap_psram(size)     CodecMem_Alloc(size, CODEC_MEM_COLD, "vorbis")
+#define __calloc_heap_psram(ch, size) CodecMem_Calloc(ch, size, CODEC_MEM_COLD, "vorbis")
+
+
+VORBISDecoder_t s_vorbisDefault; // the context of the codec registry
+
+VORBISDecoder_t* VORBISDecoder_Create(){ // a further, independent decoder, e.g. to probe or preroll a second stream
+    VORBISDecoder_t* dec = new (std::nothrow) VORBISDecoder_t;
+    if(!dec) log_e("not enough memory to allocate a vorbisdecoder context");
+    return dec;
+}
+void VORBISDecoder_Destroy(VORBISDecoder_t* dec){
+    if(!dec || dec == &s_vorbisDefault) return;
+    VORBISDecoder_FreeBuffers(dec);
+    delete dec;
+}
+VORBISDecoder_t* VORBISDecoder_Default(){
+    return &s_vorbisDefault;
+}
+bool VORBISDecoder_AllocateBuffers(VORBISDecoder_t* dec){
+    dec->segmentTable = (uint16_t*)__calloc_heap_psram(256, sizeof(uint16_t));
+    dec->chbuf = (char*)__calloc_heap_psram(256, sizeof(char));
+    dec->lastSegmentTable = (uint8_t*)__malloc_heap_psram(4096);
+    VORBISsetDefaults(dec);
     return true;
 }
-void VORBISDecoder_FreeBuffers(){
-    if(s_vorbisSegmentTable) {free(s_vorbisSegmentTable); s_vorbisSegmentTable = NULL;}
-    if(s_vorbisChbuf){free(s_vorbisChbuf); s_vorbisChbuf = NULL;}
-    if(s_lastSegmentTable){free(s_lastSegmentTable); s_lastSegmentTable = NULL;}
-
-    clearGlobalConfigurations();
-}
-void VORBISDecoder_ClearBuffers(){
-    if(s_vorbisChbuf) memset(s_vorbisChbuf, 0, 256);
-    bitReader_clear();
-}
-void VORBISsetDefaults(){
-    s_pageNr = 0;
-    s_f_vorbisNewSteamTitle = false;  // streamTitle
-    s_f_vorbisNewMetadataBlockPicture = false;
-    s_f_lastSegmentTable = false;
-    s_f_parseOggDone = false;
-    s_f_oggFirstPage = false;
-    s_f_oggContinuedPage = false;
-    s_f_oggLastPage = false;
-    s_f_vorbisStr_found = false;
-    if(s_dsp_state){vorbis_dsp_destroy(s_dsp_state); s_dsp_state = NULL;}
-    s_vorbisChannels = 0;
-    s_vorbisSamplerate = 0;
-    s_vorbisBitRate = 0;
-    s_vorbisSegmentLength = 0;
-    s_vorbisValidSamples = 0;
-    s_vorbisSegmentTableSize = 0;
-    s_vorbisCurrentFilePos = 0;
-    s_vorbisAudioDataStart = 0;
-    s_vorbisOldMode = 0xFF;
-    s_vorbisSegmentTableRdPtr = -1;
-    s_vorbisError = 0;
-    s_lastSegmentTableLen = 0;
-    s_vorbisBlockPicPos = 0;
-    s_vorbisBlockPicLen = 0;
-    s_vorbisBlockPicLenUntilFrameEnd = 0;
-    s_commentBlockSegmentSize = 0;
-    s_vorbisBlockPicItem.clear();
-    s_vorbisBlockPicItem.shrink_to_fit();
-
-    VORBISDecoder_ClearBuffers();
-}
-
-void clearGlobalConfigurations() { // mode, mapping, floor etc
-    if(s_nrOfCodebooks) {  // if we have a stream with changing codebooks, delete the old one
-        for(int32_t i = 0; i < s_nrOfCodebooks; i++) { vorbis_book_clear(s_codebooks + i); }
-        s_nrOfCodebooks = 0;
-    }
-    if(s_codebooks) {
-        free(s_codebooks);
-        s_codebooks = NULL;
-    }
-    if(s_dsp_state) {
-        vorbis_dsp_destroy(s_dsp_state);
-        s_dsp_state = NULL;
-    }
-    if(s_nrOfFloors) {
-        for(int32_t i = 0; i < s_nrOfFloors; i++) floor_free_info(s_floor_param[i]);
-        free(s_floor_param);
-        s_nrOfFloors = 0;
-    }
-    if(s_nrOfResidues) {
-        for(int32_t i = 0; i < s_nrOfResidues; i++) res_clear_info(s_residue_param + i);
-        s_nrOfResidues = 0;
-    }
-    if(s_nrOfMaps) {
-        for(int32_t i = 0; i < s_nrOfMaps; i++) { mapping_clear_info(s_map_param + i); }
-        s_nrOfMaps = 0;
-    }
-    if(s_floor_type) {
-        free(s_floor_type);
-        s_floor_type = NULL;
-    }
-    if(s_residue_param) {
-        free(s_residue_param);
-        s_residue_param = NULL;
-    }
-    if(s_map_param) {
-        free(s_map_param);
-        s_map_param = NULL;
-    }
-    if(s_mode_param) {
-        free(s_mode_param);
-        s_mode_param = NULL;
+void VORBISDecoder_FreeBuffers(VORBISDecoder_t* dec){
+    if(dec->segmentTable) {free(dec->segmentTable); dec->segmentTable = NULL;}
+    if(dec->chbuf){free(dec->chbuf); dec->chbuf = NULL;}
+    if(dec->lastSegmentTable){free(dec->lastSegmentTable); dec->lastSegmentTable = NULL;}
+
+    clearGlobalConfigurations(dec);
+}
+void VORBISDecoder_ClearBuffers(VORBISDecoder_t* dec){
+    if(dec->chbuf) memset(dec->chbuf, 0, 256);
+    bitReader_clear(dec);
+}
+void VORBISsetDefaults(VORBISDecoder_t* dec){
+    dec->pageNr = 0;
+    dec->f_newSteamTitle = false;  // streamTitle
+    dec->f_newMetadataBlockPicture = false;
+    dec->f_lastSegmentTable = false;
+    dec->f_parseOggDone = false;
+    dec->f_oggFirstPage = false;
+    dec->f_oggContinuedPage = false;
+    dec->f_oggLastPage = false;
+    dec->f_vorbisStrFound = false;
+    if(dec->dsp_state){vorbis_dsp_destroy(dec, dec->dsp_state); dec->dsp_state = NULL;}
+    dec->channels = 0;
+    dec->samplerate = 0;
+    dec->bitRate = 0;
+    dec->segmentLength = 0;
+    dec->validSamples = 0;
+    dec->segmentTableSize = 0;
+    dec->currentFilePos = 0;
+    dec->audioDataStart = 0;
+    dec->oldMode = 0xFF;
+    dec->segmentTableRdPtr = -1;
+    dec->error = 0;
+    dec->lastSegmentTableLen = 0;
+    dec->blockPicPos = 0;
+    dec->blockPicLen = 0;
+    dec->blockPicLenUntilFrameEnd = 0;
+    dec->commentBlockSegmentSize = 0;
+    dec->blockPicItem.clear();
+    dec->blockPicItem.shrink_to_fit();
+
+    VORBISDecoder_ClearBuffers(dec);
+}
+
+void clearGlobalConfigurations(VORBISDecoder_t* dec) { // mode, mapping, floor etc
+    if(dec->nrOfCodebooks) {  // if we have a stream with changing codebooks, delete the old one
+        for(int32_t i = 0; i < dec->nrOfCodebooks; i++) { vorbis_book_clear(dec->codebooks + i); }
+        dec->nrOfCodebooks = 0;
+    }
+    dec->lookupDRAM = 0;
+    if(dec->codebooks) {
+        free(dec->codebooks);
+        dec->codebooks = NULL;
+    }
+    if(dec->dsp_state) {
+        vorbis_dsp_destroy(dec, dec->dsp_state);
+        dec->dsp_state = NULL;
+    }
+    if(dec->nrOfFloors) {
+        for(int32_t i = 0; i < dec->nrOfFloors; i++) floor_free_info(dec->floor_param[i]);
+        free(dec->floor_param);
+        dec->nrOfFloors = 0;
+    }
+    if(dec->nrOfResidues) {
+        for(int32_t i = 0; i < dec->nrOfResidues; i++) res_clear_info(dec->residue_param + i);
+        dec->nrOfResidues = 0;
+    }
+    if(dec->nrOfMaps) {
+        for(int32_t i = 0; i < dec->nrOfMaps; i++) { mapping_clear_info(dec->map_param + i); }
+        dec->nrOfMaps = 0;
+    }
+    if(dec->floor_type) {
+        free(dec->floor_type);
+        dec->floor_type = NULL;
+    }
+    if(dec->residue_param) {
+        free(dec->residue_param);
+        dec->residue_param = NULL;
+    }
+    if(dec->map_param) {
+        free(dec->map_param);
+        dec->map_param = NULL;
+    }
+    if(dec->mode_param) {
+        free(dec->mode_param);
+        dec->mode_param = NULL;
     }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-int32_t VORBISDecode(uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) {
+int32_t VORBISDecode(VORBISDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, int16_t* outbuf) {
 
     int32_t ret = 0;
     int32_t segmentLength = 0;
 
-    if(s_commentBlockSegmentSize) {
-        if(s_commentBlockSegmentSize > 8192) {
-            s_commentBlockSegmentSize -= 8192;
-            s_commentLength -= 8192;
+    if(dec->commentBlockSegmentSize) {
+        if(dec->commentBlockSegmentSize > 8192) {
+            dec->commentBlockSegmentSize -= 8192;
+            dec->commentLength -= 8192;
             *bytesLeft -= 8192;
-            s_vorbisCurrentFilePos += 8192;
+            dec->currentFilePos += 8192;
         }
         else {
-            *bytesLeft -= s_commentBlockSegmentSize;
-            s_vorbisCurrentFilePos += s_commentBlockSegmentSize;
-            s_commentLength -= s_commentBlockSegmentSize;
-            s_commentBlockSegmentSize = 0;
+            *bytesLeft -= dec->commentBlockSegmentSize;
+            dec->currentFilePos += dec->commentBlockSegmentSize;
+            dec->commentLength -= dec->commentBlockSegmentSize;
+            dec->commentBlockSegmentSize = 0;
         }
-        if(s_vorbisRemainBlockPicLen <= 0 && !s_f_vorbisNewMetadataBlockPicture) {
-            if(s_vorbisBlockPicItem.size() > 0) { // get blockpic data
+        if(dec->remainBlockPicLen <= 0 && !dec->f_newMetadataBlockPicture) {
+            if(dec->blockPicItem.size() > 0) { // get blockpic data
                 // log_i("---------------------------------------------------------------------------");
-                // log_i("metadata blockpic found at pos %i, size %i bytes", s_vorbisBlockPicPos, s_vorbisBlockPicLen);
-                // for(int32_t i = 0; i < s_vorbisBlockPicItem.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, s_vorbisBlockPicItem[i], s_vorbisBlockPicItem[i + 1]); }
+                // log_i("metadata blockpic found at pos %i, size %i bytes", blockPicPos, blockPicLen);
+                // for(int32_t i = 0; i < blockPicItem.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, blockPicItem[i], blockPicItem[i + 1]); }
                 // log_i("---------------------------------------------------------------------------");
-                s_f_vorbisNewMetadataBlockPicture = true;
+                dec->f_newMetadataBlockPicture = true;
             }
         }
         return VORBIS_PARSE_OGG_DONE;
     }
 
-    if(!s_vorbisSegmentTableSize) {
-        s_vorbisSegmentTableRdPtr = -1; // back to the parking position
-        ret = VORBISparseOGG(inbuf, bytesLeft);
-        s_f_parseOggDone = true;
-        if(!s_vorbisSegmentTableSize) { log_w("OggS without segments?"); }
+    if(!dec->segmentTableSize) {
+        dec->segmentTableRdPtr = -1; // back to the parking position
+        ret = VORBISparseOGG(dec, inbuf, bytesLeft);
+        dec->f_parseOggDone = true;
+        if(!dec->segmentTableSize) { log_w("OggS without segments?"); }
         return ret;
     }
 
     // With the last segment of a table, we don't know whether it will be continued in the next Ogg page.
-    // So the last segment is saved. s_lastSegmentTableLen specifies the size of the last saved segment.
+    // So the last segment is saved. lastSegmentTableLen specifies the size of the last saved segment.
     // If the next Ogg Page does not contain a 'continuedPage', the last segment is played first. However,
     // if 'continuedPage' is set, the first segment of the new page is added to the saved segment and played.
-    if(!s_lastSegmentTableLen){
-        if(s_vorbisSegmentTableSize) {
-            s_vorbisSegmentTableRdPtr++;
-            s_vorbisSegmentTableSize--;
-            segmentLength = s_vorbisSegmentTable[s_vorbisSegmentTableRdPtr];
+    if(!dec->lastSegmentTableLen){
+        if(dec->segmentTableSize) {
+            dec->segmentTableRdPtr++;
+            dec->segmentTableSize--;
+            segmentLength = dec->segmentTable[dec->segmentTableRdPtr];
         }
     }
 
-    if(s_pageNr < 4)
-        if(VORBIS_specialIndexOf(inbuf, "vorbis", 10) == 1) s_pageNr++;
+    if(dec->pageNr < 4)
+        if(VORBIS_specialIndexOf(inbuf, "vorbis", 10) == 1) dec->pageNr++;
 
-    switch(s_pageNr) {
+    switch(dec->pageNr) {
         case 0:
             ret = VORBIS_PARSE_OGG_DONE; // do nothing
             break;
         case 1:
-            ret = vorbisDecodePage1(inbuf, bytesLeft, segmentLength); // blocksize, channels, samplerates
+            ret = vorbisDecodePage1(dec, inbuf, bytesLeft, segmentLength); // blocksize, channels, samplerates
             break;
         case 2:
-            ret = vorbisDecodePage2(inbuf, bytesLeft, segmentLength); // comments
+            ret = vorbisDecodePage2(dec, inbuf, bytesLeft, segmentLength); // comments
             break;
         case 3:
-            ret = vorbisDecodePage3(inbuf, bytesLeft, segmentLength); // codebooks
+            ret = vorbisDecodePage3(dec, inbuf, bytesLeft, segmentLength); // codebooks
             break;
         case 4:
-            ret = vorbisDecodePage4(inbuf, bytesLeft, segmentLength, outbuf); // decode audio
+            ret = vorbisDecodePage4(dec, inbuf, bytesLeft, segmentLength, outbuf); // decode audio
             break;
-        default: log_e("unknown page %s", s_pageNr); break;
+        default: log_e("unknown page %s", dec->pageNr); break;
     }
     return ret;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t vorbisDecodePage1(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
+int32_t vorbisDecodePage1(VORBISDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
     int32_t ret = VORBIS_PARSE_OGG_DONE;
-    clearGlobalConfigurations(); // if a new codebook is required, delete the old one
+    clearGlobalConfigurations(dec); // if a new codebook is required, delete the old one
     int32_t idx = VORBIS_specialIndexOf(inbuf, "vorbis", 10);
     if(idx == 1) {
         // log_i("first packet (identification segmentLength) %i", segmentLength);
-        s_identificatonHeaderLength = segmentLength;
-        ret = parseVorbisFirstPacket(inbuf, segmentLength);
+        dec->identificatonHeaderLength = segmentLength;
+        ret = parseVorbisFirstPacket(dec, inbuf, segmentLength);
     }
     else {
         ret = ERR_VORBIS_NOT_AUDIO; // #651
     }
 
     *bytesLeft -= segmentLength;
-    s_vorbisCurrentFilePos += segmentLength;
+    dec->currentFilePos += segmentLength;
     return ret;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t vorbisDecodePage2(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
+int32_t vorbisDecodePage2(VORBISDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
     int32_t ret = VORBIS_PARSE_OGG_DONE;
     int32_t idx = VORBIS_specialIndexOf(inbuf, "vorbis", 10);
     if(idx == 1) {
-        s_vorbisBlockPicItem.clear();
-        s_vorbisBlockPicItem.shrink_to_fit();
-        s_f_vorbisStr_found = true;
-        s_vorbisCommentHeaderLength = segmentLength;
-        ret = parseVorbisComment(inbuf, segmentLength);
-        s_commentBlockSegmentSize = segmentLength;
-         int32_t pLen = _min((int32_t)s_vorbisBlockPicLen, s_vorbisBlockPicLenUntilFrameEnd);
-        if(s_vorbisBlockPicLen && pLen > 0){
-            s_vorbisBlockPicItem.push_back(s_vorbisBlockPicPos);
-            s_vorbisBlockPicItem.push_back(pLen);
-        }
-        s_vorbisRemainBlockPicLen = s_vorbisBlockPicLen - pLen;
+        dec->blockPicItem.clear();
+        dec->blockPicItem.shrink_to_fit();
+        dec->f_vorbisStrFound = true;
+        dec->commentHeaderLength = segmentLength;
+        ret = parseVorbisComment(dec, inbuf, segmentLength);
+        dec->commentBlockSegmentSize = segmentLength;
+         int32_t pLen = _min((int32_t)dec->blockPicLen, dec->blockPicLenUntilFrameEnd);
+        if(dec->blockPicLen && pLen > 0){
+            dec->blockPicItem.push_back(dec->blockPicPos);
+            dec->blockPicItem.push_back(pLen);
+        }
+        dec->remainBlockPicLen = dec->blockPicLen - pLen;
         ret = VORBIS_PARSE_OGG_DONE;
     }
     else {
-        s_commentBlockSegmentSize = segmentLength;
-        uint32_t pLen = min(s_vorbisRemainBlockPicLen, (int32_t)segmentLength);
-        if(s_vorbisRemainBlockPicLen && pLen > 0){
-            s_vorbisBlockPicItem.push_back(s_vorbisCurrentFilePos);
-            s_vorbisBlockPicItem.push_back(pLen);
+        dec->commentBlockSegmentSize = segmentLength;
+        uint32_t pLen = min(dec->remainBlockPicLen, (int32_t)segmentLength);
+        if(dec->remainBlockPicLen && pLen > 0){
+            dec->blockPicItem.push_back(dec->currentFilePos);
+            dec->blockPicItem.push_back(pLen);
         }
-        s_vorbisRemainBlockPicLen -= segmentLength;
+        dec->remainBlockPicLen -= segmentLength;
         ret = VORBIS_PARSE_OGG_DONE;
     }
     return ret;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t vorbisDecodePage3(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
+int32_t vorbisDecodePage3(VORBISDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength){
     int32_t ret = VORBIS_PARSE_OGG_DONE;
     int32_t idx = VORBIS_specialIndexOf(inbuf, "vorbis", 10);
-    s_oggPage3Len = segmentLength;
+    dec->oggPage3Len = segmentLength;
     if(idx == 1) {
         // log_i("third packet (setup segmentLength) %i", segmentLength);
-        s_setupHeaderLength = segmentLength;
-        bitReader_setData(inbuf, segmentLength);
+        dec->setupHeaderLength = segmentLength;
+        bitReader_setData(dec, inbuf, segmentLength);
         if(segmentLength == 4080) {
             // that is 16*255 bytes and thus the maximum segment size
             // it is possible that there is another block starting with 'OggS' in which there is information
             // about codebooks. It is possible that there is another block starting with 'OggS' in which
             // there is information about codebooks.
-            int32_t l = continuedOggPackets(inbuf + s_oggPage3Len);
+            int32_t l = continuedOggPackets(inbuf + dec->oggPage3Len);
             *bytesLeft -= l;
-            s_vorbisCurrentFilePos += l;
-            s_oggPage3Len += l;
-            s_setupHeaderLength += l;
-            bitReader_setData(inbuf, s_oggPage3Len);
-            log_w("s_oggPage3Len %i", s_oggPage3Len);
-            s_pageNr++;
+            dec->currentFilePos += l;
+            dec->oggPage3Len += l;
+            dec->setupHeaderLength += l;
+            bitReader_setData(dec, inbuf, dec->oggPage3Len);
+            log_w("oggPage3Len %i", dec->oggPage3Len);
+            dec->pageNr++;
         }
-        ret = parseVorbisCodebook();
+        ret = parseVorbisCodebook(dec);
     }
     else { log_e("no \"vorbis\" something went wrong %i", segmentLength); }
-    s_pageNr = 4;
-    s_dsp_state = vorbis_dsp_create();
+    dec->pageNr = 4;
+    dec->dsp_state = vorbis_dsp_create(dec);
 
     *bytesLeft -= segmentLength;
-    s_vorbisCurrentFilePos += segmentLength;
+    dec->currentFilePos += segmentLength;
     return ret;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-int32_t vorbisDecodePage4(uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength, int16_t* outbuf){
+int32_t vorbisDecodePage4(VORBISDecoder_t* dec, uint8_t* inbuf, int32_t* bytesLeft, uint32_t segmentLength, int16_t* outbuf){
 
-    if(s_vorbisAudioDataStart == 0){
-        s_vorbisAudioDataStart = s_vorbisCurrentFilePos;
+    if(dec->audioDataStart == 0){
+        dec->audioDataStart = dec->currentFilePos;
     }
 
     int32_t ret = 0;
-    if(s_f_parseOggDone) { // first loop after VORBISparseOGG()
-        if(s_f_oggContinuedPage) {
-            if(s_lastSegmentTableLen > 0 || segmentLength > 0) {
-                if(s_lastSegmentTableLen + segmentLength > 1024) log_e("continued page too big");
-                memcpy(s_lastSegmentTable + s_lastSegmentTableLen, inbuf, segmentLength);
-                bitReader_setData(s_lastSegmentTable, s_lastSegmentTableLen + segmentLength);
-                ret = vorbis_dsp_synthesis(s_lastSegmentTable, s_lastSegmentTableLen + segmentLength, outbuf);
-                uint16_t outBuffSize = 2048 * 2;
-                s_vorbisValidSamples = vorbis_dsp_pcmout(outbuf, outBuffSize);
-                s_lastSegmentTableLen = 0;
+    if(dec->f_parseOggDone) { // first loop after VORBISparseOGG()
+        if(dec->f_oggContinuedPage) {
+            if(dec->lastSegmentTableLen > 0 || segmentLength > 0) {
+                if(dec->lastSegmentTableLen + segmentLength > 1024) log_e("continued page too big");
+                memcpy(dec->lastSegmentTable + dec->lastSegmentTableLen, inbuf, segmentLength);
+                bitReader_setData(dec, dec->lastSegmentTable, dec->lastSegmentTableLen + segmentLength);
+                ret = vorbis_dsp_synthesis(dec, dec->lastSegmentTable, dec->lastSegmentTableLen + segmentLength, outbuf);
+                dec->validSamples = vorbis_dsp_pcmout(dec, outbuf, VORBIS_OUTBUFF_SIZE);
+                dec->lastSegmentTableLen = 0;
                 if(!ret && !segmentLength) ret = VORBIS_CONTINUE;
             }
-            else { // s_lastSegmentTableLen is 0 and segmentLength is 0
-                s_vorbisValidSamples = 0;
+            else { // lastSegmentTableLen is 0 and segmentLength is 0
+                dec->validSamples = 0;
                 ret = VORBIS_CONTINUE;
             }
-            s_f_oggContinuedPage = false;
+            dec->f_oggContinuedPage = false;
         }
         else { // last segment without continued Page
-            if(s_lastSegmentTableLen) {
-                bitReader_setData(s_lastSegmentTable, s_lastSegmentTableLen);
-                ret = vorbis_dsp_synthesis(s_lastSegmentTable, s_lastSegmentTableLen, outbuf);
-                uint16_t outBuffSize = 2048 * 2;
-                s_vorbisValidSamples = vorbis_dsp_pcmout(outbuf, outBuffSize);
-                s_lastSegmentTableLen = 0;
+            if(dec->lastSegmentTableLen) {
+                bitReader_setData(dec, dec->lastSegmentTable, dec->lastSegmentTableLen);
+                ret = vorbis_dsp_synthesis(dec, dec->lastSegmentTable, dec->lastSegmentTableLen, outbuf);
+                dec->validSamples = vorbis_dsp_pcmout(dec, outbuf, VORBIS_OUTBUFF_SIZE);
+                dec->lastSegmentTableLen = 0;
                 if(ret == OV_ENOTAUDIO || ret == 0) ret = VORBIS_CONTINUE; // if no error send continue
             }
             else {
-                bitReader_setData(inbuf, segmentLength);
-                ret = vorbis_dsp_synthesis(inbuf, segmentLength, outbuf);
-                uint16_t outBuffSize = 2048 * 2;
-                s_vorbisValidSamples = vorbis_dsp_pcmout(outbuf, outBuffSize);
+                bitReader_setData(dec, inbuf, segmentLength);
+                ret = vorbis_dsp_synthesis(dec, inbuf, segmentLength, outbuf);
+                dec->validSamples = vorbis_dsp_pcmout(dec, outbuf, VORBIS_OUTBUFF_SIZE);
                 ret = 0;
             }
         }
     }
-    else { // not s_f_parseOggDone
-        if(s_vorbisSegmentTableSize || s_f_lastSegmentTable) {
-            // if(s_f_oggLastPage) log_i("last page");
-            bitReader_setData(inbuf, segmentLength);
-            ret = vorbis_dsp_synthesis(inbuf, segmentLength, outbuf);
-            uint16_t outBuffSize = 2048 * 2;
-            s_vorbisValidSamples = vorbis_dsp_pcmout(outbuf, outBuffSize);
+    else { // not f_parseOggDone
+        if(dec->segmentTableSize || dec->f_lastSegmentTable) {
+            // if(f_oggLastPage) log_i("last page");
+            bitReader_setData(dec, inbuf, segmentLength);
+            ret = vorbis_dsp_synthesis(dec, inbuf, segmentLength, outbuf);
+            dec->validSamples = vorbis_dsp_pcmout(dec, outbuf, VORBIS_OUTBUFF_SIZE);
             ret = 0;
         }
         else { // last segment
             if(segmentLength) {
-                memcpy(s_lastSegmentTable, inbuf, segmentLength);
-                s_lastSegmentTableLen = segmentLength;
-                s_vorbisValidSamples = 0;
+                memcpy(dec->lastSegmentTable, inbuf, segmentLength);
+                dec->lastSegmentTableLen = segmentLength;
+                dec->validSamples = 0;
                 ret = 0;
             }
             else {
-                s_lastSegmentTableLen = 0;
-                s_vorbisValidSamples = 0;
+                dec->lastSegmentTableLen = 0;
+                dec->validSamples = 0;
                 ret = VORBIS_PARSE_OGG_DONE;
             }
         }
-        s_f_oggFirstPage = false;
+        dec->f_oggFirstPage = false;
     }
-    s_f_parseOggDone = false;
-    if(s_f_oggLastPage && !s_vorbisSegmentTableSize) { VORBISsetDefaults(); }
+    dec->f_parseOggDone = false;
+    if(dec->f_oggLastPage && !dec->segmentTableSize) { VORBISsetDefaults(dec); }
 
     if(ret != VORBIS_CONTINUE){ // nothing to do here, is playing from lastSegmentBuff
         *bytesLeft -= segmentLength;
-        s_vorbisCurrentFilePos += segmentLength;
+        dec->currentFilePos += segmentLength;
     }
     return ret;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-uint8_t VORBISGetChannels(){
-    return s_vorbisChannels;
+uint8_t VORBISGetChannels(VORBISDecoder_t* dec){
+    return dec->channels;
 }
-uint32_t VORBISGetSampRate(){
-    return s_vorbisSamplerate;
+uint32_t VORBISGetSampRate(VORBISDecoder_t* dec){
+    return dec->samplerate;
 }
 uint8_t VORBISGetBitsPerSample(){
     return 16;
 }
-uint32_t VORBISGetBitRate(){
-    return s_vorbisBitRate;
+uint32_t VORBISGetBitRate(VORBISDecoder_t* dec){
+    return dec->bitRate;
 }
-uint32_t VORBISGetAudioDataStart(){
-    return s_vorbisAudioDataStart;
+uint32_t VORBISGetAudioDataStart(VORBISDecoder_t* dec){
+    return dec->audioDataStart;
 }
-uint16_t VORBISGetOutputSamps(){
-    return s_vorbisValidSamples; // 1024
+uint16_t VORBISGetOutputSamps(VORBISDecoder_t* dec){
+    return dec->validSamples; // 1024
 }
-char* VORBISgetStreamTitle(){
-    if(s_f_vorbisNewSteamTitle){
-        s_f_vorbisNewSteamTitle = false;
-        return s_vorbisChbuf;
+void VORBISsetLookupBits(VORBISDecoder_t* dec, uint8_t bits){ // for the codebooks of the next setup header, 0 = walk the tree only
+    dec->lookupBits = _min(bits, (uint8_t)16);
+}
+void VORBISsetFusedImdct(VORBISDecoder_t* dec, bool on){ // for the next setup header, false = transform in place in the work buffers
+    dec->f_fusedImdct = on;
+}
+char* VORBISgetStreamTitle(VORBISDecoder_t* dec){
+    if(dec->f_newSteamTitle){
+        dec->f_newSteamTitle = false;
+        return dec->chbuf;
     }
     return NULL;
 }
-vector<uint32_t> VORBISgetMetadataBlockPicture(){
-    if(s_f_vorbisNewMetadataBlockPicture){
-        s_f_vorbisNewMetadataBlockPicture = false;
-        return s_vorbisBlockPicItem;
+vector<uint32_t> VORBISgetMetadataBlockPicture(VORBISDecoder_t* dec){
+    if(dec->f_newMetadataBlockPicture){
+        dec->f_newMetadataBlockPicture = false;
+        return dec->blockPicItem;
     }
-    if(s_vorbisBlockPicItem.size() > 0){
-        s_vorbisBlockPicItem.clear();
-        s_vorbisBlockPicItem.shrink_to_fit();
+    if(dec->blockPicItem.size() > 0){
+        dec->blockPicItem.clear();
+        dec->blockPicItem.shrink_to_fit();
     }
-    return s_vorbisBlockPicItem;
+    return dec->blockPicItem;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t parseVorbisFirstPacket(uint8_t *inbuf, int16_t nBytes){ // 4.2.2. Identification header
+int32_t parseVorbisFirstPacket(VORBISDecoder_t* dec, uint8_t *inbuf, int16_t nBytes){ // 4.2.2. Identification header
                                                             // https://xiph.org/vorbis/doc/Vorbis_I_spec.html#x1-820005
     // first bytes are: '.vorbis'
     uint16_t pos = 7;
@@ -493,19 +454,19 @@ int32_t parseVorbisFirstPacket(uint8_t *inbuf, int16_t nBytes){ // 4.2.2. Identi
 
     uint8_t  blocksize   = *(inbuf + pos + 21);
 
-    s_blocksizes[0] = 1 << ( blocksize & 0x0F);
-    s_blocksizes[1] = 1 << ((blocksize & 0xF0) >> 4);
+    dec->blocksizes[0] = 1 << ( blocksize & 0x0F);
+    dec->blocksizes[1] = 1 << ((blocksize & 0xF0) >> 4);
 
-    if(s_blocksizes[0] < 64){
+    if(dec->blocksizes[0] < 64){
         log_e("blocksize[0] too low");
         return -1;
     }
-    if(s_blocksizes[1] < s_blocksizes[0]){
-        log_e("s_blocksizes[1] is smaller than s_blocksizes[0]");
+    if(dec->blocksizes[1] < dec->blocksizes[0]){
+        log_e("blocksizes[1] is smaller than blocksizes[0]");
         return -1;
     }
-    if(s_blocksizes[1] > 8192){
-        log_e("s_blocksizes[1] is too big");
+    if(dec->blocksizes[1] > 8192){
+        log_e("blocksizes[1] is too big");
         return -1;
     }
 
@@ -513,21 +474,21 @@ int32_t parseVorbisFirstPacket(uint8_t *inbuf, int16_t nBytes){ // 4.2.2. Identi
         log_e("nr of channels is not valid ch=%i", channels);
         return -1;
     }
-    s_vorbisChannels = channels;
+    dec->channels = channels;
 
     if(sampleRate < 4096 || sampleRate > 64000){
         log_e("sampleRate is not valid sr=%i", sampleRate);
         return -1;
     }
-    s_vorbisSamplerate = sampleRate;
+    dec->samplerate = sampleRate;
 
-    s_vorbisBitRate = br_nominal;
+    dec->bitRate = br_nominal;
 
     return VORBIS_PARSE_OGG_DONE;
 
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t parseVorbisComment(uint8_t *inbuf, int16_t nBytes){      // reference https://xiph.org/vorbis/doc/v-comment.html
+int32_t parseVorbisComment(VORBISDecoder_t* dec, uint8_t *inbuf, int16_t nBytes){      // reference https://xiph.org/vorbis/doc/v-comment.html
 
     // first bytes are: '.vorbis'
     uint32_t pos = 7;
@@ -541,18 +502,18 @@ int32_t parseVorbisComment(uint8_t *inbuf, int16_t nBytes){      // reference ht
        return 0;
     }
 
-    memcpy(s_vorbisChbuf, inbuf + 11, vendorLength);
-    s_vorbisChbuf[vendorLength] = '\0';
+    memcpy(dec->chbuf, inbuf + 11, vendorLength);
+    dec->chbuf[vendorLength] = '\0';
     pos += 4 + vendorLength;
-    s_vorbisCommentHeaderLength -= (7 + 4 + vendorLength);
+    dec->commentHeaderLength -= (7 + 4 + vendorLength);
 
     // log_i("vendorLength %x", vendorLength);
-    // log_i("vendorString %s", s_vorbisChbuf);
+    // log_i("vendorString %s", chbuf);
 
     uint8_t nrOfComments = *(inbuf + pos);
     // log_i("nrOfComments %i", nrOfComments);
     pos += 4;
-    s_vorbisCommentHeaderLength -= 4;
+    dec->commentHeaderLength -= 4;
 
     int32_t idx = 0;
     char* artist = NULL;
@@ -564,45 +525,45 @@ int32_t parseVorbisComment(uint8_t *inbuf, int16_t nBytes){      // reference ht
         commentLength += *(inbuf + pos + 2) << 16;
         commentLength += *(inbuf + pos + 1) << 8;
         commentLength += *(inbuf + pos);
-        s_commentLength = commentLength;
+        dec->commentLength = commentLength;
 
         uint8_t cl = min((uint32_t)254, commentLength);
-        memcpy(s_vorbisChbuf, inbuf + pos +  4, cl);
-        s_vorbisChbuf[cl] = '\0';
+        memcpy(dec->chbuf, inbuf + pos +  4, cl);
+        dec->chbuf[cl] = '\0';
 
-        // log_i("commentLength %i comment %s", commentLength, s_vorbisChbuf);
+        // log_i("commentLength %i comment %s", commentLength, chbuf);
 
-        idx =        VORBIS_specialIndexOf((uint8_t*)s_vorbisChbuf, "artist=", 10);
-        if(idx != 0) idx =  VORBIS_specialIndexOf((uint8_t*)s_vorbisChbuf, "ARTIST=", 10);
-        if(idx == 0){ artist = strndup((const char*)(s_vorbisChbuf + 7), commentLength - 7); s_commentLength = 0;}
+        idx =        VORBIS_specialIndexOf((uint8_t*)dec->chbuf, "artist=", 10);
+        if(idx != 0) idx =  VORBIS_specialIndexOf((uint8_t*)dec->chbuf, "ARTIST=", 10);
+        if(idx == 0){ artist = strndup((const char*)(dec->chbuf + 7), commentLength - 7); dec->commentLength = 0;}
 
-        idx =        VORBIS_specialIndexOf((uint8_t*)s_vorbisChbuf, "title=", 10);
-        if(idx != 0) idx =  VORBIS_specialIndexOf((uint8_t*)s_vorbisChbuf, "TITLE=", 10);
-        if(idx == 0){ title = strndup((const char*)(s_vorbisChbuf + 6), commentLength - 6); s_commentLength = 0;}
+        idx =        VORBIS_specialIndexOf((uint8_t*)dec->chbuf, "title=", 10);
+        if(idx != 0) idx =  VORBIS_specialIndexOf((uint8_t*)dec->chbuf, "TITLE=", 10);
+        if(idx == 0){ title = strndup((const char*)(dec->chbuf + 6), commentLength - 6); dec->commentLength = 0;}
 
-        idx =        VORBIS_specialIndexOf((uint8_t*)s_vorbisChbuf, "metadata_block_picture=", 25);
-        if(idx != 0) idx =  VORBIS_specialIndexOf((uint8_t*)s_vorbisChbuf, "METADATA_BLOCK_PICTURE", 25);
+        idx =        VORBIS_specialIndexOf((uint8_t*)dec->chbuf, "metadata_block_picture=", 25);
+        if(idx != 0) idx =  VORBIS_specialIndexOf((uint8_t*)dec->chbuf, "METADATA_BLOCK_PICTURE", 25);
         if(idx == 0){
-            s_vorbisBlockPicLen = commentLength - 23;
-            s_vorbisBlockPicPos += s_vorbisCurrentFilePos + 4 +pos + 23;
-            s_vorbisBlockPicLenUntilFrameEnd = s_vorbisCommentHeaderLength - 4 - 23;
+            dec->blockPicLen = commentLength - 23;
+            dec->blockPicPos += dec->currentFilePos + 4 +pos + 23;
+            dec->blockPicLenUntilFrameEnd = dec->commentHeaderLength - 4 - 23;
         }
         pos += commentLength + 4;
-        s_vorbisCommentHeaderLength -= (4 + commentLength);
+        dec->commentHeaderLength -= (4 + commentLength);
     }
     if(artist && title){
-        strcpy(s_vorbisChbuf, artist);
-        strcat(s_vorbisChbuf, " - ");
-        strcat(s_vorbisChbuf, title);
-        s_f_vorbisNewSteamTitle = true;
+        strcpy(dec->chbuf, artist);
+        strcat(dec->chbuf, " - ");
+        strcat(dec->chbuf, title);
+        dec->f_newSteamTitle = true;
     }
     else if(artist){
-        strcpy(s_vorbisChbuf, artist);
-        s_f_vorbisNewSteamTitle = true;
+        strcpy(dec->chbuf, artist);
+        dec->f_newSteamTitle = true;
     }
     else if(title){
-        strcpy(s_vorbisChbuf, title);
-        s_f_vorbisNewSteamTitle = true;
+        strcpy(dec->chbuf, title);
+        dec->f_newSteamTitle = true;
     }
     if(artist){free(artist); artist = NULL;}
     if(title) {free(title);  title = NULL;}
@@ -610,96 +571,96 @@ int32_t parseVorbisComment(uint8_t *inbuf, int16_t nBytes){      // reference ht
     return VORBIS_PARSE_OGG_DONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t parseVorbisCodebook(){
+int32_t parseVorbisCodebook(VORBISDecoder_t* dec){
 
-    s_bitReader.headptr += 7;
-    s_bitReader.length = s_oggPage3Len;
+    dec->reader.headptr += 7;
+    dec->reader.length = dec->oggPage3Len;
 
     int32_t i;
     int32_t ret = 0;
 
-    s_nrOfCodebooks = bitReader(8) +1;
-    s_codebooks = (codebook_t*) __calloc_heap_psram(s_nrOfCodebooks, sizeof(*s_codebooks));
+    dec->nrOfCodebooks = bitReader(dec, 8) +1;
+    dec->codebooks = (codebook_t*) __calloc_heap_psram(dec->nrOfCodebooks, sizeof(*dec->codebooks));
 
-    for(i = 0; i < s_nrOfCodebooks; i++){
-        ret = vorbis_book_unpack(s_codebooks + i);
+    for(i = 0; i < dec->nrOfCodebooks; i++){
+        ret = vorbis_book_unpack(dec, dec->codebooks + i);
         if(ret) log_e("codebook %i returned err", i);
         if(ret) goto err_out;
     }
 
     /* time backend settings, not actually used */
-    i = bitReader(6);
+    i = bitReader(dec, 6);
     for(; i >= 0; i--){
-        ret = bitReader(16);
+        ret = bitReader(dec, 16);
         if(ret != 0){
             log_e("err while reading backend settings");
             goto err_out;
         }
     }
     /* floor backend settings */
-    s_nrOfFloors  = bitReader(6) + 1;
+    dec->nrOfFloors  = bitReader(dec, 6) + 1;
 
-    s_floor_param = (vorbis_info_floor_t **)__malloc_heap_psram(sizeof(*s_floor_param) * s_nrOfFloors);
-    s_floor_type  = (int8_t *)__malloc_heap_psram(sizeof(int8_t) * s_nrOfFloors);
-    for(i = 0; i < s_nrOfFloors; i++) {
-        s_floor_type[i] = bitReader(16);
-        if(s_floor_type[i] < 0 || s_floor_type[i] >= VI_FLOORB) {
+    dec->floor_param = (vorbis_info_floor_t **)__malloc_heap_psram(sizeof(*dec->floor_param) * dec->nrOfFloors);
+    dec->floor_type  = (int8_t *)__malloc_heap_psram(sizeof(int8_t) * dec->nrOfFloors);
+    for(i = 0; i < dec->nrOfFloors; i++) {
+        dec->floor_type[i] = bitReader(dec, 16);
+        if(dec->floor_type[i] < 0 || dec->floor_type[i] >= VI_FLOORB) {
             log_e("err while reading floors");
             goto err_out;
         }
-        if(s_floor_type[i]){
-            s_floor_param[i] = floor1_info_unpack();
+        if(dec->floor_type[i]){
+            dec->floor_param[i] = floor1_info_unpack(dec);
         }
         else{
-            s_floor_param[i] = floor0_info_unpack();
+            dec->floor_param[i] = floor0_info_unpack(dec);
         }
-        if(!s_floor_param[i]){
+        if(!dec->floor_param[i]){
             log_e("floor parameter not found");
             goto err_out;
         }
     }
 
     /* residue backend settings */
-    s_nrOfResidues = bitReader(6) + 1;
-    s_residue_param = (vorbis_info_residue_t *)__malloc_heap_psram(sizeof(*s_residue_param) * s_nrOfResidues);
-    for(i = 0; i < s_nrOfResidues; i++){
-         if(res_unpack(s_residue_param + i)){
+    dec->nrOfResidues = bitReader(dec, 6) + 1;
+    dec->residue_param = (vorbis_info_residue_t *)__malloc_heap_psram(sizeof(*dec->residue_param) * dec->nrOfResidues);
+    for(i = 0; i < dec->nrOfResidues; i++){
+         if(res_unpack(dec, dec->residue_param + i)){
             log_e("err while unpacking residues");
             goto err_out;
          }
     }
 
     // /* map backend settings */
-    s_nrOfMaps = bitReader(6) + 1;
-    s_map_param = (vorbis_info_mapping_t *)__malloc_heap_psram(sizeof(*s_map_param) * s_nrOfMaps);
-    for(i = 0; i < s_nrOfMaps; i++) {
-        if(bitReader(16) != 0) goto err_out;
-        if(mapping_info_unpack(s_map_param + i)){
+    dec->nrOfMaps = bitReader(dec, 6) + 1;
+    dec->map_param = (vorbis_info_mapping_t *)__malloc_heap_psram(sizeof(*dec->map_param) * dec->nrOfMaps);
+    for(i = 0; i < dec->nrOfMaps; i++) {
+        if(bitReader(dec, 16) != 0) goto err_out;
+        if(mapping_info_unpack(dec, dec->map_param + i)){
             log_e("err while unpacking mappings");
             goto err_out;
         }
     }
 
     /* mode settings */
-    s_nrOfModes = bitReader(6) + 1;
-    s_mode_param = (vorbis_info_mode_t *)__malloc_heap_psram(s_nrOfModes* sizeof(*s_mode_param));
-    for(i = 0; i < s_nrOfModes; i++) {
-        s_mode_param[i].blockflag = bitReader(1);
-        if(bitReader(16)) goto err_out;
-        if(bitReader(16)) goto err_out;
-        s_mode_param[i].mapping = bitReader(8);
-        if(s_mode_param[i].mapping >= s_nrOfMaps){
+    dec->nrOfModes = bitReader(dec, 6) + 1;
+    dec->mode_param = (vorbis_info_mode_t *)__malloc_heap_psram(dec->nrOfModes* sizeof(*dec->mode_param));
+    for(i = 0; i < dec->nrOfModes; i++) {
+        dec->mode_param[i].blockflag = bitReader(dec, 1);
+        if(bitReader(dec, 16)) goto err_out;
+        if(bitReader(dec, 16)) goto err_out;
+        dec->mode_param[i].mapping = bitReader(dec, 8);
+        if(dec->mode_param[i].mapping >= dec->nrOfMaps){
             log_e("too many modes");
             goto err_out;
         }
     }
 
-    if(bitReader(1) != 1){
+    if(bitReader(dec, 1) != 1){
         log_e("codebooks, end bit not found");
         goto err_out;
     }
-    // if(s_setupHeaderLength != s_bitReader.headptr - s_bitReader.data){
-    //     log_e("Error reading setup header, assumed %i bytes, read %i bytes", s_setupHeaderLength, s_bitReader.headptr - s_bitReader.data);
+    // if(setupHeaderLength != reader.headptr - reader.data){
+    //     log_e("Error reading setup header, assumed %i bytes, read %i bytes", setupHeaderLength, reader.headptr - reader.data);
     //     goto err_out;
     // }
     /* top level EOP check */
@@ -708,20 +669,20 @@ int32_t parseVorbisCodebook(){
 
 err_out:
 //    vorbis_info_clear(vi);
-    log_e("err in codebook!  at pos %d", s_bitReader.headptr - s_bitReader.data);
+    log_e("err in codebook!  at pos %d", dec->reader.headptr - dec->reader.data);
     return (OV_EBADHEADER);
 }
 //----------------------------------------------------------------------------------------------------------------------
-int32_t VORBISparseOGG(uint8_t *inbuf, int32_t *bytesLeft){
+int32_t VORBISparseOGG(VORBISDecoder_t* dec, uint8_t *inbuf, int32_t *bytesLeft){
                                                            // reference https://www.xiph.org/ogg/doc/rfc3533.txt
     int32_t ret = 0; (void)ret;
 
     int32_t idx = VORBIS_specialIndexOf(inbuf, "OggS", 8192);
     if(idx != 0){
-        if(s_f_oggContinuedPage) return ERR_VORBIS_DECODER_ASYNC;
+        if(dec->f_oggContinuedPage) return ERR_VORBIS_DECODER_ASYNC;
         inbuf += idx;
         *bytesLeft -= idx;
-        s_vorbisCurrentFilePos += idx;
+        dec->currentFilePos += idx;
     }
 
     int16_t segmentTableWrPtr = -1;
@@ -752,7 +713,7 @@ int32_t VORBISparseOGG(uint8_t *inbuf, int32_t *bytesLeft){
 
     // read the segment table (contains pageSegments bytes),  1...251: Length of the frame in bytes,
     // 255: A second byte is needed.  The total length is first_byte + second byte
-    s_vorbisSegmentLength = 0;
+    dec->segmentLength = 0;
     segmentTableWrPtr = -1;
 
     for(int32_t i = 0; i < pageSegments; i++){
@@ -763,11 +724,11 @@ int32_t VORBISparseOGG(uint8_t *inbuf, int32_t *bytesLeft){
             n+= *(inbuf + 27 + i);
         }
         segmentTableWrPtr++;
-        s_vorbisSegmentTable[segmentTableWrPtr] = n;
-        s_vorbisSegmentLength += n;
+        dec->segmentTable[segmentTableWrPtr] = n;
+        dec->segmentLength += n;
     }
-    s_vorbisSegmentTableSize = segmentTableWrPtr + 1;
-    s_vorbisCompressionRatio = (float)(960 * 2 * pageSegments)/s_vorbisSegmentLength;  // const 960 validBytes out
+    dec->segmentTableSize = segmentTableWrPtr + 1;
+    dec->compressionRatio = (float)(960 * 2 * pageSegments)/dec->segmentLength;  // const 960 validBytes out
 
     bool     continuedPage = headerType & 0x01; // set: page contains data of a packet continued from the previous page
     bool     firstPage     = headerType & 0x02; // set: this is the first page of a logical bitstream (bos)
@@ -775,22 +736,22 @@ int32_t VORBISparseOGG(uint8_t *inbuf, int32_t *bytesLeft){
 
     uint16_t headerSize    = pageSegments + 27;
 
-    // log_i("headerSize %i, s_vorbisSegmentLength %i, s_vorbisSegmentTableSize %i", headerSize, s_vorbisSegmentLength, s_vorbisSegmentTableSize);
+    // log_i("headerSize %i, segmentLength %i, segmentTableSize %i", headerSize, segmentLength, segmentTableSize);
     if(firstPage || continuedPage || lastPage){
     // log_w("firstPage %i  continuedPage %i  lastPage %i", firstPage, continuedPage, lastPage);
     }
 
     *bytesLeft -= headerSize;
     inbuf += headerSize;
-    s_vorbisCurrentFilePos += headerSize;
- //   if(s_pageNr < 4 && !continuedPage) s_pageNr++;
+    dec->currentFilePos += headerSize;
+ //   if(pageNr < 4 && !continuedPage) pageNr++;
 
-    s_f_oggFirstPage = firstPage;
-    s_f_oggContinuedPage = continuedPage;
-    s_f_oggLastPage = lastPage;
-    s_oggHeaderSize = headerSize;
+    dec->f_oggFirstPage = firstPage;
+    dec->f_oggContinuedPage = continuedPage;
+    dec->f_oggLastPage = lastPage;
+    dec->oggHeaderSize = headerSize;
 
-    if(firstPage) s_pageNr = 0;
+    if(firstPage) dec->pageNr = 0;
 
     return VORBIS_PARSE_OGG_DONE; // no error
 }
@@ -842,7 +803,7 @@ int32_t VORBISFindSyncWord(unsigned char *buf, int32_t nBytes){
     return ERR_VORBIS_OGG_SYNC_NOT_FOUND;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t vorbis_book_unpack(codebook_t *s) {
+int32_t vorbis_book_unpack(VORBISDecoder_t* dec, codebook_t *s) {
     char   *lengthlist = NULL;
     uint8_t quantvals = 0;
     int32_t i, j;
@@ -852,32 +813,32 @@ int32_t vorbis_book_unpack(codebook_t *s) {
     memset(s, 0, sizeof(*s));
 
     /* make sure alignment is correct */
-    if(bitReader(24) != 0x564342){
+    if(bitReader(dec, 24) != 0x564342){
         log_e("String \"BCV\" not found");
         goto _eofout;  // "BCV"
     }
 
     /* first the basic parameters */
-    ret = bitReader(16) ;
+    ret = bitReader(dec, 16) ;
     if(ret < 0) printf("error in vorbis_book_unpack, ret =%li\n", (long int)ret);
     if(ret > 255) printf("error in vorbis_book_unpack, ret =%li\n", (long int)ret);
     s->dim = (uint8_t)ret;
-    s->entries = bitReader(24);
+    s->entries = bitReader(dec, 24);
     if(s->entries == -1) {log_e("no entries in unpack codebooks ?");   goto _eofout;}
 
     /* codeword ordering.... length ordered or unordered? */
-    switch(bitReader(1)) {
+    switch(bitReader(dec, 1)) {
         case 0:
             /* unordered */
             lengthlist = (char *)__malloc_heap_psram(sizeof(*lengthlist) * s->entries);
 
             /* allocated but unused entries? */
-            if(bitReader(1)) {
+            if(bitReader(dec, 1)) {
                 /* yes, unused entries */
 
                 for(i = 0; i < s->entries; i++) {
-                    if(bitReader(1)) {
-                        int32_t num = bitReader(5);
+                    if(bitReader(dec, 1)) {
+                        int32_t num = bitReader(dec, 5);
                         if(num == -1) goto _eofout;
                         lengthlist[i] = num + 1;
                         s->used_entries++;
@@ -891,7 +852,7 @@ int32_t vorbis_book_unpack(codebook_t *s) {
                 /* all entries used; no tagging */
                 s->used_entries = s->entries;
                 for(i = 0; i < s->entries; i++) {
-                    int32_t num = bitReader(5);
+                    int32_t num = bitReader(dec, 5);
                     if(num == -1) goto _eofout;
                     lengthlist[i] = num + 1;
 
@@ -902,13 +863,13 @@ int32_t vorbis_book_unpack(codebook_t *s) {
         case 1:
             /* ordered */
             {
-                int32_t length = bitReader(5) + 1;
+                int32_t length = bitReader(dec, 5) + 1;
 
                 s->used_entries = s->entries;
                 lengthlist = (char *)__malloc_heap_psram(sizeof(*lengthlist) * s->entries);
 
                 for(i = 0; i < s->entries;) {
-                    int32_t num = bitReader(_ilog(s->entries - i));
+                    int32_t num = bitReader(dec, _ilog(s->entries - i));
                     if(num == -1) goto _eofout;
                     for(j = 0; j < num && i < s->entries; j++, i++) lengthlist[i] = length;
                     s->dec_maxlength = length;
@@ -922,12 +883,12 @@ int32_t vorbis_book_unpack(codebook_t *s) {
     }
 
     /* Do we have a mapping to unpack? */
-    if((maptype = bitReader(4)) > 0) {
-        s->q_min = _float32_unpack(bitReader(32), &s->q_minp);
-        s->q_del = _float32_unpack(bitReader(32), &s->q_delp);
+    if((maptype = bitReader(dec, 4)) > 0) {
+        s->q_min = _float32_unpack(bitReader(dec, 32), &s->q_minp);
+        s->q_del = _float32_unpack(bitReader(dec, 32), &s->q_delp);
 
-        s->q_bits = bitReader(4) + 1;
-        s->q_seq =  bitReader(1);
+        s->q_bits = bitReader(dec, 4) + 1;
+        s->q_seq =  bitReader(dec, 1);
 
         s->q_del >>= s->q_bits;
         s->q_delp += s->q_bits;
@@ -941,7 +902,7 @@ int32_t vorbis_book_unpack(codebook_t *s) {
             s->dec_nodeb = _determine_node_bytes(s->used_entries, _ilog(s->entries) / 8 + 1);
             s->dec_leafw = _determine_leaf_words(s->dec_nodeb, _ilog(s->entries) / 8 + 1);
             s->dec_type = 0;
-            ret = _make_decode_table(s, lengthlist, quantvals, maptype);
+            ret = _make_decode_table(dec, s, lengthlist, quantvals, maptype);
             if(ret != 0) {
                  goto _errout;
             }
@@ -962,9 +923,9 @@ int32_t vorbis_book_unpack(codebook_t *s) {
                     /* use dec_type 1: vector of packed values */
                     /* need quantized values before  */
                     s->q_val = __malloc_heap_psram(sizeof(uint16_t) * quantvals);
-                    for(i = 0; i < quantvals; i++) ((uint16_t *)s->q_val)[i] = bitReader(s->q_bits);
+                    for(i = 0; i < quantvals; i++) ((uint16_t *)s->q_val)[i] = bitReader(dec, s->q_bits);
 
-                    if(oggpack_eop()) {
+                    if(oggpack_eop(dec)) {
                         if(s->q_val) {free(s->q_val), s->q_val = NULL;}
                         goto _eofout;
                     }
@@ -972,7 +933,7 @@ int32_t vorbis_book_unpack(codebook_t *s) {
                     s->dec_type = 1;
                     s->dec_nodeb = _determine_node_bytes(s->used_entries, (s->q_bits * s->dim + 8) / 8);
                     s->dec_leafw = _determine_leaf_words(s->dec_nodeb, (s->q_bits * s->dim + 8) / 8);
-                    ret = _make_decode_table(s, lengthlist, quantvals, maptype);
+                    ret = _make_decode_table(dec, s, lengthlist, quantvals, maptype);
                     if(ret) {
                         if(s->q_val) {free(s->q_val), s->q_val = NULL;}
                         goto _errout;
@@ -985,21 +946,21 @@ int32_t vorbis_book_unpack(codebook_t *s) {
                     /* need quantized values before */
                     if(s->q_bits <= 8) {
                         s->q_val = __malloc_heap_psram(quantvals);
-                        for(i = 0; i < quantvals; i++) ((uint8_t *)s->q_val)[i] = bitReader(s->q_bits);
+                        for(i = 0; i < quantvals; i++) ((uint8_t *)s->q_val)[i] = bitReader(dec, s->q_bits);
                     }
                     else {
                         s->q_val = __malloc_heap_psram(quantvals * 2);
-                        for(i = 0; i < quantvals; i++) ((uint16_t *)s->q_val)[i] = bitReader(s->q_bits);
+                        for(i = 0; i < quantvals; i++) ((uint16_t *)s->q_val)[i] = bitReader(dec, s->q_bits);
                     }
 
-                    if(oggpack_eop()) goto _eofout;
+                    if(oggpack_eop(dec)) goto _eofout;
 
                     s->q_pack = _ilog(quantvals - 1);
                     s->dec_type = 2;
                     s->dec_nodeb = _determine_node_bytes(s->used_entries, (_ilog(quantvals - 1) * s->dim + 8) / 8);
                     s->dec_leafw = _determine_leaf_words(s->dec_nodeb, (_ilog(quantvals - 1) * s->dim + 8) / 8);
 
-                    ret = _make_decode_table(s, lengthlist, quantvals, maptype);
+                    ret = _make_decode_table(dec, s, lengthlist, quantvals, maptype);
                     if(ret){
                         goto _errout;
                     }
@@ -1017,7 +978,7 @@ int32_t vorbis_book_unpack(codebook_t *s) {
                 s->dec_type = 1;
                 s->dec_nodeb = _determine_node_bytes(s->used_entries, (s->q_bits * s->dim + 8) / 8);
                 s->dec_leafw = _determine_leaf_words(s->dec_nodeb, (s->q_bits * s->dim + 8) / 8);
-                if(_make_decode_table(s, lengthlist, quantvals, maptype)) goto _errout;
+                if(_make_decode_table(dec, s, lengthlist, quantvals, maptype)) goto _errout;
             }
             else {
                 /* use dec_type 3: scalar offset into packed value array */
@@ -1025,7 +986,7 @@ int32_t vorbis_book_unpack(codebook_t *s) {
                 s->dec_type = 3;
                 s->dec_nodeb = _determine_node_bytes(s->used_entries, _ilog(s->used_entries - 1) / 8 + 1);
                 s->dec_leafw = _determine_leaf_words(s->dec_nodeb, _ilog(s->used_entries - 1) / 8 + 1);
-                if(_make_decode_table(s, lengthlist, quantvals, maptype)) goto _errout;
+                if(_make_decode_table(dec, s, lengthlist, quantvals, maptype)) goto _errout;
 
                 /* get the vals & pack them */
                 s->q_pack = (s->q_bits + 7) / 8 * s->dim;
@@ -1033,11 +994,11 @@ int32_t vorbis_book_unpack(codebook_t *s) {
 
                 if(s->q_bits <= 8) {
                     for(i = 0; i < s->used_entries * s->dim; i++)
-                        ((uint8_t *)(s->q_val))[i] = bitReader(s->q_bits);
+                        ((uint8_t *)(s->q_val))[i] = bitReader(dec, s->q_bits);
                 }
                 else {
                     for(i = 0; i < s->used_entries * s->dim; i++)
-                        ((uint16_t *)(s->q_val))[i] = bitReader(s->q_bits);
+                        ((uint16_t *)(s->q_val))[i] = bitReader(dec, s->q_bits);
                 }
             }
             break;
@@ -1045,7 +1006,8 @@ int32_t vorbis_book_unpack(codebook_t *s) {
             log_e("maptype %i schould be 0, 1 or 2", maptype);
             goto _errout;
     }
-    if(oggpack_eop()) goto _eofout;
+    if(oggpack_eop(dec)) goto _eofout;
+    _make_lookup_table(dec, s);
     if(lengthlist) {free(lengthlist); lengthlist = NULL;}
     if(s->q_val)   {free(s->q_val), s->q_val = NULL;}
     return 0; // ok
@@ -1083,42 +1045,42 @@ const uint32_t mask[] = {0x00000000, 0x00000001, 0x00000003, 0x00000007, 0x00000
                          0x0fffffff, 0x1fffffff, 0x3fffffff, 0x7fffffff, 0xffffffff};
 
 
-void bitReader_clear(){
-    s_bitReader.data = NULL;
-    s_bitReader.headptr = NULL;
-    s_bitReader.length = 0;
-    s_bitReader.headend = 0;
-    s_bitReader.headbit = 0;
+void bitReader_clear(VORBISDecoder_t* dec){
+    dec->reader.data = NULL;
+    dec->reader.headptr = NULL;
+    dec->reader.length = 0;
+    dec->reader.headend = 0;
+    dec->reader.headbit = 0;
 }
 
-void bitReader_setData(uint8_t *buff, uint16_t buffSize){
-    s_bitReader.data = buff;
-    s_bitReader.headptr = buff;
-    s_bitReader.length = buffSize;
-    s_bitReader.headend = buffSize * 8;
-    s_bitReader.headbit = 0;
+void bitReader_setData(VORBISDecoder_t* dec, uint8_t *buff, uint16_t buffSize){
+    dec->reader.data = buff;
+    dec->reader.headptr = buff;
+    dec->reader.length = buffSize;
+    dec->reader.headend = buffSize * 8;
+    dec->reader.headbit = 0;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 /* Read in bits without advancing the bitptr; bits <= 32 */
-int32_t bitReader_look(uint16_t nBits){
+int32_t bitReader_look(VORBISDecoder_t* dec, uint16_t nBits){
     uint32_t m = mask[nBits];
     int32_t  ret = 0;
 
-    nBits += s_bitReader.headbit;
+    nBits += dec->reader.headbit;
 
-    if(nBits >= s_bitReader.headend << 3) {
-        uint8_t       *ptr = s_bitReader.headptr;
+    if(nBits >= dec->reader.headend << 3) {
+        uint8_t       *ptr = dec->reader.headptr;
         if(nBits) {
-            ret = *ptr++ >> s_bitReader.headbit;
+            ret = *ptr++ >> dec->reader.headbit;
             if(nBits > 8) {
-                ret |= *ptr++ << (8 - s_bitReader.headbit);
+                ret |= *ptr++ << (8 - dec->reader.headbit);
                 if(nBits > 16) {
-                    ret |= *ptr++ << (16 - s_bitReader.headbit);
+                    ret |= *ptr++ << (16 - dec->reader.headbit);
                     if(nBits > 24) {
-                         ret |= *ptr++ << (24 - s_bitReader.headbit);
-                        if(nBits > 32 && s_bitReader.headbit) {
-                            ret |= *ptr << (32 - s_bitReader.headbit);
+                         ret |= *ptr++ << (24 - dec->reader.headbit);
+                        if(nBits > 32 && dec->reader.headbit) {
+                            ret |= *ptr << (32 - dec->reader.headbit);
                         }
                     }
                 }
@@ -1127,14 +1089,14 @@ int32_t bitReader_look(uint16_t nBits){
     }
     else {
         /* make this a switch jump-table */
-        ret = s_bitReader.headptr[0] >> s_bitReader.headbit;
+        ret = dec->reader.headptr[0] >> dec->reader.headbit;
         if(nBits > 8) {
-            ret |= s_bitReader.headptr[1] << (8 - s_bitReader.headbit);
+            ret |= dec->reader.headptr[1] << (8 - dec->reader.headbit);
             if(nBits > 16) {
-                ret |= s_bitReader.headptr[2] << (16 - s_bitReader.headbit);
+                ret |= dec->reader.headptr[2] << (16 - dec->reader.headbit);
                 if(nBits > 24) {
-                    ret |= s_bitReader.headptr[3] << (24 - s_bitReader.headbit);
-                    if(nBits > 32 && s_bitReader.headbit) ret |= s_bitReader.headptr[4] << (32 - s_bitReader.headbit);
+                    ret |= dec->reader.headptr[3] << (24 - dec->reader.headbit);
+                    if(nBits > 32 && dec->reader.headbit) ret |= dec->reader.headptr[4] << (32 - dec->reader.headbit);
                 }
             }
         }
@@ -1144,20 +1106,28 @@ int32_t bitReader_look(uint16_t nBits){
     return ret;
 }
 
+/* the next 32 bits without advancing the bitptr, assembled from one word and the following byte */
+uint32_t bitReader_look32(VORBISDecoder_t* dec){
+    const uint8_t *p = dec->reader.headptr;
+    uint32_t ret = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    if(dec->reader.headbit) ret = (ret >> dec->reader.headbit) | ((uint32_t)p[4] << (32 - dec->reader.headbit));
+    return ret;
+}
+
 /* bits <= 32 */
-int32_t bitReader(uint16_t nBits) {
-    int32_t ret = bitReader_look(nBits);
-    if(bitReader_adv(nBits) < 0) return -1;
+int32_t bitReader(VORBISDecoder_t* dec, uint16_t nBits) {
+    int32_t ret = bitReader_look(dec, nBits);
+    if(bitReader_adv(dec, nBits) < 0) return -1;
     return (ret);
 }
 
 /* limited to 32 at a time */
-int8_t bitReader_adv(uint16_t nBits) {
-    nBits += s_bitReader.headbit;
-    s_bitReader.headbit = nBits & 7;
-    s_bitReader.headend -= (nBits >> 3);
-    s_bitReader.headptr += (nBits >> 3);
-    if(s_bitReader.headend < 1){
+int8_t bitReader_adv(VORBISDecoder_t* dec, uint16_t nBits) {
+    nBits += dec->reader.headbit;
+    dec->reader.headbit = nBits & 7;
+    dec->reader.headend -= (nBits >> 3);
+    dec->reader.headptr += (nBits >> 3);
+    if(dec->reader.headend < 1){
         return -1;
         log_e("error in bitreader");
     }
@@ -1219,13 +1189,13 @@ int32_t _determine_leaf_words(int32_t nodeb, int32_t leafwidth) {
     return 1;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t _make_decode_table(codebook_t *s, char *lengthlist, uint8_t quantvals, int32_t maptype) {
+int32_t _make_decode_table(VORBISDecoder_t* dec, codebook_t *s, char *lengthlist, uint8_t quantvals, int32_t maptype) {
     uint32_t *work = nullptr;
 
     if(s->dec_nodeb == 4) {
         s->dec_table = __malloc_heap_psram((s->used_entries * 2 + 1) * sizeof(*work));
         /* +1 (rather than -2) is to accommodate 0 and 1 sized books, which are specialcased to nodeb==4 */
-        if(_make_words(lengthlist, s->entries, (uint32_t *)s->dec_table, quantvals, s, maptype)) return 1;
+        if(_make_words(dec, lengthlist, s->entries, (uint32_t *)s->dec_table, quantvals, s, maptype)) return 1;
 
         return 0;
     }
@@ -1233,7 +1203,7 @@ int32_t _make_decode_table(codebook_t *s, char *lengthlist, uint8_t quantvals, i
     work = (uint32_t *)__calloc_heap_psram((uint32_t)(s->used_entries * 2 - 2) , sizeof(*work));
     if(!work) log_e("oom");
 
-    if(_make_words(lengthlist, s->entries, work, quantvals, s, maptype)) {
+    if(_make_words(dec, lengthlist, s->entries, work, quantvals, s, maptype)) {
         if(work) {free(work); work = NULL;}
         return 1;
     }
@@ -1327,8 +1297,32 @@ int32_t _make_decode_table(codebook_t *s, char *lengthlist, uint8_t quantvals, i
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
+/* resolve every combination of the first dec_lookup_bits bits once, so that decode_packed_entry_number() needs a single
+   access for all codewords up to this length. Tables are placed in DRAM up to VORBIS_LOOKUP_DRAM_LIMIT, then in PSRAM */
+void _make_lookup_table(VORBISDecoder_t* dec, codebook_t *s) {
+    s->dec_lookup_bits = _min((uint32_t)dec->lookupBits, s->dec_maxlength);
+    if(s->used_entries < 2 || s->dec_lookup_bits == 0) return;
+
+    uint32_t n = 1 << s->dec_lookup_bits;
+    uint32_t size = n * (sizeof(uint32_t) + sizeof(uint8_t));
+
+    if(dec->lookupDRAM + size <= VORBIS_LOOKUP_DRAM_LIMIT) {
+        s->dec_lookup = (uint32_t *)CodecMem_Alloc(size, CODEC_MEM_DRAM, "vorbis lookup");
+        if(s->dec_lookup) dec->lookupDRAM += size;
+    }
+    if(!s->dec_lookup) s->dec_lookup = (uint32_t *)__malloc_heap_psram(size);
+    if(!s->dec_lookup) { s->dec_lookup_bits = 0; return; } // not fatal, decode by walking the tree
+    s->dec_lookup_len = (uint8_t *)(s->dec_lookup + n);
+
+    for(uint32_t idx = 0; idx < n; idx++) {
+        uint32_t chase = 0;
+        s->dec_lookup_len[idx] = chase_decode_tree(s, idx, 0, s->dec_lookup_bits, &chase);
+        s->dec_lookup[idx] = chase;
+    }
+}
+//---------------------------------------------------------------------------------------------------------------------
 /* given a list of word lengths, number of used entries, and byte width of a leaf, generate the decode table */
-int32_t _make_words(char *l, uint16_t n, uint32_t *work, uint8_t quantvals, codebook_t *b, int32_t maptype) {
+int32_t _make_words(VORBISDecoder_t* dec, char *l, uint16_t n, uint32_t *work, uint8_t quantvals, codebook_t *b, int32_t maptype) {
 
     int32_t  i, j, count = 0;
     uint32_t top = 0;
@@ -1364,7 +1358,7 @@ int32_t _make_words(char *l, uint16_t n, uint32_t *work, uint8_t quantvals, code
                         top++;
                         work[chase * 2 + 1] = 0;
                     }
-                    work[chase * 2 + bit] = decpack(i, count++, quantvals, b, maptype) | 0x80000000;
+                    work[chase * 2 + bit] = decpack(dec, i, count++, quantvals, b, maptype) | 0x80000000;
                 }
 
                 /* Look to see if the next shorter marker points to the node above. if so, update it and repeat.  */
@@ -1392,7 +1386,7 @@ int32_t _make_words(char *l, uint16_t n, uint32_t *work, uint8_t quantvals, code
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
-uint32_t decpack(int32_t entry, int32_t used_entry, uint8_t quantvals, codebook_t *b, int32_t maptype) {
+uint32_t decpack(VORBISDecoder_t* dec, int32_t entry, int32_t used_entry, uint8_t quantvals, codebook_t *b, int32_t maptype) {
     uint32_t ret = 0;
 
     switch(b->dec_type) {
@@ -1416,7 +1410,7 @@ uint32_t decpack(int32_t entry, int32_t used_entry, uint8_t quantvals, codebook_
                 for(uint8_t j = 0; j < b->dim; j++) {
                     assert((b->q_bits * j) >= 0);
                     uint32_t shift = (uint32_t)b->q_bits * j;
-                    int32_t  _ret = bitReader(b->q_bits) << shift;
+                    int32_t  _ret = bitReader(dec, b->q_bits) << shift;
                     assert(_ret >= 0);
                     ret |= (uint32_t)_ret;
                 }
@@ -1467,9 +1461,9 @@ uint8_t _book_maptype1_quantvals(codebook_t *b) {
     }
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t oggpack_eop() {
-    if(s_bitReader.headptr -s_bitReader.data  > s_setupHeaderLength){
-        log_i("s_bitReader.headptr %i, s_setupHeaderLength %i", s_bitReader.headptr, s_setupHeaderLength);
+int32_t oggpack_eop(VORBISDecoder_t* dec) {
+    if(dec->reader.headptr -dec->reader.data  > dec->setupHeaderLength){
+        log_i("reader.headptr %i, setupHeaderLength %i", dec->reader.headptr, dec->setupHeaderLength);
         log_i("ogg package 3 overflow");
          return -1;
     }
@@ -1481,32 +1475,33 @@ void vorbis_book_clear(codebook_t *b) {
    info struct */
     if(b->q_val) free(b->q_val);
     if(b->dec_table) free(b->dec_table);
+    if(b->dec_lookup) free(b->dec_lookup); // dec_lookup_len is part of the same block
 
     memset(b, 0, sizeof(*b));
 }
 //---------------------------------------------------------------------------------------------------------------------
- vorbis_info_floor_t* floor0_info_unpack() {
+vorbis_info_floor_t* floor0_info_unpack(VORBISDecoder_t* dec) {
 
     int32_t               j;
 
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)__malloc_heap_psram(sizeof(*info));
-    info->order =    bitReader( 8);
-    info->rate =     bitReader(16);
-    info->barkmap =  bitReader(16);
-    info->ampbits =  bitReader( 6);
-    info->ampdB =    bitReader( 8);
-    info->numbooks = bitReader( 4) + 1;
+    info->order =    bitReader(dec,  8);
+    info->rate =     bitReader(dec, 16);
+    info->barkmap =  bitReader(dec, 16);
+    info->ampbits =  bitReader(dec,  6);
+    info->ampdB =    bitReader(dec,  8);
+    info->numbooks = bitReader(dec,  4) + 1;
 
     if(info->order < 1) goto err_out;
     if(info->rate < 1) goto err_out;
     if(info->barkmap < 1) goto err_out;
 
     for(j = 0; j < info->numbooks; j++) {
-        info->books[j] = bitReader(8);
-        if(info->books[j] >= s_nrOfCodebooks) goto err_out;
+        info->books[j] = bitReader(dec, 8);
+        if(info->books[j] >= dec->nrOfCodebooks) goto err_out;
     }
 
-    if(oggpack_eop()) goto err_out;
+    if(oggpack_eop(dec)) goto err_out;
     return (info);
 
 err_out:
@@ -1514,41 +1509,41 @@ err_out:
     return (NULL);
 }
 //---------------------------------------------------------------------------------------------------------------------
-vorbis_info_floor_t* floor1_info_unpack() {
+vorbis_info_floor_t* floor1_info_unpack(VORBISDecoder_t* dec) {
 
     int32_t j, k, count = 0, maxclass = -1, rangebits;
 
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)__calloc_heap_psram(1, sizeof(vorbis_info_floor_t));
     /* read partitions */
-    info->partitions = bitReader(5); /* only 0 to 31 legal */
+    info->partitions = bitReader(dec, 5); /* only 0 to 31 legal */
     info->partitionclass = (uint8_t *)__malloc_heap_psram(info->partitions * sizeof(*info->partitionclass));
     for(j = 0; j < info->partitions; j++) {
-        info->partitionclass[j] = bitReader(4); /* only 0 to 15 legal */
+        info->partitionclass[j] = bitReader(dec, 4); /* only 0 to 15 legal */
         if(maxclass < info->partitionclass[j]) maxclass = info->partitionclass[j];
     }
 
     /* read partition classes */
     info->_class = (floor1class_t *)__malloc_heap_psram((uint32_t)(maxclass + 1) * sizeof(*info->_class));
     for(j = 0; j < maxclass + 1; j++) {
-        info->_class[j].class_dim = bitReader(3) + 1; /* 1 to 8 */
-        info->_class[j].class_subs = bitReader(2);    /* 0,1,2,3 bits */
-        if(oggpack_eop() < 0) goto err_out;
+        info->_class[j].class_dim = bitReader(dec, 3) + 1; /* 1 to 8 */
+        info->_class[j].class_subs = bitReader(dec, 2);    /* 0,1,2,3 bits */
+        if(oggpack_eop(dec) < 0) goto err_out;
         if(info->_class[j].class_subs){
-            info->_class[j].class_book = bitReader(8);
+            info->_class[j].class_book = bitReader(dec, 8);
         }
         else{
             info->_class[j].class_book = 0;
         }
-        if(info->_class[j].class_book >= s_nrOfCodebooks) goto err_out;
+        if(info->_class[j].class_book >= dec->nrOfCodebooks) goto err_out;
         for(k = 0; k < (1 << info->_class[j].class_subs); k++) {
-            info->_class[j].class_subbook[k] = (uint8_t)bitReader(8) - 1;
-            if(info->_class[j].class_subbook[k] >= s_nrOfCodebooks && info->_class[j].class_subbook[k] != 0xff) goto err_out;
+            info->_class[j].class_subbook[k] = (uint8_t)bitReader(dec, 8) - 1;
+            if(info->_class[j].class_subbook[k] >= dec->nrOfCodebooks && info->_class[j].class_subbook[k] != 0xff) goto err_out;
         }
     }
 
     /* read the post list */
-    info->mult = bitReader(2) + 1; /* only 1,2,3,4 legal now */
-    rangebits = bitReader(4);
+    info->mult = bitReader(dec, 2) + 1; /* only 1,2,3,4 legal now */
+    rangebits = bitReader(dec, 4);
 
     for(j = 0, k = 0; j < info->partitions; j++) count += info->_class[info->partitionclass[j]].class_dim;
     info->postlist = (uint16_t *)__malloc_heap_psram((count + 2) * sizeof(*info->postlist));
@@ -1561,11 +1556,11 @@ vorbis_info_floor_t* floor1_info_unpack() {
         count += info->_class[info->partitionclass[j]].class_dim;
         if(count > VIF_POSIT) goto err_out;
         for(; k < count; k++) {
-            int32_t t = info->postlist[k + 2] = bitReader(rangebits);
+            int32_t t = info->postlist[k + 2] = bitReader(dec, rangebits);
             if(t >= (1 << rangebits)) goto err_out;
         }
     }
-    if(oggpack_eop()) goto err_out;
+    if(oggpack_eop(dec)) goto err_out;
     info->postlist[0] = 0;
     info->postlist[1] = 1 << rangebits;
     info->posts = count + 2;
@@ -1604,33 +1599,33 @@ err_out:
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* vorbis_info is for range checking */
-int32_t res_unpack(vorbis_info_residue_t *info){
+int32_t res_unpack(VORBISDecoder_t* dec, vorbis_info_residue_t *info){
     int32_t               j, k;
     memset(info, 0, sizeof(*info));
 
-    info->type =       bitReader(16);
+    info->type =       bitReader(dec, 16);
     if(info->type > 2 || info->type < 0) goto errout;
-    info->begin =      bitReader(24);
-    info->end =        bitReader(24);
-    info->grouping =   bitReader(24) + 1;
-    info->partitions = bitReader(6) + 1;
-    info->groupbook =  bitReader(8);
-    if(info->groupbook >= s_nrOfCodebooks) goto errout;
+    info->begin =      bitReader(dec, 24);
+    info->end =        bitReader(dec, 24);
+    info->grouping =   bitReader(dec, 24) + 1;
+    info->partitions = bitReader(dec, 6) + 1;
+    info->groupbook =  bitReader(dec, 8);
+    if(info->groupbook >= dec->nrOfCodebooks) goto errout;
 
     info->stagemasks = (uint8_t *)__malloc_heap_psram(info->partitions * sizeof(*info->stagemasks));
     info->stagebooks = (uint8_t *)__malloc_heap_psram(info->partitions * 8 * sizeof(*info->stagebooks));
 
     for(j = 0; j < info->partitions; j++) {
-        int32_t cascade = bitReader(3);
-        if(bitReader(1)) cascade |= (bitReader(5) << 3);
+        int32_t cascade = bitReader(dec, 3);
+        if(bitReader(dec, 1)) cascade |= (bitReader(dec, 5) << 3);
         info->stagemasks[j] = cascade;
     }
 
     for(j = 0; j < info->partitions; j++) {
         for(k = 0; k < 8; k++) {
             if((info->stagemasks[j] >> k) & 1) {
-                uint8_t book = bitReader(8);
-                if(book >= s_nrOfCodebooks) goto errout;
+                uint8_t book = bitReader(dec, 8);
+                if(book >= dec->nrOfCodebooks) goto errout;
                 info->stagebooks[j * 8 + k] = book;
                 if(k + 1 > info->stages) info->stages = k + 1;
             }
@@ -1639,7 +1634,7 @@ int32_t res_unpack(vorbis_info_residue_t *info){
         }
     }
 
-    if(oggpack_eop()) goto errout;
+    if(oggpack_eop(dec)) goto errout;
 
     return 0;
 errout:
@@ -1648,45 +1643,45 @@ errout:
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* also responsible for range checking */
-int32_t mapping_info_unpack(vorbis_info_mapping_t *info) {
+int32_t mapping_info_unpack(VORBISDecoder_t* dec, vorbis_info_mapping_t *info) {
     int32_t               i;
     memset(info, 0, sizeof(*info));
 
-    if(bitReader(1)) info->submaps = bitReader(4) + 1;
+    if(bitReader(dec, 1)) info->submaps = bitReader(dec, 4) + 1;
     else
         info->submaps = 1;
 
-    if(bitReader(1)) {
-        info->coupling_steps = bitReader(8) + 1;
+    if(bitReader(dec, 1)) {
+        info->coupling_steps = bitReader(dec, 8) + 1;
         info->coupling = (coupling_step_t *)__malloc_heap_psram(info->coupling_steps * sizeof(*info->coupling));
 
         for(i = 0; i < info->coupling_steps; i++) {
-            int32_t testM = info->coupling[i].mag = bitReader(ilog(s_vorbisChannels));
-            int32_t testA = info->coupling[i].ang = bitReader(ilog(s_vorbisChannels));
+            int32_t testM = info->coupling[i].mag = bitReader(dec, ilog(dec->channels));
+            int32_t testA = info->coupling[i].ang = bitReader(dec, ilog(dec->channels));
 
-            if(testM < 0 || testA < 0 || testM == testA || testM >= s_vorbisChannels || testA >= s_vorbisChannels) goto err_out;
+            if(testM < 0 || testA < 0 || testM == testA || testM >= dec->channels || testA >= dec->channels) goto err_out;
         }
     }
 
-    if(bitReader(2) > 0) goto err_out;
+    if(bitReader(dec, 2) > 0) goto err_out;
     /* 2,3:reserved */
 
     if(info->submaps > 1) {
-        info->chmuxlist = (uint8_t *)__malloc_heap_psram(sizeof(*info->chmuxlist) * s_vorbisChannels);
-        for(i = 0; i < s_vorbisChannels; i++) {
-            info->chmuxlist[i] = bitReader(4);
+        info->chmuxlist = (uint8_t *)__malloc_heap_psram(sizeof(*info->chmuxlist) * dec->channels);
+        for(i = 0; i < dec->channels; i++) {
+            info->chmuxlist[i] = bitReader(dec, 4);
             if(info->chmuxlist[i] >= info->submaps) goto err_out;
         }
     }
 
     info->submaplist = (submap_t *)__malloc_heap_psram(sizeof(*info->submaplist) * info->submaps);
     for(i = 0; i < info->submaps; i++) {
-        int32_t temp = bitReader(8);
+        int32_t temp = bitReader(dec, 8);
         (void)temp;
-        info->submaplist[i].floor = bitReader(8);
-        if(info->submaplist[i].floor >= s_nrOfFloors) goto err_out;
-        info->submaplist[i].residue = bitReader(8);
-        if(info->submaplist[i].residue >= s_nrOfResidues) goto err_out;
+        info->submaplist[i].floor = bitReader(dec, 8);
+        if(info->submaplist[i].floor >= dec->nrOfFloors) goto err_out;
+        info->submaplist[i].residue = bitReader(dec, 8);
+        if(info->submaplist[i].residue >= dec->nrOfResidues) goto err_out;
     }
 
     return 0;
@@ -1764,17 +1759,39 @@ void mapping_clear_info(vorbis_info_mapping_t *info) {
 //      ⏫⏫⏫    O G G      I M P L     A B O V E  ⏫⏫⏫
 //      ⏬⏬⏬ V O R B I S   I M P L     B E L O W  ⏬⏬⏬
 //---------------------------------------------------------------------------------------------------------------------
-vorbis_dsp_state_t *vorbis_dsp_create() {
+vorbis_dsp_state_t *vorbis_dsp_create(VORBISDecoder_t* dec) {
     int32_t i;
 
     vorbis_dsp_state_t *v = (vorbis_dsp_state_t *)__calloc_heap_psram(1, sizeof(vorbis_dsp_state_t));
 
-    v->work = (int32_t **)__malloc_heap_psram(s_vorbisChannels * sizeof(*v->work));
-    v->mdctright = (int32_t **)__malloc_heap_psram(s_vorbisChannels* sizeof(*v->mdctright));
+    v->work = (int32_t **)__malloc_heap_psram(dec->channels * sizeof(*v->work));
+    v->mdctright = (int32_t **)__malloc_heap_psram(dec->channels* sizeof(*v->mdctright));
 
-    for(i = 0; i < s_vorbisChannels; i++) {
-        v->work[i] = (int32_t *)__calloc_heap_psram(1, (s_blocksizes[1] >> 1) * sizeof(*v->work[i]));
-        v->mdctright[i] = (int32_t *)__calloc_heap_psram(1, (s_blocksizes[1] >> 2) * sizeof(*v->mdctright[i]));
+    for(i = 0; i < dec->channels; i++) {
+        v->work[i] = (int32_t *)__calloc_heap_psram(1, (dec->blocksizes[1] >> 1) * sizeof(*v->work[i]));
+        v->mdctright[i] = (int32_t *)__calloc_heap_psram(1, (dec->blocksizes[1] >> 2) * sizeof(*v->mdctright[i]));
+    }
+
+    dec->sincos0 = sincos_lookup0; // imdct twiddles in flash, unless the fused path has its copy
+    dec->sincos1 = sincos_lookup1;
+
+    /* fused imdct, window and overlap-add for long blocks up to 2048: the transform runs in a scratch buffer with a copy
+       of the twiddles, both HOT (DRAM first), the PSRAM work buffers only hold the spectrum. Without the memory the
+       transform stays in place */
+    if(dec->blocksizes[1] <= 2048 && dec->f_fusedImdct) {
+        v->imdct = (int32_t *)CodecMem_Alloc((dec->blocksizes[1] >> 1) * sizeof(*v->imdct), CODEC_MEM_HOT, "vorbis imdct");
+        v->sincos = (int32_t *)CodecMem_Alloc(sizeof(sincos_lookup0) + sizeof(sincos_lookup1), CODEC_MEM_HOT, "vorbis imdct");
+        if(v->imdct && v->sincos) {
+            const size_t n0 = sizeof(sincos_lookup0) / sizeof(sincos_lookup0[0]); // lookup1 follows lookup0
+            memcpy(v->sincos, sincos_lookup0, sizeof(sincos_lookup0));
+            memcpy(v->sincos + n0, sincos_lookup1, sizeof(sincos_lookup1));
+            dec->sincos0 = v->sincos;
+            dec->sincos1 = v->sincos + n0;
+        }
+        else {
+            if(v->imdct)  {free(v->imdct);  v->imdct = NULL;}
+            if(v->sincos) {free(v->sincos); v->sincos = NULL;}
+        }
     }
 
     v->lW = 0; /* previous window size */
@@ -1786,64 +1803,81 @@ vorbis_dsp_state_t *vorbis_dsp_create() {
     return v;
 }
 //---------------------------------------------------------------------------------------------------------------------
-void vorbis_dsp_destroy(vorbis_dsp_state_t *v) {
+void vorbis_dsp_destroy(VORBISDecoder_t* dec, vorbis_dsp_state_t *v) {
     int32_t i;
     if(v) {
         if(v->work) {
-            for(i = 0; i < s_vorbisChannels; i++) {
+            for(i = 0; i < dec->channels; i++) {
                 if(v->work[i]) {free(v->work[i]); v->work[i] = NULL;}
             }
             if(v->work){free(v->work); v->work = NULL;}
         }
         if(v->mdctright) {
-            for(i = 0; i < s_vorbisChannels; i++) {
+            for(i = 0; i < dec->channels; i++) {
                 if(v->mdctright[i]){free(v->mdctright[i]); v->mdctright[i] = NULL;}
             }
             if(v->mdctright){free(v->mdctright); v->mdctright = NULL;}
         }
+        if(v->imdct)  {free(v->imdct);  v->imdct = NULL;}
+        if(v->sincos) {free(v->sincos); v->sincos = NULL;}
+        dec->sincos0 = sincos_lookup0;
+        dec->sincos1 = sincos_lookup1;
         free(v);
         v = NULL;
     }
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t vorbis_dsp_synthesis(uint8_t* inbuf, uint16_t len, int16_t* outbuf) {
+int32_t vorbis_dsp_synthesis(VORBISDecoder_t* dec, uint8_t* inbuf, uint16_t len, int16_t* outbuf) {
 
     int32_t mode, i;
 
     /* Check the packet type */
-    if(bitReader(1) != 0)  {
+    if(bitReader(dec, 1) != 0)  {
         /* Oops.  This is not an audio data packet */
         return OV_ENOTAUDIO;
     }
 
     /* read our mode and pre/post windowsize */
-    mode = bitReader(ilog(s_nrOfModes));
-    if(mode == -1 || mode >= s_nrOfModes) return OV_EBADPACKET;
+    mode = bitReader(dec, ilog(dec->nrOfModes));
+    if(mode == -1 || mode >= dec->nrOfModes) return OV_EBADPACKET;
 
     /* shift information we still need from last window */
-    s_dsp_state->lW = s_dsp_state->W;
-    s_dsp_state->W = s_mode_param[mode].blockflag;
-    for(i = 0; i < s_vorbisChannels; i++){
-        mdct_shift_right(s_blocksizes[s_dsp_state->lW], s_dsp_state->work[i], s_dsp_state->mdctright[i]);
+    dec->dsp_state->lW = dec->dsp_state->W;
+    dec->dsp_state->W = dec->mode_param[mode].blockflag;
+    if(!dec->dsp_state->imdct) { // the fused path has already kept the right half of the last block
+        for(i = 0; i < dec->channels; i++){
+            mdct_shift_right(dec->blocksizes[dec->dsp_state->lW], dec->dsp_state->work[i], dec->dsp_state->mdctright[i]);
+        }
     }
-    if(s_dsp_state->W) {
+    if(dec->dsp_state->W) {
         int32_t temp;
-        bitReader(1);
-        temp = bitReader(1);
+        bitReader(dec, 1);
+        temp = bitReader(dec, 1);
         if(temp == -1) return OV_EBADPACKET;
     }
 
     /* packet decode and portions of synthesis that rely on only this block */
     {
-        mapping_inverse(s_map_param + s_mode_param[mode].mapping);
+        mapping_inverse(dec, dec->map_param + dec->mode_param[mode].mapping);
 
-        if(s_dsp_state->out_begin == -1) {
-            s_dsp_state->out_begin = 0;
-            s_dsp_state->out_end = 0;
+        if(dec->dsp_state->out_begin == -1) {
+            dec->dsp_state->out_begin = 0;
+            dec->dsp_state->out_end = 0;
         }
         else {
-            s_dsp_state->out_begin = 0;
-            s_dsp_state->out_end = s_blocksizes[s_dsp_state->lW] / 4 + s_blocksizes[s_dsp_state->W] / 4;
+            dec->dsp_state->out_begin = 0;
+            dec->dsp_state->out_end = dec->blocksizes[dec->dsp_state->lW] / 4 + dec->blocksizes[dec->dsp_state->W] / 4;
+        }
+    }
+
+    if(dec->dsp_state->imdct) {
+        int32_t n = dec->blocksizes[dec->dsp_state->W];
+        int32_t samples = vorbis_dsp_pcmcount(dec, VORBIS_OUTBUFF_SIZE);
+        for(i = 0; i < dec->channels; i++) {
+            memcpy(dec->dsp_state->imdct, dec->dsp_state->work[i], (n >> 1) * sizeof(*dec->dsp_state->imdct));
+            mdct_backward(dec, n, dec->dsp_state->imdct);
+            if(samples && outbuf) vorbis_dsp_lap(dec, i, dec->dsp_state->imdct, outbuf, samples);
+            mdct_shift_right(n, dec->dsp_state->imdct, dec->dsp_state->mdctright[i]);
         }
     }
 
@@ -1858,18 +1892,18 @@ void mdct_shift_right(int32_t n, int32_t *in, int32_t *right) {
     for(i = 0; i < n; i++) right[i] = in[i << 1];
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t mapping_inverse(vorbis_info_mapping_t *info) {
+int32_t mapping_inverse(VORBISDecoder_t* dec, vorbis_info_mapping_t *info) {
 
     int32_t     i, j;
-    int32_t n = s_blocksizes[s_dsp_state->W];
+    int32_t n = dec->blocksizes[dec->dsp_state->W];
 
-    int32_t **pcmbundle = (int32_t **)alloca(sizeof(*pcmbundle) * s_vorbisChannels);
-    int32_t      *zerobundle = (int32_t *)alloca(sizeof(*zerobundle) * s_vorbisChannels);
-    int32_t      *nonzero = (int32_t *)alloca(sizeof(*nonzero) * s_vorbisChannels);
-    int32_t **floormemo = (int32_t **)alloca(sizeof(*floormemo) * s_vorbisChannels);
+    int32_t **pcmbundle = (int32_t **)alloca(sizeof(*pcmbundle) * dec->channels);
+    int32_t      *zerobundle = (int32_t *)alloca(sizeof(*zerobundle) * dec->channels);
+    int32_t      *nonzero = (int32_t *)alloca(sizeof(*nonzero) * dec->channels);
+    int32_t **floormemo = (int32_t **)alloca(sizeof(*floormemo) * dec->channels);
 
     /* recover the spectral envelope; store it in the PCM vector for now */
-    for(i = 0; i < s_vorbisChannels; i++) {
+    for(i = 0; i < dec->channels; i++) {
 
         int32_t submap = 0;
         int32_t floorno;
@@ -1877,21 +1911,21 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
         if(info->submaps > 1) submap = info->chmuxlist[i];
         floorno = info->submaplist[submap].floor;
 
-        if(s_floor_type[floorno]) {
+        if(dec->floor_type[floorno]) {
             /* floor 1 */
-            floormemo[i] = (int32_t *)alloca(sizeof(*floormemo[i]) * floor1_memosize(s_floor_param[floorno]));
-            floormemo[i] = floor1_inverse1(s_floor_param[floorno], floormemo[i]);
+            floormemo[i] = (int32_t *)alloca(sizeof(*floormemo[i]) * floor1_memosize(dec->floor_param[floorno]));
+            floormemo[i] = floor1_inverse1(dec, dec->floor_param[floorno], floormemo[i]);
         }
         else {
             /* floor 0 */
-            floormemo[i] = (int32_t *)alloca(sizeof(*floormemo[i]) * floor0_memosize(s_floor_param[floorno]));
-            floormemo[i] = floor0_inverse1(s_floor_param[floorno], floormemo[i]);
+            floormemo[i] = (int32_t *)alloca(sizeof(*floormemo[i]) * floor0_memosize(dec->floor_param[floorno]));
+            floormemo[i] = floor0_inverse1(dec, dec->floor_param[floorno], floormemo[i]);
         }
 
         if(floormemo[i]) nonzero[i] = 1;
         else
             nonzero[i] = 0;
-        memset(s_dsp_state->work[i], 0, sizeof(*s_dsp_state->work[i]) * n / 2);
+        memset(dec->dsp_state->work[i], 0, sizeof(*dec->dsp_state->work[i]) * n / 2);
     }
 
     /* channel coupling can 'dirty' the nonzero listing */
@@ -1905,16 +1939,16 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
     /* recover the residue into our working vectors */
     for(i = 0; i < info->submaps; i++) {
         uint8_t ch_in_bundle = 0;
-        for(j = 0; j < s_vorbisChannels; j++) {
+        for(j = 0; j < dec->channels; j++) {
             if(!info->chmuxlist || info->chmuxlist[j] == i) {
                 if(nonzero[j]) zerobundle[ch_in_bundle] = 1;
                 else
                     zerobundle[ch_in_bundle] = 0;
-                pcmbundle[ch_in_bundle++] = s_dsp_state->work[j];
+                pcmbundle[ch_in_bundle++] = dec->dsp_state->work[j];
             }
         }
 
-        res_inverse(s_residue_param + info->submaplist[i].residue, pcmbundle, zerobundle, ch_in_bundle);
+        res_inverse(dec, dec->residue_param + info->submaplist[i].residue, pcmbundle, zerobundle, ch_in_bundle);
     }
 
     // for(j=0;j<vi->channels;j++)
@@ -1922,8 +1956,8 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
 
     /* channel coupling */
     for(i = info->coupling_steps - 1; i >= 0; i--) {
-        int32_t *pcmM = s_dsp_state->work[info->coupling[i].mag];
-        int32_t *pcmA = s_dsp_state->work[info->coupling[i].ang];
+        int32_t *pcmM = dec->dsp_state->work[info->coupling[i].mag];
+        int32_t *pcmA = dec->dsp_state->work[info->coupling[i].ang];
 
         for(j = 0; j < n / 2; j++) {
             int32_t mag = pcmM[j];
@@ -1954,21 +1988,21 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
 
     /* compute and apply spectral envelope */
 
-    for(i = 0; i < s_vorbisChannels; i++) {
-        int32_t *pcm = s_dsp_state->work[i];
+    for(i = 0; i < dec->channels; i++) {
+        int32_t *pcm = dec->dsp_state->work[i];
         int32_t      submap = 0;
         int32_t      floorno;
 
         if(info->submaps > 1) submap = info->chmuxlist[i];
         floorno = info->submaplist[submap].floor;
 
-        if(s_floor_type[floorno]) {
+        if(dec->floor_type[floorno]) {
             /* floor 1 */
-            floor1_inverse2(s_floor_param[floorno], floormemo[i], pcm);
+            floor1_inverse2(dec, dec->floor_param[floorno], floormemo[i], pcm);
         }
         else {
             /* floor 0 */
-            floor0_inverse2(s_floor_param[floorno], floormemo[i], pcm);
+            floor0_inverse2(dec, dec->floor_param[floorno], floormemo[i], pcm);
         }
 
     }
@@ -1977,9 +2011,11 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
     //_analysis_output("mdct",seq+j,vb->pcm[j],-24,n/2,0,1);
 
     /* transform the PCM data; takes PCM vector, vb; modifies PCM vector */
-    /* only MDCT right now.... */
-    for(i = 0; i < s_vorbisChannels; i++){
-        mdct_backward(n, s_dsp_state->work[i]);
+    /* only MDCT right now.... (the fused path transforms in vorbis_dsp_synthesis) */
+    if(!dec->dsp_state->imdct) {
+        for(i = 0; i < dec->channels; i++){
+            mdct_backward(dec, n, dec->dsp_state->work[i]);
+        }
     }
 
     // for(j=0;j<vi->channels;j++)
@@ -1999,22 +2035,22 @@ int32_t floor1_memosize(vorbis_info_floor_t *i) {
     return info->posts;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t *floor0_inverse1(vorbis_info_floor_t *i, int32_t *lsp) {
+int32_t *floor0_inverse1(VORBISDecoder_t* dec, vorbis_info_floor_t *i, int32_t *lsp) {
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)i;
     int32_t                 j;
 
-    int32_t ampraw = bitReader(info->ampbits);
+    int32_t ampraw = bitReader(dec, info->ampbits);
 
     if(ampraw > 0) { /* also handles the -1 out of data case */
         int32_t maxval = (1 << info->ampbits) - 1;
         int32_t     amp = ((ampraw * info->ampdB) << 4) / maxval;
-        int32_t     booknum = bitReader(_ilog(info->numbooks));
+        int32_t     booknum = bitReader(dec, _ilog(info->numbooks));
 
         if(booknum != -1 && booknum < info->numbooks) { /* be paranoid */
-            codebook_t        *b = s_codebooks + info->books[booknum];
+            codebook_t        *b = dec->codebooks + info->books[booknum];
             int32_t           last = 0;
 
-            if(vorbis_book_decodev_set(b, lsp, info->order, -24) == -1) goto eop;
+            if(vorbis_book_decodev_set(dec, b, lsp, info->order, -24) == -1) goto eop;
             for(j = 0; j < info->order;) {
                 for(uint8_t k = 0; j < info->order && k < b->dim; k++, j++) lsp[j] += last;
                 last = lsp[j - 1];
@@ -2028,18 +2064,18 @@ eop:
     return (NULL);
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t *floor1_inverse1(vorbis_info_floor_t *in, int32_t *fit_value) {
+int32_t *floor1_inverse1(VORBISDecoder_t* dec, vorbis_info_floor_t *in, int32_t *fit_value) {
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)in;
 
     int32_t                 quant_look[4] = {256, 128, 86, 64};
     int32_t                 i, j, k;
     int32_t                 quant_q = quant_look[info->mult - 1];
-    codebook_t         *books = s_codebooks;
+    codebook_t         *books = dec->codebooks;
 
     /* unpack wrapped/predicted values from stream */
-    if(bitReader(1) == 1) {
-        fit_value[0] = bitReader(ilog(quant_q - 1));
-        fit_value[1] = bitReader(ilog(quant_q - 1));
+    if(bitReader(dec, 1) == 1) {
+        fit_value[0] = bitReader(dec, ilog(quant_q - 1));
+        fit_value[1] = bitReader(dec, ilog(quant_q - 1));
 
     /* partition by partition */
         for(i = 0, j = 2; i < info->partitions; i++) {
@@ -2051,7 +2087,7 @@ int32_t *floor1_inverse1(vorbis_info_floor_t *in, int32_t *fit_value) {
 
             /* decode the partition's first stage cascade value */
             if(csubbits) {
-                cval = vorbis_book_decode(books + info->_class[classv].class_book);
+                cval = vorbis_book_decode(dec, books + info->_class[classv].class_book);
                 if(cval == -1) goto eop;
             }
 
@@ -2059,7 +2095,7 @@ int32_t *floor1_inverse1(vorbis_info_floor_t *in, int32_t *fit_value) {
                 int32_t book = info->_class[classv].class_subbook[cval & (csub - 1)];
                 cval >>= csubbits;
                 if(book != 0xff) {
-                    if((fit_value[j + k] = vorbis_book_decode(books + book)) == -1) goto eop;
+                    if((fit_value[j + k] = vorbis_book_decode(dec, books + book)) == -1) goto eop;
                 }
                 else { fit_value[j + k] = 0; }
             }
@@ -2104,96 +2140,108 @@ eop:
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* returns the [original, not compacted] entry number or -1 on eof *********/
-int32_t vorbis_book_decode(codebook_t* book) {
+int32_t vorbis_book_decode(VORBISDecoder_t* dec, codebook_t* book) {
     if(book->dec_type) return -1;
-    return decode_packed_entry_number(book);
+    return decode_packed_entry_number(dec, book);
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t decode_packed_entry_number(codebook_t *book) {
+int32_t decode_packed_entry_number(VORBISDecoder_t* dec, codebook_t *book) {
     uint32_t chase = 0;
-    int32_t      read = book->dec_maxlength;
-    int32_t  lok = bitReader_look(read), i;
+    int32_t  first = 0;
+    uint32_t cache = bitReader_look32(dec); // the next 32 bits, covers the longest codeword
 
-    while(lok < 0 && read > 1){
-        lok = bitReader_look(--read);
+    if(book->dec_lookup) {
+        /* short codewords are resolved with one table access, longer ones continue at the stored node */
+        uint32_t idx = cache & mask[book->dec_lookup_bits];
+        if(book->dec_lookup_len[idx]) {
+            bitReader_adv(dec, book->dec_lookup_len[idx]);
+            return book->dec_lookup[idx];
+        }
+        chase = book->dec_lookup[idx];
+        first = book->dec_lookup_bits;
     }
 
-    if(lok < 0) {
-        bitReader_adv(1); /* force eop */
-        return -1;
+    int32_t  read = book->dec_maxlength;
+    uint32_t lok = cache & mask[read]; // the cache always holds 32 valid bits, no shorter retry at the end of a packet
+
+    int32_t len = chase_decode_tree(book, lok, first, read, &chase);
+    if(len) {
+        bitReader_adv(dec, len);
+        return chase;
     }
+    bitReader_adv(dec, read + 1);
+    log_e("read %i", read);
+    return (-1);
+}
+//---------------------------------------------------------------------------------------------------------------------
+/* chase the tree from node 'chase' with the bits first ... read-1 of 'lok'. Returns the codeword length and the leaf
+   value in 'chase', or 0 if no leaf was reached, then 'chase' is the node to continue from */
+int32_t chase_decode_tree(codebook_t *book, uint32_t lok, int32_t first, int32_t read, uint32_t *chase) {
+    uint32_t c = *chase;
+    int32_t  i;
 
-    /* chase the tree with the bits we got */
     if(book->dec_nodeb == 1) {
         if(book->dec_leafw == 1) {
             /* 8/8 */
             uint8_t *t = (uint8_t *)book->dec_table;
-            for(i = 0; i < read; i++) {
-                chase = t[chase * 2 + ((lok >> i) & 1)];
-                if(chase & 0x80UL) break;
+            for(i = first; i < read; i++) {
+                c = t[c * 2 + ((lok >> i) & 1)];
+                if(c & 0x80UL) break;
             }
-            chase &= 0x7fUL;
+            if(i < read) c &= 0x7fUL;
         }
         else {
             /* 8/16 */
             uint8_t *t = (uint8_t *)book->dec_table;
-            for(i = 0; i < read; i++) {
+            for(i = first; i < read; i++) {
                 int32_t bit = (lok >> i) & 1;
-                int32_t next = t[chase + bit];
+                int32_t next = t[c + bit];
                 if(next & 0x80) {
-                    chase = (next << 8) | t[chase + bit + 1 + (!bit || (t[chase] & 0x80))];
+                    c = (next << 8) | t[c + bit + 1 + (!bit || (t[c] & 0x80))];
                     break;
                 }
-                chase = next;
+                c = next;
             }
-            chase &= 0x7fffUL;
+            if(i < read) c &= 0x7fffUL;
         }
     }
     else {
         if(book->dec_nodeb == 2) {
             if(book->dec_leafw == 1) {
                 /* 16/16 */
-                int32_t idx;
-                for(i = 0; i < read; i++) {
-                    idx = chase * 2 + ((lok >> i) & 1);
-                    chase = ((uint16_t *)(book->dec_table))[idx];
-                    if(chase & 0x8000UL){
-                        break;
-                    }
+                for(i = first; i < read; i++) {
+                    c = ((uint16_t *)(book->dec_table))[c * 2 + ((lok >> i) & 1)];
+                    if(c & 0x8000UL) break;
                 }
-                chase &= 0x7fffUL;
+                if(i < read) c &= 0x7fffUL;
             }
             else {
                 /* 16/32 */
                 uint16_t *t = (uint16_t *)book->dec_table;
-                for(i = 0; i < read; i++) {
+                for(i = first; i < read; i++) {
                     int32_t bit = (lok >> i) & 1;
-                    int32_t next = t[chase + bit];
+                    int32_t next = t[c + bit];
                     if(next & 0x8000) {
-                        chase = (next << 16) | t[chase + bit + 1 + (!bit || (t[chase] & 0x8000))];
+                        c = (next << 16) | t[c + bit + 1 + (!bit || (t[c] & 0x8000))];
                         break;
                     }
-                    chase = next;
+                    c = next;
                 }
-                chase &= 0x7fffffffUL;
+                if(i < read) c &= 0x7fffffffUL;
             }
         }
         else {
-            for(i = 0; i < read; i++) {
-                chase = ((uint32_t *)(book->dec_table))[chase * 2 + ((lok >> i) & 1)];
-                if(chase & 0x80000000UL) break;
+            for(i = first; i < read; i++) {
+                c = ((uint32_t *)(book->dec_table))[c * 2 + ((lok >> i) & 1)];
+                if(c & 0x80000000UL) break;
             }
-            chase &= 0x7fffffffUL;
+            if(i < read) c &= 0x7fffffffUL;
         }
     }
 
-    if(i < read) {
-        bitReader_adv(i + 1);
-        return chase;
-    }
-    bitReader_adv(read + 1);
-    log_e("read %i", read);
-    return (-1);
+    *chase = c;
+    if(i < read) return i + 1;
+    return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
 int32_t render_point(int32_t x0, int32_t x1, int32_t y0, int32_t y1, int32_t x) {
@@ -2214,13 +2262,13 @@ int32_t render_point(int32_t x0, int32_t x1, int32_t y0, int32_t y1, int32_t x)
 //---------------------------------------------------------------------------------------------------------------------
 /* unlike the others, we guard against n not being an integer number * of <dim> internally rather than in the upper
  layer (called only by * floor0) */
-int32_t vorbis_book_decodev_set(codebook_t *book, int32_t *a, int32_t n, int32_t point) {
+int32_t vorbis_book_decodev_set(VORBISDecoder_t* dec, codebook_t *book, int32_t *a, int32_t n, int32_t point) {
     if(book->used_entries > 0) {
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
         int32_t      i;
 
         for(i = 0; i < n;) {
-            if(decode_map(book, v, point)) return -1;
+            if(decode_map(dec, book, v, point)) return -1;
             for(uint8_t j = 0; i < n && j < book->dim; j++) a[i++] = v[j];
         }
     }
@@ -2233,11 +2281,11 @@ int32_t vorbis_book_decodev_set(codebook_t *book, int32_t *a, int32_t n, int32_t
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t decode_map(codebook_t *s, int32_t *v, int32_t point) {
+int32_t decode_map(VORBISDecoder_t* dec, codebook_t *s, int32_t *v, int32_t point) {
 
-    uint32_t entry = decode_packed_entry_number(s);
+    uint32_t entry = decode_packed_entry_number(dec, s);
 
-    if(oggpack_eop()) return (-1);
+    if(oggpack_eop(dec)) return (-1);
 
     /* according to decode type */
     switch(s->dec_type) {
@@ -2297,14 +2345,14 @@ int32_t decode_map(codebook_t *s, int32_t *v, int32_t point) {
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t res_inverse(vorbis_info_residue_t *info, int32_t **in, int32_t *nonzero, uint8_t ch) {
+int32_t res_inverse(VORBISDecoder_t* dec, vorbis_info_residue_t *info, int32_t **in, int32_t *nonzero, uint8_t ch) {
     int32_t               j, k, s;
     uint8_t           m = 0, n = 0;
     uint8_t           used = 0;
-    codebook_t         *phrasebook = s_codebooks + info->groupbook;
+    codebook_t         *phrasebook = dec->codebooks + info->groupbook;
     uint32_t          samples_per_partition = info->grouping;
     uint8_t           partitions_per_word = phrasebook->dim;
-    uint32_t          pcmend = s_blocksizes[s_dsp_state->W];
+    uint32_t          pcmend = dec->blocksizes[dec->dsp_state->W];
 
 
     if(info->type < 2) {
@@ -2340,7 +2388,7 @@ int32_t res_inverse(vorbis_info_residue_t *info, int32_t **in, int32_t *nonzero,
                                 }
                             }
                             for(n = 0; n < ch; n++) {
-                                int32_t temp = vorbis_book_decode(phrasebook);
+                                int32_t temp = vorbis_book_decode(dec, phrasebook);
                                 if(temp == -1) goto eopbreak;
                                 /* this can be done quickly in assembly due to the quotient
                                  always being at most six bits */
@@ -2357,14 +2405,14 @@ int32_t res_inverse(vorbis_info_residue_t *info, int32_t **in, int32_t *nonzero,
                             for(j = 0; j < ch; j++) {
                                 uint32_t offset = info->begin + i * samples_per_partition;
                                 if(info->stagemasks[(int32_t)partword[j][i]] & (1 << s)) {
-                                    codebook_t *stagebook = s_codebooks + info->stagebooks[(partword[j][i] << 3) + s];
+                                    codebook_t *stagebook = dec->codebooks + info->stagebooks[(partword[j][i] << 3) + s];
                                     if(info->type) {
-                                        if(vorbis_book_decodev_add(stagebook, in[j] + offset,
+                                        if(vorbis_book_decodev_add(dec, stagebook, in[j] + offset,
                                                                    samples_per_partition, -8) == -1)
                                             goto eopbreak;
                                     }
                                     else {
-                                        if(vorbis_book_decodevs_add(stagebook, in[j] + offset,
+                                        if(vorbis_book_decodevs_add(dec, stagebook, in[j] + offset,
                                                                     samples_per_partition, -8) == -1)
                                             goto eopbreak;
                                     }
@@ -2404,7 +2452,7 @@ int32_t res_inverse(vorbis_info_residue_t *info, int32_t **in, int32_t *nonzero,
                             partword[i + k] = partword[i + k + 1] * info->partitions;
 
                         /* fetch the partition word */
-                        temp = vorbis_book_decode(phrasebook);
+                        temp = vorbis_book_decode(dec, phrasebook);
                         if(temp == -1) goto eopbreak;
 
                         /* this can be done quickly in assembly due to the quotient always being at most six bits */
@@ -2418,8 +2466,8 @@ int32_t res_inverse(vorbis_info_residue_t *info, int32_t **in, int32_t *nonzero,
                     /* now we decode residual values for the partitions */
                     for(k = 0; k < partitions_per_word && i < partvals; k++, i++)
                         if(info->stagemasks[(int32_t)partword[i]] & (1 << s)) {
-                            codebook_t *stagebook = s_codebooks + info->stagebooks[(partword[i] << 3) + s];
-                            if(vorbis_book_decodevv_add(stagebook, in, i * samples_per_partition + beginoff, ch,
+                            codebook_t *stagebook = dec->codebooks + info->stagebooks[(partword[i] << 3) + s];
+                            if(vorbis_book_decodevv_add(dec, stagebook, in, i * samples_per_partition + beginoff, ch,
                                                         samples_per_partition, -8) == -1)
                                 goto eopbreak;
                         }
@@ -2433,13 +2481,13 @@ eopbreak:
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* decode vector / dim granularity guarding is done in the upper layer */
-int32_t vorbis_book_decodev_add(codebook_t *book, int32_t *a, int32_t n, int32_t point) {
+int32_t vorbis_book_decodev_add(VORBISDecoder_t* dec, codebook_t *book, int32_t *a, int32_t n, int32_t point) {
     if(book->used_entries > 0) {
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
         uint32_t i;
 
         for(i = 0; i < n;) {
-            if(decode_map(book, v, point)) return -1;
+            if(decode_map(dec, book, v, point)) return -1;
             for(uint8_t j = 0; i < n && j < book->dim; j++) a[i++] += v[j];
         }
     }
@@ -2448,21 +2496,21 @@ int32_t vorbis_book_decodev_add(codebook_t *book, int32_t *a, int32_t n, int32_t
 //---------------------------------------------------------------------------------------------------------------------
 /* returns 0 on OK or -1 on eof */
 /* decode vector / dim granularity guarding is done in the upper layer */
-int32_t vorbis_book_decodevs_add(codebook_t *book, int32_t *a, int32_t n, int32_t point) {
+int32_t vorbis_book_decodevs_add(VORBISDecoder_t* dec, codebook_t *book, int32_t *a, int32_t n, int32_t point) {
     if(book->used_entries > 0) {
         int32_t      step = n / book->dim;
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
         int32_t      j;
 
         for(j = 0; j < step; j++) {
-            if(decode_map(book, v, point)) return -1;
+            if(decode_map(dec, book, v, point)) return -1;
             for(uint8_t i = 0, o = j; i < book->dim; i++, o += step) a[o] += v[i];
         }
     }
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int32_t floor0_inverse2(vorbis_info_floor_t *i, int32_t *lsp, int32_t *out) {
+int32_t floor0_inverse2(VORBISDecoder_t* dec, vorbis_info_floor_t *i, int32_t *lsp, int32_t *out) {
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)i;
 
 
@@ -2470,19 +2518,19 @@ int32_t floor0_inverse2(vorbis_info_floor_t *i, int32_t *lsp, int32_t *out) {
         int32_t amp = lsp[info->order];
 
         /* take the coefficients back to a spectral envelope curve */
-        vorbis_lsp_to_curve(out, s_blocksizes[s_dsp_state->W] / 2, info->barkmap, lsp, info->order, amp, info->ampdB,
+        vorbis_lsp_to_curve(out, dec->blocksizes[dec->dsp_state->W] / 2, info->barkmap, lsp, info->order, amp, info->ampdB,
                             info->rate >> 1);
         return (1);
     }
-    memset(out, 0, sizeof(*out) * s_blocksizes[s_dsp_state->W] / 2);
+    memset(out, 0, sizeof(*out) * dec->blocksizes[dec->dsp_state->W] / 2);
     return (0);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-int32_t floor1_inverse2(vorbis_info_floor_t *in, int32_t *fit_value, int32_t *out) {
+int32_t floor1_inverse2(VORBISDecoder_t* dec, vorbis_info_floor_t *in, int32_t *fit_value, int32_t *out) {
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)in;
 
-    int32_t               n = s_blocksizes[s_dsp_state->W] / 2;
+    int32_t               n = dec->blocksizes[dec->dsp_state->W] / 2;
     int32_t               j;
 
     if(fit_value) {
@@ -2767,7 +2815,7 @@ int32_t vorbis_invsqlook_i(int32_t a, int32_t e) {
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* partial; doesn't perform last-step deinterleave/unrolling. That can be done more efficiently during pcm output */
-void mdct_backward(int32_t n, int32_t *in) {
+void mdct_backward(VORBISDecoder_t* dec, int32_t n, int32_t *in) {
     int32_t shift;
     int32_t step;
 
@@ -2776,21 +2824,21 @@ void mdct_backward(int32_t n, int32_t *in) {
     shift = 13 - shift;
     step = 2 << shift;
 
-    presymmetry(in, n >> 1, step);
-    mdct_butterflies(in, n >> 1, shift);
+    presymmetry(dec, in, n >> 1, step);
+    mdct_butterflies(dec, in, n >> 1, shift);
     mdct_bitreverse(in, n, shift);
-    mdct_step7(in, n, step);
-    mdct_step8(in, n, step);
+    mdct_step7(dec, in, n, step);
+    mdct_step8(dec, in, n, step);
 }
 //---------------------------------------------------------------------------------------------------------------------
-void presymmetry(int32_t *in, int32_t n2, int32_t step) {
+void presymmetry(VORBISDecoder_t* dec, int32_t *in, int32_t n2, int32_t step) {
     int32_t       *aX;
     int32_t       *bX;
     const int32_t *T;
     int32_t            n4 = n2 >> 1;
 
     aX = in + n2 - 3;
-    T = sincos_lookup0;
+    T = dec->sincos0;
 
     do {
         int32_t r0 = aX[0];
@@ -2809,7 +2857,7 @@ void presymmetry(int32_t *in, int32_t n2, int32_t step) {
 
     aX = in + n2 - 4;
     bX = in;
-    T = sincos_lookup0;
+    T = dec->sincos0;
     do {
         int32_t ri0 = aX[0];
         int32_t ri2 = aX[2];
@@ -2825,20 +2873,20 @@ void presymmetry(int32_t *in, int32_t n2, int32_t step) {
     } while(aX >= in + n4);
 }
 //---------------------------------------------------------------------------------------------------------------------
-void mdct_butterflies(int32_t *x, int32_t points, int32_t shift) {
+void mdct_butterflies(VORBISDecoder_t* dec, int32_t *x, int32_t points, int32_t shift) {
     int32_t stages = 8 - shift;
     int32_t i, j;
 
     for(i = 0; --stages > 0; i++) {
-        for(j = 0; j < (1 << i); j++) mdct_butterfly_generic(x + (points >> i) * j, points >> i, 4 << (i + shift));
+        for(j = 0; j < (1 << i); j++) mdct_butterfly_generic(dec, x + (points >> i) * j, points >> i, 4 << (i + shift));
     }
 
     for(j = 0; j < points; j += 32) mdct_butterfly_32(x + j);
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* N/stage point generic N stage butterfly (in place, 2 register) */
-void mdct_butterfly_generic(int32_t *x, int32_t points, int32_t step) {
-    const int32_t *T = sincos_lookup0;
+void mdct_butterfly_generic(VORBISDecoder_t* dec, int32_t *x, int32_t points, int32_t step) {
+    const int32_t *T = dec->sincos0;
     int32_t       *x1 = x + points - 4;
     int32_t       *x2 = x + (points >> 1) - 4;
     int32_t        r0, r1, r2, r3;
@@ -2857,7 +2905,7 @@ void mdct_butterfly_generic(int32_t *x, int32_t points, int32_t step) {
         T += step;
         x1 -= 4;
         x2 -= 4;
-    } while(T < sincos_lookup0 + 1024);
+    } while(T < dec->sincos0 + 1024);
     do {
         r0 = x1[0] - x1[1];
         x1[0] += x1[1];
@@ -2872,7 +2920,7 @@ void mdct_butterfly_generic(int32_t *x, int32_t points, int32_t step) {
         T -= step;
         x1 -= 4;
         x2 -= 4;
-    } while(T > sincos_lookup0);
+    } while(T > dec->sincos0);
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* 32 point butterfly (in place, 4 register) */
@@ -3014,10 +3062,10 @@ int32_t bitrev12(int32_t x) {
     return bitrev[x >> 8] | (bitrev[(x & 0x0f0) >> 4] << 4) | (((int32_t)bitrev[x & 0x00f]) << 8);
 }
 //---------------------------------------------------------------------------------------------------------------------
-void mdct_step7(int32_t *x, int32_t n, int32_t step) {
+void mdct_step7(VORBISDecoder_t* dec, int32_t *x, int32_t n, int32_t step) {
     int32_t       *w0 = x;
     int32_t       *w1 = x + (n >> 1);
-    const int32_t *T = (step >= 4) ? (sincos_lookup0 + (step >> 1)) : sincos_lookup1;
+    const int32_t *T = (step >= 4) ? (dec->sincos0 + (step >> 1)) : dec->sincos1;
     const int32_t *Ttop = T + 1024;
     int32_t        r0, r1, r2, r3;
 
@@ -3059,7 +3107,7 @@ void mdct_step7(int32_t *x, int32_t n, int32_t step) {
     } while(w0 < w1);
 }
 //---------------------------------------------------------------------------------------------------------------------
-void mdct_step8(int32_t *x, int32_t n, int32_t step) {
+void mdct_step8(VORBISDecoder_t* dec, int32_t *x, int32_t n, int32_t step) {
     const int32_t *T;
     const int32_t *V;
     int32_t       *iX = x + (n >> 1);
@@ -3067,7 +3115,7 @@ void mdct_step8(int32_t *x, int32_t n, int32_t step) {
 
     switch(step) {
         default:
-            T = (step >= 4) ? (sincos_lookup0 + (step >> 1)) : sincos_lookup1;
+            T = (step >= 4) ? (dec->sincos0 + (step >> 1)) : dec->sincos1;
             do {
                 int32_t r0 = x[0];
                 int32_t r1 = -x[1];
@@ -3080,8 +3128,8 @@ void mdct_step8(int32_t *x, int32_t n, int32_t step) {
         case 1: {
             /* linear interpolation between table values: offset=0.5, step=1 */
             int32_t t0, t1, v0, v1, r0, r1;
-            T = sincos_lookup0;
-            V = sincos_lookup1;
+            T = dec->sincos0;
+            V = dec->sincos1;
             t0 = (*T++) >> 1;
             t1 = (*T++) >> 1;
             do {
@@ -3105,8 +3153,8 @@ void mdct_step8(int32_t *x, int32_t n, int32_t step) {
         case 0: {
             /* linear interpolation between table values: offset=0.25, step=0.5 */
             int32_t t0, t1, v0, v1, q0, q1, r0, r1;
-            T = sincos_lookup0;
-            V = sincos_lookup1;
+            T = dec->sincos0;
+            V = dec->sincos1;
             t0 = *T++;
             t1 = *T++;
             do {
@@ -3144,7 +3192,7 @@ void mdct_step8(int32_t *x, int32_t n, int32_t step) {
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* decode vector / dim granularity guarding is done in the upper layer */
-int32_t vorbis_book_decodevv_add(codebook_t *book, int32_t **a, int32_t offset, uint8_t ch, int32_t n, int32_t point) {
+int32_t vorbis_book_decodevv_add(VORBISDecoder_t* dec, codebook_t *book, int32_t **a, int32_t offset, uint8_t ch, int32_t n, int32_t point) {
     if(book->used_entries > 0) {
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
         int32_t  i;
@@ -3152,7 +3200,7 @@ int32_t vorbis_book_decodevv_add(codebook_t *book, int32_t **a, int32_t offset,
         int32_t  m = offset + n;
 
         for(i = offset; i < m;) {
-            if(decode_map(book, v, point)) return -1;
+            if(decode_map(dec, book, v, point)) return -1;
             for(uint8_t j = 0; i < m && j < book->dim; j++) {
                 a[chptr++][i] += v[j];
                 if(chptr == ch) {
@@ -3167,31 +3215,37 @@ int32_t vorbis_book_decodevv_add(codebook_t *book, int32_t **a, int32_t offset,
 }
 //---------------------------------------------------------------------------------------------------------------------
 /* pcm==0 indicates we just want the pending samples, no more */
-int32_t vorbis_dsp_pcmout(int16_t *outBuff, int32_t outBuffSize) {
-    if(s_dsp_state->out_begin > -1 && s_dsp_state->out_begin < s_dsp_state->out_end) {
-        int32_t n = s_dsp_state->out_end - s_dsp_state->out_begin;
-
-        if(outBuff) {
-            int32_t i;
-            if(n > outBuffSize) {
-                n = outBuffSize;
-                log_e("outBufferSize too small, must be min %i (int16_t) words", n);
-            }
-            for(i = 0; i < s_vorbisChannels; i++){
-                mdct_unroll_lap(s_blocksizes[0], s_blocksizes[1],
-                                s_dsp_state->lW, s_dsp_state->W, s_dsp_state->work[i],
-                                s_dsp_state->mdctright[i], _vorbis_window(s_blocksizes[0] >> 1),
-                                _vorbis_window(s_blocksizes[1] >> 1),
-                                outBuff + i, s_vorbisChannels,
-                                s_dsp_state->out_begin,
-                                s_dsp_state->out_begin + n);
-            }
+int32_t vorbis_dsp_pcmout(VORBISDecoder_t* dec, int16_t *outBuff, int32_t outBuffSize) {
+    int32_t n = vorbis_dsp_pcmcount(dec, outBuffSize);
+    if(n && outBuff && !dec->dsp_state->imdct) { // the fused path has already written the samples
+        for(int32_t i = 0; i < dec->channels; i++) vorbis_dsp_lap(dec, i, dec->dsp_state->work[i], outBuff, n);
+    }
+    return n;
+}
+//---------------------------------------------------------------------------------------------------------------------
+int32_t vorbis_dsp_pcmcount(VORBISDecoder_t* dec, int32_t outBuffSize) {
+    if(dec->dsp_state->out_begin > -1 && dec->dsp_state->out_begin < dec->dsp_state->out_end) {
+        int32_t n = dec->dsp_state->out_end - dec->dsp_state->out_begin;
+        if(n > outBuffSize) {
+            n = outBuffSize;
+            log_e("outBufferSize too small, must be min %i (int16_t) words", n);
         }
         return (n);
     }
     return (0);
 }
 //---------------------------------------------------------------------------------------------------------------------
+/* window and overlap-add the imdct output 'in' of one channel with the right half of the previous block */
+void vorbis_dsp_lap(VORBISDecoder_t* dec, uint8_t ch, int32_t *in, int16_t *outBuff, int32_t n) {
+    mdct_unroll_lap(dec->blocksizes[0], dec->blocksizes[1],
+                    dec->dsp_state->lW, dec->dsp_state->W, in,
+                    dec->dsp_state->mdctright[ch], _vorbis_window(dec->blocksizes[0] >> 1),
+                    _vorbis_window(dec->blocksizes[1] >> 1),
+                    outBuff + ch, dec->channels,
+                    dec->dsp_state->out_begin,
+                    dec->dsp_state->out_begin + n);
+}
+//---------------------------------------------------------------------------------------------------------------------
 int32_t *_vorbis_window(int32_t left) {
     switch(left) {
         case 32:
@@ -3288,3 +3342,4 @@ void mdct_unroll_lap(int32_t n0, int32_t n1, int32_t lW, int32_t W, int32_t *in,
     }
 }
 //---------------------------------------------------------------------------------------------------------------------
+#endif // AUDIO_CODEC_VORBIS
@@ -40,6 +40,7 @@
 
 #define SPI_SD_SPEED          25000000  // 25 MHz
 #define AUDIO_HEADER_TIMEOUT  7500      // in milliseconds
+#define WEB_RADIO_PRECONNECT  0         // 1 = Keep the previous and next station connected for instant switching (PSRAM)
 
 //=====================
 //== Pin definitions ==